@@ -0,0 +1,54 @@
+#ifndef BPV7_IN_PLACE_FORWARDING_VIEW_H
+#define BPV7_IN_PLACE_FORWARDING_VIEW_H 1
+
+#include "codec/bpv7.h"
+#include <cstdint>
+
+/*
+A non-allocating alternative to BundleViewV7 for the common forwarding case.
+
+BundleViewV7::LoadBundle allocates a derived Bpv7CanonicalBlock per block (held in a std::list),
+verifies every block crc (payload included), and BundleViewV7::RenderInPlace renders every block
+twice, which is a lot of work just to rewrite the previous node block and increment the hop count.
+
+This view decodes only the primary block and walks the canonical block headers
+(block-type-specific data is not decoded), remembering where the previous node and hop count
+blocks are located within the bundle.  When the new values have the same CBOR encoded sizes
+as the old values, those two blocks are patched in place and only their crcs are recomputed.
+All other blocks are forwarded byte for byte with their original crcs, so their crcs are not
+verified here (corruption remains detectable by the receiver).  When a size change is unavoidable
+(e.g. no previous node block is present and one must be added), the bundle is left unmodified
+and the caller shall fall back to BundleViewV7.
+*/
+
+class Bpv7InPlaceForwardingView {
+
+public:
+    enum class UPDATE_RESULT {
+        SUCCESS = 0, //bundle was modified in place
+        NEEDS_FULL_RENDER, //bundle was left unmodified, use BundleViewV7 instead
+        HOP_LIMIT_EXCEEDED //bundle was left unmodified, bundle should be deleted
+    };
+    struct BlockLocation {
+        Bpv7CanonicalBlock header; //block header fields only (m_dataPtr and m_dataLength point into the bundle)
+        uint8_t * serializationPtr;
+        uint64_t serializationSize;
+        unsigned int count; //number of blocks of this type found in the bundle
+    };
+
+    BPCODEC_EXPORT Bpv7InPlaceForwardingView();
+    BPCODEC_EXPORT ~Bpv7InPlaceForwardingView();
+    BPCODEC_EXPORT bool LoadBundle(uint8_t * bundleData, const std::size_t size, const bool skipCrcVerifyInPatchableBlocks = false);
+    BPCODEC_EXPORT UPDATE_RESULT UpdatePreviousNodeAndIncrementHopCount(const cbhe_eid_t & newPreviousNode);
+
+    Bpv7CbhePrimaryBlock m_primaryBlock;
+    BlockLocation m_previousNodeBlock;
+    BlockLocation m_hopCountBlock;
+    uint64_t m_hopLimit; //valid after UpdatePreviousNodeAndIncrementHopCount if a hop count block is present
+    uint64_t m_hopCount; //valid after UpdatePreviousNodeAndIncrementHopCount if a hop count block is present (the incremented value)
+    bool m_hasBpsecBlocks; //integrity or confidentiality blocks may cover the blocks to be patched, so never patch in place
+    uint8_t * m_bundleData;
+    std::size_t m_bundleSize;
+};
+
+#endif // BPV7_IN_PLACE_FORWARDING_VIEW_H
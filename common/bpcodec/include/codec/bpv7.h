@@ -358,6 +358,9 @@ struct CLASS_VISIBILITY_BPCODEC Bpv7CanonicalBlock {
     BPCODEC_EXPORT void RecomputeCrcAfterDataModification(uint8_t * serializationBase, const uint64_t sizeSerialized);
     BPCODEC_EXPORT static bool DeserializeBpv7(std::unique_ptr<Bpv7CanonicalBlock> & canonicalPtr, uint8_t * serialization,
         uint64_t & numBytesTakenToDecode, uint64_t bufferSize, const bool skipCrcVerify, const bool isAdminRecord);
+    //decodes only the block header fields (no block-type-specific data) into an existing block without any heap allocation
+    BPCODEC_EXPORT static bool DeserializeBpv7IntoExistingBlock(Bpv7CanonicalBlock & canonical, uint8_t * serialization,
+        uint64_t & numBytesTakenToDecode, uint64_t bufferSize, const bool skipCrcVerify);
     BPCODEC_EXPORT virtual bool Virtual_DeserializeExtensionBlockDataBpv7();
 };
 
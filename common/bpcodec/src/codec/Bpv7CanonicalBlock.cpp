@@ -249,40 +249,14 @@ bool Bpv7CanonicalBlock::DeserializeBpv7(std::unique_ptr<Bpv7CanonicalBlock> & c
     uint64_t bufferSize, const bool skipCrcVerify, const bool isAdminRecord)
 {
     uint8_t cborSizeDecoded;
-    const uint8_t * const serializationBase = serialization;
     if (bufferSize < Bpv7CanonicalBlock::smallestSerializedCanonicalSize) {
         return false;
     }
-
-
-    //Every block other than the primary block (all such blocks are termed
-    //"canonical" blocks) SHALL be represented as a CBOR array; the number
-    //of elements in the array SHALL be 5 (if CRC type is zero) or 6
-    //(otherwise).
-    const uint8_t initialCborByte = *serialization++;
-    --bufferSize;
-    const uint8_t cborMajorType = initialCborByte >> 5;
-    const uint8_t cborArraySize = initialCborByte & 0x1f;
-    if ((cborMajorType != 4U) || //major type 4
-        ((cborArraySize - 5U) > (6U - 5U))) { //additional information [5..6] (array of length [5..6])
-        return false;
-    }
-
-    //The fields of every canonical block SHALL be as follows, listed in
-    //the order in which they MUST appear:
-
-    //Block type code, an unsigned integer. Bundle block type code 1
-    //indicates that the block is a bundle payload block. Block type
-    //codes 2 through 9 are explicitly reserved as noted later in
-    //this specification.  Block type codes 192 through 255 are not
-    //reserved and are available for private and/or experimental use.
-    //All other block type code values are reserved for future use.
-    const BPV7_BLOCK_TYPE_CODE blockTypeCode = static_cast<BPV7_BLOCK_TYPE_CODE>(CborDecodeU64(serialization, &cborSizeDecoded, bufferSize));
+    //peek at the block type code (which follows the one byte cbor array header) to allocate the proper derived class
+    const BPV7_BLOCK_TYPE_CODE blockTypeCode = static_cast<BPV7_BLOCK_TYPE_CODE>(CborDecodeU64(serialization + 1, &cborSizeDecoded, bufferSize - 1));
     if ((cborSizeDecoded == 0) || (cborSizeDecoded > 2)) { //uint8_t should be size 1 or 2 encoded bytes
         return false; //failure
     }
-    serialization += cborSizeDecoded;
-    bufferSize -= cborSizeDecoded;
     if (isAdminRecord) {
         if (blockTypeCode != BPV7_BLOCK_TYPE_CODE::PAYLOAD) { //admin records always go into a payload block
             return false;
@@ -312,11 +286,52 @@ bool Bpv7CanonicalBlock::DeserializeBpv7(std::unique_ptr<Bpv7CanonicalBlock> & c
                 break;
         }
     }
-    canonicalPtr->m_blockTypeCode = blockTypeCode;
+    return DeserializeBpv7IntoExistingBlock(*canonicalPtr, serialization, numBytesTakenToDecode, bufferSize, skipCrcVerify);
+}
+
+//serialization must be temporarily modifyable to zero crc and restore it
+bool Bpv7CanonicalBlock::DeserializeBpv7IntoExistingBlock(Bpv7CanonicalBlock & canonical, uint8_t * serialization, uint64_t & numBytesTakenToDecode,
+    uint64_t bufferSize, const bool skipCrcVerify)
+{
+    uint8_t cborSizeDecoded;
+    const uint8_t * const serializationBase = serialization;
+    if (bufferSize < Bpv7CanonicalBlock::smallestSerializedCanonicalSize) {
+        return false;
+    }
+
+
+    //Every block other than the primary block (all such blocks are termed
+    //"canonical" blocks) SHALL be represented as a CBOR array; the number
+    //of elements in the array SHALL be 5 (if CRC type is zero) or 6
+    //(otherwise).
+    const uint8_t initialCborByte = *serialization++;
+    --bufferSize;
+    const uint8_t cborMajorType = initialCborByte >> 5;
+    const uint8_t cborArraySize = initialCborByte & 0x1f;
+    if ((cborMajorType != 4U) || //major type 4
+        ((cborArraySize - 5U) > (6U - 5U))) { //additional information [5..6] (array of length [5..6])
+        return false;
+    }
+
+    //The fields of every canonical block SHALL be as follows, listed in
+    //the order in which they MUST appear:
+
+    //Block type code, an unsigned integer. Bundle block type code 1
+    //indicates that the block is a bundle payload block. Block type
+    //codes 2 through 9 are explicitly reserved as noted later in
+    //this specification.  Block type codes 192 through 255 are not
+    //reserved and are available for private and/or experimental use.
+    //All other block type code values are reserved for future use.
+    canonical.m_blockTypeCode = static_cast<BPV7_BLOCK_TYPE_CODE>(CborDecodeU64(serialization, &cborSizeDecoded, bufferSize));
+    if ((cborSizeDecoded == 0) || (cborSizeDecoded > 2)) { //uint8_t should be size 1 or 2 encoded bytes
+        return false; //failure
+    }
+    serialization += cborSizeDecoded;
+    bufferSize -= cborSizeDecoded;
 
     //Block number, an unsigned integer as discussed in 4.1 above.
     //Block number SHALL be represented as a CBOR unsigned integer.
-    canonicalPtr->m_blockNumber = CborDecodeU64(serialization, &cborSizeDecoded, bufferSize);
+    canonical.m_blockNumber = CborDecodeU64(serialization, &cborSizeDecoded, bufferSize);
     if (cborSizeDecoded == 0) {
         return false; //failure
     }
@@ -332,7 +347,7 @@ bool Bpv7CanonicalBlock::DeserializeBpv7(std::unique_ptr<Bpv7CanonicalBlock> & c
     //beginning with the low-order bit instead of the high-order bit, for
     //agreement with the bit numbering of the bundle processing control
     //flags):
-    canonicalPtr->m_blockProcessingControlFlags = static_cast<BPV7_BLOCKFLAG>(CborDecodeU64(serialization, &cborSizeDecoded, bufferSize));
+    canonical.m_blockProcessingControlFlags = static_cast<BPV7_BLOCKFLAG>(CborDecodeU64(serialization, &cborSizeDecoded, bufferSize));
     if (cborSizeDecoded == 0) {
         return false; //failure
     }
@@ -353,11 +368,11 @@ bool Bpv7CanonicalBlock::DeserializeBpv7(std::unique_ptr<Bpv7CanonicalBlock> & c
     if (bufferSize < 2) { //for crcType and [potentialTag24 or byteStringHeader]
         return false;
     }
-    canonicalPtr->m_crcType = static_cast<BPV7_CRC_TYPE>(*serialization++);
+    canonical.m_crcType = static_cast<BPV7_CRC_TYPE>(*serialization++);
     --bufferSize;
 
     //verify cbor array size
-    const bool hasCrc = (canonicalPtr->m_crcType != BPV7_CRC_TYPE::NONE);
+    const bool hasCrc = (canonical.m_crcType != BPV7_CRC_TYPE::NONE);
     const uint8_t expectedCborArraySize = 5 + hasCrc;
     if (expectedCborArraySize != cborArraySize) {
         return false; //failure
@@ -403,7 +418,7 @@ bool Bpv7CanonicalBlock::DeserializeBpv7(std::unique_ptr<Bpv7CanonicalBlock> & c
         return false; //failure
     }
     *byteStringHeaderStartPtr &= 0x1f; //temporarily zero out major type to 0 to make it unsigned integer
-    canonicalPtr->m_dataLength = CborDecodeU64(byteStringHeaderStartPtr, &cborSizeDecoded, bufferSize);
+    canonical.m_dataLength = CborDecodeU64(byteStringHeaderStartPtr, &cborSizeDecoded, bufferSize);
     *byteStringHeaderStartPtr |= (2U << 5); // restore to major type to 2 (change from major type 0 (unsigned integer) to major type 2 (byte string))
     if (cborSizeDecoded == 0) {
         return false; //failure
@@ -411,11 +426,11 @@ bool Bpv7CanonicalBlock::DeserializeBpv7(std::unique_ptr<Bpv7CanonicalBlock> & c
     serialization += cborSizeDecoded;
     bufferSize -= cborSizeDecoded;
 
-    if (canonicalPtr->m_dataLength > bufferSize) {
+    if (canonical.m_dataLength > bufferSize) {
         return false;
     }
-    canonicalPtr->m_dataPtr = serialization;
-    serialization += canonicalPtr->m_dataLength;
+    canonical.m_dataPtr = serialization;
+    serialization += canonical.m_dataLength;
 
     
     if (hasCrc) {
@@ -426,11 +441,11 @@ bool Bpv7CanonicalBlock::DeserializeBpv7(std::unique_ptr<Bpv7CanonicalBlock> & c
         //(including CBOR "break" characters) including the CRC field
         //itself, which for this purpose SHALL be temporarily populated
         //with all bytes set to zero.
-        bufferSize -= canonicalPtr->m_dataLength; //only need to do this if hasCrc
+        bufferSize -= canonical.m_dataLength; //only need to do this if hasCrc
         uint8_t * const crcStartPtr = serialization;
-        if (canonicalPtr->m_crcType == BPV7_CRC_TYPE::CRC16_X25) {
-            canonicalPtr->m_computedCrc32 = 0;
-            if ((bufferSize < 3) || (!Bpv7Crc::DeserializeCrc16ForBpv7(serialization, &cborSizeDecoded, canonicalPtr->m_computedCrc16))) {
+        if (canonical.m_crcType == BPV7_CRC_TYPE::CRC16_X25) {
+            canonical.m_computedCrc32 = 0;
+            if ((bufferSize < 3) || (!Bpv7Crc::DeserializeCrc16ForBpv7(serialization, &cborSizeDecoded, canonical.m_computedCrc16))) {
                 return false;
             }
             serialization += 3;
@@ -441,22 +456,22 @@ bool Bpv7CanonicalBlock::DeserializeBpv7(std::unique_ptr<Bpv7CanonicalBlock> & c
             }
             Bpv7Crc::SerializeZeroedCrc16ForBpv7(crcStartPtr);
             const uint16_t computedCrc16 = Bpv7Crc::Crc16_X25_Unaligned(serializationBase, blockSerializedLength);
-            Bpv7Crc::SerializeCrc16ForBpv7(crcStartPtr, canonicalPtr->m_computedCrc16); //restore original received crc after zeroing
-            if (computedCrc16 == canonicalPtr->m_computedCrc16) {
+            Bpv7Crc::SerializeCrc16ForBpv7(crcStartPtr, canonical.m_computedCrc16); //restore original received crc after zeroing
+            if (computedCrc16 == canonical.m_computedCrc16) {
                 return true;
             }
             else {
                 static const boost::format fmtTemplate("Error: Bpv7CanonicalBlock deserialize Crc16_X25 mismatch: block came with crc %04x but Decode just computed %04x");
                 boost::format fmt(fmtTemplate);
-                fmt % canonicalPtr->m_computedCrc16 % computedCrc16;
+                fmt % canonical.m_computedCrc16 % computedCrc16;
                 const std::string message(std::move(fmt.str()));
                 std::cout << message << "\n";
                 return false;
             }
         }
-        else if (canonicalPtr->m_crcType == BPV7_CRC_TYPE::CRC32C) {
-            canonicalPtr->m_computedCrc16 = 0;
-            if ((bufferSize < 5) || (!Bpv7Crc::DeserializeCrc32ForBpv7(serialization, &cborSizeDecoded, canonicalPtr->m_computedCrc32))) {
+        else if (canonical.m_crcType == BPV7_CRC_TYPE::CRC32C) {
+            canonical.m_computedCrc16 = 0;
+            if ((bufferSize < 5) || (!Bpv7Crc::DeserializeCrc32ForBpv7(serialization, &cborSizeDecoded, canonical.m_computedCrc32))) {
                 return false;
             }
             serialization += 5;
@@ -467,14 +482,14 @@ bool Bpv7CanonicalBlock::DeserializeBpv7(std::unique_ptr<Bpv7CanonicalBlock> & c
             }
             Bpv7Crc::SerializeZeroedCrc32ForBpv7(crcStartPtr);
             const uint32_t computedCrc32 = Bpv7Crc::Crc32C_Unaligned(serializationBase, blockSerializedLength);
-            Bpv7Crc::SerializeCrc32ForBpv7(crcStartPtr, canonicalPtr->m_computedCrc32); //restore original received crc after zeroing
-            if (computedCrc32 == canonicalPtr->m_computedCrc32) {
+            Bpv7Crc::SerializeCrc32ForBpv7(crcStartPtr, canonical.m_computedCrc32); //restore original received crc after zeroing
+            if (computedCrc32 == canonical.m_computedCrc32) {
                 return true;
             }
             else {
                 static const boost::format fmtTemplate("Error: Bpv7CanonicalBlock deserialize Crc32C mismatch: block came with crc %08x but Decode just computed %08x");
                 boost::format fmt(fmtTemplate);
-                fmt % canonicalPtr->m_computedCrc32 % computedCrc32;
+                fmt % canonical.m_computedCrc32 % computedCrc32;
                 const std::string message(std::move(fmt.str()));
                 std::cout << message << "\n";
                 return false;
@@ -486,8 +501,8 @@ bool Bpv7CanonicalBlock::DeserializeBpv7(std::unique_ptr<Bpv7CanonicalBlock> & c
         }
     }
     else {
-        canonicalPtr->m_computedCrc32 = 0;
-        canonicalPtr->m_computedCrc16 = 0;
+        canonical.m_computedCrc32 = 0;
+        canonical.m_computedCrc16 = 0;
         numBytesTakenToDecode = serialization - serializationBase;
         return true;
     }
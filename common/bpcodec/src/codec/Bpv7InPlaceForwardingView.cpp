@@ -0,0 +1,128 @@
+#include "codec/Bpv7InPlaceForwardingView.h"
+#include "CborUint.h"
+
+Bpv7InPlaceForwardingView::Bpv7InPlaceForwardingView() {}
+Bpv7InPlaceForwardingView::~Bpv7InPlaceForwardingView() {}
+
+bool Bpv7InPlaceForwardingView::LoadBundle(uint8_t * bundleData, const std::size_t size, const bool skipCrcVerifyInPatchableBlocks) {
+    m_previousNodeBlock.count = 0;
+    m_hopCountBlock.count = 0;
+    m_hasBpsecBlocks = false;
+    m_bundleData = bundleData;
+    m_bundleSize = size;
+
+    uint8_t * serialization = bundleData;
+    uint64_t bufferSize = size;
+    uint64_t decodedBlockSize;
+
+    //Each bundle SHALL be a concatenated sequence of at least two blocks,
+    //represented as a CBOR indefinite-length array.
+    if (bufferSize == 0) {
+        return false;
+    }
+    --bufferSize;
+    const uint8_t initialCborByte = *serialization++;
+    if (initialCborByte != ((4U << 5) | 31U)) { //major type 4, additional information 31 (Indefinite-Length Array)
+        return false;
+    }
+
+    if (!m_primaryBlock.DeserializeBpv7(serialization, decodedBlockSize, bufferSize)) {
+        return false;
+    }
+    serialization += decodedBlockSize;
+    bufferSize -= decodedBlockSize;
+    if ((m_primaryBlock.m_bundleProcessingControlFlags & BPV7_BUNDLEFLAG::ISFRAGMENT) != BPV7_BUNDLEFLAG::NO_FLAGS_SET) { //not currently supported (same as BundleViewV7)
+        return false;
+    }
+
+    //walk the canonical block headers (the last block must be the payload block followed by a CBOR break stop code)
+    Bpv7CanonicalBlock header;
+    while (true) {
+        uint8_t * const serializationThisCanonicalBlockBeginPtr = serialization;
+        if (!Bpv7CanonicalBlock::DeserializeBpv7IntoExistingBlock(header, serialization, decodedBlockSize, bufferSize, true)) {
+            return false;
+        }
+        serialization += decodedBlockSize;
+        bufferSize -= decodedBlockSize;
+
+        BlockLocation * blockLocationPtr = NULL;
+        if (header.m_blockTypeCode == BPV7_BLOCK_TYPE_CODE::PREVIOUS_NODE) {
+            blockLocationPtr = &m_previousNodeBlock;
+        }
+        else if (header.m_blockTypeCode == BPV7_BLOCK_TYPE_CODE::HOP_COUNT) {
+            blockLocationPtr = &m_hopCountBlock;
+        }
+        else if ((header.m_blockTypeCode == BPV7_BLOCK_TYPE_CODE::INTEGRITY) || (header.m_blockTypeCode == BPV7_BLOCK_TYPE_CODE::CONFIDENTIALITY)) {
+            m_hasBpsecBlocks = true;
+        }
+        else if (header.m_blockTypeCode == BPV7_BLOCK_TYPE_CODE::PAYLOAD) { //last block
+            if (header.m_blockNumber != 1) { //The block number of the payload block is always 1.
+                return false;
+            }
+            if (bufferSize == 0) {
+                return false;
+            }
+            --bufferSize;
+            const uint8_t expectedCborBreakStopCode = *serialization++;
+            if (expectedCborBreakStopCode != 0xff) { //0xff is break character
+                return false;
+            }
+            return (static_cast<uint64_t>(serialization - bundleData) == size); //todo aggregation support
+        }
+        if (blockLocationPtr) {
+            //a block about to get its crc recomputed must be verified first so that corruption isn't masked
+            if ((!skipCrcVerifyInPatchableBlocks) && (!Bpv7CanonicalBlock::DeserializeBpv7IntoExistingBlock(header, serializationThisCanonicalBlockBeginPtr, decodedBlockSize, decodedBlockSize, false))) {
+                return false;
+            }
+            blockLocationPtr->header = header;
+            blockLocationPtr->serializationPtr = serializationThisCanonicalBlockBeginPtr;
+            blockLocationPtr->serializationSize = decodedBlockSize;
+            ++(blockLocationPtr->count);
+        }
+        if (bufferSize == 0) {
+            return false;
+        }
+    }
+}
+
+Bpv7InPlaceForwardingView::UPDATE_RESULT Bpv7InPlaceForwardingView::UpdatePreviousNodeAndIncrementHopCount(const cbhe_eid_t & newPreviousNode) {
+    //If the local node is the source of the bundle, then the bundle MUST NOT contain
+    //any Previous Node block.  Otherwise the bundle SHOULD contain one
+    //(1) occurrence of this type of block and MUST NOT contain more than one.
+    //(A missing previous node block must be added, and multiple blocks are an error, both handled by BundleViewV7.)
+    if ((m_previousNodeBlock.count != 1) || (m_hopCountBlock.count > 1) || m_hasBpsecBlocks) {
+        return UPDATE_RESULT::NEEDS_FULL_RENDER;
+    }
+    if (newPreviousNode.GetSerializationSizeBpv7() != m_previousNodeBlock.header.m_dataLength) {
+        return UPDATE_RESULT::NEEDS_FULL_RENDER;
+    }
+
+    //check everything before modifying anything so that the bundle is never partially modified
+    const bool hasHopCount = (m_hopCountBlock.count != 0);
+    if (hasHopCount) {
+        uint8_t numBytesTakenToDecode;
+        if ((!CborTwoUint64ArrayDeserialize(m_hopCountBlock.header.m_dataPtr, &numBytesTakenToDecode, m_hopCountBlock.header.m_dataLength, m_hopLimit, m_hopCount))
+            || (numBytesTakenToDecode != m_hopCountBlock.header.m_dataLength))
+        {
+            return UPDATE_RESULT::NEEDS_FULL_RENDER; //let BundleViewV7 report the malformed block
+        }
+        //the hop count value SHOULD initially be zero and SHOULD be increased by 1 on each hop.
+        ++m_hopCount;
+        //When a bundle's hop count exceeds its hop limit, the bundle SHOULD be deleted.
+        //Hop limit MUST be in the range 1 through 255.
+        if ((m_hopCount > m_hopLimit) || (m_hopCount > 255)) {
+            return UPDATE_RESULT::HOP_LIMIT_EXCEEDED;
+        }
+        //hop count transition from 23 to 24 (or a non-canonical received encoding) changes the size
+        if (CborTwoUint64ArraySerializationSize(m_hopLimit, m_hopCount) != m_hopCountBlock.header.m_dataLength) {
+            return UPDATE_RESULT::NEEDS_FULL_RENDER;
+        }
+        //(the bufferSize overloads must be used since the fast encoders may write up to 9 bytes per cbor uint past the data)
+        CborTwoUint64ArraySerialize(m_hopCountBlock.header.m_dataPtr, m_hopLimit, m_hopCount, m_hopCountBlock.header.m_dataLength);
+        m_hopCountBlock.header.RecomputeCrcAfterDataModification(m_hopCountBlock.serializationPtr, m_hopCountBlock.serializationSize);
+    }
+
+    newPreviousNode.SerializeBpv7(m_previousNodeBlock.header.m_dataPtr, m_previousNodeBlock.header.m_dataLength);
+    m_previousNodeBlock.header.RecomputeCrcAfterDataModification(m_previousNodeBlock.serializationPtr, m_previousNodeBlock.serializationSize);
+    return UPDATE_RESULT::SUCCESS;
+}
@@ -1,6 +1,7 @@
 #include <boost/test/unit_test.hpp>
 #include <boost/thread.hpp>
 #include "codec/BundleViewV7.h"
+#include "codec/Bpv7InPlaceForwardingView.h"
 #include <iostream>
 #include <string>
 #include <inttypes.h>
@@ -1061,3 +1062,137 @@ BOOST_AUTO_TEST_CASE(Bpv7BibeTestCase)
         }
     }
 }
+
+static std::vector<uint8_t> GenerateForwardingBundle(const BPV7_CRC_TYPE crcTypeToUse, const cbhe_eid_t & previousNode,
+    const uint64_t hopLimit, const uint64_t hopCount, const std::string & payloadString)
+{
+    BundleViewV7 bv;
+    Bpv7CbhePrimaryBlock & primary = bv.m_primaryBlockView.header;
+    primary.SetZero();
+    primary.m_bundleProcessingControlFlags = BPV7_BUNDLEFLAG::NOFRAGMENT;
+    primary.m_sourceNodeId.Set(PRIMARY_SRC_NODE, PRIMARY_SRC_SVC);
+    primary.m_destinationEid.Set(PRIMARY_DEST_NODE, PRIMARY_DEST_SVC);
+    primary.m_reportToEid.Set(0, 0);
+    primary.m_creationTimestamp.millisecondsSinceStartOfYear2000 = PRIMARY_TIME;
+    primary.m_lifetimeMilliseconds = PRIMARY_LIFETIME;
+    primary.m_creationTimestamp.sequenceNumber = PRIMARY_SEQ;
+    primary.m_crcType = crcTypeToUse;
+    bv.m_primaryBlockView.SetManuallyModified();
+
+    if (previousNode.nodeId) { //node 0 means don't add a previous node block
+        std::unique_ptr<Bpv7CanonicalBlock> blockPtr = boost::make_unique<Bpv7PreviousNodeCanonicalBlock>();
+        Bpv7PreviousNodeCanonicalBlock & block = *(reinterpret_cast<Bpv7PreviousNodeCanonicalBlock*>(blockPtr.get()));
+        block.m_blockProcessingControlFlags = BPV7_BLOCKFLAG::REMOVE_BLOCK_IF_IT_CANT_BE_PROCESSED;
+        block.m_blockNumber = 2;
+        block.m_crcType = crcTypeToUse;
+        block.m_previousNode = previousNode;
+        bv.AppendMoveCanonicalBlock(blockPtr);
+    }
+    {
+        std::unique_ptr<Bpv7CanonicalBlock> blockPtr = boost::make_unique<Bpv7HopCountCanonicalBlock>();
+        Bpv7HopCountCanonicalBlock & block = *(reinterpret_cast<Bpv7HopCountCanonicalBlock*>(blockPtr.get()));
+        block.m_blockProcessingControlFlags = BPV7_BLOCKFLAG::REMOVE_BLOCK_IF_IT_CANT_BE_PROCESSED;
+        block.m_blockNumber = 3;
+        block.m_crcType = crcTypeToUse;
+        block.m_hopLimit = hopLimit;
+        block.m_hopCount = hopCount;
+        bv.AppendMoveCanonicalBlock(blockPtr);
+    }
+    {
+        std::unique_ptr<Bpv7CanonicalBlock> blockPtr = boost::make_unique<Bpv7CanonicalBlock>();
+        Bpv7CanonicalBlock & block = *blockPtr;
+        block.m_blockTypeCode = BPV7_BLOCK_TYPE_CODE::PAYLOAD;
+        block.m_blockProcessingControlFlags = BPV7_BLOCKFLAG::REMOVE_BLOCK_IF_IT_CANT_BE_PROCESSED;
+        block.m_blockNumber = 1; //must be 1
+        block.m_crcType = crcTypeToUse;
+        block.m_dataLength = payloadString.size();
+        block.m_dataPtr = (uint8_t*)payloadString.data(); //payloadString must remain in scope until after render
+        bv.AppendMoveCanonicalBlock(blockPtr);
+    }
+    BOOST_REQUIRE(bv.Render(5000));
+    return bv.m_frontBuffer;
+}
+
+BOOST_AUTO_TEST_CASE(Bpv7InPlaceForwardingViewTestCase)
+{
+    const std::string payloadString = { "This is the data inside the bpv7 payload block!!!" };
+    const cbhe_eid_t oldPreviousNode(12345, 678910);
+    const cbhe_eid_t newPreviousNodeSameSize(23456, 987654);
+    const cbhe_eid_t newPreviousNodeSmaller(10, 0);
+    const std::vector<BPV7_CRC_TYPE> crcTypesVec = { BPV7_CRC_TYPE::NONE, BPV7_CRC_TYPE::CRC16_X25, BPV7_CRC_TYPE::CRC32C };
+    for (std::size_t crcI = 0; crcI < crcTypesVec.size(); ++crcI) {
+        const BPV7_CRC_TYPE crcTypeToUse = crcTypesVec[crcI];
+
+        //same cbor sizes => patched in place, identical to the output of a full BundleViewV7 load and render
+        {
+            std::vector<uint8_t> bundleInPlace = GenerateForwardingBundle(crcTypeToUse, oldPreviousNode, 250, 200, payloadString);
+            std::vector<uint8_t> bundleFullRender(bundleInPlace);
+
+            Bpv7InPlaceForwardingView inPlaceView;
+            BOOST_REQUIRE(inPlaceView.LoadBundle(bundleInPlace.data(), bundleInPlace.size()));
+            BOOST_REQUIRE_EQUAL(inPlaceView.m_primaryBlock.m_destinationEid, cbhe_eid_t(PRIMARY_DEST_NODE, PRIMARY_DEST_SVC));
+            BOOST_REQUIRE_EQUAL(inPlaceView.m_previousNodeBlock.count, 1);
+            BOOST_REQUIRE_EQUAL(inPlaceView.m_hopCountBlock.count, 1);
+            BOOST_REQUIRE(inPlaceView.UpdatePreviousNodeAndIncrementHopCount(newPreviousNodeSameSize) == Bpv7InPlaceForwardingView::UPDATE_RESULT::SUCCESS);
+            BOOST_REQUIRE_EQUAL(inPlaceView.m_hopCount, 201);
+
+            BundleViewV7 bv;
+            BOOST_REQUIRE(bv.LoadBundle(bundleFullRender.data(), bundleFullRender.size()));
+            std::vector<BundleViewV7::Bpv7CanonicalBlockView*> blocks;
+            bv.GetCanonicalBlocksByType(BPV7_BLOCK_TYPE_CODE::PREVIOUS_NODE, blocks);
+            BOOST_REQUIRE_EQUAL(blocks.size(), 1);
+            dynamic_cast<Bpv7PreviousNodeCanonicalBlock*>(blocks[0]->headerPtr.get())->m_previousNode = newPreviousNodeSameSize;
+            blocks[0]->SetManuallyModified();
+            bv.GetCanonicalBlocksByType(BPV7_BLOCK_TYPE_CODE::HOP_COUNT, blocks);
+            BOOST_REQUIRE_EQUAL(blocks.size(), 1);
+            ++(dynamic_cast<Bpv7HopCountCanonicalBlock*>(blocks[0]->headerPtr.get())->m_hopCount);
+            blocks[0]->SetManuallyModified();
+            BOOST_REQUIRE(bv.RenderInPlace(0));
+            BOOST_REQUIRE_EQUAL(bv.m_renderedBundle.size(), bundleInPlace.size());
+            BOOST_REQUIRE(memcmp(bv.m_renderedBundle.data(), bundleInPlace.data(), bundleInPlace.size()) == 0);
+
+            //the patched bundle must pass full crc verification
+            BundleViewV7 bvVerify;
+            BOOST_REQUIRE(bvVerify.LoadBundle(bundleInPlace.data(), bundleInPlace.size()));
+            bvVerify.GetCanonicalBlocksByType(BPV7_BLOCK_TYPE_CODE::PREVIOUS_NODE, blocks);
+            BOOST_REQUIRE_EQUAL(blocks.size(), 1);
+            BOOST_REQUIRE_EQUAL(dynamic_cast<Bpv7PreviousNodeCanonicalBlock*>(blocks[0]->headerPtr.get())->m_previousNode, newPreviousNodeSameSize);
+        }
+
+        //size changes or hop limit exceeded => bundle left unmodified
+        {
+            struct TestCase {
+                cbhe_eid_t previousNodeInBundle;
+                uint64_t hopLimit;
+                uint64_t hopCount;
+                cbhe_eid_t newPreviousNode;
+                Bpv7InPlaceForwardingView::UPDATE_RESULT expectedResult;
+            };
+            const std::vector<TestCase> testCases = {
+                { oldPreviousNode, 250, 200, newPreviousNodeSmaller, Bpv7InPlaceForwardingView::UPDATE_RESULT::NEEDS_FULL_RENDER },
+                { cbhe_eid_t(0, 0), 250, 200, newPreviousNodeSameSize, Bpv7InPlaceForwardingView::UPDATE_RESULT::NEEDS_FULL_RENDER }, //no previous node block
+                { oldPreviousNode, 250, 23, newPreviousNodeSameSize, Bpv7InPlaceForwardingView::UPDATE_RESULT::NEEDS_FULL_RENDER }, //hop count 23 to 24
+                { oldPreviousNode, 200, 200, newPreviousNodeSameSize, Bpv7InPlaceForwardingView::UPDATE_RESULT::HOP_LIMIT_EXCEEDED }
+            };
+            for (std::size_t i = 0; i < testCases.size(); ++i) {
+                const TestCase & tc = testCases[i];
+                std::vector<uint8_t> bundle = GenerateForwardingBundle(crcTypeToUse, tc.previousNodeInBundle, tc.hopLimit, tc.hopCount, payloadString);
+                const std::vector<uint8_t> bundleOriginal(bundle);
+                Bpv7InPlaceForwardingView inPlaceView;
+                BOOST_REQUIRE(inPlaceView.LoadBundle(bundle.data(), bundle.size()));
+                BOOST_REQUIRE(inPlaceView.UpdatePreviousNodeAndIncrementHopCount(tc.newPreviousNode) == tc.expectedResult);
+                BOOST_REQUIRE(bundle == bundleOriginal);
+            }
+        }
+
+        //a corrupted block that would get its crc recomputed must be rejected
+        if (crcTypeToUse != BPV7_CRC_TYPE::NONE) {
+            std::vector<uint8_t> bundle = GenerateForwardingBundle(crcTypeToUse, oldPreviousNode, 250, 200, payloadString);
+            Bpv7InPlaceForwardingView inPlaceView;
+            BOOST_REQUIRE(inPlaceView.LoadBundle(bundle.data(), bundle.size()));
+            inPlaceView.m_hopCountBlock.header.m_dataPtr[1] ^= 1; //corrupt hop limit
+            BOOST_REQUIRE(!inPlaceView.LoadBundle(bundle.data(), bundle.size()));
+            BOOST_REQUIRE(inPlaceView.LoadBundle(bundle.data(), bundle.size(), true)); //unless told to skip crc verification
+        }
+    }
+}
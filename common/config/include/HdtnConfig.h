@@ -59,6 +59,17 @@ public:
     uint64_t m_retransmitBundleAfterNoCustodySignalMilliseconds;
     uint64_t m_maxBundleSizeBytes;
     uint64_t m_maxIngressBundleWaitOnEgressMilliseconds;
+    uint64_t m_maxIngressBundleWaitOnStorageMilliseconds; //how long a bundle waits for a storage credit before it is dropped (0 => dropped without waiting)
+    uint64_t m_numIngressWorkerThreads; //0 => process bundles on the induct threads, else number of final dest eid shards each with its own thread
+    uint64_t m_numEgressWorkerThreads; //0 => forward bundles on the egress zmq thread, else number of outduct shards each with its own forwarding thread
+    uint64_t m_egressSchedulerQuantumBytes; //0 => forward bundles in arrival order, else deficit round robin quantum of the egress priority scheduler (only applies to outducts with a nonzero bundlePipelineLimit)
+    uint64_t m_egressSchedulerBulkWeight; //bulk flows get this many quanta per round
+    uint64_t m_egressSchedulerNormalWeight; //normal flows get this many quanta per round (expedited flows are strict priority)
+    uint64_t m_statusReportLifetimeSeconds; //lifetime of the bundle status reports this node generates (e.g. expired bundle deletion)
+    uint64_t m_releaseWindowMinBytes; //lower bound of each outduct's adaptive window of bytes released from storage and not yet acked by egress
+    uint64_t m_releaseWindowMaxBytes; //upper bound of each outduct's adaptive window of bytes released from storage and not yet acked by egress
+    uint64_t m_sharedMemoryBundleArenaNumSlabs; //0 => bundles copied over zmq, else (multi-process mode only) slabs in each producer's shared memory arena
+    uint64_t m_sharedMemoryBundleArenaSlabSizeBytes; //bundles larger than a slab are copied over zmq
     uint64_t m_maxLtpReceiveUdpPacketSizeBytes;
 
     std::string m_zmqIngressAddress;
@@ -35,6 +35,7 @@ struct outduct_element_config_t {
     uint32_t ltpRandomNumberSizeBits;
     uint16_t ltpSenderBoundPort;
     uint64_t ltpMaxSendRateBitsPerSecOrZeroToDisable;
+    uint32_t ltpNumWorkerThreads; //sessions are split between this many LtpEngine threads (default 1)
 
     //specific to udp
     uint64_t udpRateBps;
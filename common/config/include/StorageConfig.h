@@ -77,6 +77,7 @@ public:
     bool m_tryToRestoreFromDisk;
     bool m_autoDeleteFilesOnExit;
     uint64_t m_totalStorageCapacityBytes;
+    std::string m_catalogJournalFilePath; //optional, empty disables the catalog journal (restore always scans every segment)
     storage_disk_config_vector_t m_storageDiskConfigVector;
 };
 
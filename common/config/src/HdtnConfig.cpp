@@ -25,6 +25,17 @@ HdtnConfig::HdtnConfig() :
     m_retransmitBundleAfterNoCustodySignalMilliseconds(10000),
     m_maxBundleSizeBytes(10000000), //10MB
     m_maxIngressBundleWaitOnEgressMilliseconds(2000),
+    m_maxIngressBundleWaitOnStorageMilliseconds(2000),
+    m_numIngressWorkerThreads(0),
+    m_numEgressWorkerThreads(0),
+    m_egressSchedulerQuantumBytes(0),
+    m_egressSchedulerBulkWeight(1),
+    m_egressSchedulerNormalWeight(4),
+    m_statusReportLifetimeSeconds(86400),
+    m_releaseWindowMinBytes(1000000),
+    m_releaseWindowMaxBytes(500000000),
+    m_sharedMemoryBundleArenaNumSlabs(0),
+    m_sharedMemoryBundleArenaSlabSizeBytes(1048576),
     m_maxLtpReceiveUdpPacketSizeBytes(65536),
     m_zmqIngressAddress("localhost"),
     m_zmqEgressAddress("localhost"),
@@ -67,6 +78,17 @@ HdtnConfig::HdtnConfig(const HdtnConfig& o) :
     m_retransmitBundleAfterNoCustodySignalMilliseconds(o.m_retransmitBundleAfterNoCustodySignalMilliseconds),
     m_maxBundleSizeBytes(o.m_maxBundleSizeBytes),
     m_maxIngressBundleWaitOnEgressMilliseconds(o.m_maxIngressBundleWaitOnEgressMilliseconds),
+    m_maxIngressBundleWaitOnStorageMilliseconds(o.m_maxIngressBundleWaitOnStorageMilliseconds),
+    m_numIngressWorkerThreads(o.m_numIngressWorkerThreads),
+    m_numEgressWorkerThreads(o.m_numEgressWorkerThreads),
+    m_egressSchedulerQuantumBytes(o.m_egressSchedulerQuantumBytes),
+    m_egressSchedulerBulkWeight(o.m_egressSchedulerBulkWeight),
+    m_egressSchedulerNormalWeight(o.m_egressSchedulerNormalWeight),
+    m_statusReportLifetimeSeconds(o.m_statusReportLifetimeSeconds),
+    m_releaseWindowMinBytes(o.m_releaseWindowMinBytes),
+    m_releaseWindowMaxBytes(o.m_releaseWindowMaxBytes),
+    m_sharedMemoryBundleArenaNumSlabs(o.m_sharedMemoryBundleArenaNumSlabs),
+    m_sharedMemoryBundleArenaSlabSizeBytes(o.m_sharedMemoryBundleArenaSlabSizeBytes),
     m_maxLtpReceiveUdpPacketSizeBytes(o.m_maxLtpReceiveUdpPacketSizeBytes),
     m_zmqIngressAddress(o.m_zmqIngressAddress),
     m_zmqEgressAddress(o.m_zmqEgressAddress),
@@ -106,6 +128,17 @@ HdtnConfig::HdtnConfig(HdtnConfig&& o) :
     m_retransmitBundleAfterNoCustodySignalMilliseconds(o.m_retransmitBundleAfterNoCustodySignalMilliseconds),
     m_maxBundleSizeBytes(o.m_maxBundleSizeBytes),
     m_maxIngressBundleWaitOnEgressMilliseconds(o.m_maxIngressBundleWaitOnEgressMilliseconds),
+    m_maxIngressBundleWaitOnStorageMilliseconds(o.m_maxIngressBundleWaitOnStorageMilliseconds),
+    m_numIngressWorkerThreads(o.m_numIngressWorkerThreads),
+    m_numEgressWorkerThreads(o.m_numEgressWorkerThreads),
+    m_egressSchedulerQuantumBytes(o.m_egressSchedulerQuantumBytes),
+    m_egressSchedulerBulkWeight(o.m_egressSchedulerBulkWeight),
+    m_egressSchedulerNormalWeight(o.m_egressSchedulerNormalWeight),
+    m_statusReportLifetimeSeconds(o.m_statusReportLifetimeSeconds),
+    m_releaseWindowMinBytes(o.m_releaseWindowMinBytes),
+    m_releaseWindowMaxBytes(o.m_releaseWindowMaxBytes),
+    m_sharedMemoryBundleArenaNumSlabs(o.m_sharedMemoryBundleArenaNumSlabs),
+    m_sharedMemoryBundleArenaSlabSizeBytes(o.m_sharedMemoryBundleArenaSlabSizeBytes),
     m_maxLtpReceiveUdpPacketSizeBytes(o.m_maxLtpReceiveUdpPacketSizeBytes),
     m_zmqIngressAddress(std::move(o.m_zmqIngressAddress)),
     m_zmqEgressAddress(std::move(o.m_zmqEgressAddress)),
@@ -145,6 +178,17 @@ HdtnConfig& HdtnConfig::operator=(const HdtnConfig& o) {
     m_retransmitBundleAfterNoCustodySignalMilliseconds = o.m_retransmitBundleAfterNoCustodySignalMilliseconds;
     m_maxBundleSizeBytes = o.m_maxBundleSizeBytes;
     m_maxIngressBundleWaitOnEgressMilliseconds = o.m_maxIngressBundleWaitOnEgressMilliseconds;
+    m_maxIngressBundleWaitOnStorageMilliseconds = o.m_maxIngressBundleWaitOnStorageMilliseconds;
+    m_numIngressWorkerThreads = o.m_numIngressWorkerThreads;
+    m_numEgressWorkerThreads = o.m_numEgressWorkerThreads;
+    m_egressSchedulerQuantumBytes = o.m_egressSchedulerQuantumBytes;
+    m_egressSchedulerBulkWeight = o.m_egressSchedulerBulkWeight;
+    m_egressSchedulerNormalWeight = o.m_egressSchedulerNormalWeight;
+    m_statusReportLifetimeSeconds = o.m_statusReportLifetimeSeconds;
+    m_releaseWindowMinBytes = o.m_releaseWindowMinBytes;
+    m_releaseWindowMaxBytes = o.m_releaseWindowMaxBytes;
+    m_sharedMemoryBundleArenaNumSlabs = o.m_sharedMemoryBundleArenaNumSlabs;
+    m_sharedMemoryBundleArenaSlabSizeBytes = o.m_sharedMemoryBundleArenaSlabSizeBytes;
     m_maxLtpReceiveUdpPacketSizeBytes = o.m_maxLtpReceiveUdpPacketSizeBytes;
     m_zmqIngressAddress = o.m_zmqIngressAddress;
     m_zmqEgressAddress = o.m_zmqEgressAddress;
@@ -185,6 +229,17 @@ HdtnConfig& HdtnConfig::operator=(HdtnConfig&& o) {
     m_retransmitBundleAfterNoCustodySignalMilliseconds = o.m_retransmitBundleAfterNoCustodySignalMilliseconds;
     m_maxBundleSizeBytes = o.m_maxBundleSizeBytes;
     m_maxIngressBundleWaitOnEgressMilliseconds = o.m_maxIngressBundleWaitOnEgressMilliseconds;
+    m_maxIngressBundleWaitOnStorageMilliseconds = o.m_maxIngressBundleWaitOnStorageMilliseconds;
+    m_numIngressWorkerThreads = o.m_numIngressWorkerThreads;
+    m_numEgressWorkerThreads = o.m_numEgressWorkerThreads;
+    m_egressSchedulerQuantumBytes = o.m_egressSchedulerQuantumBytes;
+    m_egressSchedulerBulkWeight = o.m_egressSchedulerBulkWeight;
+    m_egressSchedulerNormalWeight = o.m_egressSchedulerNormalWeight;
+    m_statusReportLifetimeSeconds = o.m_statusReportLifetimeSeconds;
+    m_releaseWindowMinBytes = o.m_releaseWindowMinBytes;
+    m_releaseWindowMaxBytes = o.m_releaseWindowMaxBytes;
+    m_sharedMemoryBundleArenaNumSlabs = o.m_sharedMemoryBundleArenaNumSlabs;
+    m_sharedMemoryBundleArenaSlabSizeBytes = o.m_sharedMemoryBundleArenaSlabSizeBytes;
     m_maxLtpReceiveUdpPacketSizeBytes = o.m_maxLtpReceiveUdpPacketSizeBytes;
     m_zmqIngressAddress = std::move(o.m_zmqIngressAddress);
     m_zmqEgressAddress = std::move(o.m_zmqEgressAddress);
@@ -227,6 +282,17 @@ bool HdtnConfig::operator==(const HdtnConfig & o) const {
         (m_retransmitBundleAfterNoCustodySignalMilliseconds == o.m_retransmitBundleAfterNoCustodySignalMilliseconds) &&
         (m_maxBundleSizeBytes == o.m_maxBundleSizeBytes) &&
         (m_maxIngressBundleWaitOnEgressMilliseconds == o.m_maxIngressBundleWaitOnEgressMilliseconds) &&
+        (m_maxIngressBundleWaitOnStorageMilliseconds == o.m_maxIngressBundleWaitOnStorageMilliseconds) &&
+        (m_numIngressWorkerThreads == o.m_numIngressWorkerThreads) &&
+        (m_numEgressWorkerThreads == o.m_numEgressWorkerThreads) &&
+        (m_egressSchedulerQuantumBytes == o.m_egressSchedulerQuantumBytes) &&
+        (m_egressSchedulerBulkWeight == o.m_egressSchedulerBulkWeight) &&
+        (m_egressSchedulerNormalWeight == o.m_egressSchedulerNormalWeight) &&
+        (m_statusReportLifetimeSeconds == o.m_statusReportLifetimeSeconds) &&
+        (m_releaseWindowMinBytes == o.m_releaseWindowMinBytes) &&
+        (m_releaseWindowMaxBytes == o.m_releaseWindowMaxBytes) &&
+        (m_sharedMemoryBundleArenaNumSlabs == o.m_sharedMemoryBundleArenaNumSlabs) &&
+        (m_sharedMemoryBundleArenaSlabSizeBytes == o.m_sharedMemoryBundleArenaSlabSizeBytes) &&
         (m_maxLtpReceiveUdpPacketSizeBytes == o.m_maxLtpReceiveUdpPacketSizeBytes) &&
         (m_zmqRegistrationServerAddress == o.m_zmqRegistrationServerAddress) &&
         (m_zmqSchedulerAddress == o.m_zmqSchedulerAddress) &&
@@ -271,6 +337,17 @@ bool HdtnConfig::SetValuesFromPropertyTree(const boost::property_tree::ptree & p
         m_retransmitBundleAfterNoCustodySignalMilliseconds = pt.get<uint64_t>("retransmitBundleAfterNoCustodySignalMilliseconds");
         m_maxBundleSizeBytes = pt.get<uint64_t>("maxBundleSizeBytes");
         m_maxIngressBundleWaitOnEgressMilliseconds = pt.get<uint64_t>("maxIngressBundleWaitOnEgressMilliseconds");
+        m_maxIngressBundleWaitOnStorageMilliseconds = pt.get<uint64_t>("maxIngressBundleWaitOnStorageMilliseconds", 2000); //non-throw version
+        m_numIngressWorkerThreads = pt.get<uint64_t>("numIngressWorkerThreads", 0); //non-throw version
+        m_numEgressWorkerThreads = pt.get<uint64_t>("numEgressWorkerThreads", 0); //non-throw version
+        m_egressSchedulerQuantumBytes = pt.get<uint64_t>("egressSchedulerQuantumBytes", 0); //non-throw version
+        m_egressSchedulerBulkWeight = pt.get<uint64_t>("egressSchedulerBulkWeight", 1); //non-throw version
+        m_egressSchedulerNormalWeight = pt.get<uint64_t>("egressSchedulerNormalWeight", 4); //non-throw version
+        m_statusReportLifetimeSeconds = pt.get<uint64_t>("statusReportLifetimeSeconds", 86400); //non-throw version
+        m_releaseWindowMinBytes = pt.get<uint64_t>("releaseWindowMinBytes", 1000000); //non-throw version
+        m_releaseWindowMaxBytes = pt.get<uint64_t>("releaseWindowMaxBytes", 500000000); //non-throw version
+        m_sharedMemoryBundleArenaNumSlabs = pt.get<uint64_t>("sharedMemoryBundleArenaNumSlabs", 0); //non-throw version
+        m_sharedMemoryBundleArenaSlabSizeBytes = pt.get<uint64_t>("sharedMemoryBundleArenaSlabSizeBytes", 1048576); //non-throw version
         m_maxLtpReceiveUdpPacketSizeBytes = pt.get<uint64_t>("maxLtpReceiveUdpPacketSizeBytes");
 
         m_zmqIngressAddress = pt.get<std::string>("zmqIngressAddress");
@@ -366,6 +443,17 @@ boost::property_tree::ptree HdtnConfig::GetNewPropertyTree() const {
     pt.put("retransmitBundleAfterNoCustodySignalMilliseconds", m_retransmitBundleAfterNoCustodySignalMilliseconds);
     pt.put("maxBundleSizeBytes", m_maxBundleSizeBytes);
     pt.put("maxIngressBundleWaitOnEgressMilliseconds", m_maxIngressBundleWaitOnEgressMilliseconds);
+    pt.put("maxIngressBundleWaitOnStorageMilliseconds", m_maxIngressBundleWaitOnStorageMilliseconds);
+    pt.put("numIngressWorkerThreads", m_numIngressWorkerThreads);
+    pt.put("numEgressWorkerThreads", m_numEgressWorkerThreads);
+    pt.put("egressSchedulerQuantumBytes", m_egressSchedulerQuantumBytes);
+    pt.put("egressSchedulerBulkWeight", m_egressSchedulerBulkWeight);
+    pt.put("egressSchedulerNormalWeight", m_egressSchedulerNormalWeight);
+    pt.put("statusReportLifetimeSeconds", m_statusReportLifetimeSeconds);
+    pt.put("releaseWindowMinBytes", m_releaseWindowMinBytes);
+    pt.put("releaseWindowMaxBytes", m_releaseWindowMaxBytes);
+    pt.put("sharedMemoryBundleArenaNumSlabs", m_sharedMemoryBundleArenaNumSlabs);
+    pt.put("sharedMemoryBundleArenaSlabSizeBytes", m_sharedMemoryBundleArenaSlabSizeBytes);
     pt.put("maxLtpReceiveUdpPacketSizeBytes", m_maxLtpReceiveUdpPacketSizeBytes);
 
     pt.put("zmqIngressAddress", m_zmqIngressAddress);
@@ -31,6 +31,7 @@ induct_element_config_t::induct_element_config_t() :
     ltpRemoteUdpHostname(""),
     ltpRemoteUdpPort(0),
     ltpRxDataSegmentSessionNumberRecreationPreventerHistorySize(0),
+    ltpNumWorkerThreads(1),
     keepAliveIntervalSeconds(0),
 
     tcpclV3MyMaxTxSegmentSizeBytes(0),
@@ -64,6 +65,7 @@ induct_element_config_t::induct_element_config_t(const induct_element_config_t&
     ltpRemoteUdpHostname(o.ltpRemoteUdpHostname),
     ltpRemoteUdpPort(o.ltpRemoteUdpPort),
     ltpRxDataSegmentSessionNumberRecreationPreventerHistorySize(o.ltpRxDataSegmentSessionNumberRecreationPreventerHistorySize),
+    ltpNumWorkerThreads(o.ltpNumWorkerThreads),
     keepAliveIntervalSeconds(o.keepAliveIntervalSeconds),
 
     tcpclV3MyMaxTxSegmentSizeBytes(o.tcpclV3MyMaxTxSegmentSizeBytes),
@@ -94,6 +96,7 @@ induct_element_config_t::induct_element_config_t(induct_element_config_t&& o) :
     ltpRemoteUdpHostname(std::move(o.ltpRemoteUdpHostname)),
     ltpRemoteUdpPort(o.ltpRemoteUdpPort),
     ltpRxDataSegmentSessionNumberRecreationPreventerHistorySize(o.ltpRxDataSegmentSessionNumberRecreationPreventerHistorySize),
+    ltpNumWorkerThreads(o.ltpNumWorkerThreads),
     keepAliveIntervalSeconds(o.keepAliveIntervalSeconds),
 
     tcpclV3MyMaxTxSegmentSizeBytes(o.tcpclV3MyMaxTxSegmentSizeBytes),
@@ -124,6 +127,7 @@ induct_element_config_t& induct_element_config_t::operator=(const induct_element
     ltpRemoteUdpHostname = o.ltpRemoteUdpHostname;
     ltpRemoteUdpPort = o.ltpRemoteUdpPort;
     ltpRxDataSegmentSessionNumberRecreationPreventerHistorySize = o.ltpRxDataSegmentSessionNumberRecreationPreventerHistorySize;
+    ltpNumWorkerThreads = o.ltpNumWorkerThreads;
     keepAliveIntervalSeconds = o.keepAliveIntervalSeconds;
 
     tcpclV3MyMaxTxSegmentSizeBytes = o.tcpclV3MyMaxTxSegmentSizeBytes;
@@ -156,6 +160,7 @@ induct_element_config_t& induct_element_config_t::operator=(induct_element_confi
     ltpRemoteUdpHostname = std::move(o.ltpRemoteUdpHostname);
     ltpRemoteUdpPort = o.ltpRemoteUdpPort;
     ltpRxDataSegmentSessionNumberRecreationPreventerHistorySize = o.ltpRxDataSegmentSessionNumberRecreationPreventerHistorySize;
+    ltpNumWorkerThreads = o.ltpNumWorkerThreads;
     keepAliveIntervalSeconds = o.keepAliveIntervalSeconds;
 
     tcpclV3MyMaxTxSegmentSizeBytes = o.tcpclV3MyMaxTxSegmentSizeBytes;
@@ -187,6 +192,7 @@ bool induct_element_config_t::operator==(const induct_element_config_t & o) cons
         (ltpRemoteUdpHostname == o.ltpRemoteUdpHostname) &&
         (ltpRemoteUdpPort == o.ltpRemoteUdpPort) &&
         (ltpRxDataSegmentSessionNumberRecreationPreventerHistorySize == o.ltpRxDataSegmentSessionNumberRecreationPreventerHistorySize) &&
+        (ltpNumWorkerThreads == o.ltpNumWorkerThreads) &&
         (keepAliveIntervalSeconds == o.keepAliveIntervalSeconds) &&
         
         (tcpclV3MyMaxTxSegmentSizeBytes == o.tcpclV3MyMaxTxSegmentSizeBytes) &&
@@ -291,11 +297,16 @@ bool InductsConfig::SetValuesFromPropertyTree(const boost::property_tree::ptree
                 inductElementConfig.ltpRemoteUdpHostname = inductElementConfigPt.second.get<std::string>("ltpRemoteUdpHostname");
                 inductElementConfig.ltpRemoteUdpPort = inductElementConfigPt.second.get<uint16_t>("ltpRemoteUdpPort");
                 inductElementConfig.ltpRxDataSegmentSessionNumberRecreationPreventerHistorySize = inductElementConfigPt.second.get<uint64_t>("ltpRxDataSegmentSessionNumberRecreationPreventerHistorySize");
+                inductElementConfig.ltpNumWorkerThreads = inductElementConfigPt.second.get<uint32_t>("ltpNumWorkerThreads", 1); //non-throw version
+                if (inductElementConfig.ltpNumWorkerThreads == 0) {
+                    std::cerr << "error parsing JSON inductVector[" << (vectorIndex - 1) << "]: ltpNumWorkerThreads must be at least 1" << std::endl;
+                    return false;
+                }
             }
             else {
                 static const std::vector<std::string> LTP_ONLY_VALUES = { "thisLtpEngineId" , "remoteLtpEngineId", "ltpReportSegmentMtu", "oneWayLightTimeMs", "oneWayMarginTimeMs",
                     "clientServiceId", "preallocatedRedDataBytes", "ltpMaxRetriesPerSerialNumber", "ltpRandomNumberSizeBits", "ltpRemoteUdpHostname", "ltpRemoteUdpPort",
-                    "ltpRxDataSegmentSessionNumberRecreationPreventerHistorySize"
+                    "ltpRxDataSegmentSessionNumberRecreationPreventerHistorySize", "ltpNumWorkerThreads"
                 };
                 for (std::size_t i = 0; i < LTP_ONLY_VALUES.size(); ++i) {
                     if (inductElementConfigPt.second.count(LTP_ONLY_VALUES[i]) != 0) {
@@ -415,6 +426,7 @@ boost::property_tree::ptree InductsConfig::GetNewPropertyTree() const {
             inductElementConfigPt.put("ltpRemoteUdpHostname", inductElementConfig.ltpRemoteUdpHostname);
             inductElementConfigPt.put("ltpRemoteUdpPort", inductElementConfig.ltpRemoteUdpPort);
             inductElementConfigPt.put("ltpRxDataSegmentSessionNumberRecreationPreventerHistorySize", inductElementConfig.ltpRxDataSegmentSessionNumberRecreationPreventerHistorySize);
+            inductElementConfigPt.put("ltpNumWorkerThreads", inductElementConfig.ltpNumWorkerThreads);
         }
         if ((inductElementConfig.convergenceLayer == "stcp") || (inductElementConfig.convergenceLayer == "tcpcl_v3") || (inductElementConfig.convergenceLayer == "tcpcl_v4")) {
             inductElementConfigPt.put("keepAliveIntervalSeconds", inductElementConfig.keepAliveIntervalSeconds);
@@ -35,6 +35,7 @@ outduct_element_config_t::outduct_element_config_t() :
     ltpRandomNumberSizeBits(0),
     ltpSenderBoundPort(0),
     ltpMaxSendRateBitsPerSecOrZeroToDisable(0),
+    ltpNumWorkerThreads(1),
 
     udpRateBps(0),
 
@@ -75,6 +76,7 @@ outduct_element_config_t::outduct_element_config_t(const outduct_element_config_
     ltpRandomNumberSizeBits(o.ltpRandomNumberSizeBits),
     ltpSenderBoundPort(o.ltpSenderBoundPort),
     ltpMaxSendRateBitsPerSecOrZeroToDisable(o.ltpMaxSendRateBitsPerSecOrZeroToDisable),
+    ltpNumWorkerThreads(o.ltpNumWorkerThreads),
 
     udpRateBps(o.udpRateBps),
 
@@ -112,6 +114,7 @@ outduct_element_config_t::outduct_element_config_t(outduct_element_config_t&& o)
     ltpRandomNumberSizeBits(o.ltpRandomNumberSizeBits),
     ltpSenderBoundPort(o.ltpSenderBoundPort),
     ltpMaxSendRateBitsPerSecOrZeroToDisable(o.ltpMaxSendRateBitsPerSecOrZeroToDisable),
+    ltpNumWorkerThreads(o.ltpNumWorkerThreads),
 
     udpRateBps(o.udpRateBps),
 
@@ -149,6 +152,7 @@ outduct_element_config_t& outduct_element_config_t::operator=(const outduct_elem
     ltpRandomNumberSizeBits = o.ltpRandomNumberSizeBits;
     ltpSenderBoundPort = o.ltpSenderBoundPort;
     ltpMaxSendRateBitsPerSecOrZeroToDisable = o.ltpMaxSendRateBitsPerSecOrZeroToDisable;
+    ltpNumWorkerThreads = o.ltpNumWorkerThreads;
 
     udpRateBps = o.udpRateBps;
 
@@ -189,6 +193,7 @@ outduct_element_config_t& outduct_element_config_t::operator=(outduct_element_co
     ltpRandomNumberSizeBits = o.ltpRandomNumberSizeBits;
     ltpSenderBoundPort = o.ltpSenderBoundPort;
     ltpMaxSendRateBitsPerSecOrZeroToDisable = o.ltpMaxSendRateBitsPerSecOrZeroToDisable;
+    ltpNumWorkerThreads = o.ltpNumWorkerThreads;
 
     udpRateBps = o.udpRateBps;
 
@@ -228,6 +233,7 @@ bool outduct_element_config_t::operator==(const outduct_element_config_t & o) co
         (ltpRandomNumberSizeBits == o.ltpRandomNumberSizeBits) &&
         (ltpSenderBoundPort == o.ltpSenderBoundPort) &&
         (ltpMaxSendRateBitsPerSecOrZeroToDisable == o.ltpMaxSendRateBitsPerSecOrZeroToDisable) &&
+        (ltpNumWorkerThreads == o.ltpNumWorkerThreads) &&
 
         (udpRateBps == o.udpRateBps) &&
 
@@ -349,10 +355,16 @@ bool OutductsConfig::SetValuesFromPropertyTree(const boost::property_tree::ptree
                 }
                 outductElementConfig.ltpSenderBoundPort = outductElementConfigPt.second.get<uint16_t>("ltpSenderBoundPort");
                 outductElementConfig.ltpMaxSendRateBitsPerSecOrZeroToDisable = outductElementConfigPt.second.get<uint64_t>("ltpMaxSendRateBitsPerSecOrZeroToDisable");
+                outductElementConfig.ltpNumWorkerThreads = outductElementConfigPt.second.get<uint32_t>("ltpNumWorkerThreads", 1); //non-throw version
+                if (outductElementConfig.ltpNumWorkerThreads == 0) {
+                    std::cerr << "error parsing JSON outductVector[" << (vectorIndex - 1) << "]: ltpNumWorkerThreads must be at least 1" << std::endl;
+                    return false;
+                }
             }
             else {
                 static const std::vector<std::string> LTP_ONLY_VALUES = { "thisLtpEngineId" , "remoteLtpEngineId", "ltpDataSegmentMtu", "oneWayLightTimeMs", "oneWayMarginTimeMs",
-                    "clientServiceId", "numRxCircularBufferElements", "ltpMaxRetriesPerSerialNumber", "ltpCheckpointEveryNthDataSegment", "ltpRandomNumberSizeBits", "ltpSenderBoundPort"
+                    "clientServiceId", "numRxCircularBufferElements", "ltpMaxRetriesPerSerialNumber", "ltpCheckpointEveryNthDataSegment", "ltpRandomNumberSizeBits", "ltpSenderBoundPort",
+                    "ltpNumWorkerThreads"
                 };
                 for (std::size_t i = 0; i < LTP_ONLY_VALUES.size(); ++i) {
                     if (outductElementConfigPt.second.count(LTP_ONLY_VALUES[i]) != 0) {
@@ -495,6 +507,7 @@ boost::property_tree::ptree OutductsConfig::GetNewPropertyTree() const {
             outductElementConfigPt.put("ltpRandomNumberSizeBits", outductElementConfig.ltpRandomNumberSizeBits);
             outductElementConfigPt.put("ltpSenderBoundPort", outductElementConfig.ltpSenderBoundPort);
             outductElementConfigPt.put("ltpMaxSendRateBitsPerSecOrZeroToDisable", outductElementConfig.ltpMaxSendRateBitsPerSecOrZeroToDisable);
+            outductElementConfigPt.put("ltpNumWorkerThreads", outductElementConfig.ltpNumWorkerThreads);
         }
         if (outductElementConfig.convergenceLayer == "udp") {
             outductElementConfigPt.put("udpRateBps", outductElementConfig.udpRateBps);
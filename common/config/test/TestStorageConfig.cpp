@@ -8,12 +8,14 @@ BOOST_AUTO_TEST_CASE(StorageConfigTestCase)
     sc1->m_totalStorageCapacityBytes = 100000;
     sc1->AddDisk("d1", "/mnt/d1/d1.bin");
     sc1->AddDisk("d2", "/mnt/d2/d2.bin");
+    sc1->m_catalogJournalFilePath = "/mnt/d1/catalog_journal.bin";
     //sc1->ToJsonFile("storageConfig.json");
 
     StorageConfig_ptr sc1_copy = boost::make_shared< StorageConfig>();
     sc1_copy->m_totalStorageCapacityBytes = 100000;
     sc1_copy->AddDisk("d1", "/mnt/d1/d1.bin");
     sc1_copy->AddDisk("d2", "/mnt/d2/d2.bin");
+    sc1_copy->m_catalogJournalFilePath = "/mnt/d1/catalog_journal.bin";
 
     StorageConfig_ptr sc2 = boost::make_shared< StorageConfig>();
     sc2->m_totalStorageCapacityBytes = 100000;
@@ -38,6 +40,7 @@ BOOST_AUTO_TEST_CASE(StorageConfigTestCase)
     BOOST_REQUIRE(sc1Json == sc1_fromJson->ToJson());
     BOOST_REQUIRE_EQUAL(sc1_fromJson->m_storageDiskConfigVector.size(), 2);
     BOOST_REQUIRE_EQUAL(sc1_fromJson->m_totalStorageCapacityBytes, 100000);
+    BOOST_REQUIRE_EQUAL(sc1_fromJson->m_catalogJournalFilePath, "/mnt/d1/catalog_journal.bin");
 
 }
 
@@ -0,0 +1,101 @@
+#ifndef _HDTN_INGRESS_ACK_BATCHER_H
+#define _HDTN_INGRESS_ACK_BATCHER_H
+
+#include <stdint.h>
+#include <cstring>
+#include <vector>
+#include "message.hpp"
+#include "zmq.hpp"
+
+namespace hdtn {
+
+//Accumulates acks destined for ingress and run-length encodes consecutive ids (per final destination)
+//so that a single zmq message (IngressAckBatchHdr + IngressAckRange array) can acknowledge many bundles.
+//The owner decides when to send: either when IsFull() (size threshold) or when its event loop
+//has no more work pending (time threshold), so batching never adds latency to an idle path.
+class IngressAckBatcher {
+public:
+    IngressAckBatcher(const uint16_t messageType, const std::size_t maxRangesPerMessage) :
+        m_totalAcksSent(0),
+        m_totalMessagesSent(0),
+        m_totalFailedSends(0),
+        m_messageType(messageType),
+        m_maxRangesPerMessage((maxRangesPerMessage) ? maxRangesPerMessage : 1),
+        m_numPendingAcks(0)
+    {
+        m_ranges.reserve(m_maxRangesPerMessage);
+    }
+
+    void Append(const cbhe_eid_t & finalDestEid, const uint64_t id) {
+        if (!m_ranges.empty()) {
+            IngressAckRange & lastRange = m_ranges.back();
+            if ((lastRange.finalDestEid == finalDestEid) && ((lastRange.firstId + lastRange.count) == id)) {
+                ++lastRange.count;
+                ++m_numPendingAcks;
+                return;
+            }
+        }
+        m_ranges.resize(m_ranges.size() + 1);
+        IngressAckRange & newRange = m_ranges.back();
+        newRange.finalDestEid = finalDestEid;
+        newRange.firstId = id;
+        newRange.count = 1;
+        ++m_numPendingAcks;
+    }
+
+    bool IsEmpty() const {
+        return m_ranges.empty();
+    }
+
+    bool IsFull() const {
+        return (m_ranges.size() >= m_maxRangesPerMessage);
+    }
+
+    //sends all pending acks as one message (non-blocking) and clears the batch;
+    //if the message could not be queued, the acks are kept for a retry on the next Send
+    bool Send(zmq::socket_t & socket) {
+        if (m_ranges.empty()) {
+            return true;
+        }
+        const std::size_t rangesSizeBytes = m_ranges.size() * sizeof(IngressAckRange);
+        zmq::message_t zmqMessage(sizeof(IngressAckBatchHdr) + rangesSizeBytes);
+        IngressAckBatchHdr hdr;
+        hdr.base.type = m_messageType;
+        hdr.base.flags = 0;
+        hdr.numRanges = static_cast<uint32_t>(m_ranges.size());
+        hdr.numAcks = m_numPendingAcks;
+        uint8_t * const data = static_cast<uint8_t*>(zmqMessage.data());
+        memcpy(data, &hdr, sizeof(hdr));
+        memcpy(data + sizeof(hdr), m_ranges.data(), rangesSizeBytes);
+        if (!socket.send(std::move(zmqMessage), zmq::send_flags::dontwait)) {
+            ++m_totalFailedSends;
+            return false;
+        }
+        m_totalAcksSent += m_numPendingAcks;
+        ++m_totalMessagesSent;
+        m_ranges.clear();
+        m_numPendingAcks = 0;
+        return true;
+    }
+
+    uint64_t GetNumPendingAcks() const {
+        return m_numPendingAcks;
+    }
+
+    double GetAverageAcksPerMessage() const {
+        return (m_totalMessagesSent) ? (static_cast<double>(m_totalAcksSent) / static_cast<double>(m_totalMessagesSent)) : 0.0;
+    }
+
+    uint64_t m_totalAcksSent;
+    uint64_t m_totalMessagesSent;
+    uint64_t m_totalFailedSends;
+private:
+    const uint16_t m_messageType;
+    const std::size_t m_maxRangesPerMessage;
+    uint64_t m_numPendingAcks;
+    std::vector<IngressAckRange> m_ranges;
+};
+
+}  // namespace hdtn
+
+#endif  //_HDTN_INGRESS_ACK_BATCHER_H
@@ -12,6 +12,7 @@
 #define HDTN_FLAG_CUSTODY_REQ (0x01)
 #define HDTN_FLAG_CUSTODY_OK (0x02)
 #define HDTN_FLAG_CUSTODY_FAIL (0x04)
+#define HDTN_FLAG_BUNDLE_IN_SHARED_MEMORY (0x0100) //CommonHdr flags: the bundle message part is a shm_bundle_descriptor_t
 
 // Common message types shared by all components
 #define HDTN_MSGTYPE_EGRESS (0x0004)
@@ -49,6 +50,8 @@
 #define HDTN_MSGTYPE_EGRESS_ACK_TO_STORAGE (0x5555)
 #define HDTN_MSGTYPE_EGRESS_ACK_TO_INGRESS (0x5556)
 #define HDTN_MSGTYPE_STORAGE_ACK_TO_INGRESS (0x5557)
+#define HDTN_MSGTYPE_EGRESS_ACK_BATCH_TO_INGRESS (0x5558)
+#define HDTN_MSGTYPE_STORAGE_ACK_BATCH_TO_INGRESS (0x5559)
 
 namespace hdtn {
 //#pragma pack (push, 1)
@@ -66,7 +69,7 @@ struct ToEgressHdr {
     CommonHdr base;
     uint8_t hasCustody;
     uint8_t isCutThroughFromIngress;
-    uint8_t unused3;
+    uint8_t priorityIndex; //00 = bulk, 01 = normal, 10 = expedited
     uint8_t unused4;
     cbhe_eid_t finalDestEid;
     uint64_t custodyId;
@@ -115,6 +118,21 @@ struct StorageAckHdr {
     //}
 };
 
+//a run of consecutive ingress unique ids [firstId, firstId + count) being acked for one final destination
+struct IngressAckRange {
+    cbhe_eid_t finalDestEid;
+    uint64_t firstId;
+    uint64_t count;
+};
+
+//batched acks from egress or storage to ingress.
+//This header is immediately followed (in the same zmq message) by numRanges IngressAckRange structs.
+struct IngressAckBatchHdr {
+    CommonHdr base;
+    uint32_t numRanges;
+    uint64_t numAcks; //sum of all the IngressAckRange counts
+};
+
 struct TelemStorageHdr {
     CommonHdr base;
     StorageStats stats;
@@ -38,6 +38,11 @@ public:
     INDUCT_MANAGER_LIB_EXPORT bool ForwardOnOpportunisticLink(const uint64_t remoteNodeId, zmq::message_t & dataZmq, const uint32_t timeoutSeconds);
     INDUCT_MANAGER_LIB_EXPORT bool ForwardOnOpportunisticLink(const uint64_t remoteNodeId, const uint8_t* bundleData, const std::size_t size, const uint32_t timeoutSeconds);
 
+    //called (from any thread) when the consumer of received bundles is out of credits;
+    //convergence layers with flow control (tcpcl) stop reading from their sockets until called again with false.
+    //Default implementation is a no-op (udp/ltp/stcp have no way to throttle the sender without dropping).
+    INDUCT_MANAGER_LIB_EXPORT virtual void SetBackPressure(const bool backPressureActive);
+
 protected:
     struct OpportunisticBundleQueue { //tcpcl only
         INDUCT_MANAGER_LIB_EXPORT OpportunisticBundleQueue();
@@ -12,6 +12,7 @@ public:
         const uint64_t myNodeId, const uint64_t maxUdpRxPacketSizeBytesForAllLtp, const uint64_t maxBundleSizeBytes,
         const OnNewOpportunisticLinkCallback_t & onNewOpportunisticLinkCallback, const OnDeletedOpportunisticLinkCallback_t & onDeletedOpportunisticLinkCallback);
     INDUCT_MANAGER_LIB_EXPORT void Clear();
+    INDUCT_MANAGER_LIB_EXPORT void SetBackPressure(const bool backPressureActive);
 public:
 
     std::list<std::unique_ptr<Induct> > m_inductsList;
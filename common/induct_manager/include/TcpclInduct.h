@@ -13,6 +13,7 @@ public:
         const uint64_t myNodeId, const uint64_t maxBundleSizeBytes, const OnNewOpportunisticLinkCallback_t & onNewOpportunisticLinkCallback,
         const OnDeletedOpportunisticLinkCallback_t & onDeletedOpportunisticLinkCallback);
     INDUCT_MANAGER_LIB_EXPORT virtual ~TcpclInduct();
+    INDUCT_MANAGER_LIB_EXPORT virtual void SetBackPressure(const bool backPressureActive);
     
 private:
     
@@ -26,6 +27,7 @@ private:
     INDUCT_MANAGER_LIB_EXPORT void OnContactHeaderCallback_FromIoServiceThread(TcpclBundleSink * thisTcpclBundleSinkPtr);
     INDUCT_MANAGER_LIB_EXPORT void NotifyBundleReadyToSend_FromIoServiceThread(const uint64_t remoteNodeId);
     INDUCT_MANAGER_LIB_EXPORT virtual void Virtual_PostNotifyBundleReadyToSend_FromIoServiceThread(const uint64_t remoteNodeId);
+    INDUCT_MANAGER_LIB_EXPORT void SetBackPressure_FromIoServiceThread(const bool backPressureActive);
 
     boost::asio::io_service m_ioService;
     boost::asio::ip::tcp::acceptor m_tcpAcceptor;
@@ -34,6 +36,7 @@ private:
     std::list<TcpclBundleSink> m_listTcpclBundleSinks;
     const uint64_t M_MY_NODE_ID;
     volatile bool m_allowRemoveInactiveTcpConnections;
+    bool m_backPressureActive; //io service thread only
     const uint64_t M_MAX_BUNDLE_SIZE_BYTES;
 
     
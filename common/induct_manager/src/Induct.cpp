@@ -108,6 +108,8 @@ bool Induct::ForwardOnOpportunisticLink(const uint64_t remoteNodeId, zmq::messag
 
 void Induct::Virtual_PostNotifyBundleReadyToSend_FromIoServiceThread(const uint64_t remoteNodeId) {}
 
+void Induct::SetBackPressure(const bool backPressureActive) {}
+
 bool Induct::BundleSinkTryGetData_FromIoServiceThread(OpportunisticBundleQueue & opportunisticBundleQueue, std::pair<std::unique_ptr<zmq::message_t>, std::vector<uint8_t> > & bundleDataPair) {
     return opportunisticBundleQueue.TryPop_ThreadSafe(bundleDataPair);
 }
@@ -50,3 +50,9 @@ void InductManager::LoadInductsFromConfig(const InductProcessBundleCallback_t &
 void InductManager::Clear() {
     m_inductsList.clear();
 }
+
+void InductManager::SetBackPressure(const bool backPressureActive) {
+    for (std::list<std::unique_ptr<Induct> >::iterator it = m_inductsList.begin(); it != m_inductsList.end(); ++it) {
+        (*it)->SetBackPressure(backPressureActive);
+    }
+}
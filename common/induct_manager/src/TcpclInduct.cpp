@@ -13,6 +13,7 @@ TcpclInduct::TcpclInduct(const InductProcessBundleCallback_t & inductProcessBund
     m_workPtr(boost::make_unique<boost::asio::io_service::work>(m_ioService)),
     M_MY_NODE_ID(myNodeId),
     m_allowRemoveInactiveTcpConnections(true),
+    m_backPressureActive(false),
     M_MAX_BUNDLE_SIZE_BYTES(maxBundleSizeBytes)    
 {
     m_onNewOpportunisticLinkCallback = onNewOpportunisticLinkCallback;
@@ -65,6 +66,9 @@ void TcpclInduct::HandleTcpAccept(boost::shared_ptr<boost::asio::ip::tcp::socket
             boost::bind(&TcpclInduct::OnContactHeaderCallback_FromIoServiceThread, this, boost::placeholders::_1),
             10, //const unsigned int maxUnacked, (todo)
             m_inductConfig.tcpclV3MyMaxTxSegmentSizeBytes); //const uint64_t maxFragmentSize = 100000000); (todo)
+        if (m_backPressureActive) {
+            m_listTcpclBundleSinks.back().SetRxPausedByBackPressure_FromIoServiceThread(true);
+        }
 
         StartTcpAccept(); //only accept if there was no error
     }
@@ -135,3 +139,14 @@ void TcpclInduct::NotifyBundleReadyToSend_FromIoServiceThread(const uint64_t rem
 void TcpclInduct::Virtual_PostNotifyBundleReadyToSend_FromIoServiceThread(const uint64_t remoteNodeId) {
     boost::asio::post(m_ioService, boost::bind(&TcpclInduct::NotifyBundleReadyToSend_FromIoServiceThread, this, remoteNodeId));
 }
+
+void TcpclInduct::SetBackPressure_FromIoServiceThread(const bool backPressureActive) {
+    m_backPressureActive = backPressureActive;
+    for (std::list<TcpclBundleSink>::iterator it = m_listTcpclBundleSinks.begin(); it != m_listTcpclBundleSinks.end(); ++it) {
+        it->SetRxPausedByBackPressure_FromIoServiceThread(backPressureActive);
+    }
+}
+
+void TcpclInduct::SetBackPressure(const bool backPressureActive) {
+    boost::asio::post(m_ioService, boost::bind(&TcpclInduct::SetBackPressure_FromIoServiceThread, this, backPressureActive));
+}
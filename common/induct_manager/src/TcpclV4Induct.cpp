@@ -16,6 +16,7 @@ TcpclV4Induct::TcpclV4Induct(const InductProcessBundleCallback_t & inductProcess
     m_workPtr(boost::make_unique<boost::asio::io_service::work>(m_ioService)),
     M_MY_NODE_ID(myNodeId),
     m_allowRemoveInactiveTcpConnections(true),
+    m_backPressureActive(false),
     M_MAX_BUNDLE_SIZE_BYTES(maxBundleSizeBytes)    
 {
     m_tlsSuccessfullyConfigured = false;
@@ -119,6 +120,9 @@ void TcpclV4Induct::HandleTcpAccept(boost::shared_ptr<boost::asio::ip::tcp::sock
             boost::bind(&TcpclV4Induct::OnContactHeaderCallback_FromIoServiceThread, this, boost::placeholders::_1),
             10, //const unsigned int maxUnacked, (todo)
             m_inductConfig.tcpclV4MyMaxRxSegmentSizeBytes); //const uint64_t maxFragmentSize = 100000000); (todo)
+        if (m_backPressureActive) {
+            m_listTcpclV4BundleSinks.back().SetRxPausedByBackPressure_FromIoServiceThread(true);
+        }
 
         StartTcpAccept(); //only accept if there was no error
     }
@@ -181,3 +185,14 @@ void TcpclV4Induct::NotifyBundleReadyToSend_FromIoServiceThread(const uint64_t r
 void TcpclV4Induct::Virtual_PostNotifyBundleReadyToSend_FromIoServiceThread(const uint64_t remoteNodeId) {
     boost::asio::post(m_ioService, boost::bind(&TcpclV4Induct::NotifyBundleReadyToSend_FromIoServiceThread, this, remoteNodeId));
 }
+
+void TcpclV4Induct::SetBackPressure_FromIoServiceThread(const bool backPressureActive) {
+    m_backPressureActive = backPressureActive;
+    for (std::list<TcpclV4BundleSink>::iterator it = m_listTcpclV4BundleSinks.begin(); it != m_listTcpclV4BundleSinks.end(); ++it) {
+        it->SetRxPausedByBackPressure_FromIoServiceThread(backPressureActive);
+    }
+}
+
+void TcpclV4Induct::SetBackPressure(const bool backPressureActive) {
+    boost::asio::post(m_ioService, boost::bind(&TcpclV4Induct::SetBackPressure_FromIoServiceThread, this, backPressureActive));
+}
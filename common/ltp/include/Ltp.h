@@ -220,6 +220,9 @@ public:
 	typedef boost::function<void(uint8_t segmentTypeFlags, const session_id_t & sessionId,
         std::vector<uint8_t> & clientServiceDataVec, const data_segment_metadata_t & dataSegmentMetadata,
         Ltp::ltp_extensions_t & headerExtensions, Ltp::ltp_extensions_t & trailerExtensions)> DataSegmentContentsReadCallback_t;
+    typedef boost::function<void(uint8_t segmentTypeFlags, const session_id_t & sessionId,
+        const uint8_t * clientServiceData, const data_segment_metadata_t & dataSegmentMetadata,
+        Ltp::ltp_extensions_t & headerExtensions, Ltp::ltp_extensions_t & trailerExtensions)> DataSegmentContentsReadInPlaceCallback_t;
     typedef boost::function<void(const session_id_t & sessionId, const report_segment_t & reportSegment,
         Ltp::ltp_extensions_t & headerExtensions, Ltp::ltp_extensions_t & trailerExtensions)> ReportSegmentContentsReadCallback_t;
     typedef boost::function<void(const session_id_t & sessionId, uint64_t reportSerialNumberBeingAcknowledged,
@@ -235,6 +238,10 @@ public:
     LTP_LIB_EXPORT ~Ltp();
     
     LTP_LIB_EXPORT void SetDataSegmentContentsReadCallback(const DataSegmentContentsReadCallback_t & callback);
+    //Optional. When set, a data segment whose client service data lies entirely within the buffer passed to one HandleReceivedChars call
+    //(and that has no trailer extensions) is handed over with clientServiceData pointing into that buffer (valid only for the duration of the callback)
+    //instead of being copied into m_dataSegment_clientServiceData first. All other data segments still go to the DataSegmentContentsReadCallback_t.
+    LTP_LIB_EXPORT void SetDataSegmentContentsReadInPlaceCallback(const DataSegmentContentsReadInPlaceCallback_t & callback);
     LTP_LIB_EXPORT void SetReportSegmentContentsReadCallback(const ReportSegmentContentsReadCallback_t & callback);
     LTP_LIB_EXPORT void SetReportAcknowledgementSegmentContentsReadCallback(const ReportAcknowledgementSegmentContentsReadCallback_t & callback);
     LTP_LIB_EXPORT void SetCancelSegmentContentsReadCallback(const CancelSegmentContentsReadCallback_t & callback);
@@ -244,6 +251,11 @@ public:
     LTP_LIB_EXPORT void InitRx();
     LTP_LIB_EXPORT bool HandleReceivedChars(const uint8_t * rxVals, std::size_t numChars, std::string & errorMessage, SessionOriginatorEngineIdDecodedCallback_t * sessionOriginatorEngineIdDecodedCallbackPtr = NULL);
     LTP_LIB_EXPORT void HandleReceivedChar(const uint8_t rxVal, std::string & errorMessage);
+    //For transports that deliver whole segments (e.g. one UDP datagram): every complete segment in the buffer is decoded in one pass
+    //(consecutive sdnvs decoded together) and its client service data goes to the in-place callback when one is set.
+    //Whatever is not a complete well formed segment (or arrives while a segment streamed in through HandleReceivedChars is incomplete)
+    //is passed on to HandleReceivedChars, so it is always safe to call this instead of HandleReceivedChars.
+    LTP_LIB_EXPORT bool HandleReceivedDatagram(const uint8_t * datagram, std::size_t size, std::string & errorMessage, SessionOriginatorEngineIdDecodedCallback_t * sessionOriginatorEngineIdDecodedCallbackPtr = NULL);
     LTP_LIB_EXPORT bool IsAtBeginningState() const; //unit testing convenience function
 
     
@@ -268,6 +280,7 @@ private:
     LTP_LIB_NO_EXPORT bool NextStateAfterTrailerExtensions(std::string & errorMessage);
     LTP_LIB_NO_EXPORT const uint8_t * TryShortcutReadDataSegmentSdnvs(const uint8_t * rxVals, std::size_t & numChars, std::string & errorMessage);
     LTP_LIB_NO_EXPORT const uint8_t * TryShortcutReadReportSegmentSdnvs(const uint8_t * rxVals, std::size_t & numChars, std::string & errorMessage);
+    LTP_LIB_NO_EXPORT std::size_t TryDecodeWholeSegment(const uint8_t * data, const std::size_t size, SessionOriginatorEngineIdDecodedCallback_t * sessionOriginatorEngineIdDecodedCallbackPtr);
 public:
 	std::vector<uint8_t> m_sdnvTempVec;
     LTP_MAIN_RX_STATE m_mainRxState;
@@ -300,6 +313,7 @@ public:
         
 	//callback functions
 	DataSegmentContentsReadCallback_t m_dataSegmentContentsReadCallback;
+    DataSegmentContentsReadInPlaceCallback_t m_dataSegmentContentsReadInPlaceCallback;
     ReportSegmentContentsReadCallback_t m_reportSegmentContentsReadCallback;
     ReportAcknowledgementSegmentContentsReadCallback_t m_reportAcknowledgementSegmentContentsReadCallback;
     CancelSegmentContentsReadCallback_t m_cancelSegmentContentsReadCallback;
@@ -20,7 +20,8 @@ public:
         const uint16_t myBoundUdpPort, const unsigned int numUdpRxCircularBufferVectors,
         const uint64_t ESTIMATED_BYTES_TO_RECEIVE_PER_SESSION,
         uint32_t ltpMaxRetriesPerSerialNumber, const bool force32BitRandomNumbers,
-        const std::string & remoteUdpHostname, const uint16_t remoteUdpPort, const uint64_t maxBundleSizeBytes);
+        const std::string & remoteUdpHostname, const uint16_t remoteUdpPort, const uint64_t maxBundleSizeBytes,
+        const unsigned int numWorkerThreads);
     LTP_LIB_EXPORT ~LtpBundleSink();
     LTP_LIB_EXPORT bool ReadyToBeDeleted();
 private:
@@ -32,6 +33,7 @@ private:
     LTP_LIB_NO_EXPORT void ReceptionSessionCancelledCallback(const Ltp::session_id_t & sessionId, CANCEL_SEGMENT_REASON_CODES reasonCode);
 
     const LtpWholeBundleReadyCallback_t m_ltpWholeBundleReadyCallback;
+    boost::mutex m_receptionCallbackMutex; //the ltp callbacks come from every worker thread of the engine, the bundle ready callback is not reentrant
 
     //ltp vars
     const uint64_t M_THIS_ENGINE_ID;
@@ -3,6 +3,7 @@
 
 #include <boost/random/random_device.hpp>
 #include <boost/thread.hpp>
+#include <boost/atomic.hpp>
 #include "LtpFragmentSet.h"
 #include "Ltp.h"
 #include "LtpRandomNumberGenerator.h"
@@ -30,6 +31,11 @@ public:
         bool isFromSender;
         uint8_t retryCount;
     };
+    struct packet_to_send_t {
+        std::vector<boost::asio::const_buffer> constBufferVec;
+        boost::shared_ptr<std::vector<std::vector<uint8_t> > > underlyingDataToDeleteOnSentCallback;
+        uint64_t sessionOriginatorEngineId;
+    };
     
     LTP_LIB_EXPORT LtpEngine(const uint64_t thisEngineId, const uint8_t engineIndexForEncodingIntoRandomSessionNumber, const uint64_t mtuClientServiceData, uint64_t mtuReportSegment,
         const boost::posix_time::time_duration & oneWayLightTime, const boost::posix_time::time_duration & oneWayMarginTime,
@@ -41,6 +47,9 @@ public:
     LTP_LIB_EXPORT virtual void Reset();
     LTP_LIB_EXPORT void SetCheckpointEveryNthDataPacketForSenders(uint64_t checkpointEveryNthDataPacketSender);
     LTP_LIB_EXPORT void SetMtuReportSegment(uint64_t mtuReportSegment);
+    //Up to this many packets (default 1) are dequeued per send opportunity and handed to SendPackets as one batch.
+    //The token rate limiter is still consulted before each packet of a batch.
+    LTP_LIB_EXPORT void SetMaxPacketsToSendPerBatch(unsigned int maxPacketsToSendPerBatch);
 
     LTP_LIB_EXPORT void TransmissionRequest(boost::shared_ptr<transmission_request_t> & transmissionRequest);
     LTP_LIB_EXPORT void TransmissionRequest_ThreadSafe(boost::shared_ptr<transmission_request_t> && transmissionRequest);
@@ -70,17 +79,37 @@ public:
 
     LTP_LIB_EXPORT bool NextPacketToSendRoundRobin(std::vector<boost::asio::const_buffer> & constBufferVec, boost::shared_ptr<std::vector<std::vector<uint8_t> > > & underlyingDataToDeleteOnSentCallback, uint64_t & sessionOriginatorEngineId);
 
+    //includes the sessions of any worker engines (safe to call from any thread)
     LTP_LIB_EXPORT std::size_t NumActiveReceivers() const;
     LTP_LIB_EXPORT std::size_t NumActiveSenders() const;
 
     LTP_LIB_EXPORT void UpdateRate(const uint64_t maxSendRateBitsPerSecOrZeroToDisable);
+    //with worker engines, this engine and its workers all take their tokens from this engine's rate limiter
     LTP_LIB_EXPORT void UpdateRate_ThreadSafe(const uint64_t maxSendRateBitsPerSecOrZeroToDisable);
 protected:
+    //A worker engine runs a share of this engine's sessions on its own thread (see LtpUdpEngine).  The setters, TransmissionRequest_ThreadSafe (round robin),
+    //CancellationRequest_ThreadSafe and UpdateRate_ThreadSafe of this engine also apply to its workers, but received packets must be routed by the caller.
+    LTP_LIB_EXPORT void AddWorkerEngine(LtpEngine * workerEnginePtr);
+    //0 for this engine, otherwise 1 + the index of the worker engine (in the order added) that owns the session.
+    //A transmission session is owned by the engine whose engine index is encoded in its session number (this engine's index + worker index),
+    //and a reception session by the engine at (session number modulo number of engines).
+    LTP_LIB_EXPORT std::size_t GetOwningWorkerIndex(const Ltp::session_id_t & sessionId) const;
     LTP_LIB_EXPORT virtual void PacketInFullyProcessedCallback(bool success);
     LTP_LIB_EXPORT virtual void SendPacket(std::vector<boost::asio::const_buffer> & constBufferVec, boost::shared_ptr<std::vector<std::vector<uint8_t> > > & underlyingDataToDeleteOnSentCallback, const uint64_t sessionOriginatorEngineId);
+    //called instead of SendPacket when more than one packet was dequeued (default implementation calls SendPacket for each);
+    //the underlyingDataToDeleteOnSentCallback of each packet not moved out by the implementation is released upon return
+    LTP_LIB_EXPORT virtual void SendPackets(std::vector<packet_to_send_t> & packetsToSend, const std::size_t numPacketsToSend);
     LTP_LIB_EXPORT void SignalReadyForSend_ThreadSafe();
+    //lets a derived engine run its own work on the LtpEngine thread (e.g. a batch of received packets in one post)
+    LTP_LIB_EXPORT void PostToLtpEngine_ThreadSafe(const boost::function<void()> & handler);
 private:
     LTP_LIB_NO_EXPORT void TrySendPacketIfAvailable();
+    LTP_LIB_NO_EXPORT void TrySendPacketBatchIfAvailable();
+    LTP_LIB_NO_EXPORT bool CanTakeSharedTokens();
+    LTP_LIB_NO_EXPORT void TakeSharedTokens(const uint64_t tokens);
+    LTP_LIB_NO_EXPORT void StartSharedTokenRefreshClock(const boost::posix_time::ptime & nowPtime);
+    LTP_LIB_NO_EXPORT bool RefreshSharedTokens(const boost::posix_time::ptime & nowPtime); //returns true if the bucket is full
+    LTP_LIB_NO_EXPORT void UpdateNumActiveSessions();
 
     LTP_LIB_NO_EXPORT void CancelSegmentReceivedCallback(const Ltp::session_id_t & sessionId, CANCEL_SEGMENT_REASON_CODES reasonCode, bool isFromSender,
         Ltp::ltp_extensions_t & headerExtensions, Ltp::ltp_extensions_t & trailerExtensions);
@@ -93,6 +122,10 @@ private:
     LTP_LIB_NO_EXPORT void DataSegmentReceivedCallback(uint8_t segmentTypeFlags, const Ltp::session_id_t & sessionId,
         std::vector<uint8_t> & clientServiceDataVec, const Ltp::data_segment_metadata_t & dataSegmentMetadata,
         Ltp::ltp_extensions_t & headerExtensions, Ltp::ltp_extensions_t & trailerExtensions);
+    LTP_LIB_NO_EXPORT void DataSegmentReceivedInPlaceCallback(uint8_t segmentTypeFlags, const Ltp::session_id_t & sessionId,
+        const uint8_t * clientServiceData, const Ltp::data_segment_metadata_t & dataSegmentMetadata,
+        Ltp::ltp_extensions_t & headerExtensions, Ltp::ltp_extensions_t & trailerExtensions);
+    LTP_LIB_NO_EXPORT LtpSessionReceiver * GetOrCreateSessionReceiverForDataSegment(const Ltp::session_id_t & sessionId, const uint64_t clientServiceId);
 
     LTP_LIB_NO_EXPORT void CancelSegmentTimerExpiredCallback(Ltp::session_id_t cancelSegmentTimerSerialNumber, std::vector<uint8_t> & userData);
     LTP_LIB_NO_EXPORT void NotifyEngineThatThisSenderNeedsDeletedCallback(const Ltp::session_id_t & sessionId, bool wasCancelled, CANCEL_SEGMENT_REASON_CODES reasonCode, std::shared_ptr<LtpTransmissionRequestUserData> & userDataPtr);
@@ -115,6 +148,8 @@ private:
     const bool M_FORCE_32_BIT_RANDOM_NUMBERS;
     boost::random_device m_randomDevice;
     //boost::mutex m_randomDeviceMutex;
+    boost::asio::io_service m_ioServiceLtpEngine; //for timers and post calls only
+    LtpTimingWheel m_timingWheel; //all session timers (declared before the sessions so it outlives them)
     std::map<uint64_t, std::unique_ptr<LtpSessionSender> > m_mapSessionNumberToSessionSender;
     std::map<Ltp::session_id_t, std::unique_ptr<LtpSessionReceiver> > m_mapSessionIdToSessionReceiver;
     std::list<std::pair<uint64_t, std::vector<uint8_t> > > m_closedSessionDataToSend; //sessionOriginatorEngineId, data
@@ -137,16 +172,27 @@ private:
     uint64_t m_maxReceptionClaims;
     uint32_t m_maxRetriesPerSerialNumber;
 
-    boost::asio::io_service m_ioServiceLtpEngine; //for timers and post calls only
     std::unique_ptr<boost::asio::io_service::work> m_workLtpEnginePtr;
     LtpTimerManager<Ltp::session_id_t> m_timeManagerOfCancelSegments;
+    //the rate limiter and its refresh time are shared with the worker engines, so only the owner's (this engine or the engine
+    //that added this worker) are used, under the owner's m_tokenRateLimiterMutex; each engine runs its own refresh timer
+    LtpEngine * m_tokenRateLimiterOwnerPtr;
+    boost::mutex m_tokenRateLimiterMutex;
     BorrowableTokenRateLimiter m_tokenRateLimiter;
     boost::asio::deadline_timer m_tokenRefreshTimer;
     uint64_t m_maxSendRateBitsPerSecOrZeroToDisable;
     bool m_tokenRefreshTimerIsRunning;
     boost::posix_time::ptime m_lastTimeTokensWereRefreshed;
+    unsigned int m_maxPacketsToSendPerBatch;
+    std::vector<packet_to_send_t> m_packetsToSendBatchVec;
     std::unique_ptr<boost::thread> m_ioServiceLtpEngineThreadPtr;
 
+    std::vector<LtpEngine*> m_workerEnginesPtrVec;
+    boost::atomic<unsigned int> m_nextEngineForTransmissionRequest;
+    //sizes of the session maps, which are only touched by this engine's thread
+    boost::atomic<std::size_t> m_numActiveSendersAtomic;
+    boost::atomic<std::size_t> m_numActiveReceiversAtomic;
+
     //session re-creation prevention
     std::map<uint64_t, std::unique_ptr<LtpSessionRecreationPreventer> > m_mapSessionOriginatorEngineIdToLtpSessionRecreationPreventer;
 
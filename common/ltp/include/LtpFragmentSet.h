@@ -15,7 +15,10 @@ public:
     static bool SplitReportSegment(const Ltp::report_segment_t & originalTooLargeReportSegment, std::vector<Ltp::report_segment_t> & reportSegmentsVec, const uint64_t maxReceptionClaimsPerReportSegment);
     static void AddReportSegmentToFragmentSet(std::set<data_fragment_t> & fragmentSet, const Ltp::report_segment_t & reportSegment);
     static void AddReportSegmentToFragmentSetNeedingResent(std::set<data_fragment_t> & fragmentSetNeedingResent, const Ltp::report_segment_t & reportSegment);
+
+    static bool PopulateReportSegment(const data_fragment_vec_t & fragmentVec, Ltp::report_segment_t & reportSegment, uint64_t lowerBound = UINT64_MAX, uint64_t upperBound = UINT64_MAX);
+    static void AddReportSegmentToFragmentSet(data_fragment_vec_t & fragmentVec, const Ltp::report_segment_t & reportSegment);
+    static void AddReportSegmentToFragmentSetNeedingResent(data_fragment_vec_t & fragmentVecNeedingResent, const Ltp::report_segment_t & reportSegment);
 };
 
 #endif // LTP_FRAGMENT_SET_H
-
@@ -24,7 +24,7 @@ public:
     
     LTP_LIB_EXPORT LtpSessionReceiver(uint64_t randomNextReportSegmentReportSerialNumber, const uint64_t MAX_RECEPTION_CLAIMS, const uint64_t ESTIMATED_BYTES_TO_RECEIVE, const uint64_t maxRedRxBytes,
         const Ltp::session_id_t & sessionId, const uint64_t clientServiceId,
-        const boost::posix_time::time_duration & oneWayLightTime, const boost::posix_time::time_duration & oneWayMarginTime, boost::asio::io_service & ioServiceRef,
+        const boost::posix_time::time_duration & oneWayLightTime, const boost::posix_time::time_duration & oneWayMarginTime, LtpTimingWheel & timingWheelRef,
         const NotifyEngineThatThisReceiverNeedsDeletedCallback_t & notifyEngineThatThisReceiverNeedsDeletedCallback,
         const NotifyEngineThatThisReceiversTimersProducedDataFunction_t & notifyEngineThatThisSendersTimersProducedDataFunction,
         const uint32_t maxRetriesPerSerialNumber = 5);
@@ -39,11 +39,21 @@ public:
         std::vector<uint8_t> & clientServiceDataVec, const Ltp::data_segment_metadata_t & dataSegmentMetadata,
         Ltp::ltp_extensions_t & headerExtensions, Ltp::ltp_extensions_t & trailerExtensions, const RedPartReceptionCallback_t & redPartReceptionCallback,
         const GreenPartSegmentArrivalCallback_t & greenPartSegmentArrivalCallback);
+    //same as above but clientServiceData (of length dataSegmentMetadata.length) points into the received datagram rather than into a vector
+    LTP_LIB_EXPORT void DataSegmentReceivedCallback(uint8_t segmentTypeFlags,
+        const uint8_t * clientServiceData, const Ltp::data_segment_metadata_t & dataSegmentMetadata,
+        Ltp::ltp_extensions_t & headerExtensions, Ltp::ltp_extensions_t & trailerExtensions, const RedPartReceptionCallback_t & redPartReceptionCallback,
+        const GreenPartSegmentArrivalCallback_t & greenPartSegmentArrivalCallback);
+private:
+    LTP_LIB_NO_EXPORT void DataSegmentReceived(uint8_t segmentTypeFlags,
+        const uint8_t * clientServiceData, std::vector<uint8_t> * clientServiceDataVecPtr, const Ltp::data_segment_metadata_t & dataSegmentMetadata,
+        Ltp::ltp_extensions_t & headerExtensions, Ltp::ltp_extensions_t & trailerExtensions, const RedPartReceptionCallback_t & redPartReceptionCallback,
+        const GreenPartSegmentArrivalCallback_t & greenPartSegmentArrivalCallback);
 private:
-    std::set<LtpFragmentSet::data_fragment_t> m_receivedDataFragmentsSet;
+    LtpFragmentSet::data_fragment_vec_t m_receivedDataFragmentsSet;
     std::map<uint64_t, Ltp::report_segment_t> m_mapAllReportSegmentsSent;
     std::map<uint64_t, Ltp::report_segment_t> m_mapPrimaryReportSegmentsSent;
-    std::set<LtpFragmentSet::data_fragment_t> m_receivedDataFragmentsThatSenderKnowsAboutSet;
+    LtpFragmentSet::data_fragment_vec_t m_receivedDataFragmentsThatSenderKnowsAboutSet;
     std::set<uint64_t> m_checkpointSerialNumbersReceivedSet;
     std::list<std::pair<uint64_t, uint8_t> > m_reportSerialNumbersToSendList; //pair<reportSerialNumber, retryCount>
     LtpTimerManager<uint64_t> m_timeManagerOfReportSerialNumbers;
@@ -61,7 +71,6 @@ private:
     bool m_didRedPartReceptionCallback;
     bool m_didNotifyForDeletion;
     bool m_receivedEobFromGreenOrRed;
-    boost::asio::io_service & m_ioServiceRef;
     const NotifyEngineThatThisReceiverNeedsDeletedCallback_t m_notifyEngineThatThisReceiverNeedsDeletedCallback;
     const NotifyEngineThatThisReceiversTimersProducedDataFunction_t m_notifyEngineThatThisReceiversTimersProducedDataFunction;
 
@@ -39,7 +39,7 @@ public:
     LTP_LIB_EXPORT LtpSessionSender(uint64_t randomInitialSenderCheckpointSerialNumber, LtpClientServiceDataToSend && dataToSend,
         std::shared_ptr<LtpTransmissionRequestUserData> && userDataPtrToTake, uint64_t lengthOfRedPart, const uint64_t MTU,
         const Ltp::session_id_t & sessionId, const uint64_t clientServiceId,
-        const boost::posix_time::time_duration & oneWayLightTime, const boost::posix_time::time_duration & oneWayMarginTime, boost::asio::io_service & ioServiceRef,
+        const boost::posix_time::time_duration & oneWayLightTime, const boost::posix_time::time_duration & oneWayMarginTime, LtpTimingWheel & timingWheelRef,
         const NotifyEngineThatThisSenderNeedsDeletedCallback_t & notifyEngineThatThisSenderNeedsDeletedCallback,
         const NotifyEngineThatThisSendersTimersProducedDataFunction_t & notifyEngineThatThisSendersTimersProducedDataFunction,
         const InitialTransmissionCompletedCallback_t & initialTransmissionCompletedCallback,
@@ -52,7 +52,7 @@ public:
         Ltp::ltp_extensions_t & headerExtensions, Ltp::ltp_extensions_t & trailerExtensions);
     
 private:
-    std::set<LtpFragmentSet::data_fragment_t> m_dataFragmentsAckedByReceiver;
+    LtpFragmentSet::data_fragment_vec_t m_dataFragmentsAckedByReceiver;
     std::list<std::vector<uint8_t> > m_nonDataToSend;
     std::list<resend_fragment_t> m_resendFragmentsList;
     std::set<uint64_t> m_reportSegmentSerialNumbersReceivedSet;
@@ -72,7 +72,6 @@ private:
     const uint64_t M_CHECKPOINT_EVERY_NTH_DATA_PACKET;
     uint64_t m_checkpointEveryNthDataPacketCounter;
     const uint32_t M_MAX_RETRIES_PER_SERIAL_NUMBER;
-    boost::asio::io_service & m_ioServiceRef;
     const NotifyEngineThatThisSenderNeedsDeletedCallback_t m_notifyEngineThatThisSenderNeedsDeletedCallback;
     const NotifyEngineThatThisSendersTimersProducedDataFunction_t m_notifyEngineThatThisSendersTimersProducedDataFunction;
     const InitialTransmissionCompletedCallback_t m_initialTransmissionCompletedCallback;
@@ -0,0 +1,88 @@
+#ifndef LTP_TIMING_WHEEL_H
+#define LTP_TIMING_WHEEL_H 1
+
+#include <cstdint>
+#include <boost/asio.hpp>
+#include <boost/shared_ptr.hpp>
+#include "ltp_lib_export.h"
+
+//Single threaded class designed to run and be called from ioService thread only.
+//
+//Hierarchical timing wheel shared by all the timers of an LtpEngine (checkpoint, report segment and cancel segment timers
+//of every session), so that one deadline_timer serves any number of sessions.
+//Time is divided into ticks of a fixed duration.  Level 0 has one slot per tick for the next 256 ticks, and each of the
+//3 higher levels has 64 slots each covering a whole turn of the level below (about 18.6 hours in total at 1 ms per tick,
+//longer timers are parked in the last level and re-inserted until due).  A slot of a higher level is redistributed
+//to the levels below when level 0 comes around to it.
+//Timers are intrusive (the caller owns the memory), so starting and cancelling are O(1) with no allocation.
+//Timers due in the same tick expire in the order they were started.
+//The deadline_timer is only armed while timers are pending, and wakes up at the next occupied level 0 slot
+//or the next redistribution, not on every tick.
+class LtpTimingWheel {
+private:
+    LtpTimingWheel();
+public:
+    class Timer {
+    public:
+        LTP_LIB_EXPORT Timer();
+        LTP_LIB_EXPORT Timer(const Timer & o); //a copy is never started
+        LTP_LIB_EXPORT virtual ~Timer(); //cancels the timer if started
+        LTP_LIB_EXPORT bool IsStarted() const;
+    protected:
+        //called from the ioService thread once the timer is no longer started, the timer may be restarted or destroyed from here
+        virtual void OnTimingWheelTimerExpired() = 0;
+    private:
+        Timer & operator=(const Timer & o); //not implemented
+        friend class LtpTimingWheel;
+        Timer * m_prev;
+        Timer * m_next;
+        LtpTimingWheel * m_timingWheelPtr;
+        uint64_t m_expiryTick;
+    };
+
+    LTP_LIB_EXPORT LtpTimingWheel(boost::asio::io_service & ioService, const boost::posix_time::time_duration & tickDuration);
+    LTP_LIB_EXPORT ~LtpTimingWheel();
+
+    //expires duration from now (rounded up to a whole tick), restarting the timer if already started
+    LTP_LIB_EXPORT void StartTimer(Timer & timer, const boost::posix_time::time_duration & duration);
+    //returns false if the timer was not started
+    LTP_LIB_EXPORT bool CancelTimer(Timer & timer);
+    LTP_LIB_EXPORT std::size_t Size() const;
+    LTP_LIB_EXPORT bool Empty() const;
+
+private:
+    static const unsigned int LEVEL0_BITS = 8;
+    static const unsigned int LEVEL_N_BITS = 6;
+    static const unsigned int NUM_LEVELS = 4;
+    static const unsigned int LEVEL0_SIZE = 1u << LEVEL0_BITS;
+    static const unsigned int LEVEL_N_SIZE = 1u << LEVEL_N_BITS;
+    static const unsigned int NUM_SLOTS = LEVEL0_SIZE + ((NUM_LEVELS - 1) * LEVEL_N_SIZE);
+    static const uint64_t MAX_TICKS_AHEAD = (static_cast<uint64_t>(1) << (LEVEL0_BITS + ((NUM_LEVELS - 1) * LEVEL_N_BITS))) - 1;
+
+    //slots are circular doubly linked lists whose head is a sentinel Timer
+    class SlotHead : public Timer {
+    protected:
+        virtual void OnTimingWheelTimerExpired();
+    };
+
+    LTP_LIB_NO_EXPORT uint64_t GetTick(const boost::posix_time::ptime & t) const;
+    LTP_LIB_NO_EXPORT void Insert(Timer & timer);
+    LTP_LIB_NO_EXPORT static void Unlink(Timer & timer);
+    LTP_LIB_NO_EXPORT static void PushBack(Timer & head, Timer & timer);
+    LTP_LIB_NO_EXPORT void Cascade(const unsigned int firstSlotIndexOfLevel, const unsigned int slotIndexWithinLevel);
+    LTP_LIB_NO_EXPORT void ProcessTick();
+    LTP_LIB_NO_EXPORT void TryArmDeadlineTimer();
+    LTP_LIB_NO_EXPORT void OnDeadlineTimerExpired(const boost::system::error_code& e, boost::shared_ptr<bool> & isWheelDeletedPtr);
+
+    boost::asio::deadline_timer m_deadlineTimer;
+    const boost::posix_time::time_duration M_TICK_DURATION;
+    const boost::posix_time::ptime M_EPOCH;
+    SlotHead m_slots[NUM_SLOTS];
+    uint64_t m_currentTick; //all slots of ticks up to and including this one have been processed
+    std::size_t m_size;
+    bool m_deadlineTimerIsArmed;
+    uint64_t m_deadlineTimerTick;
+    boost::shared_ptr<bool> m_isWheelDeletedPtr;
+};
+
+#endif // LTP_TIMING_WHEEL_H
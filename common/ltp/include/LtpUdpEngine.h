@@ -9,6 +9,10 @@
 #include <queue>
 #include "CircularIndexBufferSingleProducerSingleConsumerConfigurable.h"
 #include "LtpEngine.h"
+#ifdef __linux__
+#include <sys/socket.h> //sendmmsg
+#define LTP_UDP_ENGINE_SUPPORTS_SENDMMSG 1
+#endif
 
 class CLASS_VISIBILITY_LTP_LIB LtpUdpEngine : public LtpEngine {
 private:
@@ -21,20 +25,36 @@ public:
         const boost::posix_time::time_duration & oneWayLightTime, const boost::posix_time::time_duration & oneWayMarginTime, 
         const boost::asio::ip::udp::endpoint & remoteEndpoint, const unsigned int numUdpRxCircularBufferVectors,
         const uint64_t ESTIMATED_BYTES_TO_RECEIVE_PER_SESSION, const uint64_t maxRedRxBytesPerSession, uint32_t checkpointEveryNthDataPacketSender,
-        uint32_t maxRetriesPerSerialNumber, const bool force32BitRandomNumbers, const uint64_t maxUdpRxPacketSizeBytes, const uint64_t maxSendRateBitsPerSecOrZeroToDisable);
+        uint32_t maxRetriesPerSerialNumber, const bool force32BitRandomNumbers, const uint64_t maxUdpRxPacketSizeBytes, const uint64_t maxSendRateBitsPerSecOrZeroToDisable,
+        const unsigned int maxUdpPacketsToSendPerSystemCall, const bool useUdpGso, const unsigned int numWorkerThreads);
 
     LTP_LIB_EXPORT virtual ~LtpUdpEngine();
 
     LTP_LIB_EXPORT virtual void Reset();
     
     LTP_LIB_EXPORT void PostPacketFromManager_ThreadSafe(std::vector<uint8_t> & packetIn_thenSwappedForAnotherSameSizeVector, std::size_t size);
+    //Batched alternative used by the manager's recvmmsg receive path (manager's udp thread only): each packet of a batch is queued,
+    //then all of them are handed to the LtpEngine thread with a single post.
+    //Returns true if this is the first packet queued since the last post (the caller must then call PostQueuedPacketsFromManager_ThreadSafe).
+    LTP_LIB_EXPORT bool QueuePacketFromManager(std::vector<uint8_t> & packetIn_thenSwappedForAnotherSameSizeVector, std::size_t size);
+    LTP_LIB_EXPORT void PostQueuedPacketsFromManager_ThreadSafe();
+
+    //This engine (worker 0) plus numWorkerThreads - 1 worker engines (engine indices engineIndexForEncodingIntoRandomSessionNumber + workerIndex),
+    //each running its share of the sessions on its own thread (see LtpEngine::AddWorkerEngine).
+    //The manager must hand each received packet to the worker returned by GetWorkerEngineOwningSession.
+    LTP_LIB_EXPORT unsigned int GetNumWorkers() const;
+    LTP_LIB_EXPORT LtpUdpEngine * GetWorkerEngine(const unsigned int workerIndex);
+    LTP_LIB_EXPORT LtpUdpEngine * GetWorkerEngineOwningSession(const Ltp::session_id_t & sessionId);
 
 private:
     LTP_LIB_NO_EXPORT virtual void PacketInFullyProcessedCallback(bool success);
     LTP_LIB_NO_EXPORT virtual void SendPacket(std::vector<boost::asio::const_buffer> & constBufferVec, boost::shared_ptr<std::vector<std::vector<uint8_t> > > & underlyingDataToDeleteOnSentCallback, const uint64_t sessionOriginatorEngineId);
+    LTP_LIB_NO_EXPORT void PacketsInFromManager(const unsigned int numPackets);
     LTP_LIB_NO_EXPORT void HandleUdpSend(boost::shared_ptr<std::vector<std::vector<uint8_t> > > & underlyingDataToDeleteOnSentCallback, const boost::system::error_code& error, std::size_t bytes_transferred);
-
-    
+#ifdef LTP_UDP_ENGINE_SUPPORTS_SENDMMSG
+    LTP_LIB_NO_EXPORT virtual void SendPackets(std::vector<packet_to_send_t> & packetsToSend, const std::size_t numPacketsToSend);
+    LTP_LIB_NO_EXPORT void HandleUdpSendBatch(const std::size_t numPacketsSent);
+#endif
 
     
     
@@ -47,13 +67,44 @@ private:
     const uint64_t M_MAX_UDP_RX_PACKET_SIZE_BYTES;
     CircularIndexBufferSingleProducerSingleConsumerConfigurable m_circularIndexBuffer;
     std::vector<std::vector<boost::uint8_t> > m_udpReceiveBuffersCbVec;
+    std::vector<std::size_t> m_udpReceiveBytesTransferredCbVec; //only used by the batched path
+    unsigned int m_numPacketsQueuedFromManager;
 
     bool m_printedCbTooSmallNotice;
 
+    std::vector<std::unique_ptr<LtpUdpEngine> > m_workerEnginesVec; //workers 1 and up
+
+#ifdef LTP_UDP_ENGINE_SUPPORTS_SENDMMSG
+    //batched send path (LtpEngine thread only), see SendPackets
+    struct sendmmsg_packet_t {
+        std::size_t packetIndex; //into packetsToSend
+        std::size_t firstIovecIndex;
+        std::size_t numIovecs;
+        std::size_t sizeBytes;
+    };
+    struct sendmmsg_message_t {
+        std::size_t firstPacketIndex; //into m_sendmmsgPacketsVec
+        std::size_t numPackets; //more than one only for a UDP GSO message
+        std::size_t gsoSegmentSizeBytes; //0 if not a UDP GSO message
+    };
+    union udp_gso_control_buffer_t {
+        char buf[CMSG_SPACE(sizeof(uint16_t))];
+        struct cmsghdr align;
+    };
+    bool m_useUdpGso; //cleared if the kernel rejects a UDP GSO message
+    std::vector<sendmmsg_packet_t> m_sendmmsgPacketsVec;
+    std::vector<sendmmsg_message_t> m_sendmmsgMessagesVec;
+    std::vector<struct iovec> m_sendmmsgIovecsVec;
+    std::vector<struct mmsghdr> m_sendmmsgHeadersVec;
+    std::vector<udp_gso_control_buffer_t> m_sendmmsgControlBuffersVec;
+#endif
+
 public:
     volatile uint64_t m_countAsyncSendCalls;
     volatile uint64_t m_countAsyncSendCallbackCalls;
     uint64_t m_countCircularBufferOverruns;
+    uint64_t m_countSendmmsgCalls;
+    uint64_t m_countUdpGsoMessagesSent;
 
     //unit testing drop packet simulation stuff
     UdpDropSimulatorFunction_t m_udpDropSimulatorFunction;
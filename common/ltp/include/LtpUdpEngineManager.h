@@ -7,6 +7,10 @@
 #include <vector>
 #include <map>
 #include "LtpUdpEngine.h"
+#ifdef __linux__
+#include <sys/socket.h> //recvmmsg
+#define LTP_UDP_ENGINE_MANAGER_SUPPORTS_RECVMMSG 1
+#endif
 
 //Every "link" should have a unique engine ID, managed by using the remote eid that the link will be connecting to as the engine id for LTP
 //We track a link as a paired induct/outduct and for each link there is one engine id
@@ -29,11 +33,18 @@ public:
      */
     LTP_LIB_EXPORT bool StartIfNotAlreadyRunning();
 
+    /** Add the engine for a link.  With numWorkerThreads greater than 1, the engine runs its sessions on that many threads:
+     * sessions are partitioned by session number, received packets are routed to the worker owning their session,
+     * and the workers all take their tokens from one rate limiter of maxSendRateBitsPerSecOrZeroToDisable.
+     * Session callbacks may then be called concurrently from the worker threads.
+     * An outduct uses one engine index per worker thread.
+     */
     LTP_LIB_EXPORT bool AddLtpUdpEngine(const uint64_t thisEngineId, const uint64_t remoteEngineId, const bool isInduct, const uint64_t mtuClientServiceData, uint64_t mtuReportSegment,
         const boost::posix_time::time_duration & oneWayLightTime, const boost::posix_time::time_duration & oneWayMarginTime,
         const std::string & remoteHostname, const uint16_t remotePort, const unsigned int numUdpRxCircularBufferVectors,
         const uint64_t ESTIMATED_BYTES_TO_RECEIVE_PER_SESSION, const uint64_t maxRedRxBytesPerSession, uint32_t checkpointEveryNthDataPacketSender,
-        uint32_t maxRetriesPerSerialNumber, const bool force32BitRandomNumbers, const uint64_t maxSendRateBitsPerSecOrZeroToDisable);
+        uint32_t maxRetriesPerSerialNumber, const bool force32BitRandomNumbers, const uint64_t maxSendRateBitsPerSecOrZeroToDisable,
+        unsigned int numWorkerThreads);
 
     LTP_LIB_EXPORT LtpUdpEngine * GetLtpUdpEnginePtrByRemoteEngineId(const uint64_t remoteEngineId, const bool isInduct);
     LTP_LIB_EXPORT void RemoveLtpUdpEngineByRemoteEngineId_ThreadSafe(const uint64_t remoteEngineId, const bool isInduct, const boost::function<void()> & callback);
@@ -45,14 +56,37 @@ public:
 private:
     LTP_LIB_NO_EXPORT void StartUdpReceive();
     LTP_LIB_NO_EXPORT void HandleUdpReceive(const boost::system::error_code & error, std::size_t bytesTransferred);
+    LTP_LIB_NO_EXPORT LtpUdpEngine * GetLtpUdpEnginePtrForReceivedPacket(const std::vector<uint8_t> & packet, const std::size_t size, bool & isCriticalError);
+#ifdef LTP_UDP_ENGINE_MANAGER_SUPPORTS_RECVMMSG
+    LTP_LIB_NO_EXPORT void HandleUdpSocketReadable(const boost::system::error_code & error);
+#endif
 public:
     LTP_LIB_EXPORT static std::shared_ptr<LtpUdpEngineManager> GetOrCreateInstance(const uint16_t myBoundUdpPort, const bool autoStart);
     LTP_LIB_EXPORT static void SetMaxUdpRxPacketSizeBytesForAllLtp(const uint64_t maxUdpRxPacketSizeBytesForAllLtp);
+    /** Choose the UDP receive path of managers created from now on (default true). No effect where recvmmsg is unavailable (non-Linux).
+     *
+     * @param useRecvmmsg If true, receive up to RECVMMSG_BATCH_SIZE datagrams per system call into a ring of preallocated buffers and
+     * hand each batch to the engines with one post per engine.  If false, receive one datagram per async_receive_from.
+     */
+    LTP_LIB_EXPORT static void SetUseRecvmmsgForNewInstances(const bool useRecvmmsg);
+    static const unsigned int RECVMMSG_BATCH_SIZE = 32;
+    /** Choose the UDP send path of engines added to managers created from now on (default true, true). No effect where sendmmsg is unavailable (non-Linux).
+     *
+     * @param useSendmmsg If true, an engine dequeues up to SENDMMSG_BATCH_SIZE ready packets per send opportunity (still subject to its rate limit)
+     * and sends them with sendmmsg.  If false, each packet is sent with its own async_send_to.
+     * @param useUdpGso If true (and useSendmmsg is true), runs of equal size packets within a batch are sent as one UDP GSO (UDP_SEGMENT) message.
+     * Disabled automatically by an engine if the kernel rejects it.
+     */
+    LTP_LIB_EXPORT static void SetUseSendmmsgForNewInstances(const bool useSendmmsg, const bool useUdpGso);
+    static const unsigned int SENDMMSG_BATCH_SIZE = 64;
 private:
     //LtpUdpEngineManager(); 
     static std::map<uint16_t, std::weak_ptr<LtpUdpEngineManager> > m_staticMapBoundPortToLtpUdpEngineManagerPtr;
     static boost::mutex m_staticMutex;
     static uint64_t M_STATIC_MAX_UDP_RX_PACKET_SIZE_BYTES_FOR_ALL_LTP_UDP_ENGINES;
+    static bool m_staticUseRecvmmsgForNewInstances;
+    static bool m_staticUseSendmmsgForNewInstances;
+    static bool m_staticUseUdpGsoForNewInstances;
     
 
 
@@ -66,6 +100,16 @@ private:
     
     std::vector<boost::uint8_t> m_udpReceiveBuffer;
     boost::asio::ip::udp::endpoint m_remoteEndpointReceived;
+    const bool M_USE_RECVMMSG;
+    const bool M_USE_SENDMMSG;
+    const bool M_USE_UDP_GSO;
+#ifdef LTP_UDP_ENGINE_MANAGER_SUPPORTS_RECVMMSG
+    //ring of receive buffers (swapped with engine buffers just like m_udpReceiveBuffer) and the recvmmsg headers pointing into them
+    std::vector<std::vector<boost::uint8_t> > m_recvmmsgBuffersVec;
+    std::vector<struct iovec> m_recvmmsgIovecsVec;
+    std::vector<struct mmsghdr> m_recvmmsgHeadersVec;
+    std::vector<LtpUdpEngine*> m_enginesWithQueuedPacketsVec;
+#endif
     //std::map<std::pair<uint64_t, bool>, std::unique_ptr<LtpUdpEngine> > m_mapSessionOriginatorEngineIdPlusIsInductToLtpUdpEnginePtr;
     std::map<uint64_t, std::unique_ptr<LtpUdpEngine> > m_mapRemoteEngineIdToLtpUdpEngineReceiverPtr; //inducts (differentiate by remote engine id using this map)
     std::map<uint64_t, std::unique_ptr<LtpUdpEngine> > m_mapRemoteEngineIdToLtpUdpEngineTransmitterPtr; //outducts (differentiate by engine index encoded into the session number, cannot use this map)
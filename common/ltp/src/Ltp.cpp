@@ -305,6 +305,9 @@ Ltp::~Ltp() {
 void Ltp::SetDataSegmentContentsReadCallback(const DataSegmentContentsReadCallback_t & callback) {
     m_dataSegmentContentsReadCallback = callback;
 }
+void Ltp::SetDataSegmentContentsReadInPlaceCallback(const DataSegmentContentsReadInPlaceCallback_t & callback) {
+    m_dataSegmentContentsReadInPlaceCallback = callback;
+}
 void Ltp::SetReportSegmentContentsReadCallback(const ReportSegmentContentsReadCallback_t & callback) {
     m_reportSegmentContentsReadCallback = callback;
 }
@@ -634,6 +637,16 @@ bool Ltp::HandleReceivedChars(const uint8_t * rxVals, std::size_t numChars, std:
                     }
                 }
             }
+            else if ((dataSegmentRxState == LTP_DATA_SEGMENT_RX_STATE::READ_CLIENT_SERVICE_DATA) && m_dataSegment_clientServiceData.empty()
+                && ((numChars + 1) >= m_dataSegmentMetadata.length) && (m_numTrailerExtensionTlvs == 0) && m_dataSegmentContentsReadInPlaceCallback)
+            {
+                //rxVal is the first byte of the client service data and the rest of it is already in rxVals: hand it over without buffering it
+                const std::size_t bytesRemainingToSkip = static_cast<std::size_t>(m_dataSegmentMetadata.length - 1);
+                m_dataSegmentContentsReadInPlaceCallback(m_segmentTypeFlags, m_sessionId, rxVals - 1, m_dataSegmentMetadata, m_headerExtensions, m_trailerExtensions);
+                rxVals += bytesRemainingToSkip;
+                numChars -= bytesRemainingToSkip;
+                SetBeginningState();
+            }
             else if (dataSegmentRxState == LTP_DATA_SEGMENT_RX_STATE::READ_CLIENT_SERVICE_DATA) {
                 m_dataSegment_clientServiceData.push_back(rxVal);
                 if (m_dataSegment_clientServiceData.size() == m_dataSegmentMetadata.length) {
@@ -1128,6 +1141,220 @@ const uint8_t * Ltp::TryShortcutReadDataSegmentSdnvs(const uint8_t * rxVals, std
     }
 }
 
+//Decodes numValues consecutive sdnvs that must all lie within the size bytes at data.
+//Returns the number of bytes they occupy, or 0 if any of them is invalid or does not fit.
+static std::size_t DecodeConsecutiveSdnvs(const uint8_t * data, std::size_t size, uint64_t * decodedValues, unsigned int numValues) {
+    const uint8_t * const dataStart = data;
+#ifdef USE_SDNV_FAST
+    while (numValues && (size >= SDNV_DECODE_MINIMUM_SAFE_BUFFER_SIZE)) { //the simd decoder reads 16 bytes
+        uint8_t numBytes;
+        const unsigned int numDecoded = SdnvDecodeMultipleU64Fast(data, &numBytes, decodedValues, numValues);
+        if (numDecoded == 0) { //invalid sdnv, let the classic decode below reject it
+            break;
+        }
+        data += numBytes;
+        size -= numBytes;
+        decodedValues += numDecoded;
+        numValues -= numDecoded;
+    }
+#endif
+    while (numValues) {
+        uint8_t numBytes;
+        *decodedValues++ = SdnvDecodeU64(data, &numBytes, size);
+        if (numBytes == 0) {
+            return 0;
+        }
+        data += numBytes;
+        size -= numBytes;
+        --numValues;
+    }
+    return static_cast<std::size_t>(data - dataStart);
+}
+
+//returns the position following the extensions, or NULL if they are malformed or do not fit
+static const uint8_t * DecodeExtensions(const uint8_t * ptr, const uint8_t * const end, Ltp::ltp_extensions_t & extensions, const uint8_t numExtensions) {
+    extensions.extensionsVec.resize(numExtensions);
+    for (uint8_t i = 0; i < numExtensions; ++i) {
+        Ltp::ltp_extension_t & extension = extensions.extensionsVec[i];
+        if (ptr == end) {
+            return NULL;
+        }
+        extension.tag = *ptr++;
+        uint64_t length;
+        const std::size_t sdnvSize = DecodeConsecutiveSdnvs(ptr, end - ptr, &length, 1);
+        if (sdnvSize == 0) {
+            return NULL;
+        }
+        ptr += sdnvSize;
+        if (length > static_cast<uint64_t>(end - ptr)) {
+            return NULL;
+        }
+        extension.valueVec.assign(ptr, ptr + length);
+        ptr += length;
+    }
+    return ptr;
+}
+
+bool Ltp::HandleReceivedDatagram(const uint8_t * datagram, std::size_t size, std::string & errorMessage, SessionOriginatorEngineIdDecodedCallback_t * sessionOriginatorEngineIdDecodedCallbackPtr) {
+    if (!IsAtBeginningState()) { //continuing a segment streamed in by earlier calls
+        return HandleReceivedChars(datagram, size, errorMessage, sessionOriginatorEngineIdDecodedCallbackPtr);
+    }
+    while (size) {
+        const std::size_t segmentSize = TryDecodeWholeSegment(datagram, size, sessionOriginatorEngineIdDecodedCallbackPtr);
+        if (segmentSize == 0) { //malformed (the state machine reports why) or incomplete (the state machine keeps it until the rest arrives)
+            return HandleReceivedChars(datagram, size, errorMessage, sessionOriginatorEngineIdDecodedCallbackPtr);
+        }
+        datagram += segmentSize;
+        size -= segmentSize;
+    }
+    return true;
+}
+
+//Decodes the segment at the start of data if the whole segment is there and makes its callbacks.
+//Returns the size of the segment, or 0 (before any callback is made) if data does not start with a complete well formed segment.
+std::size_t Ltp::TryDecodeWholeSegment(const uint8_t * data, const std::size_t size, SessionOriginatorEngineIdDecodedCallback_t * sessionOriginatorEngineIdDecodedCallbackPtr) {
+    const uint8_t * ptr = data;
+    const uint8_t * const end = data + size;
+    const uint8_t controlByte = *ptr++;
+    if ((controlByte >> 4) != 0) { //ltp version not 0
+        return 0;
+    }
+    m_segmentTypeFlags = controlByte & 0x0f;
+    if ((m_segmentTypeFlags == 5) || (m_segmentTypeFlags == 6) || (m_segmentTypeFlags == 10) || (m_segmentTypeFlags == 11)) { // undefined
+        return 0;
+    }
+    uint64_t sdnvs[5];
+    std::size_t sdnvsSize = DecodeConsecutiveSdnvs(ptr, end - ptr, sdnvs, 2);
+    if ((sdnvsSize == 0) || (sdnvsSize == static_cast<std::size_t>(end - ptr))) { //no room for the extension counts byte
+        return 0;
+    }
+    ptr += sdnvsSize;
+    m_sessionId.sessionOriginatorEngineId = sdnvs[0];
+    m_sessionId.sessionNumber = sdnvs[1];
+    const uint8_t extensionCounts = *ptr++;
+    m_numHeaderExtensionTlvs = extensionCounts >> 4;
+    m_numTrailerExtensionTlvs = extensionCounts & 0x0f;
+    ptr = DecodeExtensions(ptr, end, m_headerExtensions, m_numHeaderExtensionTlvs);
+    if (ptr == NULL) {
+        return 0;
+    }
+
+    const uint8_t * clientServiceData = NULL;
+    if (m_segmentTypeFlags <= 7) { //data segment
+        const bool isCheckpoint = ((m_segmentTypeFlags >= 1) && (m_segmentTypeFlags <= 3));
+        sdnvsSize = DecodeConsecutiveSdnvs(ptr, end - ptr, sdnvs, (isCheckpoint) ? 5 : 3);
+        if (sdnvsSize == 0) {
+            return 0;
+        }
+        ptr += sdnvsSize;
+        m_dataSegmentMetadata.clientServiceId = sdnvs[0];
+        m_dataSegmentMetadata.offset = sdnvs[1];
+        m_dataSegmentMetadata.length = sdnvs[2];
+        if (isCheckpoint) {
+            m_dataSegment_checkpointSerialNumber = sdnvs[3];
+            m_dataSegment_reportSerialNumber = sdnvs[4];
+            m_dataSegmentMetadata.checkpointSerialNumber = &m_dataSegment_checkpointSerialNumber;
+            m_dataSegmentMetadata.reportSerialNumber = &m_dataSegment_reportSerialNumber;
+        }
+        else {
+            m_dataSegmentMetadata.checkpointSerialNumber = NULL;
+            m_dataSegmentMetadata.reportSerialNumber = NULL;
+        }
+        if ((m_dataSegmentMetadata.length == 0) || (m_dataSegmentMetadata.length > static_cast<uint64_t>(end - ptr))) {
+            return 0;
+        }
+        clientServiceData = ptr;
+        ptr += m_dataSegmentMetadata.length;
+    }
+    else if (m_segmentTypeFlags == 8) { //report segment
+        sdnvsSize = DecodeConsecutiveSdnvs(ptr, end - ptr, sdnvs, 5);
+        if (sdnvsSize == 0) {
+            return 0;
+        }
+        ptr += sdnvsSize;
+        m_reportSegment.reportSerialNumber = sdnvs[0];
+        m_reportSegment.checkpointSerialNumber = sdnvs[1];
+        m_reportSegment.upperBound = sdnvs[2];
+        m_reportSegment.lowerBound = sdnvs[3];
+        m_reportSegment_receptionClaimCount = sdnvs[4];
+        //must be 1 or more (The content of an RS comprises one or more data reception claims), and each claim takes at least 2 bytes
+        if ((m_reportSegment_receptionClaimCount == 0) || (m_reportSegment_receptionClaimCount > (static_cast<uint64_t>(end - ptr) / 2))) {
+            return 0;
+        }
+        m_reportSegment.receptionClaims.resize(m_reportSegment_receptionClaimCount);
+        uint64_t claimSdnvs[16]; //decoded 8 claims at a time
+        for (std::size_t claimIndex = 0; claimIndex < m_reportSegment.receptionClaims.size(); ) {
+            const unsigned int numClaims = static_cast<unsigned int>(std::min<std::size_t>(8, m_reportSegment.receptionClaims.size() - claimIndex));
+            sdnvsSize = DecodeConsecutiveSdnvs(ptr, end - ptr, claimSdnvs, numClaims * 2);
+            if (sdnvsSize == 0) {
+                return 0;
+            }
+            ptr += sdnvsSize;
+            for (unsigned int i = 0; i < numClaims; ++i, ++claimIndex) {
+                reception_claim_t & claim = m_reportSegment.receptionClaims[claimIndex];
+                claim.offset = claimSdnvs[i * 2];
+                claim.length = claimSdnvs[(i * 2) + 1];
+                if (claim.length == 0) { //must be 1 or more (A reception claim's length shall never be less than 1)
+                    return 0;
+                }
+            }
+        }
+    }
+    else if (m_segmentTypeFlags == 9) { //report acknowledgement segment
+        sdnvsSize = DecodeConsecutiveSdnvs(ptr, end - ptr, &m_reportAcknowledgementSegment_reportSerialNumber, 1);
+        if (sdnvsSize == 0) {
+            return 0;
+        }
+        ptr += sdnvsSize;
+    }
+    else if ((m_segmentTypeFlags & 0xd) != 0xd) { //12 or 14 => cancel segment (CAx (cancel ack) has no contents)
+        if (ptr == end) {
+            return 0;
+        }
+        m_cancelSegment_reasonCode = *ptr++;
+    }
+
+    ptr = DecodeExtensions(ptr, end, m_trailerExtensions, m_numTrailerExtensionTlvs);
+    if (ptr == NULL) {
+        return 0;
+    }
+
+    //the whole segment is good
+    if (sessionOriginatorEngineIdDecodedCallbackPtr) {
+        (*sessionOriginatorEngineIdDecodedCallbackPtr)(m_sessionId.sessionOriginatorEngineId);
+    }
+    if (m_segmentTypeFlags <= 7) {
+        if (m_dataSegmentContentsReadInPlaceCallback) {
+            m_dataSegmentContentsReadInPlaceCallback(m_segmentTypeFlags, m_sessionId, clientServiceData, m_dataSegmentMetadata, m_headerExtensions, m_trailerExtensions);
+        }
+        else if (m_dataSegmentContentsReadCallback) {
+            m_dataSegment_clientServiceData.assign(clientServiceData, clientServiceData + m_dataSegmentMetadata.length);
+            m_dataSegmentContentsReadCallback(m_segmentTypeFlags, m_sessionId, m_dataSegment_clientServiceData, m_dataSegmentMetadata, m_headerExtensions, m_trailerExtensions);
+        }
+    }
+    else if (m_segmentTypeFlags == 8) {
+        if (m_reportSegmentContentsReadCallback) {
+            m_reportSegmentContentsReadCallback(m_sessionId, m_reportSegment, m_headerExtensions, m_trailerExtensions);
+        }
+    }
+    else if (m_segmentTypeFlags == 9) {
+        if (m_reportAcknowledgementSegmentContentsReadCallback) {
+            m_reportAcknowledgementSegmentContentsReadCallback(m_sessionId, m_reportAcknowledgementSegment_reportSerialNumber, m_headerExtensions, m_trailerExtensions);
+        }
+    }
+    else if ((m_segmentTypeFlags & 0xd) == 0xd) {
+        if (m_cancelAcknowledgementSegmentContentsReadCallback) {
+            m_cancelAcknowledgementSegmentContentsReadCallback(m_sessionId, (m_segmentTypeFlags == (static_cast<uint8_t>(LTP_SEGMENT_TYPE_FLAGS::CANCEL_ACK_SEGMENT_TO_BLOCK_SENDER))), m_headerExtensions, m_trailerExtensions);
+        }
+    }
+    else {
+        if (m_cancelSegmentContentsReadCallback) {
+            m_cancelSegmentContentsReadCallback(m_sessionId, (static_cast<CANCEL_SEGMENT_REASON_CODES>(m_cancelSegment_reasonCode)), (m_segmentTypeFlags == (static_cast<uint8_t>(LTP_SEGMENT_TYPE_FLAGS::CANCEL_SEGMENT_FROM_BLOCK_SENDER))), m_headerExtensions, m_trailerExtensions);
+        }
+    }
+    return static_cast<std::size_t>(ptr - data);
+}
+
 //Preconditions before call:
 //m_sdnvTempVec.clear();
 //m_reportSegmentRxState = LTP_REPORT_SEGMENT_RX_STATE::READ_REPORT_SERIAL_NUMBER_SDNV;
@@ -9,7 +9,8 @@ LtpBundleSource::LtpBundleSource(const uint64_t clientServiceId, const uint64_t
     const boost::posix_time::time_duration & oneWayLightTime, const boost::posix_time::time_duration & oneWayMarginTime,
     const uint16_t myBoundUdpPort, const unsigned int numUdpRxCircularBufferVectors,
     uint32_t checkpointEveryNthDataPacketSender, uint32_t ltpMaxRetriesPerSerialNumber, const bool force32BitRandomNumbers,
-    const std::string & remoteUdpHostname, const uint16_t remoteUdpPort, const uint64_t maxSendRateBitsPerSecOrZeroToDisable) :
+    const std::string & remoteUdpHostname, const uint16_t remoteUdpPort, const uint64_t maxSendRateBitsPerSecOrZeroToDisable,
+    const unsigned int numWorkerThreads) :
 
 m_useLocalConditionVariableAckReceived(false), //for destructor only
 
@@ -26,7 +27,7 @@ m_totalBundleBytesSent(0)
     m_ltpUdpEnginePtr = m_ltpUdpEngineManagerPtr->GetLtpUdpEnginePtrByRemoteEngineId(remoteLtpEngineId, false);
     if (m_ltpUdpEnginePtr == NULL) {
         m_ltpUdpEngineManagerPtr->AddLtpUdpEngine(thisEngineId, remoteLtpEngineId, false, mtuClientServiceData, 80, oneWayLightTime, oneWayMarginTime,
-            remoteUdpHostname, remoteUdpPort, numUdpRxCircularBufferVectors, 0, 0, 0, ltpMaxRetriesPerSerialNumber, force32BitRandomNumbers, maxSendRateBitsPerSecOrZeroToDisable);
+            remoteUdpHostname, remoteUdpPort, numUdpRxCircularBufferVectors, 0, 0, 0, ltpMaxRetriesPerSerialNumber, force32BitRandomNumbers, maxSendRateBitsPerSecOrZeroToDisable, numWorkerThreads);
         m_ltpUdpEnginePtr = m_ltpUdpEngineManagerPtr->GetLtpUdpEnginePtrByRemoteEngineId(remoteLtpEngineId, false);
     }
 
@@ -113,9 +114,12 @@ std::size_t LtpBundleSource::GetTotalBundleBytesSent() {
 
 bool LtpBundleSource::Forward(std::vector<uint8_t> & dataVec) {
     
-    if (m_activeSessionsSet.size() > 100) {
-        std::cerr << "Error in LtpBundleSource::Forward.. too many unacked sessions" << std::endl;
-        return false;
+    {
+        boost::mutex::scoped_lock lock(m_activeSessionsSetMutex);
+        if (m_activeSessionsSet.size() > 100) {
+            std::cerr << "Error in LtpBundleSource::Forward.. too many unacked sessions" << std::endl;
+            return false;
+        }
     }
 
     boost::shared_ptr<LtpEngine::transmission_request_t> tReq = boost::make_shared<LtpEngine::transmission_request_t>();
@@ -136,9 +140,12 @@ bool LtpBundleSource::Forward(std::vector<uint8_t> & dataVec) {
 bool LtpBundleSource::Forward(zmq::message_t & dataZmq) {
 
 
-    if (m_activeSessionsSet.size() > 100) {
-        std::cerr << "Error in LtpBundleSource::Forward.. too many unacked sessions" << std::endl;
-        return false;
+    {
+        boost::mutex::scoped_lock lock(m_activeSessionsSetMutex);
+        if (m_activeSessionsSet.size() > 100) {
+            std::cerr << "Error in LtpBundleSource::Forward.. too many unacked sessions" << std::endl;
+            return false;
+        }
     }
 
     boost::shared_ptr<LtpEngine::transmission_request_t> tReq = boost::make_shared<LtpEngine::transmission_request_t>();
@@ -164,11 +171,13 @@ bool LtpBundleSource::Forward(const uint8_t* bundleData, const std::size_t size)
 
 
 void LtpBundleSource::SessionStartCallback(const Ltp::session_id_t & sessionId) {
+    boost::mutex::scoped_lock lock(m_activeSessionsSetMutex);
     if (m_activeSessionsSet.insert(sessionId).second == false) { //sessionId was not inserted (already exists)
         std::cerr << "error in LtpBundleSource::SessionStartCallback, sessionId " << sessionId << " (already exists)\n";
     }
 }
 void LtpBundleSource::TransmissionSessionCompletedCallback(const Ltp::session_id_t & sessionId) {
+    boost::mutex::scoped_lock lock(m_activeSessionsSetMutex);
     std::set<Ltp::session_id_t>::iterator it = m_activeSessionsSet.find(sessionId);
     if (it != m_activeSessionsSet.end()) { //found
         m_activeSessionsSet.erase(it);
@@ -191,6 +200,7 @@ void LtpBundleSource::InitialTransmissionCompletedCallback(const Ltp::session_id
 
 }
 void LtpBundleSource::TransmissionSessionCancelledCallback(const Ltp::session_id_t & sessionId, CANCEL_SEGMENT_REASON_CODES reasonCode) {
+    boost::mutex::scoped_lock lock(m_activeSessionsSetMutex);
     std::set<Ltp::session_id_t>::iterator it = m_activeSessionsSet.find(sessionId);
     if (it != m_activeSessionsSet.end()) { //found
         m_activeSessionsSet.erase(it);
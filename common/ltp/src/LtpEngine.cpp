@@ -20,14 +20,20 @@ LtpEngine::LtpEngine(const uint64_t thisEngineId, const uint8_t engineIndexForEn
     M_ONE_WAY_MARGIN_TIME(oneWayMarginTime),
     M_TRANSMISSION_TO_ACK_RECEIVED_TIME((oneWayLightTime * 2) + (oneWayMarginTime * 2)),
     M_FORCE_32_BIT_RANDOM_NUMBERS(force32BitRandomNumbers),
+    m_timingWheel(m_ioServiceLtpEngine, boost::posix_time::milliseconds(1)),
     m_checkpointEveryNthDataPacketSender(checkpointEveryNthDataPacketSender),
     m_maxRetriesPerSerialNumber(maxRetriesPerSerialNumber),
     m_workLtpEnginePtr(boost::make_unique< boost::asio::io_service::work>(m_ioServiceLtpEngine)),
-    m_timeManagerOfCancelSegments(m_ioServiceLtpEngine, oneWayLightTime, oneWayMarginTime, boost::bind(&LtpEngine::CancelSegmentTimerExpiredCallback, this, boost::placeholders::_1, boost::placeholders::_2)),
+    m_timeManagerOfCancelSegments(m_timingWheel, oneWayLightTime, oneWayMarginTime, boost::bind(&LtpEngine::CancelSegmentTimerExpiredCallback, this, boost::placeholders::_1, boost::placeholders::_2)),
+    m_tokenRateLimiterOwnerPtr(this),
     m_tokenRefreshTimer(m_ioServiceLtpEngine),
     m_maxSendRateBitsPerSecOrZeroToDisable(maxSendRateBitsPerSecOrZeroToDisable),
     m_tokenRefreshTimerIsRunning(false),
-    m_lastTimeTokensWereRefreshed(boost::posix_time::special_values::neg_infin)
+    m_lastTimeTokensWereRefreshed(boost::posix_time::special_values::neg_infin),
+    m_maxPacketsToSendPerBatch(1),
+    m_nextEngineForTransmissionRequest(0),
+    m_numActiveSendersAtomic(0),
+    m_numActiveReceiversAtomic(0)
 {
     m_ltpRxStateMachine.SetCancelSegmentContentsReadCallback(boost::bind(&LtpEngine::CancelSegmentReceivedCallback, this,
         boost::placeholders::_1, boost::placeholders::_2, boost::placeholders::_3,
@@ -44,6 +50,9 @@ LtpEngine::LtpEngine(const uint64_t thisEngineId, const uint8_t engineIndexForEn
     m_ltpRxStateMachine.SetDataSegmentContentsReadCallback(boost::bind(&LtpEngine::DataSegmentReceivedCallback, this,
         boost::placeholders::_1, boost::placeholders::_2, boost::placeholders::_3,
         boost::placeholders::_4, boost::placeholders::_5, boost::placeholders::_6));
+    m_ltpRxStateMachine.SetDataSegmentContentsReadInPlaceCallback(boost::bind(&LtpEngine::DataSegmentReceivedInPlaceCallback, this,
+        boost::placeholders::_1, boost::placeholders::_2, boost::placeholders::_3,
+        boost::placeholders::_4, boost::placeholders::_5, boost::placeholders::_6));
 
     m_rng.SetEngineIndex(engineIndexForEncodingIntoRandomSessionNumber);
     SetMtuReportSegment(mtuReportSegment);
@@ -82,6 +91,7 @@ LtpEngine::~LtpEngine() {
 void LtpEngine::Reset() {
     m_mapSessionNumberToSessionSender.clear();
     m_mapSessionIdToSessionReceiver.clear();
+    UpdateNumActiveSessions();
     m_ltpRxStateMachine.InitRx();
     m_sendersIterator = m_mapSessionNumberToSessionSender.begin();
     m_receiversIterator = m_mapSessionIdToSessionReceiver.begin();
@@ -102,6 +112,20 @@ void LtpEngine::Reset() {
 
 void LtpEngine::SetCheckpointEveryNthDataPacketForSenders(uint64_t checkpointEveryNthDataPacketSender) {
     m_checkpointEveryNthDataPacketSender = checkpointEveryNthDataPacketSender;
+    for (std::size_t i = 0; i < m_workerEnginesPtrVec.size(); ++i) {
+        m_workerEnginesPtrVec[i]->SetCheckpointEveryNthDataPacketForSenders(checkpointEveryNthDataPacketSender);
+    }
+}
+
+void LtpEngine::SetMaxPacketsToSendPerBatch(unsigned int maxPacketsToSendPerBatch) {
+    if (maxPacketsToSendPerBatch == 0) {
+        maxPacketsToSendPerBatch = 1;
+    }
+    m_maxPacketsToSendPerBatch = maxPacketsToSendPerBatch;
+    m_packetsToSendBatchVec.resize((maxPacketsToSendPerBatch > 1) ? maxPacketsToSendPerBatch : 0);
+    for (std::size_t i = 0; i < m_workerEnginesPtrVec.size(); ++i) {
+        m_workerEnginesPtrVec[i]->SetMaxPacketsToSendPerBatch(maxPacketsToSendPerBatch);
+    }
 }
 
 void LtpEngine::SetMtuReportSegment(uint64_t mtuReportSegment) {
@@ -113,11 +137,31 @@ void LtpEngine::SetMtuReportSegment(uint64_t mtuReportSegment) {
     }
     m_maxReceptionClaims = (mtuReportSegment - 50) / 20;
     std::cout << "max reception claims = " << m_maxReceptionClaims << std::endl;
+    for (std::size_t i = 0; i < m_workerEnginesPtrVec.size(); ++i) {
+        m_workerEnginesPtrVec[i]->SetMtuReportSegment(mtuReportSegment);
+    }
+}
+
+void LtpEngine::AddWorkerEngine(LtpEngine * workerEnginePtr) {
+    m_workerEnginesPtrVec.push_back(workerEnginePtr);
+    workerEnginePtr->m_tokenRateLimiterOwnerPtr = this;
+}
+
+std::size_t LtpEngine::GetOwningWorkerIndex(const Ltp::session_id_t & sessionId) const {
+    const std::size_t numEngines = m_workerEnginesPtrVec.size() + 1;
+    if (numEngines == 1) {
+        return 0;
+    }
+    if (sessionId.sessionOriginatorEngineId == M_THIS_ENGINE_ID) { //transmission session
+        const uint8_t workerIndex = LtpRandomNumberGenerator::GetEngineIndexFromRandomSessionNumber(sessionId.sessionNumber) - m_rng.GetEngineIndex();
+        return (workerIndex < numEngines) ? workerIndex : 0;
+    }
+    return static_cast<std::size_t>(sessionId.sessionNumber % numEngines); //reception session
 }
 
 bool LtpEngine::PacketIn(const uint8_t * data, const std::size_t size, Ltp::SessionOriginatorEngineIdDecodedCallback_t * sessionOriginatorEngineIdDecodedCallbackPtr) {
     std::string errorMessage;
-    const bool success = m_ltpRxStateMachine.HandleReceivedChars(data, size, errorMessage, sessionOriginatorEngineIdDecodedCallbackPtr);
+    const bool success = m_ltpRxStateMachine.HandleReceivedDatagram(data, size, errorMessage, sessionOriginatorEngineIdDecodedCallbackPtr);
     if (!success) {
         std::cerr << "error in LtpEngine::PacketIn: " << errorMessage << std::endl;
         m_ltpRxStateMachine.InitRx();
@@ -147,11 +191,19 @@ void LtpEngine::SignalReadyForSend_ThreadSafe() { //called by HandleUdpSend
     boost::asio::post(m_ioServiceLtpEngine, boost::bind(&LtpEngine::TrySendPacketIfAvailable, this));
 }
 
+void LtpEngine::PostToLtpEngine_ThreadSafe(const boost::function<void()> & handler) {
+    boost::asio::post(m_ioServiceLtpEngine, handler);
+}
+
 void LtpEngine::TrySendPacketIfAvailable() {
     if (m_ioServiceLtpEngineThreadPtr) { //if not running inside a unit test
+        if (m_maxPacketsToSendPerBatch > 1) {
+            TrySendPacketBatchIfAvailable();
+            return;
+        }
         //RATE STUFF (the TrySendPacketIfAvailable and OnTokenRefresh_TimerExpired run in the same thread)
         if (m_maxSendRateBitsPerSecOrZeroToDisable) { //if rate limiting enabled
-            if (!m_tokenRateLimiter.CanTakeTokens()) { //no tokens available for next send, TrySendPacketIfAvailable() will be called at the next m_tokenRefreshTimer expiration
+            if (!CanTakeSharedTokens()) { //no tokens available for next send, TrySendPacketIfAvailable() will be called at the next m_tokenRefreshTimer expiration
                 TryRestartTokenRefreshTimer(); //make sure this is running so that tokens can be replenished
                 return;
             }
@@ -165,7 +217,7 @@ void LtpEngine::TrySendPacketIfAvailable() {
                 for (std::size_t i = 0; i < constBufferVec.size(); ++i) {
                     bytesToSend += constBufferVec[i].size();
                 }
-                m_tokenRateLimiter.TakeTokens(bytesToSend);
+                TakeSharedTokens(bytesToSend);
                 TryRestartTokenRefreshTimer(); //tokens were taken, so make sure this is running so that tokens can be replenished
             }
             SendPacket(constBufferVec, underlyingDataToDeleteOnSentCallback, sessionOriginatorEngineId); //virtual call to child implementation
@@ -173,6 +225,54 @@ void LtpEngine::TrySendPacketIfAvailable() {
     }
 }
 
+void LtpEngine::TrySendPacketBatchIfAvailable() {
+    std::size_t numPacketsToSend = 0;
+    while (numPacketsToSend < m_maxPacketsToSendPerBatch) {
+        if (m_maxSendRateBitsPerSecOrZeroToDisable) { //if rate limiting enabled
+            if (!CanTakeSharedTokens()) { //no tokens available for next send, TrySendPacketIfAvailable() will be called at the next m_tokenRefreshTimer expiration
+                TryRestartTokenRefreshTimer(); //make sure this is running so that tokens can be replenished
+                break;
+            }
+        }
+        if (numPacketsToSend && (!m_listSendersNeedingDeleted.empty() || !m_listReceiversNeedingDeleted.empty())) {
+            //NextPacketToSendRoundRobin may delete a finished session whose data the packets already in this batch still point to,
+            //so send the batch first
+            break;
+        }
+        packet_to_send_t & packet = m_packetsToSendBatchVec[numPacketsToSend];
+        if (!NextPacketToSendRoundRobin(packet.constBufferVec, packet.underlyingDataToDeleteOnSentCallback, packet.sessionOriginatorEngineId)) {
+            break;
+        }
+        if (m_maxSendRateBitsPerSecOrZeroToDisable) { //if rate limiting enabled
+            std::size_t bytesToSend = 0;
+            for (std::size_t i = 0; i < packet.constBufferVec.size(); ++i) {
+                bytesToSend += packet.constBufferVec[i].size();
+            }
+            TakeSharedTokens(bytesToSend);
+            TryRestartTokenRefreshTimer(); //tokens were taken, so make sure this is running so that tokens can be replenished
+        }
+        ++numPacketsToSend;
+    }
+    if (numPacketsToSend == 1) {
+        packet_to_send_t & packet = m_packetsToSendBatchVec[0];
+        SendPacket(packet.constBufferVec, packet.underlyingDataToDeleteOnSentCallback, packet.sessionOriginatorEngineId); //virtual call to child implementation
+        packet.underlyingDataToDeleteOnSentCallback.reset();
+    }
+    else if (numPacketsToSend) {
+        SendPackets(m_packetsToSendBatchVec, numPacketsToSend); //virtual call to child implementation
+        for (std::size_t i = 0; i < numPacketsToSend; ++i) {
+            m_packetsToSendBatchVec[i].underlyingDataToDeleteOnSentCallback.reset();
+        }
+    }
+}
+
+void LtpEngine::SendPackets(std::vector<packet_to_send_t> & packetsToSend, const std::size_t numPacketsToSend) {
+    for (std::size_t i = 0; i < numPacketsToSend; ++i) {
+        packet_to_send_t & packet = packetsToSend[i];
+        SendPacket(packet.constBufferVec, packet.underlyingDataToDeleteOnSentCallback, packet.sessionOriginatorEngineId);
+    }
+}
+
 void LtpEngine::PacketInFullyProcessedCallback(bool success) {}
 
 void LtpEngine::SendPacket(std::vector<boost::asio::const_buffer> & constBufferVec, boost::shared_ptr<std::vector<std::vector<uint8_t> > > & underlyingDataToDeleteOnSentCallback, const uint64_t sessionOriginatorEngineId) {}
@@ -194,6 +294,7 @@ bool LtpEngine::NextPacketToSendRoundRobin(std::vector<boost::asio::const_buffer
                 else {
                     m_mapSessionNumberToSessionSender.erase(txSessionIt);
                 }
+                UpdateNumActiveSessions();
                 ////std::cout << "deleted session sender " << m_listSendersNeedingDeleted.front() << std::endl;
             }
         }
@@ -222,6 +323,7 @@ bool LtpEngine::NextPacketToSendRoundRobin(std::vector<boost::asio::const_buffer
                 else {
                     m_mapSessionIdToSessionReceiver.erase(rxSessionIt);
                 }
+                UpdateNumActiveSessions();
                 ////std::cout << "deleted session receiver sessionNumber " << m_listReceiversNeedingDeleted.front().sessionNumber << std::endl;
             }
         }
@@ -328,10 +430,11 @@ void LtpEngine::TransmissionRequest(uint64_t destinationClientServiceId, uint64_
     m_mapSessionNumberToSessionSender[randomSessionNumberGeneratedBySender] = boost::make_unique<LtpSessionSender>(
         randomInitialSenderCheckpointSerialNumber, std::move(clientServiceDataToSend), std::move(userDataPtrToTake),
         lengthOfRedPart, M_MTU_CLIENT_SERVICE_DATA, senderSessionId, destinationClientServiceId,
-        M_ONE_WAY_LIGHT_TIME, M_ONE_WAY_MARGIN_TIME, m_ioServiceLtpEngine,
+        M_ONE_WAY_LIGHT_TIME, M_ONE_WAY_MARGIN_TIME, m_timingWheel,
         boost::bind(&LtpEngine::NotifyEngineThatThisSenderNeedsDeletedCallback, this, boost::placeholders::_1, boost::placeholders::_2, boost::placeholders::_3, boost::placeholders::_4),
         boost::bind(&LtpEngine::TrySendPacketIfAvailable, this),
         boost::bind(&LtpEngine::InitialTransmissionCompletedCallback, this, boost::placeholders::_1, boost::placeholders::_2), m_checkpointEveryNthDataPacketSender, m_maxRetriesPerSerialNumber);
+    UpdateNumActiveSessions();
 
     if (m_sessionStartCallback) {
         //At the sender, the session start notice informs the client service of the initiation of the transmission session.
@@ -363,11 +466,23 @@ void LtpEngine::TransmissionRequest(boost::shared_ptr<transmission_request_t> &
     TrySendPacketIfAvailable();
 }
 void LtpEngine::TransmissionRequest_ThreadSafe(boost::shared_ptr<transmission_request_t> && transmissionRequest) {
+    if (!m_workerEnginesPtrVec.empty()) { //the new session goes to the next of this engine and its workers in turn
+        const std::size_t engineIndex = m_nextEngineForTransmissionRequest.fetch_add(1, boost::memory_order_relaxed) % (m_workerEnginesPtrVec.size() + 1);
+        if (engineIndex) {
+            m_workerEnginesPtrVec[engineIndex - 1]->TransmissionRequest_ThreadSafe(std::move(transmissionRequest));
+            return;
+        }
+    }
     //The arguments to bind are copied or moved, and are never passed by reference unless wrapped in std::ref or std::cref.
     boost::asio::post(m_ioServiceLtpEngine, boost::bind(&LtpEngine::TransmissionRequest, this, std::move(transmissionRequest)));
 }
 
 void LtpEngine::CancellationRequest_ThreadSafe(const Ltp::session_id_t & sessionId) {
+    const std::size_t workerIndex = GetOwningWorkerIndex(sessionId);
+    if (workerIndex) {
+        m_workerEnginesPtrVec[workerIndex - 1]->CancellationRequest_ThreadSafe(sessionId);
+        return;
+    }
     //The arguments to bind are copied or moved, and are never passed by reference unless wrapped in std::ref or std::cref.
     boost::asio::post(m_ioServiceLtpEngine, boost::bind(&LtpEngine::CancellationRequest, this, sessionId));
 }
@@ -421,6 +536,7 @@ bool LtpEngine::CancellationRequest(const Ltp::session_id_t & sessionId) { //onl
             else {
                 m_mapSessionNumberToSessionSender.erase(txSessionIt);
             }
+            UpdateNumActiveSessions();
             std::cout << "LtpEngine::CancellationRequest deleted session sender session number " << sessionId.sessionNumber << std::endl;
 
             //send Cancel Segment to receiver (NextPacketToSendRoundRobin() will create the packet and start the timer)
@@ -460,6 +576,7 @@ bool LtpEngine::CancellationRequest(const Ltp::session_id_t & sessionId) { //onl
             else {
                 m_mapSessionIdToSessionReceiver.erase(rxSessionIt);
             }
+            UpdateNumActiveSessions();
             std::cout << "LtpEngine::CancellationRequest deleted session receiver session number " << sessionId.sessionNumber << std::endl;
 
             //send Cancel Segment to sender (NextPacketToSendRoundRobin() will create the packet and start the timer)
@@ -500,6 +617,7 @@ void LtpEngine::CancelSegmentReceivedCallback(const Ltp::session_id_t & sessionI
             else {
                 m_mapSessionIdToSessionReceiver.erase(rxSessionIt);
             }
+            UpdateNumActiveSessions();
             std::cout << "LtpEngine::CancelSegmentReceivedCallback deleted session receiver session number " << sessionId.sessionNumber << std::endl;
             //Send CAx after outer if-else statement
             
@@ -528,6 +646,7 @@ void LtpEngine::CancelSegmentReceivedCallback(const Ltp::session_id_t & sessionI
             else {
                 m_mapSessionNumberToSessionSender.erase(txSessionIt);
             }
+            UpdateNumActiveSessions();
             std::cout << "LtpEngine::CancelSegmentReceivedCallback deleted session sender session number " << sessionId.sessionNumber << std::endl;
             //Send CAx after outer if-else statement
         }
@@ -695,13 +814,10 @@ void LtpEngine::ReportSegmentReceivedCallback(const Ltp::session_id_t & sessionI
 //new reception session, and is delivered upon arrival of the first
 //data segment carrying a new session ID.
 
-void LtpEngine::DataSegmentReceivedCallback(uint8_t segmentTypeFlags, const Ltp::session_id_t & sessionId,
-    std::vector<uint8_t> & clientServiceDataVec, const Ltp::data_segment_metadata_t & dataSegmentMetadata,
-    Ltp::ltp_extensions_t & headerExtensions, Ltp::ltp_extensions_t & trailerExtensions)
-{
+LtpSessionReceiver * LtpEngine::GetOrCreateSessionReceiverForDataSegment(const Ltp::session_id_t & sessionId, const uint64_t clientServiceId) {
     if (sessionId.sessionOriginatorEngineId == M_THIS_ENGINE_ID) {
         std::cerr << "error in DS received: sessionId.sessionOriginatorEngineId(" << sessionId.sessionOriginatorEngineId << ") == M_THIS_ENGINE_ID(" << M_THIS_ENGINE_ID << ")\n";
-        return;
+        return NULL;
     }
 
     std::map<Ltp::session_id_t, std::unique_ptr<LtpSessionReceiver> >::iterator rxSessionIt = m_mapSessionIdToSessionReceiver.find(sessionId);
@@ -715,13 +831,13 @@ void LtpEngine::DataSegmentReceivedCallback(uint8_t segmentTypeFlags, const Ltp:
         }
         if (!it->second->AddSession(sessionId.sessionNumber)) {
             std::cout << "preventing old session from being recreated for " << sessionId << std::endl;
-            return;
+            return NULL;
         }
         //if(m_ltpSessionRecreationPreventer.AddSession(sessionId.sessionNumber))
         const uint64_t randomNextReportSegmentReportSerialNumber = (M_FORCE_32_BIT_RANDOM_NUMBERS) ? m_rng.GetRandomSerialNumber32(m_randomDevice) : m_rng.GetRandomSerialNumber64(m_randomDevice); //incremented by 1 for new
         std::unique_ptr<LtpSessionReceiver> session = boost::make_unique<LtpSessionReceiver>(randomNextReportSegmentReportSerialNumber, m_maxReceptionClaims,
             M_ESTIMATED_BYTES_TO_RECEIVE_PER_SESSION, M_MAX_RED_RX_BYTES_PER_SESSION,
-            sessionId, dataSegmentMetadata.clientServiceId, M_ONE_WAY_LIGHT_TIME, M_ONE_WAY_MARGIN_TIME, m_ioServiceLtpEngine,
+            sessionId, clientServiceId, M_ONE_WAY_LIGHT_TIME, M_ONE_WAY_MARGIN_TIME, m_timingWheel,
             boost::bind(&LtpEngine::NotifyEngineThatThisReceiverNeedsDeletedCallback, this, boost::placeholders::_1, boost::placeholders::_2, boost::placeholders::_3),
             boost::bind(&LtpEngine::TrySendPacketIfAvailable, this), m_maxRetriesPerSerialNumber);
 
@@ -729,8 +845,9 @@ void LtpEngine::DataSegmentReceivedCallback(uint8_t segmentTypeFlags, const Ltp:
             m_mapSessionIdToSessionReceiver.insert(std::pair< Ltp::session_id_t, std::unique_ptr<LtpSessionReceiver> >(sessionId, std::move(session)));
         if (res.second == false) { //fragment key was not inserted
             std::cerr << "error new rx session cannot be inserted??\n";
-            return;
+            return NULL;
         }
+        UpdateNumActiveSessions();
         rxSessionIt = res.first;
 
         if (m_sessionStartCallback) {
@@ -738,43 +855,102 @@ void LtpEngine::DataSegmentReceivedCallback(uint8_t segmentTypeFlags, const Ltp:
             m_sessionStartCallback(sessionId);
         }
     }
-    rxSessionIt->second->DataSegmentReceivedCallback(segmentTypeFlags, clientServiceDataVec, dataSegmentMetadata, headerExtensions, trailerExtensions, m_redPartReceptionCallback, m_greenPartSegmentArrivalCallback);
+    return rxSessionIt->second.get();
+}
+
+void LtpEngine::DataSegmentReceivedCallback(uint8_t segmentTypeFlags, const Ltp::session_id_t & sessionId,
+    std::vector<uint8_t> & clientServiceDataVec, const Ltp::data_segment_metadata_t & dataSegmentMetadata,
+    Ltp::ltp_extensions_t & headerExtensions, Ltp::ltp_extensions_t & trailerExtensions)
+{
+    LtpSessionReceiver * const sessionReceiverPtr = GetOrCreateSessionReceiverForDataSegment(sessionId, dataSegmentMetadata.clientServiceId);
+    if (sessionReceiverPtr == NULL) {
+        return;
+    }
+    sessionReceiverPtr->DataSegmentReceivedCallback(segmentTypeFlags, clientServiceDataVec, dataSegmentMetadata, headerExtensions, trailerExtensions, m_redPartReceptionCallback, m_greenPartSegmentArrivalCallback);
+    TrySendPacketIfAvailable();
+}
+
+//same as above with the client service data still in the received datagram (avoids buffering it in the rx state machine before it is copied into the red part)
+void LtpEngine::DataSegmentReceivedInPlaceCallback(uint8_t segmentTypeFlags, const Ltp::session_id_t & sessionId,
+    const uint8_t * clientServiceData, const Ltp::data_segment_metadata_t & dataSegmentMetadata,
+    Ltp::ltp_extensions_t & headerExtensions, Ltp::ltp_extensions_t & trailerExtensions)
+{
+    LtpSessionReceiver * const sessionReceiverPtr = GetOrCreateSessionReceiverForDataSegment(sessionId, dataSegmentMetadata.clientServiceId);
+    if (sessionReceiverPtr == NULL) {
+        return;
+    }
+    sessionReceiverPtr->DataSegmentReceivedCallback(segmentTypeFlags, clientServiceData, dataSegmentMetadata, headerExtensions, trailerExtensions, m_redPartReceptionCallback, m_greenPartSegmentArrivalCallback);
     TrySendPacketIfAvailable();
 }
 
 void LtpEngine::SetSessionStartCallback(const SessionStartCallback_t & callback) {
     m_sessionStartCallback = callback;
+    for (std::size_t i = 0; i < m_workerEnginesPtrVec.size(); ++i) {
+        m_workerEnginesPtrVec[i]->SetSessionStartCallback(callback);
+    }
 }
 void LtpEngine::SetRedPartReceptionCallback(const RedPartReceptionCallback_t & callback) {
     m_redPartReceptionCallback = callback;
+    for (std::size_t i = 0; i < m_workerEnginesPtrVec.size(); ++i) {
+        m_workerEnginesPtrVec[i]->SetRedPartReceptionCallback(callback);
+    }
 }
 void LtpEngine::SetGreenPartSegmentArrivalCallback(const GreenPartSegmentArrivalCallback_t & callback) {
     m_greenPartSegmentArrivalCallback = callback;
+    for (std::size_t i = 0; i < m_workerEnginesPtrVec.size(); ++i) {
+        m_workerEnginesPtrVec[i]->SetGreenPartSegmentArrivalCallback(callback);
+    }
 }
 void LtpEngine::SetReceptionSessionCancelledCallback(const ReceptionSessionCancelledCallback_t & callback) {
     m_receptionSessionCancelledCallback = callback;
+    for (std::size_t i = 0; i < m_workerEnginesPtrVec.size(); ++i) {
+        m_workerEnginesPtrVec[i]->SetReceptionSessionCancelledCallback(callback);
+    }
 }
 void LtpEngine::SetTransmissionSessionCompletedCallback(const TransmissionSessionCompletedCallback_t & callback) {
     m_transmissionSessionCompletedCallback = callback;
+    for (std::size_t i = 0; i < m_workerEnginesPtrVec.size(); ++i) {
+        m_workerEnginesPtrVec[i]->SetTransmissionSessionCompletedCallback(callback);
+    }
 }
 void LtpEngine::SetInitialTransmissionCompletedCallback(const InitialTransmissionCompletedCallback_t & callback) {
     m_initialTransmissionCompletedCallback = callback;
+    for (std::size_t i = 0; i < m_workerEnginesPtrVec.size(); ++i) {
+        m_workerEnginesPtrVec[i]->SetInitialTransmissionCompletedCallback(callback);
+    }
 }
 void LtpEngine::SetTransmissionSessionCancelledCallback(const TransmissionSessionCancelledCallback_t & callback) {
     m_transmissionSessionCancelledCallback = callback;
+    for (std::size_t i = 0; i < m_workerEnginesPtrVec.size(); ++i) {
+        m_workerEnginesPtrVec[i]->SetTransmissionSessionCancelledCallback(callback);
+    }
+}
+
+void LtpEngine::UpdateNumActiveSessions() {
+    m_numActiveSendersAtomic.store(m_mapSessionNumberToSessionSender.size(), boost::memory_order_release);
+    m_numActiveReceiversAtomic.store(m_mapSessionIdToSessionReceiver.size(), boost::memory_order_release);
 }
 
 std::size_t LtpEngine::NumActiveReceivers() const {
-    return m_mapSessionIdToSessionReceiver.size();
+    std::size_t numReceivers = m_numActiveReceiversAtomic.load(boost::memory_order_acquire);
+    for (std::size_t i = 0; i < m_workerEnginesPtrVec.size(); ++i) {
+        numReceivers += m_workerEnginesPtrVec[i]->NumActiveReceivers();
+    }
+    return numReceivers;
 }
 std::size_t LtpEngine::NumActiveSenders() const {
-    return m_mapSessionNumberToSessionSender.size();
+    std::size_t numSenders = m_numActiveSendersAtomic.load(boost::memory_order_acquire);
+    for (std::size_t i = 0; i < m_workerEnginesPtrVec.size(); ++i) {
+        numSenders += m_workerEnginesPtrVec[i]->NumActiveSenders();
+    }
+    return numSenders;
 }
 
 void LtpEngine::UpdateRate(const uint64_t maxSendRateBitsPerSecOrZeroToDisable) {
     m_maxSendRateBitsPerSecOrZeroToDisable = maxSendRateBitsPerSecOrZeroToDisable;
-    if (maxSendRateBitsPerSecOrZeroToDisable) {
+    if (maxSendRateBitsPerSecOrZeroToDisable && (m_tokenRateLimiterOwnerPtr == this)) { //a worker engine only needs to know whether the rate is limited
         const uint64_t rateBytesPerSecond = m_maxSendRateBitsPerSecOrZeroToDisable >> 3;
+        boost::mutex::scoped_lock lock(m_tokenRateLimiterMutex);
         m_tokenRateLimiter.SetRate(
             rateBytesPerSecond,
             boost::posix_time::seconds(1),
@@ -784,17 +960,46 @@ void LtpEngine::UpdateRate(const uint64_t maxSendRateBitsPerSecOrZeroToDisable)
 }
 
 void LtpEngine::UpdateRate_ThreadSafe(const uint64_t maxSendRateBitsPerSecOrZeroToDisable) {
+    for (std::size_t i = 0; i < m_workerEnginesPtrVec.size(); ++i) {
+        m_workerEnginesPtrVec[i]->UpdateRate_ThreadSafe(maxSendRateBitsPerSecOrZeroToDisable);
+    }
     boost::asio::post(m_ioServiceLtpEngine, boost::bind(&LtpEngine::UpdateRate, this, maxSendRateBitsPerSecOrZeroToDisable));
 }
 
 
+bool LtpEngine::CanTakeSharedTokens() {
+    boost::mutex::scoped_lock lock(m_tokenRateLimiterOwnerPtr->m_tokenRateLimiterMutex);
+    return m_tokenRateLimiterOwnerPtr->m_tokenRateLimiter.CanTakeTokens();
+}
+
+void LtpEngine::TakeSharedTokens(const uint64_t tokens) {
+    boost::mutex::scoped_lock lock(m_tokenRateLimiterOwnerPtr->m_tokenRateLimiterMutex);
+    m_tokenRateLimiterOwnerPtr->m_tokenRateLimiter.TakeTokens(tokens);
+}
+
+void LtpEngine::StartSharedTokenRefreshClock(const boost::posix_time::ptime & nowPtime) {
+    boost::mutex::scoped_lock lock(m_tokenRateLimiterOwnerPtr->m_tokenRateLimiterMutex);
+    if (m_tokenRateLimiterOwnerPtr->m_lastTimeTokensWereRefreshed.is_neg_infinity()) {
+        m_tokenRateLimiterOwnerPtr->m_lastTimeTokensWereRefreshed = nowPtime;
+    }
+}
+
+//adds the tokens for the time since any engine sharing the rate limiter last refreshed it
+bool LtpEngine::RefreshSharedTokens(const boost::posix_time::ptime & nowPtime) {
+    boost::mutex::scoped_lock lock(m_tokenRateLimiterOwnerPtr->m_tokenRateLimiterMutex);
+    LtpEngine & owner = *m_tokenRateLimiterOwnerPtr;
+    if (nowPtime > owner.m_lastTimeTokensWereRefreshed) {
+        owner.m_tokenRateLimiter.AddTime(nowPtime - owner.m_lastTimeTokensWereRefreshed);
+        owner.m_lastTimeTokensWereRefreshed = nowPtime;
+    }
+    return owner.m_tokenRateLimiter.HasFullBucketOfTokens();
+}
+
 //restarts the token refresh timer if it is not running from now
 void LtpEngine::TryRestartTokenRefreshTimer() {
     if (!m_tokenRefreshTimerIsRunning) {
         const boost::posix_time::ptime nowPtime = boost::posix_time::microsec_clock::universal_time();
-        if (m_lastTimeTokensWereRefreshed.is_neg_infinity()) {
-            m_lastTimeTokensWereRefreshed = nowPtime;
-        }
+        StartSharedTokenRefreshClock(nowPtime);
         m_tokenRefreshTimer.expires_at(nowPtime + static_tokenRefreshTimeDurationWindow);
         m_tokenRefreshTimer.async_wait(boost::bind(&LtpEngine::OnTokenRefresh_TimerExpired, this, boost::asio::placeholders::error));
         m_tokenRefreshTimerIsRunning = true;
@@ -803,9 +1008,7 @@ void LtpEngine::TryRestartTokenRefreshTimer() {
 //restarts the token refresh timer if it is not running from the given ptime
 void LtpEngine::TryRestartTokenRefreshTimer(const boost::posix_time::ptime & nowPtime) {
     if (!m_tokenRefreshTimerIsRunning) {
-        if (m_lastTimeTokensWereRefreshed.is_neg_infinity()) {
-            m_lastTimeTokensWereRefreshed = nowPtime;
-        }
+        StartSharedTokenRefreshClock(nowPtime);
         m_tokenRefreshTimer.expires_at(nowPtime + static_tokenRefreshTimeDurationWindow);
         m_tokenRefreshTimer.async_wait(boost::bind(&LtpEngine::OnTokenRefresh_TimerExpired, this, boost::asio::placeholders::error));
         m_tokenRefreshTimerIsRunning = true;
@@ -814,16 +1017,14 @@ void LtpEngine::TryRestartTokenRefreshTimer(const boost::posix_time::ptime & now
 
 void LtpEngine::OnTokenRefresh_TimerExpired(const boost::system::error_code& e) {
     const boost::posix_time::ptime nowPtime = boost::posix_time::microsec_clock::universal_time();
-    const boost::posix_time::time_duration diff = nowPtime - m_lastTimeTokensWereRefreshed;
-    m_tokenRateLimiter.AddTime(diff);
-    m_lastTimeTokensWereRefreshed = nowPtime;
+    const bool hasFullBucketOfTokens = RefreshSharedTokens(nowPtime);
     m_tokenRefreshTimerIsRunning = false;
     if (e != boost::asio::error::operation_aborted) {
         // Timer was not cancelled, take necessary action.
         
         //If more tokens can be added, restart the timer so more tokens will be added at the next timer expiration.
         //Otherwise, if full, don't restart the timer and the next send packet operation will start it.
-        if (!m_tokenRateLimiter.HasFullBucketOfTokens()) {
+        if (!hasFullBucketOfTokens) {
             TryRestartTokenRefreshTimer(nowPtime); //do this first before TrySendPacketIfAvailable so nowPtime can be used
         }
 
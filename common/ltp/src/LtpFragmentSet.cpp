@@ -1,28 +1,38 @@
 #include "LtpFragmentSet.h"
 #include <iostream>
+#include <algorithm>
 #include "Sdnv.h"
 
-bool LtpFragmentSet::PopulateReportSegment(const std::set<data_fragment_t> & fragmentSet, Ltp::report_segment_t & reportSegment, uint64_t lowerBound, uint64_t upperBound) {
+static std::set<FragmentSet::data_fragment_t>::const_iterator LowerBound(const std::set<FragmentSet::data_fragment_t> & fragmentSet, const FragmentSet::data_fragment_t & key) {
+    return fragmentSet.lower_bound(key);
+}
+
+static FragmentSet::data_fragment_vec_t::const_iterator LowerBound(const FragmentSet::data_fragment_vec_t & fragmentVec, const FragmentSet::data_fragment_t & key) {
+    return std::lower_bound(fragmentVec.cbegin(), fragmentVec.cend(), key);
+}
+
+template <typename FragmentContainerType>
+static bool PopulateReportSegmentFromContainer(const FragmentContainerType & fragmentSet, Ltp::report_segment_t & reportSegment, uint64_t lowerBound, uint64_t upperBound) {
     if (fragmentSet.empty()) {
         return false;
     }
 
     //Lower bound : The lower bound of a report segment is the size of the(interior) block prefix to which the segment's reception claims do NOT pertain.
-    std::set<data_fragment_t>::const_iterator firstElement;
+    typename FragmentContainerType::const_iterator firstElement;
     if (lowerBound == UINT64_MAX) { //AUTO DETECT
         firstElement = fragmentSet.cbegin();
         lowerBound = firstElement->beginIndex;
     }
     else {
-        //set::lower_bound() returns an iterator pointing to the element in the container which is equivalent to k passed in the parameter.
+        //lower_bound() returns an iterator pointing to the element in the container which is equivalent to k passed in the parameter.
         //In case k is not present in the set container, the function returns an iterator pointing to the immediate next element which is just greater than k.
-        firstElement = fragmentSet.lower_bound(data_fragment_t(lowerBound, lowerBound)); //firstElement may overlap or abut key
+        firstElement = LowerBound(fragmentSet, FragmentSet::data_fragment_t(lowerBound, lowerBound)); //firstElement may overlap or abut key
     }
     reportSegment.lowerBound = lowerBound;
 
     //Upper bound : The upper bound of a report segment is the size of the block prefix to which the segment's reception claims pertain.
     if (upperBound == UINT64_MAX) { //AUTO DETECT
-        std::set<data_fragment_t>::const_reverse_iterator lastElement = fragmentSet.crbegin();
+        typename FragmentContainerType::const_reverse_iterator lastElement = fragmentSet.crbegin();
         upperBound = lastElement->endIndex + 1;
     }
     reportSegment.upperBound = upperBound;
@@ -34,7 +44,7 @@ bool LtpFragmentSet::PopulateReportSegment(const std::set<data_fragment_t> & fra
     //Reception claims
     reportSegment.receptionClaims.clear();
     reportSegment.receptionClaims.reserve(fragmentSet.size());
-    for (std::set<data_fragment_t>::const_iterator it = firstElement; it != fragmentSet.cend(); ++it) {
+    for (typename FragmentContainerType::const_iterator it = firstElement; it != fragmentSet.cend(); ++it) {
         //Offset : The offset indicates the successful reception of data beginning at the indicated offset from the lower bound of the RS.The
         //offset within the entire block can be calculated by summing this offset with the lower bound of the RS.
         const uint64_t beginIndex = std::max(it->beginIndex, lowerBound);
@@ -64,6 +74,14 @@ bool LtpFragmentSet::PopulateReportSegment(const std::set<data_fragment_t> & fra
     return true;
 }
 
+bool LtpFragmentSet::PopulateReportSegment(const std::set<data_fragment_t> & fragmentSet, Ltp::report_segment_t & reportSegment, uint64_t lowerBound, uint64_t upperBound) {
+    return PopulateReportSegmentFromContainer(fragmentSet, reportSegment, lowerBound, upperBound);
+}
+
+bool LtpFragmentSet::PopulateReportSegment(const data_fragment_vec_t & fragmentVec, Ltp::report_segment_t & reportSegment, uint64_t lowerBound, uint64_t upperBound) {
+    return PopulateReportSegmentFromContainer(fragmentVec, reportSegment, lowerBound, upperBound);
+}
+
 bool LtpFragmentSet::SplitReportSegment(const Ltp::report_segment_t & originalTooLargeReportSegment, std::vector<Ltp::report_segment_t> & reportSegmentsVec, const uint64_t maxReceptionClaimsPerReportSegment) {
     //3.2.  Retransmission
     //
@@ -104,15 +122,17 @@ bool LtpFragmentSet::SplitReportSegment(const Ltp::report_segment_t & originalTo
     return true;
 }
 
-void LtpFragmentSet::AddReportSegmentToFragmentSet(std::set<data_fragment_t> & fragmentSet, const Ltp::report_segment_t & reportSegment) {
+template <typename FragmentContainerType>
+static void AddReportSegmentToFragmentContainer(FragmentContainerType & fragmentSet, const Ltp::report_segment_t & reportSegment) {
     const uint64_t lowerBound = reportSegment.lowerBound;
     for (std::vector<Ltp::reception_claim_t>::const_iterator it = reportSegment.receptionClaims.cbegin(); it != reportSegment.receptionClaims.cend(); ++it) {
         const uint64_t beginIndex = lowerBound + it->offset;
-        InsertFragment(fragmentSet, data_fragment_t(beginIndex, (beginIndex + it->length) - 1));
+        FragmentSet::InsertFragment(fragmentSet, FragmentSet::data_fragment_t(beginIndex, (beginIndex + it->length) - 1));
     }
 }
 
-void LtpFragmentSet::AddReportSegmentToFragmentSetNeedingResent(std::set<data_fragment_t> & fragmentSetNeedingResent, const Ltp::report_segment_t & reportSegment) {
+template <typename FragmentContainerType>
+static void AddReportSegmentToFragmentContainerNeedingResent(FragmentContainerType & fragmentSetNeedingResent, const Ltp::report_segment_t & reportSegment) {
     const std::vector<Ltp::reception_claim_t> & receptionClaims = reportSegment.receptionClaims;
     if (receptionClaims.empty()) {
         return;
@@ -120,7 +140,7 @@ void LtpFragmentSet::AddReportSegmentToFragmentSetNeedingResent(std::set<data_fr
     const uint64_t lowerBound = reportSegment.lowerBound;
     std::vector<Ltp::reception_claim_t>::const_iterator it = receptionClaims.cbegin();
     if (it->offset > 0) { //add one
-        InsertFragment(fragmentSetNeedingResent, data_fragment_t(lowerBound, (lowerBound + it->offset) - 1));
+        FragmentSet::InsertFragment(fragmentSetNeedingResent, FragmentSet::data_fragment_t(lowerBound, (lowerBound + it->offset) - 1));
     }
     //uint64_t nextBeginIndex = lowerBound;
     const Ltp::reception_claim_t * previousReceptionClaim = NULL;
@@ -128,13 +148,30 @@ void LtpFragmentSet::AddReportSegmentToFragmentSetNeedingResent(std::set<data_fr
         if (previousReceptionClaim) {
             const uint64_t beginIndex = lowerBound + previousReceptionClaim->offset + previousReceptionClaim->length;
             const uint64_t endIndex = (lowerBound + it->offset) - 1;
-            InsertFragment(fragmentSetNeedingResent, data_fragment_t(beginIndex, endIndex));
+            FragmentSet::InsertFragment(fragmentSetNeedingResent, FragmentSet::data_fragment_t(beginIndex, endIndex));
         }
         //nextBeginIndex = (lowerBound + it->offset + it->length);
         previousReceptionClaim = &(*it);
     }
     const uint64_t beginIndex = lowerBound + previousReceptionClaim->offset + previousReceptionClaim->length;;
     if (beginIndex < reportSegment.upperBound) {
-        InsertFragment(fragmentSetNeedingResent, data_fragment_t(beginIndex, reportSegment.upperBound - 1));
+        FragmentSet::InsertFragment(fragmentSetNeedingResent, FragmentSet::data_fragment_t(beginIndex, reportSegment.upperBound - 1));
     }
 }
+
+void LtpFragmentSet::AddReportSegmentToFragmentSet(std::set<data_fragment_t> & fragmentSet, const Ltp::report_segment_t & reportSegment) {
+    AddReportSegmentToFragmentContainer(fragmentSet, reportSegment);
+}
+
+void LtpFragmentSet::AddReportSegmentToFragmentSet(data_fragment_vec_t & fragmentVec, const Ltp::report_segment_t & reportSegment) {
+    AddReportSegmentToFragmentContainer(fragmentVec, reportSegment);
+}
+
+void LtpFragmentSet::AddReportSegmentToFragmentSetNeedingResent(std::set<data_fragment_t> & fragmentSetNeedingResent, const Ltp::report_segment_t & reportSegment) {
+    AddReportSegmentToFragmentContainerNeedingResent(fragmentSetNeedingResent, reportSegment);
+}
+
+//the gaps between the reception claims come out in order, so with a vector each one is an append
+void LtpFragmentSet::AddReportSegmentToFragmentSetNeedingResent(data_fragment_vec_t & fragmentVecNeedingResent, const Ltp::report_segment_t & reportSegment) {
+    AddReportSegmentToFragmentContainerNeedingResent(fragmentVecNeedingResent, reportSegment);
+}
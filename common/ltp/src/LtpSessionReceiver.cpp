@@ -7,11 +7,11 @@
 LtpSessionReceiver::LtpSessionReceiver(uint64_t randomNextReportSegmentReportSerialNumber, const uint64_t MAX_RECEPTION_CLAIMS,
     const uint64_t ESTIMATED_BYTES_TO_RECEIVE, const uint64_t maxRedRxBytes,
     const Ltp::session_id_t & sessionId, const uint64_t clientServiceId,
-    const boost::posix_time::time_duration & oneWayLightTime, const boost::posix_time::time_duration & oneWayMarginTime, boost::asio::io_service & ioServiceRef,
+    const boost::posix_time::time_duration & oneWayLightTime, const boost::posix_time::time_duration & oneWayMarginTime, LtpTimingWheel & timingWheelRef,
     const NotifyEngineThatThisReceiverNeedsDeletedCallback_t & notifyEngineThatThisReceiverNeedsDeletedCallback,
     const NotifyEngineThatThisReceiversTimersProducedDataFunction_t & notifyEngineThatThisReceiversTimersProducedDataFunction,
     const uint32_t maxRetriesPerSerialNumber) :
-    m_timeManagerOfReportSerialNumbers(ioServiceRef, oneWayLightTime, oneWayMarginTime, boost::bind(&LtpSessionReceiver::LtpReportSegmentTimerExpiredCallback, this, boost::placeholders::_1, boost::placeholders::_2)),
+    m_timeManagerOfReportSerialNumbers(timingWheelRef, oneWayLightTime, oneWayMarginTime, boost::bind(&LtpSessionReceiver::LtpReportSegmentTimerExpiredCallback, this, boost::placeholders::_1, boost::placeholders::_2)),
     m_nextReportSegmentReportSerialNumber(randomNextReportSegmentReportSerialNumber),
     M_MAX_RECEPTION_CLAIMS(MAX_RECEPTION_CLAIMS),
     M_ESTIMATED_BYTES_TO_RECEIVE(ESTIMATED_BYTES_TO_RECEIVE),
@@ -25,7 +25,6 @@ LtpSessionReceiver::LtpSessionReceiver(uint64_t randomNextReportSegmentReportSer
     m_didRedPartReceptionCallback(false),
     m_didNotifyForDeletion(false),
     m_receivedEobFromGreenOrRed(false),
-    m_ioServiceRef(ioServiceRef),
     m_notifyEngineThatThisReceiverNeedsDeletedCallback(notifyEngineThatThisReceiverNeedsDeletedCallback),
     m_notifyEngineThatThisReceiversTimersProducedDataFunction(notifyEngineThatThisReceiversTimersProducedDataFunction),
     m_numReportSegmentTimerExpiredCallbacks(0),
@@ -149,11 +148,29 @@ void LtpSessionReceiver::DataSegmentReceivedCallback(uint8_t segmentTypeFlags,
     Ltp::ltp_extensions_t & headerExtensions, Ltp::ltp_extensions_t & trailerExtensions, const RedPartReceptionCallback_t & redPartReceptionCallback,
     const GreenPartSegmentArrivalCallback_t & greenPartSegmentArrivalCallback)
 {
-    const uint64_t offsetPlusLength = dataSegmentMetadata.offset + dataSegmentMetadata.length;
-    
     if (dataSegmentMetadata.length != clientServiceDataVec.size()) {
         std::cerr << "error dataSegmentMetadata.length != clientServiceDataVec.size()\n";
+        return;
     }
+    DataSegmentReceived(segmentTypeFlags, clientServiceDataVec.data(), &clientServiceDataVec, dataSegmentMetadata,
+        headerExtensions, trailerExtensions, redPartReceptionCallback, greenPartSegmentArrivalCallback);
+}
+
+void LtpSessionReceiver::DataSegmentReceivedCallback(uint8_t segmentTypeFlags,
+    const uint8_t * clientServiceData, const Ltp::data_segment_metadata_t & dataSegmentMetadata,
+    Ltp::ltp_extensions_t & headerExtensions, Ltp::ltp_extensions_t & trailerExtensions, const RedPartReceptionCallback_t & redPartReceptionCallback,
+    const GreenPartSegmentArrivalCallback_t & greenPartSegmentArrivalCallback)
+{
+    DataSegmentReceived(segmentTypeFlags, clientServiceData, NULL, dataSegmentMetadata,
+        headerExtensions, trailerExtensions, redPartReceptionCallback, greenPartSegmentArrivalCallback);
+}
+
+void LtpSessionReceiver::DataSegmentReceived(uint8_t segmentTypeFlags,
+    const uint8_t * clientServiceData, std::vector<uint8_t> * clientServiceDataVecPtr, const Ltp::data_segment_metadata_t & dataSegmentMetadata,
+    Ltp::ltp_extensions_t & headerExtensions, Ltp::ltp_extensions_t & trailerExtensions, const RedPartReceptionCallback_t & redPartReceptionCallback,
+    const GreenPartSegmentArrivalCallback_t & greenPartSegmentArrivalCallback)
+{
+    const uint64_t offsetPlusLength = dataSegmentMetadata.offset + dataSegmentMetadata.length;
     
 
     
@@ -202,11 +219,16 @@ void LtpSessionReceiver::DataSegmentReceivedCallback(uint8_t segmentTypeFlags,
             }
             return;
         }
-        if (m_dataReceivedRed.size() < offsetPlusLength) {
-            m_dataReceivedRed.resize(offsetPlusLength);
-            //std::cout << m_dataReceived.size() << " " << m_dataReceived.capacity() << std::endl;
+        if (dataSegmentMetadata.offset == m_dataReceivedRed.size()) { //in order (the usual case): append so the bytes are written once (no zero fill ahead of the copy)
+            m_dataReceivedRed.insert(m_dataReceivedRed.end(), clientServiceData, clientServiceData + dataSegmentMetadata.length);
+        }
+        else {
+            if (m_dataReceivedRed.size() < offsetPlusLength) {
+                m_dataReceivedRed.resize(offsetPlusLength);
+                //std::cout << m_dataReceived.size() << " " << m_dataReceived.capacity() << std::endl;
+            }
+            memcpy(m_dataReceivedRed.data() + dataSegmentMetadata.offset, clientServiceData, dataSegmentMetadata.length);
         }
-        memcpy(m_dataReceivedRed.data() + dataSegmentMetadata.offset, clientServiceDataVec.data(), dataSegmentMetadata.length);
 
         bool isRedCheckpoint = (segmentTypeFlags != 0);
         bool isEndOfRedPart = (segmentTypeFlags & 2);
@@ -362,7 +384,7 @@ void LtpSessionReceiver::DataSegmentReceivedCallback(uint8_t segmentTypeFlags,
         }
         //std::cout << "m_lengthOfRedPart " << m_lengthOfRedPart << " m_receivedDataFragmentsSet.size() " << m_receivedDataFragmentsSet.size() << std::endl;
         if ((!m_didRedPartReceptionCallback) && (m_lengthOfRedPart != UINT64_MAX) && (m_receivedDataFragmentsSet.size() == 1)) {
-            std::set<LtpFragmentSet::data_fragment_t>::const_iterator it = m_receivedDataFragmentsSet.cbegin();
+            LtpFragmentSet::data_fragment_vec_t::const_iterator it = m_receivedDataFragmentsSet.cbegin();
             //std::cout << "it->beginIndex " << it->beginIndex << " it->endIndex " << it->endIndex << std::endl;
             if ((it->beginIndex == 0) && (it->endIndex == (m_lengthOfRedPart - 1))) {
                 if (redPartReceptionCallback) {
@@ -400,7 +422,13 @@ void LtpSessionReceiver::DataSegmentReceivedCallback(uint8_t segmentTypeFlags,
         }
 
         if (greenPartSegmentArrivalCallback) {
-            greenPartSegmentArrivalCallback(M_SESSION_ID, clientServiceDataVec, offsetPlusLength, dataSegmentMetadata.clientServiceId, isEndOfBlock);
+            if (clientServiceDataVecPtr) {
+                greenPartSegmentArrivalCallback(M_SESSION_ID, *clientServiceDataVecPtr, offsetPlusLength, dataSegmentMetadata.clientServiceId, isEndOfBlock);
+            }
+            else { //received in place, the green part consumer takes ownership of a vector
+                std::vector<uint8_t> clientServiceDataVec(clientServiceData, clientServiceData + dataSegmentMetadata.length);
+                greenPartSegmentArrivalCallback(M_SESSION_ID, clientServiceDataVec, offsetPlusLength, dataSegmentMetadata.clientServiceId, isEndOfBlock);
+            }
         }
         
         if (isEndOfBlock) { //a green EOB
@@ -0,0 +1,227 @@
+#include "LtpTimingWheel.h"
+#include <boost/bind/bind.hpp>
+#include <boost/make_shared.hpp>
+
+LtpTimingWheel::Timer::Timer() : m_prev(NULL), m_next(NULL), m_timingWheelPtr(NULL), m_expiryTick(0) {}
+
+LtpTimingWheel::Timer::Timer(const Timer & o) : m_prev(NULL), m_next(NULL), m_timingWheelPtr(NULL), m_expiryTick(0) {}
+
+LtpTimingWheel::Timer::~Timer() {
+    if (m_timingWheelPtr) {
+        m_timingWheelPtr->CancelTimer(*this);
+    }
+}
+
+bool LtpTimingWheel::Timer::IsStarted() const {
+    return (m_timingWheelPtr != NULL);
+}
+
+void LtpTimingWheel::SlotHead::OnTimingWheelTimerExpired() {} //never started
+
+LtpTimingWheel::LtpTimingWheel(boost::asio::io_service & ioService, const boost::posix_time::time_duration & tickDuration) :
+    m_deadlineTimer(ioService),
+    M_TICK_DURATION((tickDuration.total_microseconds() > 0) ? tickDuration : boost::posix_time::microseconds(1)),
+    M_EPOCH(boost::posix_time::microsec_clock::universal_time()),
+    m_currentTick(0),
+    m_size(0),
+    m_deadlineTimerIsArmed(false),
+    m_deadlineTimerTick(0),
+    m_isWheelDeletedPtr(boost::make_shared<bool>(false))
+{
+    for (unsigned int i = 0; i < NUM_SLOTS; ++i) {
+        m_slots[i].m_prev = &m_slots[i];
+        m_slots[i].m_next = &m_slots[i];
+    }
+}
+
+LtpTimingWheel::~LtpTimingWheel() {
+    //a cancelled wait may still be delivered after this is gone.. prevent it from using the deleted member variables
+    *m_isWheelDeletedPtr = true;
+    //timers that outlive the wheel must not try to cancel themselves from it
+    for (unsigned int i = 0; i < NUM_SLOTS; ++i) {
+        while (m_slots[i].m_next != &m_slots[i]) {
+            Timer & timer = *m_slots[i].m_next;
+            Unlink(timer);
+            timer.m_timingWheelPtr = NULL;
+        }
+    }
+    m_size = 0;
+}
+
+uint64_t LtpTimingWheel::GetTick(const boost::posix_time::ptime & t) const {
+    const int64_t us = (t - M_EPOCH).total_microseconds();
+    return (us <= 0) ? 0 : static_cast<uint64_t>(us) / static_cast<uint64_t>(M_TICK_DURATION.total_microseconds());
+}
+
+void LtpTimingWheel::StartTimer(Timer & timer, const boost::posix_time::time_duration & duration) {
+    if (timer.m_timingWheelPtr) {
+        timer.m_timingWheelPtr->CancelTimer(timer);
+    }
+    const boost::posix_time::ptime nowPtime = boost::posix_time::microsec_clock::universal_time();
+    if (m_size == 0) {
+        //nothing pending, so the wheel may have been idle (deadline timer not running) for any length of time: skip straight to now
+        const uint64_t nowTick = GetTick(nowPtime);
+        if (nowTick > m_currentTick) {
+            m_currentTick = nowTick;
+        }
+    }
+    const int64_t expiryUs = ((nowPtime + duration) - M_EPOCH).total_microseconds();
+    const uint64_t tickUs = static_cast<uint64_t>(M_TICK_DURATION.total_microseconds());
+    uint64_t expiryTick = (expiryUs <= 0) ? 0 : ((static_cast<uint64_t>(expiryUs) + (tickUs - 1)) / tickUs); //round up so it never expires early
+    if (expiryTick <= m_currentTick) {
+        expiryTick = m_currentTick + 1;
+    }
+    timer.m_expiryTick = expiryTick;
+    timer.m_timingWheelPtr = this;
+    Insert(timer);
+    ++m_size;
+    if ((!m_deadlineTimerIsArmed) || (expiryTick < m_deadlineTimerTick)) {
+        TryArmDeadlineTimer();
+    }
+}
+
+bool LtpTimingWheel::CancelTimer(Timer & timer) {
+    if (timer.m_timingWheelPtr != this) {
+        return false;
+    }
+    Unlink(timer);
+    timer.m_timingWheelPtr = NULL;
+    --m_size;
+    if ((m_size == 0) && m_deadlineTimerIsArmed) { //nothing left to wait for (lets the io_service run out of work)
+        m_deadlineTimerIsArmed = false;
+        m_deadlineTimer.cancel();
+    }
+    return true;
+}
+
+std::size_t LtpTimingWheel::Size() const {
+    return m_size;
+}
+
+bool LtpTimingWheel::Empty() const {
+    return (m_size == 0);
+}
+
+void LtpTimingWheel::Unlink(Timer & timer) {
+    timer.m_prev->m_next = timer.m_next;
+    timer.m_next->m_prev = timer.m_prev;
+    timer.m_prev = NULL;
+    timer.m_next = NULL;
+}
+
+void LtpTimingWheel::PushBack(Timer & head, Timer & timer) {
+    timer.m_prev = head.m_prev;
+    timer.m_next = &head;
+    head.m_prev->m_next = &timer;
+    head.m_prev = &timer;
+}
+
+void LtpTimingWheel::Insert(Timer & timer) {
+    uint64_t slotTick = timer.m_expiryTick;
+    uint64_t ticksAhead = (slotTick > m_currentTick) ? (slotTick - m_currentTick) : 0;
+    if (ticksAhead > MAX_TICKS_AHEAD) { //park it in the furthest slot, it gets re-inserted when that slot comes around
+        ticksAhead = MAX_TICKS_AHEAD;
+        slotTick = m_currentTick + MAX_TICKS_AHEAD;
+    }
+    if (ticksAhead < LEVEL0_SIZE) {
+        PushBack(m_slots[slotTick & (LEVEL0_SIZE - 1)], timer);
+        return;
+    }
+    unsigned int level = 1;
+    unsigned int shift = LEVEL0_BITS;
+    while ((level < (NUM_LEVELS - 1)) && (ticksAhead >= (static_cast<uint64_t>(1) << (shift + LEVEL_N_BITS)))) {
+        ++level;
+        shift += LEVEL_N_BITS;
+    }
+    PushBack(m_slots[LEVEL0_SIZE + ((level - 1) * LEVEL_N_SIZE) + ((slotTick >> shift) & (LEVEL_N_SIZE - 1))], timer);
+}
+
+void LtpTimingWheel::Cascade(const unsigned int firstSlotIndexOfLevel, const unsigned int slotIndexWithinLevel) {
+    SlotHead & head = m_slots[firstSlotIndexOfLevel + slotIndexWithinLevel];
+    while (head.m_next != &head) { //re-inserting from the current tick always lands in a lower level
+        Timer & timer = *head.m_next;
+        Unlink(timer);
+        Insert(timer);
+    }
+}
+
+void LtpTimingWheel::ProcessTick() {
+    const uint64_t tick = m_currentTick;
+    if ((tick & (LEVEL0_SIZE - 1)) == 0) { //level 0 wrapped around, redistribute the next slot of level 1 (and so on up while those wrap too)
+        unsigned int shift = LEVEL0_BITS;
+        for (unsigned int level = 1; level < NUM_LEVELS; ++level) {
+            const unsigned int slotIndexWithinLevel = static_cast<unsigned int>((tick >> shift) & (LEVEL_N_SIZE - 1));
+            Cascade(LEVEL0_SIZE + ((level - 1) * LEVEL_N_SIZE), slotIndexWithinLevel);
+            if (slotIndexWithinLevel != 0) {
+                break;
+            }
+            shift += LEVEL_N_BITS;
+        }
+    }
+
+    //Move the due timers to a local list first: a callback may cancel (or destroy) any timer still in it,
+    //and may start timers (which can only land in later ticks).
+    SlotHead & slotHead = m_slots[tick & (LEVEL0_SIZE - 1)];
+    if (slotHead.m_next == &slotHead) {
+        return;
+    }
+    SlotHead dueList;
+    dueList.m_next = slotHead.m_next;
+    dueList.m_prev = slotHead.m_prev;
+    dueList.m_next->m_prev = &dueList;
+    dueList.m_prev->m_next = &dueList;
+    slotHead.m_next = &slotHead;
+    slotHead.m_prev = &slotHead;
+    while (dueList.m_next != &dueList) {
+        Timer & timer = *dueList.m_next;
+        Unlink(timer);
+        if (timer.m_expiryTick > tick) { //was parked beyond the range of the wheel
+            Insert(timer);
+            continue;
+        }
+        timer.m_timingWheelPtr = NULL;
+        --m_size;
+        timer.OnTimingWheelTimerExpired();
+    }
+}
+
+void LtpTimingWheel::TryArmDeadlineTimer() {
+    if (m_size == 0) {
+        return;
+    }
+    //wake up at the next occupied level 0 slot of this turn, otherwise when level 0 wraps around
+    uint64_t wakeTick = ((m_currentTick >> LEVEL0_BITS) + 1) << LEVEL0_BITS;
+    for (uint64_t tick = m_currentTick + 1; tick < wakeTick; ++tick) {
+        const SlotHead & slotHead = m_slots[tick & (LEVEL0_SIZE - 1)];
+        if (slotHead.m_next != &slotHead) {
+            wakeTick = tick;
+            break;
+        }
+    }
+    if (m_deadlineTimerIsArmed && (m_deadlineTimerTick <= wakeTick)) {
+        return;
+    }
+    m_deadlineTimerTick = wakeTick;
+    m_deadlineTimerIsArmed = true;
+    m_deadlineTimer.expires_at(M_EPOCH + boost::posix_time::microseconds(static_cast<int64_t>(wakeTick * static_cast<uint64_t>(M_TICK_DURATION.total_microseconds()))));
+    m_deadlineTimer.async_wait(boost::bind(&LtpTimingWheel::OnDeadlineTimerExpired, this, boost::asio::placeholders::error, m_isWheelDeletedPtr));
+}
+
+void LtpTimingWheel::OnDeadlineTimerExpired(const boost::system::error_code& e, boost::shared_ptr<bool> & isWheelDeletedPtr) {
+    if (*isWheelDeletedPtr) {
+        return;
+    }
+    if (e == boost::asio::error::operation_aborted) { //cancelled because the wheel emptied or an earlier wake up was needed (a new wait is already pending if so)
+        return;
+    }
+    m_deadlineTimerIsArmed = false;
+    const uint64_t nowTick = GetTick(boost::posix_time::microsec_clock::universal_time());
+    while ((m_currentTick < nowTick) && m_size) {
+        ++m_currentTick;
+        ProcessTick();
+    }
+    if (m_currentTick < nowTick) { //empty
+        m_currentTick = nowTick;
+    }
+    TryArmDeadlineTimer();
+}
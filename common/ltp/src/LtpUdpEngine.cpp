@@ -1,5 +1,19 @@
 #include "LtpUdpEngine.h"
 #include <boost/make_unique.hpp>
+#ifdef LTP_UDP_ENGINE_SUPPORTS_SENDMMSG
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <cerrno>
+#include <cstring>
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103 //linux/udp.h (kernel 4.18+), missing from older libc headers
+#endif
+#ifndef SOL_UDP
+#define SOL_UDP 17
+#endif
+static const std::size_t UDP_GSO_MAX_SEGMENTS = 64; //UDP_MAX_SEGMENTS of the kernel
+static const std::size_t UDP_GSO_MAX_BYTES = 65507; //all segments of a UDP GSO message must fit in one maximum size IPv4 UDP datagram
+#endif
 
 
 LtpUdpEngine::LtpUdpEngine(boost::asio::io_service & ioServiceUdpRef, boost::asio::ip::udp::socket & udpSocketRef,
@@ -8,9 +22,11 @@ LtpUdpEngine::LtpUdpEngine(boost::asio::io_service & ioServiceUdpRef, boost::asi
     const boost::posix_time::time_duration & oneWayLightTime, const boost::posix_time::time_duration & oneWayMarginTime,
     const boost::asio::ip::udp::endpoint & remoteEndpoint, const unsigned int numUdpRxCircularBufferVectors,
     const uint64_t ESTIMATED_BYTES_TO_RECEIVE_PER_SESSION, const uint64_t maxRedRxBytesPerSession, uint32_t checkpointEveryNthDataPacketSender,
-    uint32_t maxRetriesPerSerialNumber, const bool force32BitRandomNumbers, const uint64_t maxUdpRxPacketSizeBytes, const uint64_t maxSendRateBitsPerSecOrZeroToDisable) :
+    uint32_t maxRetriesPerSerialNumber, const bool force32BitRandomNumbers, const uint64_t maxUdpRxPacketSizeBytes, const uint64_t maxSendRateBitsPerSecOrZeroToDisable,
+    const unsigned int maxUdpPacketsToSendPerSystemCall, const bool useUdpGso, const unsigned int numWorkerThreads) :
     LtpEngine(thisEngineId, engineIndexForEncodingIntoRandomSessionNumber, mtuClientServiceData, mtuReportSegment, oneWayLightTime, oneWayMarginTime,
-        ESTIMATED_BYTES_TO_RECEIVE_PER_SESSION, maxRedRxBytesPerSession, true, checkpointEveryNthDataPacketSender, maxRetriesPerSerialNumber, force32BitRandomNumbers, maxSendRateBitsPerSecOrZeroToDisable),
+        ESTIMATED_BYTES_TO_RECEIVE_PER_SESSION, maxRedRxBytesPerSession, true, checkpointEveryNthDataPacketSender, maxRetriesPerSerialNumber, force32BitRandomNumbers,
+        maxSendRateBitsPerSecOrZeroToDisable),
     m_ioServiceUdpRef(ioServiceUdpRef),
     m_udpSocketRef(udpSocketRef),
     m_remoteEndpoint(remoteEndpoint),
@@ -18,19 +34,45 @@ LtpUdpEngine::LtpUdpEngine(boost::asio::io_service & ioServiceUdpRef, boost::asi
     M_MAX_UDP_RX_PACKET_SIZE_BYTES(maxUdpRxPacketSizeBytes),
     m_circularIndexBuffer(M_NUM_CIRCULAR_BUFFER_VECTORS),
     m_udpReceiveBuffersCbVec(M_NUM_CIRCULAR_BUFFER_VECTORS),
+    m_udpReceiveBytesTransferredCbVec(M_NUM_CIRCULAR_BUFFER_VECTORS),
+    m_numPacketsQueuedFromManager(0),
     m_printedCbTooSmallNotice(false),
+#ifdef LTP_UDP_ENGINE_SUPPORTS_SENDMMSG
+    m_useUdpGso(useUdpGso),
+#endif
     m_countAsyncSendCalls(0),
     m_countAsyncSendCallbackCalls(0),
-    m_countCircularBufferOverruns(0)
+    m_countCircularBufferOverruns(0),
+    m_countSendmmsgCalls(0),
+    m_countUdpGsoMessagesSent(0)
 {
     for (unsigned int i = 0; i < M_NUM_CIRCULAR_BUFFER_VECTORS; ++i) {
         m_udpReceiveBuffersCbVec[i].resize(maxUdpRxPacketSizeBytes);
     }
+#ifdef LTP_UDP_ENGINE_SUPPORTS_SENDMMSG
+    if (maxUdpPacketsToSendPerSystemCall > 1) {
+        SetMaxPacketsToSendPerBatch(maxUdpPacketsToSendPerSystemCall);
+        m_sendmmsgPacketsVec.reserve(maxUdpPacketsToSendPerSystemCall);
+        m_sendmmsgMessagesVec.reserve(maxUdpPacketsToSendPerSystemCall);
+        m_sendmmsgIovecsVec.reserve(maxUdpPacketsToSendPerSystemCall * 3); //header, data, and trailer
+        m_sendmmsgHeadersVec.reserve(maxUdpPacketsToSendPerSystemCall);
+        m_sendmmsgControlBuffersVec.reserve(maxUdpPacketsToSendPerSystemCall);
+    }
+#endif
+    for (unsigned int workerIndex = 1; workerIndex < numWorkerThreads; ++workerIndex) {
+        m_workerEnginesVec.push_back(boost::make_unique<LtpUdpEngine>(ioServiceUdpRef, udpSocketRef, thisEngineId,
+            static_cast<uint8_t>(engineIndexForEncodingIntoRandomSessionNumber + workerIndex), mtuClientServiceData, mtuReportSegment, oneWayLightTime, oneWayMarginTime,
+            remoteEndpoint, numUdpRxCircularBufferVectors, ESTIMATED_BYTES_TO_RECEIVE_PER_SESSION, maxRedRxBytesPerSession, checkpointEveryNthDataPacketSender,
+            maxRetriesPerSerialNumber, force32BitRandomNumbers, maxUdpRxPacketSizeBytes, maxSendRateBitsPerSecOrZeroToDisable, //the workers share this engine's rate limiter
+            maxUdpPacketsToSendPerSystemCall, useUdpGso, 1));
+        AddWorkerEngine(m_workerEnginesVec.back().get());
+    }
 }
 
 LtpUdpEngine::~LtpUdpEngine() {
     //std::cout << "end of ~LtpUdpEngine with port " << M_MY_BOUND_UDP_PORT << std::endl;
-    std::cout << "~LtpUdpEngine: m_countAsyncSendCalls " << m_countAsyncSendCalls << " m_countCircularBufferOverruns " << m_countCircularBufferOverruns << std::endl;
+    std::cout << "~LtpUdpEngine: m_countAsyncSendCalls " << m_countAsyncSendCalls << " m_countSendmmsgCalls " << m_countSendmmsgCalls
+        << " m_countUdpGsoMessagesSent " << m_countUdpGsoMessagesSent << " m_countCircularBufferOverruns " << m_countCircularBufferOverruns << std::endl;
 }
 
 
@@ -39,6 +81,23 @@ void LtpUdpEngine::Reset() {
     m_countAsyncSendCalls = 0;
     m_countAsyncSendCallbackCalls = 0;
     m_countCircularBufferOverruns = 0;
+    m_countSendmmsgCalls = 0;
+    m_countUdpGsoMessagesSent = 0;
+    for (std::size_t i = 0; i < m_workerEnginesVec.size(); ++i) {
+        m_workerEnginesVec[i]->Reset();
+    }
+}
+
+unsigned int LtpUdpEngine::GetNumWorkers() const {
+    return static_cast<unsigned int>(m_workerEnginesVec.size() + 1);
+}
+
+LtpUdpEngine * LtpUdpEngine::GetWorkerEngine(const unsigned int workerIndex) {
+    return (workerIndex == 0) ? this : m_workerEnginesVec[workerIndex - 1].get();
+}
+
+LtpUdpEngine * LtpUdpEngine::GetWorkerEngineOwningSession(const Ltp::session_id_t & sessionId) {
+    return GetWorkerEngine(static_cast<unsigned int>(GetOwningWorkerIndex(sessionId)));
 }
 
 
@@ -58,6 +117,42 @@ void LtpUdpEngine::PostPacketFromManager_ThreadSafe(std::vector<uint8_t> & packe
     }
 }
 
+bool LtpUdpEngine::QueuePacketFromManager(std::vector<uint8_t> & packetIn_thenSwappedForAnotherSameSizeVector, std::size_t size) {
+    const unsigned int writeIndex = m_circularIndexBuffer.GetIndexForWrite(); //store the volatile
+    if (writeIndex == UINT32_MAX) {
+        ++m_countCircularBufferOverruns;
+        if (!m_printedCbTooSmallNotice) {
+            m_printedCbTooSmallNotice = true;
+            std::cout << "notice in LtpUdpEngine::QueuePacketFromManager(): buffers full.. you might want to increase the circular buffer size! Next UDP packet will be dropped!" << std::endl;
+        }
+        return false;
+    }
+    packetIn_thenSwappedForAnotherSameSizeVector.swap(m_udpReceiveBuffersCbVec[writeIndex]);
+    m_udpReceiveBytesTransferredCbVec[writeIndex] = size;
+    m_circularIndexBuffer.CommitWrite(); //write complete at this point
+    return (m_numPacketsQueuedFromManager++ == 0);
+}
+
+void LtpUdpEngine::PostQueuedPacketsFromManager_ThreadSafe() {
+    if (m_numPacketsQueuedFromManager) {
+        PostToLtpEngine_ThreadSafe(boost::bind(&LtpUdpEngine::PacketsInFromManager, this, m_numPacketsQueuedFromManager));
+        m_numPacketsQueuedFromManager = 0;
+    }
+}
+
+void LtpUdpEngine::PacketsInFromManager(const unsigned int numPackets) {
+    //Called by LTP Engine thread.  Packets are read in the order they were committed, and each PacketIn's
+    //PacketInFullyProcessedCallback commits the read before the next one.
+    for (unsigned int i = 0; i < numPackets; ++i) {
+        const unsigned int readIndex = m_circularIndexBuffer.GetIndexForRead(); //store the volatile
+        if (readIndex == UINT32_MAX) {
+            std::cerr << "error in LtpUdpEngine::PacketsInFromManager: circular buffer unexpectedly empty" << std::endl;
+            return;
+        }
+        PacketIn(m_udpReceiveBuffersCbVec[readIndex].data(), m_udpReceiveBytesTransferredCbVec[readIndex]);
+    }
+}
+
 void LtpUdpEngine::SendPacket(std::vector<boost::asio::const_buffer> & constBufferVec, boost::shared_ptr<std::vector<std::vector<uint8_t> > > & underlyingDataToDeleteOnSentCallback, const uint64_t sessionOriginatorEngineId) {
     //called by LtpEngine Thread
     ++m_countAsyncSendCalls;
@@ -72,6 +167,147 @@ void LtpUdpEngine::SendPacket(std::vector<boost::asio::const_buffer> & constBuff
     }
 }
 
+#ifdef LTP_UDP_ENGINE_SUPPORTS_SENDMMSG
+void LtpUdpEngine::SendPackets(std::vector<packet_to_send_t> & packetsToSend, const std::size_t numPacketsToSend) {
+    //Called by LtpEngine Thread.
+    //The whole batch goes out with as few sendmmsg calls as possible (normally one).  A run of packets of equal size
+    //(the last of the run may be shorter) is sent as one UDP GSO message which the kernel splits back into one datagram per packet.
+    //The kernel copies the data before sendmmsg returns, so sent packets need no completion handler of their own.
+    //Whatever sendmmsg could not take (socket send buffer full or an error) falls back to async_send_to.
+    m_countAsyncSendCalls += numPacketsToSend;
+    std::size_t numPacketsCompleted = 0; //sent by sendmmsg or dropped by the simulator, completed with a single HandleUdpSendBatch
+
+    m_sendmmsgPacketsVec.clear();
+    m_sendmmsgIovecsVec.clear();
+    for (std::size_t i = 0; i < numPacketsToSend; ++i) {
+        const std::vector<boost::asio::const_buffer> & constBufferVec = packetsToSend[i].constBufferVec;
+        if (m_udpDropSimulatorFunction && m_udpDropSimulatorFunction(*((uint8_t*)constBufferVec[0].data()))) {
+            ++numPacketsCompleted;
+            continue;
+        }
+        sendmmsg_packet_t packet;
+        packet.packetIndex = i;
+        packet.firstIovecIndex = m_sendmmsgIovecsVec.size();
+        packet.sizeBytes = 0;
+        for (std::size_t j = 0; j < constBufferVec.size(); ++j) {
+            const std::size_t bufSize = constBufferVec[j].size();
+            if (bufSize) { //skip the unused trailer
+                struct iovec iov;
+                iov.iov_base = const_cast<void*>(constBufferVec[j].data());
+                iov.iov_len = bufSize;
+                m_sendmmsgIovecsVec.push_back(iov);
+                packet.sizeBytes += bufSize;
+            }
+        }
+        packet.numIovecs = m_sendmmsgIovecsVec.size() - packet.firstIovecIndex;
+        m_sendmmsgPacketsVec.push_back(packet);
+    }
+
+    m_sendmmsgMessagesVec.clear();
+    for (std::size_t i = 0; i < m_sendmmsgPacketsVec.size(); ) {
+        sendmmsg_message_t message;
+        message.firstPacketIndex = i;
+        message.numPackets = 1;
+        message.gsoSegmentSizeBytes = 0;
+        if (m_useUdpGso) {
+            const std::size_t segmentSize = m_sendmmsgPacketsVec[i].sizeBytes;
+            std::size_t totalBytes = segmentSize;
+            while (((i + message.numPackets) < m_sendmmsgPacketsVec.size()) && (message.numPackets < UDP_GSO_MAX_SEGMENTS)) {
+                const std::size_t nextSize = m_sendmmsgPacketsVec[i + message.numPackets].sizeBytes;
+                if ((nextSize > segmentSize) || ((totalBytes + nextSize) > UDP_GSO_MAX_BYTES)) {
+                    break;
+                }
+                totalBytes += nextSize;
+                ++message.numPackets;
+                if (nextSize < segmentSize) { //only the last segment may be shorter
+                    break;
+                }
+            }
+            if (message.numPackets > 1) {
+                message.gsoSegmentSizeBytes = segmentSize;
+            }
+        }
+        m_sendmmsgMessagesVec.push_back(message);
+        i += message.numPackets;
+    }
+
+    //the iovec vector no longer grows, so pointers into it are now stable
+    const std::size_t numMessages = m_sendmmsgMessagesVec.size();
+    m_sendmmsgHeadersVec.resize(numMessages);
+    m_sendmmsgControlBuffersVec.resize(numMessages);
+    if (numMessages) {
+        memset(m_sendmmsgHeadersVec.data(), 0, numMessages * sizeof(struct mmsghdr));
+    }
+    for (std::size_t i = 0; i < numMessages; ++i) {
+        const sendmmsg_message_t & message = m_sendmmsgMessagesVec[i];
+        const sendmmsg_packet_t & firstPacket = m_sendmmsgPacketsVec[message.firstPacketIndex];
+        const sendmmsg_packet_t & lastPacket = m_sendmmsgPacketsVec[message.firstPacketIndex + message.numPackets - 1];
+        struct msghdr & msg = m_sendmmsgHeadersVec[i].msg_hdr;
+        msg.msg_name = m_remoteEndpoint.data();
+        msg.msg_namelen = static_cast<socklen_t>(m_remoteEndpoint.size());
+        msg.msg_iov = &m_sendmmsgIovecsVec[firstPacket.firstIovecIndex];
+        msg.msg_iovlen = (lastPacket.firstIovecIndex + lastPacket.numIovecs) - firstPacket.firstIovecIndex;
+        if (message.gsoSegmentSizeBytes) {
+            msg.msg_control = m_sendmmsgControlBuffersVec[i].buf;
+            msg.msg_controllen = sizeof(m_sendmmsgControlBuffersVec[i].buf);
+            struct cmsghdr * const cmsg = CMSG_FIRSTHDR(&msg);
+            cmsg->cmsg_level = SOL_UDP;
+            cmsg->cmsg_type = UDP_SEGMENT;
+            cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+            const uint16_t gsoSize = static_cast<uint16_t>(message.gsoSegmentSizeBytes);
+            memcpy(CMSG_DATA(cmsg), &gsoSize, sizeof(gsoSize));
+        }
+    }
+
+    std::size_t messageIndex = 0;
+    while (messageIndex < numMessages) {
+        const int numSent = sendmmsg(m_udpSocketRef.native_handle(), &m_sendmmsgHeadersVec[messageIndex],
+            static_cast<unsigned int>(numMessages - messageIndex), MSG_DONTWAIT);
+        ++m_countSendmmsgCalls;
+        if (numSent > 0) {
+            for (int i = 0; i < numSent; ++i) {
+                const sendmmsg_message_t & message = m_sendmmsgMessagesVec[messageIndex++];
+                numPacketsCompleted += message.numPackets;
+                m_countUdpGsoMessagesSent += (message.gsoSegmentSizeBytes != 0);
+            }
+        }
+        else if ((numSent < 0) && (errno == EINTR)) {
+            continue;
+        }
+        else {
+            if ((numSent < 0) && m_sendmmsgMessagesVec[messageIndex].gsoSegmentSizeBytes
+                && ((errno == EIO) || (errno == EINVAL) || (errno == ENOPROTOOPT) || (errno == EOPNOTSUPP)))
+            {
+                //kernel older than 4.18, or a segment that does not fit in the path MTU
+                m_useUdpGso = false;
+                std::cout << "notice in LtpUdpEngine::SendPackets: UDP GSO message rejected (" << strerror(errno)
+                    << "), sending without UDP GSO from now on" << std::endl;
+            }
+            break; //EAGAIN (socket send buffer full) or an error: async_send_to waits for room or reports the error
+        }
+    }
+    for (; messageIndex < numMessages; ++messageIndex) {
+        const sendmmsg_message_t & message = m_sendmmsgMessagesVec[messageIndex];
+        for (std::size_t i = 0; i < message.numPackets; ++i) {
+            packet_to_send_t & packet = packetsToSend[m_sendmmsgPacketsVec[message.firstPacketIndex + i].packetIndex];
+            m_udpSocketRef.async_send_to(packet.constBufferVec, m_remoteEndpoint,
+                boost::bind(&LtpUdpEngine::HandleUdpSend, this, std::move(packet.underlyingDataToDeleteOnSentCallback),
+                    boost::asio::placeholders::error,
+                    boost::asio::placeholders::bytes_transferred));
+        }
+    }
+    if (numPacketsCompleted) {
+        boost::asio::post(m_ioServiceUdpRef, boost::bind(&LtpUdpEngine::HandleUdpSendBatch, this, numPacketsCompleted));
+    }
+}
+
+void LtpUdpEngine::HandleUdpSendBatch(const std::size_t numPacketsSent) {
+    m_countAsyncSendCallbackCalls += numPacketsSent;
+    if (m_countAsyncSendCallbackCalls == m_countAsyncSendCalls) { //prevent too many sends from stacking up in ioService queue
+        SignalReadyForSend_ThreadSafe();
+    }
+}
+#endif
 
 void LtpUdpEngine::PacketInFullyProcessedCallback(bool success) {
     //Called by LTP Engine thread
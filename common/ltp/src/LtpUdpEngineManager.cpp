@@ -1,13 +1,29 @@
 #include "LtpUdpEngineManager.h"
 #include <boost/make_unique.hpp>
 #include <boost/lexical_cast.hpp>
+#include <algorithm>
 #include "Sdnv.h"
+#ifdef LTP_UDP_ENGINE_MANAGER_SUPPORTS_RECVMMSG
+#include <cerrno>
+#include <cstring>
+static const bool RECVMMSG_SUPPORTED = true;
+#else
+static const bool RECVMMSG_SUPPORTED = false;
+#endif
+#ifdef LTP_UDP_ENGINE_SUPPORTS_SENDMMSG
+static const bool SENDMMSG_SUPPORTED = true;
+#else
+static const bool SENDMMSG_SUPPORTED = false;
+#endif
 
 //c++ shared singleton using weak pointer
 //https://codereview.stackexchange.com/questions/14343/c-shared-singleton
 std::map<uint16_t, std::weak_ptr<LtpUdpEngineManager> > LtpUdpEngineManager::m_staticMapBoundPortToLtpUdpEngineManagerPtr;
 boost::mutex LtpUdpEngineManager::m_staticMutex;
 uint64_t LtpUdpEngineManager::M_STATIC_MAX_UDP_RX_PACKET_SIZE_BYTES_FOR_ALL_LTP_UDP_ENGINES = 0;
+bool LtpUdpEngineManager::m_staticUseRecvmmsgForNewInstances = true;
+bool LtpUdpEngineManager::m_staticUseSendmmsgForNewInstances = true;
+bool LtpUdpEngineManager::m_staticUseUdpGsoForNewInstances = true;
 
 //static function
 void LtpUdpEngineManager::SetMaxUdpRxPacketSizeBytesForAllLtp(const uint64_t maxUdpRxPacketSizeBytesForAllLtp) {
@@ -28,6 +44,19 @@ void LtpUdpEngineManager::SetMaxUdpRxPacketSizeBytesForAllLtp(const uint64_t max
     }
 }
 
+//static function
+void LtpUdpEngineManager::SetUseRecvmmsgForNewInstances(const bool useRecvmmsg) {
+    boost::mutex::scoped_lock theLock(m_staticMutex);
+    m_staticUseRecvmmsgForNewInstances = useRecvmmsg;
+}
+
+//static function
+void LtpUdpEngineManager::SetUseSendmmsgForNewInstances(const bool useSendmmsg, const bool useUdpGso) {
+    boost::mutex::scoped_lock theLock(m_staticMutex);
+    m_staticUseSendmmsgForNewInstances = useSendmmsg;
+    m_staticUseUdpGsoForNewInstances = useUdpGso;
+}
+
 //static function
 std::shared_ptr<LtpUdpEngineManager> LtpUdpEngineManager::GetOrCreateInstance(const uint16_t myBoundUdpPort, const bool autoStart) {
     boost::mutex::scoped_lock theLock(m_staticMutex);
@@ -54,10 +83,29 @@ LtpUdpEngineManager::LtpUdpEngineManager(const uint16_t myBoundUdpPort, const bo
     m_resolver(m_ioServiceUdp),
     m_udpSocket(m_ioServiceUdp),
     m_udpReceiveBuffer(M_STATIC_MAX_UDP_RX_PACKET_SIZE_BYTES_FOR_ALL_LTP_UDP_ENGINES),
+    M_USE_RECVMMSG(RECVMMSG_SUPPORTED && m_staticUseRecvmmsgForNewInstances), //constructed by GetOrCreateInstance with m_staticMutex locked
+    M_USE_SENDMMSG(SENDMMSG_SUPPORTED && m_staticUseSendmmsgForNewInstances),
+    M_USE_UDP_GSO(M_USE_SENDMMSG && m_staticUseUdpGsoForNewInstances),
     m_vecEngineIndexToLtpUdpEngineTransmitterPtr(256, NULL),
     m_nextEngineIndex(1),
     m_readyToForward(false)
 {
+#ifdef LTP_UDP_ENGINE_MANAGER_SUPPORTS_RECVMMSG
+    if (M_USE_RECVMMSG) {
+        m_recvmmsgBuffersVec.resize(RECVMMSG_BATCH_SIZE);
+        m_recvmmsgIovecsVec.resize(RECVMMSG_BATCH_SIZE);
+        m_recvmmsgHeadersVec.resize(RECVMMSG_BATCH_SIZE);
+        memset(m_recvmmsgHeadersVec.data(), 0, RECVMMSG_BATCH_SIZE * sizeof(struct mmsghdr)); //no source address (msg_name) wanted
+        for (unsigned int i = 0; i < RECVMMSG_BATCH_SIZE; ++i) {
+            m_recvmmsgBuffersVec[i].resize(M_STATIC_MAX_UDP_RX_PACKET_SIZE_BYTES_FOR_ALL_LTP_UDP_ENGINES);
+            m_recvmmsgIovecsVec[i].iov_base = m_recvmmsgBuffersVec[i].data();
+            m_recvmmsgIovecsVec[i].iov_len = m_recvmmsgBuffersVec[i].size();
+            m_recvmmsgHeadersVec[i].msg_hdr.msg_iov = &m_recvmmsgIovecsVec[i];
+            m_recvmmsgHeadersVec[i].msg_hdr.msg_iovlen = 1;
+        }
+        m_enginesWithQueuedPacketsVec.reserve(RECVMMSG_BATCH_SIZE);
+    }
+#endif
     if (autoStart) {
         StartIfNotAlreadyRunning(); //TODO EVALUATE IF AUTO START SAFE
     }
@@ -77,7 +125,9 @@ bool LtpUdpEngineManager::StartIfNotAlreadyRunning() {
 
             return false;
         }
-        printf("LtpUdpEngineManager bound successfully on UDP port %d\n", m_udpSocket.local_endpoint().port());
+        printf("LtpUdpEngineManager bound successfully on UDP port %d (%s, %s)\n", m_udpSocket.local_endpoint().port(),
+            (M_USE_RECVMMSG) ? "batched receive with recvmmsg" : "single datagram receive",
+            (M_USE_UDP_GSO) ? "batched send with sendmmsg and UDP GSO" : (M_USE_SENDMMSG) ? "batched send with sendmmsg" : "single datagram send");
 
         StartUdpReceive(); //call before creating io_service thread so that it has "work"
 
@@ -104,6 +154,13 @@ void LtpUdpEngineManager::RemoveLtpUdpEngineByRemoteEngineId_NotThreadSafe(const
             << " for type " << ((isInduct) ? "induct" : "outduct") << " does not exist" << std::endl;
     }
     else {
+        if (!isInduct) { //its engine indices are never reused
+            LtpUdpEngine * const ltpUdpEnginePtr = it->second.get();
+            for (unsigned int workerIndex = 0; workerIndex < ltpUdpEnginePtr->GetNumWorkers(); ++workerIndex) {
+                std::replace(m_vecEngineIndexToLtpUdpEngineTransmitterPtr.begin(), m_vecEngineIndexToLtpUdpEngineTransmitterPtr.end(),
+                    ltpUdpEnginePtr->GetWorkerEngine(workerIndex), static_cast<LtpUdpEngine*>(NULL));
+            }
+        }
         whichMap->erase(it);
         std::cout << "remoteEngineId " << remoteEngineId << " for type " << ((isInduct) ? "induct" : "outduct") << " successfully removed" << std::endl;
     }
@@ -112,14 +169,17 @@ void LtpUdpEngineManager::RemoveLtpUdpEngineByRemoteEngineId_NotThreadSafe(const
     }
 }
 
-//a max of 254 engines can be added for one outduct with the same udp port
+//a max of 254 engines (engine worker threads) can be added for one outduct with the same udp port
 bool LtpUdpEngineManager::AddLtpUdpEngine(const uint64_t thisEngineId, const uint64_t remoteEngineId, const bool isInduct, const uint64_t mtuClientServiceData, uint64_t mtuReportSegment,
     const boost::posix_time::time_duration & oneWayLightTime, const boost::posix_time::time_duration & oneWayMarginTime,
     const std::string & remoteHostname, const uint16_t remotePort, const unsigned int numUdpRxCircularBufferVectors,
     const uint64_t ESTIMATED_BYTES_TO_RECEIVE_PER_SESSION, const uint64_t maxRedRxBytesPerSession, uint32_t checkpointEveryNthDataPacketSender,
-    uint32_t maxRetriesPerSerialNumber, const bool force32BitRandomNumbers, const uint64_t maxSendRateBitsPerSecOrZeroToDisable)
+    uint32_t maxRetriesPerSerialNumber, const bool force32BitRandomNumbers, const uint64_t maxSendRateBitsPerSecOrZeroToDisable, unsigned int numWorkerThreads)
 {   
-    if ((m_nextEngineIndex > 255) && (!isInduct)) {
+    if (numWorkerThreads == 0) {
+        numWorkerThreads = 1;
+    }
+    if (((m_nextEngineIndex + numWorkerThreads) > 256) && (!isInduct)) {
         std::cerr << "error in LtpUdpEngineManager::AddLtpUdpEngine: a max of 254 engines can be added for one outduct with the same udp port\n";
         return false;
     }
@@ -146,10 +206,13 @@ bool LtpUdpEngineManager::AddLtpUdpEngine(const uint64_t thisEngineId, const uin
     std::unique_ptr<LtpUdpEngine> newLtpUdpEnginePtr = boost::make_unique<LtpUdpEngine>(m_ioServiceUdp,
         m_udpSocket, thisEngineId, engineIndex, mtuClientServiceData, mtuReportSegment, oneWayLightTime, oneWayMarginTime,
         remoteEndpoint, numUdpRxCircularBufferVectors, ESTIMATED_BYTES_TO_RECEIVE_PER_SESSION, maxRedRxBytesPerSession, checkpointEveryNthDataPacketSender,
-        maxRetriesPerSerialNumber, force32BitRandomNumbers, M_STATIC_MAX_UDP_RX_PACKET_SIZE_BYTES_FOR_ALL_LTP_UDP_ENGINES, maxSendRateBitsPerSecOrZeroToDisable);
-    if (!isInduct) {
-        ++m_nextEngineIndex;
-        m_vecEngineIndexToLtpUdpEngineTransmitterPtr[engineIndex] = newLtpUdpEnginePtr.get();
+        maxRetriesPerSerialNumber, force32BitRandomNumbers, M_STATIC_MAX_UDP_RX_PACKET_SIZE_BYTES_FOR_ALL_LTP_UDP_ENGINES, maxSendRateBitsPerSecOrZeroToDisable,
+        (M_USE_SENDMMSG) ? SENDMMSG_BATCH_SIZE : 1, M_USE_UDP_GSO, numWorkerThreads);
+    if (!isInduct) { //each worker has its own engine index
+        for (unsigned int workerIndex = 0; workerIndex < numWorkerThreads; ++workerIndex) {
+            m_vecEngineIndexToLtpUdpEngineTransmitterPtr[engineIndex + workerIndex] = newLtpUdpEnginePtr->GetWorkerEngine(workerIndex);
+        }
+        m_nextEngineIndex += numWorkerThreads;
     }
     (*whichMap)[remoteEngineId] = std::move(newLtpUdpEnginePtr);
     
@@ -174,6 +237,14 @@ void LtpUdpEngineManager::Stop() {
 
 
 void LtpUdpEngineManager::StartUdpReceive() {
+#ifdef LTP_UDP_ENGINE_MANAGER_SUPPORTS_RECVMMSG
+    if (M_USE_RECVMMSG) {
+        m_udpSocket.async_wait(boost::asio::ip::udp::socket::wait_read,
+            boost::bind(&LtpUdpEngineManager::HandleUdpSocketReadable, this,
+                boost::asio::placeholders::error));
+        return;
+    }
+#endif
     m_udpSocket.async_receive_from(
         boost::asio::buffer(m_udpReceiveBuffer),
         m_remoteEndpointReceived,
@@ -182,67 +253,82 @@ void LtpUdpEngineManager::StartUdpReceive() {
             boost::asio::placeholders::bytes_transferred));
 }
 
+//returns NULL if the packet should be ignored, or if isCriticalError is set, in which case the caller must shut down the socket
+LtpUdpEngine * LtpUdpEngineManager::GetLtpUdpEnginePtrForReceivedPacket(const std::vector<uint8_t> & packet, const std::size_t size, bool & isCriticalError) {
+    isCriticalError = false;
+    if (size <= 2) {
+        std::cerr << "error in LtpUdpEngineManager::HandleUdpReceive(): bytesTransferred <= 2 .. ignoring packet" << std::endl;
+        return NULL;
+    }
 
-void LtpUdpEngineManager::HandleUdpReceive(const boost::system::error_code & error, std::size_t bytesTransferred) {
-    if (!error) {
-        if (bytesTransferred <= 2) {
-            std::cerr << "error in LtpUdpEngineManager::HandleUdpReceive(): bytesTransferred <= 2 .. ignoring packet" << std::endl;
-            StartUdpReceive();
-            return;
+    const uint8_t segmentTypeFlags = packet[0]; // & 0x0f; //upper 4 bits must be 0 for version 0
+    bool isSenderToReceiver;
+    if (!Ltp::GetMessageDirectionFromSegmentFlags(segmentTypeFlags, isSenderToReceiver)) {
+        std::cerr << "critical error in LtpUdpEngine::HandleUdpReceive(): received invalid ltp packet with segment type flag " << (int)segmentTypeFlags << std::endl;
+        isCriticalError = true;
+        return NULL;
+    }
+
+    uint8_t sdnvSize;
+    const uint64_t sessionOriginatorEngineId = SdnvDecodeU64(&packet[1], &sdnvSize, (100 - 1)); //no worries about hardware accelerated sdnv read out of bounds due to minimum 100 byte size
+    if (sdnvSize == 0) {
+        std::cerr << "error in LtpUdpEngineManager::HandleUdpReceive(): cannot read sessionOriginatorEngineId.. ignoring packet" << std::endl;
+        return NULL;
+    }
+
+    LtpUdpEngine * ltpUdpEnginePtr;
+    if (isSenderToReceiver) { //received an isSenderToReceiver message type => isInduct (this ltp engine received a message type that only travels from an outduct (sender) to an induct (receiver))
+        //sessionOriginatorEngineId is the remote engine id in the case of an induct
+        std::map<uint64_t, std::unique_ptr<LtpUdpEngine> >::iterator it = m_mapRemoteEngineIdToLtpUdpEngineReceiverPtr.find(sessionOriginatorEngineId);
+        if (it == m_mapRemoteEngineIdToLtpUdpEngineReceiverPtr.end()) {
+            std::cerr << "error in LtpUdpEngineManager::HandleUdpReceive: an induct received packet with unknown remote engine Id "
+                << sessionOriginatorEngineId << ".. ignoring packet" << std::endl;
+            return NULL;
         }
-        
-        const uint8_t segmentTypeFlags = m_udpReceiveBuffer[0]; // & 0x0f; //upper 4 bits must be 0 for version 0
-        bool isSenderToReceiver;
-        if (!Ltp::GetMessageDirectionFromSegmentFlags(segmentTypeFlags, isSenderToReceiver)) {
-            std::cerr << "critical error in LtpUdpEngine::HandleUdpReceive(): received invalid ltp packet with segment type flag " << (int)segmentTypeFlags << std::endl;
-            DoUdpShutdown();
-            return;
+        ltpUdpEnginePtr = it->second.get();
+        if (ltpUdpEnginePtr->GetNumWorkers() > 1) { //the session number decides which worker engine owns the session
+            const uint64_t sessionNumber = SdnvDecodeU64(&packet[1 + sdnvSize], &sdnvSize, ((100 - 10) - 1)); //no worries about hardware accelerated sdnv read out of bounds due to minimum 100 byte size
+            if (sdnvSize == 0) {
+                std::cerr << "error in LtpUdpEngineManager::HandleUdpReceive(): cannot read sessionNumber.. ignoring packet" << std::endl;
+                return NULL;
+            }
+            ltpUdpEnginePtr = ltpUdpEnginePtr->GetWorkerEngineOwningSession(Ltp::session_id_t(sessionOriginatorEngineId, sessionNumber));
         }
-        
-        uint8_t sdnvSize;
-        const uint64_t sessionOriginatorEngineId = SdnvDecodeU64(&m_udpReceiveBuffer[1], &sdnvSize, (100 - 1)); //no worries about hardware accelerated sdnv read out of bounds due to minimum 100 byte size
+    }
+    else { //received an isReceiverToSender message type => isOutduct (this ltp engine received a message type that only travels from an induct (receiver) to an outduct (sender))
+        //sessionOriginatorEngineId is my engine id in the case of an outduct.. need to get the session number to find the proper LtpUdpEngine
+        const uint64_t sessionNumber = SdnvDecodeU64(&packet[1 + sdnvSize], &sdnvSize, ((100 - 10) - 1)); //no worries about hardware accelerated sdnv read out of bounds due to minimum 100 byte size
         if (sdnvSize == 0) {
-            std::cerr << "error in LtpUdpEngineManager::HandleUdpReceive(): cannot read sessionOriginatorEngineId.. ignoring packet" << std::endl;
-            StartUdpReceive();
-            return;
+            std::cerr << "error in LtpUdpEngineManager::HandleUdpReceive(): cannot read sessionNumber.. ignoring packet" << std::endl;
+            return NULL;
+        }
+        const uint8_t engineIndex = LtpRandomNumberGenerator::GetEngineIndexFromRandomSessionNumber(sessionNumber);
+        ltpUdpEnginePtr = m_vecEngineIndexToLtpUdpEngineTransmitterPtr[engineIndex];
+        if (ltpUdpEnginePtr == NULL) {
+            std::cerr << "error in LtpUdpEngineManager::HandleUdpReceive: an outduct received packet of type " << (int)segmentTypeFlags << " with unknown session number "
+                << sessionNumber << ".. ignoring packet" << std::endl;
+            return NULL;
         }
+    }
+    return ltpUdpEnginePtr;
+}
 
-        LtpUdpEngine * ltpUdpEnginePtr;
-        if (isSenderToReceiver) { //received an isSenderToReceiver message type => isInduct (this ltp engine received a message type that only travels from an outduct (sender) to an induct (receiver))
-            //sessionOriginatorEngineId is the remote engine id in the case of an induct
-            std::map<uint64_t, std::unique_ptr<LtpUdpEngine> >::iterator it = m_mapRemoteEngineIdToLtpUdpEngineReceiverPtr.find(sessionOriginatorEngineId);
-            if (it == m_mapRemoteEngineIdToLtpUdpEngineReceiverPtr.end()) {
-                std::cerr << "error in LtpUdpEngineManager::HandleUdpReceive: an induct received packet with unknown remote engine Id "
-                    << sessionOriginatorEngineId << ".. ignoring packet" << std::endl;
-                StartUdpReceive();
-                return;
-            }
-            ltpUdpEnginePtr = it->second.get();
+void LtpUdpEngineManager::HandleUdpReceive(const boost::system::error_code & error, std::size_t bytesTransferred) {
+    if (!error) {
+        bool isCriticalError;
+        LtpUdpEngine * const ltpUdpEnginePtr = GetLtpUdpEnginePtrForReceivedPacket(m_udpReceiveBuffer, bytesTransferred, isCriticalError);
+        if (isCriticalError) {
+            DoUdpShutdown();
+            return;
         }
-        else { //received an isReceiverToSender message type => isOutduct (this ltp engine received a message type that only travels from an induct (receiver) to an outduct (sender))
-            //sessionOriginatorEngineId is my engine id in the case of an outduct.. need to get the session number to find the proper LtpUdpEngine
-            const uint64_t sessionNumber = SdnvDecodeU64(&m_udpReceiveBuffer[1 + sdnvSize], &sdnvSize, ((100 - 10) - 1)); //no worries about hardware accelerated sdnv read out of bounds due to minimum 100 byte size
-            if (sdnvSize == 0) {
-                std::cerr << "error in LtpUdpEngineManager::HandleUdpReceive(): cannot read sessionNumber.. ignoring packet" << std::endl;
-                StartUdpReceive();
-                return;
-            }
-            const uint8_t engineIndex = LtpRandomNumberGenerator::GetEngineIndexFromRandomSessionNumber(sessionNumber);
-            ltpUdpEnginePtr = m_vecEngineIndexToLtpUdpEngineTransmitterPtr[engineIndex];
-            if (ltpUdpEnginePtr == NULL) {
-                std::cerr << "error in LtpUdpEngineManager::HandleUdpReceive: an outduct received packet of type " << (int)segmentTypeFlags << " with unknown session number "
-                    << sessionNumber << ".. ignoring packet" << std::endl;
-                StartUdpReceive();
-                return;
+        if (ltpUdpEnginePtr) {
+            ltpUdpEnginePtr->PostPacketFromManager_ThreadSafe(m_udpReceiveBuffer, bytesTransferred);
+            if (m_udpReceiveBuffer.size() != M_STATIC_MAX_UDP_RX_PACKET_SIZE_BYTES_FOR_ALL_LTP_UDP_ENGINES) {
+                std::cerr << "error in LtpUdpEngineManager::HandleUdpReceive: swapped packet not size "
+                    << M_STATIC_MAX_UDP_RX_PACKET_SIZE_BYTES_FOR_ALL_LTP_UDP_ENGINES << "... resizing" << std::endl;
+                m_udpReceiveBuffer.resize(M_STATIC_MAX_UDP_RX_PACKET_SIZE_BYTES_FOR_ALL_LTP_UDP_ENGINES);
             }
         }
-        
-        ltpUdpEnginePtr->PostPacketFromManager_ThreadSafe(m_udpReceiveBuffer, bytesTransferred);
-        if (m_udpReceiveBuffer.size() != M_STATIC_MAX_UDP_RX_PACKET_SIZE_BYTES_FOR_ALL_LTP_UDP_ENGINES) {
-            std::cerr << "error in LtpUdpEngineManager::HandleUdpReceive: swapped packet not size " 
-                << M_STATIC_MAX_UDP_RX_PACKET_SIZE_BYTES_FOR_ALL_LTP_UDP_ENGINES << "... resizing" << std::endl;
-            m_udpReceiveBuffer.resize(M_STATIC_MAX_UDP_RX_PACKET_SIZE_BYTES_FOR_ALL_LTP_UDP_ENGINES);
-        }
         StartUdpReceive(); //restart operation only if there was no error
     }
     else if (error != boost::asio::error::operation_aborted) {
@@ -251,7 +337,58 @@ void LtpUdpEngineManager::HandleUdpReceive(const boost::system::error_code & err
     }
 }
 
-
+#ifdef LTP_UDP_ENGINE_MANAGER_SUPPORTS_RECVMMSG
+//Drains up to RECVMMSG_BATCH_SIZE datagrams with one system call, then posts each engine's share of the batch to that engine's thread at once.
+void LtpUdpEngineManager::HandleUdpSocketReadable(const boost::system::error_code & error) {
+    if (error) {
+        if (error != boost::asio::error::operation_aborted) {
+            std::cerr << "critical error in LtpUdpEngineManager::HandleUdpSocketReadable(): " << error.message() << std::endl;
+            DoUdpShutdown();
+        }
+        return;
+    }
+    const int numPackets = recvmmsg(m_udpSocket.native_handle(), m_recvmmsgHeadersVec.data(), RECVMMSG_BATCH_SIZE, MSG_DONTWAIT, NULL);
+    if (numPackets < 0) {
+        const int errorNumber = errno;
+        if ((errorNumber == EAGAIN) || (errorNumber == EWOULDBLOCK) || (errorNumber == EINTR)) {
+            StartUdpReceive(); //spurious wakeup
+        }
+        else {
+            std::cerr << "critical error in LtpUdpEngineManager::HandleUdpSocketReadable(): recvmmsg: " << strerror(errorNumber) << std::endl;
+            DoUdpShutdown();
+        }
+        return;
+    }
+    for (int i = 0; i < numPackets; ++i) {
+        std::vector<boost::uint8_t> & packet = m_recvmmsgBuffersVec[i];
+        const std::size_t bytesTransferred = m_recvmmsgHeadersVec[i].msg_len;
+        bool isCriticalError;
+        LtpUdpEngine * const ltpUdpEnginePtr = GetLtpUdpEnginePtrForReceivedPacket(packet, bytesTransferred, isCriticalError);
+        if (isCriticalError) {
+            m_enginesWithQueuedPacketsVec.clear(); //the engines are about to be deleted
+            DoUdpShutdown();
+            return;
+        }
+        if (ltpUdpEnginePtr == NULL) {
+            continue;
+        }
+        if (ltpUdpEnginePtr->QueuePacketFromManager(packet, bytesTransferred)) {
+            m_enginesWithQueuedPacketsVec.push_back(ltpUdpEnginePtr);
+        }
+        if (packet.size() != M_STATIC_MAX_UDP_RX_PACKET_SIZE_BYTES_FOR_ALL_LTP_UDP_ENGINES) {
+            std::cerr << "error in LtpUdpEngineManager::HandleUdpSocketReadable: swapped packet not size "
+                << M_STATIC_MAX_UDP_RX_PACKET_SIZE_BYTES_FOR_ALL_LTP_UDP_ENGINES << "... resizing" << std::endl;
+            packet.resize(M_STATIC_MAX_UDP_RX_PACKET_SIZE_BYTES_FOR_ALL_LTP_UDP_ENGINES);
+        }
+        m_recvmmsgIovecsVec[i].iov_base = packet.data(); //the swap gave this ring slot a different buffer
+    }
+    for (std::size_t i = 0; i < m_enginesWithQueuedPacketsVec.size(); ++i) {
+        m_enginesWithQueuedPacketsVec[i]->PostQueuedPacketsFromManager_ThreadSafe();
+    }
+    m_enginesWithQueuedPacketsVec.clear();
+    StartUdpReceive(); //restart operation only if there was no error
+}
+#endif
 
 
 void LtpUdpEngineManager::DoUdpShutdown() {
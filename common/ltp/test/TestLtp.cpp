@@ -1,6 +1,7 @@
 #include <boost/test/unit_test.hpp>
 #include "Ltp.h"
 #include <boost/bind/bind.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
 
 BOOST_AUTO_TEST_CASE(LtpSessionIdTestCase)
 {
@@ -1335,4 +1336,447 @@ BOOST_AUTO_TEST_CASE(LtpFullTestCase)
     BOOST_REQUIRE(t.m_ltp.IsAtBeginningState());
     t.DoCancelSegment();
     BOOST_REQUIRE(t.m_ltp.IsAtBeginningState());
-}
\ No newline at end of file
+}
+BOOST_AUTO_TEST_CASE(LtpDataSegmentInPlaceTestCase)
+{
+    struct Test {
+        Ltp m_ltp;
+        std::vector<uint8_t> m_receivedData;
+        uint64_t m_numInPlaceCallbacks;
+        uint64_t m_numBufferedCallbacks;
+
+        Test() : m_numInPlaceCallbacks(0), m_numBufferedCallbacks(0) {
+            m_ltp.SetDataSegmentContentsReadCallback(boost::bind(&Test::DataSegmentCallback, this,
+                boost::placeholders::_1, boost::placeholders::_2, boost::placeholders::_3,
+                boost::placeholders::_4, boost::placeholders::_5, boost::placeholders::_6));
+            m_ltp.SetDataSegmentContentsReadInPlaceCallback(boost::bind(&Test::DataSegmentInPlaceCallback, this,
+                boost::placeholders::_1, boost::placeholders::_2, boost::placeholders::_3,
+                boost::placeholders::_4, boost::placeholders::_5, boost::placeholders::_6));
+        }
+        void DataSegmentCallback(uint8_t segmentTypeFlags, const Ltp::session_id_t & sessionId,
+            std::vector<uint8_t> & clientServiceDataVec, const Ltp::data_segment_metadata_t & dataSegmentMetadata,
+            Ltp::ltp_extensions_t & headerExtensions, Ltp::ltp_extensions_t & trailerExtensions)
+        {
+            ++m_numBufferedCallbacks;
+            BOOST_REQUIRE_EQUAL(dataSegmentMetadata.length, clientServiceDataVec.size());
+            m_receivedData.insert(m_receivedData.end(), clientServiceDataVec.begin(), clientServiceDataVec.end());
+        }
+        void DataSegmentInPlaceCallback(uint8_t segmentTypeFlags, const Ltp::session_id_t & sessionId,
+            const uint8_t * clientServiceData, const Ltp::data_segment_metadata_t & dataSegmentMetadata,
+            Ltp::ltp_extensions_t & headerExtensions, Ltp::ltp_extensions_t & trailerExtensions)
+        {
+            ++m_numInPlaceCallbacks;
+            BOOST_REQUIRE(trailerExtensions.extensionsVec.empty());
+            m_receivedData.insert(m_receivedData.end(), clientServiceData, clientServiceData + dataSegmentMetadata.length);
+        }
+        void Reset() {
+            m_receivedData.clear();
+            m_numInPlaceCallbacks = 0;
+            m_numBufferedCallbacks = 0;
+        }
+    };
+
+    std::vector<uint8_t> clientServiceData(1000);
+    for (std::size_t i = 0; i < clientServiceData.size(); ++i) {
+        clientServiceData[i] = static_cast<uint8_t>(i * 7);
+    }
+    uint64_t checkpointSerialNumber = 10;
+    uint64_t reportSerialNumber = 0;
+    std::vector<uint8_t> header;
+    Ltp::GenerateLtpHeaderPlusDataSegmentMetadata(header, LTP_DATA_SEGMENT_TYPE_FLAGS::REDDATA_CHECKPOINT_ENDOFREDPART_ENDOFBLOCK,
+        Ltp::session_id_t(5555, 6666), Ltp::data_segment_metadata_t(7777, 0, clientServiceData.size(), &checkpointSerialNumber, &reportSerialNumber));
+    std::vector<uint8_t> packet(header);
+    packet.insert(packet.end(), clientServiceData.begin(), clientServiceData.end());
+
+    Test t;
+    std::string errorMessage;
+
+    //whole datagram at once => in place
+    BOOST_REQUIRE(t.m_ltp.HandleReceivedChars(packet.data(), packet.size(), errorMessage));
+    BOOST_REQUIRE(t.m_ltp.IsAtBeginningState());
+    BOOST_REQUIRE_EQUAL(t.m_numInPlaceCallbacks, 1);
+    BOOST_REQUIRE_EQUAL(t.m_numBufferedCallbacks, 0);
+    BOOST_REQUIRE(t.m_receivedData == clientServiceData);
+
+    //two segments in one buffer => both in place
+    t.Reset();
+    {
+        std::vector<uint8_t> twoPackets(packet);
+        twoPackets.insert(twoPackets.end(), packet.begin(), packet.end());
+        BOOST_REQUIRE(t.m_ltp.HandleReceivedChars(twoPackets.data(), twoPackets.size(), errorMessage));
+        BOOST_REQUIRE(t.m_ltp.IsAtBeginningState());
+        BOOST_REQUIRE_EQUAL(t.m_numInPlaceCallbacks, 2);
+        BOOST_REQUIRE_EQUAL(t.m_numBufferedCallbacks, 0);
+        std::vector<uint8_t> expected(clientServiceData);
+        expected.insert(expected.end(), clientServiceData.begin(), clientServiceData.end());
+        BOOST_REQUIRE(t.m_receivedData == expected);
+    }
+
+    //header then the whole client service data => in place
+    t.Reset();
+    BOOST_REQUIRE(t.m_ltp.HandleReceivedChars(header.data(), header.size(), errorMessage));
+    BOOST_REQUIRE(t.m_ltp.HandleReceivedChars(clientServiceData.data(), clientServiceData.size(), errorMessage));
+    BOOST_REQUIRE(t.m_ltp.IsAtBeginningState());
+    BOOST_REQUIRE_EQUAL(t.m_numInPlaceCallbacks, 1);
+    BOOST_REQUIRE_EQUAL(t.m_numBufferedCallbacks, 0);
+    BOOST_REQUIRE(t.m_receivedData == clientServiceData);
+
+    //client service data split across calls => buffered
+    for (std::size_t splitIndex = header.size() + 1; splitIndex < packet.size(); splitIndex += 333) {
+        t.Reset();
+        BOOST_REQUIRE(t.m_ltp.HandleReceivedChars(packet.data(), splitIndex, errorMessage));
+        BOOST_REQUIRE(t.m_ltp.HandleReceivedChars(packet.data() + splitIndex, packet.size() - splitIndex, errorMessage));
+        BOOST_REQUIRE(t.m_ltp.IsAtBeginningState());
+        BOOST_REQUIRE_EQUAL(t.m_numInPlaceCallbacks, 0);
+        BOOST_REQUIRE_EQUAL(t.m_numBufferedCallbacks, 1);
+        BOOST_REQUIRE(t.m_receivedData == clientServiceData);
+    }
+
+    //trailer extensions => buffered (the callback must come after the trailer)
+    t.Reset();
+    {
+        Ltp::ltp_extensions_t trailerExtensions;
+        Ltp::ltp_extension_t e;
+        e.tag = 0x44;
+        e.valueVec = { 'x', 'y' };
+        trailerExtensions.extensionsVec.push_back(std::move(e));
+        std::vector<uint8_t> packetWithTrailer;
+        Ltp::GenerateLtpHeaderPlusDataSegmentMetadata(packetWithTrailer, LTP_DATA_SEGMENT_TYPE_FLAGS::REDDATA,
+            Ltp::session_id_t(5555, 6666), Ltp::data_segment_metadata_t(7777, 0, clientServiceData.size()), NULL, 1);
+        packetWithTrailer.insert(packetWithTrailer.end(), clientServiceData.begin(), clientServiceData.end());
+        trailerExtensions.AppendSerialize(packetWithTrailer);
+        BOOST_REQUIRE(t.m_ltp.HandleReceivedChars(packetWithTrailer.data(), packetWithTrailer.size(), errorMessage));
+        BOOST_REQUIRE(t.m_ltp.IsAtBeginningState());
+        BOOST_REQUIRE_EQUAL(t.m_numInPlaceCallbacks, 0);
+        BOOST_REQUIRE_EQUAL(t.m_numBufferedCallbacks, 1);
+        BOOST_REQUIRE(t.m_receivedData == clientServiceData);
+    }
+    BOOST_REQUIRE_EQUAL(errorMessage.size(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(LtpDataSegmentInPlaceBenchmarkTestCase, *boost::unit_test::disabled())
+{
+    //reassemble a 256MB red part from 60000 byte data segments (one per datagram):
+    //client service data buffered by the rx state machine vs handed over in place
+    struct Benchmark {
+        Ltp m_ltp;
+        std::vector<uint8_t> m_redPart;
+
+        void DataSegmentCallback(uint8_t segmentTypeFlags, const Ltp::session_id_t & sessionId,
+            std::vector<uint8_t> & clientServiceDataVec, const Ltp::data_segment_metadata_t & dataSegmentMetadata,
+            Ltp::ltp_extensions_t & headerExtensions, Ltp::ltp_extensions_t & trailerExtensions)
+        {
+            memcpy(m_redPart.data() + dataSegmentMetadata.offset, clientServiceDataVec.data(), dataSegmentMetadata.length);
+        }
+        void DataSegmentInPlaceCallback(uint8_t segmentTypeFlags, const Ltp::session_id_t & sessionId,
+            const uint8_t * clientServiceData, const Ltp::data_segment_metadata_t & dataSegmentMetadata,
+            Ltp::ltp_extensions_t & headerExtensions, Ltp::ltp_extensions_t & trailerExtensions)
+        {
+            memcpy(m_redPart.data() + dataSegmentMetadata.offset, clientServiceData, dataSegmentMetadata.length);
+        }
+    };
+    const uint64_t SEGMENT_SIZE = 60000;
+    const uint64_t NUM_SEGMENTS = 4474; //~256MB
+    const uint64_t NUM_DATAGRAMS_IN_RING = 64; //more than fits in the cache, like a receive ring
+    const std::size_t MAX_HEADER_SIZE = 64;
+    //each datagram buffer holds its client service data at MAX_HEADER_SIZE and gets its header written right in front of it
+    std::vector<std::vector<uint8_t> > datagramRing(NUM_DATAGRAMS_IN_RING);
+    for (uint64_t i = 0; i < NUM_DATAGRAMS_IN_RING; ++i) {
+        datagramRing[i].assign(MAX_HEADER_SIZE + SEGMENT_SIZE, static_cast<uint8_t>(i));
+    }
+    std::vector<uint8_t> header;
+
+    double gigabytesPerSecond[2];
+    for (unsigned int inPlace = 0; inPlace < 2; ++inPlace) {
+        Benchmark b;
+        b.m_redPart.resize(NUM_SEGMENTS * SEGMENT_SIZE);
+        b.m_ltp.SetDataSegmentContentsReadCallback(boost::bind(&Benchmark::DataSegmentCallback, &b,
+            boost::placeholders::_1, boost::placeholders::_2, boost::placeholders::_3,
+            boost::placeholders::_4, boost::placeholders::_5, boost::placeholders::_6));
+        if (inPlace) {
+            b.m_ltp.SetDataSegmentContentsReadInPlaceCallback(boost::bind(&Benchmark::DataSegmentInPlaceCallback, &b,
+                boost::placeholders::_1, boost::placeholders::_2, boost::placeholders::_3,
+                boost::placeholders::_4, boost::placeholders::_5, boost::placeholders::_6));
+        }
+        std::string errorMessage;
+        const boost::posix_time::ptime startTime = boost::posix_time::microsec_clock::universal_time();
+        for (uint64_t i = 0; i < NUM_SEGMENTS; ++i) {
+            Ltp::GenerateLtpHeaderPlusDataSegmentMetadata(header, LTP_DATA_SEGMENT_TYPE_FLAGS::REDDATA,
+                Ltp::session_id_t(5555, 6666), Ltp::data_segment_metadata_t(1, i * SEGMENT_SIZE, SEGMENT_SIZE));
+            uint8_t * const datagramPtr = datagramRing[i % NUM_DATAGRAMS_IN_RING].data() + (MAX_HEADER_SIZE - header.size());
+            memcpy(datagramPtr, header.data(), header.size());
+            BOOST_REQUIRE(b.m_ltp.HandleReceivedChars(datagramPtr, header.size() + SEGMENT_SIZE, errorMessage));
+        }
+        const double seconds = (boost::posix_time::microsec_clock::universal_time() - startTime).total_microseconds() * 1e-6;
+        for (uint64_t i = 0; i < NUM_SEGMENTS; ++i) {
+            BOOST_REQUIRE_EQUAL(b.m_redPart[i * SEGMENT_SIZE], static_cast<uint8_t>(i % NUM_DATAGRAMS_IN_RING));
+            BOOST_REQUIRE_EQUAL(b.m_redPart[((i + 1) * SEGMENT_SIZE) - 1], static_cast<uint8_t>(i % NUM_DATAGRAMS_IN_RING));
+        }
+        gigabytesPerSecond[inPlace] = (seconds > 0) ? ((NUM_SEGMENTS * SEGMENT_SIZE) / seconds) * 1e-9 : 0;
+        std::cout << (inPlace ? "in place: " : "buffered: ") << (NUM_SEGMENTS * SEGMENT_SIZE) << " red bytes reassembled in "
+            << seconds << " seconds (" << gigabytesPerSecond[inPlace] << " GB/s)" << std::endl;
+    }
+    std::cout << "LTP red part reassembly speedup in place: " << ((gigabytesPerSecond[0] > 0) ? (gigabytesPerSecond[1] / gigabytesPerSecond[0]) : 0) << "x" << std::endl;
+}
+
+BOOST_AUTO_TEST_CASE(LtpDatagramTestCase)
+{
+    //every callback is recorded as a string so the datagram decoder and the state machine can be compared
+    struct Recorder {
+        Ltp m_ltp;
+        std::vector<std::string> m_callbacks;
+
+        Recorder(const bool useInPlaceCallback) {
+            m_ltp.SetDataSegmentContentsReadCallback(boost::bind(&Recorder::DataSegmentCallback, this,
+                boost::placeholders::_1, boost::placeholders::_2, boost::placeholders::_3,
+                boost::placeholders::_4, boost::placeholders::_5, boost::placeholders::_6));
+            if (useInPlaceCallback) {
+                m_ltp.SetDataSegmentContentsReadInPlaceCallback(boost::bind(&Recorder::DataSegmentInPlaceCallback, this,
+                    boost::placeholders::_1, boost::placeholders::_2, boost::placeholders::_3,
+                    boost::placeholders::_4, boost::placeholders::_5, boost::placeholders::_6));
+            }
+            m_ltp.SetReportSegmentContentsReadCallback(boost::bind(&Recorder::ReportSegmentCallback, this,
+                boost::placeholders::_1, boost::placeholders::_2, boost::placeholders::_3, boost::placeholders::_4));
+            m_ltp.SetReportAcknowledgementSegmentContentsReadCallback(boost::bind(&Recorder::ReportAcknowledgementSegmentCallback, this,
+                boost::placeholders::_1, boost::placeholders::_2, boost::placeholders::_3, boost::placeholders::_4));
+            m_ltp.SetCancelSegmentContentsReadCallback(boost::bind(&Recorder::CancelSegmentCallback, this,
+                boost::placeholders::_1, boost::placeholders::_2, boost::placeholders::_3, boost::placeholders::_4, boost::placeholders::_5));
+            m_ltp.SetCancelAcknowledgementSegmentContentsReadCallback(boost::bind(&Recorder::CancelAcknowledgementSegmentCallback, this,
+                boost::placeholders::_1, boost::placeholders::_2, boost::placeholders::_3, boost::placeholders::_4));
+        }
+        static std::string ToString(const Ltp::session_id_t & sessionId, Ltp::ltp_extensions_t & headerExtensions, Ltp::ltp_extensions_t & trailerExtensions) {
+            std::vector<uint8_t> h;
+            std::vector<uint8_t> t;
+            headerExtensions.AppendSerialize(h);
+            trailerExtensions.AppendSerialize(t);
+            return boost::lexical_cast<std::string>(sessionId) + " h" + std::string(h.begin(), h.end()) + " t" + std::string(t.begin(), t.end());
+        }
+        void DataSegment(uint8_t segmentTypeFlags, const Ltp::session_id_t & sessionId, const uint8_t * clientServiceData,
+            const Ltp::data_segment_metadata_t & dataSegmentMetadata, Ltp::ltp_extensions_t & headerExtensions, Ltp::ltp_extensions_t & trailerExtensions)
+        {
+            std::ostringstream os;
+            os << "DS " << (int)segmentTypeFlags << " " << dataSegmentMetadata.clientServiceId << " " << dataSegmentMetadata.offset << " " << dataSegmentMetadata.length;
+            if (dataSegmentMetadata.checkpointSerialNumber) {
+                os << " cp " << *dataSegmentMetadata.checkpointSerialNumber << " rp " << *dataSegmentMetadata.reportSerialNumber;
+            }
+            os << " " << std::string(clientServiceData, clientServiceData + dataSegmentMetadata.length) << " " << ToString(sessionId, headerExtensions, trailerExtensions);
+            m_callbacks.push_back(os.str());
+        }
+        void DataSegmentCallback(uint8_t segmentTypeFlags, const Ltp::session_id_t & sessionId,
+            std::vector<uint8_t> & clientServiceDataVec, const Ltp::data_segment_metadata_t & dataSegmentMetadata,
+            Ltp::ltp_extensions_t & headerExtensions, Ltp::ltp_extensions_t & trailerExtensions)
+        {
+            BOOST_REQUIRE_EQUAL(dataSegmentMetadata.length, clientServiceDataVec.size());
+            DataSegment(segmentTypeFlags, sessionId, clientServiceDataVec.data(), dataSegmentMetadata, headerExtensions, trailerExtensions);
+        }
+        void DataSegmentInPlaceCallback(uint8_t segmentTypeFlags, const Ltp::session_id_t & sessionId,
+            const uint8_t * clientServiceData, const Ltp::data_segment_metadata_t & dataSegmentMetadata,
+            Ltp::ltp_extensions_t & headerExtensions, Ltp::ltp_extensions_t & trailerExtensions)
+        {
+            DataSegment(segmentTypeFlags, sessionId, clientServiceData, dataSegmentMetadata, headerExtensions, trailerExtensions);
+        }
+        void ReportSegmentCallback(const Ltp::session_id_t & sessionId, const Ltp::report_segment_t & reportSegment,
+            Ltp::ltp_extensions_t & headerExtensions, Ltp::ltp_extensions_t & trailerExtensions)
+        {
+            std::ostringstream os;
+            os << "RS " << reportSegment << " " << ToString(sessionId, headerExtensions, trailerExtensions);
+            m_callbacks.push_back(os.str());
+        }
+        void ReportAcknowledgementSegmentCallback(const Ltp::session_id_t & sessionId, uint64_t reportSerialNumberBeingAcknowledged,
+            Ltp::ltp_extensions_t & headerExtensions, Ltp::ltp_extensions_t & trailerExtensions)
+        {
+            m_callbacks.push_back("RA " + boost::lexical_cast<std::string>(reportSerialNumberBeingAcknowledged) + " " + ToString(sessionId, headerExtensions, trailerExtensions));
+        }
+        void CancelSegmentCallback(const Ltp::session_id_t & sessionId, CANCEL_SEGMENT_REASON_CODES reasonCode, bool isFromSender,
+            Ltp::ltp_extensions_t & headerExtensions, Ltp::ltp_extensions_t & trailerExtensions)
+        {
+            m_callbacks.push_back("CS " + boost::lexical_cast<std::string>((int)reasonCode) + " " + boost::lexical_cast<std::string>(isFromSender) + " " + ToString(sessionId, headerExtensions, trailerExtensions));
+        }
+        void CancelAcknowledgementSegmentCallback(const Ltp::session_id_t & sessionId, bool isToSender,
+            Ltp::ltp_extensions_t & headerExtensions, Ltp::ltp_extensions_t & trailerExtensions)
+        {
+            m_callbacks.push_back("CA " + boost::lexical_cast<std::string>(isToSender) + " " + ToString(sessionId, headerExtensions, trailerExtensions));
+        }
+    };
+
+    Ltp::ltp_extensions_t noExtensions;
+    Ltp::ltp_extensions_t extensions;
+    {
+        Ltp::ltp_extension_t e;
+        e.tag = 0x11;
+        e.valueVec = { 'v', 'a', 'l' };
+        extensions.extensionsVec.push_back(e);
+        e.tag = 0x22;
+        e.valueVec.clear();
+        extensions.extensionsVec.push_back(e);
+    }
+    const Ltp::session_id_t sessionId(300, 0x123456789aULL); //multi byte sdnvs
+    std::vector<std::vector<uint8_t> > segments;
+    for (unsigned int withExtensions = 0; withExtensions < 2; ++withExtensions) {
+        Ltp::ltp_extensions_t & exts = (withExtensions) ? extensions : noExtensions;
+        Ltp::ltp_extensions_t * const extsPtr = (withExtensions) ? &extensions : NULL;
+        const std::string clientServiceData("The quick brown fox jumps over the lazy dog!");
+        uint64_t checkpointSerialNumber = 5000;
+        uint64_t reportSerialNumber = 0;
+        for (unsigned int flags = 0; flags <= 7; ++flags) {
+            if ((flags == 5) || (flags == 6)) {
+                continue;
+            }
+            const bool isCheckpoint = ((flags >= 1) && (flags <= 3));
+            std::vector<uint8_t> segment;
+            Ltp::GenerateLtpHeaderPlusDataSegmentMetadata(segment, static_cast<LTP_DATA_SEGMENT_TYPE_FLAGS>(flags), sessionId,
+                Ltp::data_segment_metadata_t(1, 1000000 * flags, clientServiceData.size(), (isCheckpoint) ? &checkpointSerialNumber : NULL, (isCheckpoint) ? &reportSerialNumber : NULL),
+                extsPtr, static_cast<uint8_t>(exts.extensionsVec.size()));
+            segment.insert(segment.end(), clientServiceData.begin(), clientServiceData.end());
+            exts.AppendSerialize(segment);
+            segments.push_back(segment);
+        }
+        for (unsigned int numClaims = 1; numClaims <= 40; numClaims += 13) {
+            Ltp::report_segment_t rs;
+            rs.reportSerialNumber = 0x7fffffffffffULL;
+            rs.checkpointSerialNumber = 5000;
+            rs.lowerBound = 1000;
+            rs.upperBound = 1000 + (numClaims * 3000);
+            for (unsigned int i = 0; i < numClaims; ++i) {
+                rs.receptionClaims.push_back(Ltp::reception_claim_t(i * 3000, 1 + (i * 100)));
+            }
+            std::vector<uint8_t> segment;
+            Ltp::GenerateReportSegmentLtpPacket(segment, sessionId, rs, extsPtr, extsPtr);
+            segments.push_back(segment);
+        }
+        std::vector<uint8_t> segment;
+        Ltp::GenerateReportAcknowledgementSegmentLtpPacket(segment, sessionId, 0x7fffffffffffULL, extsPtr, extsPtr);
+        segments.push_back(segment);
+        Ltp::GenerateCancelSegmentLtpPacket(segment, sessionId, CANCEL_SEGMENT_REASON_CODES::MISCOLORED, true, extsPtr, extsPtr);
+        segments.push_back(segment);
+        Ltp::GenerateCancelSegmentLtpPacket(segment, sessionId, CANCEL_SEGMENT_REASON_CODES::RLEXC, false, extsPtr, extsPtr);
+        segments.push_back(segment);
+        Ltp::GenerateCancelAcknowledgementSegmentLtpPacket(segment, sessionId, true, extsPtr, extsPtr);
+        segments.push_back(segment);
+        Ltp::GenerateCancelAcknowledgementSegmentLtpPacket(segment, sessionId, false, extsPtr, extsPtr);
+        segments.push_back(segment);
+    }
+
+    //one segment per datagram, then all of them in one buffer: same callbacks as the state machine fed a byte at a time
+    std::vector<uint8_t> allSegments;
+    for (unsigned int useInPlaceCallback = 0; useInPlaceCallback < 2; ++useInPlaceCallback) {
+        Recorder byteAtATime(false);
+        Recorder datagram(useInPlaceCallback != 0);
+        Recorder allInOne(useInPlaceCallback != 0);
+        std::string errorMessage;
+        for (std::size_t i = 0; i < segments.size(); ++i) {
+            for (std::size_t j = 0; j < segments[i].size(); ++j) {
+                byteAtATime.m_ltp.HandleReceivedChar(segments[i][j], errorMessage);
+            }
+            BOOST_REQUIRE(datagram.m_ltp.HandleReceivedDatagram(segments[i].data(), segments[i].size(), errorMessage));
+            BOOST_REQUIRE(datagram.m_ltp.IsAtBeginningState());
+            if (useInPlaceCallback == 0) {
+                allSegments.insert(allSegments.end(), segments[i].begin(), segments[i].end());
+            }
+        }
+        BOOST_REQUIRE(allInOne.m_ltp.HandleReceivedDatagram(allSegments.data(), allSegments.size(), errorMessage));
+        BOOST_REQUIRE_EQUAL(errorMessage.size(), 0);
+        BOOST_REQUIRE_EQUAL(byteAtATime.m_callbacks.size(), segments.size());
+        BOOST_REQUIRE(datagram.m_callbacks == byteAtATime.m_callbacks);
+        BOOST_REQUIRE(allInOne.m_callbacks == byteAtATime.m_callbacks);
+    }
+
+    //a segment split across calls (streamed) goes through the state machine
+    {
+        Recorder byteAtATime(false);
+        Recorder datagram(true);
+        std::string errorMessage;
+        for (std::size_t j = 0; j < allSegments.size(); ++j) {
+            byteAtATime.m_ltp.HandleReceivedChar(allSegments[j], errorMessage);
+        }
+        for (std::size_t j = 0; j < allSegments.size(); j += 7) {
+            BOOST_REQUIRE(datagram.m_ltp.HandleReceivedDatagram(allSegments.data() + j, std::min<std::size_t>(7, allSegments.size() - j), errorMessage));
+        }
+        BOOST_REQUIRE(datagram.m_ltp.IsAtBeginningState());
+        BOOST_REQUIRE(datagram.m_callbacks == byteAtATime.m_callbacks);
+    }
+
+    //malformed segments are reported by the state machine, without any callback
+    {
+        Recorder datagram(true);
+        std::string errorMessage;
+        std::vector<uint8_t> badVersion(segments[0]);
+        badVersion[0] |= 0x10;
+        BOOST_REQUIRE(!datagram.m_ltp.HandleReceivedDatagram(badVersion.data(), badVersion.size(), errorMessage));
+        BOOST_REQUIRE_EQUAL(errorMessage, "error ltp version not 0.. got 1");
+        datagram.m_ltp.InitRx();
+
+        std::vector<uint8_t> badFlags(segments[0]);
+        badFlags[0] = 5;
+        errorMessage.clear();
+        BOOST_REQUIRE(!datagram.m_ltp.HandleReceivedDatagram(badFlags.data(), badFlags.size(), errorMessage));
+        BOOST_REQUIRE(!errorMessage.empty());
+        datagram.m_ltp.InitRx();
+
+        //an 11 byte session originator engine id sdnv
+        std::vector<uint8_t> badSdnv(1, 0);
+        badSdnv.insert(badSdnv.end(), 10, 0x81);
+        badSdnv.insert(badSdnv.end(), segments[0].begin() + 1, segments[0].end());
+        errorMessage.clear();
+        BOOST_REQUIRE(!datagram.m_ltp.HandleReceivedDatagram(badSdnv.data(), badSdnv.size(), errorMessage));
+        BOOST_REQUIRE(!errorMessage.empty());
+        datagram.m_ltp.InitRx();
+        BOOST_REQUIRE(datagram.m_callbacks.empty());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(LtpDatagramReportSegmentBenchmarkTestCase, *boost::unit_test::disabled())
+{
+    //a sender processing report segments of 20 reception claims each (one per datagram)
+    struct Benchmark {
+        uint64_t m_numReportSegments;
+        uint64_t m_claimLengthSum;
+        void ReportSegmentCallback(const Ltp::session_id_t & sessionId, const Ltp::report_segment_t & reportSegment,
+            Ltp::ltp_extensions_t & headerExtensions, Ltp::ltp_extensions_t & trailerExtensions)
+        {
+            ++m_numReportSegments;
+            for (std::size_t i = 0; i < reportSegment.receptionClaims.size(); ++i) {
+                m_claimLengthSum += reportSegment.receptionClaims[i].length;
+            }
+        }
+    };
+    const uint64_t NUM_REPORT_SEGMENTS = 500000;
+    Ltp::report_segment_t rs;
+    rs.reportSerialNumber = 0x123456789ULL;
+    rs.checkpointSerialNumber = 0x987654321ULL;
+    rs.lowerBound = 50000000;
+    rs.upperBound = 100000000;
+    for (unsigned int i = 0; i < 20; ++i) {
+        rs.receptionClaims.push_back(Ltp::reception_claim_t(i * 2500000, 1000000 + i));
+    }
+    std::vector<uint8_t> datagram;
+    Ltp::GenerateReportSegmentLtpPacket(datagram, Ltp::session_id_t(0x12345, 0x6789abcdefULL), rs);
+
+    double secondsPerMethod[2];
+    for (unsigned int useDatagramDecoder = 0; useDatagramDecoder < 2; ++useDatagramDecoder) {
+        Benchmark b;
+        b.m_numReportSegments = 0;
+        b.m_claimLengthSum = 0;
+        Ltp ltp;
+        ltp.SetReportSegmentContentsReadCallback(boost::bind(&Benchmark::ReportSegmentCallback, &b,
+            boost::placeholders::_1, boost::placeholders::_2, boost::placeholders::_3, boost::placeholders::_4));
+        std::string errorMessage;
+        const boost::posix_time::ptime startTime = boost::posix_time::microsec_clock::universal_time();
+        for (uint64_t i = 0; i < NUM_REPORT_SEGMENTS; ++i) {
+            if (useDatagramDecoder) {
+                ltp.HandleReceivedDatagram(datagram.data(), datagram.size(), errorMessage);
+            }
+            else {
+                ltp.HandleReceivedChars(datagram.data(), datagram.size(), errorMessage);
+            }
+        }
+        secondsPerMethod[useDatagramDecoder] = (boost::posix_time::microsec_clock::universal_time() - startTime).total_microseconds() * 1e-6;
+        BOOST_REQUIRE_EQUAL(b.m_numReportSegments, NUM_REPORT_SEGMENTS);
+        BOOST_REQUIRE_EQUAL(b.m_claimLengthSum, NUM_REPORT_SEGMENTS * ((20 * 1000000) + 190));
+        BOOST_REQUIRE(errorMessage.empty());
+        std::cout << ((useDatagramDecoder) ? "HandleReceivedDatagram: " : "HandleReceivedChars:    ") << NUM_REPORT_SEGMENTS << " report segments ("
+            << datagram.size() << " bytes each) in " << secondsPerMethod[useDatagramDecoder] << " seconds" << std::endl;
+    }
+    std::cout << "LTP report segment decode speedup with HandleReceivedDatagram: "
+        << ((secondsPerMethod[1] > 0) ? (secondsPerMethod[0] / secondsPerMethod[1]) : 0) << "x" << std::endl;
+}
@@ -1,6 +1,8 @@
 #include <boost/test/unit_test.hpp>
 #include "LtpFragmentSet.h"
 #include <boost/bind/bind.hpp>
+#include <algorithm>
+#include <boost/date_time/posix_time/posix_time.hpp>
 
 BOOST_AUTO_TEST_CASE(LtpFragmentSetTestCase)
 {
@@ -590,3 +592,201 @@ BOOST_AUTO_TEST_CASE(LtpFragmentSetTestCase)
         }
     }
 }
+
+static bool FragmentVecEqualsSet(const LtpFragmentSet::data_fragment_vec_t & fragmentVec, const std::set<LtpFragmentSet::data_fragment_t> & fragmentSet) {
+    return (fragmentVec.size() == fragmentSet.size()) && std::equal(fragmentVec.cbegin(), fragmentVec.cend(), fragmentSet.cbegin());
+}
+
+static std::set<LtpFragmentSet::data_fragment_t> FragmentSetFromBitmap(const std::vector<bool> & indexCovered) {
+    std::set<LtpFragmentSet::data_fragment_t> fragmentSet;
+    for (uint64_t i = 0; i < indexCovered.size(); ++i) {
+        if (indexCovered[i]) {
+            const uint64_t beginIndex = i;
+            while (((i + 1) < indexCovered.size()) && indexCovered[i + 1]) {
+                ++i;
+            }
+            fragmentSet.emplace_hint(fragmentSet.end(), beginIndex, i);
+        }
+    }
+    return fragmentSet;
+}
+
+BOOST_AUTO_TEST_CASE(LtpFragmentSetVecTestCase)
+{
+    typedef LtpFragmentSet::data_fragment_t df;
+    typedef LtpFragmentSet::data_fragment_vec_t dfvec;
+    typedef Ltp::report_segment_t rs;
+    typedef Ltp::reception_claim_t rc;
+
+    //insert coalesces same as the set
+    {
+        dfvec fragmentVec;
+        LtpFragmentSet::InsertFragment(fragmentVec, df(100, 200));
+        LtpFragmentSet::InsertFragment(fragmentVec, df(300, 400));
+        LtpFragmentSet::InsertFragment(fragmentVec, df(0, 10));
+        BOOST_REQUIRE(fragmentVec == dfvec({ df(0,10), df(100,200), df(300,400) }));
+        LtpFragmentSet::InsertFragment(fragmentVec, df(150, 250));
+        BOOST_REQUIRE(fragmentVec == dfvec({ df(0,10), df(100,250), df(300,400) }));
+        LtpFragmentSet::InsertFragment(fragmentVec, df(251, 299)); //abuts both
+        BOOST_REQUIRE(fragmentVec == dfvec({ df(0,10), df(100,400) }));
+        LtpFragmentSet::InsertFragment(fragmentVec, df(401, 500)); //in order abut
+        BOOST_REQUIRE(fragmentVec == dfvec({ df(0,10), df(100,500) }));
+        LtpFragmentSet::InsertFragment(fragmentVec, df(5, 1000)); //swallow all
+        BOOST_REQUIRE(fragmentVec == dfvec({ df(0,1000) }));
+        BOOST_REQUIRE(LtpFragmentSet::ContainsFragmentEntirely(fragmentVec, df(0, 1000)));
+        BOOST_REQUIRE(!LtpFragmentSet::ContainsFragmentEntirely(fragmentVec, df(0, 1001)));
+    }
+
+    //remove splits and trims same as the set
+    {
+        dfvec fragmentVec({ df(0,100), df(200,300), df(400,500) });
+        LtpFragmentSet::RemoveFragment(fragmentVec, df(50, 60)); //split
+        BOOST_REQUIRE(fragmentVec == dfvec({ df(0,49), df(61,100), df(200,300), df(400,500) }));
+        LtpFragmentSet::RemoveFragment(fragmentVec, df(90, 450)); //trim right of first, erase middle, trim left of last
+        BOOST_REQUIRE(fragmentVec == dfvec({ df(0,49), df(61,89), df(451,500) }));
+        LtpFragmentSet::RemoveFragment(fragmentVec, df(0, 49));
+        BOOST_REQUIRE(fragmentVec == dfvec({ df(61,89), df(451,500) }));
+        LtpFragmentSet::RemoveFragment(fragmentVec, df(90, 450)); //nothing there
+        BOOST_REQUIRE(fragmentVec == dfvec({ df(61,89), df(451,500) }));
+        BOOST_REQUIRE(LtpFragmentSet::DoesNotContainFragmentEntirely(fragmentVec, df(90, 450)));
+        BOOST_REQUIRE(!LtpFragmentSet::DoesNotContainFragmentEntirely(fragmentVec, df(90, 451)));
+
+        //delete range abutting the fragment before it
+        fragmentVec = dfvec({ df(0,9), df(15,20) });
+        FragmentSet::RemoveFragment(fragmentVec, df(10, 17));
+        BOOST_REQUIRE(fragmentVec == dfvec({ df(0,9), df(18,20) }));
+    }
+
+    //randomized against the set (removals are checked against a bitmap of the covered indices, from which the set is rebuilt)
+    {
+        uint64_t lcg = 12345;
+        std::set<df> fragmentSet;
+        dfvec fragmentVec;
+        std::vector<bool> indexCovered(10050, false);
+        for (unsigned int i = 0; i < 20000; ++i) {
+            lcg = (lcg * 6364136223846793005ULL) + 1442695040888963407ULL;
+            const uint64_t begin = (lcg >> 33) % 10000;
+            const uint64_t end = begin + ((lcg >> 20) % 50);
+            const df key(begin, end);
+            const unsigned int op = static_cast<unsigned int>((lcg >> 10) % 4);
+            if (op == 0) {
+                std::fill(indexCovered.begin() + begin, indexCovered.begin() + (end + 1), false);
+                fragmentSet = FragmentSetFromBitmap(indexCovered);
+                LtpFragmentSet::RemoveFragment(fragmentVec, key);
+            }
+            else {
+                std::fill(indexCovered.begin() + begin, indexCovered.begin() + (end + 1), true);
+                LtpFragmentSet::InsertFragment(fragmentSet, key);
+                LtpFragmentSet::InsertFragment(fragmentVec, key);
+            }
+            BOOST_REQUIRE(FragmentVecEqualsSet(fragmentVec, fragmentSet));
+            lcg = (lcg * 6364136223846793005ULL) + 1442695040888963407ULL;
+            const df query((lcg >> 33) % 10000, ((lcg >> 33) % 10000) + ((lcg >> 20) % 100));
+            BOOST_REQUIRE_EQUAL(LtpFragmentSet::ContainsFragmentEntirely(fragmentVec, query), LtpFragmentSet::ContainsFragmentEntirely(fragmentSet, query));
+            BOOST_REQUIRE_EQUAL(LtpFragmentSet::DoesNotContainFragmentEntirely(fragmentVec, query), LtpFragmentSet::DoesNotContainFragmentEntirely(fragmentSet, query));
+            if ((i % 100) == 0) {
+                rs reportSegmentFromVec;
+                rs reportSegmentFromSet;
+                const uint64_t lowerBound = (lcg >> 40) % 5000;
+                const uint64_t upperBound = lowerBound + 1 + ((lcg >> 24) % 5000);
+                BOOST_REQUIRE_EQUAL(LtpFragmentSet::PopulateReportSegment(fragmentVec, reportSegmentFromVec, lowerBound, upperBound),
+                    LtpFragmentSet::PopulateReportSegment(fragmentSet, reportSegmentFromSet, lowerBound, upperBound));
+                BOOST_REQUIRE(reportSegmentFromVec == reportSegmentFromSet);
+                BOOST_REQUIRE_EQUAL(LtpFragmentSet::PopulateReportSegment(fragmentVec, reportSegmentFromVec),
+                    LtpFragmentSet::PopulateReportSegment(fragmentSet, reportSegmentFromSet));
+                BOOST_REQUIRE(reportSegmentFromVec == reportSegmentFromSet);
+                std::set<df> needingResentSet;
+                dfvec needingResentVec;
+                LtpFragmentSet::AddReportSegmentToFragmentSetNeedingResent(needingResentSet, reportSegmentFromSet);
+                LtpFragmentSet::AddReportSegmentToFragmentSetNeedingResent(needingResentVec, reportSegmentFromVec);
+                BOOST_REQUIRE(FragmentVecEqualsSet(needingResentVec, needingResentSet));
+                dfvec fromReportSegmentVec;
+                LtpFragmentSet::AddReportSegmentToFragmentSet(fromReportSegmentVec, reportSegmentFromVec);
+                BOOST_REQUIRE(!fromReportSegmentVec.empty() || reportSegmentFromVec.receptionClaims.empty());
+            }
+        }
+    }
+
+    //report segment round trip
+    {
+        const rs reportSegment(0, 0, 6000, 0, std::vector<rc>({ rc(0,10), rc(20,10), rc(40,10) }));
+        dfvec fragmentVec;
+        LtpFragmentSet::AddReportSegmentToFragmentSet(fragmentVec, reportSegment);
+        BOOST_REQUIRE(fragmentVec == dfvec({ df(0,9), df(20,29), df(40,49) }));
+        dfvec needingResentVec;
+        LtpFragmentSet::AddReportSegmentToFragmentSetNeedingResent(needingResentVec, reportSegment);
+        BOOST_REQUIRE(needingResentVec == dfvec({ df(10,19), df(30,39), df(50,5999) }));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(LtpFragmentSetVecBenchmarkTestCase, *boost::unit_test::disabled())
+{
+    //a receiver getting a 100MB red part in 1000 byte data segments over a lossy link (10% loss, every 16th segment a checkpoint),
+    //then the sender processing the final report: std::set vs sorted vector
+    typedef LtpFragmentSet::data_fragment_t df;
+    typedef LtpFragmentSet::data_fragment_vec_t dfvec;
+    typedef Ltp::report_segment_t rs;
+    const uint64_t SEGMENT_SIZE = 1000;
+    const uint64_t NUM_SEGMENTS = 100000;
+    std::vector<bool> segmentLost(NUM_SEGMENTS);
+    uint64_t lcg = 6789;
+    for (uint64_t i = 0; i < NUM_SEGMENTS; ++i) {
+        lcg = (lcg * 6364136223846793005ULL) + 1442695040888963407ULL;
+        segmentLost[i] = (((lcg >> 33) % 10) == 0);
+    }
+
+    rs finalReportSegmentFromSet;
+    rs finalReportSegmentFromVec;
+    for (unsigned int useVec = 0; useVec < 2; ++useVec) {
+        std::set<df> fragmentSet;
+        dfvec fragmentVec;
+        rs reportSegment;
+        uint64_t numReceptionClaims = 0;
+        const boost::posix_time::ptime startTime = boost::posix_time::microsec_clock::universal_time();
+        uint64_t lowerBound = 0;
+        for (uint64_t i = 0; i < NUM_SEGMENTS; ++i) {
+            if (!segmentLost[i]) {
+                const df fragment(i * SEGMENT_SIZE, ((i + 1) * SEGMENT_SIZE) - 1);
+                if (useVec) {
+                    LtpFragmentSet::InsertFragment(fragmentVec, fragment);
+                }
+                else {
+                    LtpFragmentSet::InsertFragment(fragmentSet, fragment);
+                }
+            }
+            if ((i % 16) == 15) { //checkpoint, report on the scope since the last checkpoint
+                const uint64_t upperBound = (i + 1) * SEGMENT_SIZE;
+                if (useVec) {
+                    LtpFragmentSet::PopulateReportSegment(fragmentVec, reportSegment, lowerBound, upperBound);
+                }
+                else {
+                    LtpFragmentSet::PopulateReportSegment(fragmentSet, reportSegment, lowerBound, upperBound);
+                }
+                numReceptionClaims += reportSegment.receptionClaims.size();
+                lowerBound = upperBound;
+            }
+        }
+        const boost::posix_time::ptime receivedTime = boost::posix_time::microsec_clock::universal_time();
+        //end of red part checkpoint, report on the whole block, then the sender finds what needs resent
+        std::set<df> needingResentSet;
+        dfvec needingResentVec;
+        if (useVec) {
+            LtpFragmentSet::PopulateReportSegment(fragmentVec, finalReportSegmentFromVec, 0, NUM_SEGMENTS * SEGMENT_SIZE);
+            LtpFragmentSet::AddReportSegmentToFragmentSetNeedingResent(needingResentVec, finalReportSegmentFromVec);
+        }
+        else {
+            LtpFragmentSet::PopulateReportSegment(fragmentSet, finalReportSegmentFromSet, 0, NUM_SEGMENTS * SEGMENT_SIZE);
+            LtpFragmentSet::AddReportSegmentToFragmentSetNeedingResent(needingResentSet, finalReportSegmentFromSet);
+        }
+        const boost::posix_time::ptime reportedTime = boost::posix_time::microsec_clock::universal_time();
+        std::cout << (useVec ? "sorted vector: " : "std::set:      ")
+            << NUM_SEGMENTS << " data segments with " << numReceptionClaims << " checkpoint reception claims took "
+            << (receivedTime - startTime).total_microseconds() << " us, final report and "
+            << (useVec ? needingResentVec.size() : needingResentSet.size()) << " gaps took "
+            << (reportedTime - receivedTime).total_microseconds() << " us\n";
+        if (useVec) {
+            BOOST_REQUIRE(needingResentVec.size() > (NUM_SEGMENTS / 20));
+        }
+    }
+    BOOST_REQUIRE(finalReportSegmentFromSet == finalReportSegmentFromVec);
+}
@@ -258,3 +258,88 @@ BOOST_AUTO_TEST_CASE(LtpTimerManagerTestCase)
     t2.DoTest3();
     t2.DoTest4();
 }
+
+BOOST_AUTO_TEST_CASE(LtpTimerManagerSharedTimingWheelBenchmarkTestCase, *boost::unit_test::disabled())
+{
+    //one checkpoint timer for each of 100k sessions, every other one cancelled (as if its report segment came back),
+    //the rest left to expire: all sessions on one shared timing wheel vs each session on its own deadline_timer
+    struct Test {
+        const uint64_t NUM_SESSIONS;
+        const boost::posix_time::time_duration ONE_WAY_LIGHT_TIME;
+        const boost::posix_time::time_duration ONE_WAY_MARGIN_TIME;
+        boost::asio::io_service m_ioService;
+        std::vector<std::unique_ptr<LtpTimerManager<uint64_t> > > m_timerManagers;
+        uint64_t m_numCallbacks;
+        uint64_t m_lastSessionNumberInCallback;
+        bool m_callbacksInOrder;
+        boost::posix_time::ptime m_firstExpiryAllowedTime;
+        bool m_expiredEarly;
+
+        Test() :
+            NUM_SESSIONS(100000),
+            ONE_WAY_LIGHT_TIME(boost::posix_time::milliseconds(100)),
+            ONE_WAY_MARGIN_TIME(boost::posix_time::milliseconds(50)) {}
+
+        void LtpTimerExpiredCallback(uint64_t serialNumber, std::vector<uint8_t> & userData) {
+            //serial number is the session number
+            if ((m_numCallbacks != 0) && (serialNumber <= m_lastSessionNumberInCallback)) {
+                m_callbacksInOrder = false;
+            }
+            if (boost::posix_time::microsec_clock::universal_time() < m_firstExpiryAllowedTime) {
+                m_expiredEarly = true;
+            }
+            m_lastSessionNumberInCallback = serialNumber;
+            ++m_numCallbacks;
+        }
+
+        void DoTest(LtpTimingWheel * sharedTimingWheelPtr) {
+            m_timerManagers.clear();
+            m_timerManagers.reserve(NUM_SESSIONS);
+            m_ioService.reset();
+            m_numCallbacks = 0;
+            m_lastSessionNumberInCallback = 0;
+            m_callbacksInOrder = true;
+            m_expiredEarly = false;
+            for (uint64_t i = 0; i < NUM_SESSIONS; ++i) {
+                const LtpTimerManager<uint64_t>::LtpTimerExpiredCallback_t callback = boost::bind(&Test::LtpTimerExpiredCallback, this, boost::placeholders::_1, boost::placeholders::_2);
+                if (sharedTimingWheelPtr) {
+                    m_timerManagers.emplace_back(new LtpTimerManager<uint64_t>(*sharedTimingWheelPtr, ONE_WAY_LIGHT_TIME, ONE_WAY_MARGIN_TIME, callback));
+                }
+                else {
+                    m_timerManagers.emplace_back(new LtpTimerManager<uint64_t>(m_ioService, ONE_WAY_LIGHT_TIME, ONE_WAY_MARGIN_TIME, callback));
+                }
+            }
+            m_firstExpiryAllowedTime = boost::posix_time::microsec_clock::universal_time() + ((ONE_WAY_LIGHT_TIME * 2) + (ONE_WAY_MARGIN_TIME * 2));
+            boost::timer::cpu_timer startCancelTimer;
+            for (uint64_t i = 0; i < NUM_SESSIONS; ++i) {
+                BOOST_REQUIRE(m_timerManagers[i]->StartTimer(i));
+            }
+            for (uint64_t i = 0; i < NUM_SESSIONS; i += 2) {
+                BOOST_REQUIRE(m_timerManagers[i]->DeleteTimer(i));
+            }
+            startCancelTimer.stop();
+            boost::timer::cpu_timer runTimer;
+            m_ioService.run();
+            runTimer.stop();
+            std::cout << (sharedTimingWheelPtr ? "shared timing wheel: " : "timer per session:   ")
+                << NUM_SESSIONS << " starts + " << (NUM_SESSIONS / 2) << " cancels took " << (startCancelTimer.elapsed().wall / 1000) << " us, "
+                << (NUM_SESSIONS / 2) << " expiries took " << (runTimer.elapsed().user + runTimer.elapsed().system) / 1000 << " us cpu\n";
+
+            BOOST_REQUIRE_EQUAL(m_numCallbacks, NUM_SESSIONS / 2);
+            if (sharedTimingWheelPtr) { //separate deadline_timers don't guarantee the order
+                BOOST_REQUIRE(m_callbacksInOrder);
+            }
+            BOOST_REQUIRE(!m_expiredEarly);
+            for (uint64_t i = 0; i < NUM_SESSIONS; ++i) {
+                BOOST_REQUIRE(m_timerManagers[i]->Empty());
+            }
+        }
+    };
+
+    Test t;
+    LtpTimingWheel timingWheel(t.m_ioService, boost::posix_time::milliseconds(1));
+    t.DoTest(&timingWheel);
+    BOOST_REQUIRE(timingWheel.Empty());
+    t.DoTest(NULL);
+    t.m_timerManagers.clear();
+}
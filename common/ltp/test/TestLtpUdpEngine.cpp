@@ -1,6 +1,14 @@
 #include <boost/test/unit_test.hpp>
 #include "LtpUdpEngineManager.h"
 #include <boost/bind/bind.hpp>
+#include <boost/atomic.hpp>
+#ifdef LTP_UDP_ENGINE_MANAGER_SUPPORTS_RECVMMSG
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#endif
 
 BOOST_AUTO_TEST_CASE(LtpUdpEngineTestCase, *boost::unit_test::enabled())
 {
@@ -71,7 +79,7 @@ BOOST_AUTO_TEST_CASE(LtpUdpEngineTestCase, *boost::unit_test::enabled())
             ltpUdpEngineDestPtr = ltpUdpEngineManagerDestPtr->GetLtpUdpEnginePtrByRemoteEngineId(EXPECTED_SESSION_ORIGINATOR_ENGINE_ID, true); //sessionOriginatorEngineId is the remote engine id in the case of an induct
             if (ltpUdpEngineDestPtr == NULL) {
                 ltpUdpEngineManagerDestPtr->AddLtpUdpEngine(ENGINE_ID_DEST, EXPECTED_SESSION_ORIGINATOR_ENGINE_ID, true, 1, UINT64_MAX, ONE_WAY_LIGHT_TIME, ONE_WAY_MARGIN_TIME, //1=> MTU NOT USED AT THIS TIME, UINT64_MAX=> unlimited report segment size
-                    "localhost", BOUND_UDP_PORT_SRC, 100, 0, 10000000, 0, 5, false, 0);
+                    "localhost", BOUND_UDP_PORT_SRC, 100, 0, 10000000, 0, 5, false, 0, 1);
                 ltpUdpEngineDestPtr = ltpUdpEngineManagerDestPtr->GetLtpUdpEnginePtrByRemoteEngineId(EXPECTED_SESSION_ORIGINATOR_ENGINE_ID, true);
             }
             ltpUdpEngineDestPtr->SetSessionStartCallback(boost::bind(&Test::SessionStartReceiverCallback, this, boost::placeholders::_1));
@@ -84,7 +92,7 @@ BOOST_AUTO_TEST_CASE(LtpUdpEngineTestCase, *boost::unit_test::enabled())
             ltpUdpEngineSrcPtr = ltpUdpEngineManagerSrcPtr->GetLtpUdpEnginePtrByRemoteEngineId(ENGINE_ID_DEST, false);
             if (ltpUdpEngineSrcPtr == NULL) {
                 ltpUdpEngineManagerSrcPtr->AddLtpUdpEngine(ENGINE_ID_SRC, ENGINE_ID_DEST, false, 1, UINT64_MAX, ONE_WAY_LIGHT_TIME, ONE_WAY_MARGIN_TIME, //1=> MTU NOT USED AT THIS TIME, UINT64_MAX=> unlimited report segment size
-                    "localhost", BOUND_UDP_PORT_DEST, 100, 0, 0, 0, 5, false, 0);
+                    "localhost", BOUND_UDP_PORT_DEST, 100, 0, 0, 0, 5, false, 0, 1);
                 ltpUdpEngineSrcPtr = ltpUdpEngineManagerSrcPtr->GetLtpUdpEnginePtrByRemoteEngineId(ENGINE_ID_DEST, false);
             }
 
@@ -879,7 +887,8 @@ BOOST_AUTO_TEST_CASE(LtpUdpEngineTestCase, *boost::unit_test::enabled())
             tReq->userDataPtr = myUserData; //keep a copy
             ltpUdpEngineSrcPtr->TransmissionRequest_ThreadSafe(std::move(tReq));
             for (unsigned int i = 0; i < 10; ++i) {
-                if (numInitialTransmissionCompletedCallbacks) {
+                //initial transmission completes when the last segment is dequeued, which with batched sends can be before the receiver has seen the first one
+                if (numInitialTransmissionCompletedCallbacks && numSessionStartReceiverCallbacks) {
                     break;
                 }
                 cv.timed_wait(cvLock, boost::posix_time::milliseconds(250));
@@ -1042,3 +1051,373 @@ BOOST_AUTO_TEST_CASE(LtpUdpEngineTestCase, *boost::unit_test::enabled())
     t.DoTestSenderCancelSession();
     t.DoTestDropOddDataSegmentWithRsMtu();
 }
+
+#ifdef LTP_UDP_ENGINE_MANAGER_SUPPORTS_RECVMMSG //the benchmark compares against the recvmmsg path and forks the sender
+//Loopback receive benchmark: a child process blasts green data segments of one session at an induct engine,
+//once with the single datagram receive path and once with the recvmmsg batched path.
+//Since the sender runs in another process, the cpu time of this process is that of the receiving manager and engine threads.
+BOOST_AUTO_TEST_CASE(LtpUdpEngineReceiveBenchmarkTestCase, *boost::unit_test::disabled())
+{
+    struct Benchmark {
+        boost::atomic<uint64_t> numGreenSegmentsReceived;
+
+        void GreenPartSegmentArrivalCallback(const Ltp::session_id_t & sessionId, std::vector<uint8_t> & movableClientServiceDataVec, uint64_t offsetStartOfBlock, uint64_t clientServiceId, bool isEndOfBlock) {
+            numGreenSegmentsReceived.fetch_add(1, boost::memory_order_relaxed);
+        }
+
+        static double GetProcessCpuSeconds() {
+            struct rusage usage;
+            getrusage(RUSAGE_SELF, &usage);
+            return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) + ((usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1e-6);
+        }
+
+        //returns receiver cpu microseconds per segment received
+        double Run(const bool useRecvmmsg, const uint16_t boundUdpPort, const uint64_t remoteEngineId) {
+            static const uint64_t NUM_SEGMENTS = 200000;
+            static const uint64_t SEGMENT_DATA_SIZE = 100;
+            numGreenSegmentsReceived = 0;
+            LtpUdpEngineManager::SetUseRecvmmsgForNewInstances(useRecvmmsg);
+            std::shared_ptr<LtpUdpEngineManager> managerPtr = LtpUdpEngineManager::GetOrCreateInstance(boundUdpPort, false);
+            BOOST_REQUIRE(managerPtr);
+            BOOST_REQUIRE(managerPtr->AddLtpUdpEngine(1, remoteEngineId, true, 1, UINT64_MAX, boost::posix_time::milliseconds(250), boost::posix_time::milliseconds(250),
+                "localhost", 1, 1000, 0, 10000000, 0, 5, false, 0, 1));
+            LtpUdpEngine * const enginePtr = managerPtr->GetLtpUdpEnginePtrByRemoteEngineId(remoteEngineId, true);
+            BOOST_REQUIRE(enginePtr);
+            enginePtr->SetGreenPartSegmentArrivalCallback(boost::bind(&Benchmark::GreenPartSegmentArrivalCallback, this, boost::placeholders::_1, boost::placeholders::_2,
+                boost::placeholders::_3, boost::placeholders::_4, boost::placeholders::_5));
+            BOOST_REQUIRE(managerPtr->StartIfNotAlreadyRunning());
+
+            const std::vector<uint8_t> segmentData(SEGMENT_DATA_SIZE, 'G');
+            const Ltp::session_id_t sessionId(remoteEngineId, 12345);
+            std::vector<std::vector<uint8_t> > datagrams(NUM_SEGMENTS);
+            for (uint64_t i = 0; i < NUM_SEGMENTS; ++i) {
+                Ltp::GenerateLtpHeaderPlusDataSegmentMetadata(datagrams[i], LTP_DATA_SEGMENT_TYPE_FLAGS::GREENDATA, sessionId,
+                    Ltp::data_segment_metadata_t(1, i * SEGMENT_DATA_SIZE, SEGMENT_DATA_SIZE));
+                datagrams[i].insert(datagrams[i].end(), segmentData.begin(), segmentData.end());
+            }
+            struct sockaddr_in destAddress;
+            memset(&destAddress, 0, sizeof(destAddress));
+            destAddress.sin_family = AF_INET;
+            destAddress.sin_port = htons(boundUdpPort);
+            destAddress.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+            const double startCpuSeconds = GetProcessCpuSeconds();
+            const boost::posix_time::ptime startTime = boost::posix_time::microsec_clock::universal_time();
+            const pid_t senderPid = fork();
+            BOOST_REQUIRE_GE(senderPid, 0);
+            if (senderPid == 0) { //sender (child) process, only system calls from here on
+                const int senderSocket = socket(AF_INET, SOCK_DGRAM, 0);
+                for (uint64_t i = 0; i < NUM_SEGMENTS; ++i) {
+                    sendto(senderSocket, datagrams[i].data(), datagrams[i].size(), 0, (const struct sockaddr *)&destAddress, sizeof(destAddress));
+                }
+                _exit(0);
+            }
+            //wait until no more segments arrive (segments the receiver could not keep up with were dropped by the kernel)
+            uint64_t lastCount = 0;
+            boost::posix_time::ptime lastProgressTime = boost::posix_time::microsec_clock::universal_time();
+            while ((lastCount < NUM_SEGMENTS) && ((boost::posix_time::microsec_clock::universal_time() - lastProgressTime) < boost::posix_time::milliseconds(500))) {
+                boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+                const uint64_t count = numGreenSegmentsReceived.load(boost::memory_order_relaxed);
+                if (count != lastCount) {
+                    lastCount = count;
+                    lastProgressTime = boost::posix_time::microsec_clock::universal_time();
+                }
+            }
+            const double cpuSeconds = GetProcessCpuSeconds() - startCpuSeconds;
+            int senderStatus;
+            waitpid(senderPid, &senderStatus, 0);
+            const double seconds = (lastProgressTime - startTime).total_microseconds() * 1e-6;
+            const double cpuMicrosecondsPerSegment = (lastCount) ? ((cpuSeconds * 1e6) / lastCount) : 0;
+            std::cout << ((useRecvmmsg) ? "recvmmsg" : "async_receive_from") << ": received " << lastCount << " of " << NUM_SEGMENTS
+                << " green segments in " << seconds << " seconds (" << ((seconds > 0) ? (lastCount / seconds) : 0) << " segments/s) using "
+                << cpuMicrosecondsPerSegment << " receiver cpu microseconds per segment" << std::endl;
+            BOOST_REQUIRE_GT(lastCount, 0);
+            managerPtr->Stop();
+            return cpuMicrosecondsPerSegment;
+        }
+    };
+
+    LtpUdpEngineManager::SetMaxUdpRxPacketSizeBytesForAllLtp(UINT16_MAX); //MUST BE CALLED BEFORE GetOrCreateInstance
+    Benchmark b;
+    const double before = b.Run(false, 1114, 400);
+    const double after = b.Run(true, 1115, 401);
+    std::cout << "LTP UDP receive cpu time per segment reduced by recvmmsg: " << ((after > 0) ? (before / after) : 0) << "x" << std::endl;
+    LtpUdpEngineManager::SetUseRecvmmsgForNewInstances(true); //restore the default
+}
+#endif
+
+//Loopback transmit benchmark: an outduct engine sends one fully green block to a plain UDP socket,
+//once with one async_send_to per segment, once with sendmmsg, and once with sendmmsg and UDP GSO.
+BOOST_AUTO_TEST_CASE(LtpUdpEngineTransmitBenchmarkTestCase, *boost::unit_test::disabled())
+{
+    static const uint64_t NUM_SEGMENTS = 20000;
+    static const uint64_t SEGMENT_DATA_SIZE = 1000;
+    struct Benchmark {
+        boost::atomic<uint64_t> numDatagramsReceived;
+        boost::atomic<uint64_t> numDatagramsWithUnexpectedSize;
+        boost::atomic<bool> receiverDone;
+
+        void ReceiverThreadFunc(boost::asio::ip::udp::socket * receiverSocketPtr) {
+            std::vector<uint8_t> buf(UINT16_MAX);
+            while (true) {
+                boost::system::error_code ec;
+                const std::size_t size = receiverSocketPtr->receive(boost::asio::buffer(buf), 0, ec);
+                if (ec || (size == 1)) { //1 byte => stop sentinel
+                    break;
+                }
+                numDatagramsReceived.fetch_add(1, boost::memory_order_relaxed);
+                //every segment carries SEGMENT_DATA_SIZE bytes plus a header of a few dozen bytes (a UDP GSO message that was not split would be much larger)
+                if ((size <= SEGMENT_DATA_SIZE) || (size > (SEGMENT_DATA_SIZE + 64))) {
+                    numDatagramsWithUnexpectedSize.fetch_add(1, boost::memory_order_relaxed);
+                }
+            }
+            receiverDone = true;
+        }
+
+        //returns segments sent per second
+        double Run(const bool useSendmmsg, const bool useUdpGso, const uint16_t boundUdpPort) {
+            numDatagramsReceived = 0;
+            numDatagramsWithUnexpectedSize = 0;
+            receiverDone = false;
+            boost::asio::io_service ioService;
+            boost::asio::ip::udp::socket receiverSocket(ioService, boost::asio::ip::udp::endpoint(boost::asio::ip::address_v4::loopback(), 0));
+            receiverSocket.set_option(boost::asio::socket_base::receive_buffer_size(8000000));
+            const uint16_t receiverPort = receiverSocket.local_endpoint().port();
+            boost::thread receiverThread(boost::bind(&Benchmark::ReceiverThreadFunc, this, &receiverSocket));
+
+            LtpUdpEngineManager::SetUseSendmmsgForNewInstances(useSendmmsg, useUdpGso);
+            std::shared_ptr<LtpUdpEngineManager> managerPtr = LtpUdpEngineManager::GetOrCreateInstance(boundUdpPort, false);
+            BOOST_REQUIRE(managerPtr);
+            BOOST_REQUIRE(managerPtr->AddLtpUdpEngine(1, 2, false, SEGMENT_DATA_SIZE, UINT64_MAX, boost::posix_time::milliseconds(250), boost::posix_time::milliseconds(250),
+                "localhost", receiverPort, 100, 0, 0, 0, 5, false, 0, 1));
+            LtpUdpEngine * const enginePtr = managerPtr->GetLtpUdpEnginePtrByRemoteEngineId(2, false);
+            BOOST_REQUIRE(enginePtr);
+            BOOST_REQUIRE(managerPtr->StartIfNotAlreadyRunning());
+
+            boost::shared_ptr<LtpEngine::transmission_request_t> tReq = boost::make_shared<LtpEngine::transmission_request_t>();
+            tReq->destinationClientServiceId = 1;
+            tReq->destinationLtpEngineId = 2;
+            tReq->clientServiceDataToSend = std::vector<uint8_t>(NUM_SEGMENTS * SEGMENT_DATA_SIZE, 'G');
+            tReq->lengthOfRedPart = 0;
+            const boost::posix_time::ptime startTime = boost::posix_time::microsec_clock::universal_time();
+            enginePtr->TransmissionRequest_ThreadSafe(std::move(tReq));
+            for (unsigned int i = 0; (i < 20000) && (enginePtr->m_countAsyncSendCallbackCalls < NUM_SEGMENTS); ++i) {
+                boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+            }
+            const double seconds = (boost::posix_time::microsec_clock::universal_time() - startTime).total_microseconds() * 1e-6;
+            BOOST_REQUIRE_EQUAL(enginePtr->m_countAsyncSendCallbackCalls, NUM_SEGMENTS);
+            BOOST_REQUIRE_EQUAL(enginePtr->m_countAsyncSendCalls, NUM_SEGMENTS);
+            const uint64_t countSendmmsgCalls = enginePtr->m_countSendmmsgCalls;
+            const uint64_t countUdpGsoMessagesSent = enginePtr->m_countUdpGsoMessagesSent;
+
+            //stop the receiver once it has drained its socket (keep sending the sentinel in case the kernel drops it)
+            boost::asio::ip::udp::socket sentinelSocket(ioService, boost::asio::ip::udp::endpoint(boost::asio::ip::udp::v4(), 0));
+            const uint8_t sentinel = 0;
+            for (unsigned int i = 0; (i < 1000) && (!receiverDone); ++i) {
+                sentinelSocket.send_to(boost::asio::buffer(&sentinel, 1), receiverSocket.local_endpoint());
+                boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+            }
+            receiverThread.join();
+            managerPtr->Stop();
+
+            const double segmentsPerSecond = (seconds > 0) ? (NUM_SEGMENTS / seconds) : 0;
+            std::cout << ((useUdpGso) ? "sendmmsg with UDP GSO" : (useSendmmsg) ? "sendmmsg" : "async_send_to") << ": sent " << NUM_SEGMENTS
+                << " green segments in " << seconds << " seconds (" << segmentsPerSecond << " segments/s) with " << countSendmmsgCalls << " sendmmsg calls and "
+                << countUdpGsoMessagesSent << " UDP GSO messages, " << numDatagramsReceived << " received" << std::endl;
+            BOOST_REQUIRE_GT(numDatagramsReceived, 0);
+            BOOST_REQUIRE_LE(numDatagramsReceived, NUM_SEGMENTS);
+            BOOST_REQUIRE_EQUAL(numDatagramsWithUnexpectedSize, 0);
+            if (!useSendmmsg) {
+                BOOST_REQUIRE_EQUAL(countSendmmsgCalls, 0);
+            }
+            return segmentsPerSecond;
+        }
+    };
+
+    LtpUdpEngineManager::SetMaxUdpRxPacketSizeBytesForAllLtp(UINT16_MAX); //MUST BE CALLED BEFORE GetOrCreateInstance
+    Benchmark b;
+    const double before = b.Run(false, false, 1116);
+    const double afterSendmmsg = b.Run(true, false, 1117);
+    const double afterUdpGso = b.Run(true, true, 1118);
+    std::cout << "LTP UDP transmit speedup with sendmmsg: " << ((before > 0) ? (afterSendmmsg / before) : 0) << "x, with sendmmsg and UDP GSO: "
+        << ((before > 0) ? (afterUdpGso / before) : 0) << "x" << std::endl;
+    LtpUdpEngineManager::SetUseSendmmsgForNewInstances(true, true); //restore the default
+}
+
+//Loopback red part benchmark: an outduct engine sends one fully red block to an induct engine
+//(every data segment carries up to 60000 bytes, only the last one is a checkpoint).
+//The induct copies each segment's client service data once, from the udp receive buffer straight into the preallocated red part.
+BOOST_AUTO_TEST_CASE(LtpUdpEngineRedPartLoopbackBenchmarkTestCase, *boost::unit_test::disabled())
+{
+    static const uint64_t BLOCK_SIZE = 64000000;
+    static const uint64_t SEGMENT_DATA_SIZE = 60000;
+    struct Benchmark {
+        boost::atomic<bool> redPartReceived;
+        boost::atomic<bool> redPartCorrect;
+        boost::posix_time::ptime redPartReceivedTime;
+
+        void RedPartReceptionCallback(const Ltp::session_id_t & sessionId, padded_vector_uint8_t & movableClientServiceDataVec, uint64_t lengthOfRedPart, uint64_t clientServiceId, bool isEndOfBlock) {
+            redPartReceivedTime = boost::posix_time::microsec_clock::universal_time();
+            bool correct = (movableClientServiceDataVec.size() == BLOCK_SIZE) && (lengthOfRedPart == BLOCK_SIZE); //isEndOfBlock is that of the segment completing the red part (which may be a resent one)
+            for (uint64_t i = 0; correct && (i < movableClientServiceDataVec.size()); i += 999) {
+                correct = (movableClientServiceDataVec[i] == static_cast<uint8_t>(i));
+            }
+            redPartCorrect = correct;
+            redPartReceived = true;
+        }
+    };
+
+    LtpUdpEngineManager::SetMaxUdpRxPacketSizeBytesForAllLtp(UINT16_MAX); //MUST BE CALLED BEFORE GetOrCreateInstance
+    const uint16_t BOUND_UDP_PORT_SRC = 1119;
+    const uint16_t BOUND_UDP_PORT_DEST = 1120;
+    const uint64_t ENGINE_ID_SRC = 500;
+    const uint64_t ENGINE_ID_DEST = 501;
+    const boost::posix_time::time_duration ONE_WAY_LIGHT_TIME(boost::posix_time::milliseconds(10));
+    const boost::posix_time::time_duration ONE_WAY_MARGIN_TIME(boost::posix_time::milliseconds(10));
+    Benchmark b;
+    b.redPartReceived = false;
+    b.redPartCorrect = false;
+
+    std::shared_ptr<LtpUdpEngineManager> managerDestPtr = LtpUdpEngineManager::GetOrCreateInstance(BOUND_UDP_PORT_DEST, false);
+    BOOST_REQUIRE(managerDestPtr);
+    BOOST_REQUIRE(managerDestPtr->AddLtpUdpEngine(ENGINE_ID_DEST, ENGINE_ID_SRC, true, 1, UINT64_MAX, ONE_WAY_LIGHT_TIME, ONE_WAY_MARGIN_TIME,
+        "localhost", BOUND_UDP_PORT_SRC, 1000, BLOCK_SIZE, BLOCK_SIZE, 0, 5, false, 0, 1)); //red part preallocated to the block size
+    LtpUdpEngine * const engineDestPtr = managerDestPtr->GetLtpUdpEnginePtrByRemoteEngineId(ENGINE_ID_SRC, true);
+    BOOST_REQUIRE(engineDestPtr);
+    engineDestPtr->SetRedPartReceptionCallback(boost::bind(&Benchmark::RedPartReceptionCallback, &b, boost::placeholders::_1, boost::placeholders::_2,
+        boost::placeholders::_3, boost::placeholders::_4, boost::placeholders::_5));
+
+    std::shared_ptr<LtpUdpEngineManager> managerSrcPtr = LtpUdpEngineManager::GetOrCreateInstance(BOUND_UDP_PORT_SRC, false);
+    BOOST_REQUIRE(managerSrcPtr);
+    BOOST_REQUIRE(managerSrcPtr->AddLtpUdpEngine(ENGINE_ID_SRC, ENGINE_ID_DEST, false, SEGMENT_DATA_SIZE, UINT64_MAX, ONE_WAY_LIGHT_TIME, ONE_WAY_MARGIN_TIME,
+        "localhost", BOUND_UDP_PORT_DEST, 1000, 0, 0, 0, 5, false, 0, 1));
+    LtpUdpEngine * const engineSrcPtr = managerSrcPtr->GetLtpUdpEnginePtrByRemoteEngineId(ENGINE_ID_DEST, false);
+    BOOST_REQUIRE(engineSrcPtr);
+    BOOST_REQUIRE(managerDestPtr->StartIfNotAlreadyRunning());
+    BOOST_REQUIRE(managerSrcPtr->StartIfNotAlreadyRunning());
+
+    boost::shared_ptr<LtpEngine::transmission_request_t> tReq = boost::make_shared<LtpEngine::transmission_request_t>();
+    tReq->destinationClientServiceId = 1;
+    tReq->destinationLtpEngineId = ENGINE_ID_DEST;
+    std::vector<uint8_t> block(BLOCK_SIZE);
+    for (uint64_t i = 0; i < BLOCK_SIZE; ++i) {
+        block[i] = static_cast<uint8_t>(i);
+    }
+    tReq->clientServiceDataToSend = std::move(block);
+    tReq->lengthOfRedPart = BLOCK_SIZE;
+    const boost::posix_time::ptime startTime = boost::posix_time::microsec_clock::universal_time();
+    engineSrcPtr->TransmissionRequest_ThreadSafe(std::move(tReq));
+    for (unsigned int i = 0; (i < 30000) && (!b.redPartReceived); ++i) {
+        boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+    }
+    BOOST_REQUIRE(b.redPartReceived);
+    BOOST_REQUIRE(b.redPartCorrect);
+    const double seconds = (b.redPartReceivedTime - startTime).total_microseconds() * 1e-6;
+    std::cout << "received a " << BLOCK_SIZE << " byte red part over loopback in " << seconds << " seconds ("
+        << ((seconds > 0) ? ((BLOCK_SIZE / seconds) * 1e-9) : 0) << " GB/s) after " << engineSrcPtr->m_countAsyncSendCalls << " datagrams sent" << std::endl;
+    managerSrcPtr->Stop();
+    managerDestPtr->Stop();
+}
+
+BOOST_AUTO_TEST_CASE(LtpUdpEngineWorkerThreadsTestCase)
+{
+    //one engine pair, each engine running its sessions on 4 worker threads
+    static const unsigned int NUM_WORKER_THREADS = 4;
+    static const unsigned int NUM_SESSIONS = 40;
+    static const uint64_t BLOCK_SIZE = 100000;
+    static const uint64_t SEGMENT_DATA_SIZE = 1000;
+    struct Test {
+        boost::mutex mutex; //the callbacks come from all the worker threads
+        std::set<boost::thread::id> receivingThreadIds;
+        std::set<boost::thread::id> completingThreadIds;
+        std::set<uint64_t> blockIdsReceived;
+        unsigned int numRedPartsCorrect;
+        unsigned int numSessionsCompleted;
+
+        void RedPartReceptionCallback(const Ltp::session_id_t & sessionId, padded_vector_uint8_t & movableClientServiceDataVec, uint64_t lengthOfRedPart, uint64_t clientServiceId, bool isEndOfBlock) {
+            bool correct = (movableClientServiceDataVec.size() == BLOCK_SIZE) && (lengthOfRedPart == BLOCK_SIZE);
+            const uint8_t blockId = (correct) ? movableClientServiceDataVec[0] : 0;
+            for (uint64_t i = 0; correct && (i < movableClientServiceDataVec.size()); i += 99) {
+                correct = (movableClientServiceDataVec[i] == static_cast<uint8_t>(blockId + i));
+            }
+            boost::mutex::scoped_lock lock(mutex);
+            receivingThreadIds.insert(boost::this_thread::get_id());
+            blockIdsReceived.insert(blockId);
+            numRedPartsCorrect += correct;
+        }
+        void TransmissionSessionCompletedCallback(const Ltp::session_id_t & sessionId) {
+            boost::mutex::scoped_lock lock(mutex);
+            completingThreadIds.insert(boost::this_thread::get_id());
+            ++numSessionsCompleted;
+        }
+    };
+
+    LtpUdpEngineManager::SetMaxUdpRxPacketSizeBytesForAllLtp(UINT16_MAX); //MUST BE CALLED BEFORE GetOrCreateInstance
+    const uint16_t BOUND_UDP_PORT_SRC = 1121;
+    const uint16_t BOUND_UDP_PORT_DEST = 1122;
+    const uint64_t ENGINE_ID_SRC = 600;
+    const uint64_t ENGINE_ID_DEST = 601;
+    const boost::posix_time::time_duration ONE_WAY_LIGHT_TIME(boost::posix_time::milliseconds(10));
+    const boost::posix_time::time_duration ONE_WAY_MARGIN_TIME(boost::posix_time::milliseconds(10));
+    Test t;
+    t.numRedPartsCorrect = 0;
+    t.numSessionsCompleted = 0;
+
+    std::shared_ptr<LtpUdpEngineManager> managerDestPtr = LtpUdpEngineManager::GetOrCreateInstance(BOUND_UDP_PORT_DEST, false);
+    BOOST_REQUIRE(managerDestPtr);
+    BOOST_REQUIRE(managerDestPtr->AddLtpUdpEngine(ENGINE_ID_DEST, ENGINE_ID_SRC, true, 1, UINT64_MAX, ONE_WAY_LIGHT_TIME, ONE_WAY_MARGIN_TIME,
+        "localhost", BOUND_UDP_PORT_SRC, 1000, BLOCK_SIZE, BLOCK_SIZE, 0, 5, false, 0, NUM_WORKER_THREADS));
+    LtpUdpEngine * const engineDestPtr = managerDestPtr->GetLtpUdpEnginePtrByRemoteEngineId(ENGINE_ID_SRC, true);
+    BOOST_REQUIRE(engineDestPtr);
+    BOOST_REQUIRE_EQUAL(engineDestPtr->GetNumWorkers(), NUM_WORKER_THREADS);
+    engineDestPtr->SetRedPartReceptionCallback(boost::bind(&Test::RedPartReceptionCallback, &t, boost::placeholders::_1, boost::placeholders::_2,
+        boost::placeholders::_3, boost::placeholders::_4, boost::placeholders::_5));
+
+    std::shared_ptr<LtpUdpEngineManager> managerSrcPtr = LtpUdpEngineManager::GetOrCreateInstance(BOUND_UDP_PORT_SRC, false);
+    BOOST_REQUIRE(managerSrcPtr);
+    BOOST_REQUIRE(managerSrcPtr->AddLtpUdpEngine(ENGINE_ID_SRC, ENGINE_ID_DEST, false, SEGMENT_DATA_SIZE, UINT64_MAX, ONE_WAY_LIGHT_TIME, ONE_WAY_MARGIN_TIME,
+        "localhost", BOUND_UDP_PORT_DEST, 1000, 0, 0, 0, 5, false, 0, NUM_WORKER_THREADS));
+    LtpUdpEngine * const engineSrcPtr = managerSrcPtr->GetLtpUdpEnginePtrByRemoteEngineId(ENGINE_ID_DEST, false);
+    BOOST_REQUIRE(engineSrcPtr);
+    BOOST_REQUIRE_EQUAL(engineSrcPtr->GetNumWorkers(), NUM_WORKER_THREADS);
+    engineSrcPtr->SetTransmissionSessionCompletedCallback(boost::bind(&Test::TransmissionSessionCompletedCallback, &t, boost::placeholders::_1));
+    BOOST_REQUIRE(managerDestPtr->StartIfNotAlreadyRunning());
+    BOOST_REQUIRE(managerSrcPtr->StartIfNotAlreadyRunning());
+
+    for (unsigned int sessionIndex = 0; sessionIndex < NUM_SESSIONS; ++sessionIndex) {
+        boost::shared_ptr<LtpEngine::transmission_request_t> tReq = boost::make_shared<LtpEngine::transmission_request_t>();
+        tReq->destinationClientServiceId = 1;
+        tReq->destinationLtpEngineId = ENGINE_ID_DEST;
+        std::vector<uint8_t> block(BLOCK_SIZE);
+        for (uint64_t i = 0; i < BLOCK_SIZE; ++i) {
+            block[i] = static_cast<uint8_t>(sessionIndex + i);
+        }
+        tReq->clientServiceDataToSend = std::move(block);
+        tReq->lengthOfRedPart = BLOCK_SIZE;
+        engineSrcPtr->TransmissionRequest_ThreadSafe(std::move(tReq));
+    }
+    for (unsigned int i = 0; i < 30000; ++i) {
+        {
+            boost::mutex::scoped_lock lock(t.mutex);
+            if (t.numSessionsCompleted == NUM_SESSIONS) {
+                break;
+            }
+        }
+        boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+    }
+    {
+        boost::mutex::scoped_lock lock(t.mutex);
+        BOOST_REQUIRE_EQUAL(t.numSessionsCompleted, NUM_SESSIONS);
+        BOOST_REQUIRE_EQUAL(t.numRedPartsCorrect, NUM_SESSIONS);
+        BOOST_REQUIRE_EQUAL(t.blockIdsReceived.size(), NUM_SESSIONS);
+        //the sessions were spread over all the workers of both engines
+        BOOST_REQUIRE_EQUAL(t.completingThreadIds.size(), NUM_WORKER_THREADS);
+        BOOST_REQUIRE_EQUAL(t.receivingThreadIds.size(), NUM_WORKER_THREADS);
+    }
+    for (unsigned int workerIndex = 0; workerIndex < NUM_WORKER_THREADS; ++workerIndex) {
+        BOOST_REQUIRE_GT(engineSrcPtr->GetWorkerEngine(workerIndex)->m_countAsyncSendCalls, 0);
+        BOOST_REQUIRE_GT(engineDestPtr->GetWorkerEngine(workerIndex)->m_countAsyncSendCalls, 0);
+    }
+    managerSrcPtr->Stop();
+    managerDestPtr->Stop();
+}
@@ -7,12 +7,16 @@
 #include <vector>
 #include <zmq.hpp>
 #include <boost/thread.hpp>
+#include <boost/atomic.hpp>
 #include "codec/bpv6.h"
 #include "TcpclBundleSource.h" //for OutductOpportunisticProcessReceivedBundleCallback_t
 
 class OutductManager {
 public:
     typedef boost::function<void(uint64_t outductUuidIndex)> OutductManager_OnSuccessfulOutductAckCallback_t;
+    typedef std::map<cbhe_eid_t, boost::shared_ptr<Outduct> > final_dest_eid_to_outduct_map_t;
+    //immutable once published, so a reader holding one never needs a lock
+    typedef boost::shared_ptr<const final_dest_eid_to_outduct_map_t> route_table_snapshot_t;
 
     OUTDUCT_MANAGER_LIB_EXPORT OutductManager();
     OUTDUCT_MANAGER_LIB_EXPORT ~OutductManager();
@@ -24,6 +28,14 @@ public:
     OUTDUCT_MANAGER_LIB_EXPORT Outduct * GetOutductByFinalDestinationEid_ThreadSafe(const cbhe_eid_t & finalDestEid);
     OUTDUCT_MANAGER_LIB_EXPORT Outduct * GetOutductByOutductUuid(const uint64_t uuid);
     OUTDUCT_MANAGER_LIB_EXPORT void SetOutductForFinalDestinationEid_ThreadSafe(const cbhe_eid_t finalDestEid, boost::shared_ptr<Outduct> & outductPtr);
+    OUTDUCT_MANAGER_LIB_EXPORT route_table_snapshot_t GetRouteTableSnapshot_ThreadSafe() const;
+    //incremented after every route table update, so a reader can keep its snapshot until this changes
+    OUTDUCT_MANAGER_LIB_EXPORT uint64_t GetRouteTableGeneration_ThreadSafe() const;
+    OUTDUCT_MANAGER_LIB_EXPORT static Outduct * GetOutductByFinalDestinationEid(const route_table_snapshot_t & routeTableSnapshot, const cbhe_eid_t & finalDestEid);
+    //for a reader thread that keeps its own snapshot (and the generation it was taken at): the snapshot is reloaded
+    //only after the route table generation changes, so a lookup on an unchanged table is one atomic load and a find
+    OUTDUCT_MANAGER_LIB_EXPORT Outduct * GetOutductByFinalDestinationEid_ThreadSafe(route_table_snapshot_t & cachedRouteTableSnapshot,
+        uint64_t & cachedRouteTableGeneration, const cbhe_eid_t & finalDestEid) const;
     OUTDUCT_MANAGER_LIB_EXPORT boost::shared_ptr<Outduct> GetOutductSharedPtrByOutductUuid(const uint64_t uuid);
     OUTDUCT_MANAGER_LIB_EXPORT Outduct * GetOutductByNextHopEid(const cbhe_eid_t & nextHopEid);
     OUTDUCT_MANAGER_LIB_EXPORT void SetOutductManagerOnSuccessfulOutductAckCallback(const OutductManager_OnSuccessfulOutductAckCallback_t & callback);
@@ -37,6 +49,7 @@ public:
     OUTDUCT_MANAGER_LIB_EXPORT bool Forward_Blocking(const cbhe_eid_t & finalDestEid, std::vector<uint8_t> & movableDataVec, const uint32_t timeoutSeconds);
 private:
     OUTDUCT_MANAGER_LIB_NO_EXPORT void OnSuccessfulBundleAck(uint64_t uuidIndex);
+    OUTDUCT_MANAGER_LIB_NO_EXPORT void PublishRouteTable(const final_dest_eid_to_outduct_map_t & finalDestEidToOutductMap);
 
     struct thread_communication_t {
         boost::condition_variable m_cv;
@@ -52,8 +65,11 @@ private:
         }
     };
 
-    std::map<cbhe_eid_t, boost::shared_ptr<Outduct> > m_finalDestEidToOutductMap;
-    boost::mutex m_finalDestEidToOutductMapMutex;
+    //Read-copy-update: route updates copy the current table, modify the copy, and atomically swap it in,
+    //so the per-bundle lookups never wait on a route update (or on each other).
+    route_table_snapshot_t m_routeTableSnapshotPtr; //only accessed with boost::atomic_load/atomic_store
+    boost::atomic<uint64_t> m_routeTableGeneration;
+    boost::mutex m_routeTableUpdateMutex; //serializes the writers only
     std::map<cbhe_eid_t, boost::shared_ptr<Outduct> > m_nextHopEidToOutductMap;
     std::vector<boost::shared_ptr<Outduct> > m_outductsVec;
     std::vector<std::unique_ptr<thread_communication_t> > m_threadCommunicationVec;
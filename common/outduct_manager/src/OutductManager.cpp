@@ -9,7 +9,10 @@
 #include "LtpOverUdpOutduct.h"
 #include "Uri.h"
 
-OutductManager::OutductManager() : m_numEventsTooManyUnackedBundles(0) {}
+OutductManager::OutductManager() :
+    m_routeTableSnapshotPtr(boost::make_shared<final_dest_eid_to_outduct_map_t>()),
+    m_routeTableGeneration(0),
+    m_numEventsTooManyUnackedBundles(0) {}
 
 OutductManager::~OutductManager() {
     std::cout << "m_numEventsTooManyUnackedBundles " << m_numEventsTooManyUnackedBundles << std::endl;
@@ -31,7 +34,7 @@ bool OutductManager::LoadOutductsFromConfig(const OutductsConfig & outductsConfi
     const OutductOpportunisticProcessReceivedBundleCallback_t & outductOpportunisticProcessReceivedBundleCallback)
 {
     LtpUdpEngineManager::SetMaxUdpRxPacketSizeBytesForAllLtp(maxUdpRxPacketSizeBytesForAllLtp); //MUST BE CALLED BEFORE ANY USAGE OF LTP
-    m_finalDestEidToOutductMap.clear();
+    final_dest_eid_to_outduct_map_t finalDestEidToOutductMap;
     m_nextHopEidToOutductMap.clear();
     m_outductsVec.clear();
     m_threadCommunicationVec.clear();
@@ -90,7 +93,7 @@ bool OutductManager::LoadOutductsFromConfig(const OutductsConfig & outductsConfi
                     std::cerr << "error in OutductManager::LoadOutductsFromConfig: finalDestinationEidUri " << finalDestinationEidUri << " is invalid." << std::endl;
                     return false;
                 }
-                m_finalDestEidToOutductMap[destEid] = outductSharedPtr;
+                finalDestEidToOutductMap[destEid] = outductSharedPtr;
             }
             cbhe_eid_t nextHopEid;
             if (!Uri::ParseIpnUriString(thisOutductConfig.nextHopEndpointId, nextHopEid.nodeId, nextHopEid.serviceId)) {
@@ -110,11 +113,12 @@ bool OutductManager::LoadOutductsFromConfig(const OutductsConfig & outductsConfi
             return false;
         }
     }
+    PublishRouteTable(finalDestEidToOutductMap);
     return true;
 }
 
 void OutductManager::Clear() {
-    m_finalDestEidToOutductMap.clear();
+    PublishRouteTable(final_dest_eid_to_outduct_map_t());
     m_nextHopEidToOutductMap.clear();
 }
 
@@ -246,18 +250,49 @@ bool OutductManager::Forward_Blocking(const cbhe_eid_t & finalDestEid, std::vect
     }
 }
 
+void OutductManager::PublishRouteTable(const final_dest_eid_to_outduct_map_t & finalDestEidToOutductMap) {
+    boost::mutex::scoped_lock lock(m_routeTableUpdateMutex);
+    route_table_snapshot_t newRouteTableSnapshotPtr = boost::make_shared<final_dest_eid_to_outduct_map_t>(finalDestEidToOutductMap);
+    boost::atomic_store(&m_routeTableSnapshotPtr, newRouteTableSnapshotPtr);
+    m_routeTableGeneration.fetch_add(1, boost::memory_order_release);
+}
+
 void OutductManager::SetOutductForFinalDestinationEid_ThreadSafe(const cbhe_eid_t finalDestEid, boost::shared_ptr<Outduct> & outductPtr) {
-    m_finalDestEidToOutductMapMutex.lock();
-    m_finalDestEidToOutductMap[finalDestEid] = outductPtr;
-    m_finalDestEidToOutductMapMutex.unlock();
+    boost::mutex::scoped_lock lock(m_routeTableUpdateMutex);
+    //copy, update, then swap in the new table (readers still holding the old one are unaffected)
+    boost::shared_ptr<final_dest_eid_to_outduct_map_t> newMapPtr = boost::make_shared<final_dest_eid_to_outduct_map_t>(*boost::atomic_load(&m_routeTableSnapshotPtr));
+    (*newMapPtr)[finalDestEid] = outductPtr;
+    boost::atomic_store(&m_routeTableSnapshotPtr, route_table_snapshot_t(newMapPtr));
+    m_routeTableGeneration.fetch_add(1, boost::memory_order_release);
+}
+
+OutductManager::route_table_snapshot_t OutductManager::GetRouteTableSnapshot_ThreadSafe() const {
+    return boost::atomic_load(&m_routeTableSnapshotPtr);
+}
+
+uint64_t OutductManager::GetRouteTableGeneration_ThreadSafe() const {
+    return m_routeTableGeneration.load(boost::memory_order_acquire);
+}
+
+Outduct * OutductManager::GetOutductByFinalDestinationEid(const route_table_snapshot_t & routeTableSnapshot, const cbhe_eid_t & finalDestEid) {
+    final_dest_eid_to_outduct_map_t::const_iterator it = routeTableSnapshot->find(finalDestEid);
+    return (it != routeTableSnapshot->cend()) ? it->second.get() : NULL;
 }
 
 Outduct * OutductManager::GetOutductByFinalDestinationEid_ThreadSafe(const cbhe_eid_t & finalDestEid) {
-    m_finalDestEidToOutductMapMutex.lock();
-    std::map<cbhe_eid_t, boost::shared_ptr<Outduct> >::iterator it = m_finalDestEidToOutductMap.find(finalDestEid);
-    Outduct * const retVal = (it != m_finalDestEidToOutductMap.end()) ? it->second.get() : NULL;
-    m_finalDestEidToOutductMapMutex.unlock();
-    return retVal;
+    return GetOutductByFinalDestinationEid(GetRouteTableSnapshot_ThreadSafe(), finalDestEid);
+}
+
+Outduct * OutductManager::GetOutductByFinalDestinationEid_ThreadSafe(route_table_snapshot_t & cachedRouteTableSnapshot,
+    uint64_t & cachedRouteTableGeneration, const cbhe_eid_t & finalDestEid) const
+{
+    //the generation is incremented after its snapshot is stored, so a changed generation always finds that snapshot (or a newer one)
+    const uint64_t currentRouteTableGeneration = GetRouteTableGeneration_ThreadSafe();
+    if (currentRouteTableGeneration != cachedRouteTableGeneration) {
+        cachedRouteTableGeneration = currentRouteTableGeneration;
+        cachedRouteTableSnapshot = GetRouteTableSnapshot_ThreadSafe();
+    }
+    return GetOutductByFinalDestinationEid(cachedRouteTableSnapshot, finalDestEid);
 }
 
 Outduct * OutductManager::GetOutductByNextHopEid(const cbhe_eid_t & nextHopEid) {
@@ -0,0 +1,139 @@
+#include <boost/test/unit_test.hpp>
+#include "OutductManager.h"
+#include <boost/make_shared.hpp>
+#include <vector>
+
+//an outduct that only carries its uuid (the route table tests never forward)
+class RouteTableTestOutduct : public Outduct {
+public:
+    RouteTableTestOutduct(const uint64_t outductUuid) : Outduct(outduct_element_config_t(), outductUuid) {}
+    virtual ~RouteTableTestOutduct() {}
+    virtual std::size_t GetTotalDataSegmentsUnacked() { return 0; }
+    virtual bool Forward(const uint8_t* bundleData, const std::size_t size) { return false; }
+    virtual bool Forward(zmq::message_t & movableDataZmq) { return false; }
+    virtual bool Forward(std::vector<uint8_t> & movableDataVec) { return false; }
+    virtual void SetOnSuccessfulAckCallback(const OnSuccessfulOutductAckCallback_t & callback) {}
+    virtual void Connect() {}
+    virtual bool ReadyToForward() { return true; }
+    virtual void Stop() {}
+    virtual void GetOutductFinalStats(OutductFinalStats & finalStats) {}
+};
+
+static constexpr uint64_t NUM_ROUTED_EIDS = 8;
+
+static void SetAllRoutes(OutductManager & outductManager, const uint64_t outductUuid) {
+    //a new outduct per update, so only the snapshots still holding the previous one keep it alive
+    boost::shared_ptr<Outduct> outductPtr = boost::make_shared<RouteTableTestOutduct>(outductUuid);
+    for (uint64_t nodeId = 1; nodeId <= NUM_ROUTED_EIDS; ++nodeId) {
+        outductManager.SetOutductForFinalDestinationEid_ThreadSafe(cbhe_eid_t(nodeId, 1), outductPtr);
+    }
+}
+
+static void RouteTableReaderThreadFunc(OutductManager * outductManagerPtr, const volatile bool * runningPtr, uint64_t * numLookupsPtr, bool * successPtr) {
+    OutductManager & outductManager = *outductManagerPtr;
+    uint64_t cachedRouteTableGeneration = outductManager.GetRouteTableGeneration_ThreadSafe();
+    OutductManager::route_table_snapshot_t cachedRouteTableSnapshot = outductManager.GetRouteTableSnapshot_ThreadSafe();
+    std::vector<uint64_t> lastUuidSeen(NUM_ROUTED_EIDS + 1, 0);
+    uint64_t numLookups = 0;
+    bool success = true;
+    while (*runningPtr || (numLookups == 0)) {
+        for (uint64_t nodeId = 1; nodeId <= NUM_ROUTED_EIDS; ++nodeId) {
+            Outduct * outductPtr = outductManager.GetOutductByFinalDestinationEid_ThreadSafe(cachedRouteTableSnapshot, cachedRouteTableGeneration, cbhe_eid_t(nodeId, 1));
+            ++numLookups;
+            if (outductPtr == NULL) {
+                success = false;
+                continue;
+            }
+            //the outduct must still be alive (held by the snapshot), and a reader never goes back to an older route table
+            const uint64_t uuid = outductPtr->GetOutductUuid();
+            if (uuid < lastUuidSeen[nodeId]) {
+                success = false;
+            }
+            lastUuidSeen[nodeId] = uuid;
+        }
+    }
+    *numLookupsPtr = numLookups;
+    *successPtr = success;
+}
+
+BOOST_AUTO_TEST_CASE(OutductManagerRouteTableSnapshotTestCase)
+{
+    OutductManager outductManager;
+    const cbhe_eid_t eidA(1, 1);
+    const cbhe_eid_t eidB(2, 1);
+    BOOST_REQUIRE(outductManager.GetOutductByFinalDestinationEid_ThreadSafe(eidA) == NULL);
+
+    //a reader holding a snapshot keeps its table (and the outducts in it) across a swap
+    {
+        boost::shared_ptr<Outduct> outduct0Ptr = boost::make_shared<RouteTableTestOutduct>(0);
+        outductManager.SetOutductForFinalDestinationEid_ThreadSafe(eidA, outduct0Ptr);
+    }
+    const OutductManager::route_table_snapshot_t oldSnapshot = outductManager.GetRouteTableSnapshot_ThreadSafe();
+    {
+        boost::shared_ptr<Outduct> outduct1Ptr = boost::make_shared<RouteTableTestOutduct>(1);
+        outductManager.SetOutductForFinalDestinationEid_ThreadSafe(eidA, outduct1Ptr);
+    }
+    Outduct * oldOutductPtr = OutductManager::GetOutductByFinalDestinationEid(oldSnapshot, eidA);
+    BOOST_REQUIRE(oldOutductPtr != NULL);
+    BOOST_REQUIRE_EQUAL(oldOutductPtr->GetOutductUuid(), 0); //only the old snapshot still references outduct 0
+    BOOST_REQUIRE_EQUAL(oldSnapshot->size(), 1);
+    BOOST_REQUIRE_EQUAL(outductManager.GetOutductByFinalDestinationEid_ThreadSafe(eidA)->GetOutductUuid(), 1);
+
+    //the generation cached lookup keeps its snapshot until the table changes, then reloads it
+    uint64_t cachedRouteTableGeneration = outductManager.GetRouteTableGeneration_ThreadSafe();
+    OutductManager::route_table_snapshot_t cachedRouteTableSnapshot = outductManager.GetRouteTableSnapshot_ThreadSafe();
+    const OutductManager::final_dest_eid_to_outduct_map_t * const cachedTablePtr = cachedRouteTableSnapshot.get();
+    BOOST_REQUIRE(outductManager.GetOutductByFinalDestinationEid_ThreadSafe(cachedRouteTableSnapshot, cachedRouteTableGeneration, eidB) == NULL);
+    BOOST_REQUIRE_EQUAL(outductManager.GetOutductByFinalDestinationEid_ThreadSafe(cachedRouteTableSnapshot, cachedRouteTableGeneration, eidA)->GetOutductUuid(), 1);
+    BOOST_REQUIRE(cachedRouteTableSnapshot.get() == cachedTablePtr); //unchanged table, no reload
+    {
+        boost::shared_ptr<Outduct> outduct2Ptr = boost::make_shared<RouteTableTestOutduct>(2);
+        outductManager.SetOutductForFinalDestinationEid_ThreadSafe(eidB, outduct2Ptr);
+    }
+    Outduct * outductBPtr = outductManager.GetOutductByFinalDestinationEid_ThreadSafe(cachedRouteTableSnapshot, cachedRouteTableGeneration, eidB);
+    BOOST_REQUIRE(outductBPtr != NULL);
+    BOOST_REQUIRE_EQUAL(outductBPtr->GetOutductUuid(), 2);
+    BOOST_REQUIRE(cachedRouteTableSnapshot.get() != cachedTablePtr);
+    BOOST_REQUIRE_EQUAL(cachedRouteTableGeneration, outductManager.GetRouteTableGeneration_ThreadSafe());
+    BOOST_REQUIRE_EQUAL(cachedRouteTableSnapshot->size(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(OutductManagerRouteTableConcurrentReadersTestCase)
+{
+    //readers do generation cached lookups without locks while a writer keeps swapping in new route tables
+    static constexpr unsigned int NUM_READERS = 4;
+    static constexpr uint64_t NUM_UPDATES = 2000;
+    OutductManager outductManager;
+    SetAllRoutes(outductManager, 1);
+
+    volatile bool running = true;
+    std::vector<uint64_t> numLookups(NUM_READERS, 0);
+    bool success[NUM_READERS];
+    std::vector<std::unique_ptr<boost::thread> > readerThreads;
+    for (unsigned int i = 0; i < NUM_READERS; ++i) {
+        success[i] = false;
+        readerThreads.emplace_back(new boost::thread(boost::bind(&RouteTableReaderThreadFunc, &outductManager, &running, &numLookups[i], &success[i])));
+    }
+    for (uint64_t outductUuid = 2; outductUuid <= NUM_UPDATES; ++outductUuid) {
+        SetAllRoutes(outductManager, outductUuid);
+        if ((outductUuid % 100) == 0) {
+            boost::this_thread::yield();
+        }
+    }
+    running = false;
+    for (unsigned int i = 0; i < NUM_READERS; ++i) {
+        readerThreads[i]->join();
+        BOOST_REQUIRE(success[i]);
+        BOOST_REQUIRE_GT(numLookups[i], 0);
+    }
+
+    //a reader that cached an old generation sees the final table on its next lookup
+    uint64_t cachedRouteTableGeneration = 0;
+    OutductManager::route_table_snapshot_t cachedRouteTableSnapshot;
+    for (uint64_t nodeId = 1; nodeId <= NUM_ROUTED_EIDS; ++nodeId) {
+        Outduct * outductPtr = outductManager.GetOutductByFinalDestinationEid_ThreadSafe(cachedRouteTableSnapshot, cachedRouteTableGeneration, cbhe_eid_t(nodeId, 1));
+        BOOST_REQUIRE(outductPtr != NULL);
+        BOOST_REQUIRE_EQUAL(outductPtr->GetOutductUuid(), NUM_UPDATES);
+    }
+    BOOST_REQUIRE_EQUAL(cachedRouteTableGeneration, NUM_UPDATES * NUM_ROUTED_EIDS);
+}
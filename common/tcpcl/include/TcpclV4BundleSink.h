@@ -39,6 +39,8 @@ public:
     TCPCL_LIB_EXPORT void TrySendOpportunisticBundleIfAvailable_FromIoServiceThread();
     TCPCL_LIB_EXPORT void SetTryGetOpportunisticDataFunction(const TryGetOpportunisticDataFunction_t & tryGetOpportunisticDataFunction);
     TCPCL_LIB_EXPORT void SetNotifyOpportunisticDataAckedCallback(const NotifyOpportunisticDataAckedCallback_t & notifyOpportunisticDataAckedCallback);
+    //while paused, no new tcp reads are started (so the remote sender is throttled by tcp flow control)
+    TCPCL_LIB_EXPORT void SetRxPausedByBackPressure_FromIoServiceThread(const bool paused);
 private:
 
     
@@ -79,6 +81,7 @@ private:
     boost::condition_variable m_conditionVariableCb;
     std::unique_ptr<boost::thread> m_threadCbReaderPtr;
     bool m_stateTcpReadActive;
+    bool m_rxPausedByBackPressure;
     bool m_printedCbTooSmallNotice;
     volatile bool m_running;
     
@@ -46,6 +46,7 @@ TcpclBundleSink::TcpclBundleSink(
     m_tcpReceiveBuffersCbVec(M_NUM_CIRCULAR_BUFFER_VECTORS),
     m_tcpReceiveBytesTransferredCbVec(M_NUM_CIRCULAR_BUFFER_VECTORS),
     m_stateTcpReadActive(false),
+    m_rxPausedByBackPressure(false),
     m_printedCbTooSmallNotice(false),
     m_running(false)
 {
@@ -96,7 +97,7 @@ TcpclBundleSink::~TcpclBundleSink() {
 
 
 void TcpclBundleSink::TryStartTcpReceive() {
-    if ((!m_stateTcpReadActive) && (m_base_tcpSocketPtr)) {
+    if ((!m_stateTcpReadActive) && (!m_rxPausedByBackPressure) && (m_base_tcpSocketPtr)) {
         const unsigned int writeIndex = m_circularIndexBuffer.GetIndexForWrite(); //store the volatile
         if (writeIndex == UINT32_MAX) {
             if (!m_printedCbTooSmallNotice) {
@@ -157,6 +158,13 @@ void TcpclBundleSink::PopCbThreadFunc() {
 
 }
 
+void TcpclBundleSink::SetRxPausedByBackPressure_FromIoServiceThread(const bool paused) {
+    m_rxPausedByBackPressure = paused;
+    if (!paused) {
+        m_conditionVariableCb.notify_one(); //reader thread will post the appropriate TryStartTcpReceive
+    }
+}
+
 void TcpclBundleSink::Virtual_OnTcpSendSuccessful_CalledFromIoServiceThread() {
     ////TrySendOpportunisticBundleIfAvailable_FromIoServiceThread();
 }
@@ -54,6 +54,7 @@ TcpclV4BundleSink::TcpclV4BundleSink(
     m_tcpReceiveBuffersCbVec(M_NUM_CIRCULAR_BUFFER_VECTORS),
     m_tcpReceiveBytesTransferredCbVec(M_NUM_CIRCULAR_BUFFER_VECTORS),
     m_stateTcpReadActive(false),
+    m_rxPausedByBackPressure(false),
     m_printedCbTooSmallNotice(false),
     m_running(false)
 {
@@ -125,7 +126,7 @@ void TcpclV4BundleSink::HandleSslHandshake(const boost::system::error_code & err
 }
 
 void TcpclV4BundleSink::TryStartTcpReceiveSecure() { //must run within Io Service Thread
-    if ((!m_stateTcpReadActive) && (m_base_sslStreamSharedPtr)) {
+    if ((!m_stateTcpReadActive) && (!m_rxPausedByBackPressure) && (m_base_sslStreamSharedPtr)) {
         const unsigned int writeIndex = m_circularIndexBuffer.GetIndexForWrite(); //store the volatile
         if (writeIndex == UINT32_MAX) {
             if (!m_printedCbTooSmallNotice) {
@@ -163,11 +164,11 @@ void TcpclV4BundleSink::HandleTcpReceiveSomeSecure(const boost::system::error_co
 }
 
 void TcpclV4BundleSink::TryStartTcpReceiveUnsecure() { //must run within Io Service Thread
-    if ((!m_stateTcpReadActive) && (m_base_sslStreamSharedPtr)) {
+    if ((!m_stateTcpReadActive) && (!m_rxPausedByBackPressure) && (m_base_sslStreamSharedPtr)) {
         boost::asio::ip::tcp::socket & socketRef = m_base_sslStreamSharedPtr->next_layer();
 #else
 void TcpclV4BundleSink::TryStartTcpReceiveUnsecure() { //must run within Io Service Thread
-    if ((!m_stateTcpReadActive) && (m_base_tcpSocketPtr)) {
+    if ((!m_stateTcpReadActive) && (!m_rxPausedByBackPressure) && (m_base_tcpSocketPtr)) {
         boost::asio::ip::tcp::socket & socketRef = *m_base_tcpSocketPtr;
 #endif
     
@@ -239,6 +240,13 @@ void TcpclV4BundleSink::PopCbThreadFunc() {
 
 }
 
+void TcpclV4BundleSink::SetRxPausedByBackPressure_FromIoServiceThread(const bool paused) {
+    m_rxPausedByBackPressure = paused;
+    if (!paused) {
+        m_conditionVariableCb.notify_one(); //reader thread will post the appropriate TryStartTcpReceive
+    }
+}
+
 void TcpclV4BundleSink::Virtual_OnTcpSendSuccessful_CalledFromIoServiceThread() {
     ////TrySendOpportunisticBundleIfAvailable_FromIoServiceThread();
 }
@@ -0,0 +1,78 @@
+#ifndef _BUNDLE_BUFFER_POOL_H
+#define _BUNDLE_BUFFER_POOL_H
+
+#include <stdint.h>
+#include <cstddef>
+#include <new>
+#include <utility>
+#include "hdtn_util_export.h"
+
+struct BundleBufferPoolTelemetry {
+    BundleBufferPoolTelemetry() : totalSystemAllocations(0), totalSystemAllocatedBytes(0), totalSystemDeallocations(0),
+        totalOversizedAllocations(0), totalThreadCacheRefills(0), totalThreadCacheFlushes(0) {}
+    uint64_t totalSystemAllocations; //huge page slabs, individually mapped blocks, and oversized allocations
+    uint64_t totalSystemAllocatedBytes;
+    uint64_t totalSystemDeallocations;
+    uint64_t totalOversizedAllocations; //above the largest size class, these bypass the pool
+    uint64_t totalThreadCacheRefills; //a thread's free list was empty and took blocks from the shared free list
+    uint64_t totalThreadCacheFlushes; //a thread's free list was full and gave blocks back to the shared free list
+};
+
+//Process wide size-class allocator for bundle buffers (it backs padded_vector_uint8_t) and the small per-bundle
+//objects that travel with them (headers, zmq message wrappers).
+//Sizes are rounded up to one of the size classes (64 byte steps up to 256 bytes, then four classes per power of two
+//up to 16 MiB), and freed blocks go on a free list of their size class instead of back to the system:
+//  - Each thread keeps a small free list per size class, so the common case (an induct thread allocating and an
+//    ingress/egress thread freeing at a steady rate) takes no lock.  Lists that grow too long or a thread exit
+//    give the blocks back to the shared per size class free lists, which the threads refill from in batches.
+//  - Blocks up to 512 KiB are carved from 2 MiB slabs, larger blocks are mapped individually.  On Linux both are
+//    mapped 2 MiB aligned and advised to use transparent huge pages.  Slabs are never returned to the system, and the
+//    shared free lists of individually mapped blocks are capped so that a burst of large bundles is not held forever.
+//Sizes above the largest class go straight to malloc/free.
+//The caller must pass Deallocate the same size it passed Allocate (as std::allocator requires of a container).
+class HDTN_UTIL_EXPORT BundleBufferPool {
+private:
+    BundleBufferPool();
+public:
+    static void * Allocate(const std::size_t sizeBytes); //throws std::bad_alloc
+    static void Deallocate(void * ptr, const std::size_t sizeBytes);
+
+    //allocate and construct a single object (alignment up to 64 bytes), release with Delete
+    template <typename T>
+    static T * New() {
+        void * const ptr = Allocate(sizeof(T));
+        try {
+            return new (ptr) T();
+        }
+        catch (...) {
+            Deallocate(ptr, sizeof(T));
+            throw;
+        }
+    }
+    template <typename T>
+    static T * New(T && movableObject) {
+        void * const ptr = Allocate(sizeof(T));
+        try {
+            return new (ptr) T(std::move(movableObject));
+        }
+        catch (...) {
+            Deallocate(ptr, sizeof(T));
+            throw;
+        }
+    }
+    template <typename T>
+    static void Delete(T * const ptr) {
+        if (ptr) {
+            ptr->~T();
+            Deallocate(ptr, sizeof(T));
+        }
+    }
+
+    //the size actually reserved for a request of sizeBytes, or 0 if sizeBytes is above the largest size class
+    static std::size_t GetSizeClassBytes(const std::size_t sizeBytes);
+    static void GetTelemetry(BundleBufferPoolTelemetry & telem);
+    //give the calling thread's cached blocks back to the shared free lists (done automatically when a thread exits)
+    static void FlushThreadCache();
+};
+
+#endif //_BUNDLE_BUFFER_POOL_H
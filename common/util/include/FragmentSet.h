@@ -4,6 +4,8 @@
 /*
 Manages contiguous data in a set.  Contiguous data that does not abut must be split up
 into pairs of start and end indices called a data_fragment_t
+The data_fragment_vec_t overloads keep the same fragments in a sorted contiguous vector instead of a std::set,
+which has no allocation per fragment, O(log n) lookup, and O(1) append/coalesce of in-order data (the common case).
 Used by LtpFragmentSet and AGGREGATE CUSTODY SIGNAL(ACS) / CUSTODY TRANSFER ENHANCEMENT BLOCK(CTEB)
 */
 
@@ -31,6 +33,9 @@ public:
         static bool SimulateSetKeyFind(const data_fragment_t & key, const data_fragment_t & keyInSet);
     };
 
+    //sorted by beginIndex, no overlap no abut (only modify through the functions below)
+    typedef std::vector<data_fragment_t> data_fragment_vec_t;
+
 public:
     
     static void InsertFragment(std::set<data_fragment_t> & fragmentSet, data_fragment_t key);
@@ -38,6 +43,12 @@ public:
     static bool DoesNotContainFragmentEntirely(const std::set<data_fragment_t> & fragmentSet, const data_fragment_t & key);
     static void RemoveFragment(std::set<data_fragment_t> & fragmentSet, const data_fragment_t & key);
     static void PrintFragmentSet(const std::set<data_fragment_t> & fragmentSet);
+
+    static void InsertFragment(data_fragment_vec_t & fragmentVec, const data_fragment_t & key);
+    static bool ContainsFragmentEntirely(const data_fragment_vec_t & fragmentVec, const data_fragment_t & key);
+    static bool DoesNotContainFragmentEntirely(const data_fragment_vec_t & fragmentVec, const data_fragment_t & key);
+    static void RemoveFragment(data_fragment_vec_t & fragmentVec, const data_fragment_t & key);
+    static void PrintFragmentSet(const data_fragment_vec_t & fragmentVec);
 };
 
 #endif // FRAGMENT_SET_H
@@ -0,0 +1,184 @@
+#ifndef _INTER_MODULE_CHANNEL_H
+#define _INTER_MODULE_CHANNEL_H
+
+#include <stdint.h>
+#include <iostream>
+#include <vector>
+#include <boost/function.hpp>
+#include <boost/lockfree/queue.hpp>
+#include <boost/thread/mutex.hpp>
+#include "zmq.hpp"
+#include "BundleBufferPool.h"
+
+//One-way link carrying (typed header, bundle) messages from one HDTN module to another.
+//The bundle is a zmq::message_t in every implementation since that is what the modules and the outducts already
+//forward (usually wrapping the received buffer without a copy); it is left empty for header-only messages.
+//  - ZmqInterModuleChannelSender/Receiver send a message as one or two zmq message parts over a socket
+//    (multi-process mode over tcp).
+//  - NativeInterModuleChannel moves messages through a bounded lock-free queue (hdtn_one_process), so that passing a
+//    bundle between modules costs no header allocation, no zmq message part, and no socket mutex.
+template <typename HeaderType>
+class InterModuleChannelSender {
+public:
+    virtual ~InterModuleChannelSender() {}
+    //false if the receiver can't take it right now, in which case the bundle is left untouched
+    virtual bool TrySend(const HeaderType & header, zmq::message_t & movableBundle) = 0;
+};
+
+template <typename HeaderType>
+class InterModuleChannelReceiver {
+public:
+    virtual ~InterModuleChannelReceiver() {}
+    //single receiving thread, false if no (valid) message is waiting
+    virtual bool TryReceive(HeaderType & header, zmq::message_t & bundle) = 0;
+    //true if messages may be waiting that will not wake up a zmq poll (the receiving thread must not block)
+    virtual bool HasUnpolledBacklog() const = 0;
+};
+
+template <typename HeaderType>
+class ZmqInterModuleChannelSender : public InterModuleChannelSender<HeaderType> {
+private:
+    ZmqInterModuleChannelSender();
+public:
+    //thread safe (zmq sockets are not, so sends are serialized by a mutex)
+    ZmqInterModuleChannelSender(zmq::socket_t * socketPtr) : m_socketPtr(socketPtr) {}
+
+    virtual bool TrySend(const HeaderType & header, zmq::message_t & movableBundle) {
+        //force natural/64-bit alignment
+        HeaderType * headerPtr = BundleBufferPool::New<HeaderType>();
+        *headerPtr = header;
+        zmq::message_t zmqMessageHeaderWithDataStolen(headerPtr, sizeof(HeaderType), CustomCleanupHeader, headerPtr);
+        const bool isHeaderOnly = (movableBundle.size() == 0);
+        boost::mutex::scoped_lock lock(m_socketMutex);
+        if (!m_socketPtr->send(std::move(zmqMessageHeaderWithDataStolen), (isHeaderOnly) ? zmq::send_flags::dontwait : (zmq::send_flags::sndmore | zmq::send_flags::dontwait))) {
+            return false; //at the high water mark
+        }
+        //the remaining parts of a multipart message are always accepted once the first part is
+        if ((!isHeaderOnly) && (!m_socketPtr->send(std::move(movableBundle), zmq::send_flags::dontwait))) {
+            std::cerr << "error in ZmqInterModuleChannelSender::TrySend: bundle part not sent" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+private:
+    static void CustomCleanupHeader(void * data, void * hint) {
+        BundleBufferPool::Delete(static_cast<HeaderType*>(hint));
+    }
+
+    zmq::socket_t * const m_socketPtr;
+    boost::mutex m_socketMutex;
+};
+
+template <typename HeaderType>
+class ZmqInterModuleChannelReceiver : public InterModuleChannelReceiver<HeaderType> {
+private:
+    ZmqInterModuleChannelReceiver();
+public:
+    ZmqInterModuleChannelReceiver(zmq::socket_t * socketPtr) : m_socketPtr(socketPtr) {}
+
+    virtual bool TryReceive(HeaderType & header, zmq::message_t & bundle) {
+        const zmq::recv_buffer_result_t res = m_socketPtr->recv(zmq::mutable_buffer(&header, sizeof(HeaderType)), zmq::recv_flags::dontwait);
+        if (!res) {
+            return false; //nothing waiting
+        }
+        const bool hasBundlePart = (m_socketPtr->get(zmq::sockopt::rcvmore) != 0);
+        if ((res->truncated()) || (res->size != sizeof(HeaderType))) {
+            std::cerr << "error in ZmqInterModuleChannelReceiver::TryReceive: header message mismatch: untruncated = " << res->untruncated_size
+                << " truncated = " << res->size << " expected = " << sizeof(HeaderType) << std::endl;
+            if (hasBundlePart) {
+                m_socketPtr->recv(bundle, zmq::recv_flags::none); //discard it so that it is not mistaken for the next header
+            }
+            return false;
+        }
+        if (hasBundlePart) {
+            //guaranteed to be there due to the zmq::send_flags::sndmore
+            if (!m_socketPtr->recv(bundle, zmq::recv_flags::none)) {
+                std::cerr << "error in ZmqInterModuleChannelReceiver::TryReceive: bundle part not received" << std::endl;
+                return false;
+            }
+        }
+        else {
+            bundle.rebuild();
+        }
+        return true;
+    }
+
+    virtual bool HasUnpolledBacklog() const {
+        return false; //the socket itself is polled
+    }
+
+private:
+    zmq::socket_t * const m_socketPtr;
+};
+
+//Bounded multi-producer single-consumer queue of messages.  Slots are preallocated and handed between threads through two
+//lock-free queues of slot indices (free and filled), so sends and receives never allocate or block.
+//The receiver is told about new messages through an optional notify function (called by the sending thread after every
+//successful send), which lets a thread blocked in zmq::poll keep waiting on its sockets, e.g. with an inproc signal socket.
+template <typename HeaderType>
+class NativeInterModuleChannel : public InterModuleChannelSender<HeaderType>, public InterModuleChannelReceiver<HeaderType> {
+private:
+    NativeInterModuleChannel();
+public:
+    typedef boost::function<void()> notify_receiver_function_t;
+
+    NativeInterModuleChannel(const uint32_t capacity) :
+        m_slotsVec(capacity),
+        m_freeSlotIndicesQueue(capacity),
+        m_filledSlotIndicesQueue(capacity)
+    {
+        for (uint32_t i = 0; i < capacity; ++i) {
+            m_freeSlotIndicesQueue.bounded_push(i);
+        }
+    }
+
+    //must be set before the first TrySend
+    void SetNotifyReceiverFunction(const notify_receiver_function_t & notifyReceiverFunction) {
+        m_notifyReceiverFunction = notifyReceiverFunction;
+    }
+
+    //thread safe, false if full
+    virtual bool TrySend(const HeaderType & header, zmq::message_t & movableBundle) {
+        uint32_t slotIndex;
+        if (!m_freeSlotIndicesQueue.pop(slotIndex)) {
+            return false;
+        }
+        slot_t & slot = m_slotsVec[slotIndex];
+        slot.header = header;
+        slot.bundle = std::move(movableBundle);
+        m_filledSlotIndicesQueue.bounded_push(slotIndex); //never fails since there are only capacity indices
+        if (m_notifyReceiverFunction) {
+            m_notifyReceiverFunction();
+        }
+        return true;
+    }
+
+    virtual bool TryReceive(HeaderType & header, zmq::message_t & bundle) {
+        uint32_t slotIndex;
+        if (!m_filledSlotIndicesQueue.pop(slotIndex)) {
+            return false;
+        }
+        slot_t & slot = m_slotsVec[slotIndex];
+        header = slot.header;
+        bundle = std::move(slot.bundle);
+        m_freeSlotIndicesQueue.bounded_push(slotIndex);
+        return true;
+    }
+
+    virtual bool HasUnpolledBacklog() const {
+        return !m_filledSlotIndicesQueue.empty();
+    }
+
+private:
+    struct slot_t {
+        HeaderType header;
+        zmq::message_t bundle;
+    };
+    std::vector<slot_t> m_slotsVec;
+    boost::lockfree::queue<uint32_t> m_freeSlotIndicesQueue;
+    boost::lockfree::queue<uint32_t> m_filledSlotIndicesQueue;
+    notify_receiver_function_t m_notifyReceiverFunction;
+};
+
+#endif //_INTER_MODULE_CHANNEL_H
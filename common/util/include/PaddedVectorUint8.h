@@ -6,8 +6,11 @@
 #include <limits>
 #include <iostream>
 #include <vector>
+#include "BundleBufferPool.h"
 
 //https://en.cppreference.com/w/cpp/named_req/Allocator
+//Memory comes from the BundleBufferPool size classes rather than straight from malloc, since every received bundle
+//lives in one of these.
 
 template <class T>
 struct PaddedMallocator {
@@ -26,7 +29,7 @@ struct PaddedMallocator {
         //if (elementsWithPadding > std::numeric_limits<std::size_t>::max() / sizeof(T))
         //    throw std::bad_array_new_length();
 
-        if (T* p = static_cast<T*>(std::malloc(elementsWithPadding * sizeof(T)))) {
+        if (T* p = static_cast<T*>(BundleBufferPool::Allocate(elementsWithPadding * sizeof(T)))) {
 #ifdef PADDED_VECTOR_UNIT_TESTING
             static const std::vector<std::string> testStringsVec = { "padding_start", "before_data", "after_reserved", "padding_end" };
             //std::cout << "n " << n << "\n";
@@ -46,7 +49,7 @@ struct PaddedMallocator {
     }
 
     void deallocate(T* p, std::size_t n) noexcept {
-        std::free(p - PADDING_ELEMENTS_BEFORE);
+        BundleBufferPool::Deallocate(p - PADDING_ELEMENTS_BEFORE, (n + TOTAL_PADDING_ELEMENTS) * sizeof(T));
     }
 };
 
@@ -64,7 +64,7 @@ HDTN_UTIL_EXPORT uint32_t SdnvDecodeU32FastBufSize8(const uint8_t * data, uint8_
 //  also sets parameter numBytes taken to decode (set to 0 on failure)
 HDTN_UTIL_EXPORT uint64_t SdnvDecodeU64FastBufSize16(const uint8_t * data, uint8_t * numBytes);
 
-//return num values decoded this iteration
+//return num values decoded this iteration (decoding stops before an invalid sdnv, i.e. one longer than 10 bytes or not fitting in 64 bits)
 HDTN_UTIL_EXPORT unsigned int SdnvDecodeMultipleU64Fast(const uint8_t * data, uint8_t * numBytes, uint64_t * decodedValues, unsigned int decodedRemaining);
 
 
@@ -0,0 +1,88 @@
+#ifndef _SHARED_MEMORY_BUNDLE_ARENA_H
+#define _SHARED_MEMORY_BUNDLE_ARENA_H
+
+#include <stdint.h>
+#include <string>
+#include <boost/shared_ptr.hpp>
+#include <boost/interprocess/shared_memory_object.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include "zmq.hpp"
+#include "hdtn_util_export.h"
+
+//Sent over zmq in place of the bundle body when the body lives in a shared memory arena.
+struct shm_bundle_descriptor_t {
+    uint64_t arenaSessionId; //which creation of the arena the slab belongs to
+    uint64_t bundleSizeBytes;
+    uint32_t slabIndex;
+    uint32_t unused;
+};
+
+struct shm_arena_header_t;
+struct shm_slab_header_t;
+
+//Shared memory (POSIX shm on Linux) divided into fixed size slabs, used to pass bundle bodies between HDTN processes
+//on the same host so that only a small shm_bundle_descriptor_t travels over zmq.
+//Each arena has exactly one producing process, which creates it (removing any stale arena of the same name) and copies
+//bundles into free slabs.  Consuming processes open it and turn descriptors into zero-copy zmq messages whose
+//deleter drops the slab's reference count; the slab returns to the free list (a lock-free stack in the shared
+//memory, safe across processes) when the count reaches zero.  Bundles larger than a slab, or arriving while no
+//slab is free, must be sent the normal way by the caller.
+class HDTN_UTIL_EXPORT SharedMemoryBundleArena {
+private:
+    SharedMemoryBundleArena();
+    SharedMemoryBundleArena(const std::string & name, const bool isProducer);
+public:
+    ~SharedMemoryBundleArena(); //the producer removes the name (mappings held by consumers stay valid)
+
+    //producer, NULL on failure
+    static boost::shared_ptr<SharedMemoryBundleArena> Create(const std::string & name, const uint32_t numSlabs, const uint64_t slabSizeBytes);
+    //consumer, NULL if the arena does not exist (yet) or is not a bundle arena
+    static boost::shared_ptr<SharedMemoryBundleArena> Open(const std::string & name);
+
+    //producer: copies the bundle into a free slab (reference count 1), false if too big or no slab is free
+    bool CopyIn(const uint8_t * bundleData, const std::size_t bundleSizeBytes, shm_bundle_descriptor_t & descriptor);
+    //drops one reference (e.g. the producer could not send the descriptor)
+    void Release(const uint32_t slabIndex);
+    //consumer: zero-copy message holding the slab's reference, false if the descriptor is not from this arena
+    static bool MoveToZmqMessage(const boost::shared_ptr<SharedMemoryBundleArena> & arenaPtr, const shm_bundle_descriptor_t & descriptor, zmq::message_t & zmqMessage);
+
+    uint64_t GetSessionId() const;
+    uint32_t GetNumSlabs() const;
+    uint64_t GetSlabSizeBytes() const;
+    uint32_t GetNumFreeSlabs() const;
+    const std::string & GetName() const;
+
+    //one arena per producer and per hdtn instance (the port number of one of the producer's bound or connecting paths)
+    static std::string GetArenaName(const uint16_t producerPortPath);
+
+private:
+    bool PopFreeSlab(uint32_t & slabIndex);
+    void PushFreeSlab(const uint32_t slabIndex);
+    bool Map(const boost::interprocess::mode_t mode);
+
+    std::string m_name;
+    bool m_isProducer;
+    boost::interprocess::shared_memory_object m_sharedMemoryObject;
+    boost::interprocess::mapped_region m_mappedRegion;
+    shm_arena_header_t * m_headerPtr;
+    shm_slab_header_t * m_slabHeadersPtr;
+    uint8_t * m_slabDataPtr;
+};
+
+//Consumer side of one arena, reopening it whenever descriptors start arriving from a new creation
+//(i.e. the producing process was restarted).  Not thread safe.
+class HDTN_UTIL_EXPORT SharedMemoryBundleArenaReader {
+private:
+    SharedMemoryBundleArenaReader();
+public:
+    SharedMemoryBundleArenaReader(const std::string & arenaName);
+    ~SharedMemoryBundleArenaReader();
+    //the descriptor message part is replaced by the bundle, false (with the message untouched) on error
+    bool ReplaceDescriptorWithBundle(zmq::message_t & zmqMessage);
+
+private:
+    const std::string M_ARENA_NAME;
+    boost::shared_ptr<SharedMemoryBundleArena> m_arenaPtr;
+};
+
+#endif //_SHARED_MEMORY_BUNDLE_ARENA_H
@@ -0,0 +1,35 @@
+#ifndef _UNIQUE_INDEX_QUEUE_MULTI_PRODUCER_SINGLE_CONSUMER_H
+#define _UNIQUE_INDEX_QUEUE_MULTI_PRODUCER_SINGLE_CONSUMER_H
+
+#include <stdint.h>
+#include <memory>
+#include <boost/atomic.hpp>
+#include <boost/lockfree/queue.hpp>
+#include "hdtn_util_export.h"
+
+//Lock-free queue of indices in the range [0, numIndices) where an index is queued at most once until the consumer pops it.
+//Producer threads call Push_ThreadSafe after updating the state belonging to an index (e.g. an outduct's ack counters),
+//and the single consumer thread then only visits the indices that reported progress instead of scanning all of them.
+//Pop clears the queued flag before returning, so a push racing with the consumer's processing of that index queues it again
+//rather than being lost.  Since at most numIndices entries are ever queued, pushes never allocate and never fail.
+class HDTN_UTIL_EXPORT UniqueIndexQueueMultiProducerSingleConsumer {
+private:
+    UniqueIndexQueueMultiProducerSingleConsumer();
+public:
+    UniqueIndexQueueMultiProducerSingleConsumer(const uint32_t numIndices);
+    ~UniqueIndexQueueMultiProducerSingleConsumer();
+
+    //returns true if the index was newly queued, false if already queued (or out of range)
+    bool Push_ThreadSafe(const uint32_t index);
+    //consumer thread only, returns false if empty
+    bool Pop(uint32_t & index);
+    uint32_t GetNumIndices() const;
+
+private:
+    const uint32_t M_NUM_INDICES;
+    std::unique_ptr<boost::atomic<bool>[]> m_isQueuedArray;
+    boost::lockfree::queue<uint32_t> m_queue;
+};
+
+
+#endif //_UNIQUE_INDEX_QUEUE_MULTI_PRODUCER_SINGLE_CONSUMER_H
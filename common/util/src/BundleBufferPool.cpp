@@ -0,0 +1,326 @@
+#include "BundleBufferPool.h"
+#include <cstdlib>
+#include <vector>
+#include <boost/atomic.hpp>
+#include <boost/thread/mutex.hpp>
+#ifdef __linux__
+#include <sys/mman.h>
+#else
+#include <boost/align/aligned_alloc.hpp>
+#endif
+
+static const std::size_t SMALLEST_SIZE_CLASS_BYTES = 64;
+static const unsigned int NUM_LINEAR_SIZE_CLASSES = 4; //64, 128, 192, 256
+static const unsigned int NUM_SIZE_CLASSES_PER_POWER_OF_TWO = 4;
+static const unsigned int LARGEST_SIZE_CLASS_POWER_OF_TWO = 24; //16 MiB
+static const unsigned int NUM_SIZE_CLASSES = NUM_LINEAR_SIZE_CLASSES + (NUM_SIZE_CLASSES_PER_POWER_OF_TWO * (LARGEST_SIZE_CLASS_POWER_OF_TWO - 8));
+static const std::size_t LARGEST_SIZE_CLASS_BYTES = static_cast<std::size_t>(1) << LARGEST_SIZE_CLASS_POWER_OF_TWO;
+
+static const std::size_t SLAB_SIZE_BYTES = static_cast<std::size_t>(1) << 21; //2 MiB, one x86-64 huge page
+static const std::size_t LARGEST_SLAB_CARVED_SIZE_CLASS_BYTES = static_cast<std::size_t>(1) << 19; //512 KiB
+//per thread and size class, how many bytes of blocks may be kept before half of them go back to the shared free list
+static const std::size_t THREAD_CACHE_BYTES_PER_SIZE_CLASS = static_cast<std::size_t>(1) << 18; //256 KiB
+static const unsigned int MAX_THREAD_CACHE_BLOCKS_PER_SIZE_CLASS = 64;
+//individually mapped blocks beyond this (per size class) on the shared free list are returned to the system
+static const std::size_t MAX_SHARED_FREE_LIST_BYTES_PER_MAPPED_SIZE_CLASS = static_cast<std::size_t>(1) << 26; //64 MiB
+
+static unsigned int FloorLog2(std::size_t v) {
+    unsigned int r = 0;
+    if (static_cast<uint64_t>(v) >> 32) { v = static_cast<std::size_t>(static_cast<uint64_t>(v) >> 32); r += 32; }
+    if (v >> 16) { v >>= 16; r += 16; }
+    if (v >> 8) { v >>= 8; r += 8; }
+    if (v >> 4) { v >>= 4; r += 4; }
+    if (v >> 2) { v >>= 2; r += 2; }
+    if (v >> 1) { r += 1; }
+    return r;
+}
+
+//sizeBytes must not exceed LARGEST_SIZE_CLASS_BYTES
+static unsigned int SizeToClassIndex(const std::size_t sizeBytes) {
+    if (sizeBytes <= (NUM_LINEAR_SIZE_CLASSES * SMALLEST_SIZE_CLASS_BYTES)) {
+        return (sizeBytes == 0) ? 0 : static_cast<unsigned int>((sizeBytes - 1) / SMALLEST_SIZE_CLASS_BYTES);
+    }
+    //2^p < sizeBytes <= 2^(p+1), split into four classes of 2^(p-2) bytes each
+    const unsigned int p = FloorLog2(sizeBytes - 1);
+    const unsigned int subClass = static_cast<unsigned int>((sizeBytes - 1) >> (p - 2)) - NUM_SIZE_CLASSES_PER_POWER_OF_TWO;
+    return NUM_LINEAR_SIZE_CLASSES + ((p - 8) * NUM_SIZE_CLASSES_PER_POWER_OF_TWO) + subClass;
+}
+
+static std::size_t ClassIndexToSize(const unsigned int classIndex) {
+    if (classIndex < NUM_LINEAR_SIZE_CLASSES) {
+        return (classIndex + 1) * SMALLEST_SIZE_CLASS_BYTES;
+    }
+    const unsigned int j = classIndex - NUM_LINEAR_SIZE_CLASSES;
+    const unsigned int p = 8 + (j / NUM_SIZE_CLASSES_PER_POWER_OF_TWO);
+    const std::size_t subClass = j % NUM_SIZE_CLASSES_PER_POWER_OF_TWO;
+    return (static_cast<std::size_t>(1) << p) + ((subClass + 1) << (p - 2));
+}
+
+static unsigned int ThreadCacheLimit(const std::size_t classSizeBytes) {
+    if (classSizeBytes > LARGEST_SLAB_CARVED_SIZE_CLASS_BYTES) {
+        return 0; //individually mapped blocks always go through the shared free list
+    }
+    const std::size_t limit = THREAD_CACHE_BYTES_PER_SIZE_CLASS / classSizeBytes;
+    return (limit < 2) ? 2 : (limit > MAX_THREAD_CACHE_BLOCKS_PER_SIZE_CLASS) ? MAX_THREAD_CACHE_BLOCKS_PER_SIZE_CLASS : static_cast<unsigned int>(limit);
+}
+
+static void * SystemMap(const std::size_t sizeBytes, const bool hugePageAligned) {
+#ifdef __linux__
+    if (!hugePageAligned) {
+        void * const ptr = mmap(NULL, sizeBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        return (ptr == MAP_FAILED) ? NULL : ptr;
+    }
+    //over-map by a huge page and trim so that the start is 2 MiB aligned (transparent huge pages need aligned extents)
+    const std::size_t mapSizeBytes = sizeBytes + SLAB_SIZE_BYTES;
+    void * const rawPtr = mmap(NULL, mapSizeBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (rawPtr == MAP_FAILED) {
+        return NULL;
+    }
+    const uintptr_t raw = reinterpret_cast<uintptr_t>(rawPtr);
+    const uintptr_t aligned = (raw + (SLAB_SIZE_BYTES - 1)) & ~static_cast<uintptr_t>(SLAB_SIZE_BYTES - 1);
+    const std::size_t headBytes = aligned - raw;
+    const std::size_t tailBytes = mapSizeBytes - headBytes - sizeBytes;
+    if (headBytes) {
+        munmap(rawPtr, headBytes);
+    }
+    if (tailBytes) {
+        munmap(reinterpret_cast<void*>(aligned + sizeBytes), tailBytes);
+    }
+#ifdef MADV_HUGEPAGE
+    madvise(reinterpret_cast<void*>(aligned), sizeBytes, MADV_HUGEPAGE); //only a hint, ignore failure (e.g. THP disabled)
+#endif
+    return reinterpret_cast<void*>(aligned);
+#else
+    return boost::alignment::aligned_alloc((hugePageAligned) ? SLAB_SIZE_BYTES : SMALLEST_SIZE_CLASS_BYTES, sizeBytes);
+#endif
+}
+
+static void SystemUnmap(void * ptr, const std::size_t sizeBytes) {
+#ifdef __linux__
+    munmap(ptr, sizeBytes);
+#else
+    (void)sizeBytes;
+    boost::alignment::aligned_free(ptr);
+#endif
+}
+
+struct SharedSizeClass {
+    SharedSizeClass() : sizeBytes(0), isSlabCarved(false), slabCurrentPtr(NULL), slabRemainingBytes(0) {}
+    boost::mutex mutex;
+    std::size_t sizeBytes;
+    bool isSlabCarved;
+    std::vector<void*> freeBlocks;
+    uint8_t * slabCurrentPtr;
+    std::size_t slabRemainingBytes;
+};
+
+struct BundleBufferPoolShared {
+    BundleBufferPoolShared() :
+        totalSystemAllocations(0), totalSystemAllocatedBytes(0), totalSystemDeallocations(0),
+        totalOversizedAllocations(0), totalThreadCacheRefills(0), totalThreadCacheFlushes(0)
+    {
+        for (unsigned int i = 0; i < NUM_SIZE_CLASSES; ++i) {
+            sizeClasses[i].sizeBytes = ClassIndexToSize(i);
+            sizeClasses[i].isSlabCarved = (sizeClasses[i].sizeBytes <= LARGEST_SLAB_CARVED_SIZE_CLASS_BYTES);
+        }
+    }
+
+    //fills blocks with 1 to maxBlocks blocks and returns how many, throws std::bad_alloc
+    unsigned int TakeBlocks(const unsigned int classIndex, void ** blocks, const unsigned int maxBlocks) {
+        SharedSizeClass & sc = sizeClasses[classIndex];
+        unsigned int numTaken = 0;
+        boost::mutex::scoped_lock lock(sc.mutex);
+        while ((numTaken < maxBlocks) && (!sc.freeBlocks.empty())) {
+            blocks[numTaken++] = sc.freeBlocks.back();
+            sc.freeBlocks.pop_back();
+        }
+        if (numTaken) {
+            return numTaken;
+        }
+        if (!sc.isSlabCarved) {
+            void * const ptr = SystemMap(sc.sizeBytes, sc.sizeBytes >= SLAB_SIZE_BYTES);
+            if (ptr == NULL) {
+                throw std::bad_alloc();
+            }
+            CountSystemAllocation(sc.sizeBytes);
+            blocks[0] = ptr;
+            return 1;
+        }
+        if (sc.slabRemainingBytes < sc.sizeBytes) { //the remainder of the old slab (if any) is left unused
+            void * const ptr = SystemMap(SLAB_SIZE_BYTES, true);
+            if (ptr == NULL) {
+                throw std::bad_alloc();
+            }
+            CountSystemAllocation(SLAB_SIZE_BYTES);
+            sc.slabCurrentPtr = static_cast<uint8_t*>(ptr);
+            sc.slabRemainingBytes = SLAB_SIZE_BYTES;
+        }
+        while ((numTaken < maxBlocks) && (sc.slabRemainingBytes >= sc.sizeBytes)) {
+            blocks[numTaken++] = sc.slabCurrentPtr;
+            sc.slabCurrentPtr += sc.sizeBytes;
+            sc.slabRemainingBytes -= sc.sizeBytes;
+        }
+        return numTaken;
+    }
+
+    void GiveBlocks(const unsigned int classIndex, void * const * blocks, const unsigned int numBlocks) {
+        SharedSizeClass & sc = sizeClasses[classIndex];
+        boost::mutex::scoped_lock lock(sc.mutex);
+        for (unsigned int i = 0; i < numBlocks; ++i) {
+            if ((!sc.isSlabCarved) && ((sc.freeBlocks.size() * sc.sizeBytes) >= MAX_SHARED_FREE_LIST_BYTES_PER_MAPPED_SIZE_CLASS)) {
+                SystemUnmap(blocks[i], sc.sizeBytes);
+                totalSystemDeallocations.fetch_add(1, boost::memory_order_relaxed);
+            }
+            else {
+                sc.freeBlocks.push_back(blocks[i]);
+            }
+        }
+    }
+
+    void CountSystemAllocation(const std::size_t sizeBytes) {
+        totalSystemAllocations.fetch_add(1, boost::memory_order_relaxed);
+        totalSystemAllocatedBytes.fetch_add(sizeBytes, boost::memory_order_relaxed);
+    }
+
+    SharedSizeClass sizeClasses[NUM_SIZE_CLASSES];
+    boost::atomic<uint64_t> totalSystemAllocations;
+    boost::atomic<uint64_t> totalSystemAllocatedBytes;
+    boost::atomic<uint64_t> totalSystemDeallocations;
+    boost::atomic<uint64_t> totalOversizedAllocations;
+    boost::atomic<uint64_t> totalThreadCacheRefills;
+    boost::atomic<uint64_t> totalThreadCacheFlushes;
+};
+
+//intentionally never destroyed so that buffers freed during static destruction or by late exiting threads still have a home
+static BundleBufferPoolShared & GetShared() {
+    static BundleBufferPoolShared * const sharedPtr = new BundleBufferPoolShared();
+    return *sharedPtr;
+}
+
+struct ThreadCacheList {
+    ThreadCacheList() : count(0), limit(0) {}
+    unsigned int count;
+    unsigned int limit;
+    void * blocks[MAX_THREAD_CACHE_BLOCKS_PER_SIZE_CLASS];
+};
+
+struct ThreadCache {
+    ThreadCache() {
+        for (unsigned int i = 0; i < NUM_SIZE_CLASSES; ++i) {
+            lists[i].limit = ThreadCacheLimit(ClassIndexToSize(i));
+        }
+    }
+    void FlushAll() {
+        BundleBufferPoolShared & shared = GetShared();
+        for (unsigned int i = 0; i < NUM_SIZE_CLASSES; ++i) {
+            if (lists[i].count) {
+                shared.GiveBlocks(i, lists[i].blocks, lists[i].count);
+                lists[i].count = 0;
+            }
+        }
+    }
+    ThreadCacheList lists[NUM_SIZE_CLASSES];
+};
+
+//The cache itself is heap allocated on a thread's first use.  Only the owner has a destructor, so the trivially
+//destructible pointer and flag stay usable while other thread_local objects free buffers during thread exit.
+static thread_local ThreadCache * t_threadCachePtr = NULL;
+static thread_local bool t_threadCacheDestroyed = false;
+struct ThreadCacheOwner {
+    ~ThreadCacheOwner() {
+        if (t_threadCachePtr) {
+            t_threadCachePtr->FlushAll();
+            delete t_threadCachePtr;
+            t_threadCachePtr = NULL;
+        }
+        t_threadCacheDestroyed = true;
+    }
+    void Touch() {}
+};
+static thread_local ThreadCacheOwner t_threadCacheOwner;
+
+//NULL once the thread is exiting, in which case the shared free lists are used directly
+static ThreadCache * GetThreadCache() {
+    if ((t_threadCachePtr == NULL) && (!t_threadCacheDestroyed)) {
+        t_threadCachePtr = new ThreadCache();
+        t_threadCacheOwner.Touch(); //registers the owner's destructor for this thread
+    }
+    return t_threadCachePtr;
+}
+
+void * BundleBufferPool::Allocate(const std::size_t sizeBytes) {
+    if (sizeBytes > LARGEST_SIZE_CLASS_BYTES) {
+        void * const ptr = std::malloc(sizeBytes);
+        if (ptr == NULL) {
+            throw std::bad_alloc();
+        }
+        BundleBufferPoolShared & shared = GetShared();
+        shared.totalOversizedAllocations.fetch_add(1, boost::memory_order_relaxed);
+        shared.CountSystemAllocation(sizeBytes);
+        return ptr;
+    }
+    const unsigned int classIndex = SizeToClassIndex(sizeBytes);
+    ThreadCache * const threadCachePtr = GetThreadCache();
+    if ((threadCachePtr == NULL) || (threadCachePtr->lists[classIndex].limit == 0)) {
+        void * ptr;
+        GetShared().TakeBlocks(classIndex, &ptr, 1);
+        return ptr;
+    }
+    ThreadCacheList & list = threadCachePtr->lists[classIndex];
+    if (list.count == 0) {
+        BundleBufferPoolShared & shared = GetShared();
+        list.count = shared.TakeBlocks(classIndex, list.blocks, list.limit / 2);
+        shared.totalThreadCacheRefills.fetch_add(1, boost::memory_order_relaxed);
+    }
+    return list.blocks[--list.count];
+}
+
+void BundleBufferPool::Deallocate(void * ptr, const std::size_t sizeBytes) {
+    if (ptr == NULL) {
+        return;
+    }
+    if (sizeBytes > LARGEST_SIZE_CLASS_BYTES) {
+        std::free(ptr);
+        GetShared().totalSystemDeallocations.fetch_add(1, boost::memory_order_relaxed);
+        return;
+    }
+    const unsigned int classIndex = SizeToClassIndex(sizeBytes);
+    ThreadCache * const threadCachePtr = GetThreadCache();
+    if ((threadCachePtr == NULL) || (threadCachePtr->lists[classIndex].limit == 0)) {
+        GetShared().GiveBlocks(classIndex, &ptr, 1);
+        return;
+    }
+    ThreadCacheList & list = threadCachePtr->lists[classIndex];
+    if (list.count == list.limit) {
+        //keep the most recently freed (cache warm) half
+        const unsigned int numToGive = list.limit / 2;
+        BundleBufferPoolShared & shared = GetShared();
+        shared.GiveBlocks(classIndex, list.blocks, numToGive);
+        list.count -= numToGive;
+        for (unsigned int i = 0; i < list.count; ++i) {
+            list.blocks[i] = list.blocks[i + numToGive];
+        }
+        shared.totalThreadCacheFlushes.fetch_add(1, boost::memory_order_relaxed);
+    }
+    list.blocks[list.count++] = ptr;
+}
+
+std::size_t BundleBufferPool::GetSizeClassBytes(const std::size_t sizeBytes) {
+    return (sizeBytes > LARGEST_SIZE_CLASS_BYTES) ? 0 : ClassIndexToSize(SizeToClassIndex(sizeBytes));
+}
+
+void BundleBufferPool::GetTelemetry(BundleBufferPoolTelemetry & telem) {
+    BundleBufferPoolShared & shared = GetShared();
+    telem.totalSystemAllocations = shared.totalSystemAllocations.load(boost::memory_order_relaxed);
+    telem.totalSystemAllocatedBytes = shared.totalSystemAllocatedBytes.load(boost::memory_order_relaxed);
+    telem.totalSystemDeallocations = shared.totalSystemDeallocations.load(boost::memory_order_relaxed);
+    telem.totalOversizedAllocations = shared.totalOversizedAllocations.load(boost::memory_order_relaxed);
+    telem.totalThreadCacheRefills = shared.totalThreadCacheRefills.load(boost::memory_order_relaxed);
+    telem.totalThreadCacheFlushes = shared.totalThreadCacheFlushes.load(boost::memory_order_relaxed);
+}
+
+void BundleBufferPool::FlushThreadCache() {
+    if (t_threadCachePtr) {
+        t_threadCachePtr->FlushAll();
+    }
+}
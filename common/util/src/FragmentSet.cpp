@@ -176,3 +176,81 @@ void FragmentSet::PrintFragmentSet(const std::set<data_fragment_t> & fragmentSet
     }
     std::cout << std::endl;
 }
+
+void FragmentSet::InsertFragment(data_fragment_vec_t & fragmentVec, const data_fragment_t & key) {
+    if (fragmentVec.empty() || (fragmentVec.back() < key)) { //in order data with a gap (no overlap no abut), append
+        fragmentVec.push_back(key);
+        return;
+    }
+    if (key.beginIndex >= fragmentVec.back().beginIndex) { //in order data that overlaps or abuts only the last fragment, extend it
+        fragmentVec.back().endIndex = std::max(fragmentVec.back().endIndex, key.endIndex);
+        return;
+    }
+    //[first, last) are the fragments that overlap or abut the key
+    data_fragment_vec_t::iterator first = std::lower_bound(fragmentVec.begin(), fragmentVec.end(), key);
+    data_fragment_vec_t::iterator last = std::upper_bound(first, fragmentVec.end(), key);
+    if (first == last) { //no overlap nor abut
+        fragmentVec.insert(first, key);
+        return;
+    }
+    //coalesce into the first and erase the rest
+    first->beginIndex = std::min(first->beginIndex, key.beginIndex);
+    first->endIndex = std::max(boost::prior(last)->endIndex, key.endIndex);
+    fragmentVec.erase(boost::next(first), last);
+}
+
+bool FragmentSet::ContainsFragmentEntirely(const data_fragment_vec_t & fragmentVec, const data_fragment_t & key) {
+    data_fragment_vec_t::const_iterator res = std::lower_bound(fragmentVec.cbegin(), fragmentVec.cend(), key);
+    if ((res == fragmentVec.cend()) || (key < *res)) { //not found (nothing that overlaps or abuts)
+        return false;
+    }
+    return ((key.beginIndex >= res->beginIndex) && (key.endIndex <= res->endIndex));
+}
+
+static bool EndIndexLessThanBeginIndex(const FragmentSet::data_fragment_t & a, const FragmentSet::data_fragment_t & b) { //no overlap allow abut
+    return (a.endIndex < b.beginIndex);
+}
+
+bool FragmentSet::DoesNotContainFragmentEntirely(const data_fragment_vec_t & fragmentVec, const data_fragment_t & key) {
+    //first fragment not entirely before the key
+    data_fragment_vec_t::const_iterator res = std::lower_bound(fragmentVec.cbegin(), fragmentVec.cend(), key, EndIndexLessThanBeginIndex);
+    return ((res == fragmentVec.cend()) || (key.endIndex < res->beginIndex));
+}
+
+void FragmentSet::RemoveFragment(data_fragment_vec_t & fragmentVec, const data_fragment_t & key) {
+    const uint64_t deleteBegin = key.beginIndex;
+    const uint64_t deleteEnd = key.endIndex;
+    if (deleteBegin > deleteEnd) { //invalid, stop
+        return;
+    }
+    //[first, last) are the fragments that overlap the key
+    data_fragment_vec_t::iterator first = std::lower_bound(fragmentVec.begin(), fragmentVec.end(), key, EndIndexLessThanBeginIndex);
+    data_fragment_vec_t::iterator last = std::upper_bound(first, fragmentVec.end(), key, EndIndexLessThanBeginIndex);
+    if (first == last) {
+        return;
+    }
+    const uint64_t lastFragmentEndIndex = boost::prior(last)->endIndex;
+    if ((boost::next(first) == last) && (deleteBegin > first->beginIndex) && (deleteEnd < lastFragmentEndIndex)) { //split fragment in 2
+        first->endIndex = deleteBegin - 1;
+        fragmentVec.insert(boost::next(first), data_fragment_t(deleteEnd + 1, lastFragmentEndIndex));
+        return;
+    }
+    data_fragment_vec_t::iterator eraseBegin = first;
+    data_fragment_vec_t::iterator eraseEnd = last;
+    if (deleteBegin > first->beginIndex) { //alter right side of first only
+        first->endIndex = deleteBegin - 1;
+        ++eraseBegin;
+    }
+    if (deleteEnd < lastFragmentEndIndex) { //alter left side of last only
+        --eraseEnd;
+        eraseEnd->beginIndex = deleteEnd + 1;
+    }
+    fragmentVec.erase(eraseBegin, eraseEnd);
+}
+
+void FragmentSet::PrintFragmentSet(const data_fragment_vec_t & fragmentVec) {
+    for (data_fragment_vec_t::const_iterator it = fragmentVec.cbegin(); it != fragmentVec.cend(); ++it) {
+        std::cout << "(" << it->beginIndex << "," << it->endIndex << ") ";
+    }
+    std::cout << std::endl;
+}
@@ -880,6 +880,9 @@ unsigned int SdnvDecodeMultipleU64Fast(const uint8_t * data, uint8_t * numBytes,
         }
         
         const uint64_t encoded64 = _mm_cvtsi128_si64(sdnvsEncoded); //SSE2 Copy the lower 64-bit integer in a to dst.
+        if (((((uint16_t)maskIndex) << 8) | ((uint8_t)encoded64)) > 0x0981U) { //more than 10 bytes or does not fit in 64 bits (invalid), leave it undecoded
+            break;
+        }
         const uint64_t u64ByteSwapped = boost::endian::big_to_native(encoded64);
         uint64_t decoded = _pext_u64(u64ByteSwapped, masksPdepPext1[maskIndex]);
         decoded <<= decodedShifts[maskIndex];
@@ -981,6 +984,9 @@ unsigned int SdnvDecodeMultiple256BitU64Fast(const uint8_t * data, uint8_t * num
         }
 
         const uint64_t encoded64 = _mm_cvtsi128_si64(_mm256_castsi256_si128(sdnvsEncoded)); //SSE2 Copy the lower 64-bit integer in a to dst.
+        if (((((uint16_t)maskIndex) << 8) | ((uint8_t)encoded64)) > 0x0981U) { //more than 10 bytes or does not fit in 64 bits (invalid), leave it undecoded
+            break;
+        }
         const uint64_t u64ByteSwapped = boost::endian::big_to_native(encoded64);
         uint64_t decoded = _pext_u64(u64ByteSwapped, masksPdepPext1[maskIndex]);
         decoded <<= decodedShifts[maskIndex];
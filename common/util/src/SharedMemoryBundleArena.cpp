@@ -0,0 +1,257 @@
+#include "SharedMemoryBundleArena.h"
+#include <iostream>
+#include <cstring>
+#include <new>
+#include <random>
+#include <boost/atomic.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/interprocess/exceptions.hpp>
+
+#if !defined(BOOST_ATOMIC_INT64_LOCK_FREE) || (BOOST_ATOMIC_INT64_LOCK_FREE != 2) || (BOOST_ATOMIC_INT32_LOCK_FREE != 2)
+#error "SharedMemoryBundleArena requires lock-free 32 and 64 bit atomics (they are shared between processes)"
+#endif
+
+static constexpr uint64_t ARENA_MAGIC = 0x48444e5441524e41; //"HDNTARNA"
+static constexpr uint64_t ARENA_ALIGNMENT = 64; //cache line
+
+struct shm_arena_header_t {
+    uint64_t magic; //written last by the producer
+    uint64_t sessionId;
+    uint64_t slabSizeBytes;
+    uint32_t numSlabs;
+    uint32_t unused;
+    boost::atomic<uint64_t> freeListHeadAndTag; //low 32 bits: slab index + 1 (0 when empty), high 32 bits: ABA tag
+    boost::atomic<uint32_t> numFreeSlabs;
+};
+
+struct shm_slab_header_t {
+    boost::atomic<uint32_t> refCount;
+    boost::atomic<uint32_t> nextFreeSlabIndexPlusOne;
+};
+
+static uint64_t AlignUp(const uint64_t value) {
+    return (value + (ARENA_ALIGNMENT - 1)) & ~(ARENA_ALIGNMENT - 1);
+}
+static uint64_t GetSlabHeadersOffset() {
+    return AlignUp(sizeof(shm_arena_header_t));
+}
+static uint64_t GetSlabDataOffset(const uint32_t numSlabs) {
+    return AlignUp(GetSlabHeadersOffset() + (numSlabs * sizeof(shm_slab_header_t)));
+}
+
+SharedMemoryBundleArena::SharedMemoryBundleArena(const std::string & name, const bool isProducer) :
+    m_name(name),
+    m_isProducer(isProducer),
+    m_headerPtr(NULL),
+    m_slabHeadersPtr(NULL),
+    m_slabDataPtr(NULL) {}
+
+SharedMemoryBundleArena::~SharedMemoryBundleArena() {
+    if (m_isProducer && m_headerPtr) {
+        //only if the name still refers to this arena (not to a newer one created after it)
+        boost::shared_ptr<SharedMemoryBundleArena> currentArenaPtr = Open(m_name);
+        if (currentArenaPtr && (currentArenaPtr->GetSessionId() == m_headerPtr->sessionId)) {
+            boost::interprocess::shared_memory_object::remove(m_name.c_str());
+        }
+    }
+}
+
+bool SharedMemoryBundleArena::Map(const boost::interprocess::mode_t mode) {
+    m_mappedRegion = boost::interprocess::mapped_region(m_sharedMemoryObject, mode);
+    if (m_mappedRegion.get_size() < GetSlabHeadersOffset()) {
+        return false;
+    }
+    uint8_t * const basePtr = static_cast<uint8_t*>(m_mappedRegion.get_address());
+    m_headerPtr = reinterpret_cast<shm_arena_header_t*>(basePtr);
+    m_slabHeadersPtr = reinterpret_cast<shm_slab_header_t*>(basePtr + GetSlabHeadersOffset());
+    return true;
+}
+
+boost::shared_ptr<SharedMemoryBundleArena> SharedMemoryBundleArena::Create(const std::string & name, const uint32_t numSlabs, const uint64_t slabSizeBytes) {
+    if ((numSlabs == 0) || (slabSizeBytes == 0)) {
+        return boost::shared_ptr<SharedMemoryBundleArena>();
+    }
+    const uint64_t alignedSlabSizeBytes = AlignUp(slabSizeBytes);
+    const uint64_t totalSizeBytes = GetSlabDataOffset(numSlabs) + (numSlabs * alignedSlabSizeBytes);
+    boost::shared_ptr<SharedMemoryBundleArena> arenaPtr(new SharedMemoryBundleArena(name, true));
+    try {
+        //a stale arena left by a previous run of this producer may still be holding slabs that will never be released
+        boost::interprocess::shared_memory_object::remove(name.c_str());
+        arenaPtr->m_sharedMemoryObject = boost::interprocess::shared_memory_object(boost::interprocess::create_only, name.c_str(), boost::interprocess::read_write);
+        arenaPtr->m_sharedMemoryObject.truncate(static_cast<boost::interprocess::offset_t>(totalSizeBytes));
+        if (!arenaPtr->Map(boost::interprocess::read_write)) {
+            return boost::shared_ptr<SharedMemoryBundleArena>();
+        }
+    }
+    catch (const boost::interprocess::interprocess_exception & e) {
+        std::cerr << "error in SharedMemoryBundleArena::Create: cannot create " << name << " (" << totalSizeBytes << " bytes): " << e.what() << std::endl;
+        return boost::shared_ptr<SharedMemoryBundleArena>();
+    }
+    arenaPtr->m_slabDataPtr = static_cast<uint8_t*>(arenaPtr->m_mappedRegion.get_address()) + GetSlabDataOffset(numSlabs);
+
+    shm_arena_header_t * const headerPtr = new (arenaPtr->m_headerPtr) shm_arena_header_t();
+    std::random_device randomDevice;
+    headerPtr->sessionId = (static_cast<uint64_t>(randomDevice()) << 32) ^ randomDevice();
+    headerPtr->slabSizeBytes = alignedSlabSizeBytes;
+    headerPtr->numSlabs = numSlabs;
+    headerPtr->unused = 0;
+    headerPtr->freeListHeadAndTag = 0;
+    headerPtr->numFreeSlabs = 0;
+    for (uint32_t i = 0; i < numSlabs; ++i) {
+        shm_slab_header_t * const slabHeaderPtr = new (&arenaPtr->m_slabHeadersPtr[i]) shm_slab_header_t();
+        slabHeaderPtr->refCount = 0;
+        slabHeaderPtr->nextFreeSlabIndexPlusOne = 0;
+    }
+    for (uint32_t i = numSlabs; i > 0; --i) { //slab 0 on top
+        arenaPtr->PushFreeSlab(i - 1);
+    }
+    boost::atomic_thread_fence(boost::memory_order_release);
+    headerPtr->magic = ARENA_MAGIC;
+    return arenaPtr;
+}
+
+boost::shared_ptr<SharedMemoryBundleArena> SharedMemoryBundleArena::Open(const std::string & name) {
+    boost::shared_ptr<SharedMemoryBundleArena> arenaPtr(new SharedMemoryBundleArena(name, false));
+    try {
+        arenaPtr->m_sharedMemoryObject = boost::interprocess::shared_memory_object(boost::interprocess::open_only, name.c_str(), boost::interprocess::read_write);
+        if (!arenaPtr->Map(boost::interprocess::read_write)) {
+            return boost::shared_ptr<SharedMemoryBundleArena>();
+        }
+    }
+    catch (const boost::interprocess::interprocess_exception &) {
+        return boost::shared_ptr<SharedMemoryBundleArena>();
+    }
+    const shm_arena_header_t * const headerPtr = arenaPtr->m_headerPtr;
+    if (headerPtr->magic != ARENA_MAGIC) {
+        return boost::shared_ptr<SharedMemoryBundleArena>();
+    }
+    boost::atomic_thread_fence(boost::memory_order_acquire);
+    const uint64_t slabDataOffset = GetSlabDataOffset(headerPtr->numSlabs);
+    if (arenaPtr->m_mappedRegion.get_size() < (slabDataOffset + (headerPtr->numSlabs * headerPtr->slabSizeBytes))) {
+        return boost::shared_ptr<SharedMemoryBundleArena>();
+    }
+    arenaPtr->m_slabDataPtr = static_cast<uint8_t*>(arenaPtr->m_mappedRegion.get_address()) + slabDataOffset;
+    return arenaPtr;
+}
+
+//Treiber stack with a tag against ABA (another process may pop and push the same slab between our load and cas)
+bool SharedMemoryBundleArena::PopFreeSlab(uint32_t & slabIndex) {
+    uint64_t head = m_headerPtr->freeListHeadAndTag.load(boost::memory_order_acquire);
+    while (true) {
+        const uint32_t slabIndexPlusOne = static_cast<uint32_t>(head);
+        if (slabIndexPlusOne == 0) {
+            return false;
+        }
+        const uint32_t nextSlabIndexPlusOne = m_slabHeadersPtr[slabIndexPlusOne - 1].nextFreeSlabIndexPlusOne.load(boost::memory_order_relaxed);
+        const uint64_t newHead = (((head >> 32) + 1) << 32) | nextSlabIndexPlusOne;
+        if (m_headerPtr->freeListHeadAndTag.compare_exchange_weak(head, newHead, boost::memory_order_acq_rel, boost::memory_order_acquire)) {
+            slabIndex = slabIndexPlusOne - 1;
+            m_headerPtr->numFreeSlabs.fetch_sub(1, boost::memory_order_relaxed);
+            return true;
+        }
+    }
+}
+
+void SharedMemoryBundleArena::PushFreeSlab(const uint32_t slabIndex) {
+    uint64_t head = m_headerPtr->freeListHeadAndTag.load(boost::memory_order_acquire);
+    while (true) {
+        m_slabHeadersPtr[slabIndex].nextFreeSlabIndexPlusOne.store(static_cast<uint32_t>(head), boost::memory_order_relaxed);
+        const uint64_t newHead = (((head >> 32) + 1) << 32) | (slabIndex + 1);
+        if (m_headerPtr->freeListHeadAndTag.compare_exchange_weak(head, newHead, boost::memory_order_release, boost::memory_order_acquire)) {
+            m_headerPtr->numFreeSlabs.fetch_add(1, boost::memory_order_relaxed);
+            return;
+        }
+    }
+}
+
+bool SharedMemoryBundleArena::CopyIn(const uint8_t * bundleData, const std::size_t bundleSizeBytes, shm_bundle_descriptor_t & descriptor) {
+    if (bundleSizeBytes > m_headerPtr->slabSizeBytes) {
+        return false;
+    }
+    uint32_t slabIndex;
+    if (!PopFreeSlab(slabIndex)) {
+        return false;
+    }
+    m_slabHeadersPtr[slabIndex].refCount.store(1, boost::memory_order_relaxed);
+    memcpy(m_slabDataPtr + (slabIndex * m_headerPtr->slabSizeBytes), bundleData, bundleSizeBytes);
+    descriptor.arenaSessionId = m_headerPtr->sessionId;
+    descriptor.bundleSizeBytes = bundleSizeBytes;
+    descriptor.slabIndex = slabIndex;
+    descriptor.unused = 0;
+    return true;
+}
+
+void SharedMemoryBundleArena::Release(const uint32_t slabIndex) {
+    if (m_slabHeadersPtr[slabIndex].refCount.fetch_sub(1, boost::memory_order_acq_rel) == 1) {
+        PushFreeSlab(slabIndex);
+    }
+}
+
+struct shm_slab_release_hint_t {
+    boost::shared_ptr<SharedMemoryBundleArena> arenaPtr; //keeps the mapping alive until zmq is done with the slab
+    uint32_t slabIndex;
+};
+static void CustomCleanupSharedMemorySlab(void *data, void *hint) {
+    shm_slab_release_hint_t * const releaseHintPtr = static_cast<shm_slab_release_hint_t*>(hint);
+    releaseHintPtr->arenaPtr->Release(releaseHintPtr->slabIndex);
+    delete releaseHintPtr;
+}
+
+bool SharedMemoryBundleArena::MoveToZmqMessage(const boost::shared_ptr<SharedMemoryBundleArena> & arenaPtr, const shm_bundle_descriptor_t & descriptor, zmq::message_t & zmqMessage) {
+    const shm_arena_header_t & header = *arenaPtr->m_headerPtr;
+    if ((descriptor.arenaSessionId != header.sessionId) || (descriptor.slabIndex >= header.numSlabs) || (descriptor.bundleSizeBytes > header.slabSizeBytes)) {
+        return false;
+    }
+    shm_slab_release_hint_t * const releaseHintPtr = new shm_slab_release_hint_t();
+    releaseHintPtr->arenaPtr = arenaPtr;
+    releaseHintPtr->slabIndex = descriptor.slabIndex;
+    zmqMessage = zmq::message_t(arenaPtr->m_slabDataPtr + (descriptor.slabIndex * header.slabSizeBytes), static_cast<std::size_t>(descriptor.bundleSizeBytes),
+        CustomCleanupSharedMemorySlab, releaseHintPtr);
+    return true;
+}
+
+uint64_t SharedMemoryBundleArena::GetSessionId() const {
+    return m_headerPtr->sessionId;
+}
+uint32_t SharedMemoryBundleArena::GetNumSlabs() const {
+    return m_headerPtr->numSlabs;
+}
+uint64_t SharedMemoryBundleArena::GetSlabSizeBytes() const {
+    return m_headerPtr->slabSizeBytes;
+}
+uint32_t SharedMemoryBundleArena::GetNumFreeSlabs() const {
+    return m_headerPtr->numFreeSlabs.load(boost::memory_order_relaxed);
+}
+const std::string & SharedMemoryBundleArena::GetName() const {
+    return m_name;
+}
+std::string SharedMemoryBundleArena::GetArenaName(const uint16_t producerPortPath) {
+    return "hdtn_bundle_arena_" + boost::lexical_cast<std::string>(producerPortPath);
+}
+
+
+SharedMemoryBundleArenaReader::SharedMemoryBundleArenaReader(const std::string & arenaName) : M_ARENA_NAME(arenaName) {}
+SharedMemoryBundleArenaReader::~SharedMemoryBundleArenaReader() {}
+
+bool SharedMemoryBundleArenaReader::ReplaceDescriptorWithBundle(zmq::message_t & zmqMessage) {
+    if (zmqMessage.size() != sizeof(shm_bundle_descriptor_t)) {
+        std::cerr << "error in SharedMemoryBundleArenaReader::ReplaceDescriptorWithBundle: message size " << zmqMessage.size()
+            << " is not the size of a descriptor" << std::endl;
+        return false;
+    }
+    shm_bundle_descriptor_t descriptor;
+    memcpy(&descriptor, zmqMessage.data(), sizeof(descriptor));
+    if ((!m_arenaPtr) || (m_arenaPtr->GetSessionId() != descriptor.arenaSessionId)) {
+        //first descriptor, or the producer was restarted (messages still holding slabs of the old arena keep it mapped)
+        m_arenaPtr = SharedMemoryBundleArena::Open(M_ARENA_NAME);
+        if (!m_arenaPtr) {
+            std::cerr << "error in SharedMemoryBundleArenaReader::ReplaceDescriptorWithBundle: cannot open " << M_ARENA_NAME << std::endl;
+            return false;
+        }
+    }
+    if (!SharedMemoryBundleArena::MoveToZmqMessage(m_arenaPtr, descriptor, zmqMessage)) {
+        std::cerr << "error in SharedMemoryBundleArenaReader::ReplaceDescriptorWithBundle: invalid descriptor for " << M_ARENA_NAME << std::endl;
+        return false;
+    }
+    return true;
+}
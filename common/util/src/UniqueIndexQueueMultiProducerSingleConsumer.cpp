@@ -0,0 +1,46 @@
+/***************************************************************************
+ * NASA Glenn Research Center, Cleveland, OH
+ * Released under the NASA Open Source Agreement (NOSA)
+ * May  2021
+ *
+ ****************************************************************************
+ */
+
+#include "UniqueIndexQueueMultiProducerSingleConsumer.h"
+
+
+UniqueIndexQueueMultiProducerSingleConsumer::UniqueIndexQueueMultiProducerSingleConsumer(const uint32_t numIndices) :
+    M_NUM_INDICES(numIndices),
+    m_isQueuedArray(new boost::atomic<bool>[numIndices]),
+    m_queue(numIndices + 1) //preallocated nodes (plus the internal dummy node) so that bounded_push never allocates
+{
+    for (uint32_t i = 0; i < M_NUM_INDICES; ++i) {
+        m_isQueuedArray[i].store(false, boost::memory_order_relaxed);
+    }
+}
+
+UniqueIndexQueueMultiProducerSingleConsumer::~UniqueIndexQueueMultiProducerSingleConsumer() {}
+
+bool UniqueIndexQueueMultiProducerSingleConsumer::Push_ThreadSafe(const uint32_t index) {
+    if (index >= M_NUM_INDICES) {
+        return false;
+    }
+    //the seq_cst exchange orders the caller's state update before the consumer's flag clear (see Pop)
+    if (m_isQueuedArray[index].exchange(true, boost::memory_order_seq_cst)) {
+        return false; //already queued, the consumer has yet to see the index and will read the updated state
+    }
+    return m_queue.bounded_push(index); //cannot fail, at most M_NUM_INDICES entries are ever queued
+}
+
+bool UniqueIndexQueueMultiProducerSingleConsumer::Pop(uint32_t & index) {
+    if (!m_queue.pop(index)) {
+        return false;
+    }
+    //clear before the caller processes the index so that any later push queues it again
+    m_isQueuedArray[index].store(false, boost::memory_order_seq_cst);
+    return true;
+}
+
+uint32_t UniqueIndexQueueMultiProducerSingleConsumer::GetNumIndices() const {
+    return M_NUM_INDICES;
+}
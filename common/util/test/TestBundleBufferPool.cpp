@@ -0,0 +1,237 @@
+#include <boost/test/unit_test.hpp>
+#include "BundleBufferPool.h"
+#include "PaddedVectorUint8.h"
+#include <boost/thread.hpp>
+#include <boost/lockfree/spsc_queue.hpp>
+#include <boost/timer/timer.hpp>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <vector>
+
+BOOST_AUTO_TEST_CASE(BundleBufferPoolSizeClassTestCase)
+{
+    BOOST_REQUIRE_EQUAL(BundleBufferPool::GetSizeClassBytes(0), 64);
+    BOOST_REQUIRE_EQUAL(BundleBufferPool::GetSizeClassBytes(1), 64);
+    BOOST_REQUIRE_EQUAL(BundleBufferPool::GetSizeClassBytes(64), 64);
+    BOOST_REQUIRE_EQUAL(BundleBufferPool::GetSizeClassBytes(65), 128);
+    BOOST_REQUIRE_EQUAL(BundleBufferPool::GetSizeClassBytes(256), 256);
+    BOOST_REQUIRE_EQUAL(BundleBufferPool::GetSizeClassBytes(257), 320);
+    BOOST_REQUIRE_EQUAL(BundleBufferPool::GetSizeClassBytes(321), 384);
+    BOOST_REQUIRE_EQUAL(BundleBufferPool::GetSizeClassBytes(512), 512);
+    BOOST_REQUIRE_EQUAL(BundleBufferPool::GetSizeClassBytes(513), 640);
+    BOOST_REQUIRE_EQUAL(BundleBufferPool::GetSizeClassBytes(1100 + 160), 1280); //1100 byte bundle in a padded vector
+    BOOST_REQUIRE_EQUAL(BundleBufferPool::GetSizeClassBytes(65536), 65536);
+    BOOST_REQUIRE_EQUAL(BundleBufferPool::GetSizeClassBytes(65537), 81920);
+    BOOST_REQUIRE_EQUAL(BundleBufferPool::GetSizeClassBytes(16777216), 16777216);
+    BOOST_REQUIRE_EQUAL(BundleBufferPool::GetSizeClassBytes(16777217), 0); //oversized
+
+    //every size maps to the smallest class that holds it, with at most 25% overhead above 256 bytes
+    std::size_t prevClassBytes = 64;
+    for (std::size_t size = 1; size <= 1000000; size += ((size < 5000) ? 1 : 97)) {
+        const std::size_t classBytes = BundleBufferPool::GetSizeClassBytes(size);
+        BOOST_REQUIRE_GE(classBytes, size);
+        BOOST_REQUIRE_GE(classBytes, prevClassBytes);
+        BOOST_REQUIRE_EQUAL(classBytes % 64, 0);
+        if (size > 256) {
+            BOOST_REQUIRE_LE(classBytes, size + (size / 4) + 64);
+        }
+        prevClassBytes = classBytes;
+    }
+}
+
+BOOST_AUTO_TEST_CASE(BundleBufferPoolAllocateTestCase)
+{
+    //a freed block is handed out again to the same thread
+    void * ptr1 = BundleBufferPool::Allocate(1000);
+    memset(ptr1, 0x11, 1000);
+    BundleBufferPool::Deallocate(ptr1, 1000);
+    void * ptr2 = BundleBufferPool::Allocate(1020); //same size class
+    BOOST_REQUIRE(ptr1 == ptr2);
+    BundleBufferPool::Deallocate(ptr2, 1020);
+
+    //blocks of every size class used are distinct, writable, and 64 byte aligned
+    static const std::size_t SIZES[] = { 1, 64, 100, 300, 4096, 70000, 600000, 3000000, 20000000 };
+    std::vector<void*> ptrs;
+    for (std::size_t i = 0; i < sizeof(SIZES) / sizeof(SIZES[0]); ++i) {
+        for (unsigned int j = 0; j < 3; ++j) {
+            uint8_t * p = static_cast<uint8_t*>(BundleBufferPool::Allocate(SIZES[i]));
+            BOOST_REQUIRE_EQUAL(reinterpret_cast<uintptr_t>(p) % 16, 0);
+            if (SIZES[i] <= 16777216) {
+                BOOST_REQUIRE_EQUAL(reinterpret_cast<uintptr_t>(p) % 64, 0);
+            }
+            memset(p, static_cast<int>(i * 3 + j), SIZES[i]);
+            ptrs.push_back(p);
+        }
+    }
+    std::size_t ptrIndex = 0;
+    for (std::size_t i = 0; i < sizeof(SIZES) / sizeof(SIZES[0]); ++i) {
+        for (unsigned int j = 0; j < 3; ++j) {
+            const uint8_t * p = static_cast<const uint8_t*>(ptrs[ptrIndex++]);
+            const uint8_t expected = static_cast<uint8_t>(i * 3 + j);
+            BOOST_REQUIRE_EQUAL(p[0], expected);
+            BOOST_REQUIRE_EQUAL(p[SIZES[i] - 1], expected);
+        }
+    }
+    ptrIndex = 0;
+    for (std::size_t i = 0; i < sizeof(SIZES) / sizeof(SIZES[0]); ++i) {
+        for (unsigned int j = 0; j < 3; ++j) {
+            BundleBufferPool::Deallocate(ptrs[ptrIndex++], SIZES[i]);
+        }
+    }
+
+    //objects
+    padded_vector_uint8_t v(500, 7);
+    const uint8_t * const vData = v.data();
+    padded_vector_uint8_t * vPtr = BundleBufferPool::New<padded_vector_uint8_t>(std::move(v));
+    BOOST_REQUIRE(vPtr->data() == vData);
+    BOOST_REQUIRE_EQUAL(vPtr->size(), 500);
+    BundleBufferPool::Delete(vPtr);
+    uint64_t * u64Ptr = BundleBufferPool::New<uint64_t>();
+    BOOST_REQUIRE_EQUAL(*u64Ptr, 0);
+    BundleBufferPool::Delete(u64Ptr);
+}
+
+typedef boost::lockfree::spsc_queue<padded_vector_uint8_t*, boost::lockfree::capacity<256> > test_vec_queue_t;
+
+static void ProducerThreadFunc(test_vec_queue_t * queuePtr, const unsigned int numVectors) {
+    for (unsigned int i = 0; i < numVectors; ++i) {
+        padded_vector_uint8_t v(100 + ((i * 37) % 5000), static_cast<uint8_t>(i));
+        padded_vector_uint8_t * vPtr = BundleBufferPool::New<padded_vector_uint8_t>(std::move(v));
+        while (!queuePtr->push(vPtr)) {
+            boost::this_thread::yield();
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(BundleBufferPoolCrossThreadTestCase)
+{
+    //like an induct thread allocating and an ingress thread freeing
+    static const unsigned int NUM_VECTORS = 100000;
+    test_vec_queue_t queue;
+    boost::thread producerThread(boost::bind(&ProducerThreadFunc, &queue, NUM_VECTORS));
+    bool allValid = true;
+    for (unsigned int i = 0; i < NUM_VECTORS; ++i) {
+        padded_vector_uint8_t * vPtr;
+        while (!queue.pop(vPtr)) {
+            boost::this_thread::yield();
+        }
+        allValid = allValid && (vPtr->size() == (100 + ((i * 37) % 5000))) && (vPtr->front() == static_cast<uint8_t>(i)) && (vPtr->back() == static_cast<uint8_t>(i));
+        BundleBufferPool::Delete(vPtr);
+    }
+    producerThread.join(); //flushes the producer's thread cache
+    BOOST_REQUIRE(allValid);
+}
+
+//what ingress allocates per bundle: the header, the vector object holding the received buffer, and the buffer itself
+struct test_bundle_header_t {
+    uint64_t fields[8];
+};
+
+static uint64_t g_numMallocatorAllocations = 0;
+template <class T>
+struct TestCountingPaddedMallocator {
+    typedef T value_type;
+    TestCountingPaddedMallocator() = default;
+    template <class U> constexpr TestCountingPaddedMallocator(const TestCountingPaddedMallocator <U>&) noexcept {}
+    T* allocate(std::size_t n) {
+        ++g_numMallocatorAllocations;
+        if (T* p = static_cast<T*>(std::malloc((n + PaddedMallocator<T>::TOTAL_PADDING_ELEMENTS) * sizeof(T)))) {
+            return p + PaddedMallocator<T>::PADDING_ELEMENTS_BEFORE;
+        }
+        throw std::bad_alloc();
+    }
+    void deallocate(T* p, std::size_t n) noexcept {
+        std::free(p - PaddedMallocator<T>::PADDING_ELEMENTS_BEFORE);
+    }
+};
+template <class T, class U>
+bool operator==(const TestCountingPaddedMallocator <T>&, const TestCountingPaddedMallocator <U>&) { return true; }
+template <class T, class U>
+bool operator!=(const TestCountingPaddedMallocator <T>&, const TestCountingPaddedMallocator <U>&) { return false; }
+typedef std::vector<uint8_t, TestCountingPaddedMallocator<uint8_t> > test_malloc_padded_vector_uint8_t;
+
+static const unsigned int BENCHMARK_NUM_BUNDLES = 1000000;
+static const unsigned int BENCHMARK_BUNDLES_IN_FLIGHT = 500;
+static std::size_t BenchmarkBundleSize(const unsigned int i) {
+    static const std::size_t SIZES[] = { 100, 1100, 1500, 8000, 65000 };
+    return SIZES[(i * 7) % (sizeof(SIZES) / sizeof(SIZES[0]))];
+}
+
+static uint64_t RunPooledBundles() {
+    std::deque<std::pair<test_bundle_header_t*, padded_vector_uint8_t*> > inFlight;
+    uint64_t numAllocations = 0;
+    for (unsigned int i = 0; i < BENCHMARK_NUM_BUNDLES; ++i) {
+        padded_vector_uint8_t rxBuf(BenchmarkBundleSize(i));
+        rxBuf[0] = static_cast<uint8_t>(i);
+        test_bundle_header_t * hdrPtr = BundleBufferPool::New<test_bundle_header_t>();
+        hdrPtr->fields[0] = i;
+        inFlight.emplace_back(hdrPtr, BundleBufferPool::New<padded_vector_uint8_t>(std::move(rxBuf)));
+        numAllocations += 3;
+        if (inFlight.size() > BENCHMARK_BUNDLES_IN_FLIGHT) {
+            BundleBufferPool::Delete(inFlight.front().first);
+            BundleBufferPool::Delete(inFlight.front().second);
+            inFlight.pop_front();
+        }
+    }
+    while (!inFlight.empty()) {
+        BundleBufferPool::Delete(inFlight.front().first);
+        BundleBufferPool::Delete(inFlight.front().second);
+        inFlight.pop_front();
+    }
+    return numAllocations;
+}
+
+static void RunMallocBundles() {
+    std::deque<std::pair<test_bundle_header_t*, test_malloc_padded_vector_uint8_t*> > inFlight;
+    for (unsigned int i = 0; i < BENCHMARK_NUM_BUNDLES; ++i) {
+        test_malloc_padded_vector_uint8_t rxBuf(BenchmarkBundleSize(i));
+        rxBuf[0] = static_cast<uint8_t>(i);
+        test_bundle_header_t * hdrPtr = new test_bundle_header_t();
+        hdrPtr->fields[0] = i;
+        inFlight.emplace_back(hdrPtr, new test_malloc_padded_vector_uint8_t(std::move(rxBuf)));
+        g_numMallocatorAllocations += 2;
+        if (inFlight.size() > BENCHMARK_BUNDLES_IN_FLIGHT) {
+            delete inFlight.front().first;
+            delete inFlight.front().second;
+            inFlight.pop_front();
+        }
+    }
+    while (!inFlight.empty()) {
+        delete inFlight.front().first;
+        delete inFlight.front().second;
+        inFlight.pop_front();
+    }
+}
+
+BOOST_AUTO_TEST_CASE(BundleBufferPoolBenchmarkTestCase, *boost::unit_test::disabled())
+{
+    std::cout << "starting bundle buffer pool benchmark (" << BENCHMARK_NUM_BUNDLES << " bundles, " << BENCHMARK_BUNDLES_IN_FLIGHT << " in flight)\n";
+    {
+        std::cout << "malloc\n";
+        g_numMallocatorAllocations = 0;
+        boost::timer::auto_cpu_timer t;
+        RunMallocBundles();
+        std::cout << "system allocations: " << g_numMallocatorAllocations << "\n";
+        BOOST_REQUIRE_EQUAL(g_numMallocatorAllocations, 3 * BENCHMARK_NUM_BUNDLES);
+    }
+
+    RunPooledBundles(); //warm up the size classes
+    BundleBufferPoolTelemetry telemBefore;
+    BundleBufferPool::GetTelemetry(telemBefore);
+    uint64_t numPooledAllocations;
+    {
+        std::cout << "bundle buffer pool\n";
+        boost::timer::auto_cpu_timer t;
+        numPooledAllocations = RunPooledBundles();
+    }
+    BundleBufferPoolTelemetry telemAfter;
+    BundleBufferPool::GetTelemetry(telemAfter);
+    const uint64_t numSystemAllocations = telemAfter.totalSystemAllocations - telemBefore.totalSystemAllocations;
+    std::cout << "allocations: " << numPooledAllocations << " system allocations: " << numSystemAllocations
+        << " thread cache refills: " << (telemAfter.totalThreadCacheRefills - telemBefore.totalThreadCacheRefills) << std::endl;
+    BOOST_REQUIRE_EQUAL(numPooledAllocations, 3 * BENCHMARK_NUM_BUNDLES);
+    //once warm, the same traffic is served entirely from the free lists
+    BOOST_REQUIRE_EQUAL(numSystemAllocations, 0);
+}
@@ -0,0 +1,119 @@
+#include <boost/test/unit_test.hpp>
+#include "InterModuleChannel.h"
+#include <boost/bind/bind.hpp>
+#include <boost/thread.hpp>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+struct test_channel_hdr_t {
+    uint64_t producerIndex;
+    uint64_t sequenceNumber;
+};
+
+static void IncrementCount(unsigned int * countPtr) {
+    ++(*countPtr);
+}
+
+static void CustomCleanupTestVec(void * data, void * hint) {
+    delete static_cast<std::vector<uint8_t>*>(hint);
+}
+
+BOOST_AUTO_TEST_CASE(NativeInterModuleChannelTestCase)
+{
+    NativeInterModuleChannel<test_channel_hdr_t> channel(2);
+    unsigned int notifyCount = 0;
+    channel.SetNotifyReceiverFunction(boost::bind(&IncrementCount, &notifyCount));
+    InterModuleChannelSender<test_channel_hdr_t> & sender = channel;
+    InterModuleChannelReceiver<test_channel_hdr_t> & receiver = channel;
+
+    test_channel_hdr_t hdr;
+    zmq::message_t bundle;
+    BOOST_REQUIRE(!receiver.TryReceive(hdr, bundle));
+    BOOST_REQUIRE(!receiver.HasUnpolledBacklog());
+
+    //the bundle moves without a copy
+    std::vector<uint8_t> * vec1Ptr = new std::vector<uint8_t>(100, 0x55);
+    const uint8_t * const vec1Data = vec1Ptr->data();
+    zmq::message_t bundle1(vec1Ptr->data(), vec1Ptr->size(), CustomCleanupTestVec, vec1Ptr);
+    hdr.producerIndex = 0;
+    hdr.sequenceNumber = 1;
+    BOOST_REQUIRE(sender.TrySend(hdr, bundle1));
+    BOOST_REQUIRE_EQUAL(bundle1.size(), 0);
+    zmq::message_t headerOnly;
+    hdr.sequenceNumber = 2;
+    BOOST_REQUIRE(sender.TrySend(hdr, headerOnly));
+    BOOST_REQUIRE_EQUAL(notifyCount, 2);
+    BOOST_REQUIRE(receiver.HasUnpolledBacklog());
+
+    //full, the bundle is left untouched
+    zmq::message_t bundle3(50);
+    hdr.sequenceNumber = 3;
+    BOOST_REQUIRE(!sender.TrySend(hdr, bundle3));
+    BOOST_REQUIRE_EQUAL(bundle3.size(), 50);
+    BOOST_REQUIRE_EQUAL(notifyCount, 2);
+
+    BOOST_REQUIRE(receiver.TryReceive(hdr, bundle));
+    BOOST_REQUIRE_EQUAL(hdr.sequenceNumber, 1);
+    BOOST_REQUIRE_EQUAL(bundle.size(), 100);
+    BOOST_REQUIRE(static_cast<const uint8_t*>(bundle.data()) == vec1Data);
+
+    BOOST_REQUIRE(sender.TrySend(hdr, bundle3)); //a slot was freed
+    BOOST_REQUIRE(receiver.TryReceive(hdr, bundle));
+    BOOST_REQUIRE_EQUAL(hdr.sequenceNumber, 2);
+    BOOST_REQUIRE_EQUAL(bundle.size(), 0);
+    BOOST_REQUIRE(receiver.TryReceive(hdr, bundle));
+    BOOST_REQUIRE_EQUAL(bundle.size(), 50);
+    BOOST_REQUIRE(!receiver.TryReceive(hdr, bundle));
+    BOOST_REQUIRE(!receiver.HasUnpolledBacklog());
+}
+
+static void ProducerThreadFunc(NativeInterModuleChannel<test_channel_hdr_t> * channelPtr, const uint64_t producerIndex, const uint64_t numMessages) {
+    for (uint64_t i = 0; i < numMessages; ++i) {
+        test_channel_hdr_t hdr;
+        hdr.producerIndex = producerIndex;
+        hdr.sequenceNumber = i;
+        zmq::message_t bundle(sizeof(i));
+        memcpy(bundle.data(), &i, sizeof(i));
+        while (!channelPtr->TrySend(hdr, bundle)) {
+            boost::this_thread::yield();
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(NativeInterModuleChannelMultiProducerTestCase)
+{
+    static const uint64_t NUM_PRODUCERS = 4;
+    static const uint64_t NUM_MESSAGES_PER_PRODUCER = 20000;
+    NativeInterModuleChannel<test_channel_hdr_t> channel(16);
+    std::vector<std::unique_ptr<boost::thread> > threads;
+    for (uint64_t p = 0; p < NUM_PRODUCERS; ++p) {
+        threads.emplace_back(new boost::thread(boost::bind(&ProducerThreadFunc, &channel, p, NUM_MESSAGES_PER_PRODUCER)));
+    }
+    std::vector<uint64_t> nextSequenceNumbers(NUM_PRODUCERS, 0);
+    uint64_t numReceived = 0;
+    bool allValid = true;
+    while (numReceived < (NUM_PRODUCERS * NUM_MESSAGES_PER_PRODUCER)) {
+        test_channel_hdr_t hdr;
+        zmq::message_t bundle;
+        if (!channel.TryReceive(hdr, bundle)) {
+            boost::this_thread::yield();
+            continue;
+        }
+        ++numReceived;
+        if ((hdr.producerIndex >= NUM_PRODUCERS) || (bundle.size() != sizeof(uint64_t))) {
+            allValid = false;
+            continue;
+        }
+        uint64_t bundleValue;
+        memcpy(&bundleValue, bundle.data(), sizeof(bundleValue));
+        //each producer's messages arrive in order and intact
+        allValid = allValid && (hdr.sequenceNumber == nextSequenceNumbers[hdr.producerIndex]) && (bundleValue == hdr.sequenceNumber);
+        ++nextSequenceNumbers[hdr.producerIndex];
+    }
+    for (std::size_t i = 0; i < threads.size(); ++i) {
+        threads[i]->join();
+    }
+    BOOST_REQUIRE(allValid);
+    BOOST_REQUIRE(!channel.HasUnpolledBacklog());
+}
@@ -0,0 +1,113 @@
+#include <boost/test/unit_test.hpp>
+#include "SharedMemoryBundleArena.h"
+#include <boost/thread.hpp>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+
+BOOST_AUTO_TEST_CASE(SharedMemoryBundleArenaTestCase)
+{
+    const std::string arenaName = SharedMemoryBundleArena::GetArenaName(65000) + "_unit_test";
+    BOOST_REQUIRE(!SharedMemoryBundleArena::Open(arenaName)); //not created yet
+    boost::shared_ptr<SharedMemoryBundleArena> producerPtr = SharedMemoryBundleArena::Create(arenaName, 2, 100);
+    BOOST_REQUIRE(producerPtr);
+    BOOST_REQUIRE_EQUAL(producerPtr->GetNumSlabs(), 2);
+    BOOST_REQUIRE_EQUAL(producerPtr->GetSlabSizeBytes(), 128); //cache line aligned
+    BOOST_REQUIRE_EQUAL(producerPtr->GetNumFreeSlabs(), 2);
+
+    std::vector<uint8_t> bundle1(128), bundle2(50), tooBig(129);
+    for (std::size_t i = 0; i < bundle1.size(); ++i) {
+        bundle1[i] = static_cast<uint8_t>(i);
+    }
+    memset(bundle2.data(), 0xab, bundle2.size());
+    shm_bundle_descriptor_t descriptor1, descriptor2, descriptor3;
+    BOOST_REQUIRE(!producerPtr->CopyIn(tooBig.data(), tooBig.size(), descriptor3));
+    BOOST_REQUIRE(producerPtr->CopyIn(bundle1.data(), bundle1.size(), descriptor1));
+    BOOST_REQUIRE(producerPtr->CopyIn(bundle2.data(), bundle2.size(), descriptor2));
+    BOOST_REQUIRE(!producerPtr->CopyIn(bundle2.data(), bundle2.size(), descriptor3)); //no free slab
+    BOOST_REQUIRE_EQUAL(producerPtr->GetNumFreeSlabs(), 0);
+    BOOST_REQUIRE_NE(descriptor1.slabIndex, descriptor2.slabIndex);
+    BOOST_REQUIRE_EQUAL(descriptor2.bundleSizeBytes, 50);
+    BOOST_REQUIRE_EQUAL(descriptor1.arenaSessionId, producerPtr->GetSessionId());
+
+    SharedMemoryBundleArenaReader reader(arenaName);
+    {
+        zmq::message_t zmqMessage1(&descriptor1, sizeof(descriptor1));
+        zmq::message_t zmqMessage2(&descriptor2, sizeof(descriptor2));
+        BOOST_REQUIRE(reader.ReplaceDescriptorWithBundle(zmqMessage1));
+        BOOST_REQUIRE(reader.ReplaceDescriptorWithBundle(zmqMessage2));
+        BOOST_REQUIRE_EQUAL(zmqMessage1.size(), bundle1.size());
+        BOOST_REQUIRE(memcmp(zmqMessage1.data(), bundle1.data(), bundle1.size()) == 0);
+        BOOST_REQUIRE_EQUAL(zmqMessage2.size(), bundle2.size());
+        BOOST_REQUIRE(memcmp(zmqMessage2.data(), bundle2.data(), bundle2.size()) == 0);
+        BOOST_REQUIRE_EQUAL(producerPtr->GetNumFreeSlabs(), 0);
+        zmqMessage1 = zmq::message_t(); //consumer done with the first bundle
+        BOOST_REQUIRE_EQUAL(producerPtr->GetNumFreeSlabs(), 1);
+
+        zmq::message_t notADescriptor(3);
+        BOOST_REQUIRE(!reader.ReplaceDescriptorWithBundle(notADescriptor));
+        shm_bundle_descriptor_t badDescriptor = descriptor1;
+        badDescriptor.slabIndex = 2;
+        zmq::message_t zmqMessageBad(&badDescriptor, sizeof(badDescriptor));
+        BOOST_REQUIRE(!reader.ReplaceDescriptorWithBundle(zmqMessageBad));
+        BOOST_REQUIRE_EQUAL(zmqMessageBad.size(), sizeof(badDescriptor)); //untouched
+    }
+    BOOST_REQUIRE_EQUAL(producerPtr->GetNumFreeSlabs(), 2);
+
+    //the producer drops a reference itself when it cannot send the descriptor
+    BOOST_REQUIRE(producerPtr->CopyIn(bundle2.data(), bundle2.size(), descriptor3));
+    BOOST_REQUIRE_EQUAL(producerPtr->GetNumFreeSlabs(), 1);
+    producerPtr->Release(descriptor3.slabIndex);
+    BOOST_REQUIRE_EQUAL(producerPtr->GetNumFreeSlabs(), 2);
+
+    //a restarted producer recreates the arena with a new session, and the reader follows it
+    const uint64_t oldSessionId = producerPtr->GetSessionId();
+    producerPtr = SharedMemoryBundleArena::Create(arenaName, 4, 64);
+    BOOST_REQUIRE(producerPtr);
+    BOOST_REQUIRE_NE(producerPtr->GetSessionId(), oldSessionId);
+    BOOST_REQUIRE(producerPtr->CopyIn(bundle2.data(), bundle2.size(), descriptor3));
+    {
+        zmq::message_t zmqMessage3(&descriptor3, sizeof(descriptor3));
+        BOOST_REQUIRE(reader.ReplaceDescriptorWithBundle(zmqMessage3));
+        BOOST_REQUIRE(memcmp(zmqMessage3.data(), bundle2.data(), bundle2.size()) == 0);
+        BOOST_REQUIRE_EQUAL(producerPtr->GetNumFreeSlabs(), 3);
+    }
+    BOOST_REQUIRE_EQUAL(producerPtr->GetNumFreeSlabs(), 4);
+    producerPtr.reset(); //removes the name
+    BOOST_REQUIRE(!SharedMemoryBundleArena::Open(arenaName));
+}
+
+BOOST_AUTO_TEST_CASE(SharedMemoryBundleArenaMultiThreadTestCase)
+{
+    //consumers on other threads release slabs while the producer keeps reusing them
+    const std::string arenaName = SharedMemoryBundleArena::GetArenaName(65001) + "_unit_test";
+    boost::shared_ptr<SharedMemoryBundleArena> producerPtr = SharedMemoryBundleArena::Create(arenaName, 8, 64);
+    BOOST_REQUIRE(producerPtr);
+    static constexpr unsigned int NUM_CONSUMERS = 4;
+    static constexpr unsigned int NUM_BUNDLES_PER_CONSUMER = 20000;
+    boost::shared_ptr<SharedMemoryBundleArena> consumerPtr = SharedMemoryBundleArena::Open(arenaName);
+    BOOST_REQUIRE(consumerPtr);
+    std::vector<boost::thread> threads;
+    boost::atomic<unsigned int> numMismatches(0);
+    for (unsigned int c = 0; c < NUM_CONSUMERS; ++c) {
+        threads.emplace_back([&producerPtr, &consumerPtr, &numMismatches, c]() {
+            for (unsigned int i = 0; i < NUM_BUNDLES_PER_CONSUMER; ++i) {
+                const uint32_t value = (c << 24) | i;
+                shm_bundle_descriptor_t descriptor;
+                while (!producerPtr->CopyIn(reinterpret_cast<const uint8_t*>(&value), sizeof(value), descriptor)) {
+                    boost::this_thread::yield();
+                }
+                zmq::message_t zmqMessage;
+                if ((!SharedMemoryBundleArena::MoveToZmqMessage(consumerPtr, descriptor, zmqMessage)) || (memcmp(zmqMessage.data(), &value, sizeof(value)) != 0)) {
+                    ++numMismatches;
+                }
+            }
+        });
+    }
+    for (std::size_t i = 0; i < threads.size(); ++i) {
+        threads[i].join();
+    }
+    BOOST_REQUIRE_EQUAL(numMismatches.load(), 0);
+    BOOST_REQUIRE_EQUAL(producerPtr->GetNumFreeSlabs(), 8);
+}
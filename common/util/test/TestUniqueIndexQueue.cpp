@@ -0,0 +1,80 @@
+#include <boost/test/unit_test.hpp>
+#include "UniqueIndexQueueMultiProducerSingleConsumer.h"
+#include <boost/thread.hpp>
+#include <iostream>
+#include <vector>
+
+
+BOOST_AUTO_TEST_CASE(UniqueIndexQueueTestCase)
+{
+    UniqueIndexQueueMultiProducerSingleConsumer q(5);
+    BOOST_REQUIRE_EQUAL(q.GetNumIndices(), 5);
+    uint32_t index;
+    BOOST_REQUIRE(!q.Pop(index));
+    BOOST_REQUIRE(q.Push_ThreadSafe(3));
+    BOOST_REQUIRE(!q.Push_ThreadSafe(3)); //already queued
+    BOOST_REQUIRE(q.Push_ThreadSafe(0));
+    BOOST_REQUIRE(!q.Push_ThreadSafe(5)); //out of range
+    BOOST_REQUIRE(q.Pop(index));
+    BOOST_REQUIRE_EQUAL(index, 3);
+    BOOST_REQUIRE(q.Push_ThreadSafe(3)); //popped so queued again
+    BOOST_REQUIRE(q.Pop(index));
+    BOOST_REQUIRE_EQUAL(index, 0);
+    BOOST_REQUIRE(q.Pop(index));
+    BOOST_REQUIRE_EQUAL(index, 3);
+    BOOST_REQUIRE(!q.Pop(index));
+
+    //all indices queued at once
+    for (uint32_t i = 0; i < 5; ++i) {
+        BOOST_REQUIRE(q.Push_ThreadSafe(4 - i));
+    }
+    for (uint32_t i = 0; i < 5; ++i) {
+        BOOST_REQUIRE(q.Pop(index));
+        BOOST_REQUIRE_EQUAL(index, 4 - i);
+    }
+    BOOST_REQUIRE(!q.Pop(index));
+}
+
+BOOST_AUTO_TEST_CASE(UniqueIndexQueueMultiThreadTestCase)
+{
+    //each producer increments counters then pushes the index, the consumer must eventually see every increment
+    static constexpr uint32_t NUM_INDICES = 8;
+    static constexpr unsigned int NUM_PRODUCERS = 4;
+    static constexpr uint64_t INCREMENTS_PER_PRODUCER = 100000;
+    UniqueIndexQueueMultiProducerSingleConsumer q(NUM_INDICES);
+    std::vector<boost::atomic<uint64_t> > counters(NUM_INDICES);
+    for (uint32_t i = 0; i < NUM_INDICES; ++i) {
+        counters[i] = 0;
+    }
+    std::vector<uint64_t> counterValuesSeen(NUM_INDICES, 0);
+
+    boost::thread_group producers;
+    for (unsigned int p = 0; p < NUM_PRODUCERS; ++p) {
+        producers.create_thread([&q, &counters, p]() {
+            for (uint64_t i = 0; i < INCREMENTS_PER_PRODUCER; ++i) {
+                const uint32_t index = static_cast<uint32_t>((i + p) % NUM_INDICES);
+                counters[index].fetch_add(1);
+                q.Push_ThreadSafe(index);
+            }
+        });
+    }
+    uint64_t totalSeen = 0;
+    uint64_t numPops = 0;
+    static constexpr uint64_t TOTAL_INCREMENTS = NUM_PRODUCERS * INCREMENTS_PER_PRODUCER;
+    const boost::posix_time::ptime timeout = boost::posix_time::microsec_clock::universal_time() + boost::posix_time::seconds(10);
+    while ((totalSeen < TOTAL_INCREMENTS) && (boost::posix_time::microsec_clock::universal_time() < timeout)) {
+        uint32_t index;
+        while (q.Pop(index)) {
+            BOOST_REQUIRE_LT(index, NUM_INDICES);
+            ++numPops;
+            const uint64_t value = counters[index].load();
+            totalSeen += value - counterValuesSeen[index];
+            counterValuesSeen[index] = value;
+        }
+    }
+    producers.join_all();
+    BOOST_REQUIRE_EQUAL(totalSeen, TOTAL_INCREMENTS);
+    uint32_t index;
+    while (q.Pop(index)) {} //pushes after the last increment was already seen
+    BOOST_REQUIRE_LE(numPops, TOTAL_INCREMENTS);
+}
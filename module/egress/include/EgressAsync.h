@@ -6,6 +6,7 @@
 #include <string>
 
 #include "message.hpp"
+#include "IngressAckBatcher.hpp"
 #include "zmq.hpp"
 #include <boost/thread.hpp>
 #include <boost/asio.hpp>
@@ -14,6 +15,10 @@
 #include "HdtnConfig.h"
 #include "OutductManager.h"
 #include "CircularIndexBufferSingleProducerSingleConsumerConfigurable.h"
+#include "UniqueIndexQueueMultiProducerSingleConsumer.h"
+#include "EgressScheduler.h"
+#include "SharedMemoryBundleArena.h"
+#include "InterModuleChannel.h"
 #include "Logger.h"
 #include "egress_async_lib_export.h"
 
@@ -36,7 +41,10 @@ public:
     EGRESS_ASYNC_LIB_EXPORT HegrManagerAsync();
     EGRESS_ASYNC_LIB_EXPORT ~HegrManagerAsync();
     EGRESS_ASYNC_LIB_EXPORT void Stop();
-    EGRESS_ASYNC_LIB_EXPORT void Init(const HdtnConfig & hdtnConfig, zmq::context_t * hdtnOneProcessZmqInprocContextPtr = NULL);
+    //in one-process mode, the native channels (if not NULL) replace the inproc sockets for bundles from ingress and storage
+    EGRESS_ASYNC_LIB_EXPORT void Init(const HdtnConfig & hdtnConfig, zmq::context_t * hdtnOneProcessZmqInprocContextPtr = NULL,
+        NativeInterModuleChannel<hdtn::ToEgressHdr> * ingressToEgressNativeChannelPtr = NULL,
+        NativeInterModuleChannel<hdtn::ToEgressHdr> * storageToEgressNativeChannelPtr = NULL);
 
     uint64_t m_bundleCount;
     uint64_t m_bundleData;
@@ -52,15 +60,65 @@ public:
 
     std::unique_ptr<zmq::socket_t> m_zmqPullSignalInprocSockPtr;
     std::unique_ptr<zmq::socket_t> m_zmqPushSignalInprocSockPtr;
+    //bundles and link messages are received through these, over the pull sockets above or native channels
+    std::unique_ptr<ZmqInterModuleChannelReceiver<hdtn::ToEgressHdr> > m_zmqFromIngressChannelReceiverPtr;
+    std::unique_ptr<ZmqInterModuleChannelReceiver<hdtn::ToEgressHdr> > m_zmqFromStorageChannelReceiverPtr;
+    InterModuleChannelReceiver<hdtn::ToEgressHdr> * m_fromIngressChannelReceiverPtr;
+    InterModuleChannelReceiver<hdtn::ToEgressHdr> * m_fromStorageChannelReceiverPtr;
     EGRESS_ASYNC_LIB_EXPORT void RouterEventHandler();
+    //all zeros when the scheduler is disabled (egressSchedulerQuantumBytes of 0)
+    EGRESS_ASYNC_LIB_EXPORT void GetSchedulerTelemetry(EgressSchedulerTelemetry & telem);
 private:
     EGRESS_ASYNC_LIB_NO_EXPORT void ReadZmqThreadFunc();
     EGRESS_ASYNC_LIB_NO_EXPORT void OnSuccessfulBundleAck(uint64_t outductUuidIndex);
     EGRESS_ASYNC_LIB_NO_EXPORT void WholeBundleReadyCallback(padded_vector_uint8_t & wholeBundleVec);
+    EGRESS_ASYNC_LIB_NO_EXPORT void SendAckBatchToIngress(IngressAckBatcher & ingressAckBatcher);
+    EGRESS_ASYNC_LIB_NO_EXPORT bool SendAckBatchToStorage(std::vector<hdtn::EgressAckHdr> & egressAcksToStorageVec);
+    EGRESS_ASYNC_LIB_NO_EXPORT void SignalReadZmqThread();
+    EGRESS_ASYNC_LIB_NO_EXPORT void ForwardToWorker(Outduct * outduct, zmq::message_t & zmqMessageBundle);
+    EGRESS_ASYNC_LIB_NO_EXPORT void ForwardBundle(Outduct * outduct, zmq::message_t & zmqMessageBundle);
+    EGRESS_ASYNC_LIB_NO_EXPORT bool OutductPipelineHasRoom(Outduct * outduct);
+    EGRESS_ASYNC_LIB_NO_EXPORT void ForwardScheduledBundles(Outduct * outduct, std::queue<hdtn::EgressAckHdr> & needAcksQueue);
+    EGRESS_ASYNC_LIB_NO_EXPORT void StopWorkers();
+
+    struct EgressWorker;
+    EGRESS_ASYNC_LIB_NO_EXPORT void WorkerThreadFunc(EgressWorker * workerPtr);
+
+    static constexpr std::size_t MAX_ACK_RANGES_PER_MESSAGE_TO_INGRESS = 256;
+    static constexpr std::size_t MAX_ACKS_PER_MESSAGE_TO_STORAGE = 256;
 
     OutductManager m_outductManager;
     HdtnConfig m_hdtnConfig;
 
+    //a bundle waiting in a worker's queue to be forwarded by that worker's thread
+    struct EgressWorkerQueueItem {
+        EgressWorkerQueueItem(Outduct * paramOutduct, zmq::message_t && paramZmqMessageBundle) :
+            outduct(paramOutduct), zmqMessageBundle(std::move(paramZmqMessageBundle)) {}
+        Outduct * outduct;
+        zmq::message_t zmqMessageBundle;
+    };
+    //When numEgressWorkerThreads is 0, bundles are forwarded on the zmq reader thread.
+    //Otherwise each worker forwards for the outducts whose uuid maps to it (uuid modulo the number of workers),
+    //so a slow or blocked outduct only holds up its own worker, and per-outduct bundle ordering is preserved.
+    struct EgressWorker {
+        EgressWorker() : m_running(true), m_totalBundlesForwarded(0) {}
+        std::queue<EgressWorkerQueueItem> m_workQueue;
+        boost::mutex m_workQueueMutex;
+        boost::condition_variable m_conditionVariableWorkQueueNotEmpty;
+        std::unique_ptr<boost::thread> m_threadPtr;
+        bool m_running; //protected by m_workQueueMutex
+        uint64_t m_totalBundlesForwarded;
+    };
+    std::vector<std::unique_ptr<EgressWorker> > m_workers;
+    //per outduct uuid, bundles handed to a worker but not yet forwarded (not yet counted by the outduct as unacked)
+    std::unique_ptr<boost::atomic<uint64_t>[]> m_outductBundlesWaitingForWorkerArray;
+
+    //Set when egressSchedulerQuantumBytes is non-zero: bundles then wait in the scheduler until their outduct's pipeline
+    //(bundlePipelineLimit) has room, and the scheduler picks which one goes next.  Only used by the zmq reader thread.
+    std::unique_ptr<EgressScheduler> m_schedulerPtr;
+
+    //outduct uuids whose acked counters changed since the egress thread last looked, pushed from the outduct io threads
+    std::unique_ptr<UniqueIndexQueueMultiProducerSingleConsumer> m_outductsWithAcksQueuePtr;
     boost::mutex m_mutexPushSignal;
     boost::mutex m_mutexPushBundleToIngress;
     volatile bool m_needToSendSignal;
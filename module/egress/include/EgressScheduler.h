@@ -0,0 +1,86 @@
+#ifndef _EGRESS_SCHEDULER_H
+#define _EGRESS_SCHEDULER_H
+
+#include <cstdint>
+#include <list>
+#include <map>
+#include <queue>
+#include <vector>
+#include <boost/atomic.hpp>
+#include "codec/Cbhe.h"
+#include "message.hpp"
+#include "zmq.hpp"
+#include "egress_async_lib_export.h"
+
+#define EGRESS_SCHEDULER_NUMBER_OF_PRIORITIES (3) //00 = bulk, 01 = normal, 10 = expedited (same as storage)
+
+typedef struct EgressSchedulerTelemetry {
+    uint64_t queuedBundles[EGRESS_SCHEDULER_NUMBER_OF_PRIORITIES];
+    uint64_t queuedBytes[EGRESS_SCHEDULER_NUMBER_OF_PRIORITIES];
+    uint64_t maxQueuedBundles[EGRESS_SCHEDULER_NUMBER_OF_PRIORITIES]; //high water mark
+    uint64_t totalBundlesScheduled[EGRESS_SCHEDULER_NUMBER_OF_PRIORITIES];
+} EgressSchedulerTelemetry;
+
+//Holds bundles in egress until their outduct has room in its pipeline, then picks which one goes next.
+//Each outduct has one flow per (priority, final destination).  Expedited flows are always served before any
+//bulk or normal flow (strict priority), and within each of those two classes the flows are served by byte-based
+//deficit round robin, where a flow's quantum is the configured quantum times the weight of its priority
+//(expedited flows all have a weight of 1).  Bundles of the same flow leave in arrival order.
+//Only the egress zmq thread may call the non-const members; GetTelemetry is thread safe.
+class EgressScheduler {
+private:
+    EgressScheduler();
+public:
+    struct scheduled_bundle_t {
+        scheduled_bundle_t(const hdtn::EgressAckHdr & paramEgressAck, zmq::message_t && paramZmqMessageBundle) :
+            egressAck(paramEgressAck), zmqMessageBundle(std::move(paramZmqMessageBundle)) {}
+        hdtn::EgressAckHdr egressAck; //queued for the outduct ack once the bundle is forwarded
+        zmq::message_t zmqMessageBundle;
+    };
+
+    EGRESS_ASYNC_LIB_EXPORT EgressScheduler(const std::size_t numOutducts, const uint64_t quantumBytes, const uint64_t bulkWeight, const uint64_t normalWeight);
+    EGRESS_ASYNC_LIB_EXPORT ~EgressScheduler();
+
+    //priorityIndex values above expedited are treated as expedited
+    EGRESS_ASYNC_LIB_EXPORT void Push(const uint64_t outductUuid, const uint8_t priorityIndex, const hdtn::EgressAckHdr & egressAck, zmq::message_t & movableZmqMessageBundle);
+    //moves the next bundle to be forwarded on this outduct into the parameters, false if none is queued
+    EGRESS_ASYNC_LIB_EXPORT bool Pop(const uint64_t outductUuid, hdtn::EgressAckHdr & egressAck, zmq::message_t & zmqMessageBundle);
+    EGRESS_ASYNC_LIB_EXPORT bool HasQueuedBundles(const uint64_t outductUuid) const;
+    EGRESS_ASYNC_LIB_EXPORT std::size_t GetNumQueuedBundles() const;
+    EGRESS_ASYNC_LIB_EXPORT std::size_t GetNumActiveFlows(const uint64_t outductUuid) const;
+    EGRESS_ASYNC_LIB_EXPORT void GetTelemetry(EgressSchedulerTelemetry & telem) const;
+
+private:
+    struct flow_t {
+        flow_t() : deficitBytes(0), quantumBytes(0), priorityIndex(0), quantumAddedThisRound(false) {}
+        std::queue<scheduled_bundle_t> bundleQueue;
+        uint64_t deficitBytes;
+        uint64_t quantumBytes;
+        uint8_t priorityIndex;
+        bool quantumAddedThisRound;
+    };
+    typedef std::list<flow_t*> active_flows_list_t;
+    typedef std::map<std::pair<uint8_t, cbhe_eid_t>, flow_t> flows_map_t;
+    struct outduct_queues_t {
+        outduct_queues_t() : numQueuedBundles(0) {}
+        flows_map_t flowsMap; //only the active flows (erased when their queue empties), map nodes keep their addresses
+        active_flows_list_t activeExpeditedFlowsList;
+        active_flows_list_t activeWeightedFlowsList; //bulk and normal
+        std::size_t numQueuedBundles;
+    };
+
+    EGRESS_ASYNC_LIB_NO_EXPORT static flow_t * VisitEachFlowOnce(active_flows_list_t & activeFlowsList);
+    EGRESS_ASYNC_LIB_NO_EXPORT static flow_t & DeficitRoundRobinNext(active_flows_list_t & activeFlowsList);
+
+    uint64_t m_quantumBytesPerPriority[EGRESS_SCHEDULER_NUMBER_OF_PRIORITIES];
+    std::vector<outduct_queues_t> m_outductQueuesVec; //outduct uuid is the index
+    std::size_t m_numQueuedBundles;
+
+    //only written by the egress zmq thread
+    boost::atomic<uint64_t> m_queuedBundles[EGRESS_SCHEDULER_NUMBER_OF_PRIORITIES];
+    boost::atomic<uint64_t> m_queuedBytes[EGRESS_SCHEDULER_NUMBER_OF_PRIORITIES];
+    boost::atomic<uint64_t> m_maxQueuedBundles[EGRESS_SCHEDULER_NUMBER_OF_PRIORITIES];
+    boost::atomic<uint64_t> m_totalBundlesScheduled[EGRESS_SCHEDULER_NUMBER_OF_PRIORITIES];
+};
+
+#endif //_EGRESS_SCHEDULER_H
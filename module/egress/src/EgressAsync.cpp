@@ -25,8 +25,13 @@
 #include <fstream>
 
 #include <sstream>
+#include <algorithm>
 
-hdtn::HegrManagerAsync::HegrManagerAsync() : m_running(false) {
+hdtn::HegrManagerAsync::HegrManagerAsync() :
+    m_fromIngressChannelReceiverPtr(NULL),
+    m_fromStorageChannelReceiverPtr(NULL),
+    m_running(false)
+{
     //m_flags = 0;
     //_next = NULL;
 }
@@ -41,9 +46,29 @@ void hdtn::HegrManagerAsync::Stop() {
         m_threadZmqReaderPtr->join();
         m_threadZmqReaderPtr.reset(); //delete it
     }
+    StopWorkers();
 }
 
-void hdtn::HegrManagerAsync::Init(const HdtnConfig & hdtnConfig, zmq::context_t * hdtnOneProcessZmqInprocContextPtr) {
+void hdtn::HegrManagerAsync::StopWorkers() {
+    for (std::size_t i = 0; i < m_workers.size(); ++i) {
+        EgressWorker & worker = *m_workers[i];
+        {
+            boost::mutex::scoped_lock lock(worker.m_workQueueMutex);
+            worker.m_running = false;
+        }
+        worker.m_conditionVariableWorkQueueNotEmpty.notify_one();
+        if (worker.m_threadPtr) {
+            worker.m_threadPtr->join();
+            worker.m_threadPtr.reset(); //delete it
+        }
+        std::cout << "egress worker " << i << " totalBundlesForwarded: " << worker.m_totalBundlesForwarded << std::endl;
+    }
+    m_workers.clear();
+}
+
+void hdtn::HegrManagerAsync::Init(const HdtnConfig & hdtnConfig, zmq::context_t * hdtnOneProcessZmqInprocContextPtr,
+    NativeInterModuleChannel<hdtn::ToEgressHdr> * ingressToEgressNativeChannelPtr, NativeInterModuleChannel<hdtn::ToEgressHdr> * storageToEgressNativeChannelPtr)
+{
 
     if (m_running) {
         std::cerr << "error: HegrManagerAsync::Init called while Egress is already running" << std::endl;
@@ -56,9 +81,40 @@ void hdtn::HegrManagerAsync::Init(const HdtnConfig & hdtnConfig, zmq::context_t
         boost::bind(&hdtn::HegrManagerAsync::WholeBundleReadyCallback, this, boost::placeholders::_1))) {
         return;
     }
+    //outduct uuids are the indices of the outducts config vector
+    m_outductsWithAcksQueuePtr = boost::make_unique<UniqueIndexQueueMultiProducerSingleConsumer>(
+        static_cast<uint32_t>(m_hdtnConfig.m_outductsConfig.m_outductElementConfigVector.size()));
 
     m_outductManager.SetOutductManagerOnSuccessfulOutductAckCallback(boost::bind(&HegrManagerAsync::OnSuccessfulBundleAck, this, boost::placeholders::_1));
 
+    static constexpr uint64_t MAX_EGRESS_WORKER_THREADS = 256;
+    if (m_hdtnConfig.m_numEgressWorkerThreads > MAX_EGRESS_WORKER_THREADS) {
+        std::cerr << "error: egress numEgressWorkerThreads (" << m_hdtnConfig.m_numEgressWorkerThreads
+            << ") exceeds the maximum of " << MAX_EGRESS_WORKER_THREADS << std::endl;
+        return;
+    }
+    m_outductBundlesWaitingForWorkerArray.reset(new boost::atomic<uint64_t>[m_outductsWithAcksQueuePtr->GetNumIndices()]);
+    for (uint32_t i = 0; i < m_outductsWithAcksQueuePtr->GetNumIndices(); ++i) {
+        m_outductBundlesWaitingForWorkerArray[i] = 0;
+    }
+    if (m_hdtnConfig.m_egressSchedulerQuantumBytes) {
+        m_schedulerPtr = boost::make_unique<EgressScheduler>(m_outductsWithAcksQueuePtr->GetNumIndices(),
+            m_hdtnConfig.m_egressSchedulerQuantumBytes, m_hdtnConfig.m_egressSchedulerBulkWeight, m_hdtnConfig.m_egressSchedulerNormalWeight);
+        //the scheduler only holds bundles while an outduct's pipeline is full, so it cannot reorder anything on an unlimited outduct
+        const outduct_element_config_vector_t & outductElementConfigVector = m_hdtnConfig.m_outductsConfig.m_outductElementConfigVector;
+        for (std::size_t i = 0; i < outductElementConfigVector.size(); ++i) {
+            if (outductElementConfigVector[i].bundlePipelineLimit == 0) {
+                const std::string msg = "warning: egress scheduler has no effect on outduct " + outductElementConfigVector[i].name +
+                    " because its bundlePipelineLimit is 0 (unlimited): its bundles are forwarded in arrival order";
+                std::cout << msg << std::endl;
+                hdtn::Logger::getInstance()->logWarning("egress", msg);
+            }
+        }
+    }
+    else {
+        m_schedulerPtr.reset();
+    }
+
     
     m_bundleCount = 0;
     m_bundleData = 0;
@@ -155,6 +211,24 @@ void hdtn::HegrManagerAsync::Init(const HdtnConfig & hdtnConfig, zmq::context_t
         //MQ shall take appropriate action such as blocking or dropping sent messages.
         const int hwm = 5; //todo
         m_zmqPushSock_connectingEgressBundlesOnlyToBoundIngressPtr->set(zmq::sockopt::sndhwm, hwm); //flow control
+
+        //the native channels wake up this thread the same way the outduct acks do
+        if (hdtnOneProcessZmqInprocContextPtr && ingressToEgressNativeChannelPtr) {
+            ingressToEgressNativeChannelPtr->SetNotifyReceiverFunction(boost::bind(&HegrManagerAsync::SignalReadZmqThread, this));
+            m_fromIngressChannelReceiverPtr = ingressToEgressNativeChannelPtr;
+        }
+        else {
+            m_zmqFromIngressChannelReceiverPtr = boost::make_unique<ZmqInterModuleChannelReceiver<hdtn::ToEgressHdr> >(m_zmqPullSock_boundIngressToConnectingEgressPtr.get());
+            m_fromIngressChannelReceiverPtr = m_zmqFromIngressChannelReceiverPtr.get();
+        }
+        if (hdtnOneProcessZmqInprocContextPtr && storageToEgressNativeChannelPtr) {
+            storageToEgressNativeChannelPtr->SetNotifyReceiverFunction(boost::bind(&HegrManagerAsync::SignalReadZmqThread, this));
+            m_fromStorageChannelReceiverPtr = storageToEgressNativeChannelPtr;
+        }
+        else {
+            m_zmqFromStorageChannelReceiverPtr = boost::make_unique<ZmqInterModuleChannelReceiver<hdtn::ToEgressHdr> >(m_zmqPullSock_connectingStorageToBoundEgressPtr.get());
+            m_fromStorageChannelReceiverPtr = m_zmqFromStorageChannelReceiverPtr.get();
+        }
     }
     catch (const zmq::error_t & ex) {
         std::cerr << "error: egress cannot set up zmq socket: " << ex.what() << std::endl;
@@ -162,6 +236,14 @@ void hdtn::HegrManagerAsync::Init(const HdtnConfig & hdtnConfig, zmq::context_t
     }
     if (!m_running) {
         m_running = true;
+        //more workers than outducts would never be used
+        const std::size_t numWorkers = static_cast<std::size_t>(std::min<uint64_t>(m_hdtnConfig.m_numEgressWorkerThreads, m_outductsWithAcksQueuePtr->GetNumIndices()));
+        m_workers.reserve(numWorkers);
+        for (std::size_t i = 0; i < numWorkers; ++i) {
+            m_workers.push_back(boost::make_unique<EgressWorker>());
+            m_workers.back()->m_threadPtr = boost::make_unique<boost::thread>(
+                boost::bind(&HegrManagerAsync::WorkerThreadFunc, this, m_workers.back().get()));
+        }
         m_threadZmqReaderPtr = boost::make_unique<boost::thread>(
             boost::bind(&HegrManagerAsync::ReadZmqThreadFunc, this)); //create and start the worker thread
     }
@@ -169,6 +251,13 @@ void hdtn::HegrManagerAsync::Init(const HdtnConfig & hdtnConfig, zmq::context_t
 
 void hdtn::HegrManagerAsync::OnSuccessfulBundleAck(uint64_t outductUuidIndex) {
     //m_conditionVariableProcessZmqMessages.notify_one();
+    if (!m_outductsWithAcksQueuePtr->Push_ThreadSafe(static_cast<uint32_t>(outductUuidIndex))) {
+        return; //already queued and not yet drained by the egress thread, which has already been signaled
+    }
+    SignalReadZmqThread();
+}
+
+void hdtn::HegrManagerAsync::SignalReadZmqThread() {
     if (m_needToSendSignal && m_mutexPushSignal.try_lock()) {
         if (m_needToSendSignal) {
             static const char signalByte = 0;
@@ -176,17 +265,125 @@ void hdtn::HegrManagerAsync::OnSuccessfulBundleAck(uint64_t outductUuidIndex) {
             m_needToSendSignal = false;
             ++m_totalEgressInprocSignalsSent;
             if (!m_zmqPushSignalInprocSockPtr->send(signalByteConstBuf, zmq::send_flags::dontwait)) {
-                std::cout << "error in hdtn::HegrManagerAsync::OnSuccessfulBundleAck: unable to send signal\n";
+                std::cout << "error in hdtn::HegrManagerAsync::SignalReadZmqThread: unable to send signal\n";
             }
         }
         m_mutexPushSignal.unlock();
     }
 }
 
-static void CustomCleanupEgressAckHdrNoHint(void *data, void *hint) {
-    (void)hint;
-    //std::cout << "free " << static_cast<hdtn::BlockHdr *>(data)->flowId << std::endl;
-    delete static_cast<hdtn::EgressAckHdr *>(data);
+//a batch that could not be queued stays in ingressAckBatcher and is retried on the next loop iteration
+void hdtn::HegrManagerAsync::SendAckBatchToIngress(IngressAckBatcher & ingressAckBatcher) {
+    if (!ingressAckBatcher.Send(*m_zmqPushSock_connectingEgressToBoundIngressPtr)) {
+        std::cout << "error: zmq could not send ingress a batch of acks from egress (will retry)" << std::endl;
+        hdtn::Logger::getInstance()->logError("egress", "Error: zmq could not send ingress a batch of acks from egress (will retry)");
+    }
+}
+
+void hdtn::HegrManagerAsync::ForwardToWorker(Outduct * outduct, zmq::message_t & zmqMessageBundle) {
+    const uint64_t outductUuid = outduct->GetOutductUuid();
+    //counted as waiting before the ack FIFO could ever see it, so the ack dispatch never mistakes it for acked
+    m_outductBundlesWaitingForWorkerArray[outductUuid].fetch_add(1, boost::memory_order_seq_cst);
+    EgressWorker & worker = *m_workers[outductUuid % m_workers.size()];
+    {
+        boost::mutex::scoped_lock lock(worker.m_workQueueMutex);
+        worker.m_workQueue.emplace(outduct, std::move(zmqMessageBundle));
+    }
+    worker.m_conditionVariableWorkQueueNotEmpty.notify_one();
+}
+
+void hdtn::HegrManagerAsync::WorkerThreadFunc(EgressWorker * workerPtr) {
+    EgressWorker & worker = *workerPtr;
+    std::queue<EgressWorkerQueueItem> localQueue;
+    while (true) {
+        {
+            boost::mutex::scoped_lock lock(worker.m_workQueueMutex);
+            while (worker.m_workQueue.empty() && worker.m_running) {
+                worker.m_conditionVariableWorkQueueNotEmpty.wait(lock); // call lock.unlock() and blocks the current thread
+            }
+            if (worker.m_workQueue.empty()) { //only when stopping (bundles already queued are still forwarded)
+                break;
+            }
+            localQueue.swap(worker.m_workQueue); //take everything queued so far with one lock
+        }
+        while (!localQueue.empty()) {
+            EgressWorkerQueueItem & item = localQueue.front();
+            const uint64_t outductUuid = item.outduct->GetOutductUuid();
+            item.outduct->Forward(item.zmqMessageBundle);
+            if (item.zmqMessageBundle.size() != 0) {
+                std::cout << "Error in hdtn::HegrManagerAsync::WorkerThreadFunc, zmqMessage was not moved" << std::endl;
+                hdtn::Logger::getInstance()->logError("egress", "Error in hdtn::HegrManagerAsync::WorkerThreadFunc, zmqMessage was not moved");
+            }
+            //decremented only after the outduct counts it as unacked (so it is always counted by one or the other)
+            m_outductBundlesWaitingForWorkerArray[outductUuid].fetch_sub(1, boost::memory_order_seq_cst);
+            //an ack for this bundle may have been reported (and dispatched) before the decrement, so have the ack dispatch look again
+            m_outductsWithAcksQueuePtr->Push_ThreadSafe(static_cast<uint32_t>(outductUuid));
+            ++worker.m_totalBundlesForwarded;
+            localQueue.pop();
+        }
+        SignalReadZmqThread();
+    }
+}
+
+void hdtn::HegrManagerAsync::ForwardBundle(Outduct * outduct, zmq::message_t & zmqMessageBundle) {
+    if (!m_workers.empty()) {
+        ForwardToWorker(outduct, zmqMessageBundle);
+    }
+    else {
+        outduct->Forward(zmqMessageBundle);
+    }
+    if (zmqMessageBundle.size() != 0) {
+        std::cout << "Error in hdtn::HegrManagerAsync::ProcessZmqMessagesThreadFunc, zmqMessage was not moved" << std::endl;
+        hdtn::Logger::getInstance()->logError("egress", "Error in hdtn::HegrManagerAsync::ProcessZmqMessagesThreadFunc, zmqMessage was not moved");
+    }
+}
+
+//a bundlePipelineLimit of 0 means no limit, so the scheduler never holds bundles for that outduct
+bool hdtn::HegrManagerAsync::OutductPipelineHasRoom(Outduct * outduct) {
+    const uint64_t pipelineLimit = outduct->GetOutductMaxBundlesInPipeline();
+    if (pipelineLimit == 0) {
+        return true;
+    }
+    const uint64_t numWaitingForWorker = (m_workers.empty()) ? 0 :
+        m_outductBundlesWaitingForWorkerArray[outduct->GetOutductUuid()].load(boost::memory_order_seq_cst);
+    return ((outduct->GetTotalDataSegmentsUnacked() + numWaitingForWorker) < pipelineLimit);
+}
+
+//moves scheduled bundles to the outduct while its pipeline has room (called after a bundle arrives or the outduct reports acks)
+void hdtn::HegrManagerAsync::ForwardScheduledBundles(Outduct * outduct, std::queue<hdtn::EgressAckHdr> & needAcksQueue) {
+    const uint64_t outductUuid = outduct->GetOutductUuid();
+    zmq::message_t zmqMessageBundle;
+    while (m_schedulerPtr->HasQueuedBundles(outductUuid) && OutductPipelineHasRoom(outduct)) {
+        //queued before the forward so that it is already there when the outduct reports the ack (from any thread)
+        needAcksQueue.emplace();
+        m_schedulerPtr->Pop(outductUuid, needAcksQueue.back(), zmqMessageBundle);
+        ForwardBundle(outduct, zmqMessageBundle);
+    }
+}
+
+void hdtn::HegrManagerAsync::GetSchedulerTelemetry(EgressSchedulerTelemetry & telem) {
+    if (m_schedulerPtr) {
+        m_schedulerPtr->GetTelemetry(telem);
+    }
+    else {
+        memset(&telem, 0, sizeof(telem));
+    }
+}
+
+//sends all pending acks to storage as one message of consecutive EgressAckHdr structs (non-blocking),
+//keeping them for a retry on the next loop iteration if the message could not be queued
+bool hdtn::HegrManagerAsync::SendAckBatchToStorage(std::vector<hdtn::EgressAckHdr> & egressAcksToStorageVec) {
+    if (egressAcksToStorageVec.empty()) {
+        return true;
+    }
+    zmq::message_t zmqMessage(egressAcksToStorageVec.data(), egressAcksToStorageVec.size() * sizeof(hdtn::EgressAckHdr));
+    if (!m_zmqPushSock_boundEgressToConnectingStoragePtr->send(std::move(zmqMessage), zmq::send_flags::dontwait)) {
+        std::cout << "error: m_zmqPushSock_boundEgressToConnectingStoragePtr could not send" << std::endl;
+        hdtn::Logger::getInstance()->logError("egress", "Error: m_zmqPushSock_boundEgressToConnectingStoragePtr could not send");
+        return false;
+    }
+    egressAcksToStorageVec.clear();
+    return true;
 }
 
 void hdtn::HegrManagerAsync::RouterEventHandler() {
@@ -232,6 +429,7 @@ void hdtn::HegrManagerAsync::ReadZmqThreadFunc() {
     }
     m_needToSendSignal = true;
     std::size_t totalCustodyTransfersSentToStorage = 0;
+    std::size_t totalAckMessagesSentToStorage = 0;
     std::size_t totalCustodyTransfersSentToIngress = 0;
     std::size_t totalEgressInprocSignalsReceived = 0;
     m_totalEgressInprocSignalsSent = 0;
@@ -239,11 +437,16 @@ void hdtn::HegrManagerAsync::ReadZmqThreadFunc() {
     char junkChar;
     const zmq::mutable_buffer signalRxBufferJunk(&junkChar, sizeof(junkChar));
 
-    typedef std::queue<std::unique_ptr<hdtn::EgressAckHdr> > queue_t;
-    typedef std::map<uint64_t, queue_t> outductuuid_needacksqueue_map_t;
+    typedef std::queue<hdtn::EgressAckHdr> queue_t;
 
-    outductuuid_needacksqueue_map_t outductUuidToNeedAcksQueueMap;
+    std::vector<queue_t> outductUuidToNeedAcksQueueVec(m_outductsWithAcksQueuePtr->GetNumIndices()); //outduct uuid is the index
+    std::vector<hdtn::EgressAckHdr> egressAcksToStorageVec;
+    egressAcksToStorageVec.reserve(MAX_ACKS_PER_MESSAGE_TO_STORAGE);
     std::set<uint64_t> availableDestOpportunisticNodeIdsSet;
+    //the route table snapshot is only reloaded after a route update
+    uint64_t routeTableGeneration = m_outductManager.GetRouteTableGeneration_ThreadSafe();
+    OutductManager::route_table_snapshot_t routeTableSnapshot = m_outductManager.GetRouteTableSnapshot_ThreadSafe();
+    IngressAckBatcher ingressAckBatcher(HDTN_MSGTYPE_EGRESS_ACK_BATCH_TO_INGRESS, MAX_ACK_RANGES_PER_MESSAGE_TO_INGRESS);
 
     // Use a form of receive that times out so we can terminate cleanly.
     static const int timeout = 250;  // milliseconds
@@ -256,44 +459,75 @@ void hdtn::HegrManagerAsync::ReadZmqThreadFunc() {
 	{m_zmqSubSock_boundRouterToConnectingEgressPtr->handle(), 0, ZMQ_POLLIN, 0},
         {m_zmqPullSignalInprocSockPtr->handle(), 0, ZMQ_POLLIN, 0}
     };
-    zmq::socket_t * const sockets[NUM_SOCKETS-1] = {
-        m_zmqPullSock_boundIngressToConnectingEgressPtr.get(),
-        m_zmqPullSock_connectingStorageToBoundEgressPtr.get(),
-	m_zmqSubSock_boundRouterToConnectingEgressPtr.get(),
+    //index 0 is ingress and index 1 is storage
+    static constexpr unsigned int NUM_BUNDLE_RECEIVERS = 2;
+    static constexpr unsigned int MAX_MESSAGES_PER_BUNDLE_RECEIVER_PER_ITERATION = 16;
+    InterModuleChannelReceiver<hdtn::ToEgressHdr> * const bundleReceivers[NUM_BUNDLE_RECEIVERS] = {
+        m_fromIngressChannelReceiverPtr,
+        m_fromStorageChannelReceiverPtr
+    };
+    //multi-process mode with shared memory enabled: ingress and storage each own the arena their bundles come through
+    SharedMemoryBundleArenaReader sharedMemoryBundleArenaReaders[2] = {
+        SharedMemoryBundleArenaReader(SharedMemoryBundleArena::GetArenaName(m_hdtnConfig.m_zmqBoundIngressToConnectingEgressPortPath)),
+        SharedMemoryBundleArenaReader(SharedMemoryBundleArena::GetArenaName(m_hdtnConfig.m_zmqConnectingStorageToBoundEgressPortPath))
     };
 
     static const long DEFAULT_BIG_TIMEOUT_POLL = 250;
+    bool bundleReceiversHadBacklog = false;
     while (m_running) { //keep thread alive if running
         int rc = 0;
         try {
-            rc = zmq::poll(&items[0], NUM_SOCKETS, DEFAULT_BIG_TIMEOUT_POLL);
+            //don't wait if a native channel still has messages, and retry soon if storage could not take the last batch of acks
+            rc = zmq::poll(&items[0], NUM_SOCKETS, (bundleReceiversHadBacklog) ? 0 : (egressAcksToStorageVec.empty()) ? DEFAULT_BIG_TIMEOUT_POLL : 1);
         }
         catch (zmq::error_t & e) {
             std::cout << "caught zmq::error_t in hdtn::HegrManagerAsync::ReadZmqThreadFunc: " << e.what() << std::endl;
             continue;
         }
         if (rc > 0) {
-            for (unsigned int itemIndex = 0; itemIndex < (NUM_SOCKETS - 2); ++itemIndex) { //skip m_zmqPullSignalInprocSockPtr in this loop
-                if ((items[itemIndex].revents & ZMQ_POLLIN) == 0) {
-                    continue;
-                }
+            if (items[NUM_SOCKETS - 2].revents & ZMQ_POLLIN) { //events from Router
+                std::cout << "[Egress] Received RouteUpdate event!!" << std::endl;
+                RouterEventHandler();
+            }
 
-                hdtn::ToEgressHdr toEgressHeader;
-                const zmq::recv_buffer_result_t res = sockets[itemIndex]->recv(zmq::mutable_buffer(&toEgressHeader, sizeof(hdtn::ToEgressHdr)), zmq::recv_flags::none);
+            if ((items[NUM_SOCKETS - 1].revents & ZMQ_POLLIN)) { //m_zmqPullSignalInprocSockPtr                
+                const zmq::recv_buffer_result_t res = m_zmqPullSignalInprocSockPtr->recv(signalRxBufferJunk, zmq::recv_flags::none);
                 if (!res) {
-                    std::cerr << "error in HegrManagerAsync::ReadZmqThreadFunc: cannot read BlockHdr" << std::endl;
-                    hdtn::Logger::getInstance()->logError("egress", "Error in HegrManagerAsync::ReadZmqThreadFunc: cannot read BlockHdr");
-                    continue;
+                    std::cerr << "error in HegrManagerAsync::ReadZmqThreadFunc: signal not received" << std::endl;
                 }
-                else if ((res->truncated()) || (res->size != sizeof(hdtn::ToEgressHdr))) {
-                    std::cerr << "egress blockhdr message mismatch: untruncated = " << res->untruncated_size 
-                        << " truncated = " << res->size << " expected = " << sizeof(hdtn::ToEgressHdr) << std::endl;
-                    hdtn::Logger::getInstance()->logError("egress", "Egress blockhdr message mismatch: untruncated = " + 
-                        std::to_string(res->untruncated_size) +  " truncated = " + std::to_string(res->size) + " expected = " + 
-                        std::to_string(sizeof(hdtn::ToEgressHdr)));
-                    continue;
+                else if ((res->truncated()) || (res->size != sizeof(junkChar))) {
+                    std::cerr << "error in HegrManagerAsync::ReadZmqThreadFunc: signal message mismatch: untruncated = " << res->untruncated_size
+                        << " truncated = " << res->size << " expected = " << sizeof(junkChar) << std::endl;
+                }
+                else {
+                    ++totalEgressInprocSignalsReceived;
                 }
-                else if ((itemIndex == 0) && (toEgressHeader.base.type == HDTN_MSGTYPE_EGRESS_ADD_OPPORTUNISTIC_LINK)) {
+                m_needToSendSignal = true;
+                
+            }
+        }
+        else if ((rc == 0) && (!bundleReceiversHadBacklog)) {
+            //idle: also visit every outduct still owed acks, a safety net should an outduct ever update its
+            //acked counters without reporting it (cheap since nothing else is happening)
+            for (std::size_t outductUuid = 0; outductUuid < outductUuidToNeedAcksQueueVec.size(); ++outductUuid) {
+                if ((!outductUuidToNeedAcksQueueVec[outductUuid].empty()) || (m_schedulerPtr && m_schedulerPtr->HasQueuedBundles(outductUuid))) {
+                    m_outductsWithAcksQueuePtr->Push_ThreadSafe(static_cast<uint32_t>(outductUuid));
+                }
+            }
+        }
+        //Bundles and opportunistic link messages from ingress and storage.  Received after the signal socket (which
+        //re-arms SignalReadZmqThread) so that anything sent to a native channel during this iteration is either received
+        //below or signals the next poll.
+        bundleReceiversHadBacklog = false;
+        for (unsigned int itemIndex = 0; itemIndex < NUM_BUNDLE_RECEIVERS; ++itemIndex) {
+            InterModuleChannelReceiver<hdtn::ToEgressHdr> & bundleReceiver = *bundleReceivers[itemIndex];
+            for (unsigned int numReceived = 0; numReceived < MAX_MESSAGES_PER_BUNDLE_RECEIVER_PER_ITERATION; ++numReceived) {
+                hdtn::ToEgressHdr toEgressHeader;
+                zmq::message_t zmqMessageBundle; //empty for link messages
+                if (!bundleReceiver.TryReceive(toEgressHeader, zmqMessageBundle)) {
+                    break;
+                }
+                if ((itemIndex == 0) && (toEgressHeader.base.type == HDTN_MSGTYPE_EGRESS_ADD_OPPORTUNISTIC_LINK)) {
                     std::cout << "egress adding opportunistic link " << toEgressHeader.finalDestEid.nodeId << std::endl;
                     availableDestOpportunisticNodeIdsSet.insert(toEgressHeader.finalDestEid.nodeId);
                     continue;
@@ -316,12 +550,10 @@ void hdtn::HegrManagerAsync::ReadZmqThreadFunc() {
                     continue;
                 }
                 ++m_messageCount;
-                
-                
-                zmq::message_t zmqMessageBundle;
-                //message guaranteed to be there due to the zmq::send_flags::sndmore
-                if (!sockets[itemIndex]->recv(zmqMessageBundle, zmq::recv_flags::none)) {
-                    std::cerr << "error on sockets[itemIndex]->recv\n";
+
+                if ((toEgressHeader.base.flags & HDTN_FLAG_BUNDLE_IN_SHARED_MEMORY) && (!sharedMemoryBundleArenaReaders[itemIndex].ReplaceDescriptorWithBundle(zmqMessageBundle))) {
+                    std::cerr << "error in HegrManagerAsync::ReadZmqThreadFunc: invalid shared memory bundle descriptor" << std::endl;
+                    hdtn::Logger::getInstance()->logError("egress", "Error in HegrManagerAsync::ReadZmqThreadFunc: invalid shared memory bundle descriptor");
                     continue;
                 }
                        
@@ -330,23 +562,17 @@ void hdtn::HegrManagerAsync::ReadZmqThreadFunc() {
 
                 const cbhe_eid_t & finalDestEid = toEgressHeader.finalDestEid;
                 if ((itemIndex == 1) && availableDestOpportunisticNodeIdsSet.count(finalDestEid.nodeId)) { //from storage and opportunistic link available in ingress
-                    hdtn::EgressAckHdr * egressAckPtr = new hdtn::EgressAckHdr();
+                    //storage can be acked right away since bundle transferred (sent with the next batch of acks to storage)
+                    egressAcksToStorageVec.resize(egressAcksToStorageVec.size() + 1);
+                    hdtn::EgressAckHdr & egressAck = egressAcksToStorageVec.back();
                     //memset 0 not needed because all values set below
-                    egressAckPtr->base.type = HDTN_MSGTYPE_EGRESS_ACK_TO_STORAGE;
-                    egressAckPtr->base.flags = 0;
-                    egressAckPtr->finalDestEid = finalDestEid;
-                    egressAckPtr->error = 0; //can set later before sending this ack if error
-                    egressAckPtr->deleteNow = !toEgressHeader.hasCustody;
-                    egressAckPtr->isToStorage = 1;
-                    egressAckPtr->custodyId = toEgressHeader.custodyId;
-
-                    zmq::message_t messageWithDataStolen(egressAckPtr, sizeof(hdtn::EgressAckHdr), CustomCleanupEgressAckHdrNoHint); //storage can be acked right away since bundle transferred
-                    if (!m_zmqPushSock_boundEgressToConnectingStoragePtr->send(std::move(messageWithDataStolen), zmq::send_flags::dontwait)) {
-                        std::cout << "error: m_zmqPushSock_boundEgressToConnectingStoragePtr could not send" << std::endl;
-                        hdtn::Logger::getInstance()->logError("egress", "Error: m_zmqPushSock_boundEgressToConnectingStoragePtr could not send");
-                        break;
-                    }
-                    ++totalCustodyTransfersSentToStorage;
+                    egressAck.base.type = HDTN_MSGTYPE_EGRESS_ACK_TO_STORAGE;
+                    egressAck.base.flags = 0;
+                    egressAck.finalDestEid = finalDestEid;
+                    egressAck.error = 0;
+                    egressAck.deleteNow = !toEgressHeader.hasCustody;
+                    egressAck.isToStorage = 1;
+                    egressAck.custodyId = toEgressHeader.custodyId;
 
                     boost::mutex::scoped_lock lock(m_mutexPushBundleToIngress);
                     static const char messageFlags = 0; //0 => from storage and needs no processing
@@ -358,97 +584,99 @@ void hdtn::HegrManagerAsync::ReadZmqThreadFunc() {
                         std::cout << "error in egress WholeBundleReadyCallback: zmq could not forward bundle to ingress" << std::endl;
                     }
                 }
-                else if (Outduct * outduct = m_outductManager.GetOutductByFinalDestinationEid_ThreadSafe(finalDestEid)) {
-                    std::unique_ptr<hdtn::EgressAckHdr> egressAckPtr = boost::make_unique<hdtn::EgressAckHdr>();
+                else if (Outduct * outduct = m_outductManager.GetOutductByFinalDestinationEid_ThreadSafe(routeTableSnapshot, routeTableGeneration, finalDestEid)) {
+                    queue_t & needAcksQueue = outductUuidToNeedAcksQueueVec[outduct->GetOutductUuid()];
+                    hdtn::EgressAckHdr scheduledEgressAck;
+                    if (!m_schedulerPtr) {
+                        //queued before the forward so that it is already there when the outduct reports the ack (from any thread)
+                        needAcksQueue.emplace();
+                    }
+                    hdtn::EgressAckHdr & egressAck = (m_schedulerPtr) ? scheduledEgressAck : needAcksQueue.back();
                     //memset 0 not needed because all values set below
-                    egressAckPtr->base.type = (toEgressHeader.isCutThroughFromIngress) ? HDTN_MSGTYPE_EGRESS_ACK_TO_INGRESS : HDTN_MSGTYPE_EGRESS_ACK_TO_STORAGE;
-                    egressAckPtr->base.flags = 0;
-                    egressAckPtr->finalDestEid = finalDestEid;
-
-                    egressAckPtr->error = 0; //can set later before sending this ack if error
-                    egressAckPtr->deleteNow = !toEgressHeader.hasCustody;
-                    egressAckPtr->isToStorage = !toEgressHeader.isCutThroughFromIngress;
-                    egressAckPtr->custodyId = toEgressHeader.custodyId;
+                    egressAck.base.type = (toEgressHeader.isCutThroughFromIngress) ? HDTN_MSGTYPE_EGRESS_ACK_TO_INGRESS : HDTN_MSGTYPE_EGRESS_ACK_TO_STORAGE;
+                    egressAck.base.flags = 0;
+                    egressAck.finalDestEid = finalDestEid;
+
+                    egressAck.error = 0; //can set later before sending this ack if error
+                    egressAck.deleteNow = !toEgressHeader.hasCustody;
+                    egressAck.isToStorage = !toEgressHeader.isCutThroughFromIngress;
+                    egressAck.custodyId = toEgressHeader.custodyId;
                     //std::cout << "*****Egress Outduct: " << static_cast<int>(outduct->GetOutductUuid()) << std::endl;
-                    outductUuidToNeedAcksQueueMap[outduct->GetOutductUuid()].push(std::move(egressAckPtr));
-                    outduct->Forward(zmqMessageBundle);
-                    if (zmqMessageBundle.size() != 0) {
-                        std::cout << "Error in hdtn::HegrManagerAsync::ProcessZmqMessagesThreadFunc, zmqMessage was not moved" << std::endl;
-                        hdtn::Logger::getInstance()->logError("egress", "Error in hdtn::HegrManagerAsync::ProcessZmqMessagesThreadFunc, zmqMessage was not moved");
+                    if (m_schedulerPtr) {
+                        //the ack is queued when the scheduler releases the bundle to the outduct
+                        m_schedulerPtr->Push(outduct->GetOutductUuid(), toEgressHeader.priorityIndex, egressAck, zmqMessageBundle);
+                        ForwardScheduledBundles(outduct, needAcksQueue);
+                    }
+                    else {
+                        ForwardBundle(outduct, zmqMessageBundle);
                     }
                 }
                 else {
                     std::cerr << "critical error in HegrManagerAsync::ProcessZmqMessagesThreadFunc: no outduct for " 
                         << Uri::GetIpnUriString(finalDestEid.nodeId, finalDestEid.serviceId) << std::endl;
                 }
-
-            }
-            if (items[NUM_SOCKETS - 2].revents & ZMQ_POLLIN) { //events from Router
-                std::cout << "[Egress] Received RouteUpdate event!!" << std::endl;
-                RouterEventHandler();
-            }
-
-            if ((items[NUM_SOCKETS - 1].revents & ZMQ_POLLIN)) { //m_zmqPullSignalInprocSockPtr                
-                const zmq::recv_buffer_result_t res = m_zmqPullSignalInprocSockPtr->recv(signalRxBufferJunk, zmq::recv_flags::none);
-                if (!res) {
-                    std::cerr << "error in HegrManagerAsync::ReadZmqThreadFunc: signal not received" << std::endl;
-                }
-                else if ((res->truncated()) || (res->size != sizeof(junkChar))) {
-                    std::cerr << "error in HegrManagerAsync::ReadZmqThreadFunc: signal message mismatch: untruncated = " << res->untruncated_size
-                        << " truncated = " << res->size << " expected = " << sizeof(junkChar) << std::endl;
-                }
-                else {
-                    ++totalEgressInprocSignalsReceived;
-                }
-                m_needToSendSignal = true;
-                
             }
+            bundleReceiversHadBacklog = bundleReceiversHadBacklog || bundleReceiver.HasUnpolledBacklog();
         }
         //Check for tcpcl acks from a bpsink-like program.
         //When acked, send an ack to storage containing the head segment id so that the bundle can be deleted from storage.
         //We will assume that when the bpsink acks the packet through tcpcl that this will be custody transfer of the bundle
         // and that storage is no longer responsible for it.  Tcpcl must be acked sequentially but storage doesn't care the
         // order of the acks.
-        for (outductuuid_needacksqueue_map_t::iterator it = outductUuidToNeedAcksQueueMap.begin(); it != outductUuidToNeedAcksQueueMap.end(); ++it) {
-            const uint64_t outductUuid = it->first;
+        //Only the outducts that reported acks (through OnSuccessfulBundleAck) since the last iteration are visited.
+        uint32_t outductUuid;
+        while (m_outductsWithAcksQueuePtr->Pop(outductUuid)) {
             //const unsigned int fec = 1; //TODO
-            queue_t & q = it->second;
+            queue_t & q = outductUuidToNeedAcksQueueVec[outductUuid];
+            if (q.empty() && ((!m_schedulerPtr) || (!m_schedulerPtr->HasQueuedBundles(outductUuid)))) {
+                continue;
+            }
             if (Outduct * outduct = m_outductManager.GetOutductByOutductUuid(outductUuid)) {
-                const std::size_t numAckedRemaining = outduct->GetTotalDataSegmentsUnacked();
+                //read before the unacked count: a worker increments the outduct's unacked count before decrementing this,
+                //so in between a bundle is counted twice (never zero times) and can't be acked early
+                const std::size_t numWaitingForWorker = (m_workers.empty()) ? 0 :
+                    static_cast<std::size_t>(m_outductBundlesWaitingForWorkerArray[outductUuid].load(boost::memory_order_seq_cst));
+                const std::size_t numAckedRemaining = outduct->GetTotalDataSegmentsUnacked() + numWaitingForWorker;
                 while (q.size() > numAckedRemaining) {
-                    std::unique_ptr<hdtn::EgressAckHdr> & qItem = q.front();
-                    const bool isToStorage = qItem->isToStorage;
-                    //this is an optimization because we only have one chunk to send
-                    //The zmq_msg_init_data() function shall initialise the message object referenced by msg
-                    //to represent the content referenced by the buffer located at address data, size bytes long.
-                    //No copy of data shall be performed and 0MQ shall take ownership of the supplied buffer.
-                    //If provided, the deallocation function ffn shall be called once the data buffer is no longer
-                    //required by 0MQ, with the data and hint arguments supplied to zmq_msg_init_data().
-                    zmq::message_t messageWithDataStolen(qItem.release(), sizeof(hdtn::EgressAckHdr), CustomCleanupEgressAckHdrNoHint); //unique_ptr goes "null" with release()
-                    if (isToStorage) {
-                        if (!m_zmqPushSock_boundEgressToConnectingStoragePtr->send(std::move(messageWithDataStolen), zmq::send_flags::dontwait)) {
-                            std::cout << "error: m_zmqPushSock_boundEgressToConnectingStoragePtr could not send" << std::endl;
-                            hdtn::Logger::getInstance()->logError("egress", "Error: m_zmqPushSock_boundEgressToConnectingStoragePtr could not send");
-                            break;
+                    const hdtn::EgressAckHdr & qItem = q.front();
+                    if (qItem.isToStorage) {
+                        //acks to storage are batched into one message of consecutive EgressAckHdr
+                        egressAcksToStorageVec.push_back(qItem);
+                        if (egressAcksToStorageVec.size() >= MAX_ACKS_PER_MESSAGE_TO_STORAGE) {
+                            const std::size_t numAcks = egressAcksToStorageVec.size();
+                            if (SendAckBatchToStorage(egressAcksToStorageVec)) {
+                                totalCustodyTransfersSentToStorage += numAcks;
+                                ++totalAckMessagesSentToStorage;
+                            }
                         }
-                        ++totalCustodyTransfersSentToStorage;
                     }
                     else {
-                        //send ack message by echoing back the block
-                        if (!m_zmqPushSock_connectingEgressToBoundIngressPtr->send(std::move(messageWithDataStolen), zmq::send_flags::dontwait)) {
-                            std::cout << "error: zmq could not send ingress an ack from egress" << std::endl;
-                            hdtn::Logger::getInstance()->logError("egress", "Error: zmq could not send ingress an ack from egress");
-                            break;
+                        //acks to ingress are batched and sent after all the outducts have been checked
+                        ingressAckBatcher.Append(qItem.finalDestEid, qItem.custodyId);
+                        if (ingressAckBatcher.IsFull()) {
+                            SendAckBatchToIngress(ingressAckBatcher);
                         }
                         ++totalCustodyTransfersSentToIngress;
                     }
                     q.pop();
                 }
+                if (m_schedulerPtr) {
+                    //the acks made room in the outduct's pipeline
+                    ForwardScheduledBundles(outduct, q);
+                }
             }
             else {
                 std::cerr << "critical error in HegrManagerAsync::ProcessZmqMessagesThreadFunc: cannot find outductUuid " << outductUuid << std::endl;
             }
         }
+        {
+            const std::size_t numAcks = egressAcksToStorageVec.size();
+            if (numAcks && SendAckBatchToStorage(egressAcksToStorageVec)) {
+                totalCustodyTransfersSentToStorage += numAcks;
+                ++totalAckMessagesSentToStorage;
+            }
+        }
+        SendAckBatchToIngress(ingressAckBatcher);
     }
 
     std::cout << "HegrManagerAsync::ReadZmqThreadFunc thread exiting\n";
@@ -456,21 +684,41 @@ void hdtn::HegrManagerAsync::ReadZmqThreadFunc() {
     const std::string msgToStorage = "totalCustodyTransfersSentToStorage: " + boost::lexical_cast<std::string>(totalCustodyTransfersSentToStorage);
     std::cout << msgToStorage << std::endl;
     hdtn::Logger::getInstance()->logInfo("egress", msgToStorage);
+    const std::string msgAckBatchesToStorage = "totalAckMessagesSentToStorage: " + boost::lexical_cast<std::string>(totalAckMessagesSentToStorage);
+    std::cout << msgAckBatchesToStorage << std::endl;
+    hdtn::Logger::getInstance()->logInfo("egress", msgAckBatchesToStorage);
     const std::string msgToIngress = "totalCustodyTransfersSentToIngress: " + boost::lexical_cast<std::string>(totalCustodyTransfersSentToIngress);
     std::cout << msgToIngress << std::endl;
     hdtn::Logger::getInstance()->logInfo("egress", msgToIngress);
+    const std::string msgAckBatches = "totalAckMessagesSentToIngress: " + boost::lexical_cast<std::string>(ingressAckBatcher.m_totalMessagesSent)
+        + " (" + boost::lexical_cast<std::string>(ingressAckBatcher.GetAverageAcksPerMessage()) + " acks per message)";
+    std::cout << msgAckBatches << std::endl;
+    hdtn::Logger::getInstance()->logInfo("egress", msgAckBatches);
     const std::string msgInprocRx = "totalEgressInprocSignalsReceived: " + boost::lexical_cast<std::string>(totalEgressInprocSignalsReceived);
     std::cout << msgInprocRx << std::endl;
     hdtn::Logger::getInstance()->logInfo("egress", msgInprocRx);
     const std::string msgInprocTx = "m_totalEgressInprocSignalsSent: " + boost::lexical_cast<std::string>(m_totalEgressInprocSignalsSent);
     std::cout << msgInprocTx << std::endl;
     hdtn::Logger::getInstance()->logInfo("egress", msgInprocTx);
+    if (m_schedulerPtr) {
+        static const char * const PRIORITY_NAMES[EGRESS_SCHEDULER_NUMBER_OF_PRIORITIES] = { "bulk", "normal", "expedited" };
+        EgressSchedulerTelemetry schedulerTelem;
+        m_schedulerPtr->GetTelemetry(schedulerTelem);
+        for (unsigned int i = 0; i < EGRESS_SCHEDULER_NUMBER_OF_PRIORITIES; ++i) {
+            const std::string msgScheduler = std::string("egress scheduler ") + PRIORITY_NAMES[i]
+                + ": totalBundlesScheduled=" + boost::lexical_cast<std::string>(schedulerTelem.totalBundlesScheduled[i])
+                + " maxQueuedBundles=" + boost::lexical_cast<std::string>(schedulerTelem.maxQueuedBundles[i])
+                + " queuedBundlesAtExit=" + boost::lexical_cast<std::string>(schedulerTelem.queuedBundles[i]);
+            std::cout << msgScheduler << std::endl;
+            hdtn::Logger::getInstance()->logInfo("egress", msgScheduler);
+        }
+    }
     //
 }
 
 static void CustomCleanupPaddedVecUint8(void *data, void *hint) {
     //std::cout << "free " << static_cast<std::vector<uint8_t>*>(hint)->size() << std::endl;
-    delete static_cast<padded_vector_uint8_t*>(hint);
+    BundleBufferPool::Delete(static_cast<padded_vector_uint8_t*>(hint));
 }
 
 //from egress bidirectional tcpcl outduct receive path and opportunistic link potentially available in ingress (otherwise ingress will give it to storage if unavailable)
@@ -484,7 +732,7 @@ void hdtn::HegrManagerAsync::WholeBundleReadyCallback(padded_vector_uint8_t & wh
     //required by 0MQ, with the data and hint arguments supplied to zmq_msg_init_data().
     static const char messageFlags = 1; //1 => from egress and needs processing
     static const zmq::const_buffer messageFlagsConstBuf(&messageFlags, sizeof(messageFlags));
-    padded_vector_uint8_t * rxBufRawPointer = new padded_vector_uint8_t(std::move(wholeBundleVec));
+    padded_vector_uint8_t * rxBufRawPointer = BundleBufferPool::New<padded_vector_uint8_t>(std::move(wholeBundleVec));
     zmq::message_t paddedMessageWithDataStolen(rxBufRawPointer->data() - rxBufRawPointer->get_allocator().PADDING_ELEMENTS_BEFORE,
         rxBufRawPointer->size() + rxBufRawPointer->get_allocator().TOTAL_PADDING_ELEMENTS, CustomCleanupPaddedVecUint8, rxBufRawPointer);
     boost::mutex::scoped_lock lock(m_mutexPushBundleToIngress);
@@ -0,0 +1,138 @@
+#include "EgressScheduler.h"
+#include <algorithm>
+#include <tuple>
+
+static constexpr uint8_t EXPEDITED_PRIORITY_INDEX = EGRESS_SCHEDULER_NUMBER_OF_PRIORITIES - 1;
+
+EgressScheduler::EgressScheduler(const std::size_t numOutducts, const uint64_t quantumBytes, const uint64_t bulkWeight, const uint64_t normalWeight) :
+    m_outductQueuesVec(numOutducts),
+    m_numQueuedBundles(0)
+{
+    //a quantum of at least one byte guarantees every flow eventually accumulates enough deficit for its head bundle
+    const uint64_t quantum = std::max<uint64_t>(quantumBytes, 1);
+    m_quantumBytesPerPriority[0] = quantum * std::max<uint64_t>(bulkWeight, 1);
+    m_quantumBytesPerPriority[1] = quantum * std::max<uint64_t>(normalWeight, 1);
+    m_quantumBytesPerPriority[EXPEDITED_PRIORITY_INDEX] = quantum;
+    for (unsigned int i = 0; i < EGRESS_SCHEDULER_NUMBER_OF_PRIORITIES; ++i) {
+        m_queuedBundles[i] = 0;
+        m_queuedBytes[i] = 0;
+        m_maxQueuedBundles[i] = 0;
+        m_totalBundlesScheduled[i] = 0;
+    }
+}
+
+EgressScheduler::~EgressScheduler() {}
+
+void EgressScheduler::Push(const uint64_t outductUuid, const uint8_t priorityIndex, const hdtn::EgressAckHdr & egressAck, zmq::message_t & movableZmqMessageBundle) {
+    const uint8_t priority = std::min(priorityIndex, EXPEDITED_PRIORITY_INDEX);
+    outduct_queues_t & outductQueues = m_outductQueuesVec[outductUuid];
+    std::pair<flows_map_t::iterator, bool> ret = outductQueues.flowsMap.emplace(std::piecewise_construct,
+        std::forward_as_tuple(priority, egressAck.finalDestEid), std::forward_as_tuple());
+    flow_t & flow = ret.first->second;
+    if (ret.second) { //only active flows are kept, so a new entry is a newly active flow
+        flow.quantumBytes = m_quantumBytesPerPriority[priority];
+        flow.priorityIndex = priority;
+        //a newly active flow joins at the tail of the current round with no deficit carried over
+        ((priority == EXPEDITED_PRIORITY_INDEX) ? outductQueues.activeExpeditedFlowsList : outductQueues.activeWeightedFlowsList).push_back(&flow);
+    }
+    const uint64_t bundleSizeBytes = movableZmqMessageBundle.size();
+    flow.bundleQueue.emplace(egressAck, std::move(movableZmqMessageBundle));
+    ++outductQueues.numQueuedBundles;
+    ++m_numQueuedBundles;
+
+    const uint64_t queuedBundles = m_queuedBundles[priority].fetch_add(1, boost::memory_order_relaxed) + 1;
+    m_queuedBytes[priority].fetch_add(bundleSizeBytes, boost::memory_order_relaxed);
+    if (queuedBundles > m_maxQueuedBundles[priority].load(boost::memory_order_relaxed)) {
+        m_maxQueuedBundles[priority].store(queuedBundles, boost::memory_order_relaxed);
+    }
+}
+
+//one classic deficit round robin visit of every active flow: a flow gets its quantum once per visit and is returned
+//if its head bundle fits in its deficit, else it keeps the deficit and moves to the tail (NULL if no head bundle fits)
+EgressScheduler::flow_t * EgressScheduler::VisitEachFlowOnce(active_flows_list_t & activeFlowsList) {
+    for (std::size_t numVisited = activeFlowsList.size(); numVisited; --numVisited) {
+        flow_t & flow = *activeFlowsList.front();
+        if (!flow.quantumAddedThisRound) {
+            flow.deficitBytes += flow.quantumBytes;
+            flow.quantumAddedThisRound = true;
+        }
+        if (flow.bundleQueue.front().zmqMessageBundle.size() <= flow.deficitBytes) {
+            return &flow;
+        }
+        flow.quantumAddedThisRound = false;
+        activeFlowsList.splice(activeFlowsList.end(), activeFlowsList, activeFlowsList.begin());
+    }
+    return NULL;
+}
+
+//Selects the same flow as classic deficit round robin, but when no head bundle fits after one visit of every flow, the
+//rounds that would only add quanta are skipped: every flow is credited at once with the quanta of the rounds the flow
+//closest to sending still needs, less one, and the next visit then finds it (so the cost no longer grows with bundle size / quantum).
+EgressScheduler::flow_t & EgressScheduler::DeficitRoundRobinNext(active_flows_list_t & activeFlowsList) {
+    if (flow_t * flowPtr = VisitEachFlowOnce(activeFlowsList)) {
+        return *flowPtr;
+    }
+    uint64_t minRoundsNeeded = UINT64_MAX;
+    for (active_flows_list_t::const_iterator it = activeFlowsList.cbegin(); it != activeFlowsList.cend(); ++it) {
+        const flow_t & flow = **it;
+        const uint64_t bytesNeeded = flow.bundleQueue.front().zmqMessageBundle.size() - flow.deficitBytes; //nonzero (head did not fit)
+        minRoundsNeeded = std::min(minRoundsNeeded, (bytesNeeded + (flow.quantumBytes - 1)) / flow.quantumBytes);
+    }
+    const uint64_t roundsToSkip = minRoundsNeeded - 1;
+    if (roundsToSkip) {
+        for (active_flows_list_t::iterator it = activeFlowsList.begin(); it != activeFlowsList.end(); ++it) {
+            (*it)->deficitBytes += roundsToSkip * (*it)->quantumBytes;
+        }
+    }
+    return *VisitEachFlowOnce(activeFlowsList); //not NULL: the flow needing minRoundsNeeded rounds fits on this visit
+}
+
+bool EgressScheduler::Pop(const uint64_t outductUuid, hdtn::EgressAckHdr & egressAck, zmq::message_t & zmqMessageBundle) {
+    outduct_queues_t & outductQueues = m_outductQueuesVec[outductUuid];
+    active_flows_list_t & activeFlowsList = (outductQueues.activeExpeditedFlowsList.empty()) ?
+        outductQueues.activeWeightedFlowsList : outductQueues.activeExpeditedFlowsList;
+    if (activeFlowsList.empty()) {
+        return false;
+    }
+    flow_t & flow = DeficitRoundRobinNext(activeFlowsList);
+    scheduled_bundle_t & scheduledBundle = flow.bundleQueue.front();
+    const uint64_t bundleSizeBytes = scheduledBundle.zmqMessageBundle.size();
+    flow.deficitBytes -= bundleSizeBytes;
+    egressAck = scheduledBundle.egressAck;
+    zmqMessageBundle = std::move(scheduledBundle.zmqMessageBundle);
+    flow.bundleQueue.pop();
+    const uint8_t priorityIndex = flow.priorityIndex;
+    if (flow.bundleQueue.empty()) {
+        //an idle flow keeps no deficit, so it is erased rather than kept for destinations that may never return
+        activeFlowsList.pop_front();
+        outductQueues.flowsMap.erase(std::pair<uint8_t, cbhe_eid_t>(priorityIndex, egressAck.finalDestEid));
+    }
+    --outductQueues.numQueuedBundles;
+    --m_numQueuedBundles;
+
+    m_queuedBundles[priorityIndex].fetch_sub(1, boost::memory_order_relaxed);
+    m_queuedBytes[priorityIndex].fetch_sub(bundleSizeBytes, boost::memory_order_relaxed);
+    m_totalBundlesScheduled[priorityIndex].fetch_add(1, boost::memory_order_relaxed);
+    return true;
+}
+
+bool EgressScheduler::HasQueuedBundles(const uint64_t outductUuid) const {
+    return (m_outductQueuesVec[outductUuid].numQueuedBundles != 0);
+}
+
+std::size_t EgressScheduler::GetNumQueuedBundles() const {
+    return m_numQueuedBundles;
+}
+
+std::size_t EgressScheduler::GetNumActiveFlows(const uint64_t outductUuid) const {
+    return m_outductQueuesVec[outductUuid].flowsMap.size();
+}
+
+void EgressScheduler::GetTelemetry(EgressSchedulerTelemetry & telem) const {
+    for (unsigned int i = 0; i < EGRESS_SCHEDULER_NUMBER_OF_PRIORITIES; ++i) {
+        telem.queuedBundles[i] = m_queuedBundles[i].load(boost::memory_order_relaxed);
+        telem.queuedBytes[i] = m_queuedBytes[i].load(boost::memory_order_relaxed);
+        telem.maxQueuedBundles[i] = m_maxQueuedBundles[i].load(boost::memory_order_relaxed);
+        telem.totalBundlesScheduled[i] = m_totalBundlesScheduled[i].load(boost::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,195 @@
+#include <boost/test/unit_test.hpp>
+#include "EgressScheduler.h"
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/uniform_int_distribution.hpp>
+#include <deque>
+#include <iostream>
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+static void PushBundle(EgressScheduler & scheduler, const uint64_t outductUuid, const uint8_t priorityIndex,
+    const cbhe_eid_t & finalDestEid, const uint64_t custodyId, const std::size_t bundleSizeBytes)
+{
+    hdtn::EgressAckHdr egressAck;
+    memset(&egressAck, 0, sizeof(egressAck));
+    egressAck.finalDestEid = finalDestEid;
+    egressAck.custodyId = custodyId;
+    zmq::message_t zmqMessageBundle(bundleSizeBytes);
+    scheduler.Push(outductUuid, priorityIndex, egressAck, zmqMessageBundle);
+    BOOST_REQUIRE_EQUAL(zmqMessageBundle.size(), 0); //moved
+}
+
+BOOST_AUTO_TEST_CASE(EgressSchedulerTestCase)
+{
+    static constexpr uint64_t QUANTUM_BYTES = 1000;
+    static constexpr uint64_t BULK_WEIGHT = 1;
+    static constexpr uint64_t NORMAL_WEIGHT = 2;
+    EgressScheduler scheduler(2, QUANTUM_BYTES, BULK_WEIGHT, NORMAL_WEIGHT);
+    const cbhe_eid_t destA(2, 1);
+    const cbhe_eid_t destB(3, 1);
+    const cbhe_eid_t destC(4, 1);
+
+    BOOST_REQUIRE(!scheduler.HasQueuedBundles(0));
+    hdtn::EgressAckHdr egressAck;
+    zmq::message_t zmqMessageBundle;
+    BOOST_REQUIRE(!scheduler.Pop(0, egressAck, zmqMessageBundle));
+
+    //custody ids 1..3 bulk to A, 11..14 normal to B, then 21 expedited to C (bigger than its quantum)
+    for (uint64_t i = 1; i <= 3; ++i) {
+        PushBundle(scheduler, 0, 0, destA, i, 1000);
+    }
+    for (uint64_t i = 11; i <= 14; ++i) {
+        PushBundle(scheduler, 0, 1, destB, i, 1000);
+    }
+    PushBundle(scheduler, 0, 2, destC, 21, 5000);
+    BOOST_REQUIRE(scheduler.HasQueuedBundles(0));
+    BOOST_REQUIRE(!scheduler.HasQueuedBundles(1));
+    BOOST_REQUIRE_EQUAL(scheduler.GetNumQueuedBundles(), 8);
+
+    EgressSchedulerTelemetry telem;
+    scheduler.GetTelemetry(telem);
+    BOOST_REQUIRE_EQUAL(telem.queuedBundles[0], 3);
+    BOOST_REQUIRE_EQUAL(telem.queuedBundles[1], 4);
+    BOOST_REQUIRE_EQUAL(telem.queuedBundles[2], 1);
+    BOOST_REQUIRE_EQUAL(telem.queuedBytes[0], 3000);
+    BOOST_REQUIRE_EQUAL(telem.queuedBytes[2], 5000);
+    BOOST_REQUIRE_EQUAL(telem.maxQueuedBundles[1], 4);
+
+    //expedited first (strict priority), then normal gets two quanta per round for each one of bulk
+    const std::vector<uint64_t> expectedCustodyIds = { 21, 1, 11, 12, 2, 13, 14, 3 };
+    for (std::size_t i = 0; i < expectedCustodyIds.size(); ++i) {
+        BOOST_REQUIRE(scheduler.Pop(0, egressAck, zmqMessageBundle));
+        BOOST_REQUIRE_EQUAL(egressAck.custodyId, expectedCustodyIds[i]);
+        BOOST_REQUIRE_EQUAL(zmqMessageBundle.size(), (expectedCustodyIds[i] == 21) ? 5000 : 1000);
+    }
+    BOOST_REQUIRE(!scheduler.Pop(0, egressAck, zmqMessageBundle));
+    BOOST_REQUIRE(!scheduler.HasQueuedBundles(0));
+    BOOST_REQUIRE_EQUAL(scheduler.GetNumQueuedBundles(), 0);
+
+    scheduler.GetTelemetry(telem);
+    for (unsigned int i = 0; i < EGRESS_SCHEDULER_NUMBER_OF_PRIORITIES; ++i) {
+        BOOST_REQUIRE_EQUAL(telem.queuedBundles[i], 0);
+        BOOST_REQUIRE_EQUAL(telem.queuedBytes[i], 0);
+    }
+    BOOST_REQUIRE_EQUAL(telem.totalBundlesScheduled[0], 3);
+    BOOST_REQUIRE_EQUAL(telem.totalBundlesScheduled[1], 4);
+    BOOST_REQUIRE_EQUAL(telem.totalBundlesScheduled[2], 1);
+    BOOST_REQUIRE_EQUAL(telem.maxQueuedBundles[0], 3); //high water mark kept
+
+    //an expedited bundle arriving behind queued bulk traffic goes next, and the outducts are independent
+    PushBundle(scheduler, 1, 0, destA, 31, 100);
+    PushBundle(scheduler, 1, 0, destA, 32, 100);
+    PushBundle(scheduler, 0, 0, destA, 41, 100);
+    BOOST_REQUIRE(scheduler.Pop(1, egressAck, zmqMessageBundle));
+    BOOST_REQUIRE_EQUAL(egressAck.custodyId, 31);
+    PushBundle(scheduler, 1, 3, destB, 33, 100); //out of range priority treated as expedited
+    BOOST_REQUIRE(scheduler.Pop(1, egressAck, zmqMessageBundle));
+    BOOST_REQUIRE_EQUAL(egressAck.custodyId, 33);
+    BOOST_REQUIRE(scheduler.Pop(1, egressAck, zmqMessageBundle));
+    BOOST_REQUIRE_EQUAL(egressAck.custodyId, 32);
+    BOOST_REQUIRE(!scheduler.HasQueuedBundles(1));
+    BOOST_REQUIRE(scheduler.Pop(0, egressAck, zmqMessageBundle));
+    BOOST_REQUIRE_EQUAL(egressAck.custodyId, 41);
+}
+
+//reference: classic deficit round robin of one class of flows, rotating the list once per visit
+struct ReferenceDrrFlow {
+    ReferenceDrrFlow() : deficitBytes(0), quantumBytes(0), quantumAddedThisRound(false) {}
+    std::deque<std::pair<uint64_t, std::size_t> > bundles; //custody id, size
+    uint64_t deficitBytes;
+    uint64_t quantumBytes;
+    bool quantumAddedThisRound;
+};
+static uint64_t ReferenceDrrPop(std::map<cbhe_eid_t, ReferenceDrrFlow> & flowsMap, std::list<cbhe_eid_t> & activeList) {
+    while (true) {
+        ReferenceDrrFlow & flow = flowsMap[activeList.front()];
+        if (!flow.quantumAddedThisRound) {
+            flow.deficitBytes += flow.quantumBytes;
+            flow.quantumAddedThisRound = true;
+        }
+        if (flow.bundles.front().second <= flow.deficitBytes) {
+            const uint64_t custodyId = flow.bundles.front().first;
+            flow.deficitBytes -= flow.bundles.front().second;
+            flow.bundles.pop_front();
+            if (flow.bundles.empty()) {
+                flowsMap.erase(activeList.front());
+                activeList.pop_front();
+            }
+            return custodyId;
+        }
+        flow.quantumAddedThisRound = false;
+        activeList.splice(activeList.end(), activeList, activeList.begin());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(EgressSchedulerSkipsQuantumOnlyRoundsTestCase)
+{
+    static constexpr uint64_t QUANTUM_BYTES = 100;
+    static constexpr uint64_t NORMAL_WEIGHT = 3;
+    boost::random::mt19937 gen(1234);
+    boost::random::uniform_int_distribution<std::size_t> sizeDist(1, 5000);
+    boost::random::uniform_int_distribution<unsigned int> destDist(1, 6);
+    boost::random::uniform_int_distribution<unsigned int> priorityDist(0, 1);
+    boost::random::uniform_int_distribution<unsigned int> actionDist(0, 2);
+
+    //random pushes and pops (flows going idle and returning) must give the same order as the reference
+    EgressScheduler scheduler(1, QUANTUM_BYTES, 1, NORMAL_WEIGHT);
+    std::map<cbhe_eid_t, ReferenceDrrFlow> referenceFlowsMap; //serviceId holds the priority
+    std::list<cbhe_eid_t> referenceActiveList;
+    hdtn::EgressAckHdr egressAck;
+    zmq::message_t zmqMessageBundle;
+    uint64_t nextCustodyId = 1;
+    std::size_t numPopped = 0;
+    for (unsigned int i = 0; i < 20000; ++i) {
+        if ((actionDist(gen) != 0) || referenceActiveList.empty()) {
+            const unsigned int priority = priorityDist(gen);
+            const cbhe_eid_t finalDestEid(destDist(gen), 1);
+            const std::size_t bundleSizeBytes = sizeDist(gen);
+            const cbhe_eid_t referenceKey(finalDestEid.nodeId, priority);
+            std::map<cbhe_eid_t, ReferenceDrrFlow>::iterator it = referenceFlowsMap.find(referenceKey);
+            if (it == referenceFlowsMap.end()) {
+                it = referenceFlowsMap.insert(std::make_pair(referenceKey, ReferenceDrrFlow())).first;
+                it->second.quantumBytes = QUANTUM_BYTES * ((priority) ? NORMAL_WEIGHT : 1);
+                referenceActiveList.push_back(referenceKey);
+            }
+            it->second.bundles.push_back(std::make_pair(nextCustodyId, bundleSizeBytes));
+            PushBundle(scheduler, 0, static_cast<uint8_t>(priority), finalDestEid, nextCustodyId++, bundleSizeBytes);
+        }
+        else {
+            BOOST_REQUIRE(scheduler.Pop(0, egressAck, zmqMessageBundle));
+            BOOST_REQUIRE_EQUAL(egressAck.custodyId, ReferenceDrrPop(referenceFlowsMap, referenceActiveList));
+            ++numPopped;
+        }
+        BOOST_REQUIRE_EQUAL(scheduler.GetNumActiveFlows(0), referenceFlowsMap.size());
+    }
+    while (!referenceActiveList.empty()) {
+        BOOST_REQUIRE(scheduler.Pop(0, egressAck, zmqMessageBundle));
+        BOOST_REQUIRE_EQUAL(egressAck.custodyId, ReferenceDrrPop(referenceFlowsMap, referenceActiveList));
+        ++numPopped;
+    }
+    BOOST_REQUIRE(!scheduler.Pop(0, egressAck, zmqMessageBundle));
+    BOOST_REQUIRE_EQUAL(numPopped, nextCustodyId - 1);
+    BOOST_REQUIRE_EQUAL(scheduler.GetNumActiveFlows(0), 0); //idle flows are erased
+
+    //bundles much bigger than the quantum (millions of quantum-only rounds for the reference)
+    EgressScheduler tinyQuantumScheduler(1, 1, 1, 1);
+    const std::size_t bigBundleSizes[4] = { 3000000, 1000000, 1000000, 1000001 };
+    const cbhe_eid_t bigBundleDests[4] = { cbhe_eid_t(2, 1), cbhe_eid_t(3, 1), cbhe_eid_t(3, 1), cbhe_eid_t(3, 1) };
+    for (uint64_t custodyId = 1; custodyId <= 4; ++custodyId) {
+        const cbhe_eid_t referenceKey(bigBundleDests[custodyId - 1].nodeId, 0);
+        if (referenceFlowsMap.find(referenceKey) == referenceFlowsMap.end()) {
+            referenceFlowsMap[referenceKey].quantumBytes = 1;
+            referenceActiveList.push_back(referenceKey);
+        }
+        referenceFlowsMap[referenceKey].bundles.push_back(std::make_pair(custodyId, bigBundleSizes[custodyId - 1]));
+        PushBundle(tinyQuantumScheduler, 0, 0, bigBundleDests[custodyId - 1], custodyId, bigBundleSizes[custodyId - 1]);
+    }
+    for (unsigned int i = 0; i < 4; ++i) {
+        BOOST_REQUIRE(tinyQuantumScheduler.Pop(0, egressAck, zmqMessageBundle));
+        BOOST_REQUIRE_EQUAL(egressAck.custodyId, ReferenceDrrPop(referenceFlowsMap, referenceActiveList));
+    }
+    BOOST_REQUIRE(!tinyQuantumScheduler.Pop(0, egressAck, zmqMessageBundle));
+    BOOST_REQUIRE_EQUAL(tinyQuantumScheduler.GetNumActiveFlows(0), 0);
+}
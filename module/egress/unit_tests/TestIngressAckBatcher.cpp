@@ -0,0 +1,101 @@
+#include <boost/test/unit_test.hpp>
+#include "IngressAckBatcher.hpp"
+#include <cstring>
+#include <vector>
+
+static void ReceiveAckBatch(zmq::socket_t & socket, hdtn::IngressAckBatchHdr & hdr, std::vector<hdtn::IngressAckRange> & ranges) {
+    zmq::message_t zmqMessage;
+    BOOST_REQUIRE(socket.recv(zmqMessage, zmq::recv_flags::none));
+    BOOST_REQUIRE_GE(zmqMessage.size(), sizeof(hdr));
+    const uint8_t * const data = static_cast<const uint8_t*>(zmqMessage.data());
+    memcpy(&hdr, data, sizeof(hdr));
+    BOOST_REQUIRE_EQUAL(zmqMessage.size(), sizeof(hdr) + (hdr.numRanges * sizeof(hdtn::IngressAckRange)));
+    ranges.resize(hdr.numRanges);
+    memcpy(ranges.data(), data + sizeof(hdr), hdr.numRanges * sizeof(hdtn::IngressAckRange));
+}
+
+BOOST_AUTO_TEST_CASE(IngressAckBatcherTestCase)
+{
+    zmq::context_t ctx;
+    zmq::socket_t pushSock(ctx, zmq::socket_type::push);
+    pushSock.bind("inproc://ingress_ack_batcher_test");
+    zmq::socket_t pullSock(ctx, zmq::socket_type::pull);
+    pullSock.connect("inproc://ingress_ack_batcher_test");
+
+    const cbhe_eid_t destA(2, 1);
+    const cbhe_eid_t destB(3, 1);
+    hdtn::IngressAckBatcher batcher(HDTN_MSGTYPE_EGRESS_ACK_BATCH_TO_INGRESS, 3);
+    BOOST_REQUIRE(batcher.IsEmpty());
+    BOOST_REQUIRE(batcher.Send(pushSock)); //nothing to send
+    BOOST_REQUIRE_EQUAL(batcher.m_totalMessagesSent, 0);
+
+    batcher.Append(destA, 10);
+    batcher.Append(destA, 11);
+    batcher.Append(destA, 12);
+    batcher.Append(destB, 13); //new range (different destination)
+    batcher.Append(destA, 14); //new range (not consecutive with the last range)
+    BOOST_REQUIRE(batcher.IsFull());
+    BOOST_REQUIRE_EQUAL(batcher.GetNumPendingAcks(), 5);
+    BOOST_REQUIRE(batcher.Send(pushSock));
+    BOOST_REQUIRE(batcher.IsEmpty());
+    BOOST_REQUIRE_EQUAL(batcher.GetNumPendingAcks(), 0);
+    BOOST_REQUIRE_EQUAL(batcher.m_totalAcksSent, 5);
+    BOOST_REQUIRE_EQUAL(batcher.m_totalMessagesSent, 1);
+
+    hdtn::IngressAckBatchHdr hdr;
+    std::vector<hdtn::IngressAckRange> ranges;
+    ReceiveAckBatch(pullSock, hdr, ranges);
+    BOOST_REQUIRE_EQUAL(hdr.base.type, HDTN_MSGTYPE_EGRESS_ACK_BATCH_TO_INGRESS);
+    BOOST_REQUIRE_EQUAL(hdr.numAcks, 5);
+    BOOST_REQUIRE_EQUAL(ranges.size(), 3);
+    BOOST_REQUIRE(ranges[0].finalDestEid == destA);
+    BOOST_REQUIRE_EQUAL(ranges[0].firstId, 10);
+    BOOST_REQUIRE_EQUAL(ranges[0].count, 3);
+    BOOST_REQUIRE(ranges[1].finalDestEid == destB);
+    BOOST_REQUIRE_EQUAL(ranges[1].firstId, 13);
+    BOOST_REQUIRE_EQUAL(ranges[1].count, 1);
+    BOOST_REQUIRE(ranges[2].finalDestEid == destA);
+    BOOST_REQUIRE_EQUAL(ranges[2].firstId, 14);
+    BOOST_REQUIRE_EQUAL(ranges[2].count, 1);
+}
+
+BOOST_AUTO_TEST_CASE(IngressAckBatcherFailedSendTestCase)
+{
+    zmq::context_t ctx;
+    zmq::socket_t pushSock(ctx, zmq::socket_type::push);
+    pushSock.bind("inproc://ingress_ack_batcher_failed_send_test");
+
+    const cbhe_eid_t destA(2, 1);
+    hdtn::IngressAckBatcher batcher(HDTN_MSGTYPE_STORAGE_ACK_BATCH_TO_INGRESS, 10);
+    batcher.Append(destA, 1);
+    batcher.Append(destA, 2);
+
+    //no peer is connected, so a non-blocking push cannot be queued (EAGAIN)
+    BOOST_REQUIRE(!batcher.Send(pushSock));
+    BOOST_REQUIRE_EQUAL(batcher.m_totalFailedSends, 1);
+    BOOST_REQUIRE_EQUAL(batcher.m_totalMessagesSent, 0);
+    BOOST_REQUIRE_EQUAL(batcher.m_totalAcksSent, 0);
+    //the acks were not lost
+    BOOST_REQUIRE(!batcher.IsEmpty());
+    BOOST_REQUIRE_EQUAL(batcher.GetNumPendingAcks(), 2);
+
+    //acks appended after the failure join the pending batch
+    batcher.Append(destA, 3);
+
+    zmq::socket_t pullSock(ctx, zmq::socket_type::pull);
+    pullSock.connect("inproc://ingress_ack_batcher_failed_send_test");
+    BOOST_REQUIRE(batcher.Send(pushSock)); //retry succeeds once ingress is connected
+    BOOST_REQUIRE(batcher.IsEmpty());
+    BOOST_REQUIRE_EQUAL(batcher.m_totalMessagesSent, 1);
+    BOOST_REQUIRE_EQUAL(batcher.m_totalAcksSent, 3);
+
+    hdtn::IngressAckBatchHdr hdr;
+    std::vector<hdtn::IngressAckRange> ranges;
+    ReceiveAckBatch(pullSock, hdr, ranges);
+    BOOST_REQUIRE_EQUAL(hdr.base.type, HDTN_MSGTYPE_STORAGE_ACK_BATCH_TO_INGRESS);
+    BOOST_REQUIRE_EQUAL(hdr.numAcks, 3);
+    BOOST_REQUIRE_EQUAL(ranges.size(), 1);
+    BOOST_REQUIRE(ranges[0].finalDestEid == destA);
+    BOOST_REQUIRE_EQUAL(ranges[0].firstId, 1);
+    BOOST_REQUIRE_EQUAL(ranges[0].count, 3);
+}
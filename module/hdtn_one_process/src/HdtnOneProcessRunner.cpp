@@ -105,13 +105,18 @@ bool HdtnOneProcessRunner::Run(int argc, const char* const argv[], volatile bool
         //The io_threads argument specifies the size of the 0MQ thread pool to handle I/O operations.
         //If your application is using only the inproc transport for messaging you may set this to zero, otherwise set it to at least one.     
         std::unique_ptr<zmq::context_t> hdtnOneProcessZmqInprocContextPtr = boost::make_unique<zmq::context_t>(0);// 0 Threads
+        //bundles from ingress and storage to egress are moved through these instead of the inproc sockets
+        //(declared before the modules so that they are destroyed after them)
+        static const uint32_t NATIVE_CHANNEL_CAPACITY = 1000; //same as the default zmq high water mark of the sockets they replace
+        NativeInterModuleChannel<hdtn::ToEgressHdr> ingressToEgressNativeChannel(NATIVE_CHANNEL_CAPACITY);
+        NativeInterModuleChannel<hdtn::ToEgressHdr> storageToEgressNativeChannel(NATIVE_CHANNEL_CAPACITY);
 
         std::cout << "starting EgressAsync.." << std::endl;
         hdtn::Logger::getInstance()->logNotification("egress", "Starting EgressAsync");
 
         //create on heap with unique_ptr to prevent stack overflows
         std::unique_ptr<hdtn::HegrManagerAsync> egressPtr = boost::make_unique<hdtn::HegrManagerAsync>();
-        egressPtr->Init(*hdtnConfig, hdtnOneProcessZmqInprocContextPtr.get());
+        egressPtr->Init(*hdtnConfig, hdtnOneProcessZmqInprocContextPtr.get(), &ingressToEgressNativeChannel, &storageToEgressNativeChannel);
 
         printf("Announcing presence of egress ...\n");
         hdtn::Logger::getInstance()->logNotification("egress", "Egress Present");
@@ -121,14 +126,14 @@ bool HdtnOneProcessRunner::Run(int argc, const char* const argv[], volatile bool
         hdtn::Logger::getInstance()->logNotification("ingress", "Starting Ingress");
         //create on heap with unique_ptr to prevent stack overflows
         std::unique_ptr<hdtn::Ingress> ingressPtr = boost::make_unique<hdtn::Ingress>();
-        ingressPtr->Init(*hdtnConfig, isCutThroughOnlyTest, hdtnOneProcessZmqInprocContextPtr.get());
+        ingressPtr->Init(*hdtnConfig, isCutThroughOnlyTest, hdtnOneProcessZmqInprocContextPtr.get(), &ingressToEgressNativeChannel);
 
 
         //create on heap with unique_ptr to prevent stack overflows
         std::unique_ptr<ZmqStorageInterface> storagePtr = boost::make_unique<ZmqStorageInterface>();
         std::cout << "[store] Initializing storage manager ..." << std::endl;
         hdtn::Logger::getInstance()->logNotification("storage", "[store] Initializing storage manager ...");
-        if (!storagePtr->Init(*hdtnConfig, hdtnOneProcessZmqInprocContextPtr.get())) {
+        if (!storagePtr->Init(*hdtnConfig, hdtnOneProcessZmqInprocContextPtr.get(), &storageToEgressNativeChannel)) {
             return false;
         }
         
@@ -190,6 +195,46 @@ bool HdtnOneProcessRunner::Run(int argc, const char* const argv[], volatile bool
                 pt.put("egressBundleCount", egressPtr->m_bundleCount);
                 pt.put("egressBundleData", egressPtr->m_bundleData/1000);
                 pt.put("egressMessageCount", egressPtr->m_messageCount);
+                hdtn::IngressCreditTelemetry creditTelem;
+                ingressPtr->GetCreditTelemetry(creditTelem);
+                pt.put("ingressCreditsPerPath", creditTelem.creditsPerPath);
+                pt.put("ingressEgressPathsOutOfCredits", creditTelem.numEgressPathsOutOfCredits);
+                pt.put("ingressMinEgressCreditsAvailable", creditTelem.minEgressCreditsAvailable);
+                pt.put("ingressMinStorageCreditsAvailable", creditTelem.minStorageCreditsAvailable);
+                pt.put("ingressBundlesWaitingForCredits", creditTelem.numBundlesWaitingForCredits);
+                pt.put("ingressTotalEgressCreditWaits", creditTelem.totalEgressCreditWaits);
+                pt.put("ingressTotalStorageCreditWaits", creditTelem.totalStorageCreditWaits);
+                pt.put("ingressTotalInductBackPressureEvents", creditTelem.totalInductBackPressureEvents);
+                pt.put("ingressInductBackPressureActive", creditTelem.inductBackPressureActive);
+                EgressSchedulerTelemetry schedulerTelem;
+                egressPtr->GetSchedulerTelemetry(schedulerTelem);
+                pt.put("egressSchedulerQueuedBundlesBulk", schedulerTelem.queuedBundles[0]);
+                pt.put("egressSchedulerQueuedBundlesNormal", schedulerTelem.queuedBundles[1]);
+                pt.put("egressSchedulerQueuedBundlesExpedited", schedulerTelem.queuedBundles[2]);
+                pt.put("egressSchedulerQueuedBytesBulk", schedulerTelem.queuedBytes[0]);
+                pt.put("egressSchedulerQueuedBytesNormal", schedulerTelem.queuedBytes[1]);
+                pt.put("egressSchedulerQueuedBytesExpedited", schedulerTelem.queuedBytes[2]);
+                pt.put("egressSchedulerMaxQueuedBundlesBulk", schedulerTelem.maxQueuedBundles[0]);
+                pt.put("egressSchedulerMaxQueuedBundlesNormal", schedulerTelem.maxQueuedBundles[1]);
+                pt.put("egressSchedulerMaxQueuedBundlesExpedited", schedulerTelem.maxQueuedBundles[2]);
+                std::vector<release_window_stats_t> releaseWindowStats;
+                storagePtr->GetReleaseWindowStats(releaseWindowStats);
+                boost::property_tree::ptree & releaseWindowsPt = pt.put_child("storageReleaseWindows",
+                    releaseWindowStats.empty() ? boost::property_tree::ptree("[]") : boost::property_tree::ptree());
+                for (std::size_t i = 0; i < releaseWindowStats.size(); ++i) {
+                    const release_window_stats_t & windowStats = releaseWindowStats[i];
+                    boost::property_tree::ptree & windowPt = (releaseWindowsPt.push_back(std::make_pair("", boost::property_tree::ptree())))->second; //using "" as key creates json array
+                    windowPt.put("name", windowStats.name);
+                    windowPt.put("bandwidthDelayProductBytes", windowStats.bandwidthDelayProductBytes);
+                    windowPt.put("windowBytes", windowStats.windowBytes);
+                    windowPt.put("bytesInFlight", windowStats.bytesInFlight);
+                    windowPt.put("bundlesInFlight", windowStats.bundlesInFlight);
+                    windowPt.put("smoothedRttMicroseconds", windowStats.smoothedRttMicroseconds);
+                    windowPt.put("totalBundlesReleased", windowStats.totalBundlesReleased);
+                    windowPt.put("totalBytesReleased", windowStats.totalBytesReleased);
+                    windowPt.put("totalClogEvents", windowStats.totalClogEvents);
+                    windowPt.put("totalWindowDecreases", windowStats.totalWindowDecreases);
+                }
                 std::stringstream ss;
                 boost::property_tree::json_parser::write_json(ss, pt);
                 json = ss.str();
@@ -0,0 +1,76 @@
+#ifndef _HDTN_EGRESS_TO_INGRESS_ACKING_QUEUE_H
+#define _HDTN_EGRESS_TO_INGRESS_ACKING_QUEUE_H
+
+#include <stdint.h>
+#include <set>
+#include <boost/thread.hpp>
+
+namespace hdtn {
+
+//The unique ids of the bundles ingress has sent to egress for one final destination and that egress has not acked yet
+//(one credit each).  Egress forwards by priority, so an expedited bundle may be acked before a bulk bundle sent earlier
+//to the same destination: the ids are therefore kept ordered in a set so that an ack removes its ids in logarithmic time
+//wherever they are, instead of searching the pending ids in send order.
+//Each ingress shard also keeps one for the bundles it sent to storage, so both paths wait for credits the same way.
+struct EgressToIngressAckingQueue {
+    EgressToIngressAckingQueue() {
+
+    }
+    std::size_t GetQueueSize() {
+        return m_ingressToEgressCustodyIdSet.size();
+    }
+    void PushMove_ThreadSafe(const uint64_t ingressToEgressCustody) {
+        boost::mutex::scoped_lock lock(m_mutex);
+        m_ingressToEgressCustodyIdSet.emplace_hint(m_ingressToEgressCustodyIdSet.end(), ingressToEgressCustody); //ids mostly arrive in increasing order
+    }
+    //undoes PushMove_ThreadSafe when the bundle could not be sent to egress after all
+    void Remove_ThreadSafe(const uint64_t ingressToEgressCustody) {
+        boost::mutex::scoped_lock lock(m_mutex);
+        m_ingressToEgressCustodyIdSet.erase(ingressToEgressCustody);
+    }
+    //removes the count consecutive ids starting at firstIngressToEgressCustody wherever they are queued, returns the number removed
+    uint64_t EraseRange_ThreadSafe(const uint64_t firstIngressToEgressCustody, const uint64_t count) {
+        boost::mutex::scoped_lock lock(m_mutex);
+        const std::set<uint64_t>::iterator itBegin = m_ingressToEgressCustodyIdSet.lower_bound(firstIngressToEgressCustody);
+        std::set<uint64_t>::iterator itEnd = itBegin;
+        uint64_t numErased = 0;
+        while ((itEnd != m_ingressToEgressCustodyIdSet.end()) && ((*itEnd - firstIngressToEgressCustody) < count)) {
+            ++itEnd;
+            ++numErased;
+        }
+        m_ingressToEgressCustodyIdSet.erase(itBegin, itEnd);
+        return numErased;
+    }
+    bool HasCredit_ThreadSafe(const std::size_t maxPendingAcks) {
+        boost::mutex::scoped_lock lock(m_mutex);
+        return (m_ingressToEgressCustodyIdSet.size() <= maxPendingAcks);
+    }
+    //returns true when a credit is available, or false if the deadline expired or running was cleared first
+    //(the size is checked under the mutex, so an ack between the check and the wait cannot be missed;
+    //whoever clears running must then call InterruptWait_ThreadSafe)
+    bool WaitForCreditUntil_ThreadSafe(const std::size_t maxPendingAcks, const boost::posix_time::ptime & deadline, const volatile bool & running) {
+        boost::mutex::scoped_lock lock(m_mutex);
+        while (running && (m_ingressToEgressCustodyIdSet.size() > maxPendingAcks)) {
+            if (!m_conditionVariable.timed_wait(lock, deadline)) { // call lock.unlock() and blocks the current thread
+                break;
+            }
+        }
+        return (m_ingressToEgressCustodyIdSet.size() <= maxPendingAcks);
+    }
+    void NotifyAll() {
+        m_conditionVariable.notify_all();
+    }
+    //wakes the waiters after their running flag was cleared (the lock orders the flag before their next check)
+    void InterruptWait_ThreadSafe() {
+        m_mutex.lock();
+        m_mutex.unlock();
+        m_conditionVariable.notify_all();
+    }
+    boost::mutex m_mutex;
+    boost::condition_variable m_conditionVariable;
+    std::set<uint64_t> m_ingressToEgressCustodyIdSet;
+};
+
+}  // namespace hdtn
+
+#endif //_HDTN_EGRESS_TO_INGRESS_ACKING_QUEUE_H
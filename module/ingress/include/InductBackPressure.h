@@ -0,0 +1,64 @@
+#ifndef _HDTN_INDUCT_BACK_PRESSURE_H
+#define _HDTN_INDUCT_BACK_PRESSURE_H
+
+#include <stdint.h>
+#include <boost/function.hpp>
+#include <boost/thread.hpp>
+
+namespace hdtn {
+
+//Counts the ingress threads waiting for an egress or storage credit and tells the inducts to stop reading (backpressure)
+//while there is at least one.  Every induct delivers its bundles through the same callback, so ingress cannot tell which
+//induct fed a waiting bundle: the backpressure is global.  It is applied to every induct when the first thread starts
+//waiting on any path (an egress final destination or a shard's storage queue) and is released only when the last
+//waiting thread, on whatever path, is done, so a path out of credits also holds up the inducts feeding other paths.
+class InductBackPressure {
+public:
+    typedef boost::function<void(bool backPressureActive)> set_back_pressure_function_t;
+
+    InductBackPressure(const set_back_pressure_function_t & setBackPressureFunction) :
+        m_setBackPressureFunction(setBackPressureFunction),
+        m_numWaiters(0),
+        m_totalBackPressureEvents(0),
+        m_allowBackPressure(true) {}
+
+    void BeginWaiting_ThreadSafe() {
+        boost::mutex::scoped_lock lock(m_mutex);
+        if ((m_numWaiters++ == 0) && m_allowBackPressure) {
+            ++m_totalBackPressureEvents;
+            m_setBackPressureFunction(true);
+        }
+    }
+    void EndWaiting_ThreadSafe() {
+        boost::mutex::scoped_lock lock(m_mutex);
+        if ((--m_numWaiters == 0) && m_allowBackPressure) {
+            m_setBackPressureFunction(false);
+        }
+    }
+    //no induct may be told to apply backpressure while (or after) the inducts are destroyed
+    void Disable_ThreadSafe() {
+        boost::mutex::scoped_lock lock(m_mutex);
+        m_allowBackPressure = false;
+    }
+    uint64_t GetNumWaiters_ThreadSafe() {
+        boost::mutex::scoped_lock lock(m_mutex);
+        return m_numWaiters;
+    }
+    uint64_t GetTotalBackPressureEvents_ThreadSafe() {
+        boost::mutex::scoped_lock lock(m_mutex);
+        return m_totalBackPressureEvents;
+    }
+
+private:
+    InductBackPressure();
+
+    const set_back_pressure_function_t m_setBackPressureFunction;
+    boost::mutex m_mutex;
+    uint64_t m_numWaiters; //protected by m_mutex
+    uint64_t m_totalBackPressureEvents; //protected by m_mutex
+    bool m_allowBackPressure; //protected by m_mutex (false once the inducts are being destroyed)
+};
+
+}  // namespace hdtn
+
+#endif //_HDTN_INDUCT_BACK_PRESSURE_H
@@ -14,9 +14,14 @@
 #include "InductManager.h"
 #include <list>
 #include <queue>
+#include <deque>
 #include <boost/atomic.hpp>
 #include "TcpclInduct.h"
 #include "TcpclV4Induct.h"
+#include "SharedMemoryBundleArena.h"
+#include "InterModuleChannel.h"
+#include "EgressToIngressAckingQueue.h"
+#include "InductBackPressure.h"
 #include "ingress_async_lib_export.h"
 
 namespace hdtn {
@@ -33,17 +38,52 @@ typedef struct IngressTelemetry {
     double elapsed;
 } IngressTelemetry;
 
+//Each pending (unacked) bundle to egress or storage consumes one credit; each ack returns it.
+//Ingress waits on a condition variable (until a configured deadline) for a returned credit instead of polling,
+//and while any bundle is waiting on any path, every induct is told to stop reading (see InductBackPressure).
+typedef struct IngressCreditTelemetry {
+    uint64_t creditsPerPath; //m_zmqMaxMessagesPerPath
+    uint64_t numEgressPathsTracked;
+    uint64_t numEgressPathsOutOfCredits;
+    uint64_t minEgressCreditsAvailable; //over all tracked egress paths (creditsPerPath if none tracked)
+    uint64_t minStorageCreditsAvailable; //over all shards
+    uint64_t numBundlesWaitingForCredits;
+    uint64_t totalEgressCreditWaits;
+    uint64_t totalStorageCreditWaits;
+    uint64_t totalInductBackPressureEvents;
+    bool inductBackPressureActive;
+} IngressCreditTelemetry;
+
 class Ingress {
 public:
     INGRESS_ASYNC_LIB_EXPORT Ingress();  // initialize message buffers
     INGRESS_ASYNC_LIB_EXPORT ~Ingress();
     INGRESS_ASYNC_LIB_EXPORT void Stop();
     INGRESS_ASYNC_LIB_EXPORT void SchedulerEventHandler();
+    //in one-process mode, ingressToEgressNativeChannelPtr (if not NULL) replaces the ingress to egress inproc socket
     INGRESS_ASYNC_LIB_EXPORT int Init(const HdtnConfig & hdtnConfig, const bool isCutThroughOnlyTest,
-             zmq::context_t * hdtnOneProcessZmqInprocContextPtr = NULL);
+             zmq::context_t * hdtnOneProcessZmqInprocContextPtr = NULL,
+             InterModuleChannelSender<hdtn::ToEgressHdr> * ingressToEgressNativeChannelPtr = NULL);
+    INGRESS_ASYNC_LIB_EXPORT void GetCreditTelemetry(IngressCreditTelemetry & telem);
+
+    //shard routing (public for the unit tests)
+    INGRESS_ASYNC_LIB_EXPORT static bool GetFinalDestEidForSharding(uint8_t * bundleDataBegin, std::size_t bundleCurrentSize, cbhe_eid_t & finalDestEid);
+    INGRESS_ASYNC_LIB_EXPORT static std::size_t GetShardIndexByFinalDestEid(const cbhe_eid_t & finalDestEid, const std::size_t numShards);
+    INGRESS_ASYNC_LIB_EXPORT static uint64_t GetFirstUniqueIdOfShard(const std::size_t shardIndex);
+    INGRESS_ASYNC_LIB_EXPORT static std::size_t GetShardIndexByUniqueId(const uint64_t uniqueId);
 private:
+    struct IngressShard;
     INGRESS_ASYNC_LIB_NO_EXPORT bool ProcessPaddedData(uint8_t * bundleDataBegin, std::size_t bundleCurrentSize,
+        std::unique_ptr<zmq::message_t> & zmqPaddedMessageUnderlyingDataUniquePtr, padded_vector_uint8_t & paddedVecMessageUnderlyingData, const bool usingZmqData, const bool needsProcessing,
+        IngressShard & shard);
+    INGRESS_ASYNC_LIB_NO_EXPORT bool DispatchPaddedData(uint8_t * bundleDataBegin, std::size_t bundleCurrentSize,
         std::unique_ptr<zmq::message_t> & zmqPaddedMessageUnderlyingDataUniquePtr, padded_vector_uint8_t & paddedVecMessageUnderlyingData, const bool usingZmqData, const bool needsProcessing);
+    INGRESS_ASYNC_LIB_NO_EXPORT IngressShard & GetShardByFinalDestEid(const cbhe_eid_t & finalDestEid);
+    INGRESS_ASYNC_LIB_NO_EXPORT IngressShard * GetShardByUniqueId(const uint64_t uniqueId);
+    INGRESS_ASYNC_LIB_NO_EXPORT void ProcessEgressAckBatch(const IngressAckBatchHdr & batchHdr, const IngressAckRange * ranges);
+    INGRESS_ASYNC_LIB_NO_EXPORT void ProcessStorageAckBatch(const IngressAckBatchHdr & batchHdr, const IngressAckRange * ranges);
+    INGRESS_ASYNC_LIB_NO_EXPORT void ShardWorkerThreadFunc(IngressShard * shardPtr);
+    INGRESS_ASYNC_LIB_NO_EXPORT bool MoveBundleToSharedMemory(zmq::message_t & zmqMessageBundle, shm_bundle_descriptor_t & descriptor);
     INGRESS_ASYNC_LIB_NO_EXPORT void ReadZmqAcksThreadFunc();
     INGRESS_ASYNC_LIB_NO_EXPORT void ReadTcpclOpportunisticBundlesFromEgressThreadFunc();
     INGRESS_ASYNC_LIB_NO_EXPORT void WholeBundleReadyCallback(padded_vector_uint8_t & wholeBundleVec);
@@ -51,45 +91,55 @@ private:
     INGRESS_ASYNC_LIB_NO_EXPORT void OnDeletedOpportunisticLinkCallback(const uint64_t remoteNodeId);
     INGRESS_ASYNC_LIB_NO_EXPORT void SendOpportunisticLinkMessages(const uint64_t remoteNodeId, bool isAvailable);
 public:
-    uint64_t m_bundleCountStorage;
+    boost::atomic_uint64_t m_bundleCountStorage;
     boost::atomic_uint64_t m_bundleCountEgress;
     uint64_t m_bundleCount;
     boost::atomic_uint64_t m_bundleData;
     double m_elapsed;
 
 private:
-    struct EgressToIngressAckingQueue {
-        EgressToIngressAckingQueue() {
-
-        }
-        std::size_t GetQueueSize() {
-            return m_ingressToEgressCustodyIdQueue.size();
-        }
-        void PushMove_ThreadSafe(const uint64_t ingressToEgressCustody) {
-            boost::mutex::scoped_lock lock(m_mutex);
-            m_ingressToEgressCustodyIdQueue.push(ingressToEgressCustody);
-        }
-        bool CompareAndPop_ThreadSafe(const uint64_t ingressToEgressCustody) {
-            boost::mutex::scoped_lock lock(m_mutex);
-            if (m_ingressToEgressCustodyIdQueue.empty()) {
-                return false;
-            }
-            else if (m_ingressToEgressCustodyIdQueue.front() == ingressToEgressCustody) {
-                m_ingressToEgressCustodyIdQueue.pop();
-                return true;
-            }
-            return false;
-        }
-        void WaitUntilNotifiedOr250MsTimeout() {
-            boost::mutex::scoped_lock lock(m_mutex);
-            m_conditionVariable.timed_wait(lock, boost::posix_time::milliseconds(250)); // call lock.unlock() and blocks the current thread
-        }
-        void NotifyAll() {            
-            m_conditionVariable.notify_all();
-        }
-        boost::mutex m_mutex;
-        boost::condition_variable m_conditionVariable;
-        std::queue<uint64_t> m_ingressToEgressCustodyIdQueue;
+    //a bundle waiting in a shard's work queue to be processed by that shard's worker thread
+    struct IngressShardQueueItem {
+        IngressShardQueueItem() : bundleDataBegin(NULL), bundleCurrentSize(0), usingZmqData(false), needsProcessing(false) {}
+        padded_vector_uint8_t paddedVec;
+        std::unique_ptr<zmq::message_t> zmqMessagePtr;
+        uint8_t * bundleDataBegin; //points into either paddedVec or zmqMessagePtr (moving either keeps this pointer valid)
+        std::size_t bundleCurrentSize;
+        bool usingZmqData;
+        bool needsProcessing;
+    };
+
+    //All state needed to forward bundles for a disjoint set of final destination eids.
+    //When numIngressWorkerThreads is 0, a single shard exists and is used directly by the induct threads.
+    //Otherwise each shard has its own worker thread, and bundles are assigned to a shard by final destination eid
+    //so that per-destination bundle ordering is preserved.
+    //Unique ids (ingress to egress and ingress to storage) carry the shard index in their upper bits
+    //so that acks can be routed back to the owning shard without a lookup, and so that
+    //consecutive ids from one shard stay contiguous for the range encoded ack batches.
+    struct IngressShard {
+        IngressShard() : m_shardIndex(0), m_ingressToEgressNextUniqueIdAtomic(0), m_ingressToStorageNextUniqueIdAtomic(0) {}
+
+        static constexpr unsigned int UNIQUE_ID_SHARD_INDEX_SHIFT = 48;
+        std::size_t m_shardIndex;
+
+        //bundle work queue (only used when sharded)
+        std::queue<std::unique_ptr<IngressShardQueueItem> > m_workQueue;
+        boost::mutex m_workQueueMutex;
+        boost::condition_variable m_conditionVariableWorkQueueNotEmpty;
+        boost::condition_variable m_conditionVariableWorkQueueNotFull;
+        std::unique_ptr<boost::thread> m_threadPtr;
+
+        EgressToIngressAckingQueue m_storageAckingQueue; //ingress to storage unique ids not yet acked by storage
+        std::map<cbhe_eid_t, EgressToIngressAckingQueue> m_egressAckMapQueue; //final dest id to queue
+        boost::mutex m_egressAckMapQueueMutex;
+        boost::atomic_uint64_t m_ingressToEgressNextUniqueIdAtomic;
+        boost::atomic_uint64_t m_ingressToStorageNextUniqueIdAtomic;
+
+        //each shard keeps its own copy of the link availability so the per-bundle lookup never contends with other shards
+        std::set<cbhe_eid_t> m_finalDestEidAvailableSet;
+        boost::mutex m_eidAvailableSetMutex;
+        std::map<uint64_t, Induct*> m_availableDestOpportunisticNodeIdToTcpclInductMap;
+        boost::mutex m_availableDestOpportunisticNodeIdToTcpclInductMapMutex;
     };
 
     std::unique_ptr<zmq::context_t> m_zmqCtxPtr;
@@ -99,6 +149,12 @@ private:
     std::unique_ptr<zmq::socket_t> m_zmqPushSock_boundIngressToConnectingStoragePtr;
     std::unique_ptr<zmq::socket_t> m_zmqPullSock_connectingStorageToBoundIngressPtr;
     std::unique_ptr<zmq::socket_t> m_zmqSubSock_boundSchedulerToConnectingIngressPtr;
+    //multi-process mode only (NULL if disabled): bundles to egress and storage go through this arena instead of the tcp sockets
+    boost::shared_ptr<SharedMemoryBundleArena> m_sharedMemoryBundleArenaPtr;
+    //bundles and opportunistic link messages to egress go through m_zmqToEgressChannelSenderPtr
+    //(over m_zmqPushSock_boundIngressToConnectingEgressPtr) or the native channel given to Init
+    std::unique_ptr<ZmqInterModuleChannelSender<hdtn::ToEgressHdr> > m_zmqToEgressChannelSenderPtr;
+    InterModuleChannelSender<hdtn::ToEgressHdr> * m_toEgressChannelSenderPtr;
 
     //boost::shared_ptr<zmq::context_t> m_zmqTelemCtx;
     //boost::shared_ptr<zmq::socket_t> m_zmqTelemSock;
@@ -108,27 +164,19 @@ private:
     cbhe_eid_t M_HDTN_EID_CUSTODY;
     cbhe_eid_t M_HDTN_EID_ECHO;
     boost::posix_time::time_duration M_MAX_INGRESS_BUNDLE_WAIT_ON_EGRESS_TIME_DURATION;
+    boost::posix_time::time_duration M_MAX_INGRESS_BUNDLE_WAIT_ON_STORAGE_TIME_DURATION;
     
     std::unique_ptr<boost::thread> m_threadZmqAckReaderPtr;
     std::unique_ptr<boost::thread> m_threadTcpclOpportunisticBundlesFromEgressReaderPtr;
-    std::queue<uint64_t> m_storageAckQueue;
-    boost::mutex m_storageAckQueueMutex;
-    boost::condition_variable m_conditionVariableStorageAckReceived;
-    std::map<cbhe_eid_t, EgressToIngressAckingQueue> m_egressAckMapQueue; //final dest id to queue
-    boost::mutex m_egressAckMapQueueMutex;
-    boost::mutex m_ingressToEgressZmqSocketMutex;
-    boost::mutex m_eidAvailableSetMutex;
-    std::size_t m_eventsTooManyInStorageQueue;
-    std::size_t m_eventsTooManyInEgressQueue;
+    std::vector<std::unique_ptr<IngressShard> > m_shards;
+    bool m_useShardWorkerThreads;
+    boost::mutex m_ingressToStorageZmqSocketMutex;
+    boost::atomic_uint64_t m_eventsTooManyInStorageQueue;
+    boost::atomic_uint64_t m_eventsTooManyInEgressQueue;
+    InductBackPressure m_inductBackPressure;
     volatile bool m_running;
     bool m_isCutThroughOnlyTest;
-    boost::atomic_uint64_t m_ingressToEgressNextUniqueIdAtomic;
-    uint64_t m_ingressToStorageNextUniqueId;
-    std::set<cbhe_eid_t> m_finalDestEidAvailableSet;
     std::vector<uint64_t> m_schedulerRxBufPtrToStdVec64;
-
-    std::map<uint64_t, Induct*> m_availableDestOpportunisticNodeIdToTcpclInductMap;
-    boost::mutex m_availableDestOpportunisticNodeIdToTcpclInductMapMutex;
 };
 
 
@@ -6,6 +6,8 @@
  */
 
 #include <iostream>
+#include <algorithm>
+#include <cstring>
 
 #include "codec/bpv6.h"
 #include "ingress.h"
@@ -15,8 +17,10 @@
 #include <boost/make_unique.hpp>
 #include <boost/lexical_cast.hpp>
 #include "Uri.h"
+#include "BundleBufferPool.h"
 #include "codec/BundleViewV6.h"
 #include "codec/BundleViewV7.h"
+#include "codec/Bpv7InPlaceForwardingView.h"
 
 namespace hdtn {
 
@@ -26,11 +30,12 @@ Ingress::Ingress() :
     m_bundleCount(0),
     m_bundleData(0),
     m_elapsed(0),
+    m_toEgressChannelSenderPtr(NULL),
+    m_useShardWorkerThreads(false),
     m_eventsTooManyInStorageQueue(0),
     m_eventsTooManyInEgressQueue(0),
-    m_running(false),
-    m_ingressToEgressNextUniqueIdAtomic(0),
-    m_ingressToStorageNextUniqueId(0)
+    m_inductBackPressure(boost::bind(&InductManager::SetBackPressure, &m_inductManager, boost::placeholders::_1)),
+    m_running(false)
 {
 }
 
@@ -39,11 +44,36 @@ Ingress::~Ingress() {
 }
 
 void Ingress::Stop() {
-    m_inductManager.Clear();
-
+    m_inductBackPressure.Disable_ThreadSafe();
 
     m_running = false; //thread stopping criteria
 
+    //wake every thread (induct or worker) waiting for an egress or storage credit so that it gives up its bundle
+    //instead of holding up the induct teardown and the joins below until its wait times out
+    for (std::size_t i = 0; i < m_shards.size(); ++i) {
+        IngressShard & shard = *m_shards[i];
+        {
+            boost::mutex::scoped_lock lockMap(shard.m_egressAckMapQueueMutex);
+            for (std::map<cbhe_eid_t, EgressToIngressAckingQueue>::iterator it = shard.m_egressAckMapQueue.begin(); it != shard.m_egressAckMapQueue.end(); ++it) {
+                it->second.InterruptWait_ThreadSafe();
+            }
+        }
+        shard.m_storageAckingQueue.InterruptWait_ThreadSafe();
+    }
+    m_inductManager.Clear();
+
+    //join the workers first since they may be waiting on acks from the ack reader thread
+    for (std::size_t i = 0; i < m_shards.size(); ++i) {
+        IngressShard & shard = *m_shards[i];
+        if (shard.m_threadPtr) {
+            shard.m_workQueueMutex.lock();
+            shard.m_workQueueMutex.unlock();
+            shard.m_conditionVariableWorkQueueNotEmpty.notify_all();
+            shard.m_conditionVariableWorkQueueNotFull.notify_all();
+            shard.m_threadPtr->join();
+            shard.m_threadPtr.reset(); //delete it
+        }
+    }
     if (m_threadZmqAckReaderPtr) {
         m_threadZmqAckReaderPtr->join();
         m_threadZmqAckReaderPtr.reset(); //delete it
@@ -52,14 +82,61 @@ void Ingress::Stop() {
         m_threadTcpclOpportunisticBundlesFromEgressReaderPtr->join();
         m_threadTcpclOpportunisticBundlesFromEgressReaderPtr.reset(); //delete it
     }
-
+    m_shards.clear();
 
     std::cout << "m_eventsTooManyInStorageQueue: " << m_eventsTooManyInStorageQueue << std::endl;
     hdtn::Logger::getInstance()->logNotification("ingress",
         "m_eventsTooManyInStorageQueue: " + std::to_string(m_eventsTooManyInStorageQueue));
+    std::cout << "m_eventsTooManyInEgressQueue: " << m_eventsTooManyInEgressQueue << std::endl;
+    const uint64_t totalInductBackPressureEvents = m_inductBackPressure.GetTotalBackPressureEvents_ThreadSafe();
+    std::cout << "m_totalInductBackPressureEvents: " << totalInductBackPressureEvents << std::endl;
+    hdtn::Logger::getInstance()->logNotification("ingress",
+        "m_eventsTooManyInEgressQueue: " + std::to_string(m_eventsTooManyInEgressQueue) +
+        " m_totalInductBackPressureEvents: " + std::to_string(totalInductBackPressureEvents));
 }
 
-int Ingress::Init(const HdtnConfig & hdtnConfig, const bool isCutThroughOnlyTest, zmq::context_t * hdtnOneProcessZmqInprocContextPtr) {
+void Ingress::GetCreditTelemetry(IngressCreditTelemetry & telem) {
+    const uint64_t creditsPerPath = m_hdtnConfig.m_zmqMaxMessagesPerPath;
+    telem.creditsPerPath = creditsPerPath;
+    telem.numEgressPathsTracked = 0;
+    telem.numEgressPathsOutOfCredits = 0;
+    telem.minEgressCreditsAvailable = creditsPerPath;
+    telem.minStorageCreditsAvailable = creditsPerPath;
+    for (std::size_t i = 0; i < m_shards.size(); ++i) {
+        IngressShard & shard = *m_shards[i];
+        {
+            boost::mutex::scoped_lock lockMap(shard.m_egressAckMapQueueMutex);
+            for (std::map<cbhe_eid_t, EgressToIngressAckingQueue>::iterator it = shard.m_egressAckMapQueue.begin(); it != shard.m_egressAckMapQueue.end(); ++it) {
+                std::size_t numPending;
+                {
+                    boost::mutex::scoped_lock lockQueue(it->second.m_mutex);
+                    numPending = it->second.m_ingressToEgressCustodyIdSet.size();
+                }
+                const uint64_t creditsAvailable = (numPending < creditsPerPath) ? (creditsPerPath - numPending) : 0;
+                ++telem.numEgressPathsTracked;
+                if (creditsAvailable == 0) {
+                    ++telem.numEgressPathsOutOfCredits;
+                }
+                telem.minEgressCreditsAvailable = std::min(telem.minEgressCreditsAvailable, creditsAvailable);
+            }
+        }
+        {
+            boost::mutex::scoped_lock lockStorage(shard.m_storageAckingQueue.m_mutex);
+            const std::size_t numPending = shard.m_storageAckingQueue.m_ingressToEgressCustodyIdSet.size();
+            const uint64_t creditsAvailable = (numPending < creditsPerPath) ? (creditsPerPath - numPending) : 0;
+            telem.minStorageCreditsAvailable = std::min(telem.minStorageCreditsAvailable, creditsAvailable);
+        }
+    }
+    telem.totalEgressCreditWaits = m_eventsTooManyInEgressQueue;
+    telem.totalStorageCreditWaits = m_eventsTooManyInStorageQueue;
+    telem.numBundlesWaitingForCredits = m_inductBackPressure.GetNumWaiters_ThreadSafe();
+    telem.totalInductBackPressureEvents = m_inductBackPressure.GetTotalBackPressureEvents_ThreadSafe();
+    telem.inductBackPressureActive = (telem.numBundlesWaitingForCredits != 0);
+}
+
+int Ingress::Init(const HdtnConfig & hdtnConfig, const bool isCutThroughOnlyTest, zmq::context_t * hdtnOneProcessZmqInprocContextPtr,
+    InterModuleChannelSender<hdtn::ToEgressHdr> * ingressToEgressNativeChannelPtr)
+{
 
     if (!m_running) {
         m_running = true;
@@ -73,6 +150,25 @@ int Ingress::Init(const HdtnConfig & hdtnConfig, const bool isCutThroughOnlyTest
         M_HDTN_EID_ECHO.Set(m_hdtnConfig.m_myNodeId, m_hdtnConfig.m_myBpEchoServiceId);
 
         M_MAX_INGRESS_BUNDLE_WAIT_ON_EGRESS_TIME_DURATION = boost::posix_time::milliseconds(m_hdtnConfig.m_maxIngressBundleWaitOnEgressMilliseconds);
+        M_MAX_INGRESS_BUNDLE_WAIT_ON_STORAGE_TIME_DURATION = boost::posix_time::milliseconds(m_hdtnConfig.m_maxIngressBundleWaitOnStorageMilliseconds);
+
+        static constexpr uint64_t MAX_INGRESS_WORKER_THREADS = 256;
+        if (m_hdtnConfig.m_numIngressWorkerThreads > MAX_INGRESS_WORKER_THREADS) {
+            std::cerr << "error: ingress numIngressWorkerThreads (" << m_hdtnConfig.m_numIngressWorkerThreads
+                << ") exceeds the maximum of " << MAX_INGRESS_WORKER_THREADS << std::endl;
+            return 0;
+        }
+        m_useShardWorkerThreads = (m_hdtnConfig.m_numIngressWorkerThreads != 0);
+        const std::size_t numShards = (m_useShardWorkerThreads) ? static_cast<std::size_t>(m_hdtnConfig.m_numIngressWorkerThreads) : 1;
+        m_shards.clear();
+        m_shards.reserve(numShards);
+        for (std::size_t i = 0; i < numShards; ++i) {
+            m_shards.push_back(boost::make_unique<IngressShard>());
+            const uint64_t firstUniqueId = GetFirstUniqueIdOfShard(i);
+            m_shards.back()->m_shardIndex = i;
+            m_shards.back()->m_ingressToEgressNextUniqueIdAtomic = firstUniqueId;
+            m_shards.back()->m_ingressToStorageNextUniqueIdAtomic = firstUniqueId;
+        }
 
         m_zmqCtxPtr = boost::make_unique<zmq::context_t>(); //needed at least by scheduler (and if one-process is not used)
         try {
@@ -97,6 +193,16 @@ int Ingress::Init(const HdtnConfig & hdtnConfig, const bool isCutThroughOnlyTest
                 m_zmqPullSock_connectingEgressBundlesOnlyToBoundIngressPtr->bind(std::string("inproc://connecting_egress_bundles_only_to_bound_ingress"));
             }
             else {
+                if (m_hdtnConfig.m_sharedMemoryBundleArenaNumSlabs) {
+                    m_sharedMemoryBundleArenaPtr = SharedMemoryBundleArena::Create(
+                        SharedMemoryBundleArena::GetArenaName(m_hdtnConfig.m_zmqBoundIngressToConnectingEgressPortPath),
+                        static_cast<uint32_t>(m_hdtnConfig.m_sharedMemoryBundleArenaNumSlabs), m_hdtnConfig.m_sharedMemoryBundleArenaSlabSizeBytes);
+                    if (!m_sharedMemoryBundleArenaPtr) {
+                        std::cerr << "error in Ingress::Init: cannot create the shared memory bundle arena" << std::endl;
+                        hdtn::Logger::getInstance()->logError("ingress", "Error in Ingress::Init: cannot create the shared memory bundle arena");
+                        return 0;
+                    }
+                }
                 // socket for cut-through mode straight to egress
                 m_zmqPushSock_boundIngressToConnectingEgressPtr = boost::make_unique<zmq::socket_t>(*m_zmqCtxPtr, zmq::socket_type::push);
                 const std::string bind_boundIngressToConnectingEgressPath(
@@ -128,6 +234,13 @@ int Ingress::Init(const HdtnConfig & hdtnConfig, const bool isCutThroughOnlyTest
             std::cerr << "error: ingress cannot connect bind zmq socket: " << ex.what() << std::endl;
             return 0;
         }
+        if (hdtnOneProcessZmqInprocContextPtr && ingressToEgressNativeChannelPtr) {
+            m_toEgressChannelSenderPtr = ingressToEgressNativeChannelPtr;
+        }
+        else {
+            m_zmqToEgressChannelSenderPtr = boost::make_unique<ZmqInterModuleChannelSender<hdtn::ToEgressHdr> >(m_zmqPushSock_boundIngressToConnectingEgressPtr.get());
+            m_toEgressChannelSenderPtr = m_zmqToEgressChannelSenderPtr.get();
+        }
         static const int timeout = 250;  // milliseconds
         m_zmqPullSock_connectingStorageToBoundIngressPtr->set(zmq::sockopt::rcvtimeo, timeout);
         m_zmqPullSock_connectingEgressToBoundIngressPtr->set(zmq::sockopt::rcvtimeo, timeout);
@@ -155,12 +268,22 @@ int Ingress::Init(const HdtnConfig & hdtnConfig, const bool isCutThroughOnlyTest
             boost::bind(&Ingress::ReadTcpclOpportunisticBundlesFromEgressThreadFunc, this)); //create and start the worker thread
 
         m_isCutThroughOnlyTest = isCutThroughOnlyTest;
+        if (m_useShardWorkerThreads) {
+            for (std::size_t i = 0; i < m_shards.size(); ++i) {
+                m_shards[i]->m_threadPtr = boost::make_unique<boost::thread>(
+                    boost::bind(&Ingress::ShardWorkerThreadFunc, this, m_shards[i].get())); //create and start the worker thread
+            }
+        }
         m_inductManager.LoadInductsFromConfig(boost::bind(&Ingress::WholeBundleReadyCallback, this, boost::placeholders::_1), m_hdtnConfig.m_inductsConfig,
             m_hdtnConfig.m_myNodeId, m_hdtnConfig.m_maxLtpReceiveUdpPacketSizeBytes, m_hdtnConfig.m_maxBundleSizeBytes,
             boost::bind(&Ingress::OnNewOpportunisticLinkCallback, this, boost::placeholders::_1, boost::placeholders::_2),
             boost::bind(&Ingress::OnDeletedOpportunisticLinkCallback, this, boost::placeholders::_1));
 
-        std::cout << "Ingress running, allowing up to " << m_hdtnConfig.m_zmqMaxMessagesPerPath << " max zmq messages per path." << std::endl;
+        std::cout << "Ingress running, allowing up to " << m_hdtnConfig.m_zmqMaxMessagesPerPath << " max zmq messages per path";
+        if (m_useShardWorkerThreads) {
+            std::cout << ", using " << numShards << " worker threads sharded by final destination eid";
+        }
+        std::cout << "." << std::endl;
     }
     return 0;
 }
@@ -177,6 +300,9 @@ void Ingress::ReadZmqAcksThreadFunc() {
     };
     std::size_t totalAcksFromEgress = 0;
     std::size_t totalAcksFromStorage = 0;
+    std::size_t totalAckMessagesFromEgress = 0;
+    std::size_t totalAckMessagesFromStorage = 0;
+    zmq::message_t ackBatchMessage;
 
     static const long DEFAULT_BIG_TIMEOUT_POLL = 250;
 
@@ -190,81 +316,49 @@ void Ingress::ReadZmqAcksThreadFunc() {
             continue;
         }
         if (rc > 0) {
-            if (items[0].revents & ZMQ_POLLIN) { //ack from egress
-                EgressAckHdr receivedEgressAckHdr;
-                const zmq::recv_buffer_result_t res = m_zmqPullSock_connectingEgressToBoundIngressPtr->recv(zmq::mutable_buffer(&receivedEgressAckHdr, sizeof(hdtn::EgressAckHdr)), zmq::recv_flags::dontwait);
-                if (!res) {
-                    std::cerr << "error in BpIngressSyscall::ReadZmqAcksThreadFunc: cannot read egress BlockHdr ack" << std::endl;
-                    hdtn::Logger::getInstance()->logError("ingress",
-                        "Error in BpIngressSyscall::ReadZmqAcksThreadFunc: cannot read egress BlockHdr ack");
+            for (unsigned int itemIndex = 0; itemIndex < 2; ++itemIndex) { //acks from egress (index 0) or storage (index 1)
+                if ((items[itemIndex].revents & ZMQ_POLLIN) == 0) {
+                    continue;
                 }
-                else if ((res->truncated()) || (res->size != sizeof(hdtn::EgressAckHdr))) {
-                    std::cerr << "egress EgressAckHdr message mismatch: untruncated = " << res->untruncated_size
-                        << " truncated = " << res->size << " expected = " << sizeof(hdtn::EgressAckHdr) << std::endl;
+                const bool isFromEgress = (itemIndex == 0);
+                const char * const fromName = (isFromEgress) ? "egress" : "storage";
+                zmq::socket_t & sock = (isFromEgress) ? *m_zmqPullSock_connectingEgressToBoundIngressPtr : *m_zmqPullSock_connectingStorageToBoundIngressPtr;
+                if (!sock.recv(ackBatchMessage, zmq::recv_flags::dontwait)) {
+                    std::cerr << "error in Ingress::ReadZmqAcksThreadFunc: cannot read " << fromName << " ack batch" << std::endl;
                     hdtn::Logger::getInstance()->logError("ingress",
-                        "Egress EgressAckHdr message mismatch: untruncated = " + std::to_string(res->untruncated_size)
-                        + " truncated = " + std::to_string(res->size) + " expected = " +
-                        std::to_string(sizeof(hdtn::EgressAckHdr)));
+                        "Error in Ingress::ReadZmqAcksThreadFunc: cannot read " + std::string(fromName) + " ack batch");
+                    continue;
                 }
-                else if (receivedEgressAckHdr.base.type != HDTN_MSGTYPE_EGRESS_ACK_TO_INGRESS) {
-                    std::cerr << "error message ack not HDTN_MSGTYPE_EGRESS_ACK_TO_INGRESS\n";
+                if (ackBatchMessage.size() < sizeof(hdtn::IngressAckBatchHdr)) {
+                    std::cerr << fromName << " IngressAckBatchHdr message too small: size = " << ackBatchMessage.size() << std::endl;
+                    hdtn::Logger::getInstance()->logError("ingress", std::string(fromName) + " IngressAckBatchHdr message too small");
+                    continue;
                 }
-                else {
-                    m_egressAckMapQueueMutex.lock();
-                    EgressToIngressAckingQueue & egressToIngressAckingObj = m_egressAckMapQueue[receivedEgressAckHdr.finalDestEid];
-                    m_egressAckMapQueueMutex.unlock();
-                    if (egressToIngressAckingObj.CompareAndPop_ThreadSafe(receivedEgressAckHdr.custodyId)) {
-                        egressToIngressAckingObj.NotifyAll();
-                        ++totalAcksFromEgress;
-                    }
-                    else {
-                        std::cerr << "error didn't receive expected egress ack" << std::endl;
-                        hdtn::Logger::getInstance()->logError("ingress", "Error didn't receive expected egress ack");
-                    }
-
-                }
-            }
-            if (items[1].revents & ZMQ_POLLIN) { //ack from storage
-                StorageAckHdr receivedStorageAck;
-                const zmq::recv_buffer_result_t res = m_zmqPullSock_connectingStorageToBoundIngressPtr->recv(zmq::mutable_buffer(&receivedStorageAck, sizeof(hdtn::StorageAckHdr)), zmq::recv_flags::dontwait);
-                if (!res) {
-                    std::cerr << "error in BpIngressSyscall::ReadZmqAcksThreadFunc: cannot read storage BlockHdr ack" << std::endl;
-                    hdtn::Logger::getInstance()->logError("ingress",
-                        "Error in BpIngressSyscall::ReadZmqAcksThreadFunc: cannot read storage BlockHdr ack");
-
+                const hdtn::IngressAckBatchHdr & batchHdr = *(static_cast<const hdtn::IngressAckBatchHdr *>(ackBatchMessage.data()));
+                const uint16_t expectedType = (isFromEgress) ? HDTN_MSGTYPE_EGRESS_ACK_BATCH_TO_INGRESS : HDTN_MSGTYPE_STORAGE_ACK_BATCH_TO_INGRESS;
+                if (batchHdr.base.type != expectedType) {
+                    std::cerr << "error message ack from " << fromName << " has wrong type " << batchHdr.base.type << "\n";
+                    continue;
                 }
-                else if ((res->truncated()) || (res->size != sizeof(hdtn::StorageAckHdr))) {
-                    std::cerr << "egress StorageAckHdr message mismatch: untruncated = " << res->untruncated_size
-                        << " truncated = " << res->size << " expected = " << sizeof(hdtn::StorageAckHdr) << std::endl;
-                    hdtn::Logger::getInstance()->logError("ingress",
-                        "Egress blockhdr message mismatch: untruncated = " + std::to_string(res->untruncated_size)
-                        + " truncated = " + std::to_string(res->size) + " expected = " +
-                        std::to_string(sizeof(hdtn::StorageAckHdr)));
+                const std::size_t expectedSize = sizeof(hdtn::IngressAckBatchHdr) + (batchHdr.numRanges * sizeof(hdtn::IngressAckRange));
+                if (ackBatchMessage.size() != expectedSize) {
+                    std::cerr << fromName << " IngressAckBatchHdr message mismatch: size = " << ackBatchMessage.size()
+                        << " expected = " << expectedSize << std::endl;
+                    hdtn::Logger::getInstance()->logError("ingress", std::string(fromName) + " IngressAckBatchHdr message mismatch: size = "
+                        + std::to_string(ackBatchMessage.size()) + " expected = " + std::to_string(expectedSize));
+                    continue;
                 }
-                else if (receivedStorageAck.base.type != HDTN_MSGTYPE_STORAGE_ACK_TO_INGRESS) {
-                    std::cerr << "error message ack not HDTN_MSGTYPE_STORAGE_ACK_TO_INGRESS\n";
+                const hdtn::IngressAckRange * ranges = reinterpret_cast<const hdtn::IngressAckRange *>(
+                    static_cast<const uint8_t *>(ackBatchMessage.data()) + sizeof(hdtn::IngressAckBatchHdr));
+                if (isFromEgress) {
+                    ProcessEgressAckBatch(batchHdr, ranges);
+                    totalAcksFromEgress += batchHdr.numAcks;
+                    ++totalAckMessagesFromEgress;
                 }
                 else {
-                    bool needsNotify = false;
-                    {
-                        boost::mutex::scoped_lock lock(m_storageAckQueueMutex);
-                        if (m_storageAckQueue.empty()) {
-                            std::cerr << "error m_storageAckQueue is empty" << std::endl;
-                            hdtn::Logger::getInstance()->logError("ingress", "Error m_storageAckQueue is empty");
-                        }
-                        else if (m_storageAckQueue.front() == receivedStorageAck.ingressUniqueId) {
-                            m_storageAckQueue.pop();
-                            needsNotify = true;
-                            ++totalAcksFromStorage;
-                        }
-                        else {
-                            std::cerr << "error didn't receive expected storage ack" << std::endl;
-                            hdtn::Logger::getInstance()->logError("ingress", "Error didn't receive expected storage ack");
-                        }
-                    }
-                    if (needsNotify) {
-                        m_conditionVariableStorageAckReceived.notify_all();
-                    }
+                    ProcessStorageAckBatch(batchHdr, ranges);
+                    totalAcksFromStorage += batchHdr.numAcks;
+                    ++totalAckMessagesFromStorage;
                 }
             }
             if (items[2].revents & ZMQ_POLLIN) { //events from Scheduler
@@ -272,21 +366,69 @@ void Ingress::ReadZmqAcksThreadFunc() {
             }
         }
     }
-    std::cout << "totalAcksFromEgress: " << totalAcksFromEgress << std::endl;
-    std::cout << "totalAcksFromStorage: " << totalAcksFromStorage << std::endl;
+    const double acksPerMessageFromEgress = (totalAckMessagesFromEgress) ? (static_cast<double>(totalAcksFromEgress) / totalAckMessagesFromEgress) : 0.0;
+    const double acksPerMessageFromStorage = (totalAckMessagesFromStorage) ? (static_cast<double>(totalAcksFromStorage) / totalAckMessagesFromStorage) : 0.0;
+    std::cout << "totalAcksFromEgress: " << totalAcksFromEgress << " in " << totalAckMessagesFromEgress
+        << " messages (" << acksPerMessageFromEgress << " acks per message)" << std::endl;
+    std::cout << "totalAcksFromStorage: " << totalAcksFromStorage << " in " << totalAckMessagesFromStorage
+        << " messages (" << acksPerMessageFromStorage << " acks per message)" << std::endl;
     std::cout << "m_bundleCountStorage: " << m_bundleCountStorage << std::endl;
     std::cout << "m_bundleCountEgress: " << m_bundleCountEgress << std::endl;
     m_bundleCount = m_bundleCountStorage + m_bundleCountEgress;
     std::cout << "m_bundleCount: " << m_bundleCount << std::endl;
     std::cout << "BpIngressSyscall::ReadZmqAcksThreadFunc thread exiting\n";
-    hdtn::Logger::getInstance()->logInfo("ingress", "totalAcksFromEgress: " + std::to_string(totalAcksFromEgress));
-    hdtn::Logger::getInstance()->logInfo("ingress", "totalAcksFromStorage: " + std::to_string(totalAcksFromStorage));
+    hdtn::Logger::getInstance()->logInfo("ingress", "totalAcksFromEgress: " + std::to_string(totalAcksFromEgress)
+        + " (" + std::to_string(acksPerMessageFromEgress) + " acks per message)");
+    hdtn::Logger::getInstance()->logInfo("ingress", "totalAcksFromStorage: " + std::to_string(totalAcksFromStorage)
+        + " (" + std::to_string(acksPerMessageFromStorage) + " acks per message)");
     hdtn::Logger::getInstance()->logInfo("ingress", "m_bundleCountStorage: " + std::to_string(m_bundleCountStorage));
     hdtn::Logger::getInstance()->logInfo("ingress", "m_bundleCountEgress: " + std::to_string(m_bundleCountEgress));
     hdtn::Logger::getInstance()->logInfo("ingress", "m_bundleCount: " + std::to_string(m_bundleCount));
     hdtn::Logger::getInstance()->logNotification("ingress", "BpIngressSyscall::ReadZmqAcksThreadFunc thread exiting");
 }
 
+void Ingress::ProcessEgressAckBatch(const IngressAckBatchHdr & batchHdr, const IngressAckRange * ranges) {
+    for (uint32_t i = 0; i < batchHdr.numRanges; ++i) {
+        const IngressAckRange & range = ranges[i];
+        IngressShard * shardPtr = GetShardByUniqueId(range.firstId);
+        if (shardPtr == NULL) {
+            std::cerr << "error egress ack has invalid unique id " << range.firstId << std::endl;
+            continue;
+        }
+        shardPtr->m_egressAckMapQueueMutex.lock();
+        EgressToIngressAckingQueue & egressToIngressAckingObj = shardPtr->m_egressAckMapQueue[range.finalDestEid];
+        shardPtr->m_egressAckMapQueueMutex.unlock();
+        const uint64_t numErased = egressToIngressAckingObj.EraseRange_ThreadSafe(range.firstId, range.count);
+        if (numErased) {
+            egressToIngressAckingObj.NotifyAll();
+        }
+        if (numErased != range.count) {
+            std::cerr << "error didn't receive expected egress ack" << std::endl;
+            hdtn::Logger::getInstance()->logError("ingress", "Error didn't receive expected egress ack");
+        }
+    }
+}
+
+void Ingress::ProcessStorageAckBatch(const IngressAckBatchHdr & batchHdr, const IngressAckRange * ranges) {
+    for (uint32_t i = 0; i < batchHdr.numRanges; ++i) {
+        const IngressAckRange & range = ranges[i];
+        IngressShard * shardPtr = GetShardByUniqueId(range.firstId);
+        if (shardPtr == NULL) {
+            std::cerr << "error storage ack has invalid unique id " << range.firstId << std::endl;
+            continue;
+        }
+        EgressToIngressAckingQueue & storageAckingObj = shardPtr->m_storageAckingQueue;
+        const uint64_t numErased = storageAckingObj.EraseRange_ThreadSafe(range.firstId, range.count);
+        if (numErased) {
+            storageAckingObj.NotifyAll();
+        }
+        if (numErased != range.count) {
+            std::cerr << "error didn't receive expected storage ack" << std::endl;
+            hdtn::Logger::getInstance()->logError("ingress", "Error didn't receive expected storage ack");
+        }
+    }
+}
+
 void Ingress::ReadTcpclOpportunisticBundlesFromEgressThreadFunc() {
     static constexpr unsigned int NUM_SOCKETS = 1;
     zmq::pollitem_t items[NUM_SOCKETS] = {
@@ -330,11 +472,11 @@ void Ingress::ReadTcpclOpportunisticBundlesFromEgressThreadFunc() {
                     uint8_t * bundleDataBegin = paddedDataBegin + PaddedMallocator<uint8_t>::PADDING_ELEMENTS_BEFORE;
 
                     std::size_t bundleCurrentSize = zmqPotentiallyPaddedMessage->size() - PaddedMallocator<uint8_t>::TOTAL_PADDING_ELEMENTS;
-                    ProcessPaddedData(bundleDataBegin, bundleCurrentSize, zmqPotentiallyPaddedMessage, unusedPaddedVec, true, true);
+                    DispatchPaddedData(bundleDataBegin, bundleCurrentSize, zmqPotentiallyPaddedMessage, unusedPaddedVec, true, true);
                     ++totalOpportunisticBundlesFromEgress;
                 }
                 else { //0 => from storage and needs no processing (is not padded)
-                    ProcessPaddedData((uint8_t *)zmqPotentiallyPaddedMessage->data(), zmqPotentiallyPaddedMessage->size(), zmqPotentiallyPaddedMessage, unusedPaddedVec, true, false);
+                    DispatchPaddedData((uint8_t *)zmqPotentiallyPaddedMessage->data(), zmqPotentiallyPaddedMessage->size(), zmqPotentiallyPaddedMessage, unusedPaddedVec, true, false);
                 }
             }
         }
@@ -367,10 +509,13 @@ void Ingress::SchedulerEventHandler() {
             hdtn::Logger::getInstance()->logError("ingress", "[Ingress::SchedulerEventHandler] res->size != sizeof(hdtn::IreleaseStartHdr");
             return;
         }
-        m_eidAvailableSetMutex.lock();
-        m_finalDestEidAvailableSet.insert(iReleaseStartHdr->finalDestinationEid);
-	m_finalDestEidAvailableSet.insert(iReleaseStartHdr->nextHopEid);
-        m_eidAvailableSetMutex.unlock();
+        for (std::size_t i = 0; i < m_shards.size(); ++i) {
+            IngressShard & shard = *m_shards[i];
+            shard.m_eidAvailableSetMutex.lock();
+            shard.m_finalDestEidAvailableSet.insert(iReleaseStartHdr->finalDestinationEid);
+            shard.m_finalDestEidAvailableSet.insert(iReleaseStartHdr->nextHopEid);
+            shard.m_eidAvailableSetMutex.unlock();
+        }
         std::cout << "Ingress sending bundles to egress for finalDestinationEid: (" << iReleaseStartHdr->finalDestinationEid.nodeId
             << "," << iReleaseStartHdr->finalDestinationEid.serviceId << ")" << std::endl;
     }
@@ -381,20 +526,23 @@ void Ingress::SchedulerEventHandler() {
             hdtn::Logger::getInstance()->logError("ingress", "[Ingress::SchedulerEventHandler] res->size != sizeof(hdtn::IreleaseStopHdr");
             return;
         }
-        m_eidAvailableSetMutex.lock();
-        m_finalDestEidAvailableSet.erase(iReleaseStoptHdr->finalDestinationEid);
-	m_finalDestEidAvailableSet.erase(iReleaseStoptHdr->nextHopEid);
-        m_eidAvailableSetMutex.unlock();
+        for (std::size_t i = 0; i < m_shards.size(); ++i) {
+            IngressShard & shard = *m_shards[i];
+            shard.m_eidAvailableSetMutex.lock();
+            shard.m_finalDestEidAvailableSet.erase(iReleaseStoptHdr->finalDestinationEid);
+            shard.m_finalDestEidAvailableSet.erase(iReleaseStoptHdr->nextHopEid);
+            shard.m_eidAvailableSetMutex.unlock();
+        }
         std::cout << "Ingress sending bundles to storage for finalDestinationEid: (" << iReleaseStoptHdr->finalDestinationEid.nodeId
             << "," << iReleaseStoptHdr->finalDestinationEid.serviceId << ") " << std::endl;
     }
 }
 
 static void CustomCleanupZmqMessage(void *data, void *hint) {
-    delete static_cast<zmq::message_t*>(hint);
+    BundleBufferPool::Delete(static_cast<zmq::message_t*>(hint));
 }
 static void CustomCleanupPaddedVecUint8(void *data, void *hint) {
-    delete static_cast<padded_vector_uint8_t*>(hint);
+    BundleBufferPool::Delete(static_cast<padded_vector_uint8_t*>(hint));
 }
 
 static void CustomCleanupStdVecUint8(void *data, void *hint) {
@@ -402,17 +550,127 @@ static void CustomCleanupStdVecUint8(void *data, void *hint) {
     delete static_cast<std::vector<uint8_t>*>(hint);
 }
 
-static void CustomCleanupToEgressHdr(void *data, void *hint) {
-    delete static_cast<hdtn::ToEgressHdr*>(hint);
+static void CustomCleanupToStorageHdr(void *data, void *hint) {
+    BundleBufferPool::Delete(static_cast<hdtn::ToStorageHdr*>(hint));
 }
 
-static void CustomCleanupToStorageHdr(void *data, void *hint) {
-    delete static_cast<hdtn::ToStorageHdr*>(hint);
+
+uint64_t Ingress::GetFirstUniqueIdOfShard(const std::size_t shardIndex) {
+    return static_cast<uint64_t>(shardIndex) << IngressShard::UNIQUE_ID_SHARD_INDEX_SHIFT;
 }
 
+std::size_t Ingress::GetShardIndexByUniqueId(const uint64_t uniqueId) {
+    return static_cast<std::size_t>(uniqueId >> IngressShard::UNIQUE_ID_SHARD_INDEX_SHIFT);
+}
 
-bool Ingress::ProcessPaddedData(uint8_t * bundleDataBegin, std::size_t bundleCurrentSize,
+std::size_t Ingress::GetShardIndexByFinalDestEid(const cbhe_eid_t & finalDestEid, const std::size_t numShards) {
+    //all services of a node share a shard so that a node's bundles are never reordered relative to each other
+    return static_cast<std::size_t>(finalDestEid.nodeId % numShards);
+}
+
+Ingress::IngressShard * Ingress::GetShardByUniqueId(const uint64_t uniqueId) {
+    const std::size_t shardIndex = GetShardIndexByUniqueId(uniqueId);
+    return (shardIndex < m_shards.size()) ? m_shards[shardIndex].get() : NULL;
+}
+
+Ingress::IngressShard & Ingress::GetShardByFinalDestEid(const cbhe_eid_t & finalDestEid) {
+    return *m_shards[GetShardIndexByFinalDestEid(finalDestEid, m_shards.size())];
+}
+
+//decode only the primary block (no canonical blocks) to determine which shard should process this bundle
+bool Ingress::GetFinalDestEidForSharding(uint8_t * bundleDataBegin, std::size_t bundleCurrentSize, cbhe_eid_t & finalDestEid) {
+    if (bundleCurrentSize == 0) {
+        return false;
+    }
+    const uint8_t firstByte = bundleDataBegin[0];
+    uint64_t decodedBlockSize;
+    if (firstByte == 6) {
+        Bpv6CbhePrimaryBlock primary;
+        if (!primary.DeserializeBpv6(bundleDataBegin, decodedBlockSize, bundleCurrentSize)) {
+            return false;
+        }
+        finalDestEid = primary.m_destinationEid;
+        return true;
+    }
+    else if (firstByte == ((4U << 5) | 31U)) { //CBOR major type 4, additional information 31 (Indefinite-Length Array)
+        Bpv7CbhePrimaryBlock primary;
+        if (!primary.DeserializeBpv7(bundleDataBegin + 1, decodedBlockSize, bundleCurrentSize - 1)) {
+            return false;
+        }
+        finalDestEid = primary.m_destinationEid;
+        return true;
+    }
+    return false;
+}
+
+bool Ingress::DispatchPaddedData(uint8_t * bundleDataBegin, std::size_t bundleCurrentSize,
     std::unique_ptr<zmq::message_t> & zmqPaddedMessageUnderlyingDataUniquePtr, padded_vector_uint8_t & paddedVecMessageUnderlyingData, const bool usingZmqData, const bool needsProcessing)
+{
+    if (!m_useShardWorkerThreads) {
+        return ProcessPaddedData(bundleDataBegin, bundleCurrentSize, zmqPaddedMessageUnderlyingDataUniquePtr, paddedVecMessageUnderlyingData, usingZmqData, needsProcessing, *m_shards[0]);
+    }
+    cbhe_eid_t finalDestEid;
+    if (!GetFinalDestEidForSharding(bundleDataBegin, bundleCurrentSize, finalDestEid)) {
+        //let shard 0 report the malformed or unsupported bundle
+        finalDestEid.Set(0, 0);
+    }
+    IngressShard & shard = GetShardByFinalDestEid(finalDestEid);
+
+    std::unique_ptr<IngressShardQueueItem> itemPtr = boost::make_unique<IngressShardQueueItem>();
+    itemPtr->bundleDataBegin = bundleDataBegin;
+    itemPtr->bundleCurrentSize = bundleCurrentSize;
+    itemPtr->usingZmqData = usingZmqData;
+    itemPtr->needsProcessing = needsProcessing;
+    if (usingZmqData) {
+        itemPtr->zmqMessagePtr = std::move(zmqPaddedMessageUnderlyingDataUniquePtr);
+    }
+    else {
+        itemPtr->paddedVec = std::move(paddedVecMessageUnderlyingData);
+    }
+
+    //the queue is bounded so that a slow destination applies backpressure to the induct instead of growing memory
+    const std::size_t maxQueueSize = (m_hdtnConfig.m_zmqMaxMessagesPerPath) ? static_cast<std::size_t>(m_hdtnConfig.m_zmqMaxMessagesPerPath) : 1;
+    {
+        boost::mutex::scoped_lock lock(shard.m_workQueueMutex);
+        while (m_running && (shard.m_workQueue.size() >= maxQueueSize)) {
+            shard.m_conditionVariableWorkQueueNotFull.wait(lock); // call lock.unlock() and blocks the current thread (Stop() notifies)
+        }
+        if (!m_running) {
+            return false;
+        }
+        shard.m_workQueue.push(std::move(itemPtr));
+    }
+    shard.m_conditionVariableWorkQueueNotEmpty.notify_one();
+    return true;
+}
+
+void Ingress::ShardWorkerThreadFunc(IngressShard * shardPtr) {
+    IngressShard & shard = *shardPtr;
+    std::size_t totalBundlesProcessed = 0;
+    while (true) {
+        std::unique_ptr<IngressShardQueueItem> itemPtr;
+        {
+            boost::mutex::scoped_lock lock(shard.m_workQueueMutex);
+            while (m_running && shard.m_workQueue.empty()) {
+                shard.m_conditionVariableWorkQueueNotEmpty.wait(lock); // call lock.unlock() and blocks the current thread
+            }
+            if ((!m_running) || shard.m_workQueue.empty()) { //bundles still queued when stopping are dropped
+                break;
+            }
+            itemPtr = std::move(shard.m_workQueue.front());
+            shard.m_workQueue.pop();
+        }
+        shard.m_conditionVariableWorkQueueNotFull.notify_one();
+        ProcessPaddedData(itemPtr->bundleDataBegin, itemPtr->bundleCurrentSize, itemPtr->zmqMessagePtr, itemPtr->paddedVec,
+            itemPtr->usingZmqData, itemPtr->needsProcessing, shard);
+        ++totalBundlesProcessed;
+    }
+    std::cout << "Ingress worker thread " << shard.m_shardIndex << " processed " << totalBundlesProcessed << " bundles" << std::endl;
+}
+
+bool Ingress::ProcessPaddedData(uint8_t * bundleDataBegin, std::size_t bundleCurrentSize,
+    std::unique_ptr<zmq::message_t> & zmqPaddedMessageUnderlyingDataUniquePtr, padded_vector_uint8_t & paddedVecMessageUnderlyingData, const bool usingZmqData, const bool needsProcessing,
+    IngressShard & shard)
 {
     std::unique_ptr<zmq::message_t> zmqMessageToSendUniquePtr; //create on heap as zmq default constructor costly
     if (bundleCurrentSize > m_hdtnConfig.m_maxBundleSizeBytes) { //should never reach here as this is handled by induct
@@ -424,6 +682,7 @@ bool Ingress::ProcessPaddedData(uint8_t * bundleDataBegin, std::size_t bundleCur
     cbhe_eid_t finalDestEid;
     bool requestsCustody = false;
     bool isAdminRecordForHdtnStorage = false;
+    uint8_t priorityIndex = 1; //normal
     const uint8_t firstByte = bundleDataBegin[0];
     const bool isBpVersion6 = (firstByte == 6);
     const bool isBpVersion7 = (firstByte == ((4U << 5) | 31U));  //CBOR major type 4, additional information 31 (Indefinite-Length Array)
@@ -435,6 +694,7 @@ bool Ingress::ProcessPaddedData(uint8_t * bundleDataBegin, std::size_t bundleCur
         }
         Bpv6CbhePrimaryBlock & primary = bv.m_primaryBlockView.header;
         finalDestEid = primary.m_destinationEid;
+        priorityIndex = primary.GetPriority();
         if (needsProcessing) {
             static const BPV6_BUNDLEFLAG requiredPrimaryFlagsForCustody = BPV6_BUNDLEFLAG::SINGLETON | BPV6_BUNDLEFLAG::CUSTODY_REQUESTED;
             requestsCustody = ((primary.m_bundleProcessingControlFlags & requiredPrimaryFlagsForCustody) == requiredPrimaryFlagsForCustody);
@@ -458,109 +718,136 @@ bool Ingress::ProcessPaddedData(uint8_t * bundleDataBegin, std::size_t bundleCur
         }
         if (!zmqMessageToSendUniquePtr) { //no modifications
             if (usingZmqData) {
-                zmq::message_t * rxBufRawPointer = new zmq::message_t(std::move(*zmqPaddedMessageUnderlyingDataUniquePtr));
+                zmq::message_t * rxBufRawPointer = BundleBufferPool::New<zmq::message_t>(std::move(*zmqPaddedMessageUnderlyingDataUniquePtr));
                 zmqMessageToSendUniquePtr = boost::make_unique<zmq::message_t>(bundleDataBegin, bundleCurrentSize, CustomCleanupZmqMessage, rxBufRawPointer);
             }
             else {
-                padded_vector_uint8_t * rxBufRawPointer = new padded_vector_uint8_t(std::move(paddedVecMessageUnderlyingData));
+                padded_vector_uint8_t * rxBufRawPointer = BundleBufferPool::New<padded_vector_uint8_t>(std::move(paddedVecMessageUnderlyingData));
                 zmqMessageToSendUniquePtr = boost::make_unique<zmq::message_t>(bundleDataBegin, bundleCurrentSize, CustomCleanupPaddedVecUint8, rxBufRawPointer);
             }
         }
     }
     else if (isBpVersion7) {
-        BundleViewV7 bv;
+        //fast path: decode only the primary block and the canonical block headers, and patch
+        //the previous node and hop count blocks in place (no allocations, no re-render)
+        Bpv7InPlaceForwardingView inPlaceView;
         const bool skipCrcVerifyInCanonicalBlocks = !needsProcessing;
-        if (!bv.LoadBundle(bundleDataBegin, bundleCurrentSize, skipCrcVerifyInCanonicalBlocks)) { //todo true => skip canonical block crc checks to increase speed
+        if (!inPlaceView.LoadBundle(bundleDataBegin, bundleCurrentSize, skipCrcVerifyInCanonicalBlocks)) {
             std::cout << "error in Ingress::Process: malformed version 7 bundle received\n";
             return false;
         }
-        Bpv7CbhePrimaryBlock & primary = bv.m_primaryBlockView.header;
-        finalDestEid = primary.m_destinationEid;
+        finalDestEid = inPlaceView.m_primaryBlock.m_destinationEid;
+        priorityIndex = inPlaceView.m_primaryBlock.GetPriority();
         requestsCustody = false; //custody unsupported at this time
+        bool needsFullRender = false;
+        bool isEcho = false;
         if (needsProcessing) {
+            const BPV7_BUNDLEFLAG primaryFlags = inPlaceView.m_primaryBlock.m_bundleProcessingControlFlags;
             //admin records pertaining to this hdtn node must go to storage.. they signal a deletion from disk
             static constexpr BPV7_BUNDLEFLAG requiredPrimaryFlagsForAdminRecord = BPV7_BUNDLEFLAG::ADMINRECORD;
-            isAdminRecordForHdtnStorage = (((primary.m_bundleProcessingControlFlags & requiredPrimaryFlagsForAdminRecord) == requiredPrimaryFlagsForAdminRecord) && (finalDestEid == M_HDTN_EID_CUSTODY));
+            isAdminRecordForHdtnStorage = (((primaryFlags & requiredPrimaryFlagsForAdminRecord) == requiredPrimaryFlagsForAdminRecord) && (finalDestEid == M_HDTN_EID_CUSTODY));
             static constexpr BPV7_BUNDLEFLAG requiredPrimaryFlagsForEcho = BPV7_BUNDLEFLAG::NO_FLAGS_SET;
-            const bool isEcho = (((primary.m_bundleProcessingControlFlags & requiredPrimaryFlagsForEcho) == requiredPrimaryFlagsForEcho) && (finalDestEid == M_HDTN_EID_ECHO));
-            if (!isAdminRecordForHdtnStorage) {
-                //get previous node
-                std::vector<BundleViewV7::Bpv7CanonicalBlockView*> blocks;
-                bv.GetCanonicalBlocksByType(BPV7_BLOCK_TYPE_CODE::PREVIOUS_NODE, blocks);
-                if (blocks.size() > 1) {
-                    std::cout << "error in Ingress::Process: version 7 bundle received has multiple previous node blocks\n";
+            isEcho = (((primaryFlags & requiredPrimaryFlagsForEcho) == requiredPrimaryFlagsForEcho) && (finalDestEid == M_HDTN_EID_ECHO));
+            if (isAdminRecordForHdtnStorage) {
+                //forwarded unmodified
+            }
+            else if (isEcho) {
+                needsFullRender = true; //primary block changes size
+            }
+            else {
+                const Bpv7InPlaceForwardingView::UPDATE_RESULT result = inPlaceView.UpdatePreviousNodeAndIncrementHopCount(cbhe_eid_t(m_hdtnConfig.m_myNodeId, 0));
+                if (result == Bpv7InPlaceForwardingView::UPDATE_RESULT::HOP_LIMIT_EXCEEDED) {
+                    std::cout << "notice: Ingress::Process dropping version 7 bundle with hop count " << inPlaceView.m_hopCount << "\n";
                     return false;
                 }
-                else if (blocks.size() == 1) { //update existing
-                    if (Bpv7PreviousNodeCanonicalBlock* previousNodeBlockPtr = dynamic_cast<Bpv7PreviousNodeCanonicalBlock*>(blocks[0]->headerPtr.get())) {
-                        previousNodeBlockPtr->m_previousNode.Set(m_hdtnConfig.m_myNodeId, 0);
-                        blocks[0]->SetManuallyModified();
-                    }
-                    else {
-                        std::cout << "error in Ingress::Process: dynamic_cast to Bpv7PreviousNodeCanonicalBlock failed\n";
-                        return false;
-                    }
-                }
-                else { //prepend new previous node block
-                    std::unique_ptr<Bpv7CanonicalBlock> blockPtr = boost::make_unique<Bpv7PreviousNodeCanonicalBlock>();
-                    Bpv7PreviousNodeCanonicalBlock & block = *(reinterpret_cast<Bpv7PreviousNodeCanonicalBlock*>(blockPtr.get()));
-
-                    block.m_blockProcessingControlFlags = BPV7_BLOCKFLAG::REMOVE_BLOCK_IF_IT_CANT_BE_PROCESSED;
-                    block.m_blockNumber = bv.GetNextFreeCanonicalBlockNumber();
-                    block.m_crcType = BPV7_CRC_TYPE::CRC32C;
-                    block.m_previousNode.Set(m_hdtnConfig.m_myNodeId, 0);
-                    bv.PrependMoveCanonicalBlock(blockPtr);
+                needsFullRender = (result == Bpv7InPlaceForwardingView::UPDATE_RESULT::NEEDS_FULL_RENDER);
+            }
+        }
+        //slow path: a block must be added or resized, so fully load and re-render the bundle (which is still unmodified)
+        if (needsFullRender) {
+            BundleViewV7 bv;
+            if (!bv.LoadBundle(bundleDataBegin, bundleCurrentSize, skipCrcVerifyInCanonicalBlocks)) {
+                std::cout << "error in Ingress::Process: malformed version 7 bundle received\n";
+                return false;
+            }
+            Bpv7CbhePrimaryBlock & primary = bv.m_primaryBlockView.header;
+            //get previous node
+            std::vector<BundleViewV7::Bpv7CanonicalBlockView*> blocks;
+            bv.GetCanonicalBlocksByType(BPV7_BLOCK_TYPE_CODE::PREVIOUS_NODE, blocks);
+            if (blocks.size() > 1) {
+                std::cout << "error in Ingress::Process: version 7 bundle received has multiple previous node blocks\n";
+                return false;
+            }
+            else if (blocks.size() == 1) { //update existing
+                if (Bpv7PreviousNodeCanonicalBlock* previousNodeBlockPtr = dynamic_cast<Bpv7PreviousNodeCanonicalBlock*>(blocks[0]->headerPtr.get())) {
+                    previousNodeBlockPtr->m_previousNode.Set(m_hdtnConfig.m_myNodeId, 0);
+                    blocks[0]->SetManuallyModified();
                 }
-
-                //get hop count if exists and update it
-                bv.GetCanonicalBlocksByType(BPV7_BLOCK_TYPE_CODE::HOP_COUNT, blocks);
-                if (blocks.size() > 1) {
-                    std::cout << "error in Ingress::Process: version 7 bundle received has multiple hop count blocks\n";
+                else {
+                    std::cout << "error in Ingress::Process: dynamic_cast to Bpv7PreviousNodeCanonicalBlock failed\n";
                     return false;
                 }
-                else if (blocks.size() == 1) { //update existing
-                    if (Bpv7HopCountCanonicalBlock* hopCountBlockPtr = dynamic_cast<Bpv7HopCountCanonicalBlock*>(blocks[0]->headerPtr.get())) {
-                        //the hop count value SHOULD initially be zero and SHOULD be increased by 1 on each hop.
-                        const uint64_t newHopCount = hopCountBlockPtr->m_hopCount + 1;
-                        //When a bundle's hop count exceeds its
-                        //hop limit, the bundle SHOULD be deleted for the reason "hop limit
-                        //exceeded", following the bundle deletion procedure defined in
-                        //Section 5.10.
-                        //Hop limit MUST be in the range 1 through 255.
-                        if ((newHopCount > hopCountBlockPtr->m_hopLimit) || (newHopCount > 255)) {
-                            std::cout << "notice: Ingress::Process dropping version 7 bundle with hop count " << newHopCount << "\n";
-                            return false;
-                        }
-                        hopCountBlockPtr->m_hopCount = newHopCount;
-                        blocks[0]->SetManuallyModified();
-                    }
-                    else {
-                        std::cout << "error in Ingress::Process: dynamic_cast to Bpv7HopCountCanonicalBlock failed\n";
+            }
+            else { //prepend new previous node block
+                std::unique_ptr<Bpv7CanonicalBlock> blockPtr = boost::make_unique<Bpv7PreviousNodeCanonicalBlock>();
+                Bpv7PreviousNodeCanonicalBlock & block = *(reinterpret_cast<Bpv7PreviousNodeCanonicalBlock*>(blockPtr.get()));
+
+                block.m_blockProcessingControlFlags = BPV7_BLOCKFLAG::REMOVE_BLOCK_IF_IT_CANT_BE_PROCESSED;
+                block.m_blockNumber = bv.GetNextFreeCanonicalBlockNumber();
+                block.m_crcType = BPV7_CRC_TYPE::CRC32C;
+                block.m_previousNode.Set(m_hdtnConfig.m_myNodeId, 0);
+                bv.PrependMoveCanonicalBlock(blockPtr);
+            }
+
+            //get hop count if exists and update it
+            bv.GetCanonicalBlocksByType(BPV7_BLOCK_TYPE_CODE::HOP_COUNT, blocks);
+            if (blocks.size() > 1) {
+                std::cout << "error in Ingress::Process: version 7 bundle received has multiple hop count blocks\n";
+                return false;
+            }
+            else if (blocks.size() == 1) { //update existing
+                if (Bpv7HopCountCanonicalBlock* hopCountBlockPtr = dynamic_cast<Bpv7HopCountCanonicalBlock*>(blocks[0]->headerPtr.get())) {
+                    //the hop count value SHOULD initially be zero and SHOULD be increased by 1 on each hop.
+                    const uint64_t newHopCount = hopCountBlockPtr->m_hopCount + 1;
+                    //When a bundle's hop count exceeds its
+                    //hop limit, the bundle SHOULD be deleted for the reason "hop limit
+                    //exceeded", following the bundle deletion procedure defined in
+                    //Section 5.10.
+                    //Hop limit MUST be in the range 1 through 255.
+                    if ((newHopCount > hopCountBlockPtr->m_hopLimit) || (newHopCount > 255)) {
+                        std::cout << "notice: Ingress::Process dropping version 7 bundle with hop count " << newHopCount << "\n";
                         return false;
                     }
+                    hopCountBlockPtr->m_hopCount = newHopCount;
+                    blocks[0]->SetManuallyModified();
                 }
-                if (isEcho) {
-                    primary.m_destinationEid = primary.m_sourceNodeId;
-                    finalDestEid = primary.m_sourceNodeId;
-                    std::cerr << "Sending Ping for destination " << finalDestEid << std::endl;
-                    primary.m_sourceNodeId = M_HDTN_EID_ECHO;
-                    bv.m_primaryBlockView.SetManuallyModified();
-                }
-
-                if (!bv.RenderInPlace(PaddedMallocator<uint8_t>::PADDING_ELEMENTS_BEFORE)) {
-                    std::cout << "error in Ingress::Process: bpv7 RenderInPlace failed\n";
+                else {
+                    std::cout << "error in Ingress::Process: dynamic_cast to Bpv7HopCountCanonicalBlock failed\n";
                     return false;
                 }
-                bundleCurrentSize = bv.m_renderedBundle.size();
             }
+            if (isEcho) {
+                primary.m_destinationEid = primary.m_sourceNodeId;
+                finalDestEid = primary.m_sourceNodeId;
+                std::cerr << "Sending Ping for destination " << finalDestEid << std::endl;
+                primary.m_sourceNodeId = M_HDTN_EID_ECHO;
+                bv.m_primaryBlockView.SetManuallyModified();
+            }
+
+            if (!bv.RenderInPlace(PaddedMallocator<uint8_t>::PADDING_ELEMENTS_BEFORE)) {
+                std::cout << "error in Ingress::Process: bpv7 RenderInPlace failed\n";
+                return false;
+            }
+            bundleDataBegin = (uint8_t*)bv.m_renderedBundle.data();
+            bundleCurrentSize = bv.m_renderedBundle.size();
         }
         if (usingZmqData) {
-            zmq::message_t * rxBufRawPointer = new zmq::message_t(std::move(*zmqPaddedMessageUnderlyingDataUniquePtr));
-            zmqMessageToSendUniquePtr = boost::make_unique<zmq::message_t>((void*)bv.m_renderedBundle.data(), bundleCurrentSize, CustomCleanupZmqMessage, rxBufRawPointer);
+            zmq::message_t * rxBufRawPointer = BundleBufferPool::New<zmq::message_t>(std::move(*zmqPaddedMessageUnderlyingDataUniquePtr));
+            zmqMessageToSendUniquePtr = boost::make_unique<zmq::message_t>(bundleDataBegin, bundleCurrentSize, CustomCleanupZmqMessage, rxBufRawPointer);
         }
         else {
-            padded_vector_uint8_t * rxBufRawPointer = new padded_vector_uint8_t(std::move(paddedVecMessageUnderlyingData));
-            zmqMessageToSendUniquePtr = boost::make_unique<zmq::message_t>((void*)bv.m_renderedBundle.data(), bundleCurrentSize, CustomCleanupPaddedVecUint8, rxBufRawPointer);
+            padded_vector_uint8_t * rxBufRawPointer = BundleBufferPool::New<padded_vector_uint8_t>(std::move(paddedVecMessageUnderlyingData));
+            zmqMessageToSendUniquePtr = boost::make_unique<zmq::message_t>(bundleDataBegin, bundleCurrentSize, CustomCleanupPaddedVecUint8, rxBufRawPointer);
         }
     }
     else {
@@ -572,13 +859,13 @@ bool Ingress::ProcessPaddedData(uint8_t * bundleDataBegin, std::size_t bundleCur
     //if (isAdminRecordForHdtnStorage) {
     //    std::cout << "ingress received admin record for final dest eid (" << finalDestEid.nodeId << "," << finalDestEid.serviceId << ")\n";
     //}
-    m_eidAvailableSetMutex.lock();
-    const bool linkIsUp = (m_finalDestEidAvailableSet.count(finalDestEid) != 0);
-    m_eidAvailableSetMutex.unlock();
-    m_availableDestOpportunisticNodeIdToTcpclInductMapMutex.lock();
-    std::map<uint64_t, Induct*>::iterator tcpclInductIterator = m_availableDestOpportunisticNodeIdToTcpclInductMap.find(finalDestEid.nodeId);
-    const bool isOpportunisticLinkUp = (tcpclInductIterator != m_availableDestOpportunisticNodeIdToTcpclInductMap.end());
-    m_availableDestOpportunisticNodeIdToTcpclInductMapMutex.unlock();
+    shard.m_eidAvailableSetMutex.lock();
+    const bool linkIsUp = (shard.m_finalDestEidAvailableSet.count(finalDestEid) != 0);
+    shard.m_eidAvailableSetMutex.unlock();
+    shard.m_availableDestOpportunisticNodeIdToTcpclInductMapMutex.lock();
+    std::map<uint64_t, Induct*>::iterator tcpclInductIterator = shard.m_availableDestOpportunisticNodeIdToTcpclInductMap.find(finalDestEid.nodeId);
+    const bool isOpportunisticLinkUp = (tcpclInductIterator != shard.m_availableDestOpportunisticNodeIdToTcpclInductMap.end());
+    shard.m_availableDestOpportunisticNodeIdToTcpclInductMapMutex.unlock();
     bool shouldTryToUseCustThrough = (m_isCutThroughOnlyTest || (linkIsUp && (!requestsCustody) && (!isAdminRecordForHdtnStorage)));
     bool useStorage = !shouldTryToUseCustThrough;
     if (isOpportunisticLinkUp) {
@@ -601,17 +888,23 @@ bool Ingress::ProcessPaddedData(uint8_t * bundleDataBegin, std::size_t bundleCur
     }
     while (shouldTryToUseCustThrough) { //type egress cut through ("while loop" instead of "if statement" to support breaking to storage)
         shouldTryToUseCustThrough = false; //protection to prevent this loop from ever iterating more than once
-        m_egressAckMapQueueMutex.lock();
-        EgressToIngressAckingQueue & egressToIngressAckingObj = m_egressAckMapQueue[finalDestEid];
-        m_egressAckMapQueueMutex.unlock();
-        boost::posix_time::ptime timeoutExpiry((m_hdtnConfig.m_maxIngressBundleWaitOnEgressMilliseconds != 0) ?
-            boost::posix_time::special_values::not_a_date_time :
-            boost::posix_time::special_values::neg_infin); //allow zero ms to prevent bpgen getting blocked and use storage
-        while (egressToIngressAckingObj.GetQueueSize() > m_hdtnConfig.m_zmqMaxMessagesPerPath) { //2000 ms timeout
-            if (timeoutExpiry == boost::posix_time::special_values::not_a_date_time) {
-                timeoutExpiry = boost::posix_time::microsec_clock::universal_time() + M_MAX_INGRESS_BUNDLE_WAIT_ON_EGRESS_TIME_DURATION;
-            }
-            else if (timeoutExpiry < boost::posix_time::microsec_clock::universal_time()) {
+        shard.m_egressAckMapQueueMutex.lock();
+        EgressToIngressAckingQueue & egressToIngressAckingObj = shard.m_egressAckMapQueue[finalDestEid];
+        shard.m_egressAckMapQueueMutex.unlock();
+        const std::size_t maxPendingAcksPerPath = m_hdtnConfig.m_zmqMaxMessagesPerPath;
+        if (!egressToIngressAckingObj.HasCredit_ThreadSafe(maxPendingAcksPerPath)) {
+            ++m_eventsTooManyInEgressQueue;
+            bool gotCredit = false;
+            if (m_hdtnConfig.m_maxIngressBundleWaitOnEgressMilliseconds != 0) { //allow zero ms to prevent bpgen getting blocked and use storage
+                const boost::posix_time::ptime deadline = boost::posix_time::microsec_clock::universal_time() + M_MAX_INGRESS_BUNDLE_WAIT_ON_EGRESS_TIME_DURATION;
+                m_inductBackPressure.BeginWaiting_ThreadSafe();
+                gotCredit = egressToIngressAckingObj.WaitForCreditUntil_ThreadSafe(maxPendingAcksPerPath, deadline, m_running);
+                m_inductBackPressure.EndWaiting_ThreadSafe();
+            }
+            if ((!gotCredit) && (!m_running)) { //interrupted by Stop()
+                return false;
+            }
+            if (!gotCredit) {
                 std::string msg = "notice in Ingress::Process: cut-through path timed out after " +
                     boost::lexical_cast<std::string>(m_hdtnConfig.m_maxIngressBundleWaitOnEgressMilliseconds) +
                     " milliseconds because it has too many pending egress acks in the queue for finalDestEid (" +
@@ -627,98 +920,109 @@ bool Ingress::ProcessPaddedData(uint8_t * bundleDataBegin, std::size_t bundleCur
                     std::cerr << msg << std::endl;
                     hdtn::Logger::getInstance()->logError("ingress", msg);
                     useStorage = true;
-                    break;
+                    break; //out of the cut through loop (the bundle must not also be sent to egress)
                 }
-
             }
-            egressToIngressAckingObj.WaitUntilNotifiedOr250MsTimeout();
-            //thread is now unblocked, and the lock is reacquired by invoking lock.lock()
-            ++m_eventsTooManyInEgressQueue;
         }
 
-        const uint64_t ingressToEgressUniqueId = m_ingressToEgressNextUniqueIdAtomic.fetch_add(1, boost::memory_order_relaxed);
-
-        //force natural/64-bit alignment
-        hdtn::ToEgressHdr * toEgressHdr = new hdtn::ToEgressHdr();
-        zmq::message_t zmqMessageToEgressHdrWithDataStolen(toEgressHdr, sizeof(hdtn::ToEgressHdr), CustomCleanupToEgressHdr, toEgressHdr);
+        const uint64_t ingressToEgressUniqueId = shard.m_ingressToEgressNextUniqueIdAtomic.fetch_add(1, boost::memory_order_relaxed);
 
+        hdtn::ToEgressHdr toEgressHdr;
         //memset 0 not needed because all values set below
-        toEgressHdr->base.type = HDTN_MSGTYPE_EGRESS;
-        toEgressHdr->base.flags = 0; //flags not used by egress // static_cast<uint16_t>(primary.flags);
-        toEgressHdr->finalDestEid = finalDestEid;
-        toEgressHdr->hasCustody = requestsCustody;
-        toEgressHdr->isCutThroughFromIngress = 1;
-        toEgressHdr->custodyId = ingressToEgressUniqueId;
-        {
-            //zmq::message_t messageWithDataStolen(hdrPtr.get(), sizeof(hdtn::BlockHdr), CustomIgnoreCleanupBlockHdr); //cleanup will occur in the queue below
-            boost::mutex::scoped_lock lock(m_ingressToEgressZmqSocketMutex);
-            if (!m_zmqPushSock_boundIngressToConnectingEgressPtr->send(std::move(zmqMessageToEgressHdrWithDataStolen), zmq::send_flags::sndmore | zmq::send_flags::dontwait)) {
-                std::cerr << "ingress can't send BlockHdr to egress" << std::endl;
-                hdtn::Logger::getInstance()->logError("ingress", "Ingress can't send BlockHdr to egress");
-            }
-            else {
-                egressToIngressAckingObj.PushMove_ThreadSafe(ingressToEgressUniqueId);
-
-
-                if (!m_zmqPushSock_boundIngressToConnectingEgressPtr->send(std::move(*zmqMessageToSendUniquePtr), zmq::send_flags::dontwait)) {
-                    std::cerr << "ingress can't send bundle to egress" << std::endl;
-                    hdtn::Logger::getInstance()->logError("ingress", "Ingress can't send bundle to egress");
-
-                }
-                else {
-                    //success                            
-                    m_bundleCountEgress.fetch_add(1, boost::memory_order_relaxed);
-                }
+        toEgressHdr.base.type = HDTN_MSGTYPE_EGRESS;
+        toEgressHdr.base.flags = 0; //flags not used by egress // static_cast<uint16_t>(primary.flags);
+        toEgressHdr.finalDestEid = finalDestEid;
+        toEgressHdr.hasCustody = requestsCustody;
+        toEgressHdr.isCutThroughFromIngress = 1;
+        toEgressHdr.priorityIndex = priorityIndex;
+        toEgressHdr.unused4 = 0;
+        toEgressHdr.custodyId = ingressToEgressUniqueId;
+        shm_bundle_descriptor_t shmDescriptor;
+        const bool bundleInSharedMemory = MoveBundleToSharedMemory(*zmqMessageToSendUniquePtr, shmDescriptor);
+        if (bundleInSharedMemory) {
+            toEgressHdr.base.flags |= HDTN_FLAG_BUNDLE_IN_SHARED_MEMORY;
+        }
+        //queued before the send so that it is already there when egress acks the bundle
+        egressToIngressAckingObj.PushMove_ThreadSafe(ingressToEgressUniqueId);
+        if (!m_toEgressChannelSenderPtr->TrySend(toEgressHdr, *zmqMessageToSendUniquePtr)) {
+            egressToIngressAckingObj.Remove_ThreadSafe(ingressToEgressUniqueId);
+            std::cerr << "ingress can't send bundle to egress" << std::endl;
+            hdtn::Logger::getInstance()->logError("ingress", "Ingress can't send bundle to egress");
+            if (bundleInSharedMemory) {
+                m_sharedMemoryBundleArenaPtr->Release(shmDescriptor.slabIndex);
             }
         }
+        else {
+            //success
+            m_bundleCountEgress.fetch_add(1, boost::memory_order_relaxed);
+        }
         break;
     }
 
     if (useStorage) { //storage
-        boost::mutex::scoped_lock lock(m_storageAckQueueMutex);
-        const uint64_t ingressToStorageUniqueId = m_ingressToStorageNextUniqueId++;
-        boost::posix_time::ptime timeoutExpiry(boost::posix_time::special_values::not_a_date_time);
-        while (m_storageAckQueue.size() > m_hdtnConfig.m_zmqMaxMessagesPerPath) { //2000 ms timeout
-            if (timeoutExpiry == boost::posix_time::special_values::not_a_date_time) {
-                static const boost::posix_time::time_duration twoSeconds = boost::posix_time::seconds(2);
-                timeoutExpiry = boost::posix_time::microsec_clock::universal_time() + twoSeconds;
-            }
-            if (timeoutExpiry < boost::posix_time::microsec_clock::universal_time()) {
-                std::cerr << "error: too many pending storage acks in the queue" << std::endl;
-                hdtn::Logger::getInstance()->logError("ingress", "Error: too many pending storage acks in the queue");
+        EgressToIngressAckingQueue & storageAckingObj = shard.m_storageAckingQueue;
+        const std::size_t maxPendingAcksPerPath = m_hdtnConfig.m_zmqMaxMessagesPerPath;
+        if (!storageAckingObj.HasCredit_ThreadSafe(maxPendingAcksPerPath)) {
+            ++m_eventsTooManyInStorageQueue;
+            bool gotCredit = false;
+            if (m_hdtnConfig.m_maxIngressBundleWaitOnStorageMilliseconds != 0) {
+                const boost::posix_time::ptime deadline = boost::posix_time::microsec_clock::universal_time() + M_MAX_INGRESS_BUNDLE_WAIT_ON_STORAGE_TIME_DURATION;
+                m_inductBackPressure.BeginWaiting_ThreadSafe();
+                gotCredit = storageAckingObj.WaitForCreditUntil_ThreadSafe(maxPendingAcksPerPath, deadline, m_running);
+                m_inductBackPressure.EndWaiting_ThreadSafe();
+            }
+            if ((!gotCredit) && (!m_running)) { //interrupted by Stop()
+                return false;
+            }
+            if (!gotCredit) {
+                const std::string msg = "error in Ingress::Process: storage path timed out after " +
+                    boost::lexical_cast<std::string>(m_hdtnConfig.m_maxIngressBundleWaitOnStorageMilliseconds) +
+                    " milliseconds because it has too many pending storage acks in the queue ..dropping bundle";
+                std::cerr << msg << std::endl;
+                hdtn::Logger::getInstance()->logError("ingress", msg);
                 return false;
             }
-            m_conditionVariableStorageAckReceived.timed_wait(lock, boost::posix_time::milliseconds(250)); // call lock.unlock() and blocks the current thread
-            //thread is now unblocked, and the lock is reacquired by invoking lock.lock()
-            ++m_eventsTooManyInStorageQueue;
         }
+        const uint64_t ingressToStorageUniqueId = shard.m_ingressToStorageNextUniqueIdAtomic.fetch_add(1, boost::memory_order_relaxed);
 
         //force natural/64-bit alignment
-        hdtn::ToStorageHdr * toStorageHdr = new hdtn::ToStorageHdr();
+        hdtn::ToStorageHdr * toStorageHdr = BundleBufferPool::New<hdtn::ToStorageHdr>();
         zmq::message_t zmqMessageToStorageHdrWithDataStolen(toStorageHdr, sizeof(hdtn::ToStorageHdr), CustomCleanupToStorageHdr, toStorageHdr);
 
         //memset 0 not needed because all values set below
         toStorageHdr->base.type = HDTN_MSGTYPE_STORE;
         toStorageHdr->base.flags = 0; //flags not used by storage // static_cast<uint16_t>(primary.flags);
         toStorageHdr->ingressUniqueId = ingressToStorageUniqueId;
+        shm_bundle_descriptor_t shmDescriptor;
+        const bool bundleInSharedMemory = MoveBundleToSharedMemory(*zmqMessageToSendUniquePtr, shmDescriptor);
+        if (bundleInSharedMemory) {
+            toStorageHdr->base.flags |= HDTN_FLAG_BUNDLE_IN_SHARED_MEMORY;
+        }
 
         //zmq::message_t messageWithDataStolen(hdrPtr.get(), sizeof(hdtn::BlockHdr), CustomIgnoreCleanupBlockHdr); //cleanup will occur in the queue below
 
-        //zmq threads not thread safe but protected by mutex above
+        //zmq threads not thread safe but protected by mutex below (shared by all shards)
+        boost::mutex::scoped_lock lockSocket(m_ingressToStorageZmqSocketMutex);
         if (!m_zmqPushSock_boundIngressToConnectingStoragePtr->send(std::move(zmqMessageToStorageHdrWithDataStolen), zmq::send_flags::sndmore | zmq::send_flags::dontwait)) {
             std::cerr << "ingress can't send BlockHdr to storage" << std::endl;
             hdtn::Logger::getInstance()->logError("ingress", "Ingress can't send BlockHdr to storage");
+            if (bundleInSharedMemory) {
+                m_sharedMemoryBundleArenaPtr->Release(shmDescriptor.slabIndex);
+            }
         }
         else {
-            m_storageAckQueue.push(ingressToStorageUniqueId);
+            storageAckingObj.PushMove_ThreadSafe(ingressToStorageUniqueId);
 
             if (!m_zmqPushSock_boundIngressToConnectingStoragePtr->send(std::move(*zmqMessageToSendUniquePtr), zmq::send_flags::dontwait)) {
                 std::cerr << "ingress can't send bundle to storage" << std::endl;
                 hdtn::Logger::getInstance()->logError("ingress", "Ingress can't send bundle to storage");
+                if (bundleInSharedMemory) {
+                    m_sharedMemoryBundleArenaPtr->Release(shmDescriptor.slabIndex);
+                }
             }
             else {
                 //success                            
-                ++m_bundleCountStorage; //protected by m_storageAckQueueMutex
+                m_bundleCountStorage.fetch_add(1, boost::memory_order_relaxed);
             }
         }
     }
@@ -731,39 +1035,46 @@ bool Ingress::ProcessPaddedData(uint8_t * bundleDataBegin, std::size_t bundleCur
 }
 
 
+//Multi-process mode with a shared memory arena: the bundle is copied into a slab (the only copy, instead of the
+//copies through the kernel on both sides of the tcp socket) and the message becomes the slab's descriptor.
+//False (message untouched) if disabled, too big for a slab, or no slab is free, in which case it goes over zmq as before.
+bool Ingress::MoveBundleToSharedMemory(zmq::message_t & zmqMessageBundle, shm_bundle_descriptor_t & descriptor) {
+    if ((!m_sharedMemoryBundleArenaPtr) ||
+        (!m_sharedMemoryBundleArenaPtr->CopyIn(static_cast<const uint8_t*>(zmqMessageBundle.data()), zmqMessageBundle.size(), descriptor)))
+    {
+        return false;
+    }
+    zmqMessageBundle = zmq::message_t(&descriptor, sizeof(descriptor)); //frees the original bundle
+    return true;
+}
+
 void Ingress::WholeBundleReadyCallback(padded_vector_uint8_t & wholeBundleVec) {
     //if more than 1 BpSinkAsync context, must protect shared resources with mutex.  Each BpSinkAsync context has
     //its own processing thread that calls this callback
     static std::unique_ptr<zmq::message_t> unusedZmqPtr;
-    ProcessPaddedData(wholeBundleVec.data(), wholeBundleVec.size(), unusedZmqPtr, wholeBundleVec, false, true);
+    DispatchPaddedData(wholeBundleVec.data(), wholeBundleVec.size(), unusedZmqPtr, wholeBundleVec, false, true);
 }
 
 void Ingress::SendOpportunisticLinkMessages(const uint64_t remoteNodeId, bool isAvailable) {
-    //force natural/64-bit alignment
-    hdtn::ToEgressHdr * toEgressHdr = new hdtn::ToEgressHdr();
-    zmq::message_t zmqMessageToEgressHdrWithDataStolen(toEgressHdr, sizeof(hdtn::ToEgressHdr), CustomCleanupToEgressHdr, toEgressHdr);
-
-    //memset 0 not needed because all values set below
-    toEgressHdr->base.type = isAvailable ? HDTN_MSGTYPE_EGRESS_ADD_OPPORTUNISTIC_LINK : HDTN_MSGTYPE_EGRESS_REMOVE_OPPORTUNISTIC_LINK;
-    toEgressHdr->finalDestEid.nodeId = remoteNodeId; //only used field, rest are don't care
-    {
-        //zmq::message_t messageWithDataStolen(hdrPtr.get(), sizeof(hdtn::BlockHdr), CustomIgnoreCleanupBlockHdr); //cleanup will occur in the queue below
-        boost::mutex::scoped_lock lock(m_ingressToEgressZmqSocketMutex);
-        if (!m_zmqPushSock_boundIngressToConnectingEgressPtr->send(std::move(zmqMessageToEgressHdrWithDataStolen), zmq::send_flags::dontwait)) {
-            std::cerr << "ingress can't send ToEgressHdr Opportunistic link message to egress" << std::endl;
-            hdtn::Logger::getInstance()->logError("ingress", "ingress can't send ToEgressHdr Opportunistic link message to egress");
-        }
+    hdtn::ToEgressHdr toEgressHdr;
+    memset(&toEgressHdr, 0, sizeof(toEgressHdr));
+    toEgressHdr.base.type = isAvailable ? HDTN_MSGTYPE_EGRESS_ADD_OPPORTUNISTIC_LINK : HDTN_MSGTYPE_EGRESS_REMOVE_OPPORTUNISTIC_LINK;
+    toEgressHdr.finalDestEid.nodeId = remoteNodeId; //only used field, rest are don't care
+    zmq::message_t noBundle; //header only
+    if (!m_toEgressChannelSenderPtr->TrySend(toEgressHdr, noBundle)) {
+        std::cerr << "ingress can't send ToEgressHdr Opportunistic link message to egress" << std::endl;
+        hdtn::Logger::getInstance()->logError("ingress", "ingress can't send ToEgressHdr Opportunistic link message to egress");
     }
 
     //force natural/64-bit alignment
-    hdtn::ToStorageHdr * toStorageHdr = new hdtn::ToStorageHdr();
+    hdtn::ToStorageHdr * toStorageHdr = BundleBufferPool::New<hdtn::ToStorageHdr>();
     zmq::message_t zmqMessageToStorageHdrWithDataStolen(toStorageHdr, sizeof(hdtn::ToStorageHdr), CustomCleanupToStorageHdr, toStorageHdr);
 
     //memset 0 not needed because all values set below
     toStorageHdr->base.type = isAvailable ? HDTN_MSGTYPE_STORAGE_ADD_OPPORTUNISTIC_LINK : HDTN_MSGTYPE_STORAGE_REMOVE_OPPORTUNISTIC_LINK;
     toStorageHdr->ingressUniqueId = remoteNodeId; //use this field as the remote node id
     {
-        boost::mutex::scoped_lock lock(m_storageAckQueueMutex);
+        boost::mutex::scoped_lock lock(m_ingressToStorageZmqSocketMutex);
         if (!m_zmqPushSock_boundIngressToConnectingStoragePtr->send(std::move(zmqMessageToStorageHdrWithDataStolen), zmq::send_flags::dontwait)) {
             std::cerr << "ingress can't send ToStorageHdr Opportunistic link message to storage" << std::endl;
             hdtn::Logger::getInstance()->logError("ingress", "ingress can't send ToStorageHdr Opportunistic link message to storage");
@@ -775,14 +1086,20 @@ void Ingress::OnNewOpportunisticLinkCallback(const uint64_t remoteNodeId, Induct
     if (TcpclInduct * tcpclInductPtr = dynamic_cast<TcpclInduct*>(thisInductPtr)) {
         std::cout << "New opportunistic link detected on TcpclV3 induct for ipn:" << remoteNodeId << ".*\n";
         SendOpportunisticLinkMessages(remoteNodeId, true);
-        boost::mutex::scoped_lock lock(m_availableDestOpportunisticNodeIdToTcpclInductMapMutex);
-        m_availableDestOpportunisticNodeIdToTcpclInductMap[remoteNodeId] = tcpclInductPtr;
+        for (std::size_t i = 0; i < m_shards.size(); ++i) {
+            IngressShard & shard = *m_shards[i];
+            boost::mutex::scoped_lock lock(shard.m_availableDestOpportunisticNodeIdToTcpclInductMapMutex);
+            shard.m_availableDestOpportunisticNodeIdToTcpclInductMap[remoteNodeId] = tcpclInductPtr;
+        }
     }
     else if (TcpclV4Induct * tcpclInductPtr = dynamic_cast<TcpclV4Induct*>(thisInductPtr)) {
         std::cout << "New opportunistic link detected on TcpclV4 induct for ipn:" << remoteNodeId << ".*\n";
         SendOpportunisticLinkMessages(remoteNodeId, true);
-        boost::mutex::scoped_lock lock(m_availableDestOpportunisticNodeIdToTcpclInductMapMutex);
-        m_availableDestOpportunisticNodeIdToTcpclInductMap[remoteNodeId] = tcpclInductPtr;
+        for (std::size_t i = 0; i < m_shards.size(); ++i) {
+            IngressShard & shard = *m_shards[i];
+            boost::mutex::scoped_lock lock(shard.m_availableDestOpportunisticNodeIdToTcpclInductMapMutex);
+            shard.m_availableDestOpportunisticNodeIdToTcpclInductMap[remoteNodeId] = tcpclInductPtr;
+        }
     }
     else {
         std::cerr << "error in Ingress::OnNewOpportunisticLinkCallback: Induct ptr cannot cast to TcpclInduct or TcpclV4Induct\n";
@@ -791,8 +1108,11 @@ void Ingress::OnNewOpportunisticLinkCallback(const uint64_t remoteNodeId, Induct
 void Ingress::OnDeletedOpportunisticLinkCallback(const uint64_t remoteNodeId) {
     std::cout << "Deleted opportunistic link on Tcpcl induct for ipn:" << remoteNodeId << ".*\n";
     SendOpportunisticLinkMessages(remoteNodeId, false);
-    boost::mutex::scoped_lock lock(m_availableDestOpportunisticNodeIdToTcpclInductMapMutex);
-    m_availableDestOpportunisticNodeIdToTcpclInductMap.erase(remoteNodeId);
+    for (std::size_t i = 0; i < m_shards.size(); ++i) {
+        IngressShard & shard = *m_shards[i];
+        boost::mutex::scoped_lock lock(shard.m_availableDestOpportunisticNodeIdToTcpclInductMapMutex);
+        shard.m_availableDestOpportunisticNodeIdToTcpclInductMap.erase(remoteNodeId);
+    }
 }
 
 }  // namespace hdtn
@@ -0,0 +1,86 @@
+#include <boost/test/unit_test.hpp>
+#include "EgressToIngressAckingQueue.h"
+#include "EgressScheduler.h"
+#include <vector>
+
+BOOST_AUTO_TEST_CASE(EgressToIngressAckingQueueOutOfOrderAckTestCase)
+{
+    static constexpr std::size_t MAX_PENDING_ACKS = 1;
+    const cbhe_eid_t destA(2, 1);
+    hdtn::EgressToIngressAckingQueue ackingQueue;
+
+    //ingress sends a bulk bundle then an expedited bundle to the same destination
+    EgressScheduler scheduler(1, 1000, 1, 2);
+    std::vector<uint64_t> ackedCustodyIds;
+    for (uint64_t custodyId = 10; custodyId <= 11; ++custodyId) {
+        ackingQueue.PushMove_ThreadSafe(custodyId);
+        hdtn::EgressAckHdr egressAck;
+        memset(&egressAck, 0, sizeof(egressAck));
+        egressAck.finalDestEid = destA;
+        egressAck.custodyId = custodyId;
+        zmq::message_t zmqMessageBundle(1000);
+        scheduler.Push(0, (custodyId == 10) ? 0 : 2, egressAck, zmqMessageBundle);
+    }
+    BOOST_REQUIRE_EQUAL(ackingQueue.GetQueueSize(), 2);
+    BOOST_REQUIRE(!ackingQueue.HasCredit_ThreadSafe(MAX_PENDING_ACKS));
+
+    //egress forwards (and therefore acks) the expedited bundle first
+    hdtn::EgressAckHdr egressAck;
+    zmq::message_t zmqMessageBundle;
+    while (scheduler.Pop(0, egressAck, zmqMessageBundle)) {
+        ackedCustodyIds.push_back(egressAck.custodyId);
+    }
+    BOOST_REQUIRE_EQUAL(ackedCustodyIds.size(), 2);
+    BOOST_REQUIRE_EQUAL(ackedCustodyIds[0], 11);
+    BOOST_REQUIRE_EQUAL(ackedCustodyIds[1], 10);
+
+    //the out of order ack frees its credit instead of being dropped
+    BOOST_REQUIRE_EQUAL(ackingQueue.EraseRange_ThreadSafe(ackedCustodyIds[0], 1), 1);
+    BOOST_REQUIRE_EQUAL(ackingQueue.GetQueueSize(), 1);
+    BOOST_REQUIRE(ackingQueue.HasCredit_ThreadSafe(MAX_PENDING_ACKS));
+    BOOST_REQUIRE_EQUAL(ackingQueue.EraseRange_ThreadSafe(ackedCustodyIds[1], 1), 1);
+    BOOST_REQUIRE_EQUAL(ackingQueue.GetQueueSize(), 0);
+
+    //acking an id that is no longer queued erases nothing
+    BOOST_REQUIRE_EQUAL(ackingQueue.EraseRange_ThreadSafe(10, 2), 0);
+
+    //a batched range may span ids acked in and out of send order
+    for (uint64_t custodyId = 20; custodyId <= 24; ++custodyId) {
+        ackingQueue.PushMove_ThreadSafe(custodyId);
+    }
+    BOOST_REQUIRE_EQUAL(ackingQueue.EraseRange_ThreadSafe(22, 2), 2);
+    BOOST_REQUIRE_EQUAL(ackingQueue.EraseRange_ThreadSafe(20, 5), 3);
+    BOOST_REQUIRE_EQUAL(ackingQueue.GetQueueSize(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(EgressToIngressAckingQueueManyPendingOutOfOrderTestCase)
+{
+    //a deep backlog acked newest first (e.g. expedited bundles overtaking bulk ones) must not cost a search of the pending ids per ack
+    static constexpr uint64_t NUM_PENDING = 200000;
+    hdtn::EgressToIngressAckingQueue ackingQueue;
+    for (uint64_t custodyId = 0; custodyId < NUM_PENDING; ++custodyId) {
+        ackingQueue.PushMove_ThreadSafe(custodyId);
+    }
+    BOOST_REQUIRE_EQUAL(ackingQueue.GetQueueSize(), NUM_PENDING);
+    for (uint64_t i = 0; i < (NUM_PENDING / 2); ++i) { //every odd id, newest first
+        BOOST_REQUIRE_EQUAL(ackingQueue.EraseRange_ThreadSafe(NUM_PENDING - 1 - (2 * i), 1), 1);
+    }
+    BOOST_REQUIRE_EQUAL(ackingQueue.GetQueueSize(), NUM_PENDING / 2);
+
+    //a range over both acked and pending ids erases only the pending ones, and stops at the end of the range
+    BOOST_REQUIRE_EQUAL(ackingQueue.EraseRange_ThreadSafe(100, 10), 5);
+    BOOST_REQUIRE_EQUAL(ackingQueue.EraseRange_ThreadSafe(100, 10), 0);
+    BOOST_REQUIRE_EQUAL(ackingQueue.GetQueueSize(), (NUM_PENDING / 2) - 5);
+    BOOST_REQUIRE(!ackingQueue.HasCredit_ThreadSafe(10));
+
+    //ids pushed out of order (two threads of one shard) and an undone push
+    ackingQueue.PushMove_ThreadSafe(NUM_PENDING + 1);
+    ackingQueue.PushMove_ThreadSafe(NUM_PENDING);
+    ackingQueue.Remove_ThreadSafe(NUM_PENDING + 1);
+    BOOST_REQUIRE_EQUAL(ackingQueue.EraseRange_ThreadSafe(NUM_PENDING, 2), 1);
+
+    //the rest acked in send order
+    BOOST_REQUIRE_EQUAL(ackingQueue.EraseRange_ThreadSafe(0, NUM_PENDING), (NUM_PENDING / 2) - 5);
+    BOOST_REQUIRE_EQUAL(ackingQueue.GetQueueSize(), 0);
+    BOOST_REQUIRE(ackingQueue.HasCredit_ThreadSafe(0));
+}
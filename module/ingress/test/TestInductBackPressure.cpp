@@ -0,0 +1,82 @@
+#include <boost/test/unit_test.hpp>
+#include "InductBackPressure.h"
+#include "EgressToIngressAckingQueue.h"
+#include <vector>
+
+static void RecordBackPressure(std::vector<bool> * setBackPressureCallsPtr, bool backPressureActive) {
+    setBackPressureCallsPtr->push_back(backPressureActive);
+}
+
+static void WaitForCreditThreadFunc(hdtn::InductBackPressure * inductBackPressurePtr, hdtn::EgressToIngressAckingQueue * ackingQueuePtr,
+    const volatile bool * runningPtr, bool * gotCreditPtr)
+{
+    const boost::posix_time::ptime deadline = boost::posix_time::microsec_clock::universal_time() + boost::posix_time::seconds(10);
+    inductBackPressurePtr->BeginWaiting_ThreadSafe();
+    *gotCreditPtr = ackingQueuePtr->WaitForCreditUntil_ThreadSafe(0, deadline, *runningPtr);
+    inductBackPressurePtr->EndWaiting_ThreadSafe();
+}
+
+static void WaitForNumWaiters(hdtn::InductBackPressure & inductBackPressure, const uint64_t numWaiters) {
+    for (unsigned int attempt = 0; (attempt < 1000) && (inductBackPressure.GetNumWaiters_ThreadSafe() != numWaiters); ++attempt) {
+        boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+    }
+    BOOST_REQUIRE_EQUAL(inductBackPressure.GetNumWaiters_ThreadSafe(), numWaiters);
+}
+
+BOOST_AUTO_TEST_CASE(InductBackPressureIsGlobalAcrossPathsTestCase)
+{
+    std::vector<bool> setBackPressureCalls; //only accessed under the InductBackPressure mutex or after the threads are joined
+    hdtn::InductBackPressure inductBackPressure(boost::bind(&RecordBackPressure, &setBackPressureCalls, boost::placeholders::_1));
+    volatile bool running = true;
+
+    //two paths (e.g. an egress final destination and a shard's storage queue), each with its only credit in use
+    hdtn::EgressToIngressAckingQueue ackingQueueA;
+    hdtn::EgressToIngressAckingQueue ackingQueueB;
+    ackingQueueA.PushMove_ThreadSafe(10);
+    ackingQueueB.PushMove_ThreadSafe(20);
+
+    bool gotCreditA = false;
+    bool gotCreditB = false;
+    boost::thread threadA(boost::bind(&WaitForCreditThreadFunc, &inductBackPressure, &ackingQueueA, &running, &gotCreditA));
+    WaitForNumWaiters(inductBackPressure, 1);
+    BOOST_REQUIRE_EQUAL(setBackPressureCalls.size(), 1);
+    BOOST_REQUIRE(setBackPressureCalls[0]); //the first waiter on any path stops every induct
+    boost::thread threadB(boost::bind(&WaitForCreditThreadFunc, &inductBackPressure, &ackingQueueB, &running, &gotCreditB));
+    WaitForNumWaiters(inductBackPressure, 2);
+    BOOST_REQUIRE_EQUAL(setBackPressureCalls.size(), 1); //already applied
+
+    //path A gets its credit back, but the inducts stay stopped while path B is still waiting
+    BOOST_REQUIRE_EQUAL(ackingQueueA.EraseRange_ThreadSafe(10, 1), 1);
+    ackingQueueA.NotifyAll();
+    threadA.join();
+    BOOST_REQUIRE(gotCreditA);
+    BOOST_REQUIRE_EQUAL(inductBackPressure.GetNumWaiters_ThreadSafe(), 1);
+    BOOST_REQUIRE_EQUAL(setBackPressureCalls.size(), 1);
+
+    //the last waiter on any path releases every induct
+    BOOST_REQUIRE_EQUAL(ackingQueueB.EraseRange_ThreadSafe(20, 1), 1);
+    ackingQueueB.NotifyAll();
+    threadB.join();
+    BOOST_REQUIRE(gotCreditB);
+    BOOST_REQUIRE_EQUAL(inductBackPressure.GetNumWaiters_ThreadSafe(), 0);
+    BOOST_REQUIRE_EQUAL(setBackPressureCalls.size(), 2);
+    BOOST_REQUIRE(!setBackPressureCalls[1]);
+    BOOST_REQUIRE_EQUAL(inductBackPressure.GetTotalBackPressureEvents_ThreadSafe(), 1);
+
+    //a waiter interrupted on stopping gives up its credit wait, and once disabled (inducts being destroyed) no induct is told anything
+    ackingQueueA.PushMove_ThreadSafe(11);
+    boost::thread threadStopped(boost::bind(&WaitForCreditThreadFunc, &inductBackPressure, &ackingQueueA, &running, &gotCreditA));
+    WaitForNumWaiters(inductBackPressure, 1);
+    BOOST_REQUIRE_EQUAL(setBackPressureCalls.size(), 3);
+    inductBackPressure.Disable_ThreadSafe();
+    running = false;
+    ackingQueueA.InterruptWait_ThreadSafe();
+    threadStopped.join();
+    BOOST_REQUIRE(!gotCreditA);
+    BOOST_REQUIRE_EQUAL(inductBackPressure.GetNumWaiters_ThreadSafe(), 0);
+    BOOST_REQUIRE_EQUAL(setBackPressureCalls.size(), 3); //never released after being disabled (the inducts are going away)
+    inductBackPressure.BeginWaiting_ThreadSafe();
+    inductBackPressure.EndWaiting_ThreadSafe();
+    BOOST_REQUIRE_EQUAL(setBackPressureCalls.size(), 3);
+    BOOST_REQUIRE_EQUAL(inductBackPressure.GetTotalBackPressureEvents_ThreadSafe(), 2);
+}
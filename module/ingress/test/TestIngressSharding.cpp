@@ -0,0 +1,233 @@
+#include <boost/test/unit_test.hpp>
+#include "ingress.h"
+#include "EgressToIngressAckingQueue.h"
+#include "codec/bpv6.h"
+#include "codec/bpv7.h"
+#include <boost/thread.hpp>
+#include <boost/bind/bind.hpp>
+#include <deque>
+#include <map>
+#include <memory>
+#include <vector>
+
+BOOST_AUTO_TEST_CASE(IngressShardRoutingTestCase)
+{
+    //all services of a node share one shard (per-destination ordering), and every shard gets used
+    const std::vector<std::size_t> numShardsVec = { 1, 3, 4 };
+    for (std::size_t n = 0; n < numShardsVec.size(); ++n) {
+        const std::size_t numShards = numShardsVec[n];
+        std::vector<bool> shardUsed(numShards, false);
+        for (uint64_t nodeId = 1; nodeId <= 20; ++nodeId) {
+            const std::size_t shardIndex = hdtn::Ingress::GetShardIndexByFinalDestEid(cbhe_eid_t(nodeId, 0), numShards);
+            BOOST_REQUIRE_LT(shardIndex, numShards);
+            shardUsed[shardIndex] = true;
+            for (uint64_t serviceId = 1; serviceId <= 3; ++serviceId) {
+                BOOST_REQUIRE_EQUAL(hdtn::Ingress::GetShardIndexByFinalDestEid(cbhe_eid_t(nodeId, serviceId), numShards), shardIndex);
+            }
+        }
+        for (std::size_t i = 0; i < numShards; ++i) {
+            BOOST_REQUIRE(shardUsed[i]);
+        }
+    }
+
+    //unique ids carry their shard so that acks find their way back, and a shard's ids stay contiguous
+    for (std::size_t shardIndex = 0; shardIndex < 4; ++shardIndex) {
+        const uint64_t firstUniqueId = hdtn::Ingress::GetFirstUniqueIdOfShard(shardIndex);
+        BOOST_REQUIRE_EQUAL(hdtn::Ingress::GetShardIndexByUniqueId(firstUniqueId), shardIndex);
+        BOOST_REQUIRE_EQUAL(hdtn::Ingress::GetShardIndexByUniqueId(firstUniqueId + 1000000), shardIndex);
+        if (shardIndex) {
+            BOOST_REQUIRE_EQUAL(hdtn::Ingress::GetShardIndexByUniqueId(firstUniqueId - 1), shardIndex - 1);
+        }
+    }
+
+    //the final destination is decoded from the primary block only
+    {
+        Bpv6CbhePrimaryBlock primary;
+        primary.SetZero();
+        primary.m_bundleProcessingControlFlags = BPV6_BUNDLEFLAG::SINGLETON | BPV6_BUNDLEFLAG::NOFRAGMENT;
+        primary.m_sourceNodeId.Set(1, 1);
+        primary.m_destinationEid.Set(5, 7);
+        primary.m_lifetimeSeconds = 1000;
+        std::vector<uint8_t> serialization(1000);
+        serialization.resize(primary.SerializeBpv6(serialization.data()));
+        cbhe_eid_t finalDestEid;
+        BOOST_REQUIRE(hdtn::Ingress::GetFinalDestEidForSharding(serialization.data(), serialization.size(), finalDestEid));
+        BOOST_REQUIRE(finalDestEid == cbhe_eid_t(5, 7));
+    }
+    {
+        Bpv7CbhePrimaryBlock primary;
+        primary.SetZero();
+        primary.m_sourceNodeId.Set(1, 1);
+        primary.m_destinationEid.Set(6, 8);
+        primary.m_lifetimeMilliseconds = 1000;
+        std::vector<uint8_t> serialization(1000);
+        serialization[0] = ((4U << 5) | 31U); //CBOR indefinite-length array (start of a bpv7 bundle)
+        serialization.resize(1 + primary.SerializeBpv7(&serialization[1]));
+        cbhe_eid_t finalDestEid;
+        BOOST_REQUIRE(hdtn::Ingress::GetFinalDestEidForSharding(serialization.data(), serialization.size(), finalDestEid));
+        BOOST_REQUIRE(finalDestEid == cbhe_eid_t(6, 8));
+    }
+    {
+        std::vector<uint8_t> garbage(10, 0xff);
+        cbhe_eid_t finalDestEid;
+        BOOST_REQUIRE(!hdtn::Ingress::GetFinalDestEidForSharding(garbage.data(), garbage.size(), finalDestEid));
+        BOOST_REQUIRE(!hdtn::Ingress::GetFinalDestEidForSharding(garbage.data(), 0, finalDestEid));
+    }
+}
+
+//stand-in for the ingress shards and egress: each shard thread sends bundles to its destinations using the shard's
+//unique ids and per-destination credits, and the egress thread acks them in ranges routed back by unique id
+struct ShardCreditTestShard {
+    std::map<cbhe_eid_t, hdtn::EgressToIngressAckingQueue> m_egressAckMapQueue;
+    std::vector<cbhe_eid_t> m_destinations;
+};
+struct ShardCreditTestEgress {
+    ShardCreditTestEgress() : m_numShardsRunning(0) {}
+    boost::mutex m_mutex;
+    boost::condition_variable m_conditionVariable;
+    std::deque<std::pair<cbhe_eid_t, uint64_t> > m_queue;
+    unsigned int m_numShardsRunning;
+};
+static const std::size_t SHARD_CREDIT_TEST_MAX_PENDING_ACKS = 5;
+static const uint64_t SHARD_CREDIT_TEST_BUNDLES_PER_SHARD = 3000;
+
+static void ShardCreditTestShardThreadFunc(ShardCreditTestShard * shardPtr, const std::size_t shardIndex, ShardCreditTestEgress * egressPtr, bool * successPtr) {
+    static const volatile bool running = true;
+    uint64_t nextUniqueId = hdtn::Ingress::GetFirstUniqueIdOfShard(shardIndex);
+    for (uint64_t i = 0; i < SHARD_CREDIT_TEST_BUNDLES_PER_SHARD; ++i) {
+        const cbhe_eid_t & finalDestEid = shardPtr->m_destinations[i % shardPtr->m_destinations.size()];
+        hdtn::EgressToIngressAckingQueue & ackingQueue = shardPtr->m_egressAckMapQueue[finalDestEid]; //pre-populated, so only a lookup
+        const boost::posix_time::ptime deadline = boost::posix_time::microsec_clock::universal_time() + boost::posix_time::seconds(10);
+        if (!ackingQueue.WaitForCreditUntil_ThreadSafe(SHARD_CREDIT_TEST_MAX_PENDING_ACKS, deadline, running)) {
+            *successPtr = false; //credits leaked
+            break;
+        }
+        const uint64_t uniqueId = nextUniqueId++;
+        ackingQueue.PushMove_ThreadSafe(uniqueId);
+        {
+            boost::mutex::scoped_lock lock(egressPtr->m_mutex);
+            egressPtr->m_queue.push_back(std::pair<cbhe_eid_t, uint64_t>(finalDestEid, uniqueId));
+        }
+        egressPtr->m_conditionVariable.notify_one();
+    }
+    {
+        boost::mutex::scoped_lock lock(egressPtr->m_mutex);
+        --egressPtr->m_numShardsRunning;
+    }
+    egressPtr->m_conditionVariable.notify_one();
+}
+
+BOOST_AUTO_TEST_CASE(IngressShardCreditAccountingTestCase)
+{
+    static const std::size_t NUM_SHARDS = 3;
+    std::vector<std::unique_ptr<ShardCreditTestShard> > shards;
+    for (std::size_t i = 0; i < NUM_SHARDS; ++i) {
+        shards.push_back(std::unique_ptr<ShardCreditTestShard>(new ShardCreditTestShard()));
+    }
+    for (uint64_t nodeId = 1; nodeId <= 6; ++nodeId) {
+        for (uint64_t serviceId = 1; serviceId <= 2; ++serviceId) {
+            const cbhe_eid_t finalDestEid(nodeId, serviceId);
+            shards[hdtn::Ingress::GetShardIndexByFinalDestEid(finalDestEid, NUM_SHARDS)]->m_destinations.push_back(finalDestEid);
+            shards[hdtn::Ingress::GetShardIndexByFinalDestEid(finalDestEid, NUM_SHARDS)]->m_egressAckMapQueue[finalDestEid];
+        }
+    }
+
+    ShardCreditTestEgress egress;
+    egress.m_numShardsRunning = NUM_SHARDS;
+    bool shardSuccess[NUM_SHARDS];
+    std::vector<std::unique_ptr<boost::thread> > threads;
+    for (std::size_t i = 0; i < NUM_SHARDS; ++i) {
+        shardSuccess[i] = true;
+        threads.push_back(std::unique_ptr<boost::thread>(new boost::thread(
+            boost::bind(&ShardCreditTestShardThreadFunc, shards[i].get(), i, &egress, &shardSuccess[i]))));
+    }
+
+    //egress: ack everything it has received in one batch of ranges, checking that each destination's bundles arrive in send order
+    std::map<cbhe_eid_t, uint64_t> lastUniqueIdPerDest;
+    uint64_t totalAcked = 0;
+    bool inOrder = true;
+    while (true) {
+        std::deque<std::pair<cbhe_eid_t, uint64_t> > received;
+        {
+            boost::mutex::scoped_lock lock(egress.m_mutex);
+            while (egress.m_queue.empty() && egress.m_numShardsRunning) {
+                egress.m_conditionVariable.wait(lock);
+            }
+            if (egress.m_queue.empty()) {
+                break;
+            }
+            received.swap(egress.m_queue);
+        }
+        std::vector<hdtn::IngressAckRange> ranges;
+        for (std::size_t i = 0; i < received.size(); ++i) {
+            const cbhe_eid_t & finalDestEid = received[i].first;
+            const uint64_t uniqueId = received[i].second;
+            std::map<cbhe_eid_t, uint64_t>::iterator it = lastUniqueIdPerDest.find(finalDestEid);
+            if (it != lastUniqueIdPerDest.end()) {
+                inOrder = inOrder && (it->second < uniqueId);
+                it->second = uniqueId;
+            }
+            else {
+                lastUniqueIdPerDest[finalDestEid] = uniqueId;
+            }
+            if ((!ranges.empty()) && (ranges.back().finalDestEid == finalDestEid) && ((ranges.back().firstId + ranges.back().count) == uniqueId)) {
+                ++ranges.back().count;
+            }
+            else {
+                ranges.resize(ranges.size() + 1);
+                ranges.back().finalDestEid = finalDestEid;
+                ranges.back().firstId = uniqueId;
+                ranges.back().count = 1;
+            }
+        }
+        for (std::size_t i = 0; i < ranges.size(); ++i) {
+            const std::size_t shardIndex = hdtn::Ingress::GetShardIndexByUniqueId(ranges[i].firstId);
+            BOOST_REQUIRE_LT(shardIndex, NUM_SHARDS);
+            BOOST_REQUIRE_EQUAL(hdtn::Ingress::GetShardIndexByFinalDestEid(ranges[i].finalDestEid, NUM_SHARDS), shardIndex);
+            hdtn::EgressToIngressAckingQueue & ackingQueue = shards[shardIndex]->m_egressAckMapQueue[ranges[i].finalDestEid];
+            BOOST_REQUIRE_EQUAL(ackingQueue.EraseRange_ThreadSafe(ranges[i].firstId, ranges[i].count), ranges[i].count);
+            ackingQueue.NotifyAll();
+            totalAcked += ranges[i].count;
+        }
+    }
+    for (std::size_t i = 0; i < NUM_SHARDS; ++i) {
+        threads[i]->join();
+        BOOST_REQUIRE(shardSuccess[i]);
+    }
+    BOOST_REQUIRE(inOrder);
+    BOOST_REQUIRE_EQUAL(totalAcked, NUM_SHARDS * SHARD_CREDIT_TEST_BUNDLES_PER_SHARD);
+    BOOST_REQUIRE_EQUAL(lastUniqueIdPerDest.size(), 12);
+    for (std::size_t i = 0; i < NUM_SHARDS; ++i) {
+        for (std::map<cbhe_eid_t, hdtn::EgressToIngressAckingQueue>::iterator it = shards[i]->m_egressAckMapQueue.begin(); it != shards[i]->m_egressAckMapQueue.end(); ++it) {
+            BOOST_REQUIRE_EQUAL(it->second.GetQueueSize(), 0); //every credit returned
+        }
+    }
+}
+
+static void CreditWaitThreadFunc(hdtn::EgressToIngressAckingQueue * ackingQueuePtr, const volatile bool * runningPtr, bool * gotCreditPtr) {
+    const boost::posix_time::ptime deadline = boost::posix_time::microsec_clock::universal_time() + boost::posix_time::seconds(60);
+    *gotCreditPtr = ackingQueuePtr->WaitForCreditUntil_ThreadSafe(0, deadline, *runningPtr);
+}
+
+BOOST_AUTO_TEST_CASE(IngressCreditWaitInterruptedOnStopTestCase)
+{
+    //a thread out of credits must give up as soon as it is told to stop, not when its wait times out
+    hdtn::EgressToIngressAckingQueue ackingQueue;
+    ackingQueue.PushMove_ThreadSafe(1);
+    volatile bool running = true;
+    bool gotCredit = true;
+    const boost::posix_time::ptime startTime = boost::posix_time::microsec_clock::universal_time();
+    boost::thread waitThread(boost::bind(&CreditWaitThreadFunc, &ackingQueue, &running, &gotCredit));
+    boost::this_thread::sleep(boost::posix_time::milliseconds(100));
+    running = false;
+    ackingQueue.InterruptWait_ThreadSafe();
+    waitThread.join();
+    BOOST_REQUIRE(!gotCredit);
+    BOOST_REQUIRE_LT((boost::posix_time::microsec_clock::universal_time() - startTime).total_seconds(), 10);
+
+    //an available credit is still returned while running
+    running = true;
+    BOOST_REQUIRE_EQUAL(ackingQueue.EraseRange_ThreadSafe(1, 1), 1);
+    CreditWaitThreadFunc(&ackingQueue, &running, &gotCredit);
+    BOOST_REQUIRE(gotCredit);
+}
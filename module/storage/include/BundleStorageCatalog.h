@@ -51,6 +51,8 @@ public:
     STORAGE_LIB_EXPORT catalog_entry_t * GetEntryFromCustodyId(const uint64_t custodyId);
     STORAGE_LIB_EXPORT uint64_t * GetCustodyIdFromUuid(const cbhe_bundle_uuid_t & bundleUuid);
     STORAGE_LIB_EXPORT uint64_t * GetCustodyIdFromUuid(const cbhe_bundle_uuid_nofragment_t & bundleUuid);
+    //custody ids (up to maxNumberToFind) of bundles awaiting send whose absolute expiration (seconds since 2000) is within [minExpiration, expiry)
+    STORAGE_LIB_EXPORT uint64_t GetExpiredBundleIds(const uint64_t minExpiration, const uint64_t expiry, const uint64_t maxNumberToFind, std::vector<uint64_t> & returnedIds);
 
 private:
     STORAGE_LIB_NO_EXPORT catalog_entry_t * PopEntryFromAwaitingSend(uint64_t & custodyId,
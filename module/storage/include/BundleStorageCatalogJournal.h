@@ -0,0 +1,97 @@
+#ifndef _BUNDLE_STORAGE_CATALOG_JOURNAL_H
+#define _BUNDLE_STORAGE_CATALOG_JOURNAL_H
+
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <unordered_map>
+#include <vector>
+#include <boost/filesystem.hpp>
+#include "BundleStorageCatalog.h"
+#include "CatalogEntry.h"
+#include "codec/Cbhe.h"
+#include "codec/PrimaryBlock.h"
+#include "storage_lib_export.h"
+
+//Everything needed to put a stored bundle back into the BundleStorageCatalog and MemoryManagerTreeArray
+//without reading any of its segments from disk.
+struct catalog_journal_entry_t {
+    uint64_t custodyId;
+    uint64_t bundleSizeBytes;
+    cbhe_eid_t destEid;
+    uint64_t encodedAbsExpirationAndCustodyAndPriority;
+    uint64_t sequence;
+    cbhe_bundle_uuid_t bundleUuid; //only meaningful with custody (fragmentOffset and dataLength only if also fragmented)
+    segment_id_chain_vec_t segmentIdChainVec;
+};
+
+//The PrimaryBlock fields used by catalog_entry_t::Init and BundleStorageCatalog::CatalogIncomingBundleForStore,
+//recreated from a journal entry.
+class CatalogJournalPrimaryBlock : public PrimaryBlock {
+public:
+    STORAGE_LIB_EXPORT CatalogJournalPrimaryBlock(const catalog_journal_entry_t & entry);
+    STORAGE_LIB_EXPORT virtual bool HasCustodyFlagSet() const;
+    STORAGE_LIB_EXPORT virtual bool HasFragmentationFlagSet() const;
+    STORAGE_LIB_EXPORT virtual cbhe_bundle_uuid_t GetCbheBundleUuidFromPrimary() const;
+    STORAGE_LIB_EXPORT virtual cbhe_bundle_uuid_nofragment_t GetCbheBundleUuidNoFragmentFromPrimary() const;
+    STORAGE_LIB_EXPORT virtual cbhe_eid_t GetFinalDestinationEid() const;
+    STORAGE_LIB_EXPORT virtual uint8_t GetPriority() const;
+    STORAGE_LIB_EXPORT virtual uint64_t GetExpirationSeconds() const;
+    STORAGE_LIB_EXPORT virtual uint64_t GetSequenceForSecondsScale() const;
+    STORAGE_LIB_EXPORT virtual uint64_t GetExpirationMilliseconds() const;
+    STORAGE_LIB_EXPORT virtual uint64_t GetSequenceForMillisecondsScale() const;
+private:
+    const catalog_journal_entry_t & m_entry;
+};
+
+//Append-only log of catalog inserts and removes plus a compacted checkpoint of the live catalog,
+//so that a restart only replays metadata instead of reading and parsing the head of every bundle on disk.
+//Both files carry a generation number: a checkpoint of generation G is followed by a journal of generation G,
+//so a crash between writing a new checkpoint and truncating the journal leaves an older (ignored) journal behind.
+//Every record carries a CRC32C; any truncated, corrupted, or inconsistent file makes Load fail so the caller
+//can fall back to scanning the disks.
+class BundleStorageCatalogJournal {
+private:
+    BundleStorageCatalogJournal();
+public:
+    STORAGE_LIB_EXPORT BundleStorageCatalogJournal(const boost::filesystem::path & journalFilePath);
+    STORAGE_LIB_EXPORT ~BundleStorageCatalogJournal();
+
+    //reads the checkpoint and replays the journal on top of it, entries are returned oldest first
+    STORAGE_LIB_EXPORT bool Load(std::vector<catalog_journal_entry_t> & entries);
+
+    //track (and, once a checkpoint has been written, append) a bundle entering or leaving the catalog
+    STORAGE_LIB_EXPORT bool AppendInsert(const uint64_t custodyId, const catalog_entry_t & catalogEntry);
+    STORAGE_LIB_EXPORT bool AppendRemove(const uint64_t custodyId);
+    STORAGE_LIB_EXPORT void ClearLiveEntries();
+
+    //true once the journal has grown well beyond the live entries it describes
+    STORAGE_LIB_EXPORT bool NeedsCheckpoint() const;
+    //writes every live entry (oldest first) to a new checkpoint, then starts a new empty journal
+    STORAGE_LIB_EXPORT bool WriteCheckpoint(BundleStorageCatalog & catalog);
+    STORAGE_LIB_EXPORT void CloseAndDeleteFiles();
+
+    STORAGE_LIB_EXPORT uint64_t GetNumLiveEntries() const;
+    STORAGE_LIB_EXPORT uint64_t GetNumRecordsSinceCheckpoint() const;
+
+    STORAGE_LIB_EXPORT static bool SerializeInsertRecord(std::vector<uint8_t> & record, const uint64_t custodyId, const catalog_entry_t & catalogEntry);
+
+private:
+    STORAGE_LIB_NO_EXPORT bool AppendRecord(const std::vector<uint8_t> & record);
+    STORAGE_LIB_NO_EXPORT void CloseJournalFile();
+private:
+    const boost::filesystem::path m_journalFilePath;
+    const boost::filesystem::path m_checkpointFilePath;
+    const boost::filesystem::path m_checkpointTmpFilePath;
+    FILE * m_journalFileHandle;
+    uint64_t m_generation;
+    uint64_t m_numRecordsSinceCheckpoint;
+
+    //live custody ids in the order they were inserted (so a checkpoint replays FIFO order within the catalog)
+    uint64_t m_nextInsertOrder;
+    std::map<uint64_t, uint64_t> m_insertOrderToCustodyIdMap;
+    std::unordered_map<uint64_t, uint64_t> m_custodyIdToInsertOrderMap;
+    std::vector<uint8_t> m_recordBuffer;
+};
+
+#endif //_BUNDLE_STORAGE_CATALOG_JOURNAL_H
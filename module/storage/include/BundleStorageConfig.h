@@ -19,6 +19,7 @@
 #define SEGMENT_RESERVED_SPACE (sizeof(uint64_t) + sizeof(uint32_t) + sizeof(uint64_t))
 #define BUNDLE_STORAGE_PER_SEGMENT_SIZE (SEGMENT_SIZE - SEGMENT_RESERVED_SPACE)
 #define READ_CACHE_NUM_SEGMENTS_PER_SESSION 50
+#define RESTORE_READ_AHEAD_NUM_SEGMENTS 256 //each disk is scanned with 1 MiB sequential reads at restore
 
 #ifdef _MSC_VER //Windows tests
 //#define FILE_SIZE (1024000000ULL * 1) //1 GByte total of files, or file_size / num_threads size per file
@@ -50,4 +51,14 @@
 ///////////////////////////
 #define CIRCULAR_INDEX_BUFFER_SIZE 30
 
+///////////////////////////
+//IO_URING (BundleStorageManagerIoUring)
+///////////////////////////
+//segments per disk that can be queued (and in flight) at once, each one a registered segment of the circular buffer
+#define IO_URING_CIRCULAR_INDEX_BUFFER_SIZE 256
+//submission queue entries per disk (operations queued between two io_uring_enter calls)
+#define IO_URING_RING_ENTRIES 32
+//operations per disk submitted but not yet completed (also capped at the completion queue size)
+#define IO_URING_MAX_OPERATIONS_IN_FLIGHT 64
+
 #endif //_BUNDLE_STORAGE_CONFIG_H
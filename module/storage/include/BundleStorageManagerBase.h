@@ -27,6 +27,8 @@
 #include "StorageConfig.h"
 #include "codec/bpv6.h"
 #include "BundleStorageCatalog.h"
+#include "BundleStorageCatalogJournal.h"
+#include <memory>
 
 
 
@@ -52,11 +54,31 @@ struct BundleStorageManagerSession_ReadFromDisk {
     STORAGE_LIB_EXPORT ~BundleStorageManagerSession_ReadFromDisk();
 };
 
+//A bundle read without blocking straight into one caller owned buffer (segment i lands at i * SEGMENT_SIZE),
+//so that the reads of several bundles can be outstanding across the disk threads at once.
+//The buffer must outlive any queued reads (see IsReadAheadIdle).
+struct BundleStorageManagerSession_ReadAhead {
+    catalog_entry_t * catalogEntryPtr;
+    uint64_t custodyId;
+    std::vector<uint8_t> * bufferPtr;
+
+    uint32_t numSegments;
+    uint32_t nextLogicalSegmentToRead; //queued to the disk threads
+    uint32_t numSegmentsRead; //completed in order
+    uint32_t segmentIsReadyCapacity;
+    std::unique_ptr<volatile bool[]> segmentIsReady;
+
+    STORAGE_LIB_EXPORT BundleStorageManagerSession_ReadAhead();
+    STORAGE_LIB_EXPORT ~BundleStorageManagerSession_ReadAhead();
+};
+
 class CLASS_VISIBILITY_STORAGE_LIB BundleStorageManagerBase {
 protected:
     STORAGE_LIB_EXPORT BundleStorageManagerBase();
     STORAGE_LIB_EXPORT BundleStorageManagerBase(const std::string & jsonConfigFileName);
     STORAGE_LIB_EXPORT BundleStorageManagerBase(const StorageConfig_ptr & storageConfigPtr);
+    //circularIndexBufferSize is the number of segments each disk's circular buffer holds
+    STORAGE_LIB_EXPORT BundleStorageManagerBase(const StorageConfig_ptr & storageConfigPtr, const unsigned int circularIndexBufferSize);
 public:
 
     STORAGE_LIB_EXPORT virtual ~BundleStorageManagerBase();
@@ -87,9 +109,34 @@ public:
     STORAGE_LIB_EXPORT uint64_t * GetCustodyIdFromUuid(const cbhe_bundle_uuid_t & bundleUuid);
     STORAGE_LIB_EXPORT uint64_t * GetCustodyIdFromUuid(const cbhe_bundle_uuid_nofragment_t & bundleUuid);
 
+    //expiry
+    STORAGE_LIB_EXPORT uint64_t GetExpiredBundleIds(const uint64_t minExpiration, const uint64_t expiry, const uint64_t maxNumberToFind, std::vector<uint64_t> & returnedIds);
+    //reads only the head segment of a bundle still awaiting send (returns bytes copied to buf, 0 on failure),
+    //leaving the session ready for a subsequent ReadAllSegments of the same bundle
+    STORAGE_LIB_EXPORT std::size_t ReadFirstSegment(BundleStorageManagerSession_ReadFromDisk & session, const uint64_t custodyId, void * buf);
+    STORAGE_LIB_EXPORT bool RemoveAwaitingSendBundleFromDisk(const uint64_t custodyId);
+
+    //Read ahead (pipelined release)
+    STORAGE_LIB_EXPORT uint64_t PopTop(BundleStorageManagerSession_ReadAhead & session, const std::vector<std::pair<cbhe_eid_t, bool> > & availableDests, std::vector<uint8_t> & buf); //0 if empty, size if entry
+    STORAGE_LIB_EXPORT bool ReturnTop(BundleStorageManagerSession_ReadAhead & session);
+    //takes a bundle still awaiting send (e.g. expired) off the queue and starts a read ahead of its first maxSegmentsToRead segments
+    //(0 if not awaiting send, else its size), the bundle is then freed with RemoveReadBundleFromDisk(session.catalogEntryPtr, custodyId)
+    STORAGE_LIB_EXPORT uint64_t PopAwaitingSend(BundleStorageManagerSession_ReadAhead & session, const uint64_t custodyId, const uint32_t maxSegmentsToRead, std::vector<uint8_t> & buf);
+    //(re)starts an idle session reading the first maxSegmentsToRead segments of its bundle into buf
+    STORAGE_LIB_EXPORT void StartReadAhead(BundleStorageManagerSession_ReadAhead & session, const uint32_t maxSegmentsToRead, std::vector<uint8_t> & buf);
+    //queues the next segments in order until a disk's circular buffer is full, returns the number of segments queued
+    STORAGE_LIB_EXPORT uint32_t QueueReadAheadSegments_NoBlock(BundleStorageManagerSession_ReadAhead & session);
+    STORAGE_LIB_EXPORT bool IsReadAheadIdle(BundleStorageManagerSession_ReadAhead & session); //no queued read still outstanding
+    STORAGE_LIB_EXPORT bool IsReadAheadComplete(BundleStorageManagerSession_ReadAhead & session); //all segments read
+    STORAGE_LIB_EXPORT bool WaitForReadAheadProgress(BundleStorageManagerSession_ReadAhead & session, const boost::posix_time::time_duration & timeout);
+    //verifies the segment headers and compacts the buffer in place down to the bundle (or the part of it that was read)
+    STORAGE_LIB_EXPORT bool FinishReadAhead(BundleStorageManagerSession_ReadAhead & session);
+
 
 
     STORAGE_LIB_EXPORT bool RestoreFromDisk(uint64_t * totalBundlesRestored, uint64_t * totalBytesRestored, uint64_t * totalSegmentsRestored);
+    //replays the catalog checkpoint and journal (metadata only), leaves the catalog and memory manager untouched on failure
+    STORAGE_LIB_EXPORT bool RestoreFromCatalogJournal(uint64_t * totalBundlesRestored, uint64_t * totalBytesRestored, uint64_t * totalSegmentsRestored);
 
     STORAGE_LIB_EXPORT const MemoryManagerTreeArray & GetMemoryManagerConstRef();
 
@@ -98,6 +145,8 @@ protected:
 
     
     virtual void NotifyDiskOfWorkToDo_ThreadSafe(const unsigned int diskId) = 0;
+private:
+    STORAGE_LIB_NO_EXPORT void JournalCatalogInsert(const uint64_t custodyId);
 
 protected:
     StorageConfig_ptr m_storageConfigPtr;
@@ -105,9 +154,11 @@ public:
     const unsigned int M_NUM_STORAGE_DISKS;
     const uint64_t M_TOTAL_STORAGE_CAPACITY_BYTES; //old FILE_SIZE
     const uint64_t M_MAX_SEGMENTS;
+    const unsigned int M_CIRCULAR_INDEX_BUFFER_SIZE; //segments per disk
 protected:
     MemoryManagerTreeArray m_memoryManager;
     BundleStorageCatalog m_bundleStorageCatalog;
+    std::unique_ptr<BundleStorageCatalogJournal> m_catalogJournalPtr; //NULL if disabled
     boost::mutex m_mutexMainThread;
     boost::mutex::scoped_lock m_lockMainThread;
     boost::condition_variable m_conditionVariableMainThread;
@@ -119,15 +170,18 @@ protected:
     segment_id_t * m_circularBufferSegmentIdsPtr;
     //volatile bool * volatile m_circularBufferIsReadCompletedPointers[CIRCULAR_INDEX_BUFFER_SIZE * NUM_STORAGE_THREADS];
     //volatile boost::uint8_t * volatile m_circularBufferReadFromStoragePointers[CIRCULAR_INDEX_BUFFER_SIZE * NUM_STORAGE_THREADS];
-    volatile bool * volatile m_circularBufferIsReadCompletedPointers[CIRCULAR_INDEX_BUFFER_SIZE * MAX_NUM_STORAGE_THREADS];
-    volatile uint8_t * volatile m_circularBufferReadFromStoragePointers[CIRCULAR_INDEX_BUFFER_SIZE * MAX_NUM_STORAGE_THREADS];
+    volatile bool * volatile * m_circularBufferIsReadCompletedPointers; //M_CIRCULAR_INDEX_BUFFER_SIZE * M_NUM_STORAGE_DISKS
+    volatile uint8_t * volatile * m_circularBufferReadFromStoragePointers; //M_CIRCULAR_INDEX_BUFFER_SIZE * M_NUM_STORAGE_DISKS
     volatile bool m_autoDeleteFilesOnExit;
+    bool m_allocateContiguousSegments; //set by implementations that issue one disk operation per run of adjacent segments
     
 public:
     bool m_successfullyRestoredFromDisk;
     uint64_t m_totalBundlesRestored;
     uint64_t m_totalBytesRestored;
     uint64_t m_totalSegmentsRestored;
+    bool m_restoredFromCatalogJournal;
+    uint64_t m_restoreDurationMilliseconds;
 };
 
 
@@ -0,0 +1,49 @@
+#ifndef _BUNDLE_STORAGE_MANAGER_IO_URING_H
+#define _BUNDLE_STORAGE_MANAGER_IO_URING_H
+
+#include "BundleStorageManagerBase.h"
+
+//One thread per disk (like BundleStorageManagerMT), but instead of one blocking stdio call per segment,
+//the segments queued in a disk's circular buffer (IO_URING_CIRCULAR_INDEX_BUFFER_SIZE, larger than the other
+//implementations' buffers) are kept in flight at once, up to IO_URING_MAX_OPERATIONS_IN_FLIGHT operations,
+//using io_uring on a file opened with O_DIRECT.  Consecutive circular buffer entries whose file offsets are also consecutive
+//are coalesced into a single submission, and bundles are allocated contiguous segment runs
+//(AllocateContiguousSegments_ThreadSafe) so that each disk extent of a bundle becomes one operation.  The (aligned) circular buffer block data is registered with
+//the ring as a fixed buffer, so writes are issued straight from it and reads land in it before being
+//copied into the session's read cache (which has no O_DIRECT alignment guarantees).
+//When io_uring is unavailable (non-Linux, kernel older than 5.6, or blocked by seccomp) the same coalesced
+//operations are performed synchronously with pread/pwrite, and when the filesystem rejects O_DIRECT
+//the file is opened buffered.  Callers that would rather use BundleStorageManagerMT in that case
+//check IsIoUringSupported() first.
+class CLASS_VISIBILITY_STORAGE_LIB BundleStorageManagerIoUring : public BundleStorageManagerBase {
+public:
+    STORAGE_LIB_EXPORT BundleStorageManagerIoUring();
+    STORAGE_LIB_EXPORT BundleStorageManagerIoUring(const std::string & jsonConfigFileName);
+    STORAGE_LIB_EXPORT BundleStorageManagerIoUring(const StorageConfig_ptr & storageConfigPtr);
+    STORAGE_LIB_EXPORT virtual ~BundleStorageManagerIoUring();
+    STORAGE_LIB_EXPORT virtual void Start();
+
+    //runtime probe: the running kernel can create a ring and supports the read/write opcodes used
+    STORAGE_LIB_EXPORT static bool IsIoUringSupported();
+
+    //valid after Start()
+    STORAGE_LIB_EXPORT bool IsUsingIoUring() const;
+    STORAGE_LIB_EXPORT bool IsUsingDirectIo() const;
+
+private:
+    struct DiskContext;
+    STORAGE_LIB_NO_EXPORT void ThreadFunc(unsigned int threadIndex);
+    STORAGE_LIB_NO_EXPORT virtual void NotifyDiskOfWorkToDo_ThreadSafe(const unsigned int diskId);
+private:
+
+    std::vector<boost::condition_variable> m_conditionVariablesVec;
+    std::vector<std::unique_ptr<boost::thread> > m_threadPtrsVec;
+    std::vector<std::unique_ptr<DiskContext> > m_diskContextPtrsVec;
+
+    volatile bool m_running;
+    bool m_usingIoUring;
+    bool m_usingDirectIo;
+};
+
+
+#endif //_BUNDLE_STORAGE_MANAGER_IO_URING_H
@@ -0,0 +1,82 @@
+#ifndef _EXPIRED_BUNDLE_SWEEP_H
+#define _EXPIRED_BUNDLE_SWEEP_H
+
+#include <cstdint>
+#include <list>
+#include <vector>
+#include "BundleStorageManagerBase.h"
+#include "codec/CustodyIdAllocator.h"
+#include "codec/Cbhe.h"
+#include "storage_lib_export.h"
+
+//write an admin record bundle generated by hdtn (acs custody signal or status report) to disk
+STORAGE_LIB_EXPORT bool WriteAdminRecordBundle(BundleStorageManagerBase & bsm, CustodyIdAllocator & custodyIdAllocator,
+    const PrimaryBlock & primary, const cbhe_eid_t & hdtnSrcEid, const uint8_t * bundleSerialized, const std::size_t bundleSize);
+
+//Bundles awaiting send whose lifetime has expired are erased a bounded slice at a time so that a large backlog
+//of expired bundles never stalls ingress, egress acks, or releases.  Bundles sent to egress or awaiting a custody signal are
+//left alone until they return to the awaiting send state.  Absolute expirations before 2001 can only come from bundles
+//created by a node without a clock (creation time 0), and those are never swept.
+//An expired bundle is taken off the awaiting send queue and read from disk without blocking the storage thread (only its
+//head segment unless a status report for a fragment needs the payload length), its deletion status report is written,
+//and then it is erased.
+class ExpiredBundleSweep {
+private:
+    ExpiredBundleSweep();
+public:
+    static constexpr uint64_t MAX_BUNDLES_PER_SLICE = 64;
+    static constexpr uint64_t MIN_ABS_EXPIRATION_SECONDS = 31536000;
+
+    enum class STATUS_REPORT { NOT_WRITTEN = 0, WRITTEN, NEEDS_WHOLE_BUNDLE };
+
+    STORAGE_LIB_EXPORT ExpiredBundleSweep(BundleStorageManagerBase & bsm, CustodyIdAllocator & custodyIdAllocator,
+        const cbhe_eid_t & hdtnEid, const uint64_t statusReportLifetimeSeconds);
+    STORAGE_LIB_EXPORT ~ExpiredBundleSweep();
+
+    //false while a full slice of expired bundles is still being read (continue the sweep once the reads finish)
+    STORAGE_LIB_EXPORT bool CanStartSlice() const;
+    //takes the bundles awaiting send that expired by nowSecondsSinceEpochRfc5050 off the queue (as many as the slice has room for)
+    //and starts reading them, true if the slice was filled (more expired bundles may remain)
+    STORAGE_LIB_EXPORT bool StartSlice(const uint64_t nowSecondsSinceEpochRfc5050);
+    //writes the deletion status reports of the bundles whose reads have finished and erases them
+    STORAGE_LIB_EXPORT void ProcessFinishedReads();
+    STORAGE_LIB_EXPORT bool IsEmpty() const;
+    STORAGE_LIB_EXPORT std::size_t GetNumBundlesInSlice() const;
+    //blocks until a disk thread completes a read (or the timeout)
+    STORAGE_LIB_EXPORT void WaitForProgress(const boost::posix_time::time_duration & timeout);
+
+    STORAGE_LIB_EXPORT uint64_t GetTotalBundlesErased() const;
+    STORAGE_LIB_EXPORT uint64_t GetTotalDeletionStatusReports() const;
+
+    //RFC 5050 / RFC 9171 "deleted due to lifetime expired" bundle status report for a subject bundle.
+    //subjectBundleBuf holds the head segment of the subject, or the whole subject if isWholeBundle.
+    //The whole subject is only needed if it is a fragment (the payload length goes in the report).
+    STORAGE_LIB_EXPORT static STATUS_REPORT WriteDeletionStatusReport(BundleStorageManagerBase & bsm, CustodyIdAllocator & custodyIdAllocator,
+        std::vector<uint8_t> & subjectBundleBuf, const bool isWholeBundle, const cbhe_eid_t & hdtnEid,
+        const uint64_t statusReportLifetimeSeconds, uint64_t & statusReportSequence);
+
+private:
+    struct read_ahead_t {
+        BundleStorageManagerSession_ReadAhead session;
+        std::vector<uint8_t> buffer;
+        bool readingWholeBundle;
+    };
+
+    bool PopAndStartRead(const uint64_t custodyId);
+    read_ahead_t * GetNextFinished();
+    void Remove(read_ahead_t * readAheadPtr);
+
+    BundleStorageManagerBase & m_bsm;
+    CustodyIdAllocator & m_custodyIdAllocator;
+    const cbhe_eid_t M_HDTN_EID;
+    const uint64_t M_STATUS_REPORT_LIFETIME_SECONDS;
+    uint64_t m_statusReportSequence;
+    uint64_t m_totalBundlesErased;
+    uint64_t m_totalDeletionStatusReports;
+    std::size_t m_numBundles;
+    std::vector<uint64_t> m_expiredCustodyIdsVec;
+    std::list<read_ahead_t> m_readAheadList;
+    std::list<read_ahead_t> m_freeList; //keeps the sessions and buffers allocated for reuse
+};
+
+#endif //_EXPIRED_BUNDLE_SWEEP_H
@@ -13,6 +13,20 @@ typedef std::vector<segment_id_t> segment_id_chain_vec_t;
 
 typedef std::vector< std::vector<uint64_t> > backup_memmanager_t;
 
+//a run of consecutive segments within one disk's file (segment id / number of disks)
+struct disk_segment_extent_t {
+    uint64_t startDiskSegmentIndex;
+    uint64_t numSegments;
+};
+typedef std::vector< std::vector<disk_segment_extent_t> > disk_extents_per_disk_t;
+
+struct memory_manager_fragmentation_stats_t {
+    uint64_t totalFreeSegments;
+    uint64_t numFreeExtents;
+    uint64_t largestFreeExtentSegments;
+    double fragmentation; //1 - (largest free extent / total free), 0 when all free space is one extent
+};
+
 class MemoryManagerTreeArray {
 private:
     MemoryManagerTreeArray();
@@ -21,11 +35,18 @@ public:
     STORAGE_LIB_EXPORT ~MemoryManagerTreeArray();
 
     STORAGE_LIB_EXPORT bool AllocateSegments_ThreadSafe(segment_id_chain_vec_t & segmentVec); //number of segments should be the vector size
+    //same as AllocateSegments_ThreadSafe, but prefers a run of free segments long enough for the whole vector
+    //(next fit, searching from where the previous run ended), so that the segments striped to each disk are
+    //consecutive within that disk's file
+    STORAGE_LIB_EXPORT bool AllocateContiguousSegments_ThreadSafe(segment_id_chain_vec_t & segmentVec); //number of segments should be the vector size
+    STORAGE_LIB_EXPORT static void GetDiskExtents(const segment_id_chain_vec_t & segmentVec, const unsigned int numDisks, disk_extents_per_disk_t & extentsPerDisk);
+    STORAGE_LIB_EXPORT void GetFragmentationStats_ThreadSafe(memory_manager_fragmentation_stats_t & stats);
     STORAGE_LIB_EXPORT bool FreeSegments_ThreadSafe(const segment_id_chain_vec_t & segmentVec);
     STORAGE_LIB_EXPORT bool IsSegmentFree(segment_id_t segmentId);
     STORAGE_LIB_EXPORT void AllocateSegmentId_NoCheck_NotThreadSafe(segment_id_t segmentId);
     STORAGE_LIB_EXPORT void BackupDataToVector(backup_memmanager_t & backup) const;
     STORAGE_LIB_EXPORT bool IsBackupEqual(const backup_memmanager_t & backup) const;
+    STORAGE_LIB_EXPORT uint64_t GetBitMaskMemoryUsageBytes() const;
 
     STORAGE_LIB_EXPORT bool FreeSegmentId_NotThreadSafe(segment_id_t segmentId);
     STORAGE_LIB_EXPORT segment_id_t GetAndSetFirstFreeSegmentId_NotThreadSafe();
@@ -37,11 +58,17 @@ private:
     STORAGE_LIB_NO_EXPORT bool IsSegmentFree(const boost::uint32_t depthIndex, const boost::uint32_t rowIndex, boost::uint32_t segmentId);
     STORAGE_LIB_NO_EXPORT void FreeSegmentId(const boost::uint32_t depthIndex, const boost::uint32_t rowIndex, boost::uint32_t segmentId, bool *success);
     STORAGE_LIB_NO_EXPORT bool AllocateSegmentId_NoCheck(const boost::uint32_t depthIndex, const boost::uint32_t rowIndex, boost::uint32_t segmentId);
+    STORAGE_LIB_NO_EXPORT bool AllocateSegments_NotThreadSafe(segment_id_chain_vec_t & segmentVec);
+    STORAGE_LIB_NO_EXPORT bool FindFreeRun_NotThreadSafe(const uint64_t numSegments, const uint64_t startLeafBlockIndex, const uint64_t endLeafBlockIndex, segment_id_t & runStartSegmentId) const;
+    STORAGE_LIB_NO_EXPORT uint64_t GetLeafFreeMask(const uint64_t leafBlockIndex) const;
+    STORAGE_LIB_NO_EXPORT bool IsLeafBlockGroupFull(const uint64_t leafBlockIndex) const;
     STORAGE_LIB_NO_EXPORT void SetupTree();
     STORAGE_LIB_NO_EXPORT void FreeTree();
 private:
     const boost::uint64_t M_MAX_SEGMENTS;
     boost::uint64_t * m_bitMasks[MAX_TREE_ARRAY_DEPTH];
+    boost::uint64_t m_arraySize64s[MAX_TREE_ARRAY_DEPTH]; //rows per depth, proportional to M_MAX_SEGMENTS
+    boost::uint64_t m_nextFitLeafBlockIndex;
     boost::mutex m_mutex;
 };
 
@@ -0,0 +1,105 @@
+#ifndef _RELEASE_READ_AHEAD_PIPELINE_H
+#define _RELEASE_READ_AHEAD_PIPELINE_H
+
+#include <cstdint>
+#include <list>
+#include <vector>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include "zmq.hpp"
+#include "message.hpp"
+#include "InterModuleChannel.h"
+#include "SharedMemoryBundleArena.h"
+#include "BundleStorageManagerBase.h"
+#include "ReleaseWindowManager.h"
+#include "CustodyTimers.h"
+#include "codec/Cbhe.h"
+#include "storage_lib_export.h"
+
+//Bundle buffers released to egress are recycled when zmq frees them (on a zmq io thread) so that a steady release
+//does not allocate.  A buffer owned by zmq keeps its pool alive since zmq may free the message after storage has stopped.
+class ReleaseBufferPool;
+struct pooled_release_buffer_t {
+    std::vector<uint8_t> data;
+    boost::shared_ptr<ReleaseBufferPool> poolPtr; //only set while owned by zmq
+};
+class ReleaseBufferPool {
+private:
+    ReleaseBufferPool();
+public:
+    STORAGE_LIB_EXPORT ReleaseBufferPool(const std::size_t maxFreeBuffers, const std::size_t maxFreeBufferCapacityBytes);
+    STORAGE_LIB_EXPORT ~ReleaseBufferPool();
+    STORAGE_LIB_EXPORT pooled_release_buffer_t * Get_ThreadSafe();
+    STORAGE_LIB_EXPORT void Return_ThreadSafe(pooled_release_buffer_t * buffer);
+    STORAGE_LIB_EXPORT std::size_t GetNumFreeBuffers_ThreadSafe();
+private:
+    const std::size_t M_MAX_FREE_BUFFERS;
+    const std::size_t M_MAX_FREE_BUFFER_CAPACITY_BYTES;
+    boost::mutex m_mutex;
+    std::vector<pooled_release_buffer_t*> m_freeBuffersVec;
+};
+
+//Keeps the segment reads of several bundles outstanding across the disk threads at once.  Completed bundles are handed
+//to egress in completion order across destinations, but in pop (priority then fifo) order within a destination.
+class ReleaseReadAheadPipeline {
+private:
+    ReleaseReadAheadPipeline();
+public:
+    static constexpr std::size_t DEFAULT_MAX_BUNDLES = 16;
+    static constexpr uint64_t DEFAULT_MAX_BYTES = 64000000;
+
+    enum class READ_AHEAD_STATUS { READING = 0, READY, FAILED, CANCELED };
+    struct read_ahead_t {
+        BundleStorageManagerSession_ReadAhead session;
+        pooled_release_buffer_t * bufferPtr;
+        //copies of the catalog entry, which no longer exists once canceled
+        cbhe_eid_t destEid;
+        uint64_t bundleSizeBytes;
+        bool hasCustody;
+        uint8_t priorityIndex;
+        READ_AHEAD_STATUS status;
+    };
+
+    STORAGE_LIB_EXPORT ReleaseReadAheadPipeline(BundleStorageManagerBase & bsm, const boost::shared_ptr<ReleaseBufferPool> & releaseBufferPoolPtr,
+        const std::size_t maxBundles, const uint64_t maxBytes);
+    STORAGE_LIB_EXPORT ~ReleaseReadAheadPipeline(); //waits for the disk threads still writing into the buffers
+
+    STORAGE_LIB_EXPORT bool IsEmpty() const;
+    STORAGE_LIB_EXPORT bool IsFull() const;
+    STORAGE_LIB_EXPORT std::size_t GetNumBundles() const;
+    STORAGE_LIB_EXPORT uint64_t GetNumBytes() const;
+    //pops the next bundle for the given links and starts reading it, NULL if there is none (or it doesn't fit right now)
+    STORAGE_LIB_EXPORT const read_ahead_t * PopAndStartRead(const std::vector<std::pair<cbhe_eid_t, bool> > & availableDestLinks);
+    //queues the segments of the bundles still being read that didn't fit in the disk queues before
+    STORAGE_LIB_EXPORT void QueueReads_NoBlock();
+    //the catalog entry is about to be erased, so the bundle must never be sent (its buffer is held until its queued reads finish)
+    STORAGE_LIB_EXPORT bool Cancel(const uint64_t custodyId);
+    //Sends the finished bundles to egress and removes them from the pipeline (starting their custody timers), as well as
+    //the failed and canceled bundles, which egress will never ack and are therefore taken out of the release window.
+    //Stops at the first bundle egress can't take right now (egressFull), which stays in the pipeline to be sent later.
+    //Returns the number of bundles removed.
+    STORAGE_LIB_EXPORT std::size_t ProcessFinishedReads_NoBlock(InterModuleChannelSender<hdtn::ToEgressHdr> & toEgressChannelSender,
+        SharedMemoryBundleArena * sharedMemoryBundleArenaPtr, ReleaseWindowManager & releaseWindowManager, CustodyTimers & custodyTimers,
+        std::size_t & totalBundlesSentToEgress, bool & egressFull);
+    //blocks until a disk thread completes a read (or the timeout)
+    STORAGE_LIB_EXPORT void WaitForProgress(const boost::posix_time::time_duration & timeout);
+
+private:
+    read_ahead_t * GetNextFinished();
+    bool SendToEgress_NoBlock(read_ahead_t * readAheadPtr, InterModuleChannelSender<hdtn::ToEgressHdr> & toEgressChannelSender,
+        SharedMemoryBundleArena * sharedMemoryBundleArenaPtr);
+    zmq::message_t MoveToZmqMessage(read_ahead_t * readAheadPtr);
+    void ReclaimUnsentZmqMessageBuffer(read_ahead_t * readAheadPtr, pooled_release_buffer_t * buffer);
+    void Remove(read_ahead_t * readAheadPtr);
+
+    BundleStorageManagerBase & m_bsm;
+    boost::shared_ptr<ReleaseBufferPool> m_releaseBufferPoolPtr;
+    const std::size_t M_MAX_BUNDLES;
+    const uint64_t M_MAX_BYTES;
+    uint64_t m_numBytes;
+    std::list<read_ahead_t> m_readAheadList; //in pop order
+    std::list<read_ahead_t> m_freeList; //keeps the sessions (and their ready flags) allocated for reuse
+    std::vector<cbhe_eid_t> m_blockedDestEidsVec;
+};
+
+#endif //_RELEASE_READ_AHEAD_PIPELINE_H
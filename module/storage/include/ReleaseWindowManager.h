@@ -0,0 +1,79 @@
+#ifndef _RELEASE_WINDOW_MANAGER_H
+#define _RELEASE_WINDOW_MANAGER_H
+
+#include <cstdint>
+#include <map>
+#include <unordered_map>
+#include <vector>
+#include <string>
+#include "codec/Cbhe.h"
+#include "OutductsConfig.h"
+#include <boost/date_time.hpp>
+#include "storage_lib_export.h"
+
+struct release_window_stats_t {
+    std::string name; //outduct name, or the ipn node of an unconfigured (e.g. opportunistic) destination
+    uint64_t bandwidthDelayProductBytes;
+    uint64_t windowBytes;
+    uint64_t bytesInFlight;
+    uint64_t bundlesInFlight;
+    uint64_t smoothedRttMicroseconds;
+    uint64_t totalBundlesReleased;
+    uint64_t totalBytesReleased;
+    uint64_t totalClogEvents;
+    uint64_t totalWindowDecreases;
+};
+
+//Byte-based limit on bundles released from storage to egress but not yet acked by egress, one window per outduct.
+//A window starts at the outduct's configured bandwidth-delay product (rate x round trip time) and then follows egress ack
+//feedback: slow start until the first decrease, then additive increase of about one bundle per window while the window is
+//the limiting factor, and a multiplicative decrease (at most once per smoothed round trip) whenever a released bundle
+//must be retried.  A window always admits one bundle when nothing is in flight so that large bundles are never stuck.
+class ReleaseWindowManager {
+private:
+    ReleaseWindowManager();
+public:
+    STORAGE_LIB_EXPORT ReleaseWindowManager(const OutductsConfig & outductsConfig, const uint64_t minWindowBytes, const uint64_t maxWindowBytes);
+    STORAGE_LIB_EXPORT ~ReleaseWindowManager();
+
+    //true if the window used by this released link still has room (counts a clog event otherwise)
+    STORAGE_LIB_EXPORT bool CanRelease(const cbhe_eid_t & linkEid, const bool isAnyServiceId);
+    //charges the window of the released link the bundle was popped for (the same window CanRelease checked)
+    STORAGE_LIB_EXPORT bool OnReleased(const cbhe_eid_t & linkEid, const bool isAnyServiceId, const uint64_t custodyId, const uint64_t bundleSizeBytes, const boost::posix_time::ptime & nowPtime);
+    STORAGE_LIB_EXPORT bool OnAcked(const uint64_t custodyId, const boost::posix_time::ptime & nowPtime);
+    STORAGE_LIB_EXPORT void OnRetry(const cbhe_eid_t & finalDestEid, const boost::posix_time::ptime & nowPtime);
+    //a released bundle that will never be acked by egress (e.g. erased before its read ahead finished), no window feedback
+    STORAGE_LIB_EXPORT bool OnCanceled(const uint64_t custodyId);
+    //a scheduler link-up rate (bytes/sec) replaces the configured rate used for the bandwidth-delay product
+    STORAGE_LIB_EXPORT void OnReleaseRate(const cbhe_eid_t & linkEid, const uint64_t rateBytesPerSecond);
+
+    STORAGE_LIB_EXPORT std::size_t GetNumBundlesInFlight() const;
+    STORAGE_LIB_EXPORT void GetStats(std::vector<release_window_stats_t> & stats) const;
+    STORAGE_LIB_EXPORT std::string GetStatsString() const;
+
+private:
+    struct window_t {
+        release_window_stats_t stats;
+        uint64_t roundTripMilliseconds; //configured, 0 if unknown
+        uint64_t slowStartThresholdBytes;
+        boost::posix_time::ptime lastDecreasePtime;
+    };
+    struct in_flight_t {
+        std::size_t windowIndex;
+        uint64_t bundleSizeBytes;
+        boost::posix_time::ptime releasedPtime;
+    };
+    STORAGE_LIB_NO_EXPORT std::size_t GetWindowIndex(const cbhe_eid_t & eid, const bool isAnyServiceId);
+    STORAGE_LIB_NO_EXPORT void SetBandwidthDelayProduct(window_t & window, const uint64_t rateBytesPerSecond);
+
+    const uint64_t M_MIN_WINDOW_BYTES;
+    const uint64_t M_MAX_WINDOW_BYTES;
+    std::vector<window_t> m_windowsVec;
+    std::map<cbhe_eid_t, std::size_t> m_finalDestEidToWindowIndexMap;
+    std::map<uint64_t, std::size_t> m_configuredNodeIdToWindowIndexMap; //the first outduct configured for a node, for any service id links
+    std::map<uint64_t, std::size_t> m_unconfiguredNodeIdToWindowIndexMap;
+    std::unordered_map<uint64_t, in_flight_t> m_custodyIdToInFlightMap;
+};
+
+
+#endif //_RELEASE_WINDOW_MANAGER_H
@@ -10,6 +10,10 @@
 #include "stats.hpp"
 #include "zmq.hpp"
 #include "codec/bpv6.h"
+#include "ReleaseWindowManager.h"
+#include "SharedMemoryBundleArena.h"
+#include "InterModuleChannel.h"
+#include "message.hpp"
 #include "storage_lib_export.h"
 
 //addresses for ZMQ IPC transport
@@ -22,14 +26,23 @@ public:
     STORAGE_LIB_EXPORT ZmqStorageInterface();
     STORAGE_LIB_EXPORT ~ZmqStorageInterface();
     STORAGE_LIB_EXPORT void Stop();
-    STORAGE_LIB_EXPORT bool Init(const HdtnConfig & hdtnConfig, zmq::context_t * hdtnOneProcessZmqInprocContextPtr = NULL);
+    //in one-process mode, storageToEgressNativeChannelPtr (if not NULL) replaces the storage to egress inproc socket
+    STORAGE_LIB_EXPORT bool Init(const HdtnConfig & hdtnConfig, zmq::context_t * hdtnOneProcessZmqInprocContextPtr = NULL,
+        InterModuleChannelSender<hdtn::ToEgressHdr> * storageToEgressNativeChannelPtr = NULL);
     STORAGE_LIB_EXPORT std::size_t GetCurrentNumberOfBundlesDeletedFromStorage();
+    //snapshot (refreshed about once per second) of the per outduct release windows to egress
+    STORAGE_LIB_EXPORT void GetReleaseWindowStats(std::vector<release_window_stats_t> & stats);
 
     hdtn::WorkerStats stats() { return m_workerStats; }
 
     std::size_t m_totalBundlesErasedFromStorageNoCustodyTransfer;
     std::size_t m_totalBundlesErasedFromStorageWithCustodyTransfer;
     std::size_t m_totalBundlesSentToEgressFromStorage;
+    std::size_t m_totalBundlesErasedFromStorageExpired;
+    uint64_t m_numExpiredBundleDeletionStatusReports;
+    std::size_t m_totalEventsAllLinksClogged;
+    std::size_t m_totalEventsNoDataInStorageForAvailableLinks;
+    std::size_t m_totalEventsDataInStorageForCloggedLinks;
     uint64_t m_numRfc5050CustodyTransfers;
     uint64_t m_numAcsCustodyTransfers;
     uint64_t m_numAcsPacketsReceived;
@@ -44,6 +57,12 @@ private:
     std::unique_ptr<zmq::socket_t> m_zmqPushSock_connectingStorageToBoundIngressPtr;
 
     std::unique_ptr<zmq::socket_t> m_telemetrySockPtr;
+    //multi-process mode only (NULL if disabled): bundles released to egress go through this arena instead of the tcp socket
+    boost::shared_ptr<SharedMemoryBundleArena> m_sharedMemoryBundleArenaPtr;
+    //bundles to egress go through m_zmqToEgressChannelSenderPtr (over m_zmqPushSock_connectingStorageToBoundEgressPtr)
+    //or the native channel given to Init
+    std::unique_ptr<ZmqInterModuleChannelSender<hdtn::ToEgressHdr> > m_zmqToEgressChannelSenderPtr;
+    InterModuleChannelSender<hdtn::ToEgressHdr> * m_toEgressChannelSenderPtr;
 
     hdtn::StorageStats storageStats;
     HdtnConfig m_hdtnConfig;
@@ -53,6 +72,8 @@ private:
     volatile bool m_running;
     volatile bool m_threadStartupComplete;
     hdtn::WorkerStats m_workerStats;
+    boost::mutex m_releaseWindowStatsMutex;
+    std::vector<release_window_stats_t> m_releaseWindowStatsVec;
 
 private:
     STORAGE_LIB_NO_EXPORT void ThreadFunc();
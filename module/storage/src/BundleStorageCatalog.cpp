@@ -170,7 +170,13 @@ bool BundleStorageCatalog::RemoveEntryFromAwaitingSend(const catalog_entry_t & c
         expirations_to_custids_map_t::iterator expirationsIt = expirationMap.find(catalogEntry.GetAbsExpiration());
         if (expirationsIt != expirationMap.end()) {
             custids_flist_plus_lastiterator_t & custodyIdFlistPlusLastIt = expirationsIt->second;
-            return Remove(custodyIdFlistPlusLastIt, custodyId);
+            if (!Remove(custodyIdFlistPlusLastIt, custodyId)) {
+                return false;
+            }
+            if (custodyIdFlistPlusLastIt.first.empty()) { //PopEntryFromAwaitingSend expects no empty lists
+                expirationMap.erase(expirationsIt);
+            }
+            return true;
         }
     }
     return false;
@@ -340,3 +346,26 @@ uint64_t * BundleStorageCatalog::GetCustodyIdFromUuid(const cbhe_bundle_uuid_t &
 uint64_t * BundleStorageCatalog::GetCustodyIdFromUuid(const cbhe_bundle_uuid_nofragment_t & bundleUuid) {
     return m_uuidNoFragToCustodyIdHashMap.GetValuePtr(bundleUuid);
 }
+uint64_t BundleStorageCatalog::GetExpiredBundleIds(const uint64_t minExpiration, const uint64_t expiry, const uint64_t maxNumberToFind, std::vector<uint64_t> & returnedIds) {
+    returnedIds.resize(0);
+    for (dest_eid_to_priorities_map_t::const_iterator destEidIt = m_destEidToPrioritiesMap.cbegin(); destEidIt != m_destEidToPrioritiesMap.cend(); ++destEidIt) {
+        const priorities_to_expirations_array_t & priorityArray = destEidIt->second;
+        for (std::size_t i = 0; i < NUMBER_OF_PRIORITIES; ++i) {
+            const expirations_to_custids_map_t & expirationMap = priorityArray[i];
+            //the maps are ordered by expiration, so stop at the first one not yet expired
+            for (expirations_to_custids_map_t::const_iterator expirationsIt = expirationMap.lower_bound(minExpiration);
+                (expirationsIt != expirationMap.cend()) && (expirationsIt->first < expiry);
+                ++expirationsIt)
+            {
+                const custids_flist_t & custodyIdFlist = expirationsIt->second.first;
+                for (custids_flist_t::const_iterator it = custodyIdFlist.cbegin(); it != custodyIdFlist.cend(); ++it) {
+                    if (returnedIds.size() >= maxNumberToFind) {
+                        return returnedIds.size();
+                    }
+                    returnedIds.push_back(*it);
+                }
+            }
+        }
+    }
+    return returnedIds.size();
+}
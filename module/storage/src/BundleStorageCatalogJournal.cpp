@@ -0,0 +1,446 @@
+/***************************************************************************
+ * NASA Glenn Research Center, Cleveland, OH
+ * Released under the NASA Open Source Agreement (NOSA)
+ * May  2021
+ *
+ ****************************************************************************
+ */
+
+#include "BundleStorageCatalogJournal.h"
+#include "Logger.h"
+#include "codec/Bpv7Crc.h"
+#include <iostream>
+#include <string>
+#include <cstring>
+#include <algorithm>
+#include <boost/endian/conversion.hpp>
+#include <boost/lexical_cast.hpp>
+
+static const uint64_t JOURNAL_FILE_MAGIC = 0x4c4e4a434e544448ULL; //"HDTNCJNL" little endian
+static const uint64_t CHECKPOINT_FILE_MAGIC = 0x54504b434e544448ULL; //"HDTNCKPT" little endian
+static const uint8_t RECORD_TYPE_INSERT = 1;
+static const uint8_t RECORD_TYPE_REMOVE = 2;
+static const uint32_t INSERT_PAYLOAD_FIXED_SIZE = 1 + (8 * 6) + (8 * 6) + 4; //type, custodyId..sequence, uuid, numSegments
+static const uint32_t REMOVE_PAYLOAD_SIZE = 1 + 8; //type, custodyId
+static const uint32_t MAX_PAYLOAD_SIZE = INSERT_PAYLOAD_FIXED_SIZE + (sizeof(segment_id_t) * (1U << 24)); //sanity limit (64GB bundles) before allocating a corrupted length
+static const uint64_t MIN_RECORDS_BEFORE_CHECKPOINT = 10000;
+
+static void AppendU32(std::vector<uint8_t> & v, const uint32_t x) {
+    const uint32_t xLittle = boost::endian::native_to_little(x);
+    const uint8_t * const p = reinterpret_cast<const uint8_t *>(&xLittle);
+    v.insert(v.end(), p, p + sizeof(xLittle));
+}
+static void AppendU64(std::vector<uint8_t> & v, const uint64_t x) {
+    const uint64_t xLittle = boost::endian::native_to_little(x);
+    const uint8_t * const p = reinterpret_cast<const uint8_t *>(&xLittle);
+    v.insert(v.end(), p, p + sizeof(xLittle));
+}
+static uint32_t ReadU32(const uint8_t * p) {
+    uint32_t x;
+    memcpy(&x, p, sizeof(x));
+    return boost::endian::little_to_native(x);
+}
+static uint64_t ReadU64(const uint8_t * p) {
+    uint64_t x;
+    memcpy(&x, p, sizeof(x));
+    return boost::endian::little_to_native(x);
+}
+
+static void LogJournalError(const std::string & msg) {
+    std::cout << msg << "\n";
+    hdtn::Logger::getInstance()->logError("storage", msg);
+}
+
+//record framing: [u32 payload length][payload][u32 crc32c of payload]
+//returns 1 if a record was read, 0 on a clean end of file, -1 if truncated or corrupted
+static int ReadRecord(FILE * fileHandle, std::vector<uint8_t> & payload) {
+    uint8_t lengthBytes[sizeof(uint32_t)];
+    const std::size_t lengthBytesRead = fread(lengthBytes, 1, sizeof(lengthBytes), fileHandle);
+    if (lengthBytesRead == 0) {
+        return 0;
+    }
+    else if (lengthBytesRead != sizeof(lengthBytes)) {
+        return -1;
+    }
+    const uint32_t payloadLength = ReadU32(lengthBytes);
+    if ((payloadLength == 0) || (payloadLength > MAX_PAYLOAD_SIZE)) {
+        return -1;
+    }
+    payload.resize(payloadLength + sizeof(uint32_t));
+    if (fread(payload.data(), 1, payload.size(), fileHandle) != payload.size()) {
+        return -1;
+    }
+    const uint32_t crc = ReadU32(&payload[payloadLength]);
+    payload.resize(payloadLength);
+    return (Bpv7Crc::Crc32C_Unaligned(payload.data(), payloadLength) == crc) ? 1 : -1;
+}
+
+static bool ParseInsertPayload(const std::vector<uint8_t> & payload, catalog_journal_entry_t & entry) {
+    if ((payload.size() < INSERT_PAYLOAD_FIXED_SIZE) || (payload[0] != RECORD_TYPE_INSERT)) {
+        return false;
+    }
+    const uint8_t * p = &payload[1];
+    entry.custodyId = ReadU64(p); p += 8;
+    entry.bundleSizeBytes = ReadU64(p); p += 8;
+    entry.destEid.nodeId = ReadU64(p); p += 8;
+    entry.destEid.serviceId = ReadU64(p); p += 8;
+    entry.encodedAbsExpirationAndCustodyAndPriority = ReadU64(p); p += 8;
+    entry.sequence = ReadU64(p); p += 8;
+    entry.bundleUuid.creationSeconds = ReadU64(p); p += 8;
+    entry.bundleUuid.sequence = ReadU64(p); p += 8;
+    entry.bundleUuid.srcEid.nodeId = ReadU64(p); p += 8;
+    entry.bundleUuid.srcEid.serviceId = ReadU64(p); p += 8;
+    entry.bundleUuid.fragmentOffset = ReadU64(p); p += 8;
+    entry.bundleUuid.dataLength = ReadU64(p); p += 8;
+    const uint32_t numSegments = ReadU32(p); p += 4;
+    if ((numSegments == 0) || (payload.size() != (INSERT_PAYLOAD_FIXED_SIZE + (static_cast<uint64_t>(numSegments) * sizeof(segment_id_t))))) {
+        return false;
+    }
+    entry.segmentIdChainVec.resize(numSegments);
+    for (uint32_t i = 0; i < numSegments; ++i, p += sizeof(segment_id_t)) {
+        entry.segmentIdChainVec[i] = ReadU32(p);
+    }
+    return true;
+}
+
+static bool ReadFileHeader(FILE * fileHandle, const uint64_t expectedMagic, uint64_t & generation) {
+    uint8_t headerBytes[2 * sizeof(uint64_t)];
+    if (fread(headerBytes, 1, sizeof(headerBytes), fileHandle) != sizeof(headerBytes)) {
+        return false;
+    }
+    generation = ReadU64(&headerBytes[8]);
+    return (ReadU64(&headerBytes[0]) == expectedMagic);
+}
+
+CatalogJournalPrimaryBlock::CatalogJournalPrimaryBlock(const catalog_journal_entry_t & entry) : m_entry(entry) {}
+bool CatalogJournalPrimaryBlock::HasCustodyFlagSet() const {
+    return ((m_entry.encodedAbsExpirationAndCustodyAndPriority & ((1U << 2) | (1U << 3))) != 0);
+}
+bool CatalogJournalPrimaryBlock::HasFragmentationFlagSet() const {
+    return ((m_entry.encodedAbsExpirationAndCustodyAndPriority & (1U << 2)) != 0);
+}
+cbhe_bundle_uuid_t CatalogJournalPrimaryBlock::GetCbheBundleUuidFromPrimary() const {
+    return m_entry.bundleUuid;
+}
+cbhe_bundle_uuid_nofragment_t CatalogJournalPrimaryBlock::GetCbheBundleUuidNoFragmentFromPrimary() const {
+    return cbhe_bundle_uuid_nofragment_t(m_entry.bundleUuid);
+}
+cbhe_eid_t CatalogJournalPrimaryBlock::GetFinalDestinationEid() const {
+    return m_entry.destEid;
+}
+uint8_t CatalogJournalPrimaryBlock::GetPriority() const {
+    return static_cast<uint8_t>(m_entry.encodedAbsExpirationAndCustodyAndPriority & 3);
+}
+uint64_t CatalogJournalPrimaryBlock::GetExpirationSeconds() const {
+    return m_entry.encodedAbsExpirationAndCustodyAndPriority >> 4;
+}
+uint64_t CatalogJournalPrimaryBlock::GetSequenceForSecondsScale() const {
+    return m_entry.sequence;
+}
+uint64_t CatalogJournalPrimaryBlock::GetExpirationMilliseconds() const {
+    return GetExpirationSeconds() * 1000;
+}
+uint64_t CatalogJournalPrimaryBlock::GetSequenceForMillisecondsScale() const {
+    return m_entry.sequence;
+}
+
+BundleStorageCatalogJournal::BundleStorageCatalogJournal(const boost::filesystem::path & journalFilePath) :
+    m_journalFilePath(journalFilePath),
+    m_checkpointFilePath(journalFilePath.string() + ".checkpoint"),
+    m_checkpointTmpFilePath(journalFilePath.string() + ".checkpoint.tmp"),
+    m_journalFileHandle(NULL),
+    m_generation(0),
+    m_numRecordsSinceCheckpoint(0),
+    m_nextInsertOrder(0) {}
+
+BundleStorageCatalogJournal::~BundleStorageCatalogJournal() {
+    CloseJournalFile();
+}
+
+void BundleStorageCatalogJournal::CloseJournalFile() {
+    if (m_journalFileHandle) {
+        fclose(m_journalFileHandle);
+        m_journalFileHandle = NULL;
+    }
+}
+
+void BundleStorageCatalogJournal::CloseAndDeleteFiles() {
+    CloseJournalFile();
+    boost::system::error_code ec;
+    boost::filesystem::remove(m_journalFilePath, ec);
+    boost::filesystem::remove(m_checkpointFilePath, ec);
+    boost::filesystem::remove(m_checkpointTmpFilePath, ec);
+}
+
+uint64_t BundleStorageCatalogJournal::GetNumLiveEntries() const {
+    return m_custodyIdToInsertOrderMap.size();
+}
+
+uint64_t BundleStorageCatalogJournal::GetNumRecordsSinceCheckpoint() const {
+    return m_numRecordsSinceCheckpoint;
+}
+
+void BundleStorageCatalogJournal::ClearLiveEntries() {
+    m_insertOrderToCustodyIdMap.clear();
+    m_custodyIdToInsertOrderMap.clear();
+}
+
+bool BundleStorageCatalogJournal::NeedsCheckpoint() const {
+    return (m_numRecordsSinceCheckpoint >= std::max<uint64_t>(MIN_RECORDS_BEFORE_CHECKPOINT, 2 * GetNumLiveEntries()));
+}
+
+bool BundleStorageCatalogJournal::SerializeInsertRecord(std::vector<uint8_t> & record, const uint64_t custodyId, const catalog_entry_t & catalogEntry) {
+    cbhe_bundle_uuid_t bundleUuid(0, 0, 0, 0, 0, 0);
+    if (catalogEntry.HasCustodyAndFragmentation()) {
+        if (catalogEntry.ptrUuidKeyInMap == NULL) {
+            return false;
+        }
+        bundleUuid = *(static_cast<const cbhe_bundle_uuid_t *>(catalogEntry.ptrUuidKeyInMap));
+    }
+    else if (catalogEntry.HasCustodyAndNonFragmentation()) {
+        if (catalogEntry.ptrUuidKeyInMap == NULL) {
+            return false;
+        }
+        const cbhe_bundle_uuid_nofragment_t & uuidNoFragment = *(static_cast<const cbhe_bundle_uuid_nofragment_t *>(catalogEntry.ptrUuidKeyInMap));
+        bundleUuid.creationSeconds = uuidNoFragment.creationSeconds;
+        bundleUuid.sequence = uuidNoFragment.sequence;
+        bundleUuid.srcEid = uuidNoFragment.srcEid;
+    }
+    const segment_id_chain_vec_t & segmentIdChainVec = catalogEntry.segmentIdChainVec;
+    const uint32_t payloadLength = INSERT_PAYLOAD_FIXED_SIZE + static_cast<uint32_t>(segmentIdChainVec.size() * sizeof(segment_id_t));
+    record.resize(0);
+    record.reserve(payloadLength + (2 * sizeof(uint32_t)));
+    AppendU32(record, payloadLength);
+    record.push_back(RECORD_TYPE_INSERT);
+    AppendU64(record, custodyId);
+    AppendU64(record, catalogEntry.bundleSizeBytes);
+    AppendU64(record, catalogEntry.destEid.nodeId);
+    AppendU64(record, catalogEntry.destEid.serviceId);
+    AppendU64(record, catalogEntry.encodedAbsExpirationAndCustodyAndPriority);
+    AppendU64(record, catalogEntry.sequence);
+    AppendU64(record, bundleUuid.creationSeconds);
+    AppendU64(record, bundleUuid.sequence);
+    AppendU64(record, bundleUuid.srcEid.nodeId);
+    AppendU64(record, bundleUuid.srcEid.serviceId);
+    AppendU64(record, bundleUuid.fragmentOffset);
+    AppendU64(record, bundleUuid.dataLength);
+    AppendU32(record, static_cast<uint32_t>(segmentIdChainVec.size()));
+    for (std::size_t i = 0; i < segmentIdChainVec.size(); ++i) {
+        AppendU32(record, segmentIdChainVec[i]);
+    }
+    AppendU32(record, Bpv7Crc::Crc32C_Unaligned(&record[sizeof(uint32_t)], payloadLength));
+    return true;
+}
+
+bool BundleStorageCatalogJournal::AppendRecord(const std::vector<uint8_t> & record) {
+    if (m_journalFileHandle == NULL) { //still restoring (or a previous write failed), the next checkpoint will capture this
+        return true;
+    }
+    ++m_numRecordsSinceCheckpoint;
+    if ((fwrite(record.data(), 1, record.size(), m_journalFileHandle) == record.size()) && (fflush(m_journalFileHandle) == 0)) {
+        return true;
+    }
+    //the journal no longer describes the catalog, so make sure a restart scans the disks instead
+    LogJournalError("error writing catalog journal " + m_journalFilePath.string() + ", disabling it until the next checkpoint");
+    CloseJournalFile();
+    boost::system::error_code ec;
+    boost::filesystem::remove(m_checkpointFilePath, ec);
+    return false;
+}
+
+bool BundleStorageCatalogJournal::AppendInsert(const uint64_t custodyId, const catalog_entry_t & catalogEntry) {
+    if (!m_custodyIdToInsertOrderMap.emplace(custodyId, m_nextInsertOrder).second) {
+        return false; //already live
+    }
+    m_insertOrderToCustodyIdMap.emplace(m_nextInsertOrder++, custodyId);
+    if (m_journalFileHandle == NULL) {
+        return true;
+    }
+    if (!SerializeInsertRecord(m_recordBuffer, custodyId, catalogEntry)) {
+        return false;
+    }
+    return AppendRecord(m_recordBuffer);
+}
+
+bool BundleStorageCatalogJournal::AppendRemove(const uint64_t custodyId) {
+    std::unordered_map<uint64_t, uint64_t>::iterator it = m_custodyIdToInsertOrderMap.find(custodyId);
+    if (it == m_custodyIdToInsertOrderMap.end()) {
+        return false;
+    }
+    m_insertOrderToCustodyIdMap.erase(it->second);
+    m_custodyIdToInsertOrderMap.erase(it);
+    if (m_journalFileHandle == NULL) {
+        return true;
+    }
+    m_recordBuffer.resize(0);
+    AppendU32(m_recordBuffer, REMOVE_PAYLOAD_SIZE);
+    m_recordBuffer.push_back(RECORD_TYPE_REMOVE);
+    AppendU64(m_recordBuffer, custodyId);
+    AppendU32(m_recordBuffer, Bpv7Crc::Crc32C_Unaligned(&m_recordBuffer[sizeof(uint32_t)], REMOVE_PAYLOAD_SIZE));
+    return AppendRecord(m_recordBuffer);
+}
+
+bool BundleStorageCatalogJournal::WriteCheckpoint(BundleStorageCatalog & catalog) {
+    const uint64_t newGeneration = m_generation + 1;
+    CloseJournalFile();
+
+    FILE * checkpointFileHandle = fopen(m_checkpointTmpFilePath.string().c_str(), "wb");
+    if (checkpointFileHandle == NULL) {
+        LogJournalError("error opening " + m_checkpointTmpFilePath.string() + " for writing a catalog checkpoint");
+        return false;
+    }
+    std::vector<uint8_t> & buf = m_recordBuffer;
+    buf.resize(0);
+    AppendU64(buf, CHECKPOINT_FILE_MAGIC);
+    AppendU64(buf, newGeneration);
+    AppendU64(buf, GetNumLiveEntries());
+    bool success = (fwrite(buf.data(), 1, buf.size(), checkpointFileHandle) == buf.size());
+    for (std::map<uint64_t, uint64_t>::const_iterator it = m_insertOrderToCustodyIdMap.cbegin(); success && (it != m_insertOrderToCustodyIdMap.cend()); ++it) {
+        const uint64_t custodyId = it->second;
+        const catalog_entry_t * const catalogEntryPtr = catalog.GetEntryFromCustodyId(custodyId);
+        success = (catalogEntryPtr != NULL)
+            && SerializeInsertRecord(buf, custodyId, *catalogEntryPtr)
+            && (fwrite(buf.data(), 1, buf.size(), checkpointFileHandle) == buf.size());
+    }
+    success = (fflush(checkpointFileHandle) == 0) && success;
+    success = (fclose(checkpointFileHandle) == 0) && success;
+    if (!success) {
+        LogJournalError("error writing catalog checkpoint " + m_checkpointTmpFilePath.string());
+        return false;
+    }
+    boost::system::error_code ec;
+    boost::filesystem::rename(m_checkpointTmpFilePath, m_checkpointFilePath, ec);
+    if (ec) {
+        LogJournalError("error renaming " + m_checkpointTmpFilePath.string() + ": " + ec.message());
+        return false;
+    }
+
+    //from here on, a journal older than the checkpoint is ignored by Load
+    m_journalFileHandle = fopen(m_journalFilePath.string().c_str(), "wb");
+    if (m_journalFileHandle == NULL) {
+        LogJournalError("error opening catalog journal " + m_journalFilePath.string() + " for writing");
+        boost::filesystem::remove(m_checkpointFilePath, ec);
+        return false;
+    }
+    buf.resize(0);
+    AppendU64(buf, JOURNAL_FILE_MAGIC);
+    AppendU64(buf, newGeneration);
+    if ((fwrite(buf.data(), 1, buf.size(), m_journalFileHandle) != buf.size()) || (fflush(m_journalFileHandle) != 0)) {
+        LogJournalError("error writing catalog journal " + m_journalFilePath.string());
+        CloseJournalFile();
+        boost::filesystem::remove(m_checkpointFilePath, ec);
+        return false;
+    }
+    m_generation = newGeneration;
+    m_numRecordsSinceCheckpoint = 0;
+    return true;
+}
+
+bool BundleStorageCatalogJournal::Load(std::vector<catalog_journal_entry_t> & entries) {
+    entries.clear();
+    std::vector<bool> entryIsLive;
+    std::unordered_map<uint64_t, std::size_t> custodyIdToEntryIndexMap;
+    std::vector<uint8_t> payload;
+
+    if ((!boost::filesystem::exists(m_checkpointFilePath)) || (!boost::filesystem::exists(m_journalFilePath))) {
+        const std::string msg = "catalog journal " + m_journalFilePath.string() + " or its checkpoint does not exist";
+        std::cout << msg << "\n";
+        hdtn::Logger::getInstance()->logNotification("storage", msg);
+        return false;
+    }
+
+    uint64_t checkpointGeneration;
+    {
+        FILE * checkpointFileHandle = fopen(m_checkpointFilePath.string().c_str(), "rb");
+        if (checkpointFileHandle == NULL) {
+            LogJournalError("error opening catalog checkpoint " + m_checkpointFilePath.string());
+            return false;
+        }
+        uint8_t numEntriesBytes[sizeof(uint64_t)];
+        bool success = ReadFileHeader(checkpointFileHandle, CHECKPOINT_FILE_MAGIC, checkpointGeneration)
+            && (fread(numEntriesBytes, 1, sizeof(numEntriesBytes), checkpointFileHandle) == sizeof(numEntriesBytes));
+        const uint64_t numEntries = (success) ? ReadU64(numEntriesBytes) : 0;
+        for (uint64_t i = 0; success && (i < numEntries); ++i) {
+            catalog_journal_entry_t entry;
+            success = (ReadRecord(checkpointFileHandle, payload) == 1)
+                && ParseInsertPayload(payload, entry)
+                && custodyIdToEntryIndexMap.emplace(entry.custodyId, entries.size()).second;
+            if (success) {
+                entries.push_back(std::move(entry));
+                entryIsLive.push_back(true);
+            }
+        }
+        success = success && (ReadRecord(checkpointFileHandle, payload) == 0); //nothing after the last entry
+        fclose(checkpointFileHandle);
+        if (!success) {
+            LogJournalError("error: catalog checkpoint " + m_checkpointFilePath.string() + " is corrupted");
+            entries.clear();
+            return false;
+        }
+    }
+
+    {
+        FILE * journalFileHandle = fopen(m_journalFilePath.string().c_str(), "rb");
+        if (journalFileHandle == NULL) {
+            LogJournalError("error opening catalog journal " + m_journalFilePath.string());
+            entries.clear();
+            return false;
+        }
+        uint64_t journalGeneration;
+        bool success = ReadFileHeader(journalFileHandle, JOURNAL_FILE_MAGIC, journalGeneration) && (journalGeneration <= checkpointGeneration);
+        if (success && (journalGeneration < checkpointGeneration)) {
+            const std::string msg = "catalog journal " + m_journalFilePath.string() + " predates its checkpoint and is ignored";
+            std::cout << msg << "\n";
+            hdtn::Logger::getInstance()->logNotification("storage", msg);
+        }
+        else {
+            while (success) {
+                const int readResult = ReadRecord(journalFileHandle, payload);
+                if (readResult == 0) {
+                    break;
+                }
+                success = (readResult == 1);
+                if (success && (payload[0] == RECORD_TYPE_INSERT)) {
+                    catalog_journal_entry_t entry;
+                    success = ParseInsertPayload(payload, entry)
+                        && custodyIdToEntryIndexMap.emplace(entry.custodyId, entries.size()).second;
+                    if (success) {
+                        entries.push_back(std::move(entry));
+                        entryIsLive.push_back(true);
+                    }
+                }
+                else if (success && (payload[0] == RECORD_TYPE_REMOVE) && (payload.size() == REMOVE_PAYLOAD_SIZE)) {
+                    std::unordered_map<uint64_t, std::size_t>::iterator it = custodyIdToEntryIndexMap.find(ReadU64(&payload[1]));
+                    success = (it != custodyIdToEntryIndexMap.end());
+                    if (success) {
+                        entryIsLive[it->second] = false;
+                        custodyIdToEntryIndexMap.erase(it);
+                    }
+                }
+                else {
+                    success = false;
+                }
+            }
+        }
+        fclose(journalFileHandle);
+        if (!success) {
+            LogJournalError("error: catalog journal " + m_journalFilePath.string() + " is corrupted");
+            entries.clear();
+            return false;
+        }
+    }
+
+    //compact out the removed entries, keeping insertion order
+    std::size_t numLive = 0;
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+        if (entryIsLive[i]) {
+            if (numLive != i) {
+                entries[numLive] = std::move(entries[i]);
+            }
+            ++numLive;
+        }
+    }
+    entries.resize(numLive);
+    m_generation = checkpointGeneration;
+    return true;
+}
@@ -111,10 +111,10 @@ void BundleStorageManagerAsio::TryDiskOperation_Consume_NotThreadSafe(const unsi
         if (consumeIndex != UINT32_MAX) { //if not empty
             m_diskOperationInProgressVec[diskId] = true;
 
-            segment_id_t * const circularBufferSegmentIdsPtr = &m_circularBufferSegmentIdsPtr[diskId * CIRCULAR_INDEX_BUFFER_SIZE];
+            segment_id_t * const circularBufferSegmentIdsPtr = &m_circularBufferSegmentIdsPtr[diskId * M_CIRCULAR_INDEX_BUFFER_SIZE];
 
             const segment_id_t segmentId = circularBufferSegmentIdsPtr[consumeIndex];
-            volatile boost::uint8_t * const readFromStorageDestPointer = m_circularBufferReadFromStoragePointers[diskId * CIRCULAR_INDEX_BUFFER_SIZE + consumeIndex];
+            volatile boost::uint8_t * const readFromStorageDestPointer = m_circularBufferReadFromStoragePointers[diskId * M_CIRCULAR_INDEX_BUFFER_SIZE + consumeIndex];
 
             const bool isWriteToDisk = (readFromStorageDestPointer == NULL);
             if (segmentId == UINT32_MAX) {
@@ -132,7 +132,7 @@ void BundleStorageManagerAsio::TryDiskOperation_Consume_NotThreadSafe(const unsi
 #endif
 
             if (isWriteToDisk) {
-                boost::uint8_t * const circularBufferBlockDataPtr = &m_circularBufferBlockDataPtr[diskId * CIRCULAR_INDEX_BUFFER_SIZE * SEGMENT_SIZE];
+                boost::uint8_t * const circularBufferBlockDataPtr = &m_circularBufferBlockDataPtr[diskId * M_CIRCULAR_INDEX_BUFFER_SIZE * SEGMENT_SIZE];
                 boost::uint8_t * const data = &circularBufferBlockDataPtr[consumeIndex * SEGMENT_SIZE]; //expected data for testing when reading
 #ifdef _WIN32
                 boost::asio::async_write_at(*m_asioHandlePtrsVec[diskId], offsetBytes,
@@ -178,7 +178,7 @@ void BundleStorageManagerAsio::HandleDiskOperationCompleted(const boost::system:
     }
     else {
         if (wasReadOperation) {
-            volatile bool * const isReadCompletedPointer = m_circularBufferIsReadCompletedPointers[diskId * CIRCULAR_INDEX_BUFFER_SIZE + consumeIndex];
+            volatile bool * const isReadCompletedPointer = m_circularBufferIsReadCompletedPointers[diskId * M_CIRCULAR_INDEX_BUFFER_SIZE + consumeIndex];
             *isReadCompletedPointer = true;
         }
         CircularIndexBufferSingleProducerSingleConsumerConfigurable & cb = m_circularIndexBuffersVec[diskId];
@@ -13,6 +13,10 @@
 #include <boost/make_shared.hpp>
 #include <boost/make_unique.hpp>
 #include <boost/endian/conversion.hpp>
+#include <boost/align/aligned_alloc.hpp>
+#include <boost/bind/bind.hpp>
+#include <algorithm>
+#include <unordered_set>
 #include "codec/BundleViewV6.h"
 #include "codec/BundleViewV7.h"
 
@@ -47,6 +51,17 @@ BundleStorageManagerSession_ReadFromDisk::BundleStorageManagerSession_ReadFromDi
 
 BundleStorageManagerSession_ReadFromDisk::~BundleStorageManagerSession_ReadFromDisk() {}
 
+BundleStorageManagerSession_ReadAhead::BundleStorageManagerSession_ReadAhead() :
+    catalogEntryPtr(NULL),
+    custodyId(0),
+    bufferPtr(NULL),
+    numSegments(0),
+    nextLogicalSegmentToRead(0),
+    numSegmentsRead(0),
+    segmentIsReadyCapacity(0) {}
+
+BundleStorageManagerSession_ReadAhead::~BundleStorageManagerSession_ReadAhead() {}
+
 BundleStorageManagerBase::BundleStorageManagerBase() : BundleStorageManagerBase("storageConfig.json") {}
 
 BundleStorageManagerBase::BundleStorageManagerBase(const std::string & jsonConfigFileName) : BundleStorageManagerBase(StorageConfig::CreateFromJsonFile(jsonConfigFileName)) {
@@ -58,28 +73,56 @@ BundleStorageManagerBase::BundleStorageManagerBase(const std::string & jsonConfi
     }
 }
 
-BundleStorageManagerBase::BundleStorageManagerBase(const StorageConfig_ptr & storageConfigPtr) :
+BundleStorageManagerBase::BundleStorageManagerBase(const StorageConfig_ptr & storageConfigPtr) : BundleStorageManagerBase(storageConfigPtr, CIRCULAR_INDEX_BUFFER_SIZE) {}
+
+BundleStorageManagerBase::BundleStorageManagerBase(const StorageConfig_ptr & storageConfigPtr, const unsigned int circularIndexBufferSize) :
     m_storageConfigPtr(storageConfigPtr),
     M_NUM_STORAGE_DISKS((m_storageConfigPtr) ? static_cast<unsigned int>(m_storageConfigPtr->m_storageDiskConfigVector.size()) : 1),
     M_TOTAL_STORAGE_CAPACITY_BYTES((m_storageConfigPtr) ? m_storageConfigPtr->m_totalStorageCapacityBytes : 1),
     M_MAX_SEGMENTS(M_TOTAL_STORAGE_CAPACITY_BYTES / SEGMENT_SIZE),
+    M_CIRCULAR_INDEX_BUFFER_SIZE(circularIndexBufferSize),
     m_memoryManager(M_MAX_SEGMENTS),
     m_lockMainThread(m_mutexMainThread),
     m_filePathsVec(M_NUM_STORAGE_DISKS),
     m_filePathsAsStringVec(M_NUM_STORAGE_DISKS),
-    m_circularIndexBuffersVec(M_NUM_STORAGE_DISKS, CircularIndexBufferSingleProducerSingleConsumerConfigurable(CIRCULAR_INDEX_BUFFER_SIZE)),
+    m_circularIndexBuffersVec(M_NUM_STORAGE_DISKS, CircularIndexBufferSingleProducerSingleConsumerConfigurable(M_CIRCULAR_INDEX_BUFFER_SIZE)),
+    m_circularBufferBlockDataPtr(NULL),
+    m_circularBufferSegmentIdsPtr(NULL),
+    m_circularBufferIsReadCompletedPointers(NULL),
+    m_circularBufferReadFromStoragePointers(NULL),
     m_autoDeleteFilesOnExit((m_storageConfigPtr) ? m_storageConfigPtr->m_autoDeleteFilesOnExit : false),
+    m_allocateContiguousSegments(false),
     m_successfullyRestoredFromDisk(false),
     m_totalBundlesRestored(0),
     m_totalBytesRestored(0),
-    m_totalSegmentsRestored(0)
+    m_totalSegmentsRestored(0),
+    m_restoredFromCatalogJournal(false),
+    m_restoreDurationMilliseconds(0)
 {
     if (!m_storageConfigPtr) {
         return;
     }
 
+    if (!m_storageConfigPtr->m_catalogJournalFilePath.empty()) {
+        m_catalogJournalPtr = boost::make_unique<BundleStorageCatalogJournal>(m_storageConfigPtr->m_catalogJournalFilePath);
+    }
+
     if (m_storageConfigPtr->m_tryToRestoreFromDisk) {
-        m_successfullyRestoredFromDisk = RestoreFromDisk(&m_totalBundlesRestored, &m_totalBytesRestored, &m_totalSegmentsRestored);
+        const boost::posix_time::ptime restoreStartTime = boost::posix_time::microsec_clock::universal_time();
+        //the full segment scan remains the fallback for a missing or corrupted journal
+        m_restoredFromCatalogJournal = (m_catalogJournalPtr) && RestoreFromCatalogJournal(&m_totalBundlesRestored, &m_totalBytesRestored, &m_totalSegmentsRestored);
+        m_successfullyRestoredFromDisk = m_restoredFromCatalogJournal || RestoreFromDisk(&m_totalBundlesRestored, &m_totalBytesRestored, &m_totalSegmentsRestored);
+        m_restoreDurationMilliseconds = static_cast<uint64_t>((boost::posix_time::microsec_clock::universal_time() - restoreStartTime).total_milliseconds());
+        const std::string msg = "restored " + boost::lexical_cast<std::string>(m_totalBundlesRestored) + " bundles "
+            + ((m_restoredFromCatalogJournal) ? "from the catalog journal" : "by scanning the disks")
+            + " in " + boost::lexical_cast<std::string>(m_restoreDurationMilliseconds) + " ms";
+        std::cout << msg << "\n";
+        hdtn::Logger::getInstance()->logNotification("storage", msg);
+    }
+
+    if (m_catalogJournalPtr) {
+        //start the journal over from a checkpoint of whatever was restored (or of nothing)
+        m_catalogJournalPtr->WriteCheckpoint(m_bundleStorageCatalog);
     }
 
 
@@ -96,16 +139,30 @@ BundleStorageManagerBase::BundleStorageManagerBase(const StorageConfig_ptr & sto
         return;
     }
 
-    m_circularBufferBlockDataPtr = (uint8_t*)malloc(CIRCULAR_INDEX_BUFFER_SIZE * M_NUM_STORAGE_DISKS * SEGMENT_SIZE * sizeof(uint8_t));
-    m_circularBufferSegmentIdsPtr = (segment_id_t*)malloc(CIRCULAR_INDEX_BUFFER_SIZE * M_NUM_STORAGE_DISKS * sizeof(segment_id_t));
+    //segment aligned so that implementations may do O_DIRECT io straight from (or into) the circular buffer blocks
+    m_circularBufferBlockDataPtr = (uint8_t*)boost::alignment::aligned_alloc(SEGMENT_SIZE, M_CIRCULAR_INDEX_BUFFER_SIZE * M_NUM_STORAGE_DISKS * SEGMENT_SIZE * sizeof(uint8_t));
+    m_circularBufferSegmentIdsPtr = (segment_id_t*)malloc(M_CIRCULAR_INDEX_BUFFER_SIZE * M_NUM_STORAGE_DISKS * sizeof(segment_id_t));
+    m_circularBufferIsReadCompletedPointers = (volatile bool * volatile *)malloc(M_CIRCULAR_INDEX_BUFFER_SIZE * M_NUM_STORAGE_DISKS * sizeof(volatile bool *));
+    m_circularBufferReadFromStoragePointers = (volatile uint8_t * volatile *)malloc(M_CIRCULAR_INDEX_BUFFER_SIZE * M_NUM_STORAGE_DISKS * sizeof(volatile uint8_t *));
 
 
 }
 
 BundleStorageManagerBase::~BundleStorageManagerBase() {
 
-    free(m_circularBufferBlockDataPtr);
+    if (m_catalogJournalPtr) {
+        if (m_autoDeleteFilesOnExit) {
+            m_catalogJournalPtr->CloseAndDeleteFiles();
+        }
+        else { //clean shutdown, so the next restart only reads the checkpoint
+            m_catalogJournalPtr->WriteCheckpoint(m_bundleStorageCatalog);
+        }
+    }
+
+    boost::alignment::aligned_free(m_circularBufferBlockDataPtr);
     free(m_circularBufferSegmentIdsPtr);
+    free((void*)m_circularBufferIsReadCompletedPointers);
+    free((void*)m_circularBufferReadFromStoragePointers);
 
     for (unsigned int diskId = 0; diskId < M_NUM_STORAGE_DISKS; ++diskId) {
         const boost::filesystem::path & p = m_filePathsVec[diskId];
@@ -124,6 +181,17 @@ const MemoryManagerTreeArray & BundleStorageManagerBase::GetMemoryManagerConstRe
     return m_memoryManager;
 }
 
+void BundleStorageManagerBase::JournalCatalogInsert(const uint64_t custodyId) {
+    if (m_catalogJournalPtr) {
+        if (const catalog_entry_t * const catalogEntryPtr = m_bundleStorageCatalog.GetEntryFromCustodyId(custodyId)) {
+            m_catalogJournalPtr->AppendInsert(custodyId, *catalogEntryPtr);
+            if (m_catalogJournalPtr->NeedsCheckpoint()) {
+                m_catalogJournalPtr->WriteCheckpoint(m_bundleStorageCatalog);
+            }
+        }
+    }
+}
+
 
 uint64_t BundleStorageManagerBase::Push(BundleStorageManagerSession_WriteToDisk & session, const PrimaryBlock & bundlePrimaryBlock, const uint64_t bundleSizeBytes) {
     catalog_entry_t & catalogEntry = session.catalogEntry;
@@ -134,7 +202,12 @@ uint64_t BundleStorageManagerBase::Push(BundleStorageManagerSession_WriteToDisk
     session.nextLogicalSegment = 0;
 
 
-    if (m_memoryManager.AllocateSegments_ThreadSafe(segmentIdChainVec)) {
+    //consecutive segment ids stripe to consecutive offsets on each disk, so an implementation that coalesces
+    //adjacent segments can move the bundle in a few large I/Os (the search for a free run costs more than first free)
+    const bool allocated = (m_allocateContiguousSegments) ?
+        m_memoryManager.AllocateContiguousSegments_ThreadSafe(segmentIdChainVec) :
+        m_memoryManager.AllocateSegments_ThreadSafe(segmentIdChainVec);
+    if (allocated) {
         //std::cout << "firstseg " << segmentIdChainVec[0] << "\n";
         return totalSegmentsRequired;
     }
@@ -163,13 +236,13 @@ int BundleStorageManagerBase::PushSegment(BundleStorageManagerSession_WriteToDis
         produceIndex = cb.GetIndexForWrite();
     }
 
-    uint8_t * const circularBufferBlockDataPtr = &m_circularBufferBlockDataPtr[diskIndex * CIRCULAR_INDEX_BUFFER_SIZE * SEGMENT_SIZE];
-    segment_id_t * const circularBufferSegmentIdsPtr = &m_circularBufferSegmentIdsPtr[diskIndex * CIRCULAR_INDEX_BUFFER_SIZE];
+    uint8_t * const circularBufferBlockDataPtr = &m_circularBufferBlockDataPtr[diskIndex * M_CIRCULAR_INDEX_BUFFER_SIZE * SEGMENT_SIZE];
+    segment_id_t * const circularBufferSegmentIdsPtr = &m_circularBufferSegmentIdsPtr[diskIndex * M_CIRCULAR_INDEX_BUFFER_SIZE];
 
 
     uint8_t * const dataCb = &circularBufferBlockDataPtr[produceIndex * SEGMENT_SIZE];
     circularBufferSegmentIdsPtr[produceIndex] = segmentId;
-    m_circularBufferReadFromStoragePointers[diskIndex * CIRCULAR_INDEX_BUFFER_SIZE + produceIndex] = NULL; //isWriteToDisk = true
+    m_circularBufferReadFromStoragePointers[diskIndex * M_CIRCULAR_INDEX_BUFFER_SIZE + produceIndex] = NULL; //isWriteToDisk = true
 
     storageSegmentHeader.nextSegmentId = (session.nextLogicalSegment == segmentIdChainVec.size()) ? UINT32_MAX : segmentIdChainVec[session.nextLogicalSegment];
     storageSegmentHeader.custodyId = custodyId;
@@ -181,7 +254,9 @@ int BundleStorageManagerBase::PushSegment(BundleStorageManagerSession_WriteToDis
     NotifyDiskOfWorkToDo_ThreadSafe(diskIndex);
     //std::cout << "writing " << size << " bytes\n";
     if (session.nextLogicalSegment == segmentIdChainVec.size()) {
-        m_bundleStorageCatalog.CatalogIncomingBundleForStore(catalogEntry, bundlePrimaryBlock, custodyId, BundleStorageCatalog::DUPLICATE_EXPIRY_ORDER::FIFO);
+        if (m_bundleStorageCatalog.CatalogIncomingBundleForStore(catalogEntry, bundlePrimaryBlock, custodyId, BundleStorageCatalog::DUPLICATE_EXPIRY_ORDER::FIFO)) {
+            JournalCatalogInsert(custodyId);
+        }
         //std::cout << "write complete\n";
     }
 
@@ -285,10 +360,10 @@ std::size_t BundleStorageManagerBase::TopSegment(BundleStorageManagerSession_Rea
         }
 
         session.readCacheIsSegmentReady[session.cacheWriteIndex] = false;
-        m_circularBufferIsReadCompletedPointers[diskIndex * CIRCULAR_INDEX_BUFFER_SIZE + produceIndex] = &session.readCacheIsSegmentReady[session.cacheWriteIndex];
-        m_circularBufferReadFromStoragePointers[diskIndex * CIRCULAR_INDEX_BUFFER_SIZE + produceIndex] = &session.readCache[session.cacheWriteIndex * SEGMENT_SIZE];
+        m_circularBufferIsReadCompletedPointers[diskIndex * M_CIRCULAR_INDEX_BUFFER_SIZE + produceIndex] = &session.readCacheIsSegmentReady[session.cacheWriteIndex];
+        m_circularBufferReadFromStoragePointers[diskIndex * M_CIRCULAR_INDEX_BUFFER_SIZE + produceIndex] = &session.readCache[session.cacheWriteIndex * SEGMENT_SIZE];
         session.cacheWriteIndex = (session.cacheWriteIndex + 1) % READ_CACHE_NUM_SEGMENTS_PER_SESSION;
-        m_circularBufferSegmentIdsPtr[diskIndex * CIRCULAR_INDEX_BUFFER_SIZE + produceIndex] = segmentId;
+        m_circularBufferSegmentIdsPtr[diskIndex * M_CIRCULAR_INDEX_BUFFER_SIZE + produceIndex] = segmentId;
 
         cb.CommitWrite();
         NotifyDiskOfWorkToDo_ThreadSafe(diskIndex);
@@ -380,13 +455,13 @@ bool BundleStorageManagerBase::RemoveReadBundleFromDisk(const catalog_entry_t *
         produceIndex = cb.GetIndexForWrite();
     }
 
-    uint8_t * const circularBufferBlockDataPtr = &m_circularBufferBlockDataPtr[diskIndex * CIRCULAR_INDEX_BUFFER_SIZE * SEGMENT_SIZE];
-    segment_id_t * const circularBufferSegmentIdsPtr = &m_circularBufferSegmentIdsPtr[diskIndex * CIRCULAR_INDEX_BUFFER_SIZE];
+    uint8_t * const circularBufferBlockDataPtr = &m_circularBufferBlockDataPtr[diskIndex * M_CIRCULAR_INDEX_BUFFER_SIZE * SEGMENT_SIZE];
+    segment_id_t * const circularBufferSegmentIdsPtr = &m_circularBufferSegmentIdsPtr[diskIndex * M_CIRCULAR_INDEX_BUFFER_SIZE];
 
 
     uint8_t * const dataCb = &circularBufferBlockDataPtr[produceIndex * SEGMENT_SIZE];
     circularBufferSegmentIdsPtr[produceIndex] = segmentId;
-    m_circularBufferReadFromStoragePointers[diskIndex * CIRCULAR_INDEX_BUFFER_SIZE + produceIndex] = NULL; //isWriteToDisk = true
+    m_circularBufferReadFromStoragePointers[diskIndex * M_CIRCULAR_INDEX_BUFFER_SIZE + produceIndex] = NULL; //isWriteToDisk = true
 
     memcpy(dataCb, &bundleSizeBytesLittleEndian, sizeof(bundleSizeBytesLittleEndian));
 
@@ -395,7 +470,179 @@ bool BundleStorageManagerBase::RemoveReadBundleFromDisk(const catalog_entry_t *
     NotifyDiskOfWorkToDo_ThreadSafe(diskIndex);
 
     const bool successFreedSegments = m_memoryManager.FreeSegments_ThreadSafe(segmentIdChainVec);
-    return (m_bundleStorageCatalog.Remove(custodyId, false).first && successFreedSegments);
+    const bool successRemovedFromCatalog = m_bundleStorageCatalog.Remove(custodyId, false).first;
+    if (successRemovedFromCatalog && m_catalogJournalPtr) {
+        m_catalogJournalPtr->AppendRemove(custodyId);
+    }
+    return (successRemovedFromCatalog && successFreedSegments);
+}
+uint64_t BundleStorageManagerBase::GetExpiredBundleIds(const uint64_t minExpiration, const uint64_t expiry, const uint64_t maxNumberToFind, std::vector<uint64_t> & returnedIds) {
+    return m_bundleStorageCatalog.GetExpiredBundleIds(minExpiration, expiry, maxNumberToFind, returnedIds);
+}
+std::size_t BundleStorageManagerBase::ReadFirstSegment(BundleStorageManagerSession_ReadFromDisk & session, const uint64_t custodyId, void * buf) {
+    session.catalogEntryPtr = m_bundleStorageCatalog.GetEntryFromCustodyId(custodyId);
+    if (session.catalogEntryPtr == NULL) {
+        return 0;
+    }
+    session.custodyId = custodyId;
+    session.nextLogicalSegment = 0;
+    session.nextLogicalSegmentToCache = 0;
+    session.cacheReadIndex = 0;
+    session.cacheWriteIndex = 0;
+
+    //unlike TopSegment, queue only the head so that no read is left in flight into the session's cache
+    const segment_id_t segmentId = session.catalogEntryPtr->segmentIdChainVec[0];
+    const unsigned int diskIndex = segmentId % M_NUM_STORAGE_DISKS;
+    CircularIndexBufferSingleProducerSingleConsumerConfigurable & cb = m_circularIndexBuffersVec[diskIndex];
+    unsigned int produceIndex = cb.GetIndexForWrite();
+    while (produceIndex == UINT32_MAX) { //store the volatile, wait until not full
+        m_conditionVariableMainThread.timed_wait(m_lockMainThread, boost::posix_time::milliseconds(10));
+        produceIndex = cb.GetIndexForWrite();
+    }
+    session.readCacheIsSegmentReady[0] = false;
+    m_circularBufferIsReadCompletedPointers[diskIndex * M_CIRCULAR_INDEX_BUFFER_SIZE + produceIndex] = &session.readCacheIsSegmentReady[0];
+    m_circularBufferReadFromStoragePointers[diskIndex * M_CIRCULAR_INDEX_BUFFER_SIZE + produceIndex] = &session.readCache[0];
+    m_circularBufferSegmentIdsPtr[diskIndex * M_CIRCULAR_INDEX_BUFFER_SIZE + produceIndex] = segmentId;
+    cb.CommitWrite();
+    NotifyDiskOfWorkToDo_ThreadSafe(diskIndex);
+
+    bool readIsReady = session.readCacheIsSegmentReady[0];
+    while (!readIsReady) {
+        m_conditionVariableMainThread.timed_wait(m_lockMainThread, boost::posix_time::milliseconds(10));
+        readIsReady = session.readCacheIsSegmentReady[0];
+    }
+
+    StorageSegmentHeader storageSegmentHeader;
+    memcpy(&storageSegmentHeader, (void*)&session.readCache[0], SEGMENT_RESERVED_SPACE);
+    storageSegmentHeader.ToNativeEndianInplace(); //should optimize out and do nothing
+    if (storageSegmentHeader.bundleSizeBytes != session.catalogEntryPtr->bundleSizeBytes) {
+        const std::string msg = "Error: read head bundle size bytes = " + boost::lexical_cast<std::string>(storageSegmentHeader.bundleSizeBytes) +
+            " does not match catalog bundleSizeBytes = " + boost::lexical_cast<std::string>(session.catalogEntryPtr->bundleSizeBytes);
+        std::cout << msg << "\n";
+        hdtn::Logger::getInstance()->logError("storage", msg);
+        return 0;
+    }
+    const std::size_t size = static_cast<std::size_t>(std::min<uint64_t>(session.catalogEntryPtr->bundleSizeBytes, BUNDLE_STORAGE_PER_SEGMENT_SIZE));
+    memcpy(buf, (void*)&session.readCache[SEGMENT_RESERVED_SPACE], size);
+    return size;
+}
+bool BundleStorageManagerBase::RemoveAwaitingSendBundleFromDisk(const uint64_t custodyId) {
+    const catalog_entry_t * catalogEntryPtr = m_bundleStorageCatalog.GetEntryFromCustodyId(custodyId);
+    if ((catalogEntryPtr == NULL) || (!m_bundleStorageCatalog.RemoveEntryFromAwaitingSend(*catalogEntryPtr, custodyId))) {
+        return false;
+    }
+    return RemoveReadBundleFromDisk(catalogEntryPtr, custodyId);
+}
+
+uint64_t BundleStorageManagerBase::PopTop(BundleStorageManagerSession_ReadAhead & session, const std::vector<std::pair<cbhe_eid_t, bool> > & availableDests, std::vector<uint8_t> & buf) { //0 if empty, size if entry
+    session.catalogEntryPtr = m_bundleStorageCatalog.PopEntryFromAwaitingSend(session.custodyId, availableDests);
+    if (session.catalogEntryPtr == NULL) {
+        return 0;
+    }
+    StartReadAhead(session, UINT32_MAX, buf);
+    return session.catalogEntryPtr->bundleSizeBytes;
+}
+
+uint64_t BundleStorageManagerBase::PopAwaitingSend(BundleStorageManagerSession_ReadAhead & session, const uint64_t custodyId, const uint32_t maxSegmentsToRead, std::vector<uint8_t> & buf) {
+    session.catalogEntryPtr = m_bundleStorageCatalog.GetEntryFromCustodyId(custodyId);
+    if ((session.catalogEntryPtr == NULL) || (!m_bundleStorageCatalog.RemoveEntryFromAwaitingSend(*session.catalogEntryPtr, custodyId))) {
+        session.catalogEntryPtr = NULL;
+        return 0;
+    }
+    session.custodyId = custodyId;
+    StartReadAhead(session, maxSegmentsToRead, buf);
+    return session.catalogEntryPtr->bundleSizeBytes;
+}
+
+void BundleStorageManagerBase::StartReadAhead(BundleStorageManagerSession_ReadAhead & session, const uint32_t maxSegmentsToRead, std::vector<uint8_t> & buf) {
+    session.numSegments = std::min(static_cast<uint32_t>(session.catalogEntryPtr->segmentIdChainVec.size()), maxSegmentsToRead);
+    session.nextLogicalSegmentToRead = 0;
+    session.numSegmentsRead = 0;
+    if (session.segmentIsReadyCapacity < session.numSegments) {
+        session.segmentIsReady.reset(new volatile bool[session.numSegments]);
+        session.segmentIsReadyCapacity = session.numSegments;
+    }
+    buf.resize(static_cast<std::size_t>(session.numSegments) * SEGMENT_SIZE);
+    session.bufferPtr = &buf;
+}
+
+bool BundleStorageManagerBase::ReturnTop(BundleStorageManagerSession_ReadAhead & session) {
+    return ((session.catalogEntryPtr != NULL) && m_bundleStorageCatalog.ReturnEntryToAwaitingSend(*session.catalogEntryPtr, session.custodyId));
+}
+
+uint32_t BundleStorageManagerBase::QueueReadAheadSegments_NoBlock(BundleStorageManagerSession_ReadAhead & session) {
+    const segment_id_chain_vec_t & segments = session.catalogEntryPtr->segmentIdChainVec;
+    uint8_t * const buf = session.bufferPtr->data();
+    uint32_t numQueued = 0;
+    while (session.nextLogicalSegmentToRead < session.numSegments) {
+        const segment_id_t segmentId = segments[session.nextLogicalSegmentToRead];
+        const unsigned int diskIndex = segmentId % M_NUM_STORAGE_DISKS;
+        CircularIndexBufferSingleProducerSingleConsumerConfigurable & cb = m_circularIndexBuffersVec[diskIndex];
+        const unsigned int produceIndex = cb.GetIndexForWrite();
+        if (produceIndex == UINT32_MAX) { //this disk is busy, keep the remaining segments (in order) for a later call
+            break;
+        }
+        session.segmentIsReady[session.nextLogicalSegmentToRead] = false;
+        m_circularBufferIsReadCompletedPointers[diskIndex * M_CIRCULAR_INDEX_BUFFER_SIZE + produceIndex] = &session.segmentIsReady[session.nextLogicalSegmentToRead];
+        m_circularBufferReadFromStoragePointers[diskIndex * M_CIRCULAR_INDEX_BUFFER_SIZE + produceIndex] = &buf[static_cast<std::size_t>(session.nextLogicalSegmentToRead) * SEGMENT_SIZE];
+        m_circularBufferSegmentIdsPtr[diskIndex * M_CIRCULAR_INDEX_BUFFER_SIZE + produceIndex] = segmentId;
+        cb.CommitWrite();
+        NotifyDiskOfWorkToDo_ThreadSafe(diskIndex);
+        ++session.nextLogicalSegmentToRead;
+        ++numQueued;
+    }
+    return numQueued;
+}
+
+bool BundleStorageManagerBase::IsReadAheadIdle(BundleStorageManagerSession_ReadAhead & session) {
+    while ((session.numSegmentsRead < session.nextLogicalSegmentToRead) && session.segmentIsReady[session.numSegmentsRead]) {
+        ++session.numSegmentsRead;
+    }
+    return (session.numSegmentsRead == session.nextLogicalSegmentToRead);
+}
+
+bool BundleStorageManagerBase::IsReadAheadComplete(BundleStorageManagerSession_ReadAhead & session) {
+    return IsReadAheadIdle(session) && (session.numSegmentsRead == session.numSegments);
+}
+
+bool BundleStorageManagerBase::WaitForReadAheadProgress(BundleStorageManagerSession_ReadAhead & session, const boost::posix_time::time_duration & timeout) {
+    if (IsReadAheadIdle(session)) {
+        return true;
+    }
+    m_conditionVariableMainThread.timed_wait(m_lockMainThread, timeout); //woken by any completed read of any disk
+    return IsReadAheadIdle(session);
+}
+
+bool BundleStorageManagerBase::FinishReadAhead(BundleStorageManagerSession_ReadAhead & session) {
+    const segment_id_chain_vec_t & segments = session.catalogEntryPtr->segmentIdChainVec;
+    const uint64_t bundleSizeBytes = session.catalogEntryPtr->bundleSizeBytes;
+    std::vector<uint8_t> & buf = *session.bufferPtr;
+    if ((!IsReadAheadComplete(session)) || (buf.size() != (static_cast<std::size_t>(session.numSegments) * SEGMENT_SIZE))) {
+        return false;
+    }
+    const uint64_t bytesRead = std::min<uint64_t>(bundleSizeBytes, static_cast<uint64_t>(session.numSegments) * BUNDLE_STORAGE_PER_SEGMENT_SIZE);
+    uint64_t totalBytesRemaining = bytesRead;
+    for (uint32_t i = 0; i < session.numSegments; ++i) {
+        StorageSegmentHeader storageSegmentHeader;
+        memcpy(&storageSegmentHeader, &buf[static_cast<std::size_t>(i) * SEGMENT_SIZE], SEGMENT_RESERVED_SPACE);
+        storageSegmentHeader.ToNativeEndianInplace(); //should optimize out and do nothing
+        const uint64_t expectedBundleSizeBytes = (i == 0) ? bundleSizeBytes : UINT64_MAX;
+        const segment_id_t expectedNextSegmentId = ((i + 1) == segments.size()) ? UINT32_MAX : segments[i + 1];
+        if ((storageSegmentHeader.bundleSizeBytes != expectedBundleSizeBytes) || (storageSegmentHeader.nextSegmentId != expectedNextSegmentId)) {
+            const std::string msg = "Error: read ahead segment " + boost::lexical_cast<std::string>(i) + " of custody id " + boost::lexical_cast<std::string>(session.custodyId)
+                + " has bundle size bytes = " + boost::lexical_cast<std::string>(storageSegmentHeader.bundleSizeBytes)
+                + " and nextSegmentId = " + boost::lexical_cast<std::string>(storageSegmentHeader.nextSegmentId);
+            std::cout << msg << "\n";
+            hdtn::Logger::getInstance()->logError("storage", msg);
+            return false;
+        }
+        //segment data only ever moves down over the headers, so compacting in forward order is safe
+        const std::size_t size = static_cast<std::size_t>(std::min<uint64_t>(totalBytesRemaining, BUNDLE_STORAGE_PER_SEGMENT_SIZE));
+        memmove(&buf[static_cast<std::size_t>(i) * BUNDLE_STORAGE_PER_SEGMENT_SIZE], &buf[(static_cast<std::size_t>(i) * SEGMENT_SIZE) + SEGMENT_RESERVED_SPACE], size);
+        totalBytesRemaining -= size;
+    }
+    buf.resize(static_cast<std::size_t>(bytesRead));
+    return (totalBytesRemaining == 0);
 }
 uint64_t * BundleStorageManagerBase::GetCustodyIdFromUuid(const cbhe_bundle_uuid_t & bundleUuid) {
     return m_bundleStorageCatalog.GetCustodyIdFromUuid(bundleUuid);
@@ -407,128 +654,252 @@ uint64_t * BundleStorageManagerBase::GetCustodyIdFromUuid(const cbhe_bundle_uuid
 //	return session.chainInfoVecPtr->front().second.size(); //use the front as new writes will be pushed back
 //}
 
+//what the restore scan keeps of a segment belonging to a bundle that still has a head (kept sorted by segment id per disk)
+struct restore_segment_info_t {
+    uint64_t custodyId;
+    segment_id_t segmentId;
+    segment_id_t nextSegmentId;
+};
+
+struct restore_head_segment_t {
+    catalog_journal_entry_t entry; //segmentIdChainVec is filled in when the chain is merged
+    segment_id_t segmentId;
+    bool primaryLoaded;
+};
+
+static bool RestoreSegmentInfoLessThanSegmentId(const restore_segment_info_t & info, const segment_id_t segmentId) {
+    return info.segmentId < segmentId;
+}
+
+static const restore_segment_info_t * FindRestoreSegmentInfo(const std::vector<restore_segment_info_t> & segmentInfos, const segment_id_t segmentId) {
+    std::vector<restore_segment_info_t>::const_iterator it = std::lower_bound(segmentInfos.begin(), segmentInfos.end(), segmentId,
+        &RestoreSegmentInfoLessThanSegmentId);
+    return ((it != segmentInfos.end()) && (it->segmentId == segmentId)) ? &(*it) : NULL;
+}
+
+//parses the primary block of a head segment into everything the catalog needs
+static bool LoadHeadSegmentPrimary(catalog_journal_entry_t & entry, uint8_t * bundleDataBegin, BundleViewV6 & bv6, BundleViewV7 & bv7) {
+    const uint8_t firstByte = bundleDataBegin[0];
+    const bool isBpVersion6 = (firstByte == 6);
+    const bool isBpVersion7 = (firstByte == ((4U << 5) | 31U));  //CBOR major type 4, additional information 31 (Indefinite-Length Array)
+    PrimaryBlock * primaryBasePtr;
+    if (isBpVersion6) {
+        if (!bv6.LoadBundle(bundleDataBegin, BUNDLE_STORAGE_PER_SEGMENT_SIZE, true)) { //load primary only
+            return false;
+        }
+        primaryBasePtr = &bv6.m_primaryBlockView.header;
+    }
+    else if (isBpVersion7) {
+        if (!bv7.LoadBundle(bundleDataBegin, BUNDLE_STORAGE_PER_SEGMENT_SIZE, true, true)) { //load primary only
+            return false;
+        }
+        primaryBasePtr = &bv7.m_primaryBlockView.header;
+    }
+    else {
+        return false;
+    }
+    catalog_entry_t catalogEntry;
+    catalogEntry.Init(*primaryBasePtr, entry.bundleSizeBytes, 0, NULL);
+    entry.destEid = catalogEntry.destEid;
+    entry.encodedAbsExpirationAndCustodyAndPriority = catalogEntry.encodedAbsExpirationAndCustodyAndPriority;
+    entry.sequence = catalogEntry.sequence;
+    entry.bundleUuid = cbhe_bundle_uuid_t(0, 0, 0, 0, 0, 0);
+    if (catalogEntry.HasCustodyAndFragmentation()) {
+        entry.bundleUuid = primaryBasePtr->GetCbheBundleUuidFromPrimary();
+    }
+    else if (catalogEntry.HasCustodyAndNonFragmentation()) {
+        const cbhe_bundle_uuid_nofragment_t uuidNoFragment = primaryBasePtr->GetCbheBundleUuidNoFragmentFromPrimary();
+        entry.bundleUuid.creationSeconds = uuidNoFragment.creationSeconds;
+        entry.bundleUuid.sequence = uuidNoFragment.sequence;
+        entry.bundleUuid.srcEid = uuidNoFragment.srcEid;
+    }
+    return true;
+}
+
+//runs in its own thread per disk: reads the whole store file front to back in large chunks.
+//The first pass (liveCustodyIdsPtr NULL) parses every head segment.  Removed bundles only have their head destroyed,
+//so the second pass keeps just the headers of segments whose custody id has a head, and memory follows the segments
+//in use rather than the size of the store files.
+static void RestoreScanDiskThreadFunc(const std::string filePath, const unsigned int diskId, const unsigned int numDisks, const uint64_t numSegmentsToScan,
+    const std::unordered_set<uint64_t> * liveCustodyIdsPtr, std::vector<restore_head_segment_t> & headSegments, std::vector<restore_segment_info_t> & segmentInfos,
+    uint8_t & success)
+{
+    success = 0;
+    FILE * const fileHandle = fopen(filePath.c_str(), "rbS");
+    if (fileHandle == NULL) {
+        const std::string msg = "Error opening file " + filePath + " for reading and restoring";
+        std::cout << msg << "\n";
+        hdtn::Logger::getInstance()->logError("storage", msg);
+        return;
+    }
+    setvbuf(fileHandle, NULL, _IONBF, 0); //reads are already large, skip the extra copy through the stdio buffer
+
+    std::unique_ptr<uint8_t[]> readAheadBuf(new uint8_t[RESTORE_READ_AHEAD_NUM_SEGMENTS * SEGMENT_SIZE]);
+    BundleViewV6 bv6;
+    BundleViewV7 bv7;
+    for (uint64_t localSegmentIndex = 0; localSegmentIndex < numSegmentsToScan; ) {
+        const uint64_t numSegmentsThisRead = std::min<uint64_t>(RESTORE_READ_AHEAD_NUM_SEGMENTS, numSegmentsToScan - localSegmentIndex);
+        const std::size_t bytesToRead = static_cast<std::size_t>(numSegmentsThisRead * SEGMENT_SIZE);
+        const std::size_t bytesReadFromFread = fread(readAheadBuf.get(), 1, bytesToRead, fileHandle);
+        if (bytesReadFromFread != bytesToRead) {
+            const std::string msg = "Error reading at offset " + boost::lexical_cast<std::string>(localSegmentIndex * SEGMENT_SIZE) +
+                " for disk " + boost::lexical_cast<std::string>(diskId) + " bytesread " + boost::lexical_cast<std::string>(bytesReadFromFread);
+            std::cout << msg << "\n";
+            hdtn::Logger::getInstance()->logError("storage", msg);
+            fclose(fileHandle);
+            return;
+        }
+        for (uint64_t i = 0; i < numSegmentsThisRead; ++i, ++localSegmentIndex) {
+            uint8_t * const segmentData = &readAheadBuf[i * SEGMENT_SIZE];
+            StorageSegmentHeader storageSegmentHeader;
+            memcpy(&storageSegmentHeader, segmentData, SEGMENT_RESERVED_SPACE);
+            storageSegmentHeader.ToNativeEndianInplace(); //should optimize out and do nothing
+
+            const segment_id_t segmentId = static_cast<segment_id_t>(localSegmentIndex * numDisks + diskId);
+            if (liveCustodyIdsPtr) {
+                if (liveCustodyIdsPtr->count(storageSegmentHeader.custodyId)) {
+                    segmentInfos.emplace_back();
+                    restore_segment_info_t & info = segmentInfos.back();
+                    info.custodyId = storageSegmentHeader.custodyId;
+                    info.segmentId = segmentId;
+                    info.nextSegmentId = storageSegmentHeader.nextSegmentId;
+                }
+            }
+            else if (storageSegmentHeader.bundleSizeBytes != UINT64_MAX) { //potential head segment
+                headSegments.emplace_back();
+                restore_head_segment_t & head = headSegments.back();
+                head.entry.custodyId = storageSegmentHeader.custodyId;
+                head.entry.bundleSizeBytes = storageSegmentHeader.bundleSizeBytes;
+                head.segmentId = segmentId;
+                head.primaryLoaded = LoadHeadSegmentPrimary(head.entry, segmentData + SEGMENT_RESERVED_SPACE, bv6, bv7);
+            }
+        }
+    }
+    fclose(fileHandle);
+    success = 1;
+}
+
 bool BundleStorageManagerBase::RestoreFromDisk(uint64_t * totalBundlesRestored, uint64_t * totalBytesRestored, uint64_t * totalSegmentsRestored) {
     *totalBundlesRestored = 0; *totalBytesRestored = 0; *totalSegmentsRestored = 0;
-    uint8_t dataReadBuf[SEGMENT_SIZE];
-    std::vector<FILE *> fileHandlesVec(M_NUM_STORAGE_DISKS);
-    std::vector <uint64_t> fileSizesVec(M_NUM_STORAGE_DISKS);
+    std::vector<uint64_t> numSegmentsToScanVec(M_NUM_STORAGE_DISKS);
+    uint64_t numSegmentIds = 0; //one past the highest segment id found on any disk
+    uint64_t endOfRestoreSegmentId = UINT64_MAX; //the first potential head segment id that lies beyond the end of its file
     for (unsigned int diskId = 0; diskId < M_NUM_STORAGE_DISKS; ++diskId) {
         const char * const filePath = m_storageConfigPtr->m_storageDiskConfigVector[diskId].storeFilePath.c_str();
         const boost::filesystem::path p(filePath);
-        if (boost::filesystem::exists(p)) {
-            fileSizesVec[diskId] = boost::filesystem::file_size(p);
-            const std::string msg = "diskId " + boost::lexical_cast<std::string>(diskId)
-                + " has file size of " + boost::lexical_cast<std::string>(fileSizesVec[diskId]);
-            std::cout << msg << "\n";
-            hdtn::Logger::getInstance()->logInfo("storage", msg);
-        }
-        else {
+        if (!boost::filesystem::exists(p)) {
             const std::string msg = "Error: " + boost::lexical_cast<std::string>(filePath) + " does not exist";
             std::cout << msg << "\n";
             hdtn::Logger::getInstance()->logError("storage", msg);
             return false;
         }
-        fileHandlesVec[diskId] = fopen(filePath, "rbR");
-        if (fileHandlesVec[diskId] == NULL) {
-            const std::string msg = "Error opening file " + std::string(filePath) +
-                " for reading and restoring";
+        const uint64_t fileSize = boost::filesystem::file_size(p);
+        const std::string msg = "diskId " + boost::lexical_cast<std::string>(diskId)
+            + " has file size of " + boost::lexical_cast<std::string>(fileSize);
+        std::cout << msg << "\n";
+        hdtn::Logger::getInstance()->logInfo("storage", msg);
+
+        const uint64_t numFullSegmentsInFile = fileSize / SEGMENT_SIZE;
+        const uint64_t numSegmentIdsOnDisk = (M_MAX_SEGMENTS > diskId) ? (((M_MAX_SEGMENTS - diskId - 1) / M_NUM_STORAGE_DISKS) + 1) : 0;
+        numSegmentsToScanVec[diskId] = std::min(numFullSegmentsInFile, numSegmentIdsOnDisk);
+        if (numSegmentsToScanVec[diskId]) {
+            numSegmentIds = std::max<uint64_t>(numSegmentIds, ((numSegmentsToScanVec[diskId] - 1) * M_NUM_STORAGE_DISKS) + diskId + 1);
+        }
+        endOfRestoreSegmentId = std::min<uint64_t>(endOfRestoreSegmentId, (numFullSegmentsInFile * M_NUM_STORAGE_DISKS) + diskId);
+    }
+    endOfRestoreSegmentId = std::min(endOfRestoreSegmentId, numSegmentIds);
+
+    //scan all disks concurrently, twice (each thread only appends to the vectors of its own disk, in segment id order):
+    //first for the heads, then for the segments of the bundles those heads start
+    std::vector<std::vector<restore_head_segment_t> > headSegmentsPerDisk(M_NUM_STORAGE_DISKS);
+    std::vector<std::vector<restore_segment_info_t> > segmentInfosPerDisk(M_NUM_STORAGE_DISKS);
+    std::unordered_set<uint64_t> liveCustodyIds;
+    for (unsigned int pass = 0; pass < 2; ++pass) {
+        std::vector<uint8_t> diskScanSuccessVec(M_NUM_STORAGE_DISKS, 0);
+        std::vector<std::unique_ptr<boost::thread> > threadPtrs(M_NUM_STORAGE_DISKS);
+        for (unsigned int diskId = 0; diskId < M_NUM_STORAGE_DISKS; ++diskId) {
+            threadPtrs[diskId] = boost::make_unique<boost::thread>(boost::bind(&RestoreScanDiskThreadFunc,
+                m_storageConfigPtr->m_storageDiskConfigVector[diskId].storeFilePath, diskId, M_NUM_STORAGE_DISKS, numSegmentsToScanVec[diskId],
+                (pass == 0) ? NULL : &liveCustodyIds, boost::ref(headSegmentsPerDisk[diskId]), boost::ref(segmentInfosPerDisk[diskId]),
+                boost::ref(diskScanSuccessVec[diskId])));
+        }
+        for (unsigned int diskId = 0; diskId < M_NUM_STORAGE_DISKS; ++diskId) {
+            threadPtrs[diskId]->join();
+        }
+        for (unsigned int diskId = 0; diskId < M_NUM_STORAGE_DISKS; ++diskId) {
+            if (!diskScanSuccessVec[diskId]) {
+                return false;
+            }
+        }
+        if (pass == 0) {
+            std::size_t numHeadSegments = 0;
+            for (unsigned int diskId = 0; diskId < M_NUM_STORAGE_DISKS; ++diskId) {
+                numHeadSegments += headSegmentsPerDisk[diskId].size();
+            }
+            if (numHeadSegments == 0) {
+                break; //empty store, nothing to chain
+            }
+            liveCustodyIds.reserve(numHeadSegments);
+            for (unsigned int diskId = 0; diskId < M_NUM_STORAGE_DISKS; ++diskId) {
+                for (std::size_t i = 0; i < headSegmentsPerDisk[diskId].size(); ++i) {
+                    liveCustodyIds.insert(headSegmentsPerDisk[diskId][i].entry.custodyId);
+                }
+            }
+        }
+    }
+
+    //merge the chains in segment id order (same catalog order and memory manager state as a sequential scan)
+    std::vector<std::size_t> nextHeadIndexPerDisk(M_NUM_STORAGE_DISKS, 0);
+    while (true) {
+        unsigned int headDiskId = M_NUM_STORAGE_DISKS;
+        for (unsigned int diskId = 0; diskId < M_NUM_STORAGE_DISKS; ++diskId) {
+            const std::vector<restore_head_segment_t> & headSegments = headSegmentsPerDisk[diskId];
+            if ((nextHeadIndexPerDisk[diskId] < headSegments.size()) && ((headDiskId == M_NUM_STORAGE_DISKS) ||
+                (headSegments[nextHeadIndexPerDisk[diskId]].segmentId < headSegmentsPerDisk[headDiskId][nextHeadIndexPerDisk[headDiskId]].segmentId)))
+            {
+                headDiskId = diskId;
+            }
+        }
+        if (headDiskId == M_NUM_STORAGE_DISKS) {
+            break;
+        }
+        restore_head_segment_t & head = headSegmentsPerDisk[headDiskId][nextHeadIndexPerDisk[headDiskId]++];
+        const segment_id_t potentialHeadSegmentId = head.segmentId;
+        if (potentialHeadSegmentId >= endOfRestoreSegmentId) break;
+        if (!m_memoryManager.IsSegmentFree(potentialHeadSegmentId)) continue;
+        if (!head.primaryLoaded) {
+            const std::string msg = "error in BundleStorageManagerBase::RestoreFromDisk: malformed bundle or unknown bundle version at segment "
+                + boost::lexical_cast<std::string>(potentialHeadSegmentId);
             std::cout << msg << "\n";
             hdtn::Logger::getInstance()->logError("storage", msg);
             return false;
         }
-    }
+        catalog_journal_entry_t & entry = head.entry;
+        const uint64_t totalSegmentsRequired = (entry.bundleSizeBytes / BUNDLE_STORAGE_PER_SEGMENT_SIZE) + ((entry.bundleSizeBytes % BUNDLE_STORAGE_PER_SEGMENT_SIZE) == 0 ? 0 : 1);
+        *totalBytesRestored += entry.bundleSizeBytes;
+        *totalSegmentsRestored += totalSegmentsRequired;
+        const CatalogJournalPrimaryBlock primary(entry);
+        catalog_entry_t catalogEntry;
+        catalogEntry.Init(primary, entry.bundleSizeBytes, totalSegmentsRequired, NULL); //NULL replaced later at CatalogIncomingBundleForStore
+        segment_id_chain_vec_t & segmentIdChainVec = catalogEntry.segmentIdChainVec;
 
-    bool restoreInProgress = true;
-    BundleViewV6 bv6;
-    BundleViewV7 bv7;
-    for (segment_id_t potentialHeadSegmentId = 0; restoreInProgress; ++potentialHeadSegmentId) {
-        if (!m_memoryManager.IsSegmentFree(potentialHeadSegmentId)) continue;
         segment_id_t segmentId = potentialHeadSegmentId;
-        BundleStorageManagerSession_WriteToDisk session;
-        catalog_entry_t & catalogEntry = session.catalogEntry;
-        segment_id_chain_vec_t & segmentIdChainVec = catalogEntry.segmentIdChainVec;
-        bool headSegmentFound = false;
-        uint64_t custodyIdHeadSegment;
-        PrimaryBlock * primaryBasePtr = NULL;
-        for (session.nextLogicalSegment = 0; ; ++session.nextLogicalSegment) {
-            const unsigned int diskIndex = segmentId % M_NUM_STORAGE_DISKS;
-            FILE * const fileHandle = fileHandlesVec[diskIndex];
-            const uint64_t offsetBytes = static_cast<uint64_t>(segmentId / M_NUM_STORAGE_DISKS) * SEGMENT_SIZE;
-            const uint64_t fileSize = fileSizesVec[diskIndex];
-            if ((session.nextLogicalSegment == 0) && ((offsetBytes + SEGMENT_SIZE) > fileSize)) {
-                static const std::string msg = "end of restore";
-                std::cout << msg << "\n";
-                hdtn::Logger::getInstance()->logNotification("storage", msg);
-                restoreInProgress = false;
-                break;
-            }
-#ifdef _MSC_VER 
-            _fseeki64_nolock(fileHandle, offsetBytes, SEEK_SET);
-#elif defined __APPLE__ 
-            fseeko(fileHandle, offsetBytes, SEEK_SET);
-#else
-            fseeko64(fileHandle, offsetBytes, SEEK_SET);
-#endif
-
-            const std::size_t bytesReadFromFread = fread((void*)dataReadBuf, 1, SEGMENT_SIZE, fileHandle);
-            if (bytesReadFromFread != SEGMENT_SIZE) {
-                const std::string msg = "Error reading at offset " + boost::lexical_cast<std::string>(offsetBytes) +
-                    " for disk " + boost::lexical_cast<std::string>(diskIndex) + " filesize " + boost::lexical_cast<std::string>(fileSize) + " logical segment "
-                    + boost::lexical_cast<std::string>(session.nextLogicalSegment) + " bytesread " + boost::lexical_cast<std::string>(bytesReadFromFread);
+        for (uint64_t logicalSegment = 0; ; ++logicalSegment) {
+            if ((segmentId >= numSegmentIds) || ((segmentId / M_NUM_STORAGE_DISKS) >= numSegmentsToScanVec[segmentId % M_NUM_STORAGE_DISKS])) {
+                const std::string msg = "error: segmentId " + boost::lexical_cast<std::string>(segmentId) + " is beyond the end of the store files";
                 std::cout << msg << "\n";
                 hdtn::Logger::getInstance()->logError("storage", msg);
                 return false;
             }
-
-            StorageSegmentHeader storageSegmentHeader;
-            memcpy(&storageSegmentHeader, dataReadBuf, SEGMENT_RESERVED_SPACE);
-            storageSegmentHeader.ToNativeEndianInplace(); //should optimize out and do nothing
-
-            
-            if ((session.nextLogicalSegment == 0) && (storageSegmentHeader.bundleSizeBytes != UINT64_MAX)) { //head segment
-                headSegmentFound = true;
-                custodyIdHeadSegment = storageSegmentHeader.custodyId;
-
-                uint8_t * bundleDataBegin = dataReadBuf + SEGMENT_RESERVED_SPACE;
-                
-                const uint8_t firstByte = bundleDataBegin[0];
-                const bool isBpVersion6 = (firstByte == 6);
-                const bool isBpVersion7 = (firstByte == ((4U << 5) | 31U));  //CBOR major type 4, additional information 31 (Indefinite-Length Array)
-                if (isBpVersion6) {
-                    if (!bv6.LoadBundle(bundleDataBegin, BUNDLE_STORAGE_PER_SEGMENT_SIZE, true)) { //load primary only
-                        std::cerr << "malformed bundle\n";
-                        return false;
-                    }
-                    Bpv6CbhePrimaryBlock & primary = bv6.m_primaryBlockView.header;
-                    primaryBasePtr = &primary;
-                }
-                else if (isBpVersion7) {
-                    if (!bv7.LoadBundle(bundleDataBegin, BUNDLE_STORAGE_PER_SEGMENT_SIZE, true, true)) { //load primary only
-                        std::cerr << "malformed bundle\n";
-                        return false;
-                    }
-                    Bpv7CbhePrimaryBlock & primary = bv7.m_primaryBlockView.header;
-                    primaryBasePtr = &primary;
-                }
-                else {
-                    std::cout << "error in BundleStorageManagerBase::RestoreFromDisk: unknown bundle version detected\n";
-                    return false;
-                }
-                const uint64_t totalSegmentsRequired = (storageSegmentHeader.bundleSizeBytes / BUNDLE_STORAGE_PER_SEGMENT_SIZE) + ((storageSegmentHeader.bundleSizeBytes % BUNDLE_STORAGE_PER_SEGMENT_SIZE) == 0 ? 0 : 1);
-
-                //std::cout << "tot segs req " << totalSegmentsRequired << "\n";
-                *totalBytesRestored += storageSegmentHeader.bundleSizeBytes;
-                *totalSegmentsRestored += totalSegmentsRequired;
-                catalogEntry.Init(*primaryBasePtr, storageSegmentHeader.bundleSizeBytes, totalSegmentsRequired, NULL); //NULL replaced later at CatalogIncomingBundleForStore
-            }
-            if (!headSegmentFound) break;
-            if (custodyIdHeadSegment != storageSegmentHeader.custodyId) { //shall be the same across all segments
+            const restore_segment_info_t * const infoPtr = FindRestoreSegmentInfo(segmentInfosPerDisk[segmentId % M_NUM_STORAGE_DISKS], segmentId);
+            if ((infoPtr == NULL) || (entry.custodyId != infoPtr->custodyId)) { //shall be the same across all segments
                 static const std::string msg = "error: custodyIdHeadSegment != custodyId";
                 std::cout << msg << "\n";
                 hdtn::Logger::getInstance()->logError("storage", msg);
                 return false;
             }
-            if ((session.nextLogicalSegment) >= segmentIdChainVec.size()) {
+            const restore_segment_info_t & info = *infoPtr;
+            if (logicalSegment >= segmentIdChainVec.size()) {
                 static const std::string msg = "error: logical segment exceeds total segments required";
                 std::cout << msg << "\n";
                 hdtn::Logger::getInstance()->logError("storage", msg);
@@ -541,41 +912,104 @@ bool BundleStorageManagerBase::RestoreFromDisk(uint64_t * totalBundlesRestored,
                 return false;
             }
             m_memoryManager.AllocateSegmentId_NoCheck_NotThreadSafe(segmentId);
-            segmentIdChainVec[session.nextLogicalSegment] = segmentId;
-
+            segmentIdChainVec[logicalSegment] = segmentId;
 
-
-            if ((session.nextLogicalSegment + 1) >= segmentIdChainVec.size()) { //==
-                if (storageSegmentHeader.nextSegmentId != UINT32_MAX) { //there are more segments
+            if ((logicalSegment + 1) >= segmentIdChainVec.size()) { //==
+                if (info.nextSegmentId != UINT32_MAX) { //there are more segments
                     static const std::string msg = "error: at the last logical segment but nextSegmentId != UINT32_MAX";
                     std::cout << msg << "\n";
                     hdtn::Logger::getInstance()->logError("storage", msg);
                     return false;
                 }
-                m_bundleStorageCatalog.CatalogIncomingBundleForStore(catalogEntry, *primaryBasePtr, storageSegmentHeader.custodyId, BundleStorageCatalog::DUPLICATE_EXPIRY_ORDER::FIFO);
+                if (m_bundleStorageCatalog.CatalogIncomingBundleForStore(catalogEntry, primary, entry.custodyId, BundleStorageCatalog::DUPLICATE_EXPIRY_ORDER::FIFO)) {
+                    JournalCatalogInsert(entry.custodyId);
+                }
                 *totalBundlesRestored += 1;
                 break;
-                //std::cout << "write complete\n";
             }
 
-            if (storageSegmentHeader.nextSegmentId == UINT32_MAX) { //there are more segments
+            if (info.nextSegmentId == UINT32_MAX) { //there are more segments
                 static const std::string msg = "error: there are more logical segments but nextSegmentId == UINT32_MAX";
                 std::cout << msg << "\n";
                 hdtn::Logger::getInstance()->logError("storage", msg);
                 return false;
             }
-            segmentId = storageSegmentHeader.nextSegmentId;
-
+            segmentId = info.nextSegmentId;
         }
     }
-
-
-    for (unsigned int tId = 0; tId < M_NUM_STORAGE_DISKS; ++tId) {
-        fclose(fileHandlesVec[tId]);
-    }
+    static const std::string msg = "end of restore";
+    std::cout << msg << "\n";
+    hdtn::Logger::getInstance()->logNotification("storage", msg);
 
     m_successfullyRestoredFromDisk = true;
     return true;
 }
 
+bool BundleStorageManagerBase::RestoreFromCatalogJournal(uint64_t * totalBundlesRestored, uint64_t * totalBytesRestored, uint64_t * totalSegmentsRestored) {
+    *totalBundlesRestored = 0; *totalBytesRestored = 0; *totalSegmentsRestored = 0;
+    std::vector<catalog_journal_entry_t> entries;
+    if ((!m_catalogJournalPtr) || (!m_catalogJournalPtr->Load(entries))) {
+        return false;
+    }
+
+    std::vector <uint64_t> fileSizesVec(M_NUM_STORAGE_DISKS);
+    for (unsigned int diskId = 0; diskId < M_NUM_STORAGE_DISKS; ++diskId) {
+        const boost::filesystem::path p(m_storageConfigPtr->m_storageDiskConfigVector[diskId].storeFilePath);
+        if (!boost::filesystem::exists(p)) {
+            const std::string msg = "Error: " + p.string() + " does not exist, cannot restore from the catalog journal";
+            std::cout << msg << "\n";
+            hdtn::Logger::getInstance()->logError("storage", msg);
+            return false;
+        }
+        fileSizesVec[diskId] = boost::filesystem::file_size(p);
+    }
 
+    //apply every entry, undoing all of them if any entry disagrees with the storage configuration or another entry
+    std::vector<uint64_t> custodyIdsCataloged;
+    segment_id_chain_vec_t segmentIdsAllocated;
+    bool success = true;
+    for (std::size_t i = 0; success && (i < entries.size()); ++i) {
+        catalog_journal_entry_t & entry = entries[i];
+        const uint64_t totalSegmentsRequired = (entry.bundleSizeBytes / BUNDLE_STORAGE_PER_SEGMENT_SIZE) + ((entry.bundleSizeBytes % BUNDLE_STORAGE_PER_SEGMENT_SIZE) == 0 ? 0 : 1);
+        success = (totalSegmentsRequired == entry.segmentIdChainVec.size());
+        for (std::size_t j = 0; success && (j < entry.segmentIdChainVec.size()); ++j) {
+            const segment_id_t segmentId = entry.segmentIdChainVec[j];
+            const uint64_t offsetBytes = static_cast<uint64_t>(segmentId / M_NUM_STORAGE_DISKS) * SEGMENT_SIZE;
+            success = (segmentId < M_MAX_SEGMENTS)
+                && ((offsetBytes + SEGMENT_SIZE) <= fileSizesVec[segmentId % M_NUM_STORAGE_DISKS])
+                && m_memoryManager.IsSegmentFree(segmentId);
+            if (success) {
+                m_memoryManager.AllocateSegmentId_NoCheck_NotThreadSafe(segmentId);
+                segmentIdsAllocated.push_back(segmentId);
+            }
+        }
+        if (!success) {
+            break;
+        }
+        const CatalogJournalPrimaryBlock primary(entry);
+        catalog_entry_t catalogEntry;
+        catalogEntry.Init(primary, entry.bundleSizeBytes, totalSegmentsRequired, NULL); //NULL replaced later at CatalogIncomingBundleForStore
+        catalogEntry.segmentIdChainVec = entry.segmentIdChainVec;
+        success = m_bundleStorageCatalog.CatalogIncomingBundleForStore(catalogEntry, primary, entry.custodyId, BundleStorageCatalog::DUPLICATE_EXPIRY_ORDER::FIFO);
+        if (success) {
+            custodyIdsCataloged.push_back(entry.custodyId);
+            JournalCatalogInsert(entry.custodyId);
+            *totalBundlesRestored += 1;
+            *totalBytesRestored += entry.bundleSizeBytes;
+            *totalSegmentsRestored += totalSegmentsRequired;
+        }
+    }
+    if (!success) {
+        static const std::string msg = "error: catalog journal does not match the storage, falling back to scanning the disks";
+        std::cout << msg << "\n";
+        hdtn::Logger::getInstance()->logError("storage", msg);
+        for (std::size_t i = 0; i < custodyIdsCataloged.size(); ++i) {
+            m_bundleStorageCatalog.Remove(custodyIdsCataloged[i], true);
+        }
+        m_memoryManager.FreeSegments_ThreadSafe(segmentIdsAllocated);
+        m_catalogJournalPtr->ClearLiveEntries();
+        *totalBundlesRestored = 0; *totalBytesRestored = 0; *totalSegmentsRestored = 0;
+        return false;
+    }
+    return true;
+}
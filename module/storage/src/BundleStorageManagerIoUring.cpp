@@ -0,0 +1,575 @@
+/***************************************************************************
+ * NASA Glenn Research Center, Cleveland, OH
+ * Released under the NASA Open Source Agreement (NOSA)
+ * May  2021
+ *
+ ****************************************************************************
+ */
+#ifdef _WIN32
+#include <io.h>
+#include <sys/stat.h>
+#else
+#define _LARGEFILE64_SOURCE
+#define _FILE_OFFSET_BITS 64
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#ifndef O_LARGEFILE
+#define O_LARGEFILE 0
+#endif
+#endif
+
+#if defined(__linux__)
+#include <sys/syscall.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter) && defined(__NR_io_uring_register)
+#include <linux/io_uring.h>
+//IORING_OP_READ/IORING_OP_WRITE are enumerators, so the opcode probe (IO_URING_OP_SUPPORTED) which came with them
+//in the kernel 5.6 headers is tested instead, along with the kernel 5.4 IORING_FEAT_SINGLE_MMAP
+#if defined(IORING_FEAT_SINGLE_MMAP) && defined(IO_URING_OP_SUPPORTED)
+#include <sys/mman.h>
+#include <sys/uio.h>
+#define STORAGE_IO_URING_SUPPORTED 1
+#endif
+#endif
+#endif
+
+#include "BundleStorageManagerIoUring.h"
+#include <iostream>
+#include <string>
+#include <cstring>
+#include <algorithm>
+#include <boost/filesystem.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/make_unique.hpp>
+
+struct BundleStorageManagerIoUring::DiskContext {
+    DiskContext();
+    ~DiskContext();
+    bool OpenFile(const char * filePath, const bool reopen, const bool tryDirectIo);
+    bool SetupRing(const unsigned int numEntries, uint8_t * registeredBuffer, const std::size_t registeredBufferSize);
+    bool QueueOperation(const bool isRead, uint8_t * buf, const std::size_t len, const uint64_t offset, const uint64_t userData, const bool drainPrevious);
+    bool SubmitAndWait(const unsigned int minComplete);
+    bool TryPopCompletion(uint64_t & userData, int32_t & result);
+    bool SyncTransfer(const bool isRead, uint8_t * buf, std::size_t len, uint64_t offset);
+
+    int m_fd;
+    bool m_isDirectIo;
+    bool m_isRingSetUp;
+    unsigned int m_maxOperationsInFlight;
+    uint64_t m_totalOperations;
+    uint64_t m_totalSegments;
+#ifdef STORAGE_IO_URING_SUPPORTED
+    int m_ringFd;
+    bool m_isBufferRegistered;
+    uint8_t * m_registeredBuffer;
+    unsigned int m_numToSubmit;
+    void * m_sqRingPtr;
+    std::size_t m_sqRingSize;
+    void * m_cqRingPtr;
+    std::size_t m_cqRingSize;
+    struct io_uring_sqe * m_sqes;
+    std::size_t m_sqesSize;
+    unsigned int m_sqEntries;
+    unsigned int * m_sqHeadPtr;
+    unsigned int * m_sqTailPtr;
+    unsigned int * m_sqRingMaskPtr;
+    unsigned int * m_sqArray;
+    unsigned int * m_cqHeadPtr;
+    unsigned int * m_cqTailPtr;
+    unsigned int * m_cqRingMaskPtr;
+    struct io_uring_cqe * m_cqes;
+#endif
+};
+
+BundleStorageManagerIoUring::DiskContext::DiskContext() :
+    m_fd(-1),
+    m_isDirectIo(false),
+    m_isRingSetUp(false),
+    m_maxOperationsInFlight(0),
+    m_totalOperations(0),
+    m_totalSegments(0)
+#ifdef STORAGE_IO_URING_SUPPORTED
+    ,
+    m_ringFd(-1),
+    m_isBufferRegistered(false),
+    m_registeredBuffer(NULL),
+    m_numToSubmit(0),
+    m_sqRingPtr(MAP_FAILED),
+    m_sqRingSize(0),
+    m_cqRingPtr(MAP_FAILED),
+    m_cqRingSize(0),
+    m_sqes(static_cast<struct io_uring_sqe *>(MAP_FAILED)),
+    m_sqesSize(0)
+#endif
+{}
+
+BundleStorageManagerIoUring::DiskContext::~DiskContext() {
+#ifdef STORAGE_IO_URING_SUPPORTED
+    if (m_sqes != MAP_FAILED) {
+        munmap(m_sqes, m_sqesSize);
+    }
+    if ((m_cqRingPtr != MAP_FAILED) && (m_cqRingPtr != m_sqRingPtr)) {
+        munmap(m_cqRingPtr, m_cqRingSize);
+    }
+    if (m_sqRingPtr != MAP_FAILED) {
+        munmap(m_sqRingPtr, m_sqRingSize);
+    }
+    if (m_ringFd >= 0) {
+        close(m_ringFd); //also unregisters the buffer
+    }
+#endif
+    if (m_fd >= 0) {
+#ifdef _WIN32
+        _close(m_fd);
+#else
+        close(m_fd);
+#endif
+    }
+}
+
+bool BundleStorageManagerIoUring::DiskContext::OpenFile(const char * filePath, const bool reopen, const bool tryDirectIo) {
+#ifdef _WIN32
+    m_fd = _open(filePath, (reopen) ? (_O_RDWR | _O_BINARY) : (_O_CREAT | _O_RDWR | _O_TRUNC | _O_BINARY), _S_IREAD | _S_IWRITE);
+#else
+    const int flags = (reopen) ? (O_RDWR | O_LARGEFILE) : (O_CREAT | O_RDWR | O_TRUNC | O_LARGEFILE);
+#ifdef O_DIRECT
+    if (tryDirectIo) {
+        m_fd = open(filePath, flags | O_DIRECT, DEFFILEMODE);
+        if (m_fd >= 0) {
+            m_isDirectIo = true;
+            return true;
+        }
+        //tmpfs and some other filesystems reject O_DIRECT with EINVAL
+    }
+#endif
+    m_fd = open(filePath, flags, DEFFILEMODE);
+#endif
+    return (m_fd >= 0);
+}
+
+bool BundleStorageManagerIoUring::DiskContext::SyncTransfer(const bool isRead, uint8_t * buf, std::size_t len, uint64_t offset) {
+    while (len) {
+#ifdef _WIN32
+        if (_lseeki64(m_fd, static_cast<__int64>(offset), SEEK_SET) < 0) {
+            return false;
+        }
+        const int n = (isRead) ? _read(m_fd, buf, static_cast<unsigned int>(len)) : _write(m_fd, buf, static_cast<unsigned int>(len));
+#else
+        const ssize_t n = (isRead) ? pread(m_fd, buf, len, static_cast<off_t>(offset)) : pwrite(m_fd, buf, len, static_cast<off_t>(offset));
+        if ((n < 0) && (errno == EINTR)) {
+            continue;
+        }
+#endif
+        if (n <= 0) {
+            return false;
+        }
+        buf += n;
+        len -= static_cast<std::size_t>(n);
+        offset += static_cast<uint64_t>(n);
+    }
+    return true;
+}
+
+#ifdef STORAGE_IO_URING_SUPPORTED
+//a kernel older than 5.6 rejects IORING_REGISTER_PROBE, and so has no IORING_OP_READ/IORING_OP_WRITE either
+static bool RingSupportsReadWriteOpcodes(const int ringFd) {
+    static const unsigned int NUM_PROBE_OPS = 64;
+    std::vector<uint8_t> probeBuf(sizeof(struct io_uring_probe) + (NUM_PROBE_OPS * sizeof(struct io_uring_probe_op)), 0);
+    struct io_uring_probe * const probe = reinterpret_cast<struct io_uring_probe *>(probeBuf.data());
+    if (syscall(__NR_io_uring_register, ringFd, IORING_REGISTER_PROBE, probe, NUM_PROBE_OPS) != 0) {
+        return false;
+    }
+    static const unsigned int REQUIRED_OPS[4] = { IORING_OP_READ, IORING_OP_WRITE, IORING_OP_READ_FIXED, IORING_OP_WRITE_FIXED };
+    for (unsigned int i = 0; i < 4; ++i) {
+        const unsigned int op = REQUIRED_OPS[i];
+        if ((op > probe->last_op) || (op >= NUM_PROBE_OPS) || ((probe->ops[op].flags & IO_URING_OP_SUPPORTED) == 0)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool BundleStorageManagerIoUring::IsIoUringSupported() {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    const int ringFd = static_cast<int>(syscall(__NR_io_uring_setup, 2, &params)); //fails with ENOSYS (old kernel) or EPERM (seccomp)
+    if (ringFd < 0) {
+        return false;
+    }
+    const bool supported = RingSupportsReadWriteOpcodes(ringFd);
+    close(ringFd);
+    return supported;
+}
+
+bool BundleStorageManagerIoUring::DiskContext::SetupRing(const unsigned int numEntries, uint8_t * registeredBuffer, const std::size_t registeredBufferSize) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    m_ringFd = static_cast<int>(syscall(__NR_io_uring_setup, numEntries, &params));
+    if (m_ringFd < 0) {
+        return false;
+    }
+    if (!RingSupportsReadWriteOpcodes(m_ringFd)) {
+        return false;
+    }
+    //submitted operations leave the submission queue, so more can be in flight than it has entries,
+    //but every one of them needs a completion queue entry
+    m_maxOperationsInFlight = std::min<unsigned int>(IO_URING_MAX_OPERATIONS_IN_FLIGHT, params.cq_entries);
+    m_sqEntries = params.sq_entries;
+    m_sqRingSize = params.sq_off.array + (params.sq_entries * sizeof(unsigned int));
+    m_cqRingSize = params.cq_off.cqes + (params.cq_entries * sizeof(struct io_uring_cqe));
+    const bool singleMmap = ((params.features & IORING_FEAT_SINGLE_MMAP) != 0);
+    if (singleMmap) {
+        m_sqRingSize = std::max(m_sqRingSize, m_cqRingSize);
+        m_cqRingSize = m_sqRingSize;
+    }
+    m_sqRingPtr = mmap(NULL, m_sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ringFd, IORING_OFF_SQ_RING);
+    if (m_sqRingPtr == MAP_FAILED) {
+        return false;
+    }
+    if (singleMmap) {
+        m_cqRingPtr = m_sqRingPtr;
+    }
+    else {
+        m_cqRingPtr = mmap(NULL, m_cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ringFd, IORING_OFF_CQ_RING);
+        if (m_cqRingPtr == MAP_FAILED) {
+            return false;
+        }
+    }
+    m_sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+    m_sqes = static_cast<struct io_uring_sqe *>(mmap(NULL, m_sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ringFd, IORING_OFF_SQES));
+    if (m_sqes == MAP_FAILED) {
+        return false;
+    }
+    uint8_t * const sq = static_cast<uint8_t *>(m_sqRingPtr);
+    m_sqHeadPtr = reinterpret_cast<unsigned int *>(sq + params.sq_off.head);
+    m_sqTailPtr = reinterpret_cast<unsigned int *>(sq + params.sq_off.tail);
+    m_sqRingMaskPtr = reinterpret_cast<unsigned int *>(sq + params.sq_off.ring_mask);
+    m_sqArray = reinterpret_cast<unsigned int *>(sq + params.sq_off.array);
+    uint8_t * const cq = static_cast<uint8_t *>(m_cqRingPtr);
+    m_cqHeadPtr = reinterpret_cast<unsigned int *>(cq + params.cq_off.head);
+    m_cqTailPtr = reinterpret_cast<unsigned int *>(cq + params.cq_off.tail);
+    m_cqRingMaskPtr = reinterpret_cast<unsigned int *>(cq + params.cq_off.ring_mask);
+    m_cqes = reinterpret_cast<struct io_uring_cqe *>(cq + params.cq_off.cqes);
+
+    //fixed buffers save the kernel from pinning the pages on every operation (may fail under a low RLIMIT_MEMLOCK, which is not fatal)
+    struct iovec iov;
+    iov.iov_base = registeredBuffer;
+    iov.iov_len = registeredBufferSize;
+    m_isBufferRegistered = (syscall(__NR_io_uring_register, m_ringFd, IORING_REGISTER_BUFFERS, &iov, 1) == 0);
+    m_registeredBuffer = registeredBuffer;
+    m_isRingSetUp = true;
+    return true;
+}
+
+bool BundleStorageManagerIoUring::DiskContext::QueueOperation(const bool isRead, uint8_t * buf, const std::size_t len, const uint64_t offset, const uint64_t userData, const bool drainPrevious) {
+    const unsigned int tail = *m_sqTailPtr; //only this thread writes the tail
+    if ((tail - __atomic_load_n(m_sqHeadPtr, __ATOMIC_ACQUIRE)) >= m_sqEntries) {
+        //submission queue full: hand the queued entries to the kernel (without waiting) to make room
+        if ((!SubmitAndWait(0)) || ((tail - __atomic_load_n(m_sqHeadPtr, __ATOMIC_ACQUIRE)) >= m_sqEntries)) {
+            return false;
+        }
+    }
+    const unsigned int index = tail & (*m_sqRingMaskPtr);
+    struct io_uring_sqe * const sqe = &m_sqes[index];
+    memset(sqe, 0, sizeof(struct io_uring_sqe));
+    if (m_isBufferRegistered) {
+        sqe->opcode = (isRead) ? IORING_OP_READ_FIXED : IORING_OP_WRITE_FIXED;
+        sqe->buf_index = 0;
+    }
+    else {
+        sqe->opcode = (isRead) ? IORING_OP_READ : IORING_OP_WRITE;
+    }
+    sqe->flags = (drainPrevious) ? IOSQE_IO_DRAIN : 0;
+    sqe->fd = m_fd;
+    sqe->off = offset;
+    sqe->addr = reinterpret_cast<uint64_t>(buf);
+    sqe->len = static_cast<uint32_t>(len);
+    sqe->user_data = userData;
+    m_sqArray[index] = index;
+    __atomic_store_n(m_sqTailPtr, tail + 1, __ATOMIC_RELEASE);
+    ++m_numToSubmit;
+    return true;
+}
+
+bool BundleStorageManagerIoUring::DiskContext::SubmitAndWait(const unsigned int minComplete) {
+    while (true) {
+        const int ret = static_cast<int>(syscall(__NR_io_uring_enter, m_ringFd, m_numToSubmit, minComplete, (minComplete) ? IORING_ENTER_GETEVENTS : 0, NULL, 0));
+        if (ret >= 0) {
+            m_numToSubmit -= static_cast<unsigned int>(ret);
+            return true;
+        }
+        if (errno != EINTR) {
+            return false;
+        }
+    }
+}
+
+bool BundleStorageManagerIoUring::DiskContext::TryPopCompletion(uint64_t & userData, int32_t & result) {
+    const unsigned int head = *m_cqHeadPtr; //only this thread writes the head
+    const unsigned int tail = __atomic_load_n(m_cqTailPtr, __ATOMIC_ACQUIRE);
+    if (head == tail) {
+        return false;
+    }
+    const struct io_uring_cqe & cqe = m_cqes[head & (*m_cqRingMaskPtr)];
+    userData = cqe.user_data;
+    result = cqe.res;
+    __atomic_store_n(m_cqHeadPtr, head + 1, __ATOMIC_RELEASE);
+    return true;
+}
+#else
+bool BundleStorageManagerIoUring::IsIoUringSupported() {
+    return false;
+}
+bool BundleStorageManagerIoUring::DiskContext::SetupRing(const unsigned int numEntries, uint8_t * registeredBuffer, const std::size_t registeredBufferSize) {
+    return false;
+}
+bool BundleStorageManagerIoUring::DiskContext::QueueOperation(const bool isRead, uint8_t * buf, const std::size_t len, const uint64_t offset, const uint64_t userData, const bool drainPrevious) {
+    return false;
+}
+bool BundleStorageManagerIoUring::DiskContext::SubmitAndWait(const unsigned int minComplete) {
+    return false;
+}
+bool BundleStorageManagerIoUring::DiskContext::TryPopCompletion(uint64_t & userData, int32_t & result) {
+    return false;
+}
+#endif
+
+BundleStorageManagerIoUring::BundleStorageManagerIoUring() : BundleStorageManagerIoUring("storageConfig.json") {}
+
+BundleStorageManagerIoUring::BundleStorageManagerIoUring(const std::string & jsonConfigFileName) : BundleStorageManagerIoUring(StorageConfig::CreateFromJsonFile(jsonConfigFileName)) {
+    if (!m_storageConfigPtr) {
+        std::cerr << "cannot open storage json config file: " << jsonConfigFileName << std::endl;
+        hdtn::Logger::getInstance()->logError("storage", "cannot open storage json config file: " + jsonConfigFileName);
+        return;
+    }
+}
+
+BundleStorageManagerIoUring::BundleStorageManagerIoUring(const StorageConfig_ptr & storageConfigPtr) :
+    BundleStorageManagerBase(storageConfigPtr, IO_URING_CIRCULAR_INDEX_BUFFER_SIZE),
+
+    m_conditionVariablesVec(M_NUM_STORAGE_DISKS),
+    m_threadPtrsVec(M_NUM_STORAGE_DISKS),
+    m_diskContextPtrsVec(M_NUM_STORAGE_DISKS),
+    m_running(false),
+    m_usingIoUring(false),
+    m_usingDirectIo(false)
+{
+    //runs of adjacent segments in a disk's circular buffer are coalesced into single operations
+    m_allocateContiguousSegments = true;
+}
+
+BundleStorageManagerIoUring::~BundleStorageManagerIoUring() {
+    m_running = false; //thread stopping criteria
+    for (unsigned int diskId = 0; diskId < M_NUM_STORAGE_DISKS; ++diskId) {
+        if (m_threadPtrsVec[diskId]) {
+            m_threadPtrsVec[diskId]->join();
+            m_threadPtrsVec[diskId].reset(); //delete it
+        }
+    }
+    for (unsigned int diskId = 0; diskId < M_NUM_STORAGE_DISKS; ++diskId) {
+        m_diskContextPtrsVec[diskId].reset(); //close the file and ring before the base class deletes the file
+    }
+}
+
+void BundleStorageManagerIoUring::Start() {
+    if ((!m_running) && (m_storageConfigPtr)) {
+        m_usingIoUring = IsIoUringSupported();
+        m_usingDirectIo = true;
+        for (unsigned int diskId = 0; diskId < M_NUM_STORAGE_DISKS; ++diskId) {
+            const char * const filePath = m_filePathsAsStringVec[diskId].c_str();
+            std::cout << ((m_successfullyRestoredFromDisk) ? "reopening " : "creating ") << filePath << "\n";
+            hdtn::Logger::getInstance()->logNotification("storage", ((m_successfullyRestoredFromDisk) ? "Reopening " : "Creating ") + std::string(filePath));
+            m_diskContextPtrsVec[diskId] = boost::make_unique<DiskContext>();
+            DiskContext & disk = *m_diskContextPtrsVec[diskId];
+            if (!disk.OpenFile(filePath, m_successfullyRestoredFromDisk, true)) {
+                std::cerr << "error opening " << filePath << std::endl;
+                hdtn::Logger::getInstance()->logError("storage", "Error opening " + std::string(filePath));
+                return;
+            }
+            uint8_t * const circularBufferBlockDataPtr = &m_circularBufferBlockDataPtr[diskId * M_CIRCULAR_INDEX_BUFFER_SIZE * SEGMENT_SIZE];
+            if (m_usingIoUring && (!disk.SetupRing(IO_URING_RING_ENTRIES, circularBufferBlockDataPtr, M_CIRCULAR_INDEX_BUFFER_SIZE * SEGMENT_SIZE))) {
+                m_usingIoUring = false;
+            }
+            if (!disk.m_isDirectIo) {
+                m_usingDirectIo = false;
+            }
+        }
+        const std::string msg = std::string("BundleStorageManagerIoUring using ") + ((m_usingIoUring) ? "io_uring" : "pread/pwrite (io_uring unavailable)")
+            + ((m_usingDirectIo) ? " with O_DIRECT" : " with buffered files");
+        std::cout << msg << std::endl;
+        hdtn::Logger::getInstance()->logNotification("storage", msg);
+        m_running = true;
+        for (unsigned int diskId = 0; diskId < M_NUM_STORAGE_DISKS; ++diskId) {
+            m_threadPtrsVec[diskId] = boost::make_unique<boost::thread>(
+                boost::bind(&BundleStorageManagerIoUring::ThreadFunc, this, diskId)); //create and start the worker thread
+        }
+    }
+}
+
+bool BundleStorageManagerIoUring::IsUsingIoUring() const {
+    return m_usingIoUring;
+}
+
+bool BundleStorageManagerIoUring::IsUsingDirectIo() const {
+    return m_usingDirectIo;
+}
+
+void BundleStorageManagerIoUring::ThreadFunc(const unsigned int threadIndex) {
+
+    boost::mutex localMutex;
+    boost::mutex::scoped_lock lock(localMutex);
+    boost::condition_variable & cv = m_conditionVariablesVec[threadIndex];
+    CircularIndexBufferSingleProducerSingleConsumerConfigurable & cb = m_circularIndexBuffersVec[threadIndex];
+    DiskContext & disk = *m_diskContextPtrsVec[threadIndex];
+    const unsigned int CB_SIZE = M_CIRCULAR_INDEX_BUFFER_SIZE;
+    uint8_t * const circularBufferBlockDataPtr = &m_circularBufferBlockDataPtr[threadIndex * CB_SIZE * SEGMENT_SIZE];
+    segment_id_t * const circularBufferSegmentIdsPtr = &m_circularBufferSegmentIdsPtr[threadIndex * CB_SIZE];
+    volatile uint8_t * volatile * const readFromStorageDestPointers = &m_circularBufferReadFromStoragePointers[threadIndex * CB_SIZE];
+    volatile bool * volatile * const isReadCompletedPointers = &m_circularBufferIsReadCompletedPointers[threadIndex * CB_SIZE];
+
+    //Entries are submitted in circular buffer order but io_uring may complete them in any order,
+    //so an entry is only committed (returned to the producer) once it and all entries before it have completed.
+    std::vector<bool> entryCompleted(CB_SIZE, false);
+    unsigned int numEntriesSubmitted = 0; //starting at the circular buffer read index, not yet committed
+    unsigned int numOperationsInFlight = 0;
+    //disk byte range of each in-flight io_uring operation, indexed by its first circular buffer entry (zero length when none)
+    std::vector<uint64_t> inFlightOffsetBegin(CB_SIZE, 0);
+    std::vector<uint64_t> inFlightOffsetEnd(CB_SIZE, 0);
+
+    while (m_running || (cb.GetIndexForRead() != UINT32_MAX)) { //keep thread alive if running or cb not empty
+
+        const unsigned int readIndex = cb.GetIndexForRead(); //store the volatile
+        const unsigned int numInBuffer = (readIndex == UINT32_MAX) ? 0 : cb.NumInBuffer();
+
+        //submit newly queued entries, coalescing runs that are adjacent both in the circular buffer and on disk
+        //(once the in-flight limit is reached, the rest wait for completions)
+        unsigned int consumeIndex = (readIndex + numEntriesSubmitted) % CB_SIZE;
+        while ((numEntriesSubmitted < numInBuffer) && ((!disk.m_isRingSetUp) || (numOperationsInFlight < disk.m_maxOperationsInFlight))) {
+            const segment_id_t segmentId = circularBufferSegmentIdsPtr[consumeIndex];
+            if (segmentId == UINT32_MAX) {
+                std::cout << "error segmentId is max\n";
+                hdtn::Logger::getInstance()->logError("storage", "Error segmentId is max");
+                entryCompleted[consumeIndex] = true; //nothing to transfer, just return the entry
+                consumeIndex = (consumeIndex + 1) % CB_SIZE;
+                ++numEntriesSubmitted;
+                continue;
+            }
+            const bool isRead = (readFromStorageDestPointers[consumeIndex] != NULL);
+            const uint64_t diskSegmentIndex = segmentId / M_NUM_STORAGE_DISKS;
+            const unsigned int maxRunLength = std::min(numInBuffer - numEntriesSubmitted, CB_SIZE - consumeIndex); //no wrap (must be contiguous in memory)
+            unsigned int runLength = 1;
+            while (runLength < maxRunLength) {
+                const unsigned int nextIndex = consumeIndex + runLength;
+                const segment_id_t nextSegmentId = circularBufferSegmentIdsPtr[nextIndex];
+                if ((nextSegmentId == UINT32_MAX)
+                    || ((readFromStorageDestPointers[nextIndex] != NULL) != isRead)
+                    || ((nextSegmentId / M_NUM_STORAGE_DISKS) != (diskSegmentIndex + runLength)))
+                {
+                    break;
+                }
+                ++runLength;
+            }
+            uint8_t * const data = &circularBufferBlockDataPtr[consumeIndex * SEGMENT_SIZE];
+            const std::size_t len = static_cast<std::size_t>(runLength) * SEGMENT_SIZE;
+            const uint64_t offsetBytes = diskSegmentIndex * SEGMENT_SIZE;
+            const uint64_t userData = (static_cast<uint64_t>(consumeIndex) << 32) | runLength;
+            ++disk.m_totalOperations;
+            disk.m_totalSegments += runLength;
+            //io_uring does not order in-flight operations, but a segment may be read right after being written,
+            //or rewritten (freed then reallocated) right after its header was overwritten by RemoveReadBundleFromDisk,
+            //so an operation overlapping one still in flight waits for all previous operations (IOSQE_IO_DRAIN)
+            bool overlapsInFlightOperation = false;
+            if (numOperationsInFlight) {
+                const uint64_t offsetEnd = offsetBytes + len;
+                for (unsigned int i = 0; i < CB_SIZE; ++i) {
+                    if ((offsetBytes < inFlightOffsetEnd[i]) && (inFlightOffsetBegin[i] < offsetEnd)) {
+                        overlapsInFlightOperation = true;
+                        break;
+                    }
+                }
+            }
+            if (disk.m_isRingSetUp && disk.QueueOperation(isRead, data, len, offsetBytes, userData, overlapsInFlightOperation)) {
+                ++numOperationsInFlight;
+                inFlightOffsetBegin[consumeIndex] = offsetBytes;
+                inFlightOffsetEnd[consumeIndex] = offsetBytes + len;
+            }
+            else {
+                if (!disk.SyncTransfer(isRead, data, len, offsetBytes)) {
+                    std::cout << ((isRead) ? "error reading\n" : "error writing\n");
+                    hdtn::Logger::getInstance()->logError("storage", (isRead) ? "Error reading" : "Error writing");
+                }
+                for (unsigned int i = 0; i < runLength; ++i) {
+                    entryCompleted[consumeIndex + i] = true;
+                }
+            }
+            consumeIndex = (consumeIndex + runLength) % CB_SIZE;
+            numEntriesSubmitted += runLength;
+        }
+
+        //submit, and block for a completion only when the next entry to commit is still in flight
+        if (numOperationsInFlight) {
+            const bool mustWait = (numEntriesSubmitted != 0) && (!entryCompleted[readIndex]);
+            if (!disk.SubmitAndWait((mustWait) ? 1 : 0)) {
+                std::cout << "error in io_uring_enter\n";
+                hdtn::Logger::getInstance()->logError("storage", "Error in io_uring_enter");
+            }
+            uint64_t userData;
+            int32_t result;
+            while (disk.TryPopCompletion(userData, result)) {
+                const unsigned int firstIndex = static_cast<unsigned int>(userData >> 32);
+                const unsigned int runLength = static_cast<unsigned int>(userData & 0xffffffff);
+                const bool isRead = (readFromStorageDestPointers[firstIndex] != NULL);
+                const std::size_t len = static_cast<std::size_t>(runLength) * SEGMENT_SIZE;
+                --numOperationsInFlight;
+                inFlightOffsetBegin[firstIndex] = 0;
+                inFlightOffsetEnd[firstIndex] = 0;
+                if ((result < 0) || (static_cast<std::size_t>(result) != len)) {
+                    //short transfer or error, retry the whole run synchronously
+                    std::cerr << "error in BundleStorageManagerIoUring: " << ((isRead) ? "read" : "write") << " result (" << result
+                        << ") != " << len << " bytes, retrying synchronously" << std::endl;
+                    const uint64_t offsetBytes = static_cast<uint64_t>(circularBufferSegmentIdsPtr[firstIndex] / M_NUM_STORAGE_DISKS) * SEGMENT_SIZE;
+                    if (!disk.SyncTransfer(isRead, &circularBufferBlockDataPtr[firstIndex * SEGMENT_SIZE], len, offsetBytes)) {
+                        std::cout << ((isRead) ? "error reading\n" : "error writing\n");
+                        hdtn::Logger::getInstance()->logError("storage", (isRead) ? "Error reading" : "Error writing");
+                    }
+                }
+                for (unsigned int i = 0; i < runLength; ++i) {
+                    entryCompleted[firstIndex + i] = true;
+                }
+            }
+        }
+
+        //commit the completed entries in order
+        bool committedAny = false;
+        while (numEntriesSubmitted && entryCompleted[cb.GetIndexForRead()]) {
+            const unsigned int commitIndex = cb.GetIndexForRead();
+            volatile uint8_t * const readFromStorageDestPointer = readFromStorageDestPointers[commitIndex];
+            if (readFromStorageDestPointer != NULL) {
+                memcpy((void*)readFromStorageDestPointer, &circularBufferBlockDataPtr[commitIndex * SEGMENT_SIZE], SEGMENT_SIZE);
+                *isReadCompletedPointers[commitIndex] = true;
+            }
+            entryCompleted[commitIndex] = false;
+            --numEntriesSubmitted;
+            cb.CommitRead();
+            committedAny = true;
+        }
+        if (committedAny) {
+            m_conditionVariableMainThread.notify_one();
+        }
+        else if ((numEntriesSubmitted == 0) && (cb.GetIndexForRead() == UINT32_MAX)) { //if empty
+            cv.timed_wait(lock, boost::posix_time::milliseconds(10)); // call lock.unlock() and blocks the current thread
+            //thread is now unblocked, and the lock is reacquired by invoking lock.lock()
+        }
+    }
+
+    if (disk.m_totalOperations) {
+        std::cout << "storage disk " << threadIndex << ": " << disk.m_totalSegments << " segments transferred in "
+            << disk.m_totalOperations << " disk operations" << std::endl;
+    }
+}
+
+//virtual function to be called immediately after a disk's circular buffer CommitWrite();
+void BundleStorageManagerIoUring::NotifyDiskOfWorkToDo_ThreadSafe(const unsigned int diskId) {
+    m_conditionVariablesVec[diskId].notify_one();
+}
@@ -72,8 +72,8 @@ void BundleStorageManagerMT::ThreadFunc(const unsigned int threadIndex) {
         hdtn::Logger::getInstance()->logNotification("storage", "Creating " + std::string(filePath));
     }
     FILE * fileHandle = (m_successfullyRestoredFromDisk) ? fopen(filePath, "r+bR") : fopen(filePath, "w+bR");
-    boost::uint8_t * const circularBufferBlockDataPtr = &m_circularBufferBlockDataPtr[threadIndex * CIRCULAR_INDEX_BUFFER_SIZE * SEGMENT_SIZE];
-    segment_id_t * const circularBufferSegmentIdsPtr = &m_circularBufferSegmentIdsPtr[threadIndex * CIRCULAR_INDEX_BUFFER_SIZE];
+    boost::uint8_t * const circularBufferBlockDataPtr = &m_circularBufferBlockDataPtr[threadIndex * M_CIRCULAR_INDEX_BUFFER_SIZE * SEGMENT_SIZE];
+    segment_id_t * const circularBufferSegmentIdsPtr = &m_circularBufferSegmentIdsPtr[threadIndex * M_CIRCULAR_INDEX_BUFFER_SIZE];
 
     while (m_running || (cb.GetIndexForRead() != UINT32_MAX)) { //keep thread alive if running or cb not empty
 
@@ -88,8 +88,8 @@ void BundleStorageManagerMT::ThreadFunc(const unsigned int threadIndex) {
 
         boost::uint8_t * const data = &circularBufferBlockDataPtr[consumeIndex * SEGMENT_SIZE]; //expected data for testing when reading
         const segment_id_t segmentId = circularBufferSegmentIdsPtr[consumeIndex];
-        volatile boost::uint8_t * const readFromStorageDestPointer = m_circularBufferReadFromStoragePointers[threadIndex * CIRCULAR_INDEX_BUFFER_SIZE + consumeIndex];
-        volatile bool * const isReadCompletedPointer = m_circularBufferIsReadCompletedPointers[threadIndex * CIRCULAR_INDEX_BUFFER_SIZE + consumeIndex];
+        volatile boost::uint8_t * const readFromStorageDestPointer = m_circularBufferReadFromStoragePointers[threadIndex * M_CIRCULAR_INDEX_BUFFER_SIZE + consumeIndex];
+        volatile bool * const isReadCompletedPointer = m_circularBufferIsReadCompletedPointers[threadIndex * M_CIRCULAR_INDEX_BUFFER_SIZE + consumeIndex];
         const bool isWriteToDisk = (readFromStorageDestPointer == NULL);
         if (segmentId == UINT32_MAX) {
             std::cout << "error segmentId is max\n";
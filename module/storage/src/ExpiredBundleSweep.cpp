@@ -0,0 +1,345 @@
+/***************************************************************************
+ * NASA Glenn Research Center, Cleveland, OH
+ * Released under the NASA Open Source Agreement (NOSA)
+ * May  2021
+ *
+ ****************************************************************************
+ */
+
+#include "ExpiredBundleSweep.h"
+#include <iostream>
+#include <boost/lexical_cast.hpp>
+#include <boost/make_unique.hpp>
+#include "Logger.h"
+#include "Uri.h"
+#include "TimestampUtil.h"
+#include "codec/BundleViewV6.h"
+#include "codec/BundleViewV7.h"
+
+ExpiredBundleSweep::ExpiredBundleSweep(BundleStorageManagerBase & bsm, CustodyIdAllocator & custodyIdAllocator,
+    const cbhe_eid_t & hdtnEid, const uint64_t statusReportLifetimeSeconds) :
+    m_bsm(bsm),
+    m_custodyIdAllocator(custodyIdAllocator),
+    M_HDTN_EID(hdtnEid),
+    M_STATUS_REPORT_LIFETIME_SECONDS(statusReportLifetimeSeconds),
+    m_statusReportSequence(0),
+    m_totalBundlesErased(0),
+    m_totalDeletionStatusReports(0),
+    m_numBundles(0)
+{
+    m_expiredCustodyIdsVec.reserve(MAX_BUNDLES_PER_SLICE);
+}
+
+ExpiredBundleSweep::~ExpiredBundleSweep() {
+    //the disk threads may still be writing into the buffers
+    for (std::list<read_ahead_t>::iterator it = m_readAheadList.begin(); it != m_readAheadList.end(); ++it) {
+        while (!m_bsm.WaitForReadAheadProgress(it->session, boost::posix_time::milliseconds(10))) {}
+    }
+}
+
+bool ExpiredBundleSweep::CanStartSlice() const {
+    return (m_numBundles < MAX_BUNDLES_PER_SLICE);
+}
+
+bool ExpiredBundleSweep::StartSlice(const uint64_t nowSecondsSinceEpochRfc5050) {
+    const uint64_t maxExpiredToFind = MAX_BUNDLES_PER_SLICE - m_numBundles;
+    if (maxExpiredToFind == 0) {
+        return true;
+    }
+    m_bsm.GetExpiredBundleIds(MIN_ABS_EXPIRATION_SECONDS, nowSecondsSinceEpochRfc5050, maxExpiredToFind, m_expiredCustodyIdsVec);
+    for (std::size_t i = 0; i < m_expiredCustodyIdsVec.size(); ++i) {
+        const uint64_t custodyId = m_expiredCustodyIdsVec[i];
+        if (!PopAndStartRead(custodyId)) {
+            const std::string msg = "error unable to erase expired custody id " + boost::lexical_cast<std::string>(custodyId) + " from storage";
+            std::cerr << msg << "\n";
+            hdtn::Logger::getInstance()->logError("storage", msg);
+        }
+    }
+    return (m_expiredCustodyIdsVec.size() == maxExpiredToFind);
+}
+
+void ExpiredBundleSweep::ProcessFinishedReads() {
+    for (std::list<read_ahead_t>::iterator it = m_readAheadList.begin(); it != m_readAheadList.end(); ++it) {
+        m_bsm.QueueReadAheadSegments_NoBlock(it->session);
+    }
+    while (read_ahead_t * readAheadPtr = GetNextFinished()) {
+        const uint64_t custodyId = readAheadPtr->session.custodyId;
+        if (!m_bsm.FinishReadAhead(readAheadPtr->session)) {
+            const std::string msg = "error unable to read expired custody id " + boost::lexical_cast<std::string>(custodyId) + " from disk";
+            std::cerr << msg << "\n";
+            hdtn::Logger::getInstance()->logError("storage", msg);
+        }
+        else {
+            const STATUS_REPORT report = WriteDeletionStatusReport(m_bsm, m_custodyIdAllocator, readAheadPtr->buffer,
+                readAheadPtr->readingWholeBundle, M_HDTN_EID, M_STATUS_REPORT_LIFETIME_SECONDS, m_statusReportSequence);
+            if (report == STATUS_REPORT::NEEDS_WHOLE_BUNDLE) {
+                m_bsm.StartReadAhead(readAheadPtr->session, UINT32_MAX, readAheadPtr->buffer);
+                readAheadPtr->readingWholeBundle = true;
+                m_bsm.QueueReadAheadSegments_NoBlock(readAheadPtr->session);
+                continue;
+            }
+            if (report == STATUS_REPORT::WRITTEN) {
+                ++m_totalDeletionStatusReports;
+            }
+        }
+        if (m_bsm.RemoveReadBundleFromDisk(readAheadPtr->session.catalogEntryPtr, custodyId)) {
+            ++m_totalBundlesErased;
+        }
+        else {
+            const std::string msg = "error unable to erase expired custody id " + boost::lexical_cast<std::string>(custodyId) + " from storage";
+            std::cerr << msg << "\n";
+            hdtn::Logger::getInstance()->logError("storage", msg);
+        }
+        Remove(readAheadPtr);
+    }
+}
+
+bool ExpiredBundleSweep::IsEmpty() const {
+    return m_readAheadList.empty();
+}
+
+std::size_t ExpiredBundleSweep::GetNumBundlesInSlice() const {
+    return m_numBundles;
+}
+
+void ExpiredBundleSweep::WaitForProgress(const boost::posix_time::time_duration & timeout) {
+    for (std::list<read_ahead_t>::iterator it = m_readAheadList.begin(); it != m_readAheadList.end(); ++it) {
+        if (!m_bsm.IsReadAheadIdle(it->session)) {
+            m_bsm.WaitForReadAheadProgress(it->session, timeout);
+            return;
+        }
+    }
+}
+
+uint64_t ExpiredBundleSweep::GetTotalBundlesErased() const {
+    return m_totalBundlesErased;
+}
+
+uint64_t ExpiredBundleSweep::GetTotalDeletionStatusReports() const {
+    return m_totalDeletionStatusReports;
+}
+
+//takes the bundle off the awaiting send queue and starts reading its head, false if it is no longer awaiting send
+bool ExpiredBundleSweep::PopAndStartRead(const uint64_t custodyId) {
+    if (m_freeList.empty()) {
+        m_freeList.emplace_back();
+    }
+    read_ahead_t & readAhead = m_freeList.front();
+    if (m_bsm.PopAwaitingSend(readAhead.session, custodyId, 1, readAhead.buffer) == 0) {
+        return false;
+    }
+    readAhead.readingWholeBundle = (readAhead.session.numSegments == readAhead.session.catalogEntryPtr->segmentIdChainVec.size());
+    m_bsm.QueueReadAheadSegments_NoBlock(readAhead.session);
+    m_readAheadList.splice(m_readAheadList.end(), m_freeList, m_freeList.begin());
+    ++m_numBundles;
+    return true;
+}
+
+//the next bundle whose reads have all completed, else NULL
+ExpiredBundleSweep::read_ahead_t * ExpiredBundleSweep::GetNextFinished() {
+    for (std::list<read_ahead_t>::iterator it = m_readAheadList.begin(); it != m_readAheadList.end(); ++it) {
+        if (m_bsm.IsReadAheadComplete(it->session)) {
+            return &(*it);
+        }
+    }
+    return NULL;
+}
+
+void ExpiredBundleSweep::Remove(read_ahead_t * readAheadPtr) {
+    for (std::list<read_ahead_t>::iterator it = m_readAheadList.begin(); it != m_readAheadList.end(); ++it) {
+        if (&(*it) == readAheadPtr) {
+            m_freeList.splice(m_freeList.begin(), m_readAheadList, it);
+            --m_numBundles;
+            return;
+        }
+    }
+}
+
+bool WriteAdminRecordBundle(BundleStorageManagerBase & bsm, CustodyIdAllocator & custodyIdAllocator,
+    const PrimaryBlock & primary, const cbhe_eid_t & hdtnSrcEid, const uint8_t * bundleSerialized, const std::size_t bundleSize)
+{
+    const uint64_t newCustodyIdForAdminRecord = custodyIdAllocator.GetNextCustodyIdForNextHopCtebToSend(hdtnSrcEid);
+
+    BundleStorageManagerSession_WriteToDisk sessionWrite;
+    const uint64_t totalSegmentsRequired = bsm.Push(sessionWrite, primary, bundleSize);
+    //std::cout << "totalSegmentsRequired " << totalSegmentsRequired << "\n";
+    if (totalSegmentsRequired == 0) {
+        const std::string msg = "out of space for admin record";
+        std::cerr << msg << "\n";
+        hdtn::Logger::getInstance()->logError("storage", msg);
+        return false;
+    }
+
+    const uint64_t totalBytesPushed = bsm.PushAllSegments(sessionWrite, primary,
+        newCustodyIdForAdminRecord, bundleSerialized, bundleSize);
+    if (totalBytesPushed != bundleSize) {
+        const std::string msg = "totalBytesPushed != admin record bundle size";
+        std::cerr << msg << "\n";
+        hdtn::Logger::getInstance()->logError("storage", msg);
+        return false;
+    }
+    return true;
+}
+
+ExpiredBundleSweep::STATUS_REPORT ExpiredBundleSweep::WriteDeletionStatusReport(BundleStorageManagerBase & bsm, CustodyIdAllocator & custodyIdAllocator,
+    std::vector<uint8_t> & subjectBundleBuf, const bool isWholeBundle, const cbhe_eid_t & hdtnEid,
+    const uint64_t statusReportLifetimeSeconds, uint64_t & statusReportSequence)
+{
+    if (subjectBundleBuf.empty()) {
+        return STATUS_REPORT::NOT_WRITTEN;
+    }
+    const uint8_t firstByte = subjectBundleBuf[0];
+    const bool isBpVersion6 = (firstByte == 6);
+    const bool isBpVersion7 = (firstByte == ((4U << 5) | 31U));  //CBOR major type 4, additional information 31 (Indefinite-Length Array)
+    if (isBpVersion6) {
+        //decoded block by block since BundleViewV6 doesn't load fragments
+        Bpv6CbhePrimaryBlock subjectPrimary;
+        uint64_t decodedBlockSize;
+        if (!subjectPrimary.DeserializeBpv6(subjectBundleBuf.data(), decodedBlockSize, subjectBundleBuf.size())) {
+            return STATUS_REPORT::NOT_WRITTEN;
+        }
+        if (((subjectPrimary.m_bundleProcessingControlFlags & BPV6_BUNDLEFLAG::DELETION_STATUS_REPORTS_REQUESTED) == BPV6_BUNDLEFLAG::NO_FLAGS_SET)
+            || ((subjectPrimary.m_bundleProcessingControlFlags & BPV6_BUNDLEFLAG::ADMINRECORD) != BPV6_BUNDLEFLAG::NO_FLAGS_SET)
+            || (subjectPrimary.m_reportToEid.nodeId == 0))
+        {
+            return STATUS_REPORT::NOT_WRITTEN;
+        }
+        const bool isFragment = ((subjectPrimary.m_bundleProcessingControlFlags & BPV6_BUNDLEFLAG::ISFRAGMENT) != BPV6_BUNDLEFLAG::NO_FLAGS_SET);
+        uint64_t fragmentLength = 0;
+        if (isFragment) {
+            if (!isWholeBundle) {
+                return STATUS_REPORT::NEEDS_WHOLE_BUNDLE;
+            }
+            const uint8_t * serialization = subjectBundleBuf.data() + decodedBlockSize;
+            uint64_t bufferSize = subjectBundleBuf.size() - decodedBlockSize;
+            while (true) {
+                std::unique_ptr<Bpv6CanonicalBlock> blockPtr;
+                if (!Bpv6CanonicalBlock::DeserializeBpv6(blockPtr, serialization, decodedBlockSize, bufferSize, false)) {
+                    return STATUS_REPORT::NOT_WRITTEN;
+                }
+                if (blockPtr->m_blockTypeCode == BPV6_BLOCK_TYPE_CODE::PAYLOAD) {
+                    fragmentLength = blockPtr->m_blockTypeSpecificDataLength;
+                    break;
+                }
+                if ((blockPtr->m_blockProcessingControlFlags & BPV6_BLOCKFLAG::IS_LAST_BLOCK) != BPV6_BLOCKFLAG::NO_FLAGS_SET) {
+                    return STATUS_REPORT::NOT_WRITTEN; //no payload block
+                }
+                serialization += decodedBlockSize;
+                bufferSize -= decodedBlockSize;
+            }
+        }
+
+        BundleViewV6 reportBv;
+        Bpv6CbhePrimaryBlock & primary = reportBv.m_primaryBlockView.header;
+        primary.SetZero();
+        primary.m_bundleProcessingControlFlags = BPV6_BUNDLEFLAG::SINGLETON | BPV6_BUNDLEFLAG::NOFRAGMENT | BPV6_BUNDLEFLAG::ADMINRECORD;
+        primary.m_sourceNodeId = hdtnEid;
+        primary.m_destinationEid = subjectPrimary.m_reportToEid;
+        primary.m_creationTimestamp.secondsSinceStartOfYear2000 = TimestampUtil::GetSecondsSinceEpochRfc5050();
+        primary.m_creationTimestamp.sequenceNumber = statusReportSequence++;
+        primary.m_lifetimeSeconds = statusReportLifetimeSeconds;
+        reportBv.m_primaryBlockView.SetManuallyModified();
+        {
+            std::unique_ptr<Bpv6CanonicalBlock> blockPtr = boost::make_unique<Bpv6AdministrativeRecord>();
+            Bpv6AdministrativeRecord & block = *(reinterpret_cast<Bpv6AdministrativeRecord*>(blockPtr.get()));
+            block.m_blockProcessingControlFlags = BPV6_BLOCKFLAG::NO_FLAGS_SET;
+            block.m_adminRecordTypeCode = BPV6_ADMINISTRATIVE_RECORD_TYPE_CODE::BUNDLE_STATUS_REPORT;
+            block.m_isFragment = isFragment; //the record flags tell the decoder the fragment fields are present
+            block.m_adminRecordContentPtr = boost::make_unique<Bpv6AdministrativeRecordContentBundleStatusReport>();
+            Bpv6AdministrativeRecordContentBundleStatusReport & bsr = *(reinterpret_cast<Bpv6AdministrativeRecordContentBundleStatusReport*>(block.m_adminRecordContentPtr.get()));
+            bsr.Reset();
+            bsr.SetTimeOfDeletionOfBundleAndStatusFlag(TimestampUtil::GenerateDtnTimeNow());
+            bsr.m_reasonCode = BPV6_BUNDLE_STATUS_REPORT_REASON_CODES::LIFETIME_EXPIRED;
+            bsr.m_isFragment = isFragment;
+            bsr.m_fragmentOffsetIfPresent = subjectPrimary.m_fragmentOffset;
+            bsr.m_fragmentLengthIfPresent = fragmentLength;
+            bsr.m_copyOfBundleCreationTimestamp = subjectPrimary.m_creationTimestamp;
+            bsr.m_bundleSourceEid = Uri::GetIpnUriString(subjectPrimary.m_sourceNodeId.nodeId, subjectPrimary.m_sourceNodeId.serviceId);
+            reportBv.AppendMoveCanonicalBlock(blockPtr);
+        }
+        if (!reportBv.Render(CBHE_BPV6_MINIMUM_SAFE_PRIMARY_HEADER_ENCODE_SIZE + Bpv6AdministrativeRecordContentBundleStatusReport::CBHE_MAX_SERIALIZATION_SIZE)) {
+            return STATUS_REPORT::NOT_WRITTEN;
+        }
+        return (WriteAdminRecordBundle(bsm, custodyIdAllocator, primary, hdtnEid,
+            (const uint8_t*)reportBv.m_renderedBundle.data(), reportBv.m_renderedBundle.size())) ? STATUS_REPORT::WRITTEN : STATUS_REPORT::NOT_WRITTEN;
+    }
+    else if (isBpVersion7) {
+        //decoded block by block since BundleViewV7 doesn't load fragments
+        Bpv7CbhePrimaryBlock subjectPrimary;
+        uint64_t decodedBlockSize;
+        if (!subjectPrimary.DeserializeBpv7(subjectBundleBuf.data() + 1, decodedBlockSize, subjectBundleBuf.size() - 1)) { //after the array start
+            return STATUS_REPORT::NOT_WRITTEN;
+        }
+        if (((subjectPrimary.m_bundleProcessingControlFlags & BPV7_BUNDLEFLAG::DELETION_STATUS_REPORTS_REQUESTED) == BPV7_BUNDLEFLAG::NO_FLAGS_SET)
+            || ((subjectPrimary.m_bundleProcessingControlFlags & BPV7_BUNDLEFLAG::ADMINRECORD) != BPV7_BUNDLEFLAG::NO_FLAGS_SET)
+            || (subjectPrimary.m_reportToEid.nodeId == 0))
+        {
+            return STATUS_REPORT::NOT_WRITTEN;
+        }
+        const bool isFragment = ((subjectPrimary.m_bundleProcessingControlFlags & BPV7_BUNDLEFLAG::ISFRAGMENT) != BPV7_BUNDLEFLAG::NO_FLAGS_SET);
+        uint64_t fragmentLength = 0;
+        if (isFragment) {
+            if (!isWholeBundle) {
+                return STATUS_REPORT::NEEDS_WHOLE_BUNDLE;
+            }
+            uint8_t * serialization = subjectBundleBuf.data() + 1 + decodedBlockSize;
+            uint64_t bufferSize = subjectBundleBuf.size() - (1 + decodedBlockSize);
+            while (true) { //the payload block is always last
+                std::unique_ptr<Bpv7CanonicalBlock> blockPtr;
+                if (!Bpv7CanonicalBlock::DeserializeBpv7(blockPtr, serialization, decodedBlockSize, bufferSize, true, false)) {
+                    return STATUS_REPORT::NOT_WRITTEN;
+                }
+                if (blockPtr->m_blockTypeCode == BPV7_BLOCK_TYPE_CODE::PAYLOAD) {
+                    fragmentLength = blockPtr->m_dataLength;
+                    break;
+                }
+                serialization += decodedBlockSize;
+                bufferSize -= decodedBlockSize;
+            }
+        }
+
+        BundleViewV7 reportBv;
+        Bpv7CbhePrimaryBlock & primary = reportBv.m_primaryBlockView.header;
+        primary.SetZero();
+        primary.m_bundleProcessingControlFlags = BPV7_BUNDLEFLAG::NOFRAGMENT | BPV7_BUNDLEFLAG::ADMINRECORD;
+        primary.m_sourceNodeId = hdtnEid;
+        primary.m_destinationEid = subjectPrimary.m_reportToEid;
+        primary.m_reportToEid.Set(0, 0);
+        const uint64_t nowMilliseconds = TimestampUtil::GetMillisecondsSinceEpochRfc5050();
+        primary.m_creationTimestamp.millisecondsSinceStartOfYear2000 = nowMilliseconds;
+        primary.m_creationTimestamp.sequenceNumber = statusReportSequence++;
+        primary.m_lifetimeMilliseconds = statusReportLifetimeSeconds * 1000;
+        primary.m_crcType = BPV7_CRC_TYPE::CRC32C;
+        reportBv.m_primaryBlockView.SetManuallyModified();
+        {
+            std::unique_ptr<Bpv7CanonicalBlock> blockPtr = boost::make_unique<Bpv7AdministrativeRecord>();
+            Bpv7AdministrativeRecord & block = *(reinterpret_cast<Bpv7AdministrativeRecord*>(blockPtr.get()));
+            block.m_blockProcessingControlFlags = BPV7_BLOCKFLAG::NO_FLAGS_SET;
+            block.m_crcType = BPV7_CRC_TYPE::CRC32C;
+            block.m_adminRecordTypeCode = BPV7_ADMINISTRATIVE_RECORD_TYPE_CODE::BUNDLE_STATUS_REPORT;
+            block.m_adminRecordContentPtr = boost::make_unique<Bpv7AdministrativeRecordContentBundleStatusReport>();
+            Bpv7AdministrativeRecordContentBundleStatusReport & bsr = *(reinterpret_cast<Bpv7AdministrativeRecordContentBundleStatusReport*>(block.m_adminRecordContentPtr.get()));
+            bsr.m_reportStatusTimeFlagWasSet = ((subjectPrimary.m_bundleProcessingControlFlags & BPV7_BUNDLEFLAG::STATUSTIME_REQUESTED) != BPV7_BUNDLEFLAG::NO_FLAGS_SET);
+            for (std::size_t i = 0; i < bsr.m_bundleStatusInfo.size(); ++i) {
+                bsr.m_bundleStatusInfo[i].first = false;
+                bsr.m_bundleStatusInfo[i].second = 0;
+            }
+            //reporting-node-deleted-bundle
+            bsr.m_bundleStatusInfo[3].first = true;
+            bsr.m_bundleStatusInfo[3].second = (bsr.m_reportStatusTimeFlagWasSet) ? nowMilliseconds : 0;
+            bsr.m_statusReportReasonCode = BPV7_STATUS_REPORT_REASON_CODE::LIFETIME_EXPIRED;
+            bsr.m_sourceNodeEid = subjectPrimary.m_sourceNodeId;
+            bsr.m_creationTimestamp = subjectPrimary.m_creationTimestamp;
+            bsr.m_subjectBundleIsFragment = isFragment;
+            bsr.m_optionalSubjectPayloadFragmentOffset = subjectPrimary.m_fragmentOffset;
+            bsr.m_optionalSubjectPayloadFragmentLength = fragmentLength;
+            reportBv.AppendMoveCanonicalBlock(blockPtr);
+        }
+        if (!reportBv.Render(5000)) {
+            return STATUS_REPORT::NOT_WRITTEN;
+        }
+        return (WriteAdminRecordBundle(bsm, custodyIdAllocator, primary, hdtnEid,
+            (const uint8_t*)reportBv.m_renderedBundle.data(), reportBv.m_renderedBundle.size())) ? STATUS_REPORT::WRITTEN : STATUS_REPORT::NOT_WRITTEN;
+    }
+    return STATUS_REPORT::NOT_WRITTEN;
+}
@@ -11,6 +11,7 @@
 #include <iostream>
 #include <string>
 #include <inttypes.h>
+#include <algorithm>
 #ifdef USE_BITTEST
 # include <immintrin.h>
 # ifdef HAVE_INTRIN_H
@@ -31,25 +32,33 @@
 
  //static uint64_t g_numLeaves = 0;
 
-MemoryManagerTreeArray::MemoryManagerTreeArray(const uint64_t maxSegments) : M_MAX_SEGMENTS(maxSegments) {
+MemoryManagerTreeArray::MemoryManagerTreeArray(const uint64_t maxSegments) : M_MAX_SEGMENTS(maxSegments), m_nextFitLeafBlockIndex(0) {
     SetupTree();
 }
 MemoryManagerTreeArray::~MemoryManagerTreeArray() {
     FreeTree();
 }
 
+//Rows are stored in segment id order (the child of bit "index" in row "rowIndex" is row (rowIndex * 64) + index),
+//so each depth only needs enough rows to cover M_MAX_SEGMENTS rather than 64^depth rows.
+//Bits with no segment or child row behind them are 0 (allocated) so they are never descended into.
 void MemoryManagerTreeArray::SetupTree() {
-    for (unsigned int i = 0; i < MAX_TREE_ARRAY_DEPTH; ++i) {
-        const uint64_t arraySize64s = (((uint64_t)1) << (i * 6));
+    uint64_t numValidBits = M_MAX_SEGMENTS; //at the leaf depth
+    for (int i = MAX_TREE_ARRAY_DEPTH - 1; i >= 0; --i) {
+        const uint64_t arraySize64s = std::max<uint64_t>(1, (numValidBits + 63) >> 6);
+        m_arraySize64s[i] = arraySize64s;
         //std::cout << i << " " << arraySize64s << "\n";
         m_bitMasks[i] = (uint64_t*)malloc(arraySize64s * sizeof(uint64_t));
         uint64_t * const currentArrayPtr = m_bitMasks[i];
         for (uint64_t j = 0; j < arraySize64s; ++j) {
             currentArrayPtr[j] = UINT64_MAX;
         }
+        const uint64_t numValidBitsInLastRow = numValidBits & 63;
+        if ((numValidBits == 0) || numValidBitsInLastRow) {
+            currentArrayPtr[arraySize64s - 1] = (((uint64_t)1) << numValidBitsInLastRow) - 1;
+        }
+        numValidBits = (numValidBits) ? arraySize64s : 0; //each row of this depth is a valid bit of the parent depth
     }
-
-
 }
 
 
@@ -59,10 +68,18 @@ void MemoryManagerTreeArray::FreeTree() {
     }
 }
 
+uint64_t MemoryManagerTreeArray::GetBitMaskMemoryUsageBytes() const {
+    uint64_t numBytes = 0;
+    for (unsigned int i = 0; i < MAX_TREE_ARRAY_DEPTH; ++i) {
+        numBytes += m_arraySize64s[i] * sizeof(uint64_t);
+    }
+    return numBytes;
+}
+
 void MemoryManagerTreeArray::BackupDataToVector(backup_memmanager_t & backup) const {
     backup.resize(MAX_TREE_ARRAY_DEPTH);
     for (unsigned int i = 0; i < MAX_TREE_ARRAY_DEPTH; ++i) {
-        const uint64_t arraySize64s = (((uint64_t)1) << (i * 6));
+        const uint64_t arraySize64s = m_arraySize64s[i];
         std::vector<uint64_t> & row = backup[i];
         row.resize(arraySize64s);
         const uint64_t * const currentArrayPtr = m_bitMasks[i];
@@ -73,9 +90,11 @@ void MemoryManagerTreeArray::BackupDataToVector(backup_memmanager_t & backup) co
 }
 
 bool MemoryManagerTreeArray::IsBackupEqual(const backup_memmanager_t & backup) const {
+    if (backup.size() != MAX_TREE_ARRAY_DEPTH) return false;
     for (unsigned int i = 0; i < MAX_TREE_ARRAY_DEPTH; ++i) {
-        const uint64_t arraySize64s = (((uint64_t)1) << (i * 6));
+        const uint64_t arraySize64s = m_arraySize64s[i];
         const std::vector<uint64_t> & row = backup[i];
+        if (row.size() != arraySize64s) return false;
         const uint64_t * const currentArrayPtr = m_bitMasks[i];
         for (uint64_t j = 0; j < arraySize64s; ++j) {
             if (row[j] != currentArrayPtr[j]) return false;
@@ -93,7 +112,7 @@ bool MemoryManagerTreeArray::GetAndSetFirstFreeSegmentId(const uint32_t depthInd
     *segmentId += firstFreeIndex * (1 << (((MAX_TREE_ARRAY_DEPTH - 1) - depthIndex) * 6)); // 64^depth
 
 
-    if ((depthIndex == MAX_TREE_ARRAY_DEPTH - 1) || GetAndSetFirstFreeSegmentId(depthIndex + 1, rowIndex + firstFreeIndex * (1 << (depthIndex * 6)), segmentId)) {
+    if ((depthIndex == MAX_TREE_ARRAY_DEPTH - 1) || GetAndSetFirstFreeSegmentId(depthIndex + 1, (rowIndex << 6) + firstFreeIndex, segmentId)) {
         if (*segmentId < M_MAX_SEGMENTS) {
 #ifdef USE_BITTEST
             _bittestandreset64((int64_t*)currentBit64Ptr, firstFreeIndex);
@@ -150,11 +169,12 @@ bool MemoryManagerTreeArray::IsSegmentFree(const uint32_t depthIndex, const uint
 #endif
     }
     else { //inner node
-        return IsSegmentFree(depthIndex + 1, rowIndex + index * (1 << (depthIndex * 6)), segmentId);
+        return IsSegmentFree(depthIndex + 1, (rowIndex << 6) + index, segmentId);
     }
 }
 
 bool MemoryManagerTreeArray::IsSegmentFree(segment_id_t segmentId) {
+    if (segmentId >= M_MAX_SEGMENTS) return true; //never allocated (RestoreFromDisk relies on this to reach the end of the files)
     return IsSegmentFree(0, 0, segmentId);
 }
 
@@ -169,7 +189,7 @@ void MemoryManagerTreeArray::FreeSegmentId(const uint32_t depthIndex, const uint
         *success = !bitWasAlreadyOne; //error if leaf bit is already 1 (empty)
     }
     else { //inner node
-        FreeSegmentId(depthIndex + 1, rowIndex + index * (1 << (depthIndex * 6)), segmentId, success);
+        FreeSegmentId(depthIndex + 1, (rowIndex << 6) + index, segmentId, success);
     }
 #else
     const uint64_t mask64 = (((uint64_t)1) << index);
@@ -181,7 +201,7 @@ void MemoryManagerTreeArray::FreeSegmentId(const uint32_t depthIndex, const uint
         *success = ((*currentBit64Ptr & mask64) == 0);
     }
     else { //inner node
-        FreeSegmentId(depthIndex + 1, rowIndex + index * (1 << (depthIndex * 6)), segmentId, success);
+        FreeSegmentId(depthIndex + 1, (rowIndex << 6) + index, segmentId, success);
     }
     *currentBit64Ptr |= mask64;
 #endif
@@ -193,7 +213,7 @@ bool MemoryManagerTreeArray::AllocateSegmentId_NoCheck(const uint32_t depthIndex
     uint64_t * const currentBit64Ptr = &currentArrayPtr[rowIndex];
     const unsigned int index = (segmentId >> (((MAX_TREE_ARRAY_DEPTH - 1) - depthIndex) * 6)) & 63;
 
-    if ((depthIndex == MAX_TREE_ARRAY_DEPTH - 1) || AllocateSegmentId_NoCheck(depthIndex + 1, rowIndex + index * (1 << (depthIndex * 6)), segmentId)) {
+    if ((depthIndex == MAX_TREE_ARRAY_DEPTH - 1) || AllocateSegmentId_NoCheck(depthIndex + 1, (rowIndex << 6) + index, segmentId)) {
         if (segmentId < M_MAX_SEGMENTS) {
 #ifdef USE_BITTEST
             _bittestandreset64((int64_t*)currentBit64Ptr, index);
@@ -214,10 +234,12 @@ bool MemoryManagerTreeArray::AllocateSegmentId_NoCheck(const uint32_t depthIndex
 }
 
 void MemoryManagerTreeArray::AllocateSegmentId_NoCheck_NotThreadSafe(segment_id_t segmentId) {
+    if (segmentId >= M_MAX_SEGMENTS) return; //no bits exist for this segment
     AllocateSegmentId_NoCheck(0, 0, segmentId);
 }
 
 bool MemoryManagerTreeArray::FreeSegmentId_NotThreadSafe(segment_id_t segmentId) {
+    if (segmentId >= M_MAX_SEGMENTS) return false;
     bool success = true;
     FreeSegmentId(0, 0, segmentId, &success);
     return success;
@@ -225,6 +247,10 @@ bool MemoryManagerTreeArray::FreeSegmentId_NotThreadSafe(segment_id_t segmentId)
 
 bool MemoryManagerTreeArray::AllocateSegments_ThreadSafe(segment_id_chain_vec_t & segmentVec) { //number of segments should be the vector size
     boost::mutex::scoped_lock lock(m_mutex);
+    return AllocateSegments_NotThreadSafe(segmentVec);
+}
+
+bool MemoryManagerTreeArray::AllocateSegments_NotThreadSafe(segment_id_chain_vec_t & segmentVec) {
     const std::size_t size = segmentVec.size();
     for (std::size_t i = 0; i < size; ++i) {
         const segment_id_t segmentId = GetAndSetFirstFreeSegmentId_NotThreadSafe();
@@ -256,3 +282,161 @@ bool MemoryManagerTreeArray::FreeSegments_ThreadSafe(const segment_id_chain_vec_
 }
 
 
+
+//leaf bits (1 = free) of segments [leafBlockIndex*64, leafBlockIndex*64 + 63] (bits at or beyond M_MAX_SEGMENTS are 0)
+uint64_t MemoryManagerTreeArray::GetLeafFreeMask(const uint64_t leafBlockIndex) const {
+    return m_bitMasks[MAX_TREE_ARRAY_DEPTH - 1][leafBlockIndex];
+}
+
+//true if the 64 leaf blocks starting at leafBlockIndex (which must be a multiple of 64) have no free segments
+bool MemoryManagerTreeArray::IsLeafBlockGroupFull(const uint64_t leafBlockIndex) const {
+    return (m_bitMasks[MAX_TREE_ARRAY_DEPTH - 2][leafBlockIndex >> 6] == 0);
+}
+
+//search (in segment id order) of the leaf masks using ctz on each mask (whole groups of 64 full masks are skipped using the parent row)
+//for the first run of numSegments free segments starting within leaf blocks [startLeafBlockIndex, endLeafBlockIndex)
+bool MemoryManagerTreeArray::FindFreeRun_NotThreadSafe(const uint64_t numSegments, const uint64_t startLeafBlockIndex, const uint64_t endLeafBlockIndex, segment_id_t & runStartSegmentId) const {
+    const uint64_t numLeafBlocks = (M_MAX_SEGMENTS + 63) >> 6;
+    uint64_t runStart = 0;
+    uint64_t runLength = 0;
+    for (uint64_t leafBlockIndex = startLeafBlockIndex; leafBlockIndex < numLeafBlocks; ++leafBlockIndex) {
+        if ((runLength == 0) && (leafBlockIndex >= endLeafBlockIndex)) {
+            break;
+        }
+        if (((leafBlockIndex & 63) == 0) && IsLeafBlockGroupFull(leafBlockIndex)) {
+            runLength = 0;
+            leafBlockIndex += 63;
+            continue;
+        }
+        const uint64_t firstSegmentId = leafBlockIndex << 6;
+        const uint64_t freeMask = GetLeafFreeMask(leafBlockIndex);
+        if (freeMask == UINT64_MAX) {
+            if (runLength == 0) {
+                runStart = firstSegmentId;
+            }
+            runLength += 64;
+        }
+        else {
+            unsigned int bitIndex = 0;
+            while (bitIndex < 64) {
+                const uint64_t remainingFreeMask = freeMask >> bitIndex;
+                if (remainingFreeMask == 0) { //rest of this mask allocated
+                    runLength = 0;
+                    break;
+                }
+                const unsigned int numAllocated = boost::multiprecision::detail::find_lsb<uint64_t>(remainingFreeMask);
+                if (numAllocated) {
+                    runLength = 0;
+                    bitIndex += numAllocated;
+                }
+                const unsigned int numFree = boost::multiprecision::detail::find_lsb<uint64_t>(~(freeMask >> bitIndex)); //nonzero since freeMask != UINT64_MAX
+                if (runLength == 0) {
+                    runStart = firstSegmentId + bitIndex;
+                }
+                runLength += numFree;
+                bitIndex += numFree;
+                if (runLength >= numSegments) {
+                    break;
+                }
+            }
+        }
+        if (runLength >= numSegments) {
+            runStartSegmentId = static_cast<segment_id_t>(runStart);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool MemoryManagerTreeArray::AllocateContiguousSegments_ThreadSafe(segment_id_chain_vec_t & segmentVec) { //number of segments should be the vector size
+    boost::mutex::scoped_lock lock(m_mutex);
+    const std::size_t size = segmentVec.size();
+    segment_id_t runStartSegmentId;
+    const uint64_t numLeafBlocks = (M_MAX_SEGMENTS + 63) >> 6;
+    if (m_nextFitLeafBlockIndex >= numLeafBlocks) {
+        m_nextFitLeafBlockIndex = 0;
+    }
+    if ((size > 1) && (FindFreeRun_NotThreadSafe(size, m_nextFitLeafBlockIndex, numLeafBlocks, runStartSegmentId)
+        || FindFreeRun_NotThreadSafe(size, 0, m_nextFitLeafBlockIndex, runStartSegmentId)))
+    {
+        m_nextFitLeafBlockIndex = (runStartSegmentId + size) >> 6;
+        for (std::size_t i = 0; i < size; ++i) {
+            const segment_id_t segmentId = runStartSegmentId + static_cast<segment_id_t>(i);
+            AllocateSegmentId_NoCheck_NotThreadSafe(segmentId);
+            segmentVec[i] = segmentId;
+        }
+        return true;
+    }
+    //no single run is long enough, fill the lowest free segments instead
+    return AllocateSegments_NotThreadSafe(segmentVec);
+}
+
+void MemoryManagerTreeArray::GetDiskExtents(const segment_id_chain_vec_t & segmentVec, const unsigned int numDisks, disk_extents_per_disk_t & extentsPerDisk) {
+    extentsPerDisk.resize(numDisks);
+    for (unsigned int diskId = 0; diskId < numDisks; ++diskId) {
+        extentsPerDisk[diskId].clear();
+    }
+    for (std::size_t i = 0; i < segmentVec.size(); ++i) {
+        const segment_id_t segmentId = segmentVec[i];
+        std::vector<disk_segment_extent_t> & extents = extentsPerDisk[segmentId % numDisks];
+        const uint64_t diskSegmentIndex = segmentId / numDisks;
+        if ((!extents.empty()) && ((extents.back().startDiskSegmentIndex + extents.back().numSegments) == diskSegmentIndex)) {
+            ++extents.back().numSegments;
+        }
+        else {
+            extents.push_back(disk_segment_extent_t());
+            extents.back().startDiskSegmentIndex = diskSegmentIndex;
+            extents.back().numSegments = 1;
+        }
+    }
+}
+
+void MemoryManagerTreeArray::GetFragmentationStats_ThreadSafe(memory_manager_fragmentation_stats_t & stats) {
+    boost::mutex::scoped_lock lock(m_mutex);
+    stats.totalFreeSegments = 0;
+    stats.numFreeExtents = 0;
+    stats.largestFreeExtentSegments = 0;
+    const uint64_t numLeafBlocks = (M_MAX_SEGMENTS + 63) >> 6;
+    uint64_t runLength = 0;
+    for (uint64_t leafBlockIndex = 0; leafBlockIndex <= numLeafBlocks; ++leafBlockIndex) {
+        uint64_t freeMask = 0; //one past the end closes the last run
+        if (leafBlockIndex < numLeafBlocks) {
+            if (((leafBlockIndex & 63) == 0) && IsLeafBlockGroupFull(leafBlockIndex)) {
+                leafBlockIndex += 63; //freeMask of 0 closes any open run
+                if (leafBlockIndex >= numLeafBlocks) {
+                    leafBlockIndex = numLeafBlocks - 1;
+                }
+            }
+            else {
+                freeMask = GetLeafFreeMask(leafBlockIndex);
+            }
+        }
+        unsigned int bitIndex = 0;
+        while (true) {
+            const uint64_t remainingFreeMask = (bitIndex < 64) ? (freeMask >> bitIndex) : 0;
+            if (remainingFreeMask == 0) {
+                if (runLength && (bitIndex < 64)) { //run ends within this mask
+                    ++stats.numFreeExtents;
+                    stats.totalFreeSegments += runLength;
+                    stats.largestFreeExtentSegments = std::max(stats.largestFreeExtentSegments, runLength);
+                    runLength = 0;
+                }
+                break;
+            }
+            const unsigned int numAllocated = boost::multiprecision::detail::find_lsb<uint64_t>(remainingFreeMask);
+            if (numAllocated && runLength) {
+                ++stats.numFreeExtents;
+                stats.totalFreeSegments += runLength;
+                stats.largestFreeExtentSegments = std::max(stats.largestFreeExtentSegments, runLength);
+                runLength = 0;
+            }
+            bitIndex += numAllocated;
+            const uint64_t remainingAfter = freeMask >> bitIndex;
+            const unsigned int numFree = (remainingAfter == UINT64_MAX) ? 64 : boost::multiprecision::detail::find_lsb<uint64_t>(~remainingAfter);
+            runLength += numFree;
+            bitIndex += numFree;
+        }
+    }
+    stats.fragmentation = (stats.totalFreeSegments) ?
+        (1.0 - (static_cast<double>(stats.largestFreeExtentSegments) / static_cast<double>(stats.totalFreeSegments))) : 0.0;
+}
@@ -0,0 +1,266 @@
+/***************************************************************************
+ * NASA Glenn Research Center, Cleveland, OH
+ * Released under the NASA Open Source Agreement (NOSA)
+ * May  2021
+ *
+ ****************************************************************************
+ */
+
+#include "ReleaseReadAheadPipeline.h"
+#include <iostream>
+#include <algorithm>
+#include "Logger.h"
+
+ReleaseBufferPool::ReleaseBufferPool(const std::size_t maxFreeBuffers, const std::size_t maxFreeBufferCapacityBytes) :
+    M_MAX_FREE_BUFFERS(maxFreeBuffers), M_MAX_FREE_BUFFER_CAPACITY_BYTES(maxFreeBufferCapacityBytes)
+{
+    m_freeBuffersVec.reserve(maxFreeBuffers);
+}
+
+ReleaseBufferPool::~ReleaseBufferPool() {
+    for (std::size_t i = 0; i < m_freeBuffersVec.size(); ++i) {
+        delete m_freeBuffersVec[i];
+    }
+}
+
+pooled_release_buffer_t * ReleaseBufferPool::Get_ThreadSafe() {
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+        if (!m_freeBuffersVec.empty()) {
+            pooled_release_buffer_t * buffer = m_freeBuffersVec.back();
+            m_freeBuffersVec.pop_back();
+            return buffer;
+        }
+    }
+    return new pooled_release_buffer_t();
+}
+
+void ReleaseBufferPool::Return_ThreadSafe(pooled_release_buffer_t * buffer) {
+    if (buffer->data.capacity() <= M_MAX_FREE_BUFFER_CAPACITY_BYTES) { //don't hold on to the memory of an occasional huge bundle
+        boost::mutex::scoped_lock lock(m_mutex);
+        if (m_freeBuffersVec.size() < M_MAX_FREE_BUFFERS) {
+            m_freeBuffersVec.push_back(buffer);
+            return;
+        }
+    }
+    delete buffer;
+}
+
+std::size_t ReleaseBufferPool::GetNumFreeBuffers_ThreadSafe() {
+    boost::mutex::scoped_lock lock(m_mutex);
+    return m_freeBuffersVec.size();
+}
+
+static void CustomCleanupPooledReleaseBuffer(void *data, void *hint) {
+    pooled_release_buffer_t * buffer = static_cast<pooled_release_buffer_t*>(hint);
+    boost::shared_ptr<ReleaseBufferPool> poolPtr;
+    poolPtr.swap(buffer->poolPtr);
+    if (poolPtr) { //NULL if reclaimed by the read ahead pipeline (the message was never sent)
+        poolPtr->Return_ThreadSafe(buffer);
+    }
+}
+
+ReleaseReadAheadPipeline::ReleaseReadAheadPipeline(BundleStorageManagerBase & bsm, const boost::shared_ptr<ReleaseBufferPool> & releaseBufferPoolPtr,
+    const std::size_t maxBundles, const uint64_t maxBytes) :
+    m_bsm(bsm), m_releaseBufferPoolPtr(releaseBufferPoolPtr), M_MAX_BUNDLES(maxBundles), M_MAX_BYTES(maxBytes), m_numBytes(0)
+{
+    m_blockedDestEidsVec.reserve(maxBundles);
+}
+
+ReleaseReadAheadPipeline::~ReleaseReadAheadPipeline() {
+    //the disk threads may still be writing into the buffers
+    for (std::list<read_ahead_t>::iterator it = m_readAheadList.begin(); it != m_readAheadList.end(); ++it) {
+        while (!m_bsm.WaitForReadAheadProgress(it->session, boost::posix_time::milliseconds(10))) {}
+        m_releaseBufferPoolPtr->Return_ThreadSafe(it->bufferPtr);
+    }
+}
+
+bool ReleaseReadAheadPipeline::IsEmpty() const {
+    return m_readAheadList.empty();
+}
+
+bool ReleaseReadAheadPipeline::IsFull() const {
+    return (m_readAheadList.size() >= M_MAX_BUNDLES) || (m_numBytes >= M_MAX_BYTES);
+}
+
+std::size_t ReleaseReadAheadPipeline::GetNumBundles() const {
+    return m_readAheadList.size();
+}
+
+uint64_t ReleaseReadAheadPipeline::GetNumBytes() const {
+    return m_numBytes;
+}
+
+const ReleaseReadAheadPipeline::read_ahead_t * ReleaseReadAheadPipeline::PopAndStartRead(const std::vector<std::pair<cbhe_eid_t, bool> > & availableDestLinks) {
+    if (m_freeList.empty()) {
+        m_freeList.emplace_back();
+    }
+    read_ahead_t & readAhead = m_freeList.front();
+    readAhead.bufferPtr = m_releaseBufferPoolPtr->Get_ThreadSafe();
+    const uint64_t bundleSizeBytes = m_bsm.PopTop(readAhead.session, availableDestLinks, readAhead.bufferPtr->data);
+    if ((bundleSizeBytes == 0) || ((!m_readAheadList.empty()) && ((m_numBytes + bundleSizeBytes) > M_MAX_BYTES))) {
+        if (bundleSizeBytes) {
+            m_bsm.ReturnTop(readAhead.session);
+        }
+        m_releaseBufferPoolPtr->Return_ThreadSafe(readAhead.bufferPtr);
+        return NULL;
+    }
+    readAhead.destEid = readAhead.session.catalogEntryPtr->destEid;
+    readAhead.bundleSizeBytes = bundleSizeBytes;
+    readAhead.hasCustody = readAhead.session.catalogEntryPtr->HasCustody();
+    readAhead.priorityIndex = readAhead.session.catalogEntryPtr->GetPriorityIndex();
+    readAhead.status = READ_AHEAD_STATUS::READING;
+    m_numBytes += bundleSizeBytes;
+    m_bsm.QueueReadAheadSegments_NoBlock(readAhead.session);
+    m_readAheadList.splice(m_readAheadList.end(), m_freeList, m_freeList.begin());
+    return &readAhead;
+}
+
+void ReleaseReadAheadPipeline::QueueReads_NoBlock() {
+    for (std::list<read_ahead_t>::iterator it = m_readAheadList.begin(); it != m_readAheadList.end(); ++it) {
+        if (it->status == READ_AHEAD_STATUS::READING) {
+            m_bsm.QueueReadAheadSegments_NoBlock(it->session);
+        }
+    }
+}
+
+bool ReleaseReadAheadPipeline::Cancel(const uint64_t custodyId) {
+    for (std::list<read_ahead_t>::iterator it = m_readAheadList.begin(); it != m_readAheadList.end(); ++it) {
+        if ((it->session.custodyId == custodyId) && (it->status != READ_AHEAD_STATUS::CANCELED)) {
+            it->status = READ_AHEAD_STATUS::CANCELED;
+            return true;
+        }
+    }
+    return false;
+}
+
+//the next finished bundle (READY, FAILED or CANCELED) that no earlier bundle to the same destination is waiting on, else NULL
+ReleaseReadAheadPipeline::read_ahead_t * ReleaseReadAheadPipeline::GetNextFinished() {
+    m_blockedDestEidsVec.resize(0);
+    for (std::list<read_ahead_t>::iterator it = m_readAheadList.begin(); it != m_readAheadList.end(); ++it) {
+        read_ahead_t & readAhead = *it;
+        if (readAhead.status == READ_AHEAD_STATUS::CANCELED) {
+            if (m_bsm.IsReadAheadIdle(readAhead.session)) {
+                return &readAhead;
+            }
+            continue;
+        }
+        if (std::find(m_blockedDestEidsVec.cbegin(), m_blockedDestEidsVec.cend(), readAhead.destEid) != m_blockedDestEidsVec.cend()) {
+            continue;
+        }
+        if (readAhead.status == READ_AHEAD_STATUS::READING) {
+            if (!m_bsm.IsReadAheadComplete(readAhead.session)) {
+                m_blockedDestEidsVec.push_back(readAhead.destEid);
+                continue;
+            }
+            readAhead.status = (m_bsm.FinishReadAhead(readAhead.session)) ? READ_AHEAD_STATUS::READY : READ_AHEAD_STATUS::FAILED;
+        }
+        return &readAhead;
+    }
+    return NULL;
+}
+
+std::size_t ReleaseReadAheadPipeline::ProcessFinishedReads_NoBlock(InterModuleChannelSender<hdtn::ToEgressHdr> & toEgressChannelSender,
+    SharedMemoryBundleArena * sharedMemoryBundleArenaPtr, ReleaseWindowManager & releaseWindowManager, CustodyTimers & custodyTimers,
+    std::size_t & totalBundlesSentToEgress, bool & egressFull)
+{
+    std::size_t numRemoved = 0;
+    egressFull = false;
+    while (read_ahead_t * readAheadPtr = GetNextFinished()) {
+        if (readAheadPtr->status == READ_AHEAD_STATUS::READY) {
+            if (!SendToEgress_NoBlock(readAheadPtr, toEgressChannelSender, sharedMemoryBundleArenaPtr)) {
+                egressFull = true; //resend later
+                break;
+            }
+            if (readAheadPtr->hasCustody) {
+                custodyTimers.StartCustodyTransferTimer(readAheadPtr->destEid, readAheadPtr->session.custodyId);
+            }
+            ++totalBundlesSentToEgress;
+        }
+        else {
+            if (readAheadPtr->status == READ_AHEAD_STATUS::FAILED) {
+                std::cout << "error: unable to read all segments from disk\n";
+                hdtn::Logger::getInstance()->logError("storage", "error: unable to read all segments from disk");
+            }
+            releaseWindowManager.OnCanceled(readAheadPtr->session.custodyId); //failed or canceled, egress will never ack it
+        }
+        Remove(readAheadPtr);
+        ++numRemoved;
+    }
+    return numRemoved;
+}
+
+//false if egress can't take it right now (the bundle stays in the pipeline to be sent later).
+//With a shared memory arena (NULL if none) the bundle is copied into a free slab and only its descriptor is sent,
+//falling back to sending the read ahead buffer itself if the bundle is too big for a slab or no slab is free.
+bool ReleaseReadAheadPipeline::SendToEgress_NoBlock(read_ahead_t * readAheadPtr, InterModuleChannelSender<hdtn::ToEgressHdr> & toEgressChannelSender,
+    SharedMemoryBundleArena * sharedMemoryBundleArenaPtr)
+{
+    shm_bundle_descriptor_t shmDescriptor;
+    const bool bundleInSharedMemory = (sharedMemoryBundleArenaPtr != NULL)
+        && sharedMemoryBundleArenaPtr->CopyIn(readAheadPtr->bufferPtr->data.data(), readAheadPtr->bufferPtr->data.size(), shmDescriptor);
+
+    hdtn::ToEgressHdr toEgressHdr;
+    //memset 0 not needed because all values set below
+    toEgressHdr.base.type = HDTN_MSGTYPE_EGRESS;
+    toEgressHdr.base.flags = (bundleInSharedMemory) ? HDTN_FLAG_BUNDLE_IN_SHARED_MEMORY : 0;
+    toEgressHdr.finalDestEid = readAheadPtr->destEid;
+    toEgressHdr.hasCustody = readAheadPtr->hasCustody;
+    toEgressHdr.isCutThroughFromIngress = 0;
+    toEgressHdr.priorityIndex = readAheadPtr->priorityIndex;
+    toEgressHdr.unused4 = 0;
+    toEgressHdr.custodyId = readAheadPtr->session.custodyId;
+
+    //(the read ahead buffer of a bundle sent through shared memory goes back to the pool when it is removed from the pipeline)
+    pooled_release_buffer_t * const buffer = readAheadPtr->bufferPtr;
+    zmq::message_t zmqMessageBundle = (bundleInSharedMemory) ?
+        zmq::message_t(&shmDescriptor, sizeof(shmDescriptor)) : MoveToZmqMessage(readAheadPtr);
+    if (!toEgressChannelSender.TrySend(toEgressHdr, zmqMessageBundle)) {
+        if (bundleInSharedMemory) {
+            sharedMemoryBundleArenaPtr->Release(shmDescriptor.slabIndex);
+        }
+        else {
+            ReclaimUnsentZmqMessageBuffer(readAheadPtr, buffer);
+        }
+        return false; //egress is at its high water mark, keep the bundle in the pipeline
+    }
+    return true;
+}
+
+//zero copy, the buffer now belongs to zmq
+zmq::message_t ReleaseReadAheadPipeline::MoveToZmqMessage(read_ahead_t * readAheadPtr) {
+    pooled_release_buffer_t * buffer = readAheadPtr->bufferPtr;
+    readAheadPtr->bufferPtr = NULL;
+    buffer->poolPtr = m_releaseBufferPoolPtr;
+    return zmq::message_t(buffer->data.data(), buffer->data.size(), CustomCleanupPooledReleaseBuffer, buffer);
+}
+
+//the message from MoveToZmqMessage could not be sent, so its buffer goes back to the read ahead
+//(must be called while the message still exists, whose cleanup then leaves the buffer alone)
+void ReleaseReadAheadPipeline::ReclaimUnsentZmqMessageBuffer(read_ahead_t * readAheadPtr, pooled_release_buffer_t * buffer) {
+    buffer->poolPtr.reset();
+    readAheadPtr->bufferPtr = buffer;
+}
+
+//the buffer goes back to the pool unless it was moved to zmq
+void ReleaseReadAheadPipeline::Remove(read_ahead_t * readAheadPtr) {
+    for (std::list<read_ahead_t>::iterator it = m_readAheadList.begin(); it != m_readAheadList.end(); ++it) {
+        if (&(*it) == readAheadPtr) {
+            if (it->bufferPtr) {
+                m_releaseBufferPoolPtr->Return_ThreadSafe(it->bufferPtr);
+            }
+            m_numBytes -= it->bundleSizeBytes;
+            m_freeList.splice(m_freeList.begin(), m_readAheadList, it);
+            return;
+        }
+    }
+}
+
+void ReleaseReadAheadPipeline::WaitForProgress(const boost::posix_time::time_duration & timeout) {
+    for (std::list<read_ahead_t>::iterator it = m_readAheadList.begin(); it != m_readAheadList.end(); ++it) {
+        if (!m_bsm.IsReadAheadIdle(it->session)) {
+            m_bsm.WaitForReadAheadProgress(it->session, timeout);
+            return;
+        }
+    }
+}
@@ -0,0 +1,205 @@
+/***************************************************************************
+ * NASA Glenn Research Center, Cleveland, OH
+ * Released under the NASA Open Source Agreement (NOSA)
+ * May  2021
+ *
+ ****************************************************************************
+ */
+
+#include "ReleaseWindowManager.h"
+#include <sstream>
+#include <algorithm>
+#include "Uri.h"
+
+
+ReleaseWindowManager::ReleaseWindowManager(const OutductsConfig & outductsConfig, const uint64_t minWindowBytes, const uint64_t maxWindowBytes) :
+    M_MIN_WINDOW_BYTES(minWindowBytes),
+    M_MAX_WINDOW_BYTES(std::max(minWindowBytes, maxWindowBytes))
+{
+    const outduct_element_config_vector_t & outductElementConfigVector = outductsConfig.m_outductElementConfigVector;
+    m_windowsVec.reserve(outductElementConfigVector.size());
+    for (std::size_t i = 0; i < outductElementConfigVector.size(); ++i) {
+        const outduct_element_config_t & thisOutductConfig = outductElementConfigVector[i];
+        m_windowsVec.emplace_back();
+        window_t & window = m_windowsVec.back();
+        window.stats = release_window_stats_t();
+        window.stats.name = thisOutductConfig.name;
+        uint64_t rateBytesPerSecond = 0;
+        if (thisOutductConfig.convergenceLayer == "ltp_over_udp") {
+            window.roundTripMilliseconds = 2 * (thisOutductConfig.oneWayLightTimeMs + thisOutductConfig.oneWayMarginTimeMs);
+            rateBytesPerSecond = thisOutductConfig.ltpMaxSendRateBitsPerSecOrZeroToDisable / 8;
+        }
+        else {
+            window.roundTripMilliseconds = 0; //unknown, only the ack feedback is used
+            if (thisOutductConfig.convergenceLayer == "udp") {
+                rateBytesPerSecond = thisOutductConfig.udpRateBps / 8;
+            }
+        }
+        SetBandwidthDelayProduct(window, rateBytesPerSecond);
+        window.stats.windowBytes = std::min(std::max(window.stats.bandwidthDelayProductBytes, M_MIN_WINDOW_BYTES), M_MAX_WINDOW_BYTES);
+        window.slowStartThresholdBytes = M_MAX_WINDOW_BYTES;
+
+        for (std::set<std::string>::const_iterator itDestUri = thisOutductConfig.finalDestinationEidUris.cbegin(); itDestUri != thisOutductConfig.finalDestinationEidUris.cend(); ++itDestUri) {
+            cbhe_eid_t destEid;
+            if (Uri::ParseIpnUriString(*itDestUri, destEid.nodeId, destEid.serviceId)) {
+                m_finalDestEidToWindowIndexMap[destEid] = i;
+                m_configuredNodeIdToWindowIndexMap.emplace(destEid.nodeId, i);
+            }
+        }
+    }
+}
+
+ReleaseWindowManager::~ReleaseWindowManager() {}
+
+void ReleaseWindowManager::SetBandwidthDelayProduct(window_t & window, const uint64_t rateBytesPerSecond) {
+    window.stats.bandwidthDelayProductBytes = (rateBytesPerSecond * window.roundTripMilliseconds) / 1000;
+}
+
+std::size_t ReleaseWindowManager::GetWindowIndex(const cbhe_eid_t & eid, const bool isAnyServiceId) {
+    if (!isAnyServiceId) {
+        std::map<cbhe_eid_t, std::size_t>::const_iterator it = m_finalDestEidToWindowIndexMap.find(eid);
+        if (it != m_finalDestEidToWindowIndexMap.cend()) {
+            return it->second;
+        }
+    }
+    {
+        std::map<uint64_t, std::size_t>::const_iterator it = m_configuredNodeIdToWindowIndexMap.find(eid.nodeId);
+        if (it != m_configuredNodeIdToWindowIndexMap.cend()) {
+            return it->second;
+        }
+    }
+    //no outduct configured for this node (e.g. an opportunistic link), so share one window per node
+    std::pair<std::map<uint64_t, std::size_t>::iterator, bool> ret = m_unconfiguredNodeIdToWindowIndexMap.emplace(eid.nodeId, m_windowsVec.size());
+    if (ret.second) {
+        m_windowsVec.emplace_back();
+        window_t & window = m_windowsVec.back();
+        window.stats = release_window_stats_t();
+        window.stats.name = Uri::GetIpnUriStringAnyServiceNumber(eid.nodeId);
+        window.stats.windowBytes = M_MIN_WINDOW_BYTES;
+        window.roundTripMilliseconds = 0;
+        window.slowStartThresholdBytes = M_MAX_WINDOW_BYTES;
+    }
+    return ret.first->second;
+}
+
+bool ReleaseWindowManager::CanRelease(const cbhe_eid_t & linkEid, const bool isAnyServiceId) {
+    release_window_stats_t & stats = m_windowsVec[GetWindowIndex(linkEid, isAnyServiceId)].stats;
+    if ((stats.bytesInFlight == 0) || (stats.bytesInFlight < stats.windowBytes)) {
+        return true;
+    }
+    ++stats.totalClogEvents;
+    return false;
+}
+
+bool ReleaseWindowManager::OnReleased(const cbhe_eid_t & linkEid, const bool isAnyServiceId, const uint64_t custodyId, const uint64_t bundleSizeBytes, const boost::posix_time::ptime & nowPtime) {
+    const std::size_t windowIndex = GetWindowIndex(linkEid, isAnyServiceId);
+    in_flight_t inFlight;
+    inFlight.windowIndex = windowIndex;
+    inFlight.bundleSizeBytes = bundleSizeBytes;
+    inFlight.releasedPtime = nowPtime;
+    if (!m_custodyIdToInFlightMap.emplace(custodyId, inFlight).second) {
+        return false;
+    }
+    release_window_stats_t & stats = m_windowsVec[windowIndex].stats;
+    stats.bytesInFlight += bundleSizeBytes;
+    ++stats.bundlesInFlight;
+    stats.totalBytesReleased += bundleSizeBytes;
+    ++stats.totalBundlesReleased;
+    return true;
+}
+
+bool ReleaseWindowManager::OnAcked(const uint64_t custodyId, const boost::posix_time::ptime & nowPtime) {
+    std::unordered_map<uint64_t, in_flight_t>::iterator it = m_custodyIdToInFlightMap.find(custodyId);
+    if (it == m_custodyIdToInFlightMap.end()) {
+        return false;
+    }
+    const in_flight_t & inFlight = it->second;
+    window_t & window = m_windowsVec[inFlight.windowIndex];
+    release_window_stats_t & stats = window.stats;
+
+    const boost::posix_time::time_duration rttSample = nowPtime - inFlight.releasedPtime;
+    const uint64_t rttSampleMicroseconds = (rttSample.is_negative()) ? 0 : static_cast<uint64_t>(rttSample.total_microseconds());
+    stats.smoothedRttMicroseconds = (stats.smoothedRttMicroseconds == 0) ? rttSampleMicroseconds : ((7 * stats.smoothedRttMicroseconds) + rttSampleMicroseconds) / 8;
+
+    //only grow while the window is what limits the release (not while storage has too little to send)
+    const bool windowLimited = ((stats.bytesInFlight * 2) >= stats.windowBytes);
+    const uint64_t ackedBytes = inFlight.bundleSizeBytes;
+    stats.bytesInFlight -= ackedBytes;
+    --stats.bundlesInFlight;
+    m_custodyIdToInFlightMap.erase(it);
+    if (windowLimited) {
+        if (stats.windowBytes < window.slowStartThresholdBytes) {
+            stats.windowBytes += ackedBytes;
+        }
+        else {
+            stats.windowBytes += std::max<uint64_t>(1, (ackedBytes * ackedBytes) / stats.windowBytes);
+        }
+        stats.windowBytes = std::min(stats.windowBytes, M_MAX_WINDOW_BYTES);
+    }
+    return true;
+}
+
+bool ReleaseWindowManager::OnCanceled(const uint64_t custodyId) {
+    std::unordered_map<uint64_t, in_flight_t>::iterator it = m_custodyIdToInFlightMap.find(custodyId);
+    if (it == m_custodyIdToInFlightMap.end()) {
+        return false;
+    }
+    release_window_stats_t & stats = m_windowsVec[it->second.windowIndex].stats;
+    stats.bytesInFlight -= it->second.bundleSizeBytes;
+    --stats.bundlesInFlight;
+    m_custodyIdToInFlightMap.erase(it);
+    return true;
+}
+
+void ReleaseWindowManager::OnRetry(const cbhe_eid_t & finalDestEid, const boost::posix_time::ptime & nowPtime) {
+    window_t & window = m_windowsVec[GetWindowIndex(finalDestEid, false)];
+    release_window_stats_t & stats = window.stats;
+    const boost::posix_time::time_duration minTimeBetweenDecreases = boost::posix_time::microseconds(
+        (stats.smoothedRttMicroseconds) ? stats.smoothedRttMicroseconds : 1000000);
+    if ((!window.lastDecreasePtime.is_not_a_date_time()) && ((nowPtime - window.lastDecreasePtime) < minTimeBetweenDecreases)) {
+        return; //a burst of retries from the same round trip counts as one congestion event
+    }
+    stats.windowBytes = std::max(stats.windowBytes / 2, M_MIN_WINDOW_BYTES);
+    window.slowStartThresholdBytes = stats.windowBytes;
+    window.lastDecreasePtime = nowPtime;
+    ++stats.totalWindowDecreases;
+}
+
+void ReleaseWindowManager::OnReleaseRate(const cbhe_eid_t & linkEid, const uint64_t rateBytesPerSecond) {
+    window_t & window = m_windowsVec[GetWindowIndex(linkEid, false)];
+    if ((rateBytesPerSecond == 0) || (window.roundTripMilliseconds == 0)) {
+        return;
+    }
+    SetBandwidthDelayProduct(window, rateBytesPerSecond);
+    window.stats.windowBytes = std::max(window.stats.windowBytes, std::min(window.stats.bandwidthDelayProductBytes, M_MAX_WINDOW_BYTES));
+}
+
+std::size_t ReleaseWindowManager::GetNumBundlesInFlight() const {
+    return m_custodyIdToInFlightMap.size();
+}
+
+void ReleaseWindowManager::GetStats(std::vector<release_window_stats_t> & stats) const {
+    stats.resize(0);
+    stats.reserve(m_windowsVec.size());
+    for (std::size_t i = 0; i < m_windowsVec.size(); ++i) {
+        stats.push_back(m_windowsVec[i].stats);
+    }
+}
+
+std::string ReleaseWindowManager::GetStatsString() const {
+    std::ostringstream oss;
+    for (std::size_t i = 0; i < m_windowsVec.size(); ++i) {
+        const release_window_stats_t & stats = m_windowsVec[i].stats;
+        oss << "release window " << stats.name
+            << ": bdpBytes=" << stats.bandwidthDelayProductBytes
+            << " windowBytes=" << stats.windowBytes
+            << " bytesInFlight=" << stats.bytesInFlight
+            << " bundlesInFlight=" << stats.bundlesInFlight
+            << " srttUs=" << stats.smoothedRttMicroseconds
+            << " bundlesReleased=" << stats.totalBundlesReleased
+            << " bytesReleased=" << stats.totalBytesReleased
+            << " clogEvents=" << stats.totalClogEvents
+            << " decreases=" << stats.totalWindowDecreases << "\n";
+    }
+    return oss.str();
+}
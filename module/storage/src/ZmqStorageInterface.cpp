@@ -7,22 +7,30 @@
 
 #include <iostream>
 #include "message.hpp"
+#include "IngressAckBatcher.hpp"
 #include "ZmqStorageInterface.h"
 #include "BundleStorageManagerMT.h"
 #include "BundleStorageManagerAsio.h"
+#include "BundleStorageManagerIoUring.h"
 #include "Logger.h"
 #include <set>
+#include <list>
+#include <algorithm>
 #include <boost/lexical_cast.hpp>
 #include <boost/make_unique.hpp>
+#include <boost/make_shared.hpp>
 #include "codec/CustodyIdAllocator.h"
 #include "codec/CustodyTransferManager.h"
 #include "Uri.h"
 #include "CustodyTimers.h"
+#include "ReleaseWindowManager.h"
+#include "ExpiredBundleSweep.h"
+#include "ReleaseReadAheadPipeline.h"
 #include "codec/BundleViewV7.h"
 
 typedef std::pair<cbhe_eid_t, bool> eid_plus_isanyserviceid_pair_t;
 
-ZmqStorageInterface::ZmqStorageInterface() : m_running(false) {}
+ZmqStorageInterface::ZmqStorageInterface() : m_toEgressChannelSenderPtr(NULL), m_running(false) {}
 
 ZmqStorageInterface::~ZmqStorageInterface() {
     Stop();
@@ -36,7 +44,9 @@ void ZmqStorageInterface::Stop() {
     }
 }
 
-bool ZmqStorageInterface::Init(const HdtnConfig & hdtnConfig, zmq::context_t * hdtnOneProcessZmqInprocContextPtr) {
+bool ZmqStorageInterface::Init(const HdtnConfig & hdtnConfig, zmq::context_t * hdtnOneProcessZmqInprocContextPtr,
+    InterModuleChannelSender<hdtn::ToEgressHdr> * storageToEgressNativeChannelPtr)
+{
     m_hdtnConfig = hdtnConfig;
     //according to ION.pdf v4.0.1 on page 100 it says:
     //  Remember that the format for this argument is ipn:element_number.0 and that
@@ -79,6 +89,16 @@ bool ZmqStorageInterface::Init(const HdtnConfig & hdtnConfig, zmq::context_t * h
         }
     }
     else {
+        if (m_hdtnConfig.m_sharedMemoryBundleArenaNumSlabs) {
+            m_sharedMemoryBundleArenaPtr = SharedMemoryBundleArena::Create(
+                SharedMemoryBundleArena::GetArenaName(m_hdtnConfig.m_zmqConnectingStorageToBoundEgressPortPath),
+                static_cast<uint32_t>(m_hdtnConfig.m_sharedMemoryBundleArenaNumSlabs), m_hdtnConfig.m_sharedMemoryBundleArenaSlabSizeBytes);
+            if (!m_sharedMemoryBundleArenaPtr) {
+                std::cerr << "error in ZmqStorageInterface::Init: cannot create the shared memory bundle arena" << std::endl;
+                hdtn::Logger::getInstance()->logError("storage", "error in ZmqStorageInterface::Init: cannot create the shared memory bundle arena");
+                return false;
+            }
+        }
         m_zmqPushSock_connectingStorageToBoundEgressPtr = boost::make_unique<zmq::socket_t>(*m_zmqContextPtr, zmq::socket_type::push);
         const std::string connect_connectingStorageToBoundEgressPath(
             std::string("tcp://") +
@@ -120,6 +140,14 @@ bool ZmqStorageInterface::Init(const HdtnConfig & hdtnConfig, zmq::context_t * h
         }
     }
 
+    if (hdtnOneProcessZmqInprocContextPtr && storageToEgressNativeChannelPtr) {
+        m_toEgressChannelSenderPtr = storageToEgressNativeChannelPtr;
+    }
+    else {
+        m_zmqToEgressChannelSenderPtr = boost::make_unique<ZmqInterModuleChannelSender<hdtn::ToEgressHdr> >(m_zmqPushSock_connectingStorageToBoundEgressPtr.get());
+        m_toEgressChannelSenderPtr = m_zmqToEgressChannelSenderPtr.get();
+    }
+
     m_zmqSubSock_boundReleaseToConnectingStoragePtr = boost::make_unique<zmq::socket_t>(*m_zmqContextPtr, zmq::socket_type::sub);
     const std::string connect_boundSchedulerPubSubPath(
         std::string("tcp://") +
@@ -178,37 +206,9 @@ bool ZmqStorageInterface::Init(const HdtnConfig & hdtnConfig, zmq::context_t * h
     return true;
 }
 
-static bool WriteAcsBundle(BundleStorageManagerBase & bsm, CustodyIdAllocator & custodyIdAllocator,
-    const Bpv6CbhePrimaryBlock & primary, const std::vector<uint8_t> & acsBundleSerialized)
-{
-    const cbhe_eid_t & hdtnSrcEid = primary.m_sourceNodeId;
-    const uint64_t newCustodyIdForAcsCustodySignal = custodyIdAllocator.GetNextCustodyIdForNextHopCtebToSend(hdtnSrcEid);
-
-    //write custody signal to disk
-    BundleStorageManagerSession_WriteToDisk sessionWrite;
-    const uint64_t totalSegmentsRequired = bsm.Push(sessionWrite, primary, acsBundleSerialized.size());
-    //std::cout << "totalSegmentsRequired " << totalSegmentsRequired << "\n";
-    if (totalSegmentsRequired == 0) {
-        const std::string msg = "out of space for acs custody signal";
-        std::cerr << msg << "\n";
-        hdtn::Logger::getInstance()->logError("storage", msg);
-        return false;
-    }
-
-    const uint64_t totalBytesPushed = bsm.PushAllSegments(sessionWrite, primary,
-        newCustodyIdForAcsCustodySignal, acsBundleSerialized.data(), acsBundleSerialized.size());
-    if (totalBytesPushed != acsBundleSerialized.size()) {
-        const std::string msg = "totalBytesPushed != acsBundleSerialized.size";
-        std::cerr << msg << "\n";
-        hdtn::Logger::getInstance()->logError("storage", msg);
-        return false;
-    }
-    return true;
-}
-
 static bool Write(zmq::message_t *message, BundleStorageManagerBase & bsm,
     CustodyIdAllocator & custodyIdAllocator, CustodyTransferManager & ctm,
-    CustodyTimers & custodyTimers,
+    CustodyTimers & custodyTimers, ReleaseReadAheadPipeline & readAheadPipeline,
     BundleViewV6 & custodySignalRfc5050RenderedBundleView,
     cbhe_eid_t & finalDestEidReturned, ZmqStorageInterface * forStats)
 {
@@ -270,6 +270,7 @@ static bool Write(zmq::message_t *message, BundleStorageManagerBase & bsm,
                         if (!custodyTimers.CancelCustodyTransferTimer(catalogEntryPtr->destEid, currentCustodyId)) {
                             std::cout << "notice: can't find custody timer associated with bundle identified by acs custody signal\n";
                         }
+                        readAheadPipeline.Cancel(currentCustodyId); //a late signal for a bundle being resent
                         if (!bsm.RemoveReadBundleFromDisk(catalogEntryPtr, currentCustodyId)) {
                             std::cout << "error freeing bundle identified by acs custody signal from disk\n";
                             continue;
@@ -328,6 +329,7 @@ static bool Write(zmq::message_t *message, BundleStorageManagerBase & bsm,
                 if (!custodyTimers.CancelCustodyTransferTimer(catalogEntryPtr->destEid, custodyIdFromRfc5050)) {
                     std::cout << "notice: can't find custody timer associated with bundle identified by rfc5050 custody signal\n";
                 }
+                readAheadPipeline.Cancel(custodyIdFromRfc5050); //a late signal for a bundle being resent
                 if (!bsm.RemoveReadBundleFromDisk(catalogEntryPtr, custodyIdFromRfc5050)) {
                     std::cout << "error freeing bundle identified by rfc5050 custody signal from disk\n";
                     return false;
@@ -456,92 +458,6 @@ static uint64_t PeekOne(const std::vector<eid_plus_isanyserviceid_pair_t> & avai
     return bytesToReadFromDisk;
 }
 
-static void CustomCleanupToEgressHdr(void *data, void *hint) {
-    delete static_cast<hdtn::ToEgressHdr*>(hint);
-}
-static void CustomCleanupStorageAckHdr(void *data, void *hint) {
-    delete static_cast<hdtn::StorageAckHdr*>(hint);
-}
-static void CustomCleanupStdVecUint8(void *data, void *hint) {
-    //std::cout << "free " << static_cast<std::vector<uint8_t>*>(hint)->size() << std::endl;
-    delete static_cast<std::vector<uint8_t>*>(hint);
-}
-
-static bool ReleaseOne_NoBlock(BundleStorageManagerSession_ReadFromDisk & sessionRead,
-    const std::vector<eid_plus_isanyserviceid_pair_t> & availableDestLinks,
-    zmq::socket_t *egressSock, BundleStorageManagerBase & bsm, const uint64_t maxBundleSizeToRead)
-{
-    //std::cout << "reading\n";
-    const uint64_t bytesToReadFromDisk = bsm.PopTop(sessionRead, availableDestLinks);
-    //std::cout << "bytesToReadFromDisk " << bytesToReadFromDisk << "\n";
-    if (bytesToReadFromDisk == 0) { //no more of these links to read
-        return false;
-    }
-
-    //this link has a bundle in the fifo
-        
-
-    //IF YOU DECIDE YOU DON'T WANT TO READ THE BUNDLE AFTER PEEKING AT IT (MAYBE IT'S TOO BIG RIGHT NOW)
-    if (bytesToReadFromDisk > maxBundleSizeToRead) {
-        std::cerr << "error: bundle to read from disk is too large right now" << std::endl;
-        hdtn::Logger::getInstance()->logError("storage", "Error: bundle to read from disk is too large right now");
-        bsm.ReturnTop(sessionRead);
-        return false;
-        //bytesToReadFromDisk = bsm.PopTop(sessionRead, availableDestLinks); //get it back
-    }
-        
-    std::vector<uint8_t> * vecUint8BundleDataRawPointer = new std::vector<uint8_t>();
-    const bool successReadAllSegments = bsm.ReadAllSegments(sessionRead, *vecUint8BundleDataRawPointer);
-    zmq::message_t zmqBundleDataMessageWithDataStolen(vecUint8BundleDataRawPointer->data(), vecUint8BundleDataRawPointer->size(), CustomCleanupStdVecUint8, vecUint8BundleDataRawPointer);
-        
-    //std::cout << "totalBytesRead " << totalBytesRead << "\n";
-    if (!successReadAllSegments) {
-        std::cout << "error: unable to read all segments from disk\n";
-        hdtn::Logger::getInstance()->logError("storage", "error: unable to read all segments from disk");
-        return false;
-    }
-
-
-    //force natural/64-bit alignment
-    hdtn::ToEgressHdr * toEgressHdr = new hdtn::ToEgressHdr();
-    zmq::message_t zmqMessageToEgressHdrWithDataStolen(toEgressHdr, sizeof(hdtn::ToEgressHdr), CustomCleanupToEgressHdr, toEgressHdr);
-
-    //memset 0 not needed because all values set below
-    toEgressHdr->base.type = HDTN_MSGTYPE_EGRESS;
-    toEgressHdr->base.flags = 0;
-    toEgressHdr->finalDestEid = sessionRead.catalogEntryPtr->destEid;
-    toEgressHdr->hasCustody = sessionRead.catalogEntryPtr->HasCustody();
-    toEgressHdr->isCutThroughFromIngress = 0;
-    toEgressHdr->custodyId = sessionRead.custodyId;
-    
-    if (!egressSock->send(std::move(zmqMessageToEgressHdrWithDataStolen), zmq::send_flags::sndmore | zmq::send_flags::dontwait)) {
-        std::cout << "error: zmq could not send" << std::endl;
-        hdtn::Logger::getInstance()->logError("storage", "Error: zmq could not send");
-        bsm.ReturnTop(sessionRead);
-        return false;
-    }
-    if (!egressSock->send(std::move(zmqBundleDataMessageWithDataStolen), zmq::send_flags::dontwait)) {
-        std::cout << "error: zmq could not send bundle" << std::endl;
-        hdtn::Logger::getInstance()->logError("storage", "Error: zmq could not send bundle");
-        bsm.ReturnTop(sessionRead);
-        return false;
-    }
-    /*
-    //if you're happy with the bundle data you read back, then officially remove it from the disk
-    if (deleteFromDiskNow) {
-        bool successRemoveBundle = bsm.RemoveReadBundleFromDisk(sessionRead);
-        if (!successRemoveBundle) {
-            std::cout << "error freeing bundle from disk\n";
-            return false;
-        }
-    }
-        */
-        
-        
-    return true;
-
-}
-
 static void PrintReleasedLinks(const std::set<eid_plus_isanyserviceid_pair_t> & availableDestLinksSet) {
     std::string strVals = "[";
     for (std::set<eid_plus_isanyserviceid_pair_t>::const_iterator it = availableDestLinksSet.cbegin(); it != availableDestLinksSet.cend(); ++it) {
@@ -557,6 +473,16 @@ static void PrintReleasedLinks(const std::set<eid_plus_isanyserviceid_pair_t> &
     hdtn::Logger::getInstance()->logNotification("storage", "Currently Releasing Final Destination Eids: " + strVals);
 }
 
+//the released link a bundle was popped for (fully qualified if released, else its node's any service id link),
+//so that the bundle is charged to the same window that CanRelease checked for that link
+static eid_plus_isanyserviceid_pair_t GetReleasedLink(const cbhe_eid_t & finalDestEid, const std::vector<eid_plus_isanyserviceid_pair_t> & availableDestLinks) {
+    const eid_plus_isanyserviceid_pair_t fullyQualifiedLink(finalDestEid, false);
+    if (std::find(availableDestLinks.cbegin(), availableDestLinks.cend(), fullyQualifiedLink) != availableDestLinks.cend()) {
+        return fullyQualifiedLink;
+    }
+    return eid_plus_isanyserviceid_pair_t(cbhe_eid_t(finalDestEid.nodeId, 0), true); //0 is don't care
+}
+
 void ZmqStorageInterface::ThreadFunc() {
     BundleStorageManagerSession_ReadFromDisk sessionRead; //reuse this due to expensive heap allocation
     BundleViewV6 custodySignalRfc5050RenderedBundleView;
@@ -587,6 +513,16 @@ void ZmqStorageInterface::ThreadFunc() {
         hdtn::Logger::getInstance()->logNotification("storage", "[ZmqStorageInterface] Initializing BundleStorageManagerAsio ... ");
         bsmPtr = boost::make_unique<BundleStorageManagerAsio>(boost::make_shared<StorageConfig>(m_hdtnConfig.m_storageConfig));
     }
+    else if ((m_hdtnConfig.m_storageConfig.m_storageImplementation == "io_uring_multi_threaded") && (!BundleStorageManagerIoUring::IsIoUringSupported())) {
+        std::cout << "[ZmqStorageInterface] io_uring is not supported by this kernel, initializing BundleStorageManagerMT instead ... " << std::endl;
+        hdtn::Logger::getInstance()->logNotification("storage", "[ZmqStorageInterface] io_uring is not supported by this kernel, initializing BundleStorageManagerMT instead ... ");
+        bsmPtr = boost::make_unique<BundleStorageManagerMT>(boost::make_shared<StorageConfig>(m_hdtnConfig.m_storageConfig));
+    }
+    else if (m_hdtnConfig.m_storageConfig.m_storageImplementation == "io_uring_multi_threaded") {
+        std::cout << "[ZmqStorageInterface] Initializing BundleStorageManagerIoUring ... " << std::endl;
+        hdtn::Logger::getInstance()->logNotification("storage", "[ZmqStorageInterface] Initializing BundleStorageManagerIoUring ... ");
+        bsmPtr = boost::make_unique<BundleStorageManagerIoUring>(boost::make_shared<StorageConfig>(m_hdtnConfig.m_storageConfig));
+    }
     else {
         std::cerr << "error in hdtn::ZmqStorageInterface::ThreadFunc: invalid storage implementation " << m_hdtnConfig.m_storageConfig.m_storageImplementation << std::endl;
         return;
@@ -595,8 +531,19 @@ void ZmqStorageInterface::ThreadFunc() {
     bsm.Start();
     
 
-    typedef std::set<uint64_t> custodyid_set_t;
-    typedef std::map<cbhe_eid_t, custodyid_set_t> finaldesteid_opencustids_map_t;
+    //Bundles released to egress and not yet acked by egress are limited by a byte window per outduct,
+    //initially the outduct's bandwidth-delay product, then adapted from the egress ack feedback.
+    ReleaseWindowManager releaseWindowManager(m_hdtnConfig.m_outductsConfig, m_hdtnConfig.m_releaseWindowMinBytes, m_hdtnConfig.m_releaseWindowMaxBytes);
+    static const boost::posix_time::time_duration RELEASE_WINDOW_STATS_PERIOD = boost::posix_time::seconds(1);
+    boost::posix_time::ptime releaseWindowStatsNowExpiry = boost::posix_time::microsec_clock::universal_time();
+
+    //Released bundles are read ahead from disk into pooled buffers (handed to zmq without a copy), keeping the segment reads
+    //of several bundles outstanding so that draining a backlog isn't bound by the latency of one bundle's reads at a time.
+    static constexpr std::size_t RELEASE_BUFFER_POOL_MAX_CAPACITY_BYTES = 10000000;
+    static const boost::posix_time::time_duration RELEASE_READ_AHEAD_MAX_WAIT = boost::posix_time::milliseconds(1);
+    boost::shared_ptr<ReleaseBufferPool> releaseBufferPoolPtr = boost::make_shared<ReleaseBufferPool>(2 * ReleaseReadAheadPipeline::DEFAULT_MAX_BUNDLES, RELEASE_BUFFER_POOL_MAX_CAPACITY_BYTES);
+    ReleaseReadAheadPipeline readAheadPipeline(bsm, releaseBufferPoolPtr,
+        ReleaseReadAheadPipeline::DEFAULT_MAX_BUNDLES, ReleaseReadAheadPipeline::DEFAULT_MAX_BYTES);
 
     std::vector<eid_plus_isanyserviceid_pair_t> availableDestLinksNotCloggedVec;
     availableDestLinksNotCloggedVec.reserve(100); //todo
@@ -609,13 +556,15 @@ void ZmqStorageInterface::ThreadFunc() {
     m_numRfc5050CustodyTransfers = 0;
     m_numAcsCustodyTransfers = 0;
     m_numAcsPacketsReceived = 0;
-    std::size_t totalEventsAllLinksClogged = 0;
-    std::size_t totalEventsNoDataInStorageForAvailableLinks = 0;
-    std::size_t totalEventsDataInStorageForCloggedLinks = 0;
+    m_totalEventsAllLinksClogged = 0;
+    m_totalEventsNoDataInStorageForAvailableLinks = 0;
+    m_totalEventsDataInStorageForCloggedLinks = 0;
     std::size_t numCustodyTransferTimeouts = 0;
 
     std::set<eid_plus_isanyserviceid_pair_t> availableDestLinksSet;
-    finaldesteid_opencustids_map_t finalDestEidToOpenCustIdsMap;
+    static constexpr std::size_t MAX_ACK_RANGES_PER_MESSAGE_TO_INGRESS = 256;
+    hdtn::IngressAckBatcher ingressAckBatcher(HDTN_MSGTYPE_STORAGE_ACK_BATCH_TO_INGRESS, MAX_ACK_RANGES_PER_MESSAGE_TO_INGRESS);
+    SharedMemoryBundleArenaReader ingressSharedMemoryBundleArenaReader(SharedMemoryBundleArena::GetArenaName(m_hdtnConfig.m_zmqBoundIngressToConnectingEgressPortPath));
 
     static constexpr std::size_t minBufSizeBytesReleaseMessages = sizeof(uint64_t) + 
         ((sizeof(hdtn::IreleaseStartHdr) > sizeof(hdtn::IreleaseStopHdr)) ? sizeof(hdtn::IreleaseStartHdr) : sizeof(hdtn::IreleaseStopHdr));
@@ -630,8 +579,26 @@ void ZmqStorageInterface::ThreadFunc() {
     static const long DEFAULT_BIG_TIMEOUT_POLL = 250;
     long timeoutPoll = DEFAULT_BIG_TIMEOUT_POLL; //0 => no blocking
     boost::posix_time::ptime acsSendNowExpiry = boost::posix_time::microsec_clock::universal_time() + ACS_SEND_PERIOD;
+
+    //expired bundles awaiting send are swept a bounded slice at a time
+    static const boost::posix_time::time_duration EXPIRY_SWEEP_PERIOD = boost::posix_time::seconds(1);
+    boost::posix_time::ptime expirySweepNowExpiry = boost::posix_time::microsec_clock::universal_time() + EXPIRY_SWEEP_PERIOD;
+    ExpiredBundleSweep expiredBundleSweep(bsm, custodyIdAllocator, M_HDTN_EID_CUSTODY, m_hdtnConfig.m_statusReportLifetimeSeconds);
+    m_totalBundlesErasedFromStorageExpired = 0;
+    m_numExpiredBundleDeletionStatusReports = 0;
     m_threadStartupComplete = true;
     while (m_running) {
+        //acks to ingress are batched: keep accumulating while more bundles from ingress are already waiting to be stored,
+        //otherwise send them now so that ingress is never left waiting on a partially filled batch
+        if ((!ingressAckBatcher.IsEmpty()) && (ingressAckBatcher.IsFull() ||
+            ((m_zmqPullSock_boundIngressToConnectingStoragePtr->get(zmq::sockopt::events) & ZMQ_POLLIN) == 0)))
+        {
+            if (!ingressAckBatcher.Send(*m_zmqPushSock_connectingStorageToBoundIngressPtr)) {
+                //the acks stay in the batch and are retried on the next loop iteration
+                std::cout << "error: zmq could not send ingress a batch of acks from storage (will retry)" << std::endl;
+                hdtn::Logger::getInstance()->logError("storage", "Error: zmq could not send ingress a batch of acks from storage (will retry)");
+            }
+        }
         int rc = 0;
         try {
             rc = zmq::poll(pollItems, 4, timeoutPoll);
@@ -642,37 +609,41 @@ void ZmqStorageInterface::ThreadFunc() {
         }
         if (rc > 0) {            
             if (pollItems[0].revents & ZMQ_POLLIN) { //from egress sock
-                hdtn::EgressAckHdr egressAckHdr;
-                const zmq::recv_buffer_result_t res = m_zmqPullSock_boundEgressToConnectingStoragePtr->recv(zmq::mutable_buffer(&egressAckHdr, sizeof(egressAckHdr)), zmq::recv_flags::none);
-                if (!res) {
+                //egress batches its acks: one message of one or more consecutive EgressAckHdr
+                zmq::message_t egressAcksMessage;
+                if (!m_zmqPullSock_boundEgressToConnectingStoragePtr->recv(egressAcksMessage, zmq::recv_flags::none)) {
                     std::cerr << "[storage-worker] EgressAckHdr not received" << std::endl;
                     hdtn::Logger::getInstance()->logError("storage", "[storage-worker] EgressAckHdr not received");
                     continue;
                 }
-                else if ((res->truncated()) || (res->size != sizeof(hdtn::EgressAckHdr))) {
+                else if ((egressAcksMessage.size() == 0) || ((egressAcksMessage.size() % sizeof(hdtn::EgressAckHdr)) != 0)) {
                     std::cerr << "[storage-worker] EgressAckHdr wrong size received" << std::endl;
                     hdtn::Logger::getInstance()->logError("storage", "[storage-worker] EgressAckHdr wrong size received");
                     continue;
                 }
-                else if (egressAckHdr.base.type != HDTN_MSGTYPE_EGRESS_ACK_TO_STORAGE) {
-                    std::cerr << "[storage-worker] EgressAckHdr not type HDTN_MSGTYPE_EGRESS_ACK_TO_STORAGE, got " << egressAckHdr.base.type << std::endl;
-                    hdtn::Logger::getInstance()->logError("storage", "[storage-worker] EgressAckHdr not type HDTN_MSGTYPE_EGRESS_ACK_TO_STORAGE");
-                    continue;
-                }
-                custodyid_set_t & custodyIdSet = finalDestEidToOpenCustIdsMap[egressAckHdr.finalDestEid];
-                custodyid_set_t::iterator it = custodyIdSet.find(egressAckHdr.custodyId);
-                if (it != custodyIdSet.end()) {
-                    if (egressAckHdr.deleteNow) { //custody not requested, so don't wait on a custody signal to delete the bundle
-                        bool successRemoveBundle = bsm.RemoveReadBundleFromDisk(egressAckHdr.custodyId);
-                        if (!successRemoveBundle) {
-                            std::cout << "error freeing bundle from disk\n";
-                            hdtn::Logger::getInstance()->logError("storage", "Error freeing bundle from disk");
-                        }
-                        else {
-                            ++m_totalBundlesErasedFromStorageNoCustodyTransfer;
+                const std::size_t numEgressAcks = egressAcksMessage.size() / sizeof(hdtn::EgressAckHdr);
+                const uint8_t * const egressAcksData = static_cast<const uint8_t *>(egressAcksMessage.data());
+                const boost::posix_time::ptime nowPtime = boost::posix_time::microsec_clock::universal_time();
+                for (std::size_t i = 0; i < numEgressAcks; ++i) {
+                    hdtn::EgressAckHdr egressAckHdr;
+                    memcpy(&egressAckHdr, egressAcksData + (i * sizeof(hdtn::EgressAckHdr)), sizeof(hdtn::EgressAckHdr));
+                    if (egressAckHdr.base.type != HDTN_MSGTYPE_EGRESS_ACK_TO_STORAGE) {
+                        std::cerr << "[storage-worker] EgressAckHdr not type HDTN_MSGTYPE_EGRESS_ACK_TO_STORAGE, got " << egressAckHdr.base.type << std::endl;
+                        hdtn::Logger::getInstance()->logError("storage", "[storage-worker] EgressAckHdr not type HDTN_MSGTYPE_EGRESS_ACK_TO_STORAGE");
+                        continue;
+                    }
+                    if (releaseWindowManager.OnAcked(egressAckHdr.custodyId, nowPtime)) {
+                        if (egressAckHdr.deleteNow) { //custody not requested, so don't wait on a custody signal to delete the bundle
+                            bool successRemoveBundle = bsm.RemoveReadBundleFromDisk(egressAckHdr.custodyId);
+                            if (!successRemoveBundle) {
+                                std::cout << "error freeing bundle from disk\n";
+                                hdtn::Logger::getInstance()->logError("storage", "Error freeing bundle from disk");
+                            }
+                            else {
+                                ++m_totalBundlesErasedFromStorageNoCustodyTransfer;
+                            }
                         }
                     }
-                    custodyIdSet.erase(it);
                 }
             }
             if (pollItems[1].revents & ZMQ_POLLIN) { //from ingress bundle data
@@ -725,27 +696,18 @@ void ZmqStorageInterface::ThreadFunc() {
                     hdtn::Logger::getInstance()->logError("storage", "error in hdtn::ZmqStorageInterface::ThreadFunc (from ingress bundle data) message not received");
                     continue;
                 }
+                if ((toStorageHeader.base.flags & HDTN_FLAG_BUNDLE_IN_SHARED_MEMORY) && (!ingressSharedMemoryBundleArenaReader.ReplaceDescriptorWithBundle(zmqBundleDataReceived))) {
+                    std::cerr << "error in hdtn::ZmqStorageInterface::ThreadFunc (from ingress bundle data) invalid shared memory bundle descriptor" << std::endl;
+                    hdtn::Logger::getInstance()->logError("storage", "error in hdtn::ZmqStorageInterface::ThreadFunc (from ingress bundle data) invalid shared memory bundle descriptor");
+                    continue;
+                }
                 storageStats.inBytes += zmqBundleDataReceived.size();
                 
-                cbhe_eid_t finalDestEidReturnedFromWrite;
-                Write(&zmqBundleDataReceived, bsm, custodyIdAllocator, ctm, custodyTimers, custodySignalRfc5050RenderedBundleView, finalDestEidReturnedFromWrite, this);
+                cbhe_eid_t finalDestEidReturnedFromWrite(0, 0);
+                Write(&zmqBundleDataReceived, bsm, custodyIdAllocator, ctm, custodyTimers, readAheadPipeline, custodySignalRfc5050RenderedBundleView, finalDestEidReturnedFromWrite, this);
 
-                //send ack message to ingress
-                //force natural/64-bit alignment
-                hdtn::StorageAckHdr * storageAckHdr = new hdtn::StorageAckHdr();
-                zmq::message_t zmqMessageStorageAckHdrWithDataStolen(storageAckHdr, sizeof(hdtn::StorageAckHdr), CustomCleanupStorageAckHdr, storageAckHdr);
-
-                //memset 0 not needed because all values set below
-                storageAckHdr->base.type = HDTN_MSGTYPE_STORAGE_ACK_TO_INGRESS;
-                storageAckHdr->base.flags = 0;
-                storageAckHdr->error = 0;
-                storageAckHdr->finalDestEid = finalDestEidReturnedFromWrite;
-                storageAckHdr->ingressUniqueId = toStorageHeader.ingressUniqueId;
-
-                if (!m_zmqPushSock_connectingStorageToBoundIngressPtr->send(std::move(zmqMessageStorageAckHdrWithDataStolen), zmq::send_flags::dontwait)) {
-                    std::cout << "error: zmq could not send ingress an ack from storage" << std::endl;
-                    hdtn::Logger::getInstance()->logError("storage", "Error: zmq could not send ingress an ack from storage");
-                }
+                //queue the ack to ingress (sent at the top of the loop)
+                ingressAckBatcher.Append(finalDestEidReturnedFromWrite, toStorageHeader.ingressUniqueId);
             }
             if (pollItems[2].revents & ZMQ_POLLIN) { //release messages
                 //force this hdtn message struct to be aligned on a 64-byte boundary using zmq::mutable_buffer
@@ -780,6 +742,7 @@ void ZmqStorageInterface::ThreadFunc() {
                     hdtn::Logger::getInstance()->logNotification("storage", msg);
                     availableDestLinksSet.emplace(iReleaseStartHdr->finalDestinationEid, false); //false => fully qualified service id
                     availableDestLinksSet.emplace(iReleaseStartHdr->nextHopEid, false);
+                    releaseWindowManager.OnReleaseRate(iReleaseStartHdr->finalDestinationEid, iReleaseStartHdr->rate);
 		}
                 else if (commonHdr->type == HDTN_MSGTYPE_ILINKDOWN) {
                     if (res->size != sizeof(hdtn::IreleaseStopHdr)) {
@@ -829,7 +792,8 @@ void ZmqStorageInterface::ThreadFunc() {
             std::list<BundleViewV6> newAcsRenderedBundleViewList;
             if (ctm.GenerateAllAcsBundlesAndClear(newAcsRenderedBundleViewList)) {
                 for(std::list<BundleViewV6>::iterator it = newAcsRenderedBundleViewList.begin(); it != newAcsRenderedBundleViewList.end(); ++it) {
-                    WriteAcsBundle(bsm, custodyIdAllocator, it->m_primaryBlockView.header, it->m_frontBuffer);
+                    WriteAdminRecordBundle(bsm, custodyIdAllocator, it->m_primaryBlockView.header, it->m_primaryBlockView.header.m_sourceNodeId,
+                        it->m_frontBuffer.data(), it->m_frontBuffer.size());
                 }
             }
             acsSendNowExpiry = nowPtime + ACS_SEND_PERIOD;
@@ -839,6 +803,7 @@ void ZmqStorageInterface::ThreadFunc() {
         while (custodyTimers.PollOneAndPopAnyExpiredCustodyTimer(custodyIdExpiredAndNeedingResent, nowPtime)) {
             if (bsm.ReturnCustodyIdToAwaitingSend(custodyIdExpiredAndNeedingResent)) {
                 ++numCustodyTransferTimeouts;
+                releaseWindowManager.OnRetry(bsm.GetCatalogEntryPtrFromCustodyId(custodyIdExpiredAndNeedingResent)->destEid, nowPtime);
             }
             else {
                 std::cerr << "error unable to return expired custody id " << custodyIdExpiredAndNeedingResent << " to the awaiting send\n";
@@ -846,54 +811,88 @@ void ZmqStorageInterface::ThreadFunc() {
         }
         
         
-        //Send and maintain a maximum of 5 unacked bundles (per flow id) to Egress.
-        //When a bundle is acked from egress using the head segment Id, the bundle is deleted from disk and a new bundle can be sent.
-        static const uint64_t maxBundleSizeToRead = UINT64_MAX;// 65535 * 10;
+        //Send and maintain a window of unacked bundle bytes (per outduct) to Egress.
+        //When a bundle is acked from egress, the bundle is deleted from disk (unless awaiting custody) and the window reopens.
+        //A bundle counts against its window from the moment it is popped for read ahead.
+        bool releaseProgress = false;
+        bool egressFull = false;
         if (availableDestLinksSet.empty()) {
             timeoutPoll = DEFAULT_BIG_TIMEOUT_POLL;
         }
-        else {
+        while ((!availableDestLinksSet.empty()) && (!readAheadPipeline.IsFull())) {
             availableDestLinksNotCloggedVec.resize(0); 
             availableDestLinksCloggedVec.resize(0);
             for (std::set<eid_plus_isanyserviceid_pair_t>::const_iterator it = availableDestLinksSet.cbegin(); it != availableDestLinksSet.cend(); ++it) {
-                //std::cout << "flow " << flowId << " sz " << flowIdToOpenSessionsMap[flowId].size() << std::endl;
-                //const bool isAnyServiceId = it->second;
-                if (finalDestEidToOpenCustIdsMap[it->first].size() < 5) {//finaldesteid_opencustids_map_t finalDestEidToOpenCustIdsMap;
+                if (releaseWindowManager.CanRelease(it->first, it->second)) {
                     availableDestLinksNotCloggedVec.push_back(*it);
                 }
                 else {
                     availableDestLinksCloggedVec.push_back(*it);
                 }
             }
-            if (availableDestLinksNotCloggedVec.size() > 0) {
-                if (ReleaseOne_NoBlock(sessionRead, availableDestLinksNotCloggedVec, m_zmqPushSock_connectingStorageToBoundEgressPtr.get(), bsm, maxBundleSizeToRead)) { //true => (successfully sent to egress)
-                    if (finalDestEidToOpenCustIdsMap[sessionRead.catalogEntryPtr->destEid].insert(sessionRead.custodyId).second) {
-                        if (sessionRead.catalogEntryPtr->HasCustody()) {
-                            custodyTimers.StartCustodyTransferTimer(sessionRead.catalogEntryPtr->destEid, sessionRead.custodyId);
-                        }
-                        timeoutPoll = 0; //no timeout as we need to keep feeding to egress
-                        ++m_totalBundlesSentToEgressFromStorage;
-                    }
-                    else {
-                        std::cerr << "could not insert custody id into finalDestEidToOpenCustIdsMap\n";
-                    }
-                }
-                else if (PeekOne(availableDestLinksCloggedVec, bsm) > 0) { //data available in storage for clogged links
+            if (availableDestLinksNotCloggedVec.empty()) { //all links clogged up and need acks
+                timeoutPoll = 1; //shortest timeout 1ms as we wait for acks
+                ++m_totalEventsAllLinksClogged;
+                break;
+            }
+            const ReleaseReadAheadPipeline::read_ahead_t * readAheadPtr = readAheadPipeline.PopAndStartRead(availableDestLinksNotCloggedVec);
+            if (readAheadPtr == NULL) {
+                if (PeekOne(availableDestLinksCloggedVec, bsm) > 0) { //data available in storage for clogged links
                     timeoutPoll = 1; //shortest timeout 1ms as we wait for acks
-                    ++totalEventsDataInStorageForCloggedLinks;
+                    ++m_totalEventsDataInStorageForCloggedLinks;
                 }
-                else { //no data in storage for any available links
+                else { //no data in storage for any available links (or the read ahead is out of bytes)
                     timeoutPoll = DEFAULT_BIG_TIMEOUT_POLL;
-                    ++totalEventsNoDataInStorageForAvailableLinks;
+                    ++m_totalEventsNoDataInStorageForAvailableLinks;
                 }
+                break;
             }
-            else { //all links clogged up and need acks
-                timeoutPoll = 1; //shortest timeout 1ms as we wait for acks
-                ++totalEventsAllLinksClogged;
+            const eid_plus_isanyserviceid_pair_t releasedLink = GetReleasedLink(readAheadPtr->destEid, availableDestLinksNotCloggedVec);
+            if (!releaseWindowManager.OnReleased(releasedLink.first, releasedLink.second, readAheadPtr->session.custodyId, readAheadPtr->bundleSizeBytes, nowPtime)) {
+                std::cerr << "could not insert custody id into the release window\n";
             }
+            releaseProgress = true;
+        }
+        readAheadPipeline.QueueReads_NoBlock();
+        if (readAheadPipeline.ProcessFinishedReads_NoBlock(*m_toEgressChannelSenderPtr, m_sharedMemoryBundleArenaPtr.get(),
+            releaseWindowManager, custodyTimers, m_totalBundlesSentToEgressFromStorage, egressFull))
+        {
+            releaseProgress = true;
+        }
+        if (egressFull) {
+            timeoutPoll = 1;
+        }
+        else if (releaseProgress) {
+            timeoutPoll = 0; //no timeout as we need to keep feeding to egress
+        }
+        else if (!readAheadPipeline.IsEmpty()) {
+            readAheadPipeline.WaitForProgress(RELEASE_READ_AHEAD_MAX_WAIT);
+            timeoutPoll = 0;
+        }
+        else if (!expiredBundleSweep.IsEmpty()) {
+            expiredBundleSweep.WaitForProgress(RELEASE_READ_AHEAD_MAX_WAIT);
+            timeoutPoll = 0;
+        }
+
+        if (releaseWindowStatsNowExpiry <= nowPtime) {
+            boost::mutex::scoped_lock lock(m_releaseWindowStatsMutex);
+            releaseWindowManager.GetStats(m_releaseWindowStatsVec);
+            releaseWindowStatsNowExpiry = nowPtime + RELEASE_WINDOW_STATS_PERIOD;
         }
         
         //}
+
+        if ((expirySweepNowExpiry <= nowPtime) && expiredBundleSweep.CanStartSlice()) { //else continue the sweep once the reads finish
+            if (expiredBundleSweep.StartSlice(TimestampUtil::GetSecondsSinceEpochRfc5050(nowPtime))) { //more may remain, continue the sweep next iteration
+                timeoutPoll = 0;
+            }
+            else {
+                expirySweepNowExpiry = nowPtime + EXPIRY_SWEEP_PERIOD;
+            }
+        }
+        expiredBundleSweep.ProcessFinishedReads();
+        m_totalBundlesErasedFromStorageExpired = expiredBundleSweep.GetTotalBundlesErased();
+        m_numExpiredBundleDeletionStatusReports = expiredBundleSweep.GetTotalDeletionStatusReports();
         
 
         /*hdtn::flow_stats stats = m_storeFlow.stats();
@@ -903,23 +902,39 @@ void ZmqStorageInterface::ThreadFunc() {
         m_workerStats.flow.disk_rcount = stats.disk_rcount;*/
         
     }
-    std::cout << "totalEventsAllLinksClogged: " << totalEventsAllLinksClogged << std::endl;
-    std::cout << "totalEventsNoDataInStorageForAvailableLinks: " << totalEventsNoDataInStorageForAvailableLinks << std::endl;
-    std::cout << "totalEventsDataInStorageForCloggedLinks: " << totalEventsDataInStorageForCloggedLinks << std::endl;
+    std::cout << "totalEventsAllLinksClogged: " << m_totalEventsAllLinksClogged << std::endl;
+    std::cout << "totalEventsNoDataInStorageForAvailableLinks: " << m_totalEventsNoDataInStorageForAvailableLinks << std::endl;
+    std::cout << "totalEventsDataInStorageForCloggedLinks: " << m_totalEventsDataInStorageForCloggedLinks << std::endl;
+    const std::string releaseWindowStatsString = releaseWindowManager.GetStatsString();
+    std::cout << releaseWindowStatsString;
     std::cout << "m_numRfc5050CustodyTransfers: " << m_numRfc5050CustodyTransfers << std::endl;
     std::cout << "m_numAcsCustodyTransfers: " << m_numAcsCustodyTransfers << std::endl;
     std::cout << "m_numAcsPacketsReceived: " << m_numAcsPacketsReceived << std::endl;
     std::cout << "m_totalBundlesErasedFromStorageNoCustodyTransfer: " << m_totalBundlesErasedFromStorageNoCustodyTransfer << std::endl;
     std::cout << "m_totalBundlesErasedFromStorageWithCustodyTransfer: " << m_totalBundlesErasedFromStorageWithCustodyTransfer << std::endl;
+    std::cout << "m_totalBundlesErasedFromStorageExpired: " << m_totalBundlesErasedFromStorageExpired << std::endl;
+    std::cout << "m_numExpiredBundleDeletionStatusReports: " << m_numExpiredBundleDeletionStatusReports << std::endl;
     std::cout << "numCustodyTransferTimeouts: " << numCustodyTransferTimeouts << std::endl;
+    std::cout << "totalAckMessagesSentToIngress: " << ingressAckBatcher.m_totalMessagesSent
+        << " (" << ingressAckBatcher.GetAverageAcksPerMessage() << " acks per message)" << std::endl;
     hdtn::Logger::getInstance()->logInfo("storage", "totalEventsAllLinksClogged: " + 
-        std::to_string(totalEventsAllLinksClogged));
+        std::to_string(m_totalEventsAllLinksClogged));
     hdtn::Logger::getInstance()->logInfo("storage", "totalEventsNoDataInStorageForAvailableLinks: " + 
-        std::to_string(totalEventsNoDataInStorageForAvailableLinks));
+        std::to_string(m_totalEventsNoDataInStorageForAvailableLinks));
     hdtn::Logger::getInstance()->logInfo("storage", "totalEventsDataInStorageForCloggedLinks: " + 
-        std::to_string(totalEventsDataInStorageForCloggedLinks));
+        std::to_string(m_totalEventsDataInStorageForCloggedLinks));
+    hdtn::Logger::getInstance()->logInfo("storage", releaseWindowStatsString);
+    hdtn::Logger::getInstance()->logInfo("storage", "totalBundlesErasedFromStorageExpired: " +
+        std::to_string(m_totalBundlesErasedFromStorageExpired) + " (" + std::to_string(m_numExpiredBundleDeletionStatusReports) + " deletion status reports)");
+    hdtn::Logger::getInstance()->logInfo("storage", "totalAckMessagesSentToIngress: " +
+        std::to_string(ingressAckBatcher.m_totalMessagesSent) + " (" + std::to_string(ingressAckBatcher.GetAverageAcksPerMessage()) + " acks per message)");
 }
 
 std::size_t ZmqStorageInterface::GetCurrentNumberOfBundlesDeletedFromStorage() {
-    return m_totalBundlesErasedFromStorageNoCustodyTransfer + m_totalBundlesErasedFromStorageWithCustodyTransfer;
+    return m_totalBundlesErasedFromStorageNoCustodyTransfer + m_totalBundlesErasedFromStorageWithCustodyTransfer + m_totalBundlesErasedFromStorageExpired;
+}
+
+void ZmqStorageInterface::GetReleaseWindowStats(std::vector<release_window_stats_t> & stats) {
+    boost::mutex::scoped_lock lock(m_releaseWindowStatsMutex);
+    stats = m_releaseWindowStatsVec;
 }
@@ -10,6 +10,7 @@
 #include <string>
 #include "BundleStorageManagerMT.h"
 #include "BundleStorageManagerAsio.h"
+#include "BundleStorageManagerIoUring.h"
 #include <boost/make_unique.hpp>
 #include <boost/random/mersenne_twister.hpp>
 #include <boost/random/uniform_int_distribution.hpp>
@@ -51,7 +52,7 @@ struct TestFile {
 //two days
 #define NUMBER_OF_EXPIRATIONS (86400*2)
 
-bool TestSpeed(BundleStorageManagerBase & bsm) {
+bool TestSpeed(BundleStorageManagerBase & bsm, double & readAvgGigaBitsPerSec, double & writeAvgGigaBitsPerSec) {
     boost::random::mt19937 gen(static_cast<unsigned int>(std::time(0)));
     const boost::random::uniform_int_distribution<> distLinkId(0, 9);
     const boost::random::uniform_int_distribution<> distFileId(0, 9);
@@ -59,8 +60,6 @@ bool TestSpeed(BundleStorageManagerBase & bsm) {
     const boost::random::uniform_int_distribution<> distAbsExpiration(0, NUMBER_OF_EXPIRATIONS - 1);
     const boost::random::uniform_int_distribution<> distTotalBundleSize(1, 65536);
 
-    g_sigHandler.Start();
-
     static const cbhe_eid_t DEST_LINKS[10] = {
         cbhe_eid_t(1,1),
         cbhe_eid_t(2,1),
@@ -230,19 +229,55 @@ bool TestSpeed(BundleStorageManagerBase & bsm) {
         hdtn::Logger::getInstance()->logInfo("storage", "Read avg GBits/sec=" + std::to_string(gigaBitsPerSecReadDoubleAvg));
         hdtn::Logger::getInstance()->logInfo("storage", "Write avg GBits/sec=" + std::to_string(gigaBitsPerSecWriteDoubleAvg));
     }
+    readAvgGigaBitsPerSec = gigaBitsPerSecReadDoubleAvg / NUM_TESTS;
+    writeAvgGigaBitsPerSec = gigaBitsPerSecWriteDoubleAvg / NUM_TESTS;
     return true;
 
 }
 
 
-int main() {
-    std::unique_ptr<BundleStorageManagerBase> bsmPtr;
-    if (true) {
-        boost::make_unique<BundleStorageManagerMT>();
+static std::unique_ptr<BundleStorageManagerBase> CreateBundleStorageManager(const std::string & storageImplementation) {
+    if (storageImplementation == "stdio_multi_threaded") {
+        return boost::make_unique<BundleStorageManagerMT>();
+    }
+    else if (storageImplementation == "asio_single_threaded") {
+        return boost::make_unique<BundleStorageManagerAsio>();
+    }
+    else if (storageImplementation == "io_uring_multi_threaded") {
+        return boost::make_unique<BundleStorageManagerIoUring>();
+    }
+    return std::unique_ptr<BundleStorageManagerBase>();
+}
+
+//usage: storage-speedtest [storageImplementation...]  (uses storageConfig.json in the working directory)
+//With no arguments, all implementations are tested one after the other and compared.
+int main(int argc, char * argv[]) {
+    std::vector<std::string> storageImplementations;
+    for (int i = 1; i < argc; ++i) {
+        storageImplementations.push_back(argv[i]);
     }
-    else {
-        boost::make_unique<BundleStorageManagerAsio>();
+    if (storageImplementations.empty()) {
+        storageImplementations = { "stdio_multi_threaded", "asio_single_threaded", "io_uring_multi_threaded" };
+    }
+    g_sigHandler.Start();
+    std::vector<std::pair<double, double> > readWriteResults(storageImplementations.size(), std::pair<double, double>(0.0, 0.0));
+    for (std::size_t i = 0; (i < storageImplementations.size()) && g_running; ++i) {
+        std::cout << "testing " << storageImplementations[i] << "\n";
+        std::unique_ptr<BundleStorageManagerBase> bsmPtr = CreateBundleStorageManager(storageImplementations[i]);
+        if (!bsmPtr) {
+            std::cerr << "invalid storage implementation " << storageImplementations[i] << std::endl;
+            return 1;
+        }
+        if (!TestSpeed(*bsmPtr, readWriteResults[i].first, readWriteResults[i].second)) {
+            std::cerr << "speed test failed for " << storageImplementations[i] << std::endl;
+            return 1;
+        }
+    }
+    if (g_running) {
+        for (std::size_t i = 0; i < storageImplementations.size(); ++i) {
+            std::cout << storageImplementations[i] << ": Read avg GBits/sec=" << readWriteResults[i].first
+                << " Write avg GBits/sec=" << readWriteResults[i].second << "\n";
+        }
     }
-    std::cout << TestSpeed(*bsmPtr) << "\n";
     return 0;
 }
@@ -1,6 +1,7 @@
 #include <boost/test/unit_test.hpp>
 #include "BundleStorageManagerMT.h"
 #include "BundleStorageManagerAsio.h"
+#include "BundleStorageManagerIoUring.h"
 #include <iostream>
 #include <string>
 #include <boost/filesystem.hpp>
@@ -85,7 +86,7 @@ static bool GenerateBundleV7(std::vector<uint8_t> & bundle, const Bpv7CbhePrimar
 
 BOOST_AUTO_TEST_CASE(BundleStorageManagerAllTestCase)
 {
-    for (unsigned int whichBsm = 0; whichBsm < 2; ++whichBsm) {
+    for (unsigned int whichBsm = 0; whichBsm < 3; ++whichBsm) {
         boost::random::mt19937 gen(static_cast<unsigned int>(std::time(0)));
         const boost::random::uniform_int_distribution<> distRandomData(0, 255);
         const boost::random::uniform_int_distribution<> distLinkId(0, 9);
@@ -127,10 +128,14 @@ BOOST_AUTO_TEST_CASE(BundleStorageManagerAllTestCase)
             std::cout << "create BundleStorageManagerMT" << std::endl;
             bsmPtr = boost::make_unique<BundleStorageManagerMT>(ptrStorageConfig);
         }
-        else {
+        else if (whichBsm == 1) {
             std::cout << "create BundleStorageManagerAsio" << std::endl;
             bsmPtr = boost::make_unique<BundleStorageManagerAsio>(ptrStorageConfig);
         }
+        else {
+            std::cout << "create BundleStorageManagerIoUring" << std::endl;
+            bsmPtr = boost::make_unique<BundleStorageManagerIoUring>(ptrStorageConfig);
+        }
         BundleStorageManagerBase & bsm = *bsmPtr;
 
         bsm.Start();
@@ -233,10 +238,198 @@ BOOST_AUTO_TEST_CASE(BundleStorageManagerAllTestCase)
 
 
 
+BOOST_AUTO_TEST_CASE(BundleStorageManagerAll_ExpiredBundles_TestCase)
+{
+    for (unsigned int whichBsm = 0; whichBsm < 3; ++whichBsm) {
+        const std::vector<cbhe_eid_t> availableDestLinks = { cbhe_eid_t(1,1), cbhe_eid_t(2,1) };
+
+        std::unique_ptr<BundleStorageManagerBase> bsmPtr;
+        StorageConfig_ptr ptrStorageConfig = StorageConfig::CreateFromJsonFile((Environment::GetPathHdtnSourceRoot() / "tests" / "config_files" / "storage" / "storageConfigRelativePaths.json").string());
+        ptrStorageConfig->m_tryToRestoreFromDisk = false; //manually set this json entry
+        ptrStorageConfig->m_autoDeleteFilesOnExit = true; //manually set this json entry
+        if (whichBsm == 0) {
+            bsmPtr = boost::make_unique<BundleStorageManagerMT>(ptrStorageConfig);
+        }
+        else if (whichBsm == 1) {
+            bsmPtr = boost::make_unique<BundleStorageManagerAsio>(ptrStorageConfig);
+        }
+        else {
+            bsmPtr = boost::make_unique<BundleStorageManagerIoUring>(ptrStorageConfig);
+        }
+        BundleStorageManagerBase & bsm = *bsmPtr;
+        bsm.Start();
+
+        static const uint64_t sizes[4] = { 1, BUNDLE_STORAGE_PER_SEGMENT_SIZE + 1, 3 * BUNDLE_STORAGE_PER_SEGMENT_SIZE, 100 };
+        std::vector<std::vector<uint8_t> > datas(4);
+        for (uint64_t custodyId = 0; custodyId < 4; ++custodyId) {
+            std::vector<uint8_t> & data = datas[custodyId];
+            data.resize(sizes[custodyId]);
+            for (std::size_t i = 0; i < data.size(); ++i) {
+                data[i] = static_cast<uint8_t>(i + custodyId);
+            }
+            Bpv6CbhePrimaryBlock primary;
+            primary.SetZero();
+            primary.m_bundleProcessingControlFlags = BPV6_BUNDLEFLAG::PRIORITY_NORMAL | BPV6_BUNDLEFLAG::SINGLETON | BPV6_BUNDLEFLAG::NOFRAGMENT;
+            primary.m_sourceNodeId.Set(PRIMARY_SRC_NODE, PRIMARY_SRC_SVC);
+            primary.m_destinationEid = availableDestLinks[custodyId % 2];
+            primary.m_creationTimestamp.secondsSinceStartOfYear2000 = 0;
+            primary.m_lifetimeSeconds = 10 + (10 * custodyId); //expires at 10, 20, 30, 40
+            primary.m_creationTimestamp.sequenceNumber = PRIMARY_SEQ;
+            BundleStorageManagerSession_WriteToDisk sessionWrite;
+            BOOST_REQUIRE_NE(bsm.Push(sessionWrite, primary, data.size()), 0);
+            BOOST_REQUIRE_EQUAL(bsm.PushAllSegments(sessionWrite, primary, custodyId, data.data(), data.size()), data.size());
+        }
+
+        std::vector<uint64_t> expiredIds;
+        BOOST_REQUIRE_EQUAL(bsm.GetExpiredBundleIds(0, 25, 100, expiredIds), 2);
+        BundleStorageManagerSession_ReadFromDisk sessionRead;
+        std::vector<uint8_t> headSegment(BUNDLE_STORAGE_PER_SEGMENT_SIZE);
+        for (std::size_t i = 0; i < expiredIds.size(); ++i) {
+            const uint64_t custodyId = expiredIds[i];
+            BOOST_REQUIRE_LT(custodyId, 2);
+            const std::vector<uint8_t> & data = datas[custodyId];
+            const std::size_t headSize = bsm.ReadFirstSegment(sessionRead, custodyId, headSegment.data());
+            BOOST_REQUIRE_EQUAL(headSize, std::min<uint64_t>(data.size(), BUNDLE_STORAGE_PER_SEGMENT_SIZE));
+            BOOST_REQUIRE(std::equal(data.begin(), data.begin() + headSize, headSegment.begin()));
+            std::vector<uint8_t> dataReadBack;
+            BOOST_REQUIRE(bsm.ReadAllSegments(sessionRead, dataReadBack));
+            BOOST_REQUIRE(dataReadBack == data);
+            BOOST_REQUIRE(bsm.RemoveAwaitingSendBundleFromDisk(custodyId));
+            BOOST_REQUIRE(!bsm.RemoveAwaitingSendBundleFromDisk(custodyId));
+        }
+        BOOST_REQUIRE_EQUAL(bsm.GetExpiredBundleIds(0, 25, 100, expiredIds), 0);
+
+        //non-blocking read of the head of an expired bundle, then of the whole bundle
+        {
+            BOOST_REQUIRE_EQUAL(bsm.GetExpiredBundleIds(0, 35, 100, expiredIds), 1);
+            const uint64_t custodyId = expiredIds[0];
+            BOOST_REQUIRE_EQUAL(custodyId, 2);
+            const std::vector<uint8_t> & data = datas[custodyId];
+            BundleStorageManagerSession_ReadAhead sessionReadAhead;
+            std::vector<uint8_t> buf;
+            BOOST_REQUIRE_EQUAL(bsm.PopAwaitingSend(sessionReadAhead, custodyId, 1, buf), data.size());
+            BOOST_REQUIRE_EQUAL(bsm.GetExpiredBundleIds(0, 35, 100, expiredIds), 0); //no longer awaiting send
+            BOOST_REQUIRE_EQUAL(bsm.QueueReadAheadSegments_NoBlock(sessionReadAhead), 1);
+            while (!bsm.WaitForReadAheadProgress(sessionReadAhead, boost::posix_time::milliseconds(10))) {}
+            BOOST_REQUIRE(bsm.FinishReadAhead(sessionReadAhead));
+            BOOST_REQUIRE_EQUAL(buf.size(), BUNDLE_STORAGE_PER_SEGMENT_SIZE);
+            BOOST_REQUIRE(std::equal(buf.begin(), buf.end(), data.begin()));
+
+            bsm.StartReadAhead(sessionReadAhead, UINT32_MAX, buf);
+            BOOST_REQUIRE_EQUAL(bsm.QueueReadAheadSegments_NoBlock(sessionReadAhead), 3);
+            while (!bsm.WaitForReadAheadProgress(sessionReadAhead, boost::posix_time::milliseconds(10))) {}
+            BOOST_REQUIRE(bsm.FinishReadAhead(sessionReadAhead));
+            BOOST_REQUIRE(buf == data);
+            BOOST_REQUIRE(bsm.RemoveReadBundleFromDisk(sessionReadAhead.catalogEntryPtr, custodyId));
+            BOOST_REQUIRE_EQUAL(bsm.PopAwaitingSend(sessionReadAhead, custodyId, 1, buf), 0);
+        }
+
+        //the unexpired bundle is still released normally
+        for (uint64_t custodyId = 3; custodyId < 4; ++custodyId) {
+            BOOST_REQUIRE_EQUAL(bsm.PopTop(sessionRead, availableDestLinks), datas[custodyId].size());
+            BOOST_REQUIRE_EQUAL(sessionRead.custodyId, custodyId);
+            std::vector<uint8_t> dataReadBack;
+            BOOST_REQUIRE(bsm.ReadAllSegments(sessionRead, dataReadBack));
+            BOOST_REQUIRE(dataReadBack == datas[custodyId]);
+            BOOST_REQUIRE(bsm.RemoveReadBundleFromDisk(sessionRead));
+        }
+        BOOST_REQUIRE_EQUAL(bsm.PopTop(sessionRead, availableDestLinks), 0);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(BundleStorageManagerAll_ReadAhead_TestCase)
+{
+    for (unsigned int whichBsm = 0; whichBsm < 3; ++whichBsm) {
+        const std::vector<std::pair<cbhe_eid_t, bool> > availableDests = { std::pair<cbhe_eid_t, bool>(cbhe_eid_t(1,1), false), std::pair<cbhe_eid_t, bool>(cbhe_eid_t(2,0), true) };
+
+        std::unique_ptr<BundleStorageManagerBase> bsmPtr;
+        StorageConfig_ptr ptrStorageConfig = StorageConfig::CreateFromJsonFile((Environment::GetPathHdtnSourceRoot() / "tests" / "config_files" / "storage" / "storageConfigRelativePaths.json").string());
+        ptrStorageConfig->m_tryToRestoreFromDisk = false; //manually set this json entry
+        ptrStorageConfig->m_autoDeleteFilesOnExit = true; //manually set this json entry
+        if (whichBsm == 0) {
+            bsmPtr = boost::make_unique<BundleStorageManagerMT>(ptrStorageConfig);
+        }
+        else if (whichBsm == 1) {
+            bsmPtr = boost::make_unique<BundleStorageManagerAsio>(ptrStorageConfig);
+        }
+        else {
+            bsmPtr = boost::make_unique<BundleStorageManagerIoUring>(ptrStorageConfig);
+        }
+        BundleStorageManagerBase & bsm = *bsmPtr;
+        bsm.Start();
+
+        //the 100 segment bundle can't be queued all at once by MT and Asio (more than CIRCULAR_INDEX_BUFFER_SIZE segments per disk)
+        static const uint64_t sizes[5] = { 1, BUNDLE_STORAGE_PER_SEGMENT_SIZE, BUNDLE_STORAGE_PER_SEGMENT_SIZE + 1, 100 * BUNDLE_STORAGE_PER_SEGMENT_SIZE - 7, 3 * BUNDLE_STORAGE_PER_SEGMENT_SIZE };
+        std::vector<std::vector<uint8_t> > datas(5);
+        for (uint64_t custodyId = 0; custodyId < 5; ++custodyId) {
+            std::vector<uint8_t> & data = datas[custodyId];
+            data.resize(sizes[custodyId]);
+            for (std::size_t i = 0; i < data.size(); ++i) {
+                data[i] = static_cast<uint8_t>((i * 7) + custodyId);
+            }
+            Bpv6CbhePrimaryBlock primary;
+            primary.SetZero();
+            primary.m_bundleProcessingControlFlags = BPV6_BUNDLEFLAG::PRIORITY_NORMAL | BPV6_BUNDLEFLAG::SINGLETON | BPV6_BUNDLEFLAG::NOFRAGMENT;
+            primary.m_sourceNodeId.Set(PRIMARY_SRC_NODE, PRIMARY_SRC_SVC);
+            primary.m_destinationEid = (custodyId % 2) ? cbhe_eid_t(2, custodyId) : cbhe_eid_t(1, 1);
+            primary.m_creationTimestamp.secondsSinceStartOfYear2000 = 0;
+            primary.m_lifetimeSeconds = 1000;
+            primary.m_creationTimestamp.sequenceNumber = PRIMARY_SEQ;
+            BundleStorageManagerSession_WriteToDisk sessionWrite;
+            BOOST_REQUIRE_NE(bsm.Push(sessionWrite, primary, data.size()), 0);
+            BOOST_REQUIRE_EQUAL(bsm.PushAllSegments(sessionWrite, primary, custodyId, data.data(), data.size()), data.size());
+        }
+
+        //all five bundles have their reads outstanding at once
+        std::vector<BundleStorageManagerSession_ReadAhead> sessions(5);
+        std::vector<std::vector<uint8_t> > bufs(5);
+        std::vector<bool> poppedCustodyIds(5, false);
+        for (std::size_t i = 0; i < sessions.size(); ++i) {
+            const uint64_t bundleSizeBytes = bsm.PopTop(sessions[i], availableDests, bufs[i]);
+            BOOST_REQUIRE_LT(sessions[i].custodyId, 5);
+            BOOST_REQUIRE_EQUAL(bundleSizeBytes, sizes[sessions[i].custodyId]);
+            BOOST_REQUIRE(!poppedCustodyIds[sessions[i].custodyId]);
+            poppedCustodyIds[sessions[i].custodyId] = true;
+            BOOST_REQUIRE_EQUAL(bufs[i].size(), sessions[i].numSegments * SEGMENT_SIZE);
+            if (i == 0) { //returned bundles are popped again
+                BOOST_REQUIRE(bsm.ReturnTop(sessions[i]));
+                poppedCustodyIds[sessions[i].custodyId] = false;
+                BOOST_REQUIRE_EQUAL(bsm.PopTop(sessions[i], availableDests, bufs[i]), bundleSizeBytes);
+                poppedCustodyIds[sessions[i].custodyId] = true;
+            }
+            bsm.QueueReadAheadSegments_NoBlock(sessions[i]);
+        }
+        std::vector<uint8_t> unusedBuf;
+        BundleStorageManagerSession_ReadAhead unusedSession;
+        BOOST_REQUIRE_EQUAL(bsm.PopTop(unusedSession, availableDests, unusedBuf), 0);
+
+        std::size_t numFinished = 0;
+        std::vector<bool> finished(5, false);
+        while (numFinished < sessions.size()) {
+            for (std::size_t i = 0; i < sessions.size(); ++i) {
+                if (finished[i]) {
+                    continue;
+                }
+                bsm.QueueReadAheadSegments_NoBlock(sessions[i]);
+                if (!bsm.IsReadAheadComplete(sessions[i])) {
+                    bsm.WaitForReadAheadProgress(sessions[i], boost::posix_time::milliseconds(10));
+                    continue;
+                }
+                BOOST_REQUIRE(bsm.FinishReadAhead(sessions[i]));
+                BOOST_REQUIRE(bufs[i] == datas[sessions[i].custodyId]);
+                BOOST_REQUIRE(bsm.RemoveReadBundleFromDisk(sessions[i].catalogEntryPtr, sessions[i].custodyId));
+                finished[i] = true;
+                ++numFinished;
+            }
+        }
+        BOOST_REQUIRE_EQUAL(bsm.PopTop(unusedSession, availableDests, unusedBuf), 0);
+    }
+}
+
 BOOST_AUTO_TEST_CASE(BundleStorageManagerAll_RestoreFromDisk_TestCase)
 {
     for (unsigned int whichBundleVersion = 6; whichBundleVersion <= 7; ++whichBundleVersion) {
-        for (unsigned int whichBsm = 0; whichBsm < 2; ++whichBsm) {
+        for (unsigned int whichBsm = 0; whichBsm < 3; ++whichBsm) {
             boost::random::mt19937 gen(static_cast<unsigned int>(std::time(0)));
             const boost::random::uniform_int_distribution<> distRandomData(0, 255);
             const boost::random::uniform_int_distribution<> distPriorityIndex(0, 2);
@@ -304,10 +497,14 @@ BOOST_AUTO_TEST_CASE(BundleStorageManagerAll_RestoreFromDisk_TestCase)
                     std::cout << "create BundleStorageManagerMT for Restore" << std::endl;
                     bsmPtr = boost::make_unique<BundleStorageManagerMT>(ptrStorageConfig);
                 }
-                else {
+                else if (whichBsm == 1) {
                     std::cout << "create BundleStorageManagerAsio for Restore" << std::endl;
                     bsmPtr = boost::make_unique<BundleStorageManagerAsio>(ptrStorageConfig);
                 }
+                else {
+                    std::cout << "create BundleStorageManagerIoUring for Restore" << std::endl;
+                    bsmPtr = boost::make_unique<BundleStorageManagerIoUring>(ptrStorageConfig);
+                }
                 BundleStorageManagerBase & bsm = *bsmPtr;
 
                 bsm.Start();
@@ -399,10 +596,14 @@ BOOST_AUTO_TEST_CASE(BundleStorageManagerAll_RestoreFromDisk_TestCase)
                     std::cout << "create BundleStorageManagerMT for Restore" << std::endl;
                     bsmPtr = boost::make_unique<BundleStorageManagerMT>(ptrStorageConfig);
                 }
-                else {
+                else if (whichBsm == 1) {
                     std::cout << "create BundleStorageManagerAsio for Restore" << std::endl;
                     bsmPtr = boost::make_unique<BundleStorageManagerAsio>(ptrStorageConfig);
                 }
+                else {
+                    std::cout << "create BundleStorageManagerIoUring for Restore" << std::endl;
+                    bsmPtr = boost::make_unique<BundleStorageManagerIoUring>(ptrStorageConfig);
+                }
                 BundleStorageManagerBase & bsm = *bsmPtr;
 
 
@@ -459,3 +660,165 @@ BOOST_AUTO_TEST_CASE(BundleStorageManagerAll_RestoreFromDisk_TestCase)
         }
     }
 }
+
+BOOST_AUTO_TEST_CASE(BundleStorageManagerAll_RestoreFromCatalogJournal_TestCase)
+{
+    for (unsigned int whichBsm = 0; whichBsm < 3; ++whichBsm) {
+        for (unsigned int corruptCheckpoint = 0; corruptCheckpoint < 2; ++corruptCheckpoint) { //a corrupted checkpoint falls back to scanning the disks
+            static const uint64_t sizes[6] = {
+                BUNDLE_STORAGE_PER_SEGMENT_SIZE - 2,
+                BUNDLE_STORAGE_PER_SEGMENT_SIZE + 1,
+                2 * BUNDLE_STORAGE_PER_SEGMENT_SIZE,
+                100 * BUNDLE_STORAGE_PER_SEGMENT_SIZE + 1,
+                3 * BUNDLE_STORAGE_PER_SEGMENT_SIZE - 1,
+                10 * BUNDLE_STORAGE_PER_SEGMENT_SIZE
+            };
+            static const std::string CATALOG_JOURNAL_FILE_PATH = "./catalog_journal.bin";
+            const std::vector<cbhe_eid_t> availableDestLinks = { cbhe_eid_t(1,1), cbhe_eid_t(2,1) };
+            const std::vector<cbhe_eid_t> availableDestLinks2 = { cbhe_eid_t(2,1) };
+            std::map<uint64_t, std::vector<uint8_t> > mapBundleSizeToBundleData;
+            uint64_t bytesWritten = 0, totalSegmentsWritten = 0;
+            backup_memmanager_t backup;
+
+            for (unsigned int restore = 0; restore < 2; ++restore) {
+                if (restore && corruptCheckpoint) {
+                    const boost::filesystem::path checkpointFilePath(CATALOG_JOURNAL_FILE_PATH + ".checkpoint");
+                    BOOST_REQUIRE(boost::filesystem::exists(checkpointFilePath));
+                    boost::filesystem::resize_file(checkpointFilePath, boost::filesystem::file_size(checkpointFilePath) - 1); //truncate the last entry
+                }
+                std::unique_ptr<BundleStorageManagerBase> bsmPtr;
+                StorageConfig_ptr ptrStorageConfig = StorageConfig::CreateFromJsonFile((Environment::GetPathHdtnSourceRoot() / "tests" / "config_files" / "storage" / "storageConfigRelativePaths.json").string());
+                ptrStorageConfig->m_tryToRestoreFromDisk = (restore != 0); //manually set this json entry
+                ptrStorageConfig->m_autoDeleteFilesOnExit = (restore != 0); //manually set this json entry
+                ptrStorageConfig->m_catalogJournalFilePath = CATALOG_JOURNAL_FILE_PATH;
+                if (whichBsm == 0) {
+                    bsmPtr = boost::make_unique<BundleStorageManagerMT>(ptrStorageConfig);
+                }
+                else if (whichBsm == 1) {
+                    bsmPtr = boost::make_unique<BundleStorageManagerAsio>(ptrStorageConfig);
+                }
+                else {
+                    bsmPtr = boost::make_unique<BundleStorageManagerIoUring>(ptrStorageConfig);
+                }
+                BundleStorageManagerBase & bsm = *bsmPtr;
+
+                if (restore == 0) {
+                    bsm.Start();
+                    uint64_t deletedBundleSize = 0;
+                    for (uint64_t custodyId = 0; custodyId < 6; ++custodyId) {
+                        Bpv6CbhePrimaryBlock primary;
+                        primary.SetZero();
+                        primary.m_bundleProcessingControlFlags = BPV6_BUNDLEFLAG::PRIORITY_NORMAL | BPV6_BUNDLEFLAG::SINGLETON | BPV6_BUNDLEFLAG::NOFRAGMENT;
+                        primary.m_sourceNodeId.Set(PRIMARY_SRC_NODE, PRIMARY_SRC_SVC);
+                        primary.m_destinationEid = (custodyId == 3) ? cbhe_eid_t(2, 1) : cbhe_eid_t(1, 1);
+                        primary.m_creationTimestamp.secondsSinceStartOfYear2000 = 0;
+                        primary.m_lifetimeSeconds = 1000 + custodyId;
+                        primary.m_creationTimestamp.sequenceNumber = PRIMARY_SEQ;
+                        std::vector<uint8_t> bundle;
+                        BOOST_REQUIRE(GenerateBundle(bundle, primary, sizes[custodyId], static_cast<uint8_t>(custodyId)));
+                        BundleStorageManagerSession_WriteToDisk sessionWrite;
+                        const uint64_t totalSegmentsRequired = bsm.Push(sessionWrite, primary, bundle.size());
+                        BOOST_REQUIRE_NE(totalSegmentsRequired, 0);
+                        BOOST_REQUIRE_EQUAL(bsm.PushAllSegments(sessionWrite, primary, custodyId, bundle.data(), bundle.size()), bundle.size());
+                        if (custodyId == 3) {
+                            deletedBundleSize = bundle.size();
+                        }
+                        else {
+                            bytesWritten += bundle.size();
+                            totalSegmentsWritten += totalSegmentsRequired;
+                            mapBundleSizeToBundleData[bundle.size()] = std::move(bundle);
+                        }
+                    }
+
+                    //the removal of a middle bundle is journaled too
+                    BundleStorageManagerSession_ReadFromDisk sessionRead;
+                    BOOST_REQUIRE_EQUAL(bsm.PopTop(sessionRead, availableDestLinks2), deletedBundleSize);
+                    BOOST_REQUIRE(bsm.RemoveReadBundleFromDisk(sessionRead));
+
+                    bsm.GetMemoryManagerConstRef().BackupDataToVector(backup);
+                    continue; //destroyed leaving its files and a checkpoint of the catalog
+                }
+
+                BOOST_REQUIRE_MESSAGE(bsm.m_successfullyRestoredFromDisk, "error restoring from disk");
+                BOOST_REQUIRE_EQUAL(bsm.m_restoredFromCatalogJournal, (corruptCheckpoint == 0));
+                BOOST_REQUIRE(bsm.GetMemoryManagerConstRef().IsBackupEqual(backup));
+                BOOST_REQUIRE_EQUAL(bsm.m_totalBundlesRestored, 6 - 1);
+                BOOST_REQUIRE_EQUAL(bsm.m_totalBytesRestored, bytesWritten);
+                BOOST_REQUIRE_EQUAL(bsm.m_totalSegmentsRestored, totalSegmentsWritten);
+                bsm.Start();
+
+                BundleStorageManagerSession_ReadFromDisk sessionRead;
+                for (unsigned int i = 0; i < (6 - 1); ++i) {
+                    const uint64_t bytesToReadFromDisk = bsm.PopTop(sessionRead, availableDestLinks);
+                    BOOST_REQUIRE_EQUAL(mapBundleSizeToBundleData.count(bytesToReadFromDisk), 1);
+                    std::vector<uint8_t> dataReadBack;
+                    BOOST_REQUIRE(bsm.ReadAllSegments(sessionRead, dataReadBack));
+                    BOOST_REQUIRE(dataReadBack == mapBundleSizeToBundleData[bytesToReadFromDisk]);
+                    BOOST_REQUIRE(bsm.RemoveReadBundleFromDisk(sessionRead));
+                }
+                BOOST_REQUIRE_EQUAL(bsm.PopTop(sessionRead, availableDestLinks), 0);
+            }
+        }
+    }
+}
+
+//restores the same amount of data spread over 1, 2 and 4 store files by scanning the disks (no catalog journal),
+//half of the bundles having been removed so that the scan has to skip the dead chains
+BOOST_AUTO_TEST_CASE(BundleStorageManagerRestoreFromDiskMultiDiskSpeedTestCase, *boost::unit_test::disabled())
+{
+    static const unsigned int NUM_BUNDLES = 4000;
+    static const uint64_t BUNDLE_SIZE = 8 * BUNDLE_STORAGE_PER_SEGMENT_SIZE;
+    static const unsigned int NUM_DISKS_TO_TEST[3] = { 1, 2, 4 };
+    const std::vector<cbhe_eid_t> availableDestLinks = { cbhe_eid_t(1,1) };
+
+    Bpv6CbhePrimaryBlock primary;
+    primary.SetZero();
+    primary.m_bundleProcessingControlFlags = BPV6_BUNDLEFLAG::PRIORITY_NORMAL | BPV6_BUNDLEFLAG::SINGLETON | BPV6_BUNDLEFLAG::NOFRAGMENT;
+    primary.m_sourceNodeId.Set(PRIMARY_SRC_NODE, PRIMARY_SRC_SVC);
+    primary.m_destinationEid = cbhe_eid_t(1, 1);
+    primary.m_creationTimestamp.sequenceNumber = PRIMARY_SEQ;
+    primary.m_lifetimeSeconds = 1000;
+    std::vector<uint8_t> bundle;
+    BOOST_REQUIRE(GenerateBundle(bundle, primary, BUNDLE_SIZE, 0));
+
+    for (unsigned int numDisksI = 0; numDisksI < 3; ++numDisksI) {
+        const unsigned int numDisks = NUM_DISKS_TO_TEST[numDisksI];
+        StorageConfig_ptr ptrStorageConfig = StorageConfig::CreateFromJsonFile((Environment::GetPathHdtnSourceRoot() / "tests" / "config_files" / "storage" / "storageConfigRelativePaths.json").string());
+        ptrStorageConfig->m_catalogJournalFilePath = ""; //restore by scanning the disks only
+        ptrStorageConfig->m_storageDiskConfigVector.clear();
+        for (unsigned int diskId = 0; diskId < numDisks; ++diskId) {
+            const std::string diskIdStr = boost::lexical_cast<std::string>(diskId + 1);
+            ptrStorageConfig->m_storageDiskConfigVector.emplace_back("d" + diskIdStr, "./restore_speed_store" + diskIdStr + ".bin");
+        }
+
+        uint64_t numBundlesRemaining = 0;
+        {
+            ptrStorageConfig->m_tryToRestoreFromDisk = false;
+            ptrStorageConfig->m_autoDeleteFilesOnExit = false;
+            BundleStorageManagerMT bsm(ptrStorageConfig);
+            bsm.Start();
+            for (unsigned int i = 0; i < NUM_BUNDLES; ++i) {
+                BundleStorageManagerSession_WriteToDisk sessionWrite;
+                BOOST_REQUIRE_NE(bsm.Push(sessionWrite, primary, bundle.size()), 0);
+                BOOST_REQUIRE_EQUAL(bsm.PushAllSegments(sessionWrite, primary, i, bundle.data(), bundle.size()), bundle.size());
+            }
+            BundleStorageManagerSession_ReadFromDisk sessionRead;
+            for (unsigned int i = 0; i < (NUM_BUNDLES / 2); ++i) {
+                BOOST_REQUIRE_EQUAL(bsm.PopTop(sessionRead, availableDestLinks), bundle.size());
+                BOOST_REQUIRE(bsm.RemoveReadBundleFromDisk(sessionRead));
+            }
+            numBundlesRemaining = NUM_BUNDLES - (NUM_BUNDLES / 2);
+        }
+
+        ptrStorageConfig->m_tryToRestoreFromDisk = true;
+        ptrStorageConfig->m_autoDeleteFilesOnExit = true;
+        boost::timer::cpu_timer timer;
+        BundleStorageManagerMT bsm(ptrStorageConfig);
+        timer.stop();
+        BOOST_REQUIRE(bsm.m_successfullyRestoredFromDisk);
+        BOOST_REQUIRE(!bsm.m_restoredFromCatalogJournal);
+        BOOST_REQUIRE_EQUAL(bsm.m_totalBundlesRestored, numBundlesRemaining);
+        std::cout << "restored " << bsm.m_totalBundlesRestored << " bundles (" << bsm.m_totalSegmentsRestored << " segments) from "
+            << numDisks << " disk(s) in " << timer.format() << std::flush;
+    }
+}
@@ -2,8 +2,11 @@
 #include "MemoryManagerTreeArray.h"
 #include <boost/multiprecision/cpp_int.hpp>
 #include <boost/multiprecision/detail/bitscan.hpp>
+#include <boost/timer/timer.hpp>
 #include <iostream>
 #include <string>
+#include <random>
+#include <memory>
 #include <inttypes.h>
 
 BOOST_AUTO_TEST_CASE(MemoryManagerTreeArrayIsSegmentFreeTestCase)
@@ -96,3 +99,213 @@ BOOST_AUTO_TEST_CASE(MemoryManagerTreeArrayTestCase)
         BOOST_REQUIRE_EQUAL(segmentId, UINT32_MAX);
     }
 }
+
+BOOST_AUTO_TEST_CASE(MemoryManagerTreeArrayMemoryUsageTestCase)
+{
+    const boost::uint64_t SMALL_MAX_SEGMENTS = (1024000000ULL * 8) / SEGMENT_SIZE;
+    //rows per depth: ceil(2000000 / 64^n) for n = 1..5
+    const uint64_t expectedSmallBytes = (31250 + 489 + 8 + 1 + 1) * sizeof(uint64_t);
+    const uint64_t fullBytes = ((1ULL << 24) + (1ULL << 18) + (1ULL << 12) + 64 + 1) * sizeof(uint64_t);
+
+    {
+        MemoryManagerTreeArray fullTree(MAX_MEMORY_MANAGER_SEGMENTS);
+        BOOST_REQUIRE_EQUAL(fullTree.GetBitMaskMemoryUsageBytes(), fullBytes);
+    }
+    {
+        MemoryManagerTreeArray smallTree(SMALL_MAX_SEGMENTS);
+        BOOST_REQUIRE_EQUAL(smallTree.GetBitMaskMemoryUsageBytes(), expectedSmallBytes);
+    }
+    //an 8GB store used to cost the same ~136MB (and the setup time to initialize it) as the largest possible store
+    BOOST_REQUIRE_LT(expectedSmallBytes * 100, fullBytes);
+
+    MemoryManagerTreeArray t(SMALL_MAX_SEGMENTS);
+    backup_memmanager_t backup;
+    t.BackupDataToVector(backup);
+    uint64_t backupBytes = 0;
+    for (std::size_t i = 0; i < backup.size(); ++i) {
+        backupBytes += backup[i].size() * sizeof(uint64_t);
+    }
+    BOOST_REQUIRE_EQUAL(backupBytes, expectedSmallBytes);
+    BOOST_REQUIRE(t.IsBackupEqual(backup));
+
+    //segments beyond the end have no bits
+    BOOST_REQUIRE(!t.FreeSegmentId_NotThreadSafe(static_cast<segment_id_t>(SMALL_MAX_SEGMENTS)));
+    t.AllocateSegmentId_NoCheck_NotThreadSafe(static_cast<segment_id_t>(SMALL_MAX_SEGMENTS));
+    BOOST_REQUIRE(t.IsBackupEqual(backup));
+}
+
+BOOST_AUTO_TEST_CASE(MemoryManagerTreeArrayContiguousTestCase)
+{
+    {
+        MemoryManagerTreeArray t(10000);
+        for (segment_id_t i = 0; i < 10; ++i) {
+            BOOST_REQUIRE_EQUAL(t.GetAndSetFirstFreeSegmentId_NotThreadSafe(), i);
+        }
+        BOOST_REQUIRE(t.FreeSegmentId_NotThreadSafe(3));
+        BOOST_REQUIRE(t.FreeSegmentId_NotThreadSafe(5));
+
+        //holes at 3 and 5 are too small, so the run starts after the allocated segments
+        segment_id_chain_vec_t segmentVec(4);
+        BOOST_REQUIRE(t.AllocateContiguousSegments_ThreadSafe(segmentVec));
+        const segment_id_chain_vec_t expectedSegmentVec({ 10, 11, 12, 13 });
+        BOOST_REQUIRE(segmentVec == expectedSegmentVec);
+
+        memory_manager_fragmentation_stats_t stats;
+        t.GetFragmentationStats_ThreadSafe(stats);
+        BOOST_REQUIRE_EQUAL(stats.totalFreeSegments, 2 + (10000 - 14));
+        BOOST_REQUIRE_EQUAL(stats.numFreeExtents, 3);
+        BOOST_REQUIRE_EQUAL(stats.largestFreeExtentSegments, 10000 - 14);
+        BOOST_REQUIRE_CLOSE(stats.fragmentation, 1.0 - ((10000.0 - 14.0) / (10000.0 - 12.0)), 0.0001);
+
+        disk_extents_per_disk_t extentsPerDisk;
+        MemoryManagerTreeArray::GetDiskExtents(segmentVec, 2, extentsPerDisk);
+        BOOST_REQUIRE_EQUAL(extentsPerDisk.size(), 2);
+        for (unsigned int diskId = 0; diskId < 2; ++diskId) {
+            BOOST_REQUIRE_EQUAL(extentsPerDisk[diskId].size(), 1);
+            BOOST_REQUIRE_EQUAL(extentsPerDisk[diskId][0].startDiskSegmentIndex, 5);
+            BOOST_REQUIRE_EQUAL(extentsPerDisk[diskId][0].numSegments, 2);
+        }
+
+        //single segments still go to the lowest hole
+        segment_id_chain_vec_t singleSegmentVec(1);
+        BOOST_REQUIRE(t.AllocateContiguousSegments_ThreadSafe(singleSegmentVec));
+        BOOST_REQUIRE_EQUAL(singleSegmentVec[0], 3);
+    }
+
+    //no run is long enough: fall back to the lowest free segments
+    {
+        MemoryManagerTreeArray t(200);
+        for (segment_id_t i = 0; i < 200; ++i) {
+            BOOST_REQUIRE_EQUAL(t.GetAndSetFirstFreeSegmentId_NotThreadSafe(), i);
+        }
+        for (segment_id_t i = 0; i < 200; i += 2) {
+            BOOST_REQUIRE(t.FreeSegmentId_NotThreadSafe(i));
+        }
+        memory_manager_fragmentation_stats_t stats;
+        t.GetFragmentationStats_ThreadSafe(stats);
+        BOOST_REQUIRE_EQUAL(stats.totalFreeSegments, 100);
+        BOOST_REQUIRE_EQUAL(stats.numFreeExtents, 100);
+        BOOST_REQUIRE_EQUAL(stats.largestFreeExtentSegments, 1);
+
+        segment_id_chain_vec_t segmentVec(3);
+        BOOST_REQUIRE(t.AllocateContiguousSegments_ThreadSafe(segmentVec));
+        const segment_id_chain_vec_t expectedSegmentVec({ 0, 2, 4 });
+        BOOST_REQUIRE(segmentVec == expectedSegmentVec);
+
+        disk_extents_per_disk_t extentsPerDisk;
+        MemoryManagerTreeArray::GetDiskExtents(segmentVec, 2, extentsPerDisk);
+        BOOST_REQUIRE_EQUAL(extentsPerDisk[0].size(), 1);
+        BOOST_REQUIRE_EQUAL(extentsPerDisk[0][0].startDiskSegmentIndex, 0);
+        BOOST_REQUIRE_EQUAL(extentsPerDisk[0][0].numSegments, 3);
+        BOOST_REQUIRE(extentsPerDisk[1].empty());
+    }
+
+    //runs spanning leaf masks and skipping fully allocated groups of leaf masks
+    {
+        const boost::uint64_t MAX_SEGMENTS = (1024000000ULL * 8) / SEGMENT_SIZE;
+        MemoryManagerTreeArray t(MAX_SEGMENTS);
+        for (segment_id_t i = 0; i < 300000; ++i) {
+            BOOST_REQUIRE_EQUAL(t.GetAndSetFirstFreeSegmentId_NotThreadSafe(), i);
+        }
+        BOOST_REQUIRE(t.FreeSegmentId_NotThreadSafe(1000)); //single hole in a full group
+        segment_id_chain_vec_t segmentVec(100);
+        BOOST_REQUIRE(t.AllocateContiguousSegments_ThreadSafe(segmentVec));
+        for (std::size_t i = 0; i < segmentVec.size(); ++i) {
+            BOOST_REQUIRE_EQUAL(segmentVec[i], 300000 + i);
+        }
+        memory_manager_fragmentation_stats_t stats;
+        t.GetFragmentationStats_ThreadSafe(stats);
+        BOOST_REQUIRE_EQUAL(stats.totalFreeSegments, MAX_SEGMENTS - 300099);
+        BOOST_REQUIRE_EQUAL(stats.numFreeExtents, 2);
+        BOOST_REQUIRE_EQUAL(stats.largestFreeExtentSegments, MAX_SEGMENTS - 300100);
+    }
+
+    //max segments not a multiple of 64
+    {
+        MemoryManagerTreeArray t(130);
+        memory_manager_fragmentation_stats_t stats;
+        t.GetFragmentationStats_ThreadSafe(stats);
+        BOOST_REQUIRE_EQUAL(stats.totalFreeSegments, 130);
+        BOOST_REQUIRE_EQUAL(stats.numFreeExtents, 1);
+        BOOST_REQUIRE_EQUAL(stats.fragmentation, 0.0);
+
+        segment_id_chain_vec_t segmentVec(130);
+        BOOST_REQUIRE(t.AllocateContiguousSegments_ThreadSafe(segmentVec));
+        BOOST_REQUIRE_EQUAL(segmentVec.back(), 129);
+        segment_id_chain_vec_t segmentVec2(2);
+        BOOST_REQUIRE(!t.AllocateContiguousSegments_ThreadSafe(segmentVec2));
+        t.GetFragmentationStats_ThreadSafe(stats);
+        BOOST_REQUIRE_EQUAL(stats.totalFreeSegments, 0);
+        BOOST_REQUIRE_EQUAL(stats.numFreeExtents, 0);
+        BOOST_REQUIRE_EQUAL(stats.fragmentation, 0.0);
+    }
+}
+
+//construction time of an 8GB store vs the largest possible store (the memory touched is checked by MemoryManagerTreeArrayMemoryUsageTestCase)
+BOOST_AUTO_TEST_CASE(MemoryManagerTreeArrayConstructionSpeedTestCase, *boost::unit_test::disabled())
+{
+    const boost::uint64_t SMALL_MAX_SEGMENTS = (1024000000ULL * 8) / SEGMENT_SIZE;
+    static const unsigned int NUM_TREES = 10;
+
+    boost::timer::cpu_timer fullTimer;
+    for (unsigned int i = 0; i < NUM_TREES; ++i) {
+        MemoryManagerTreeArray t(MAX_MEMORY_MANAGER_SEGMENTS);
+    }
+    const boost::timer::nanosecond_type fullNanoseconds = fullTimer.elapsed().wall / NUM_TREES;
+
+    boost::timer::cpu_timer smallTimer;
+    for (unsigned int i = 0; i < NUM_TREES; ++i) {
+        MemoryManagerTreeArray t(SMALL_MAX_SEGMENTS);
+    }
+    const boost::timer::nanosecond_type smallNanoseconds = smallTimer.elapsed().wall / NUM_TREES;
+
+    std::cout << "largest store construction: " << (fullNanoseconds / 1000) << " us\n";
+    std::cout << "8GB store construction: " << (smallNanoseconds / 1000) << " us\n";
+    std::cout << "construction speedup: " << (static_cast<double>(fullNanoseconds) / smallNanoseconds) << "x\n";
+}
+
+//random bundle sizes stored/released at ~90% occupancy, compares disk operations per bundle (extents over 4 disks) and allocation speed
+BOOST_AUTO_TEST_CASE(MemoryManagerTreeArrayContiguousSpeedTestCase, *boost::unit_test::disabled())
+{
+    const boost::uint64_t MAX_SEGMENTS = 1ULL << 20;
+    const unsigned int NUM_DISKS = 4;
+    const unsigned int NUM_CHURN_OPERATIONS = 200000;
+    for (unsigned int useContiguous = 0; useContiguous < 2; ++useContiguous) {
+        MemoryManagerTreeArray t(MAX_SEGMENTS);
+        std::mt19937 gen(12345);
+        std::uniform_int_distribution<unsigned int> sizeDistribution(1, 64);
+        std::vector<segment_id_chain_vec_t> storedBundles;
+        disk_extents_per_disk_t extentsPerDisk;
+        uint64_t totalSegmentsStored = 0;
+        uint64_t totalSegmentsAllocated = 0;
+        uint64_t totalExtents = 0;
+        std::cout << ((useContiguous) ? "contiguous" : "first free") << " allocation:\n";
+        {
+            boost::timer::auto_cpu_timer timer;
+            for (unsigned int i = 0; i < NUM_CHURN_OPERATIONS; ++i) {
+                while (totalSegmentsStored < ((MAX_SEGMENTS * 9) / 10)) {
+                    segment_id_chain_vec_t segmentVec(sizeDistribution(gen));
+                    const bool success = (useContiguous) ? t.AllocateContiguousSegments_ThreadSafe(segmentVec) : t.AllocateSegments_ThreadSafe(segmentVec);
+                    BOOST_REQUIRE(success);
+                    MemoryManagerTreeArray::GetDiskExtents(segmentVec, NUM_DISKS, extentsPerDisk);
+                    for (unsigned int diskId = 0; diskId < NUM_DISKS; ++diskId) {
+                        totalExtents += extentsPerDisk[diskId].size();
+                    }
+                    totalSegmentsStored += segmentVec.size();
+                    totalSegmentsAllocated += segmentVec.size();
+                    storedBundles.push_back(std::move(segmentVec));
+                }
+                const std::size_t indexToRelease = std::uniform_int_distribution<std::size_t>(0, storedBundles.size() - 1)(gen);
+                BOOST_REQUIRE(t.FreeSegments_ThreadSafe(storedBundles[indexToRelease]));
+                totalSegmentsStored -= storedBundles[indexToRelease].size();
+                storedBundles[indexToRelease].swap(storedBundles.back());
+                storedBundles.pop_back();
+            }
+        }
+        memory_manager_fragmentation_stats_t stats;
+        t.GetFragmentationStats_ThreadSafe(stats);
+        std::cout << "    segments per disk operation: " << (static_cast<double>(totalSegmentsAllocated) / totalExtents)
+            << "  free extents: " << stats.numFreeExtents << "  largest free extent: " << stats.largestFreeExtentSegments
+            << "  fragmentation: " << stats.fragmentation << "\n";
+    }
+}
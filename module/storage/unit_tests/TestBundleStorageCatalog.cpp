@@ -136,3 +136,46 @@ BOOST_AUTO_TEST_CASE(BundleStorageCatalogTestCase)
 
     
 }
+
+BOOST_AUTO_TEST_CASE(BundleStorageCatalogExpiredBundleIdsTestCase)
+{
+    BundleStorageCatalog bsc;
+    std::vector<Bpv6CbhePrimaryBlock> primaries(10);
+    std::set<uint64_t> expectedExpiredIds;
+    for (std::size_t i = 0; i < primaries.size(); ++i) {
+        CreatePrimaryV6(primaries[i], cbhe_eid_t(500, 500), cbhe_eid_t(501, 501 + (i % 2)), false, 1000 + (i * 10), i); //expires at 2000 + 10i
+        catalog_entry_t catalogEntryToTake;
+        catalogEntryToTake.Init(primaries[i], 1000, 1, NULL);
+        BOOST_REQUIRE(bsc.CatalogIncomingBundleForStore(catalogEntryToTake, primaries[i], 100 + i, BundleStorageCatalog::DUPLICATE_EXPIRY_ORDER::FIFO));
+        if (i < 5) {
+            expectedExpiredIds.insert(100 + i);
+        }
+    }
+    std::vector<uint64_t> expiredIds;
+    BOOST_REQUIRE_EQUAL(bsc.GetExpiredBundleIds(0, 2000, 100, expiredIds), 0);
+    BOOST_REQUIRE_EQUAL(bsc.GetExpiredBundleIds(0, 2050, 100, expiredIds), 5);
+    BOOST_REQUIRE(std::set<uint64_t>(expiredIds.begin(), expiredIds.end()) == expectedExpiredIds);
+    BOOST_REQUIRE_EQUAL(bsc.GetExpiredBundleIds(0, 2050, 3, expiredIds), 3); //bounded slice
+    BOOST_REQUIRE_EQUAL(bsc.GetExpiredBundleIds(2010, 2050, 100, expiredIds), 4); //100 is below the minimum expiration
+
+    //erase the expired bundles that are awaiting send, leaving no empty expiration lists behind
+    BOOST_REQUIRE_EQUAL(bsc.GetExpiredBundleIds(0, 2050, 100, expiredIds), 5);
+    for (std::size_t i = 0; i < expiredIds.size(); ++i) {
+        const catalog_entry_t * entryPtr = bsc.GetEntryFromCustodyId(expiredIds[i]);
+        BOOST_REQUIRE(entryPtr);
+        BOOST_REQUIRE(bsc.RemoveEntryFromAwaitingSend(*entryPtr, expiredIds[i]));
+        BOOST_REQUIRE(bsc.Remove(expiredIds[i], false).first);
+    }
+    BOOST_REQUIRE_EQUAL(bsc.GetExpiredBundleIds(0, 2050, 100, expiredIds), 0);
+    BOOST_REQUIRE_EQUAL(bsc.GetExpiredBundleIds(0, UINT64_MAX, 100, expiredIds), 5);
+
+    //the remaining bundles still pop in expiration order
+    const std::vector<cbhe_eid_t> availableDestEids({ cbhe_eid_t(501, 501), cbhe_eid_t(501, 502) });
+    for (std::size_t i = 5; i < primaries.size(); ++i) {
+        uint64_t custodyId;
+        BOOST_REQUIRE(bsc.PopEntryFromAwaitingSend(custodyId, availableDestEids) != NULL);
+        BOOST_REQUIRE_EQUAL(custodyId, 100 + i);
+    }
+    uint64_t custodyId;
+    BOOST_REQUIRE(bsc.PopEntryFromAwaitingSend(custodyId, availableDestEids) == NULL);
+}
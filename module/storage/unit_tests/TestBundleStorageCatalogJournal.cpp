@@ -0,0 +1,162 @@
+#include <boost/test/unit_test.hpp>
+#include "BundleStorageCatalogJournal.h"
+#include <iostream>
+#include <string>
+#include <cstdio>
+#include <boost/filesystem.hpp>
+#include "codec/bpv6.h"
+
+
+static void CreatePrimaryV6(Bpv6CbhePrimaryBlock & p, const cbhe_eid_t & srcEid, const cbhe_eid_t & destEid, bool reqCustody, uint64_t creation, uint64_t sequence) {
+
+    p.m_bundleProcessingControlFlags = BPV6_BUNDLEFLAG::NO_FLAGS_SET;
+    if (reqCustody) {
+        p.m_bundleProcessingControlFlags |= BPV6_BUNDLEFLAG::CUSTODY_REQUESTED;
+    }
+    p.m_blockLength = 1000;
+    p.m_creationTimestamp.secondsSinceStartOfYear2000 = creation;
+    p.m_creationTimestamp.sequenceNumber = sequence;
+    p.m_lifetimeSeconds = 1000;
+    p.m_fragmentOffset = 0;
+    p.m_totalApplicationDataUnitLength = 0;
+
+    p.m_destinationEid = destEid;
+    p.m_sourceNodeId = srcEid;
+    p.m_reportToEid.SetZero();
+    p.m_custodianEid.Set(1, 1);
+}
+
+static void FlipByteInFile(const boost::filesystem::path & filePath, const long offset) {
+    FILE * f = fopen(filePath.string().c_str(), "r+b");
+    BOOST_REQUIRE(f != NULL);
+    BOOST_REQUIRE_EQUAL(fseek(f, offset, SEEK_SET), 0);
+    const int c = fgetc(f);
+    BOOST_REQUIRE(c != EOF);
+    BOOST_REQUIRE_EQUAL(fseek(f, offset, SEEK_SET), 0);
+    BOOST_REQUIRE(fputc(c ^ 0xff, f) != EOF);
+    fclose(f);
+}
+
+BOOST_AUTO_TEST_CASE(BundleStorageCatalogJournalTestCase)
+{
+    const boost::filesystem::path tempDir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+    BOOST_REQUIRE(boost::filesystem::create_directory(tempDir));
+    const boost::filesystem::path journalPath = tempDir / "catalog_journal.bin";
+    const boost::filesystem::path checkpointPath = journalPath.string() + ".checkpoint";
+
+    BundleStorageCatalog bsc;
+    std::vector<Bpv6CbhePrimaryBlock> primaries(10);
+    {
+        BundleStorageCatalogJournal journal(journalPath);
+        std::vector<catalog_journal_entry_t> entries;
+        BOOST_REQUIRE(!journal.Load(entries)); //nothing written yet
+        BOOST_REQUIRE(journal.WriteCheckpoint(bsc)); //empty checkpoint, generation 1
+        BOOST_REQUIRE(boost::filesystem::exists(checkpointPath));
+
+        for (std::size_t i = 0; i < primaries.size(); ++i) {
+            CreatePrimaryV6(primaries[i], cbhe_eid_t(500, 500), cbhe_eid_t(501, 501 + (i % 2)), (i % 3) != 0, 1000, i);
+            catalog_entry_t catalogEntryToTake;
+            catalogEntryToTake.Init(primaries[i], 1000 + i, 1 + (i % 2), NULL);
+            catalogEntryToTake.segmentIdChainVec = { static_cast<segment_id_t>(2 * i) };
+            if (i % 2) {
+                catalogEntryToTake.segmentIdChainVec.push_back(static_cast<segment_id_t>(2 * i + 1));
+            }
+            const uint64_t custodyId = 100 + i;
+            BOOST_REQUIRE(bsc.CatalogIncomingBundleForStore(catalogEntryToTake, primaries[i], custodyId, BundleStorageCatalog::DUPLICATE_EXPIRY_ORDER::FIFO));
+            BOOST_REQUIRE(journal.AppendInsert(custodyId, *bsc.GetEntryFromCustodyId(custodyId)));
+        }
+        BOOST_REQUIRE(!journal.AppendInsert(100, *bsc.GetEntryFromCustodyId(100))); //already live
+        BOOST_REQUIRE(bsc.Remove(103, true).first);
+        BOOST_REQUIRE(journal.AppendRemove(103));
+        BOOST_REQUIRE(!journal.AppendRemove(103)); //no longer live
+        BOOST_REQUIRE_EQUAL(journal.GetNumLiveEntries(), 9);
+        BOOST_REQUIRE_EQUAL(journal.GetNumRecordsSinceCheckpoint(), 11);
+        BOOST_REQUIRE(!journal.NeedsCheckpoint());
+    }
+
+    std::vector<catalog_journal_entry_t> entriesFromJournal;
+    {
+        BundleStorageCatalogJournal journal(journalPath);
+        BOOST_REQUIRE(journal.Load(entriesFromJournal));
+    }
+    BOOST_REQUIRE_EQUAL(entriesFromJournal.size(), 9);
+    for (std::size_t j = 0; j < entriesFromJournal.size(); ++j) {
+        const std::size_t i = (j < 3) ? j : j + 1; //103 was removed, others keep insertion order
+        const catalog_journal_entry_t & entry = entriesFromJournal[j];
+        const catalog_entry_t & catalogEntry = *bsc.GetEntryFromCustodyId(100 + i);
+        BOOST_REQUIRE_EQUAL(entry.custodyId, 100 + i);
+        BOOST_REQUIRE_EQUAL(entry.bundleSizeBytes, catalogEntry.bundleSizeBytes);
+        BOOST_REQUIRE(entry.destEid == catalogEntry.destEid);
+        BOOST_REQUIRE_EQUAL(entry.encodedAbsExpirationAndCustodyAndPriority, catalogEntry.encodedAbsExpirationAndCustodyAndPriority);
+        BOOST_REQUIRE_EQUAL(entry.sequence, catalogEntry.sequence);
+        BOOST_REQUIRE(entry.segmentIdChainVec == catalogEntry.segmentIdChainVec);
+
+        //the recreated primary must give an identical catalog entry
+        const CatalogJournalPrimaryBlock journalPrimary(entry);
+        BOOST_REQUIRE_EQUAL(journalPrimary.HasCustodyFlagSet(), primaries[i].HasCustodyFlagSet());
+        catalog_entry_t recreatedEntry;
+        recreatedEntry.Init(journalPrimary, entry.bundleSizeBytes, entry.segmentIdChainVec.size(), NULL);
+        BOOST_REQUIRE_EQUAL(recreatedEntry.encodedAbsExpirationAndCustodyAndPriority, catalogEntry.encodedAbsExpirationAndCustodyAndPriority);
+        if (primaries[i].HasCustodyFlagSet()) {
+            BOOST_REQUIRE(journalPrimary.GetCbheBundleUuidNoFragmentFromPrimary() == primaries[i].GetCbheBundleUuidNoFragmentFromPrimary());
+        }
+    }
+
+    //a new checkpoint makes the old journal stale
+    const boost::filesystem::path staleJournalPath = journalPath.string() + ".stale";
+    boost::filesystem::copy_file(journalPath, staleJournalPath);
+    {
+        BundleStorageCatalogJournal journal(journalPath);
+        std::vector<catalog_journal_entry_t> entries;
+        BOOST_REQUIRE(journal.Load(entries));
+        for (std::size_t j = 0; j < entries.size(); ++j) {
+            BOOST_REQUIRE(journal.AppendInsert(entries[j].custodyId, *bsc.GetEntryFromCustodyId(entries[j].custodyId)));
+        }
+        BOOST_REQUIRE(journal.WriteCheckpoint(bsc)); //generation 2
+        BOOST_REQUIRE_EQUAL(journal.GetNumRecordsSinceCheckpoint(), 0);
+    }
+    boost::filesystem::remove(journalPath);
+    boost::filesystem::copy_file(staleJournalPath, journalPath); //as if a crash happened before the journal was truncated
+    {
+        BundleStorageCatalogJournal journal(journalPath);
+        std::vector<catalog_journal_entry_t> entries;
+        BOOST_REQUIRE(journal.Load(entries));
+        BOOST_REQUIRE_EQUAL(entries.size(), 9);
+        for (std::size_t j = 0; j < entries.size(); ++j) {
+            BOOST_REQUIRE_EQUAL(entries[j].custodyId, entriesFromJournal[j].custodyId);
+            BOOST_REQUIRE(entries[j].segmentIdChainVec == entriesFromJournal[j].segmentIdChainVec);
+        }
+    }
+
+    //corrupted checkpoint
+    FlipByteInFile(checkpointPath, static_cast<long>(boost::filesystem::file_size(checkpointPath) / 2));
+    {
+        BundleStorageCatalogJournal journal(journalPath);
+        std::vector<catalog_journal_entry_t> entries;
+        BOOST_REQUIRE(!journal.Load(entries));
+        BOOST_REQUIRE(entries.empty());
+        //start over with a good checkpoint then corrupt the journal
+        for (std::size_t j = 0; j < entriesFromJournal.size(); ++j) {
+            BOOST_REQUIRE(journal.AppendInsert(entriesFromJournal[j].custodyId, *bsc.GetEntryFromCustodyId(entriesFromJournal[j].custodyId)));
+        }
+        BOOST_REQUIRE(journal.WriteCheckpoint(bsc));
+        BOOST_REQUIRE(bsc.Remove(100, true).first);
+        BOOST_REQUIRE(journal.AppendRemove(100));
+    }
+    {
+        BundleStorageCatalogJournal journal(journalPath);
+        std::vector<catalog_journal_entry_t> entries;
+        BOOST_REQUIRE(journal.Load(entries));
+        BOOST_REQUIRE_EQUAL(entries.size(), 8);
+    }
+    boost::filesystem::resize_file(journalPath, boost::filesystem::file_size(journalPath) - 1); //truncated last record
+    {
+        BundleStorageCatalogJournal journal(journalPath);
+        std::vector<catalog_journal_entry_t> entries;
+        BOOST_REQUIRE(!journal.Load(entries));
+        journal.CloseAndDeleteFiles();
+    }
+    BOOST_REQUIRE(!boost::filesystem::exists(journalPath));
+    BOOST_REQUIRE(!boost::filesystem::exists(checkpointPath));
+    boost::filesystem::remove_all(tempDir);
+}
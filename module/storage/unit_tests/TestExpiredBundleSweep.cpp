@@ -0,0 +1,317 @@
+#include <boost/test/unit_test.hpp>
+#include "ExpiredBundleSweep.h"
+#include "BundleStorageManagerMT.h"
+#include "Environment.h"
+#include "TimestampUtil.h"
+#include "codec/BundleViewV6.h"
+#include "codec/BundleViewV7.h"
+#include <boost/make_unique.hpp>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+static const cbhe_eid_t HDTN_EID(1, 0);
+static const cbhe_eid_t SUBJECT_SRC_EID(100, 1);
+static const cbhe_eid_t SUBJECT_DEST_EID(200, 1);
+static const uint64_t STATUS_REPORT_LIFETIME_SECONDS = 3600;
+
+static std::unique_ptr<BundleStorageManagerBase> CreateStartedBsm() {
+    StorageConfig_ptr ptrStorageConfig = StorageConfig::CreateFromJsonFile((Environment::GetPathHdtnSourceRoot() / "tests" / "config_files" / "storage" / "storageConfigRelativePaths.json").string());
+    ptrStorageConfig->m_tryToRestoreFromDisk = false; //manually set this json entry
+    ptrStorageConfig->m_autoDeleteFilesOnExit = true; //manually set this json entry
+    std::unique_ptr<BundleStorageManagerBase> bsmPtr = boost::make_unique<BundleStorageManagerMT>(ptrStorageConfig);
+    bsmPtr->Start();
+    return bsmPtr;
+}
+
+//serialized block by block since BundleViewV6 doesn't render fragments
+static void PushBundleV6(BundleStorageManagerBase & bsm, CustodyIdAllocator & custodyIdAllocator, const Bpv6CbhePrimaryBlock & primary, const uint64_t payloadSize) {
+    std::vector<uint8_t> payloadData(payloadSize, 'a');
+    Bpv6CanonicalBlock block;
+    block.m_blockTypeCode = BPV6_BLOCK_TYPE_CODE::PAYLOAD;
+    block.m_blockProcessingControlFlags = BPV6_BLOCKFLAG::IS_LAST_BLOCK;
+    block.m_blockTypeSpecificDataLength = payloadData.size();
+    block.m_blockTypeSpecificDataPtr = payloadData.data();
+    std::vector<uint8_t> bundle(primary.GetSerializationSize() + block.GetSerializationSize());
+    const uint64_t primarySize = primary.SerializeBpv6(bundle.data());
+    BOOST_REQUIRE_NE(primarySize, 0);
+    BOOST_REQUIRE_EQUAL(primarySize + block.SerializeBpv6(bundle.data() + primarySize), bundle.size());
+    const uint64_t custodyId = custodyIdAllocator.GetNextCustodyIdForNextHopCtebToSend(primary.m_sourceNodeId);
+    BundleStorageManagerSession_WriteToDisk sessionWrite;
+    BOOST_REQUIRE_NE(bsm.Push(sessionWrite, primary, bundle.size()), 0);
+    BOOST_REQUIRE_EQUAL(bsm.PushAllSegments(sessionWrite, primary, custodyId, bundle.data(), bundle.size()), bundle.size());
+}
+
+//serialized block by block since BundleViewV7 doesn't render fragments
+static void PushBundleV7(BundleStorageManagerBase & bsm, CustodyIdAllocator & custodyIdAllocator, Bpv7CbhePrimaryBlock primary, const uint64_t payloadSize) {
+    std::vector<uint8_t> payloadData(payloadSize, 'b');
+    Bpv7CanonicalBlock block;
+    block.m_blockTypeCode = BPV7_BLOCK_TYPE_CODE::PAYLOAD;
+    block.m_blockProcessingControlFlags = BPV7_BLOCKFLAG::NO_FLAGS_SET;
+    block.m_blockNumber = 1; //must be 1
+    block.m_crcType = BPV7_CRC_TYPE::CRC32C;
+    block.m_dataLength = payloadData.size();
+    block.m_dataPtr = payloadData.data();
+    std::vector<uint8_t> bundle(1 + primary.GetSerializationSize() + block.GetSerializationSize() + 1);
+    bundle.front() = (4U << 5) | 31U; //CBOR major type 4, additional information 31 (Indefinite-Length Array)
+    const uint64_t primarySize = primary.SerializeBpv7(bundle.data() + 1);
+    BOOST_REQUIRE_NE(primarySize, 0);
+    BOOST_REQUIRE_EQUAL(1 + primarySize + block.SerializeBpv7(bundle.data() + 1 + primarySize) + 1, bundle.size());
+    bundle.back() = 0xff; //break
+    const uint64_t custodyId = custodyIdAllocator.GetNextCustodyIdForNextHopCtebToSend(primary.m_sourceNodeId);
+    BundleStorageManagerSession_WriteToDisk sessionWrite;
+    BOOST_REQUIRE_NE(bsm.Push(sessionWrite, primary, bundle.size()), 0);
+    BOOST_REQUIRE_EQUAL(bsm.PushAllSegments(sessionWrite, primary, custodyId, bundle.data(), bundle.size()), bundle.size());
+}
+
+static Bpv7CbhePrimaryBlock MakePrimaryV7(const uint64_t creationMilliseconds, const uint64_t sequenceNumber, const uint64_t lifetimeMilliseconds, const cbhe_eid_t & reportToEid) {
+    Bpv7CbhePrimaryBlock primary;
+    primary.SetZero();
+    primary.m_bundleProcessingControlFlags = BPV7_BUNDLEFLAG::NOFRAGMENT | BPV7_BUNDLEFLAG::DELETION_STATUS_REPORTS_REQUESTED | BPV7_BUNDLEFLAG::STATUSTIME_REQUESTED;
+    primary.m_sourceNodeId = SUBJECT_SRC_EID;
+    primary.m_destinationEid = SUBJECT_DEST_EID;
+    primary.m_reportToEid = reportToEid;
+    primary.m_creationTimestamp.millisecondsSinceStartOfYear2000 = creationMilliseconds;
+    primary.m_creationTimestamp.sequenceNumber = sequenceNumber;
+    primary.m_lifetimeMilliseconds = lifetimeMilliseconds;
+    primary.m_crcType = BPV7_CRC_TYPE::CRC32C;
+    return primary;
+}
+
+static Bpv6CbhePrimaryBlock MakePrimaryV6(const uint64_t creationSeconds, const uint64_t sequenceNumber, const uint64_t lifetimeSeconds, const cbhe_eid_t & reportToEid) {
+    Bpv6CbhePrimaryBlock primary;
+    primary.SetZero();
+    primary.m_bundleProcessingControlFlags = BPV6_BUNDLEFLAG::PRIORITY_NORMAL | BPV6_BUNDLEFLAG::SINGLETON | BPV6_BUNDLEFLAG::NOFRAGMENT;
+    if (reportToEid.nodeId) {
+        primary.m_bundleProcessingControlFlags |= BPV6_BUNDLEFLAG::DELETION_STATUS_REPORTS_REQUESTED;
+    }
+    primary.m_sourceNodeId = SUBJECT_SRC_EID;
+    primary.m_destinationEid = SUBJECT_DEST_EID;
+    primary.m_reportToEid = reportToEid;
+    primary.m_creationTimestamp.secondsSinceStartOfYear2000 = creationSeconds;
+    primary.m_creationTimestamp.sequenceNumber = sequenceNumber;
+    primary.m_lifetimeSeconds = lifetimeSeconds;
+    return primary;
+}
+
+//pops, reads and erases the next bundle stored for the destination (the status report)
+static void PopReport(BundleStorageManagerBase & bsm, const cbhe_eid_t & reportToEid, std::vector<uint8_t> & reportBundle) {
+    const std::vector<cbhe_eid_t> availableDestLinks = { reportToEid };
+    BundleStorageManagerSession_ReadFromDisk sessionRead;
+    BOOST_REQUIRE_NE(bsm.PopTop(sessionRead, availableDestLinks), 0);
+    BOOST_REQUIRE(bsm.ReadAllSegments(sessionRead, reportBundle));
+    BOOST_REQUIRE(bsm.RemoveReadBundleFromDisk(sessionRead));
+}
+
+static void RunSweepUntilIdle(ExpiredBundleSweep & expiredBundleSweep) {
+    for (unsigned int attempt = 0; (attempt < 10000) && (!expiredBundleSweep.IsEmpty()); ++attempt) {
+        expiredBundleSweep.ProcessFinishedReads();
+        expiredBundleSweep.WaitForProgress(boost::posix_time::milliseconds(10));
+    }
+    BOOST_REQUIRE(expiredBundleSweep.IsEmpty());
+}
+
+BOOST_AUTO_TEST_CASE(ExpiredBundleSweepStatusReportsTestCase)
+{
+    std::unique_ptr<BundleStorageManagerBase> bsmPtr = CreateStartedBsm();
+    BundleStorageManagerBase & bsm = *bsmPtr;
+    CustodyIdAllocator custodyIdAllocator;
+    ExpiredBundleSweep expiredBundleSweep(bsm, custodyIdAllocator, HDTN_EID, STATUS_REPORT_LIFETIME_SECONDS);
+
+    const uint64_t nowSeconds = TimestampUtil::GetSecondsSinceEpochRfc5050();
+    const uint64_t minAbsExpirationSeconds = ExpiredBundleSweep::MIN_ABS_EXPIRATION_SECONDS;
+    BOOST_REQUIRE_GT(nowSeconds, minAbsExpirationSeconds);
+    const cbhe_eid_t reportToEidV6(10, 0);
+    const cbhe_eid_t reportToEidV7(11, 0);
+    static const uint64_t FRAGMENT_PAYLOAD_SIZE = 3 * BUNDLE_STORAGE_PER_SEGMENT_SIZE; //head segment alone doesn't have the payload length
+
+    //expired v6 bundle requesting deletion reports
+    PushBundleV6(bsm, custodyIdAllocator, MakePrimaryV6(nowSeconds - 100, 5, 50, reportToEidV6), 100);
+    //expired multi-segment v6 fragment requesting deletion reports
+    {
+        Bpv6CbhePrimaryBlock primary = MakePrimaryV6(nowSeconds - 100, 6, 60, reportToEidV6);
+        primary.m_bundleProcessingControlFlags = BPV6_BUNDLEFLAG::PRIORITY_NORMAL | BPV6_BUNDLEFLAG::SINGLETON | BPV6_BUNDLEFLAG::ISFRAGMENT | BPV6_BUNDLEFLAG::DELETION_STATUS_REPORTS_REQUESTED;
+        primary.m_fragmentOffset = 1000;
+        primary.m_totalApplicationDataUnitLength = 1000 + FRAGMENT_PAYLOAD_SIZE;
+        PushBundleV6(bsm, custodyIdAllocator, primary, FRAGMENT_PAYLOAD_SIZE);
+    }
+    //expired v7 bundle requesting deletion reports with the status time
+    PushBundleV7(bsm, custodyIdAllocator, MakePrimaryV7(((nowSeconds - 100) * 1000) + 7, 7, 70000, reportToEidV7), 100);
+    //expired multi-segment v7 fragment requesting deletion reports with the status time
+    {
+        Bpv7CbhePrimaryBlock primary = MakePrimaryV7(((nowSeconds - 100) * 1000) + 11, 11, 75000, reportToEidV7);
+        primary.m_bundleProcessingControlFlags = BPV7_BUNDLEFLAG::ISFRAGMENT | BPV7_BUNDLEFLAG::DELETION_STATUS_REPORTS_REQUESTED | BPV7_BUNDLEFLAG::STATUSTIME_REQUESTED;
+        primary.m_fragmentOffset = 2000;
+        primary.m_totalApplicationDataUnitLength = 2000 + FRAGMENT_PAYLOAD_SIZE;
+        PushBundleV7(bsm, custodyIdAllocator, primary, FRAGMENT_PAYLOAD_SIZE);
+    }
+    //expired v6 bundle not requesting deletion reports
+    PushBundleV6(bsm, custodyIdAllocator, MakePrimaryV6(nowSeconds - 100, 8, 80, cbhe_eid_t(0, 0)), 100);
+    //unexpired v6 bundle
+    PushBundleV6(bsm, custodyIdAllocator, MakePrimaryV6(nowSeconds - 100, 9, 1000, reportToEidV6), 100);
+    //v6 bundle from a node without a clock (absolute expiration below the one year minimum), never swept
+    PushBundleV6(bsm, custodyIdAllocator, MakePrimaryV6(0, 10, 10, reportToEidV6), 100);
+
+    const uint64_t beforeSweepSeconds = TimestampUtil::GetSecondsSinceEpochRfc5050();
+    const uint64_t beforeSweepMilliseconds = TimestampUtil::GetMillisecondsSinceEpochRfc5050();
+    BOOST_REQUIRE(expiredBundleSweep.CanStartSlice());
+    BOOST_REQUIRE(!expiredBundleSweep.StartSlice(nowSeconds)); //slice not filled, nothing more expired
+    BOOST_REQUIRE_EQUAL(expiredBundleSweep.GetNumBundlesInSlice(), 5);
+    RunSweepUntilIdle(expiredBundleSweep);
+    const uint64_t afterSweepSeconds = TimestampUtil::GetSecondsSinceEpochRfc5050();
+    const uint64_t afterSweepMilliseconds = TimestampUtil::GetMillisecondsSinceEpochRfc5050();
+    BOOST_REQUIRE_EQUAL(expiredBundleSweep.GetTotalBundlesErased(), 5);
+    BOOST_REQUIRE_EQUAL(expiredBundleSweep.GetTotalDeletionStatusReports(), 4);
+
+    //v6 reports (in expiration order)
+    std::vector<uint64_t> reportSequenceNumbers;
+    for (unsigned int whichReport = 0; whichReport < 2; ++whichReport) {
+        const bool isFragment = (whichReport == 1);
+        std::vector<uint8_t> reportBundle;
+        PopReport(bsm, reportToEidV6, reportBundle);
+        BundleViewV6 bv;
+        BOOST_REQUIRE(bv.LoadBundle(reportBundle.data(), reportBundle.size()));
+        const Bpv6CbhePrimaryBlock & primary = bv.m_primaryBlockView.header;
+        BOOST_REQUIRE((primary.m_bundleProcessingControlFlags & BPV6_BUNDLEFLAG::ADMINRECORD) != BPV6_BUNDLEFLAG::NO_FLAGS_SET);
+        BOOST_REQUIRE_EQUAL(primary.m_sourceNodeId, HDTN_EID);
+        BOOST_REQUIRE_EQUAL(primary.m_destinationEid, reportToEidV6);
+        BOOST_REQUIRE_EQUAL(primary.m_lifetimeSeconds, STATUS_REPORT_LIFETIME_SECONDS);
+        BOOST_REQUIRE_GE(primary.m_creationTimestamp.secondsSinceStartOfYear2000, beforeSweepSeconds);
+        BOOST_REQUIRE_LE(primary.m_creationTimestamp.secondsSinceStartOfYear2000, afterSweepSeconds);
+        reportSequenceNumbers.push_back(primary.m_creationTimestamp.sequenceNumber);
+
+        std::vector<BundleViewV6::Bpv6CanonicalBlockView*> blocks;
+        bv.GetCanonicalBlocksByType(BPV6_BLOCK_TYPE_CODE::PAYLOAD, blocks);
+        BOOST_REQUIRE_EQUAL(blocks.size(), 1);
+        Bpv6AdministrativeRecord* adminRecordBlockPtr = dynamic_cast<Bpv6AdministrativeRecord*>(blocks[0]->headerPtr.get());
+        BOOST_REQUIRE(adminRecordBlockPtr);
+        BOOST_REQUIRE_EQUAL(adminRecordBlockPtr->m_adminRecordTypeCode, BPV6_ADMINISTRATIVE_RECORD_TYPE_CODE::BUNDLE_STATUS_REPORT);
+        Bpv6AdministrativeRecordContentBundleStatusReport * bsrPtr = dynamic_cast<Bpv6AdministrativeRecordContentBundleStatusReport*>(adminRecordBlockPtr->m_adminRecordContentPtr.get());
+        BOOST_REQUIRE(bsrPtr);
+        Bpv6AdministrativeRecordContentBundleStatusReport & bsr = *bsrPtr;
+        BOOST_REQUIRE(bsr.HasBundleStatusReportStatusFlagSet(BPV6_BUNDLE_STATUS_REPORT_STATUS_FLAGS::REPORTING_NODE_DELETED_BUNDLE));
+        BOOST_REQUIRE(!bsr.HasBundleStatusReportStatusFlagSet(BPV6_BUNDLE_STATUS_REPORT_STATUS_FLAGS::REPORTING_NODE_FORWARDED_BUNDLE));
+        BOOST_REQUIRE_EQUAL(bsr.m_reasonCode, BPV6_BUNDLE_STATUS_REPORT_REASON_CODES::LIFETIME_EXPIRED);
+        BOOST_REQUIRE_GE(bsr.m_timeOfDeletionOfBundle.secondsSinceStartOfYear2000, beforeSweepSeconds);
+        BOOST_REQUIRE_LE(bsr.m_timeOfDeletionOfBundle.secondsSinceStartOfYear2000, afterSweepSeconds);
+        BOOST_REQUIRE_EQUAL(bsr.m_bundleSourceEid, "ipn:100.1");
+        BOOST_REQUIRE_EQUAL(bsr.m_copyOfBundleCreationTimestamp.secondsSinceStartOfYear2000, nowSeconds - 100);
+        BOOST_REQUIRE_EQUAL(bsr.m_copyOfBundleCreationTimestamp.sequenceNumber, (isFragment) ? 6 : 5);
+        BOOST_REQUIRE_EQUAL(bsr.m_isFragment, isFragment);
+        if (isFragment) {
+            BOOST_REQUIRE_EQUAL(bsr.m_fragmentOffsetIfPresent, 1000);
+            BOOST_REQUIRE_EQUAL(bsr.m_fragmentLengthIfPresent, FRAGMENT_PAYLOAD_SIZE);
+        }
+    }
+
+    //v7 reports (in expiration order)
+    for (unsigned int whichReport = 0; whichReport < 2; ++whichReport) {
+        const bool isFragment = (whichReport == 1);
+        std::vector<uint8_t> reportBundle;
+        PopReport(bsm, reportToEidV7, reportBundle);
+        BundleViewV7 bv;
+        BOOST_REQUIRE(bv.LoadBundle(reportBundle.data(), reportBundle.size()));
+        const Bpv7CbhePrimaryBlock & primary = bv.m_primaryBlockView.header;
+        BOOST_REQUIRE((primary.m_bundleProcessingControlFlags & BPV7_BUNDLEFLAG::ADMINRECORD) != BPV7_BUNDLEFLAG::NO_FLAGS_SET);
+        BOOST_REQUIRE_EQUAL(primary.m_sourceNodeId, HDTN_EID);
+        BOOST_REQUIRE_EQUAL(primary.m_destinationEid, reportToEidV7);
+        BOOST_REQUIRE_EQUAL(primary.m_lifetimeMilliseconds, STATUS_REPORT_LIFETIME_SECONDS * 1000);
+        BOOST_REQUIRE_GE(primary.m_creationTimestamp.millisecondsSinceStartOfYear2000, beforeSweepMilliseconds);
+        BOOST_REQUIRE_LE(primary.m_creationTimestamp.millisecondsSinceStartOfYear2000, afterSweepMilliseconds);
+        reportSequenceNumbers.push_back(primary.m_creationTimestamp.sequenceNumber);
+
+        std::vector<BundleViewV7::Bpv7CanonicalBlockView*> blocks;
+        bv.GetCanonicalBlocksByType(BPV7_BLOCK_TYPE_CODE::PAYLOAD, blocks);
+        BOOST_REQUIRE_EQUAL(blocks.size(), 1);
+        Bpv7AdministrativeRecord* adminRecordBlockPtr = dynamic_cast<Bpv7AdministrativeRecord*>(blocks[0]->headerPtr.get());
+        BOOST_REQUIRE(adminRecordBlockPtr);
+        BOOST_REQUIRE_EQUAL(adminRecordBlockPtr->m_adminRecordTypeCode, BPV7_ADMINISTRATIVE_RECORD_TYPE_CODE::BUNDLE_STATUS_REPORT);
+        Bpv7AdministrativeRecordContentBundleStatusReport * bsrPtr = dynamic_cast<Bpv7AdministrativeRecordContentBundleStatusReport*>(adminRecordBlockPtr->m_adminRecordContentPtr.get());
+        BOOST_REQUIRE(bsrPtr);
+        Bpv7AdministrativeRecordContentBundleStatusReport & bsr = *bsrPtr;
+        BOOST_REQUIRE(bsr.m_reportStatusTimeFlagWasSet);
+        for (std::size_t i = 0; i < 3; ++i) {
+            BOOST_REQUIRE(!bsr.m_bundleStatusInfo[i].first);
+        }
+        //reporting-node-deleted-bundle
+        BOOST_REQUIRE(bsr.m_bundleStatusInfo[3].first);
+        BOOST_REQUIRE_GE(bsr.m_bundleStatusInfo[3].second, beforeSweepMilliseconds);
+        BOOST_REQUIRE_LE(bsr.m_bundleStatusInfo[3].second, afterSweepMilliseconds);
+        BOOST_REQUIRE_EQUAL(bsr.m_statusReportReasonCode, BPV7_STATUS_REPORT_REASON_CODE::LIFETIME_EXPIRED);
+        BOOST_REQUIRE_EQUAL(bsr.m_sourceNodeEid, SUBJECT_SRC_EID);
+        BOOST_REQUIRE_EQUAL(bsr.m_creationTimestamp.millisecondsSinceStartOfYear2000, ((nowSeconds - 100) * 1000) + ((isFragment) ? 11 : 7));
+        BOOST_REQUIRE_EQUAL(bsr.m_creationTimestamp.sequenceNumber, (isFragment) ? 11 : 7);
+        BOOST_REQUIRE_EQUAL(bsr.m_subjectBundleIsFragment, isFragment);
+        if (isFragment) {
+            BOOST_REQUIRE_EQUAL(bsr.m_optionalSubjectPayloadFragmentOffset, 2000);
+            BOOST_REQUIRE_EQUAL(bsr.m_optionalSubjectPayloadFragmentLength, FRAGMENT_PAYLOAD_SIZE);
+        }
+    }
+    std::sort(reportSequenceNumbers.begin(), reportSequenceNumbers.end());
+    for (std::size_t i = 0; i < reportSequenceNumbers.size(); ++i) {
+        BOOST_REQUIRE_EQUAL(reportSequenceNumbers[i], i); //one sequence number per report
+    }
+
+    //only the unexpired bundle and the one below the minimum absolute expiration remain
+    BOOST_REQUIRE(!expiredBundleSweep.StartSlice(nowSeconds));
+    BOOST_REQUIRE(expiredBundleSweep.IsEmpty());
+    BOOST_REQUIRE(!expiredBundleSweep.StartSlice(nowSeconds + 2000)); //the unexpired bundle has now expired
+    BOOST_REQUIRE_EQUAL(expiredBundleSweep.GetNumBundlesInSlice(), 1);
+    RunSweepUntilIdle(expiredBundleSweep);
+    BOOST_REQUIRE_EQUAL(expiredBundleSweep.GetTotalBundlesErased(), 6);
+    BOOST_REQUIRE_EQUAL(expiredBundleSweep.GetTotalDeletionStatusReports(), 5);
+    std::vector<uint8_t> reportBundle;
+    PopReport(bsm, reportToEidV6, reportBundle);
+
+    //creation time 0 (no clock) never expires, however late the sweep
+    BOOST_REQUIRE(!expiredBundleSweep.StartSlice(UINT64_MAX - 1));
+    BOOST_REQUIRE(expiredBundleSweep.IsEmpty());
+    BOOST_REQUIRE_EQUAL(expiredBundleSweep.GetTotalBundlesErased(), 6);
+    {
+        const std::vector<cbhe_eid_t> availableDestLinks = { SUBJECT_DEST_EID };
+        BundleStorageManagerSession_ReadFromDisk sessionRead;
+        BOOST_REQUIRE_NE(bsm.PopTop(sessionRead, availableDestLinks), 0);
+        std::vector<uint8_t> bundle;
+        BOOST_REQUIRE(bsm.ReadAllSegments(sessionRead, bundle));
+        BundleViewV6 bv;
+        BOOST_REQUIRE(bv.LoadBundle(bundle.data(), bundle.size()));
+        BOOST_REQUIRE_EQUAL(bv.m_primaryBlockView.header.m_creationTimestamp.secondsSinceStartOfYear2000, 0);
+        BOOST_REQUIRE(bsm.RemoveReadBundleFromDisk(sessionRead));
+        BOOST_REQUIRE_EQUAL(bsm.PopTop(sessionRead, availableDestLinks), 0);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(ExpiredBundleSweepSliceBoundTestCase)
+{
+    std::unique_ptr<BundleStorageManagerBase> bsmPtr = CreateStartedBsm();
+    BundleStorageManagerBase & bsm = *bsmPtr;
+    CustodyIdAllocator custodyIdAllocator;
+    ExpiredBundleSweep expiredBundleSweep(bsm, custodyIdAllocator, HDTN_EID, STATUS_REPORT_LIFETIME_SECONDS);
+
+    const uint64_t maxBundlesPerSlice = ExpiredBundleSweep::MAX_BUNDLES_PER_SLICE;
+    BOOST_REQUIRE_EQUAL(maxBundlesPerSlice, 64);
+    static const uint64_t NUM_EXPIRED = 100;
+    const uint64_t nowSeconds = TimestampUtil::GetSecondsSinceEpochRfc5050();
+    for (uint64_t i = 0; i < NUM_EXPIRED; ++i) {
+        PushBundleV6(bsm, custodyIdAllocator, MakePrimaryV6(nowSeconds - 1000, i, i, cbhe_eid_t(0, 0)), 10);
+    }
+
+    //a slice takes at most 64 bundles off the awaiting send queue
+    BOOST_REQUIRE(expiredBundleSweep.StartSlice(nowSeconds)); //filled, more may remain
+    BOOST_REQUIRE_EQUAL(expiredBundleSweep.GetNumBundlesInSlice(), maxBundlesPerSlice);
+    BOOST_REQUIRE(!expiredBundleSweep.CanStartSlice());
+    BOOST_REQUIRE(expiredBundleSweep.StartSlice(nowSeconds)); //no room, nothing more taken
+    BOOST_REQUIRE_EQUAL(expiredBundleSweep.GetNumBundlesInSlice(), maxBundlesPerSlice);
+    RunSweepUntilIdle(expiredBundleSweep);
+    BOOST_REQUIRE_EQUAL(expiredBundleSweep.GetTotalBundlesErased(), maxBundlesPerSlice);
+    BOOST_REQUIRE_EQUAL(expiredBundleSweep.GetTotalDeletionStatusReports(), 0);
+
+    //the next slice finishes the backlog
+    BOOST_REQUIRE(expiredBundleSweep.CanStartSlice());
+    BOOST_REQUIRE(!expiredBundleSweep.StartSlice(nowSeconds));
+    BOOST_REQUIRE_EQUAL(expiredBundleSweep.GetNumBundlesInSlice(), NUM_EXPIRED - maxBundlesPerSlice);
+    RunSweepUntilIdle(expiredBundleSweep);
+    BOOST_REQUIRE_EQUAL(expiredBundleSweep.GetTotalBundlesErased(), NUM_EXPIRED);
+    BOOST_REQUIRE(!expiredBundleSweep.StartSlice(nowSeconds));
+    BOOST_REQUIRE(expiredBundleSweep.IsEmpty());
+}
@@ -0,0 +1,422 @@
+#include <boost/test/unit_test.hpp>
+#include "ReleaseReadAheadPipeline.h"
+#include "BundleStorageManagerMT.h"
+#include "Environment.h"
+#include "codec/CustodyIdAllocator.h"
+#include <boost/make_unique.hpp>
+#include <boost/make_shared.hpp>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+static const cbhe_eid_t SRC_EID(100, 1);
+static const cbhe_eid_t DEST_X_EID(200, 1);
+static const cbhe_eid_t DEST_Y_EID(300, 1);
+static const uint64_t MIN_WINDOW_BYTES = 10000;
+static const uint64_t MAX_WINDOW_BYTES = 1000000000;
+
+static std::unique_ptr<BundleStorageManagerBase> CreateStartedBsm() {
+    StorageConfig_ptr ptrStorageConfig = StorageConfig::CreateFromJsonFile((Environment::GetPathHdtnSourceRoot() / "tests" / "config_files" / "storage" / "storageConfigRelativePaths.json").string());
+    ptrStorageConfig->m_tryToRestoreFromDisk = false; //manually set this json entry
+    ptrStorageConfig->m_autoDeleteFilesOnExit = true; //manually set this json entry
+    std::unique_ptr<BundleStorageManagerBase> bsmPtr = boost::make_unique<BundleStorageManagerMT>(ptrStorageConfig);
+    bsmPtr->Start();
+    return bsmPtr;
+}
+
+struct pushed_bundle_t {
+    uint64_t custodyId;
+    std::vector<uint8_t> bundle;
+};
+
+//bundles to the same destination pop in lifetime order (all created at the same time)
+static pushed_bundle_t PushBundle(BundleStorageManagerBase & bsm, CustodyIdAllocator & custodyIdAllocator, const cbhe_eid_t & destEid,
+    const uint64_t sequenceNumber, const uint64_t lifetimeSeconds, const uint64_t payloadSize)
+{
+    Bpv6CbhePrimaryBlock primary;
+    primary.SetZero();
+    primary.m_bundleProcessingControlFlags = BPV6_BUNDLEFLAG::PRIORITY_NORMAL | BPV6_BUNDLEFLAG::SINGLETON | BPV6_BUNDLEFLAG::NOFRAGMENT;
+    primary.m_sourceNodeId = SRC_EID;
+    primary.m_destinationEid = destEid;
+    primary.m_creationTimestamp.secondsSinceStartOfYear2000 = 1000;
+    primary.m_creationTimestamp.sequenceNumber = sequenceNumber;
+    primary.m_lifetimeSeconds = lifetimeSeconds;
+
+    std::vector<uint8_t> payloadData(payloadSize);
+    for (std::size_t i = 0; i < payloadData.size(); ++i) {
+        payloadData[i] = static_cast<uint8_t>(i + sequenceNumber);
+    }
+    Bpv6CanonicalBlock block;
+    block.m_blockTypeCode = BPV6_BLOCK_TYPE_CODE::PAYLOAD;
+    block.m_blockProcessingControlFlags = BPV6_BLOCKFLAG::IS_LAST_BLOCK;
+    block.m_blockTypeSpecificDataLength = payloadData.size();
+    block.m_blockTypeSpecificDataPtr = payloadData.data();
+    pushed_bundle_t pushed;
+    pushed.bundle.resize(primary.GetSerializationSize() + block.GetSerializationSize());
+    const uint64_t primarySize = primary.SerializeBpv6(pushed.bundle.data());
+    BOOST_REQUIRE_NE(primarySize, 0);
+    BOOST_REQUIRE_EQUAL(primarySize + block.SerializeBpv6(pushed.bundle.data() + primarySize), pushed.bundle.size());
+    pushed.custodyId = custodyIdAllocator.GetNextCustodyIdForNextHopCtebToSend(primary.m_sourceNodeId);
+    BundleStorageManagerSession_WriteToDisk sessionWrite;
+    BOOST_REQUIRE_NE(bsm.Push(sessionWrite, primary, pushed.bundle.size()), 0);
+    BOOST_REQUIRE_EQUAL(bsm.PushAllSegments(sessionWrite, primary, pushed.custodyId, pushed.bundle.data(), pushed.bundle.size()), pushed.bundle.size());
+    return pushed;
+}
+
+static const ReleaseReadAheadPipeline::read_ahead_t * PopAndStartRead(ReleaseReadAheadPipeline & readAheadPipeline, const cbhe_eid_t & destEid) {
+    const std::vector<std::pair<cbhe_eid_t, bool> > availableDestLinks = { std::pair<cbhe_eid_t, bool>(destEid, false) };
+    return readAheadPipeline.PopAndStartRead(availableDestLinks);
+}
+
+//the bundle egress received must be the one pushed (and a zero copy message still owning its read ahead buffer)
+static void RequireReceived(NativeInterModuleChannel<hdtn::ToEgressHdr> & toEgressChannel, const pushed_bundle_t & expected, const cbhe_eid_t & destEid) {
+    hdtn::ToEgressHdr toEgressHdr;
+    zmq::message_t zmqMessageBundle;
+    BOOST_REQUIRE(toEgressChannel.TryReceive(toEgressHdr, zmqMessageBundle));
+    BOOST_REQUIRE_EQUAL(toEgressHdr.base.type, HDTN_MSGTYPE_EGRESS);
+    BOOST_REQUIRE_EQUAL(toEgressHdr.base.flags, 0);
+    BOOST_REQUIRE_EQUAL(toEgressHdr.custodyId, expected.custodyId);
+    BOOST_REQUIRE(toEgressHdr.finalDestEid == destEid);
+    BOOST_REQUIRE_EQUAL(toEgressHdr.isCutThroughFromIngress, 0);
+    BOOST_REQUIRE_EQUAL(zmqMessageBundle.size(), expected.bundle.size());
+    BOOST_REQUIRE(memcmp(zmqMessageBundle.data(), expected.bundle.data(), expected.bundle.size()) == 0);
+}
+
+static std::size_t ProcessUntilEmpty(ReleaseReadAheadPipeline & readAheadPipeline, NativeInterModuleChannel<hdtn::ToEgressHdr> & toEgressChannel,
+    ReleaseWindowManager & releaseWindowManager, CustodyTimers & custodyTimers, std::size_t & totalBundlesSentToEgress)
+{
+    std::size_t numRemoved = 0;
+    for (unsigned int attempt = 0; (attempt < 10000) && (!readAheadPipeline.IsEmpty()); ++attempt) {
+        bool egressFull;
+        readAheadPipeline.QueueReads_NoBlock();
+        numRemoved += readAheadPipeline.ProcessFinishedReads_NoBlock(toEgressChannel, NULL, releaseWindowManager, custodyTimers, totalBundlesSentToEgress, egressFull);
+        BOOST_REQUIRE(!egressFull);
+        readAheadPipeline.WaitForProgress(boost::posix_time::milliseconds(10));
+    }
+    BOOST_REQUIRE(readAheadPipeline.IsEmpty());
+    return numRemoved;
+}
+
+//One round: a big bundle and then a small one to destination X, and a small one to destination Y.  The big bundle has more
+//segments than the disk queues hold, so unless the disk threads keep up while it is being queued, its reads stall until
+//the rest of its segments are queued, while the small bundles (popped once the disks are idle) are read right away.
+//Returns true if the small bundle to X completed before the big one (it must still go out after it).
+static bool RunInOrderPerDestinationRound(BundleStorageManagerBase & bsm, CustodyIdAllocator & custodyIdAllocator, ReleaseReadAheadPipeline & readAheadPipeline,
+    NativeInterModuleChannel<hdtn::ToEgressHdr> & toEgressChannel, ReleaseWindowManager & releaseWindowManager, CustodyTimers & custodyTimers,
+    const uint64_t round)
+{
+    const uint64_t bigPayloadSize = (CIRCULAR_INDEX_BUFFER_SIZE * 4) * BUNDLE_STORAGE_PER_SEGMENT_SIZE;
+    const pushed_bundle_t bigX = PushBundle(bsm, custodyIdAllocator, DEST_X_EID, (3 * round) + 1, 1000, bigPayloadSize);
+    const pushed_bundle_t smallX = PushBundle(bsm, custodyIdAllocator, DEST_X_EID, (3 * round) + 2, 2000, 100);
+    const pushed_bundle_t smallY = PushBundle(bsm, custodyIdAllocator, DEST_Y_EID, (3 * round) + 3, 3000, 100);
+
+    const ReleaseReadAheadPipeline::read_ahead_t * bigXPtr = PopAndStartRead(readAheadPipeline, DEST_X_EID);
+    BOOST_REQUIRE(bigXPtr != NULL);
+    BOOST_REQUIRE_EQUAL(bigXPtr->session.custodyId, bigX.custodyId);
+    for (unsigned int attempt = 0; attempt < 100; ++attempt) {
+        readAheadPipeline.WaitForProgress(boost::posix_time::milliseconds(10));
+    }
+    const ReleaseReadAheadPipeline::read_ahead_t * smallXPtr = PopAndStartRead(readAheadPipeline, DEST_X_EID);
+    BOOST_REQUIRE(smallXPtr != NULL);
+    BOOST_REQUIRE_EQUAL(smallXPtr->session.custodyId, smallX.custodyId);
+    const ReleaseReadAheadPipeline::read_ahead_t * smallYPtr = PopAndStartRead(readAheadPipeline, DEST_Y_EID);
+    BOOST_REQUIRE(smallYPtr != NULL);
+    BOOST_REQUIRE_EQUAL(smallYPtr->session.custodyId, smallY.custodyId);
+    BOOST_REQUIRE(PopAndStartRead(readAheadPipeline, DEST_X_EID) == NULL);
+    BOOST_REQUIRE_EQUAL(readAheadPipeline.GetNumBundles(), 3);
+    BOOST_REQUIRE_EQUAL(readAheadPipeline.GetNumBytes(), bigX.bundle.size() + smallX.bundle.size() + smallY.bundle.size());
+
+    //without queueing the rest of the big bundle
+    std::size_t totalBundlesSentToEgress = 0;
+    bool egressFull = false;
+    for (unsigned int attempt = 0; attempt < 100; ++attempt) {
+        readAheadPipeline.ProcessFinishedReads_NoBlock(toEgressChannel, NULL, releaseWindowManager, custodyTimers, totalBundlesSentToEgress, egressFull);
+        BOOST_REQUIRE(!egressFull);
+        readAheadPipeline.WaitForProgress(boost::posix_time::milliseconds(10));
+    }
+    const bool completedOutOfOrder = !bsm.IsReadAheadComplete(const_cast<BundleStorageManagerSession_ReadAhead&>(bigXPtr->session));
+    if (completedOutOfOrder) {
+        //only the bundle to the other destination went out, the small bundle to the same destination waits for the big one even once read
+        BOOST_REQUIRE(bsm.IsReadAheadComplete(const_cast<BundleStorageManagerSession_ReadAhead&>(smallXPtr->session)));
+        BOOST_REQUIRE_EQUAL(totalBundlesSentToEgress, 1);
+        BOOST_REQUIRE_EQUAL(readAheadPipeline.GetNumBundles(), 2);
+        RequireReceived(toEgressChannel, smallY, DEST_Y_EID);
+        BOOST_REQUIRE(!toEgressChannel.HasUnpolledBacklog());
+    }
+    BOOST_REQUIRE_EQUAL(ProcessUntilEmpty(readAheadPipeline, toEgressChannel, releaseWindowManager, custodyTimers, totalBundlesSentToEgress),
+        (completedOutOfOrder) ? 2 : (3 - totalBundlesSentToEgress));
+    BOOST_REQUIRE_EQUAL(totalBundlesSentToEgress, 3);
+    BOOST_REQUIRE_EQUAL(readAheadPipeline.GetNumBytes(), 0);
+
+    //both bundles to the same destination go out in pop order (whenever the one to the other destination does)
+    const pushed_bundle_t * const pushedPtrs[3] = { &bigX, &smallX, &smallY };
+    std::vector<uint64_t> receivedCustodyIdsVec;
+    hdtn::ToEgressHdr toEgressHdr;
+    zmq::message_t zmqMessageBundle;
+    while (toEgressChannel.TryReceive(toEgressHdr, zmqMessageBundle)) {
+        receivedCustodyIdsVec.push_back(toEgressHdr.custodyId);
+        for (unsigned int i = 0; i < 3; ++i) {
+            if (pushedPtrs[i]->custodyId == toEgressHdr.custodyId) {
+                BOOST_REQUIRE_EQUAL(zmqMessageBundle.size(), pushedPtrs[i]->bundle.size());
+                BOOST_REQUIRE(memcmp(zmqMessageBundle.data(), pushedPtrs[i]->bundle.data(), zmqMessageBundle.size()) == 0);
+            }
+        }
+    }
+    BOOST_REQUIRE_EQUAL(receivedCustodyIdsVec.size(), (completedOutOfOrder) ? 2 : 3);
+    const std::vector<uint64_t>::const_iterator itBigX = std::find(receivedCustodyIdsVec.cbegin(), receivedCustodyIdsVec.cend(), bigX.custodyId);
+    const std::vector<uint64_t>::const_iterator itSmallX = std::find(receivedCustodyIdsVec.cbegin(), receivedCustodyIdsVec.cend(), smallX.custodyId);
+    BOOST_REQUIRE(itBigX != receivedCustodyIdsVec.cend());
+    BOOST_REQUIRE(itSmallX != receivedCustodyIdsVec.cend());
+    BOOST_REQUIRE(itBigX < itSmallX);
+
+    BOOST_REQUIRE(bsm.RemoveReadBundleFromDisk(bigX.custodyId));
+    BOOST_REQUIRE(bsm.RemoveReadBundleFromDisk(smallX.custodyId));
+    BOOST_REQUIRE(bsm.RemoveReadBundleFromDisk(smallY.custodyId));
+    return completedOutOfOrder;
+}
+
+BOOST_AUTO_TEST_CASE(ReleaseReadAheadPipelineInOrderPerDestinationTestCase)
+{
+    std::unique_ptr<BundleStorageManagerBase> bsmPtr = CreateStartedBsm();
+    BundleStorageManagerBase & bsm = *bsmPtr;
+    CustodyIdAllocator custodyIdAllocator;
+    ReleaseWindowManager releaseWindowManager(OutductsConfig(), MIN_WINDOW_BYTES, MAX_WINDOW_BYTES);
+    CustodyTimers custodyTimers(boost::posix_time::seconds(10));
+    NativeInterModuleChannel<hdtn::ToEgressHdr> toEgressChannel(16);
+    boost::shared_ptr<ReleaseBufferPool> releaseBufferPoolPtr = boost::make_shared<ReleaseBufferPool>(32, 10000000);
+    ReleaseReadAheadPipeline readAheadPipeline(bsm, releaseBufferPoolPtr, ReleaseReadAheadPipeline::DEFAULT_MAX_BUNDLES, ReleaseReadAheadPipeline::DEFAULT_MAX_BYTES);
+
+    //whether the reads complete out of order depends on the disk threads, so repeat until they did
+    bool completedOutOfOrder = false;
+    for (uint64_t round = 0; (round < 20) && (!completedOutOfOrder); ++round) {
+        completedOutOfOrder = RunInOrderPerDestinationRound(bsm, custodyIdAllocator, readAheadPipeline, toEgressChannel, releaseWindowManager, custodyTimers, round);
+    }
+    BOOST_REQUIRE(completedOutOfOrder);
+}
+
+BOOST_AUTO_TEST_CASE(ReleaseReadAheadPipelineCapsTestCase)
+{
+    std::unique_ptr<BundleStorageManagerBase> bsmPtr = CreateStartedBsm();
+    BundleStorageManagerBase & bsm = *bsmPtr;
+    CustodyIdAllocator custodyIdAllocator;
+    ReleaseWindowManager releaseWindowManager(OutductsConfig(), MIN_WINDOW_BYTES, MAX_WINDOW_BYTES);
+    CustodyTimers custodyTimers(boost::posix_time::seconds(10));
+    NativeInterModuleChannel<hdtn::ToEgressHdr> toEgressChannel(32);
+    boost::shared_ptr<ReleaseBufferPool> releaseBufferPoolPtr = boost::make_shared<ReleaseBufferPool>(32, 10000000);
+    ReleaseReadAheadPipeline readAheadPipeline(bsm, releaseBufferPoolPtr, ReleaseReadAheadPipeline::DEFAULT_MAX_BUNDLES, ReleaseReadAheadPipeline::DEFAULT_MAX_BYTES);
+    const std::size_t maxBundles = ReleaseReadAheadPipeline::DEFAULT_MAX_BUNDLES;
+    const uint64_t maxBytes = ReleaseReadAheadPipeline::DEFAULT_MAX_BYTES;
+    std::size_t totalBundlesSentToEgress = 0;
+    hdtn::ToEgressHdr toEgressHdr;
+    zmq::message_t zmqMessageBundle;
+
+    //16 bundles: full by count
+    std::vector<pushed_bundle_t> pushedVec;
+    for (uint64_t i = 0; i < (maxBundles + 4); ++i) {
+        pushedVec.push_back(PushBundle(bsm, custodyIdAllocator, DEST_X_EID, i, 1000 + i, 1000));
+    }
+    for (std::size_t i = 0; i < maxBundles; ++i) {
+        BOOST_REQUIRE(!readAheadPipeline.IsFull());
+        const ReleaseReadAheadPipeline::read_ahead_t * readAheadPtr = PopAndStartRead(readAheadPipeline, DEST_X_EID);
+        BOOST_REQUIRE(readAheadPtr != NULL);
+        BOOST_REQUIRE_EQUAL(readAheadPtr->session.custodyId, pushedVec[i].custodyId);
+    }
+    BOOST_REQUIRE(readAheadPipeline.IsFull());
+    BOOST_REQUIRE_EQUAL(readAheadPipeline.GetNumBundles(), maxBundles);
+    BOOST_REQUIRE_LT(readAheadPipeline.GetNumBytes(), maxBytes);
+    BOOST_REQUIRE_EQUAL(ProcessUntilEmpty(readAheadPipeline, toEgressChannel, releaseWindowManager, custodyTimers, totalBundlesSentToEgress), maxBundles);
+    BOOST_REQUIRE(!readAheadPipeline.IsFull());
+    for (std::size_t i = 0; i < maxBundles; ++i) {
+        RequireReceived(toEgressChannel, pushedVec[i], DEST_X_EID);
+    }
+    for (std::size_t i = maxBundles; i < pushedVec.size(); ++i) {
+        BOOST_REQUIRE(PopAndStartRead(readAheadPipeline, DEST_X_EID) != NULL);
+    }
+    BOOST_REQUIRE_EQUAL(ProcessUntilEmpty(readAheadPipeline, toEgressChannel, releaseWindowManager, custodyTimers, totalBundlesSentToEgress), pushedVec.size() - maxBundles);
+    while (toEgressChannel.TryReceive(toEgressHdr, zmqMessageBundle)) {}
+    for (std::size_t i = 0; i < pushedVec.size(); ++i) {
+        BOOST_REQUIRE(bsm.RemoveReadBundleFromDisk(pushedVec[i].custodyId));
+    }
+
+    //64MB: a bundle that would take the pipeline past its bytes is left awaiting send
+    static const uint64_t BIG_PAYLOAD_SIZE = 5000000;
+    const uint64_t numBigBundlesThatFit = maxBytes / (BIG_PAYLOAD_SIZE + 100);
+    pushedVec.clear();
+    for (uint64_t i = 0; i <= numBigBundlesThatFit; ++i) {
+        pushedVec.push_back(PushBundle(bsm, custodyIdAllocator, DEST_X_EID, 100 + i, 1000 + i, BIG_PAYLOAD_SIZE));
+    }
+    for (uint64_t i = 0; i < numBigBundlesThatFit; ++i) {
+        BOOST_REQUIRE(!readAheadPipeline.IsFull());
+        BOOST_REQUIRE(PopAndStartRead(readAheadPipeline, DEST_X_EID) != NULL);
+    }
+    BOOST_REQUIRE_LT(readAheadPipeline.GetNumBundles(), maxBundles);
+    BOOST_REQUIRE_LE(readAheadPipeline.GetNumBytes(), maxBytes);
+    BOOST_REQUIRE_GT(readAheadPipeline.GetNumBytes() + pushedVec.back().bundle.size(), maxBytes);
+    BOOST_REQUIRE(PopAndStartRead(readAheadPipeline, DEST_X_EID) == NULL);
+    BOOST_REQUIRE_EQUAL(readAheadPipeline.GetNumBundles(), numBigBundlesThatFit);
+    BOOST_REQUIRE_EQUAL(ProcessUntilEmpty(readAheadPipeline, toEgressChannel, releaseWindowManager, custodyTimers, totalBundlesSentToEgress), numBigBundlesThatFit);
+    while (toEgressChannel.TryReceive(toEgressHdr, zmqMessageBundle)) {}
+    const ReleaseReadAheadPipeline::read_ahead_t * lastPtr = PopAndStartRead(readAheadPipeline, DEST_X_EID); //returned to awaiting send, and fits now
+    BOOST_REQUIRE(lastPtr != NULL);
+    BOOST_REQUIRE_EQUAL(lastPtr->session.custodyId, pushedVec.back().custodyId);
+    BOOST_REQUIRE_EQUAL(ProcessUntilEmpty(readAheadPipeline, toEgressChannel, releaseWindowManager, custodyTimers, totalBundlesSentToEgress), 1);
+    RequireReceived(toEgressChannel, pushedVec.back(), DEST_X_EID);
+
+    //a bundle bigger than the bytes limit still goes through on its own
+    {
+        ReleaseReadAheadPipeline smallReadAheadPipeline(bsm, releaseBufferPoolPtr, maxBundles, 1000);
+        const pushed_bundle_t pushed = PushBundle(bsm, custodyIdAllocator, DEST_Y_EID, 200, 1000, 2000);
+        const pushed_bundle_t pushedNext = PushBundle(bsm, custodyIdAllocator, DEST_Y_EID, 201, 2000, 10);
+        BOOST_REQUIRE(PopAndStartRead(smallReadAheadPipeline, DEST_Y_EID) != NULL);
+        BOOST_REQUIRE(smallReadAheadPipeline.IsFull());
+        BOOST_REQUIRE(PopAndStartRead(smallReadAheadPipeline, DEST_Y_EID) == NULL);
+        BOOST_REQUIRE_EQUAL(ProcessUntilEmpty(smallReadAheadPipeline, toEgressChannel, releaseWindowManager, custodyTimers, totalBundlesSentToEgress), 1);
+        RequireReceived(toEgressChannel, pushed, DEST_Y_EID);
+        BOOST_REQUIRE(PopAndStartRead(smallReadAheadPipeline, DEST_Y_EID) != NULL);
+        BOOST_REQUIRE_EQUAL(ProcessUntilEmpty(smallReadAheadPipeline, toEgressChannel, releaseWindowManager, custodyTimers, totalBundlesSentToEgress), 1);
+        RequireReceived(toEgressChannel, pushedNext, DEST_Y_EID);
+    }
+    BOOST_REQUIRE_EQUAL(totalBundlesSentToEgress, (maxBundles + 4) + numBigBundlesThatFit + 3);
+}
+
+BOOST_AUTO_TEST_CASE(ReleaseReadAheadPipelineCanceledAndFailedTestCase)
+{
+    std::unique_ptr<BundleStorageManagerBase> bsmPtr = CreateStartedBsm();
+    BundleStorageManagerBase & bsm = *bsmPtr;
+    CustodyIdAllocator custodyIdAllocator;
+    ReleaseWindowManager releaseWindowManager(OutductsConfig(), MIN_WINDOW_BYTES, MAX_WINDOW_BYTES);
+    CustodyTimers custodyTimers(boost::posix_time::seconds(10));
+    NativeInterModuleChannel<hdtn::ToEgressHdr> toEgressChannel(16);
+    boost::shared_ptr<ReleaseBufferPool> releaseBufferPoolPtr = boost::make_shared<ReleaseBufferPool>(32, 10000000);
+    ReleaseReadAheadPipeline readAheadPipeline(bsm, releaseBufferPoolPtr, ReleaseReadAheadPipeline::DEFAULT_MAX_BUNDLES, ReleaseReadAheadPipeline::DEFAULT_MAX_BYTES);
+    const boost::posix_time::ptime nowPtime = boost::posix_time::microsec_clock::universal_time();
+
+    const pushed_bundle_t canceled = PushBundle(bsm, custodyIdAllocator, DEST_X_EID, 1, 1000, 3 * BUNDLE_STORAGE_PER_SEGMENT_SIZE);
+    const pushed_bundle_t failed = PushBundle(bsm, custodyIdAllocator, DEST_X_EID, 2, 2000, 3 * BUNDLE_STORAGE_PER_SEGMENT_SIZE);
+    const pushed_bundle_t sent = PushBundle(bsm, custodyIdAllocator, DEST_X_EID, 3, 3000, 100);
+    const pushed_bundle_t * const pushedPtrs[3] = { &canceled, &failed, &sent };
+    for (unsigned int i = 0; i < 3; ++i) {
+        const ReleaseReadAheadPipeline::read_ahead_t * readAheadPtr = PopAndStartRead(readAheadPipeline, DEST_X_EID);
+        BOOST_REQUIRE(readAheadPtr != NULL);
+        BOOST_REQUIRE_EQUAL(readAheadPtr->session.custodyId, pushedPtrs[i]->custodyId);
+        BOOST_REQUIRE(releaseWindowManager.OnReleased(DEST_X_EID, false, readAheadPtr->session.custodyId, readAheadPtr->bundleSizeBytes, nowPtime));
+    }
+    BOOST_REQUIRE_EQUAL(releaseWindowManager.GetNumBundlesInFlight(), 3);
+
+    //a late custody signal erases the first bundle while it is being read
+    BOOST_REQUIRE(readAheadPipeline.Cancel(canceled.custodyId));
+    BOOST_REQUIRE(!readAheadPipeline.Cancel(canceled.custodyId)); //already canceled
+    BOOST_REQUIRE(!readAheadPipeline.Cancel(custodyIdAllocator.GetNextCustodyIdForNextHopCtebToSend(SRC_EID))); //not in the pipeline
+    BOOST_REQUIRE(bsm.RemoveReadBundleFromDisk(canceled.custodyId));
+    //the second bundle's segments on disk no longer match its catalog entry, so its read fails
+    catalog_entry_t * failedCatalogEntryPtr = bsm.GetCatalogEntryPtrFromCustodyId(failed.custodyId);
+    BOOST_REQUIRE(failedCatalogEntryPtr != NULL);
+    ++failedCatalogEntryPtr->bundleSizeBytes;
+
+    //neither is sent, and both leave the release window (egress will never ack them)
+    std::size_t totalBundlesSentToEgress = 0;
+    BOOST_REQUIRE_EQUAL(ProcessUntilEmpty(readAheadPipeline, toEgressChannel, releaseWindowManager, custodyTimers, totalBundlesSentToEgress), 3);
+    BOOST_REQUIRE_EQUAL(totalBundlesSentToEgress, 1);
+    RequireReceived(toEgressChannel, sent, DEST_X_EID);
+    BOOST_REQUIRE(!toEgressChannel.HasUnpolledBacklog());
+    BOOST_REQUIRE_EQUAL(releaseWindowManager.GetNumBundlesInFlight(), 1);
+    BOOST_REQUIRE(!releaseWindowManager.OnAcked(canceled.custodyId, nowPtime));
+    BOOST_REQUIRE(!releaseWindowManager.OnAcked(failed.custodyId, nowPtime));
+    BOOST_REQUIRE(releaseWindowManager.OnAcked(sent.custodyId, nowPtime));
+    BOOST_REQUIRE_EQUAL(readAheadPipeline.GetNumBytes(), 0);
+
+    --failedCatalogEntryPtr->bundleSizeBytes;
+    BOOST_REQUIRE(bsm.RemoveReadBundleFromDisk(failed.custodyId));
+    BOOST_REQUIRE(bsm.RemoveReadBundleFromDisk(sent.custodyId));
+}
+
+BOOST_AUTO_TEST_CASE(ReleaseReadAheadPipelineEgressFullTestCase)
+{
+    std::unique_ptr<BundleStorageManagerBase> bsmPtr = CreateStartedBsm();
+    BundleStorageManagerBase & bsm = *bsmPtr;
+    CustodyIdAllocator custodyIdAllocator;
+    ReleaseWindowManager releaseWindowManager(OutductsConfig(), MIN_WINDOW_BYTES, MAX_WINDOW_BYTES);
+    CustodyTimers custodyTimers(boost::posix_time::seconds(10));
+    NativeInterModuleChannel<hdtn::ToEgressHdr> toEgressChannel(1); //egress takes one bundle at a time
+    boost::shared_ptr<ReleaseBufferPool> releaseBufferPoolPtr = boost::make_shared<ReleaseBufferPool>(32, 10000000);
+    ReleaseReadAheadPipeline readAheadPipeline(bsm, releaseBufferPoolPtr, ReleaseReadAheadPipeline::DEFAULT_MAX_BUNDLES, ReleaseReadAheadPipeline::DEFAULT_MAX_BYTES);
+    std::size_t totalBundlesSentToEgress = 0;
+    bool egressFull = false;
+
+    std::vector<pushed_bundle_t> pushedVec;
+    for (uint64_t i = 0; i < 3; ++i) {
+        pushedVec.push_back(PushBundle(bsm, custodyIdAllocator, DEST_X_EID, i, 1000 + i, 1000 * (i + 1)));
+    }
+    BOOST_REQUIRE(PopAndStartRead(readAheadPipeline, DEST_X_EID) != NULL);
+    BOOST_REQUIRE(PopAndStartRead(readAheadPipeline, DEST_X_EID) != NULL);
+
+    //zero copy: the first bundle's buffer is now owned by the message, and the second bundle's message couldn't be sent,
+    //so its buffer is reclaimed by the pipeline (rather than going back to the pool) to be sent later
+    std::size_t numRemoved = 0;
+    for (unsigned int attempt = 0; (attempt < 1000) && (!egressFull); ++attempt) {
+        numRemoved += readAheadPipeline.ProcessFinishedReads_NoBlock(toEgressChannel, NULL, releaseWindowManager, custodyTimers, totalBundlesSentToEgress, egressFull);
+        readAheadPipeline.WaitForProgress(boost::posix_time::milliseconds(10));
+    }
+    BOOST_REQUIRE(egressFull);
+    BOOST_REQUIRE_EQUAL(numRemoved, 1);
+    BOOST_REQUIRE_EQUAL(totalBundlesSentToEgress, 1);
+    BOOST_REQUIRE_EQUAL(readAheadPipeline.GetNumBundles(), 1);
+    BOOST_REQUIRE_EQUAL(readAheadPipeline.GetNumBytes(), pushedVec[1].bundle.size());
+    BOOST_REQUIRE_EQUAL(releaseBufferPoolPtr->GetNumFreeBuffers_ThreadSafe(), 0);
+    BOOST_REQUIRE_EQUAL(readAheadPipeline.ProcessFinishedReads_NoBlock(toEgressChannel, NULL, releaseWindowManager, custodyTimers, totalBundlesSentToEgress, egressFull), 0);
+    BOOST_REQUIRE(egressFull);
+
+    //the sent buffer returns to the pool once egress is done with the message
+    RequireReceived(toEgressChannel, pushedVec[0], DEST_X_EID);
+    BOOST_REQUIRE_EQUAL(releaseBufferPoolPtr->GetNumFreeBuffers_ThreadSafe(), 1);
+
+    //the reclaimed buffer still holds the second bundle
+    BOOST_REQUIRE_EQUAL(readAheadPipeline.ProcessFinishedReads_NoBlock(toEgressChannel, NULL, releaseWindowManager, custodyTimers, totalBundlesSentToEgress, egressFull), 1);
+    BOOST_REQUIRE(!egressFull);
+    BOOST_REQUIRE(readAheadPipeline.IsEmpty());
+    RequireReceived(toEgressChannel, pushedVec[1], DEST_X_EID);
+    BOOST_REQUIRE_EQUAL(releaseBufferPoolPtr->GetNumFreeBuffers_ThreadSafe(), 2);
+
+    //the next read reuses a pooled buffer
+    BOOST_REQUIRE(PopAndStartRead(readAheadPipeline, DEST_X_EID) != NULL);
+    BOOST_REQUIRE_EQUAL(releaseBufferPoolPtr->GetNumFreeBuffers_ThreadSafe(), 1);
+
+    //through shared memory, the slab of a descriptor that couldn't be sent is released for the next bundle
+    const std::string arenaName = SharedMemoryBundleArena::GetArenaName(65001) + "_unit_test";
+    boost::shared_ptr<SharedMemoryBundleArena> arenaPtr = SharedMemoryBundleArena::Create(arenaName, 1, 10000);
+    BOOST_REQUIRE(arenaPtr);
+    {
+        hdtn::ToEgressHdr toEgressHdr;
+        zmq::message_t zmqMessageHeaderOnly;
+        BOOST_REQUIRE(toEgressChannel.TrySend(toEgressHdr, zmqMessageHeaderOnly)); //egress now full
+    }
+    egressFull = false;
+    for (unsigned int attempt = 0; (attempt < 1000) && (!egressFull); ++attempt) {
+        readAheadPipeline.ProcessFinishedReads_NoBlock(toEgressChannel, arenaPtr.get(), releaseWindowManager, custodyTimers, totalBundlesSentToEgress, egressFull);
+        readAheadPipeline.WaitForProgress(boost::posix_time::milliseconds(10));
+    }
+    BOOST_REQUIRE(egressFull);
+    BOOST_REQUIRE_EQUAL(arenaPtr->GetNumFreeSlabs(), 1);
+    {
+        hdtn::ToEgressHdr toEgressHdr;
+        zmq::message_t zmqMessageHeaderOnly;
+        BOOST_REQUIRE(toEgressChannel.TryReceive(toEgressHdr, zmqMessageHeaderOnly));
+    }
+    BOOST_REQUIRE_EQUAL(readAheadPipeline.ProcessFinishedReads_NoBlock(toEgressChannel, arenaPtr.get(), releaseWindowManager, custodyTimers, totalBundlesSentToEgress, egressFull), 1);
+    BOOST_REQUIRE(!egressFull);
+    {
+        hdtn::ToEgressHdr toEgressHdr;
+        zmq::message_t zmqMessageDescriptor;
+        BOOST_REQUIRE(toEgressChannel.TryReceive(toEgressHdr, zmqMessageDescriptor));
+        BOOST_REQUIRE_EQUAL(toEgressHdr.base.flags, HDTN_FLAG_BUNDLE_IN_SHARED_MEMORY);
+        BOOST_REQUIRE_EQUAL(toEgressHdr.custodyId, pushedVec[2].custodyId);
+        BOOST_REQUIRE_EQUAL(zmqMessageDescriptor.size(), sizeof(shm_bundle_descriptor_t));
+    }
+    BOOST_REQUIRE_EQUAL(arenaPtr->GetNumFreeSlabs(), 0); //held by the descriptor egress received
+    BOOST_REQUIRE_EQUAL(releaseBufferPoolPtr->GetNumFreeBuffers_ThreadSafe(), 2); //the read ahead buffer of a bundle sent through shared memory
+
+    for (std::size_t i = 0; i < pushedVec.size(); ++i) {
+        BOOST_REQUIRE(bsm.RemoveReadBundleFromDisk(pushedVec[i].custodyId));
+    }
+}
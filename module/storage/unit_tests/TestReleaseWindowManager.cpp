@@ -0,0 +1,125 @@
+#include <boost/test/unit_test.hpp>
+#include "ReleaseWindowManager.h"
+#include <iostream>
+#include <string>
+
+
+BOOST_AUTO_TEST_CASE(ReleaseWindowManagerTestCase)
+{
+    OutductsConfig outductsConfig;
+    {
+        outduct_element_config_t ltpConfig;
+        ltpConfig.name = "ltp to node 2";
+        ltpConfig.convergenceLayer = "ltp_over_udp";
+        ltpConfig.oneWayLightTimeMs = 90;
+        ltpConfig.oneWayMarginTimeMs = 10;
+        ltpConfig.ltpMaxSendRateBitsPerSecOrZeroToDisable = 80000000; //10 MB/s with a 200ms round trip => 2 MB
+        ltpConfig.finalDestinationEidUris = { "ipn:2.1", "ipn:2.2" };
+        outductsConfig.m_outductElementConfigVector.push_back(ltpConfig);
+
+        outduct_element_config_t tcpclConfig;
+        tcpclConfig.name = "tcpcl to node 3";
+        tcpclConfig.convergenceLayer = "tcpcl_v3";
+        tcpclConfig.finalDestinationEidUris = { "ipn:3.1" };
+        outductsConfig.m_outductElementConfigVector.push_back(tcpclConfig);
+    }
+    static constexpr uint64_t MIN_WINDOW_BYTES = 10000;
+    static constexpr uint64_t MAX_WINDOW_BYTES = 10000000;
+    ReleaseWindowManager rwm(outductsConfig, MIN_WINDOW_BYTES, MAX_WINDOW_BYTES);
+    std::vector<release_window_stats_t> stats;
+    rwm.GetStats(stats);
+    BOOST_REQUIRE_EQUAL(stats.size(), 2);
+    BOOST_REQUIRE_EQUAL(stats[0].name, "ltp to node 2");
+    BOOST_REQUIRE_EQUAL(stats[0].bandwidthDelayProductBytes, 2000000);
+    BOOST_REQUIRE_EQUAL(stats[0].windowBytes, 2000000);
+    BOOST_REQUIRE_EQUAL(stats[1].bandwidthDelayProductBytes, 0);
+    BOOST_REQUIRE_EQUAL(stats[1].windowBytes, MIN_WINDOW_BYTES);
+
+    const boost::posix_time::ptime t0 = boost::posix_time::microsec_clock::universal_time();
+    const cbhe_eid_t dest21(2, 1);
+    const cbhe_eid_t dest22(2, 2);
+
+    //both final destinations share the outduct window
+    for (uint64_t custodyId = 0; custodyId < 4; ++custodyId) {
+        BOOST_REQUIRE(rwm.CanRelease(dest21, false));
+        BOOST_REQUIRE(rwm.OnReleased((custodyId % 2) ? dest22 : dest21, false, custodyId, 500000, t0));
+    }
+    BOOST_REQUIRE(!rwm.OnReleased(dest21, false, 0, 500000, t0)); //already in flight
+    BOOST_REQUIRE_EQUAL(rwm.GetNumBundlesInFlight(), 4);
+    BOOST_REQUIRE(!rwm.CanRelease(dest21, false));
+    BOOST_REQUIRE(!rwm.CanRelease(dest22, false));
+    BOOST_REQUIRE(rwm.CanRelease(cbhe_eid_t(3, 1), false)); //other outduct unaffected
+
+    //slow start: a window limited ack grows the window by the acked bytes
+    BOOST_REQUIRE(rwm.OnAcked(0, t0 + boost::posix_time::milliseconds(200)));
+    BOOST_REQUIRE(!rwm.OnAcked(0, t0 + boost::posix_time::milliseconds(200))); //no longer in flight
+    rwm.GetStats(stats);
+    BOOST_REQUIRE_EQUAL(stats[0].windowBytes, 2500000);
+    BOOST_REQUIRE_EQUAL(stats[0].bytesInFlight, 1500000);
+    BOOST_REQUIRE_EQUAL(stats[0].bundlesInFlight, 3);
+    BOOST_REQUIRE_EQUAL(stats[0].smoothedRttMicroseconds, 200000);
+    BOOST_REQUIRE_EQUAL(stats[0].totalClogEvents, 2);
+    BOOST_REQUIRE(rwm.CanRelease(dest21, false));
+
+    //a retry halves the window once per smoothed round trip
+    rwm.OnRetry(dest21, t0 + boost::posix_time::milliseconds(300));
+    rwm.OnRetry(dest22, t0 + boost::posix_time::milliseconds(400));
+    rwm.GetStats(stats);
+    BOOST_REQUIRE_EQUAL(stats[0].windowBytes, 1250000);
+    BOOST_REQUIRE_EQUAL(stats[0].totalWindowDecreases, 1);
+    rwm.OnRetry(dest21, t0 + boost::posix_time::milliseconds(600));
+    rwm.GetStats(stats);
+    BOOST_REQUIRE_EQUAL(stats[0].windowBytes, 625000);
+    BOOST_REQUIRE_EQUAL(stats[0].totalWindowDecreases, 2);
+
+    //congestion avoidance: additive increase of about one bundle per window
+    BOOST_REQUIRE(rwm.OnAcked(1, t0 + boost::posix_time::milliseconds(700)));
+    rwm.GetStats(stats);
+    BOOST_REQUIRE_EQUAL(stats[0].windowBytes, 625000 + ((500000ULL * 500000ULL) / 625000));
+    BOOST_REQUIRE(rwm.OnAcked(2, t0 + boost::posix_time::milliseconds(800)));
+    rwm.GetStats(stats);
+    const uint64_t expectedWindowBytes = 1025000 + ((500000ULL * 500000ULL) / 1025000);
+    BOOST_REQUIRE_EQUAL(stats[0].windowBytes, expectedWindowBytes);
+    //not window limited (only 500000 bytes in flight), so no growth
+    BOOST_REQUIRE(rwm.OnAcked(3, t0 + boost::posix_time::milliseconds(900)));
+    rwm.GetStats(stats);
+    BOOST_REQUIRE_EQUAL(stats[0].windowBytes, expectedWindowBytes);
+    BOOST_REQUIRE_EQUAL(rwm.GetNumBundlesInFlight(), 0);
+
+    //a scheduler release rate replaces the configured rate
+    rwm.OnReleaseRate(dest21, 20000000);
+    rwm.GetStats(stats);
+    BOOST_REQUIRE_EQUAL(stats[0].bandwidthDelayProductBytes, 4000000);
+    BOOST_REQUIRE_EQUAL(stats[0].windowBytes, 4000000);
+
+    //an unconfigured (opportunistic) destination gets a minimum window per node, always admitting one bundle
+    BOOST_REQUIRE(rwm.CanRelease(cbhe_eid_t(7, 0), true));
+    BOOST_REQUIRE(rwm.OnReleased(cbhe_eid_t(7, 0), true, 100, 2 * MIN_WINDOW_BYTES, t0));
+    BOOST_REQUIRE(!rwm.CanRelease(cbhe_eid_t(7, 0), true));
+    rwm.GetStats(stats);
+    BOOST_REQUIRE_EQUAL(stats.size(), 3);
+    BOOST_REQUIRE_EQUAL(stats[2].name, "ipn:7.*");
+    BOOST_REQUIRE_EQUAL(stats[2].bytesInFlight, 2 * MIN_WINDOW_BYTES);
+    BOOST_REQUIRE(rwm.OnAcked(100, t0));
+    BOOST_REQUIRE(rwm.CanRelease(cbhe_eid_t(7, 0), true));
+
+    //a canceled release frees its bytes without any window feedback
+    BOOST_REQUIRE(rwm.OnReleased(cbhe_eid_t(7, 0), true, 101, 3 * MIN_WINDOW_BYTES, t0));
+    BOOST_REQUIRE(rwm.OnCanceled(101));
+    BOOST_REQUIRE(!rwm.OnCanceled(101));
+    BOOST_REQUIRE(!rwm.OnAcked(101, t0));
+    rwm.GetStats(stats);
+    BOOST_REQUIRE_EQUAL(stats[2].bytesInFlight, 0);
+    BOOST_REQUIRE_EQUAL(stats[2].windowBytes, MIN_WINDOW_BYTES + (2 * MIN_WINDOW_BYTES));
+
+    //an any service id link to a configured node is checked and charged against the outduct's window
+    BOOST_REQUIRE(rwm.CanRelease(cbhe_eid_t(2, 0), true));
+    BOOST_REQUIRE(rwm.OnReleased(cbhe_eid_t(2, 0), true, 200, 4000000, t0));
+    BOOST_REQUIRE(!rwm.CanRelease(cbhe_eid_t(2, 0), true));
+    BOOST_REQUIRE(!rwm.CanRelease(dest21, false));
+    rwm.GetStats(stats);
+    BOOST_REQUIRE_EQUAL(stats.size(), 3);
+    BOOST_REQUIRE_EQUAL(stats[0].bytesInFlight, 4000000);
+    BOOST_REQUIRE(rwm.OnAcked(200, t0));
+    BOOST_REQUIRE(!rwm.GetStatsString().empty());
+}